@@ -44,6 +44,8 @@ public:
   {
     m_libXBMC_pvr = NULL;
     m_Handle      = NULL;
+    PVR_transfer_epg_entries     = NULL;
+    PVR_transfer_channel_entries = NULL;
   }
 
   ~CHelper_libXBMC_pvr(void)
@@ -144,6 +146,13 @@ public:
       dlsym(m_libXBMC_pvr, "PVR_transfer_channel_group_member");
     if (PVR_transfer_channel_group_member == NULL) { fprintf(stderr, "Unable to assign function %s\n", dlerror()); return false; }
 
+    /* the batch transfers are optional. entries are transferred one by one when XBMC doesn't provide them */
+    PVR_transfer_epg_entries = (void (*)(void* HANDLE, void* CB, const ADDON_HANDLE handle, const EPG_TAG *epgentries, unsigned int iEntries))
+      dlsym(m_libXBMC_pvr, "PVR_transfer_epg_entries");
+
+    PVR_transfer_channel_entries = (void (*)(void* HANDLE, void* CB, const ADDON_HANDLE handle, const PVR_CHANNEL *channels, unsigned int iChannels))
+      dlsym(m_libXBMC_pvr, "PVR_transfer_channel_entries");
+
 #ifdef USE_DEMUX
     PVR_free_demux_packet = (void (*)(void* HANDLE, void* CB, DemuxPacket* pPacket))
       dlsym(m_libXBMC_pvr, "PVR_free_demux_packet");
@@ -178,6 +187,36 @@ public:
     return PVR_transfer_channel_entry(m_Handle, m_Callbacks, handle, entry);
   }
 
+  /*!
+   * @brief Transfer a list of EPG tags from the add-on to XBMC in one call
+   * @param handle The handle parameter that XBMC used when requesting the EPG data
+   * @param entries The entries to transfer to XBMC
+   * @param iEntries The number of entries
+   */
+  void TransferEpgEntries(const ADDON_HANDLE handle, const EPG_TAG* entries, unsigned int iEntries)
+  {
+    if (PVR_transfer_epg_entries)
+      return PVR_transfer_epg_entries(m_Handle, m_Callbacks, handle, entries, iEntries);
+
+    for (unsigned int iEntryPtr = 0; iEntryPtr < iEntries; iEntryPtr++)
+      PVR_transfer_epg_entry(m_Handle, m_Callbacks, handle, &entries[iEntryPtr]);
+  }
+
+  /*!
+   * @brief Transfer a list of channel entries from the add-on to XBMC in one call
+   * @param handle The handle parameter that XBMC used when requesting the channel list
+   * @param entries The entries to transfer to XBMC
+   * @param iEntries The number of entries
+   */
+  void TransferChannelEntries(const ADDON_HANDLE handle, const PVR_CHANNEL* entries, unsigned int iEntries)
+  {
+    if (PVR_transfer_channel_entries)
+      return PVR_transfer_channel_entries(m_Handle, m_Callbacks, handle, entries, iEntries);
+
+    for (unsigned int iEntryPtr = 0; iEntryPtr < iEntries; iEntryPtr++)
+      PVR_transfer_channel_entry(m_Handle, m_Callbacks, handle, &entries[iEntryPtr]);
+  }
+
   /*!
    * @brief Transfer a timer entry from the add-on to XBMC
    * @param handle The handle parameter that XBMC used when requesting the timers list
@@ -316,6 +355,8 @@ protected:
   void (*PVR_trigger_epg_update)(void*, void*, unsigned int);
   void (*PVR_transfer_channel_group)(void*, void*, const ADDON_HANDLE, const PVR_CHANNEL_GROUP*);
   void (*PVR_transfer_channel_group_member)(void*, void*, const ADDON_HANDLE, const PVR_CHANNEL_GROUP_MEMBER*);
+  void (*PVR_transfer_epg_entries)(void*, void*, const ADDON_HANDLE, const EPG_TAG*, unsigned int);
+  void (*PVR_transfer_channel_entries)(void*, void*, const ADDON_HANDLE, const PVR_CHANNEL*, unsigned int);
 #ifdef USE_DEMUX
   void (*PVR_free_demux_packet)(void*, void*, DemuxPacket*);
   DemuxPacket* (*PVR_allocate_demux_packet)(void*, void*, int);
@@ -77,6 +77,22 @@ DLLEXPORT void PVR_transfer_channel_entry(void *hdl, void* cb, const ADDON_HANDL
   ((CB_PVRLib*)cb)->TransferChannelEntry(((AddonCB*)hdl)->addonData, handle, chan);
 }
 
+DLLEXPORT void PVR_transfer_epg_entries(void *hdl, void* cb, const ADDON_HANDLE handle, const EPG_TAG *epgentries, unsigned int iEntries)
+{
+  if (cb == NULL)
+    return;
+
+  ((CB_PVRLib*)cb)->TransferEpgEntries(((AddonCB*)hdl)->addonData, handle, epgentries, iEntries);
+}
+
+DLLEXPORT void PVR_transfer_channel_entries(void *hdl, void* cb, const ADDON_HANDLE handle, const PVR_CHANNEL *channels, unsigned int iChannels)
+{
+  if (cb == NULL)
+    return;
+
+  ((CB_PVRLib*)cb)->TransferChannelEntries(((AddonCB*)hdl)->addonData, handle, channels, iChannels);
+}
+
 DLLEXPORT void PVR_transfer_timer_entry(void *hdl, void* cb, const ADDON_HANDLE handle, const PVR_TIMER *timer)
 {
   if (cb == NULL)
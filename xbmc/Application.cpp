@@ -606,6 +606,9 @@ bool CApplication::Create()
     return false;
   }
 
+  // deliver announcements on a thread of their own from here on
+  CAnnouncementManager::Initialize();
+
   // Init our DllLoaders emu env
   init_emu_environ();
 
@@ -1191,6 +1194,10 @@ bool CApplication::Initialize()
   // initialize (and update as needed) our databases
   CDatabaseManager::Get().Initialize();
 
+  // restore the directory listings of the last session, they are revalidated on first use
+  if (g_advancedSettings.m_dirCachePersist)
+    g_directoryCache.Load();
+
 #ifdef HAS_WEB_SERVER
   CWebServer::RegisterRequestHandler(&m_httpImageHandler);
   CWebServer::RegisterRequestHandler(&m_httpVfsHandler);
@@ -3447,6 +3454,12 @@ bool CApplication::Cleanup()
     g_guiSettings.Clear();
     g_advancedSettings.Clear();
 
+    // deliver any queued announcements and stop the dispatch thread
+    CAnnouncementManager::Deinitialize();
+
+    // write out any queued log lines, we log synchronously from here on
+    CLog::SetAsync(false);
+
 #ifdef _LINUX
     CXHandle::DumpObjectTracker();
 #endif
@@ -3551,6 +3564,9 @@ void CApplication::Stop(int exitCode)
     }
 #endif
 
+    if (g_advancedSettings.m_dirCachePersist)
+      g_directoryCache.Save();
+
     CLog::Log(LOGNOTICE, "clean cached files!");
 #ifdef HAS_FILESYSTEM_RAR
     g_RarManager.ClearCache(true);
@@ -1952,22 +1952,20 @@ void CFileItemList::Sort(SortDescription sortDescription)
 
   SortItems sortItems((size_t)Size());
   for (int index = 0; index < Size(); index++)
-  {
     m_items[index]->ToSortable(sortItems[index]);
-    sortItems[index][FieldId] = index;
-  }
 
-  // do the sorting
-  SortUtils::Sort(sortDescription, sortItems);
+  // do the sorting, this only gives us the new order of the items
+  std::vector<size_t> order;
+  SortUtils::Sort(sortDescription, sortItems, order);
 
   // apply the new order to the existing CFileItems
   VECFILEITEMS sortedFileItems;
-  sortedFileItems.reserve(Size());
-  for (SortItems::const_iterator it = sortItems.begin(); it != sortItems.end(); it++)
+  sortedFileItems.reserve(order.size());
+  for (std::vector<size_t>::const_iterator it = order.begin(); it != order.end(); it++)
   {
-    CFileItemPtr item = m_items[(int)it->at(FieldId).asInteger()];
+    CFileItemPtr item = m_items[*it];
     // Set the sort label in the CFileItem
-    item->SetSortLabel(CStdStringW(it->at(FieldSort).asWideString()));
+    item->SetSortLabel(CStdStringW(sortItems[*it].at(FieldSort).asWideString()));
 
     sortedFileItems.push_back(item);
   }
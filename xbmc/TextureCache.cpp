@@ -38,7 +38,10 @@ CTextureCache &CTextureCache::Get()
 }
 
 CTextureCache::CTextureCache()
+  : m_pipeline(this, 2, 2, 1, 8)
 {
+  m_indexLoaded = false;
+  m_indexWriteQueued = false;
 }
 
 CTextureCache::~CTextureCache()
@@ -50,12 +53,28 @@ void CTextureCache::Initialize()
   CSingleLock lock(m_databaseSection);
   if (!m_database.IsOpen())
     m_database.Open();
+  if (!m_indexLoaded)
+    AddJob(new CTextureIndexJob(CTextureIndexJob::LOAD_INDEX));
 }
 
 void CTextureCache::Deinitialize()
 {
+  m_pipeline.Cancel();
   CancelJobs();
   CSingleLock lock(m_databaseSection);
+  { // drop the index first so that nothing more is queued for writing
+    CExclusiveLock indexLock(m_indexSection);
+    m_index.clear();
+    m_indexStale.clear();
+    m_indexLoaded = false;
+  }
+  WriteIndex();
+  { // the index is loaded from the database again, changes that couldn't be written are gone
+    CSingleLock changesLock(m_indexChangesSection);
+    if (!m_indexChanges.empty())
+      CLog::Log(LOGERROR, "%s - dropping %u changes to the texture database", __FUNCTION__, (unsigned int)m_indexChanges.size());
+    m_indexChanges.clear();
+  }
   m_database.Close();
 }
 
@@ -160,7 +179,7 @@ void CTextureCache::BackgroundCacheImage(const CStdString &url)
     return; // image is already cached and doesn't need to be checked further
 
   // needs (re)caching
-  AddJob(new CTextureCacheJob(UnwrapImageURL(url), cacheHash));
+  m_pipeline.Add(new CTextureCacheJob(UnwrapImageURL(url), cacheHash));
 }
 
 CStdString CTextureCache::CacheImage(const CStdString &image, CBaseTexture **texture)
@@ -209,19 +228,36 @@ void CTextureCache::ClearCachedImage(const CStdString &url, bool deleteSource /*
 
 bool CTextureCache::GetCachedTexture(const CStdString &url, CTextureDetails &details)
 {
+  bool result = false;
+  if (LookupIndex(url, details, result))
+    return result;
+
+  // index is still loading, so check the database. The index is marked as loaded
+  // with m_databaseSection held, so check it again once we have it.
   CSingleLock lock(m_databaseSection);
+  if (LookupIndex(url, details, result))
+    return result;
   return m_database.GetCachedTexture(url, details);
 }
 
 bool CTextureCache::AddCachedTexture(const CStdString &url, const CTextureDetails &details)
 {
-  CSingleLock lock(m_databaseSection);
-  return m_database.AddCachedTexture(url, details);
+  CIndexChange change(CIndexChange::ADD_TEXTURE, url);
+  change.m_details = details;
+  return ChangeTexture(change);
+}
+
+bool CTextureCache::InvalidateCachedImage(const CStdString &url)
+{
+  CIndexChange change(CIndexChange::INVALIDATE, url);
+  return ChangeTexture(change);
 }
 
 void CTextureCache::IncrementUseCount(const CTextureDetails &details)
 {
   static const size_t count_before_update = 100;
+  if (details.id < 0)
+    return; // not yet written to the database, which starts it with a use count of 1
   CSingleLock lock(m_useCountSection);
   m_useCounts.reserve(count_before_update);
   m_useCounts.push_back(details);
@@ -234,14 +270,198 @@ void CTextureCache::IncrementUseCount(const CTextureDetails &details)
 
 bool CTextureCache::SetCachedTextureValid(const CStdString &url, bool updateable)
 {
-  CSingleLock lock(m_databaseSection);
-  return m_database.SetCachedTextureValid(url, updateable);
+  CIndexChange change(CIndexChange::SET_VALID, url);
+  change.m_details.updateable = updateable;
+  return ChangeTexture(change);
 }
 
 bool CTextureCache::ClearCachedTexture(const CStdString &url, CStdString &cachedURL)
+{
+  CIndexChange change(CIndexChange::CLEAR_TEXTURE, url);
+  bool result = ChangeTexture(change);
+  cachedURL = change.m_details.file;
+  return result;
+}
+
+bool CTextureCache::ChangeTexture(CIndexChange &change)
+{
+  bool result = false;
+  if (ChangeIndex(change, result))
+    return result;
+
+  // index is still loading, so change the database directly, and have the
+  // index pick up the change once it is done
+  CSingleLock lock(m_databaseSection);
+  if (ChangeIndex(change, result))
+    return result;
+  m_indexStale.insert(change.m_url);
+  return WriteChange(change);
+}
+
+bool CTextureCache::ChangeIndex(CIndexChange &change, bool &result)
+{
+  bool queueWrite = false;
+  {
+    CExclusiveLock lock(m_indexSection);
+    if (!m_indexLoaded)
+      return false;
+
+    result = true;
+    std::map<CStdString, CCachedTexture>::iterator i = m_index.find(change.m_url);
+    if (change.m_type == CIndexChange::ADD_TEXTURE)
+    {
+      CCachedTexture texture;
+      texture.file = change.m_details.file;
+      texture.hash = change.m_details.hash;
+      texture.width = change.m_details.width;
+      texture.height = change.m_details.height;
+      if (change.m_details.updateable)
+        texture.lastHashCheck = CDateTime::GetCurrentDateTime();
+      m_index[change.m_url] = texture; // id is filled in once written
+    }
+    else if (i == m_index.end())
+    { // nothing to change
+      if (change.m_type == CIndexChange::CLEAR_TEXTURE)
+        result = false;
+      return true;
+    }
+    else if (change.m_type == CIndexChange::SET_VALID)
+    {
+      if (change.m_details.updateable)
+        i->second.lastHashCheck = CDateTime::GetCurrentDateTime();
+      else
+        i->second.lastHashCheck.Reset();
+    }
+    else if (change.m_type == CIndexChange::INVALIDATE)
+      i->second.lastHashCheck = CDateTime::GetCurrentDateTime() - CDateTimeSpan(2, 0, 0, 0);
+    else if (change.m_type == CIndexChange::CLEAR_TEXTURE)
+    {
+      change.m_details.file = i->second.file;
+      m_index.erase(i);
+    }
+
+    CSingleLock changesLock(m_indexChangesSection);
+    m_indexChanges.push_back(change);
+    queueWrite = !m_indexWriteQueued;
+    m_indexWriteQueued = true;
+  }
+  // changes queued up while waiting on the job are written along with this one
+  if (queueWrite)
+    AddJob(new CTextureIndexJob(CTextureIndexJob::WRITE_INDEX));
+  return true;
+}
+
+bool CTextureCache::LookupIndex(const CStdString &url, CTextureDetails &details, bool &result) const
+{
+  CSharedLock lock(m_indexSection);
+  if (!m_indexLoaded)
+    return false;
+
+  std::map<CStdString, CCachedTexture>::const_iterator i = m_index.find(url);
+  result = i != m_index.end();
+  if (result)
+  {
+    details.id = i->second.id;
+    details.file = i->second.file;
+    details.width = i->second.width;
+    details.height = i->second.height;
+    if (i->second.NeedsCheck(CDateTime::GetCurrentDateTime()))
+      details.hash = i->second.hash;
+  }
+  return true;
+}
+
+bool CTextureCache::WriteChange(CIndexChange &change)
+{
+  switch (change.m_type)
+  {
+  case CIndexChange::ADD_TEXTURE:
+    return m_database.AddCachedTexture(change.m_url, change.m_details);
+  case CIndexChange::SET_VALID:
+    return m_database.SetCachedTextureValid(change.m_url, change.m_details.updateable);
+  case CIndexChange::INVALIDATE:
+    return m_database.InvalidateCachedTexture(change.m_url);
+  case CIndexChange::CLEAR_TEXTURE:
+    {
+      CStdString cachedFile;
+      bool result = m_database.ClearCachedTexture(change.m_url, cachedFile);
+      change.m_details.file = cachedFile;
+      return result;
+    }
+  }
+  return false;
+}
+
+bool CTextureCache::LoadIndex()
+{
+  static const unsigned int textures_per_query = 1000;
+  std::map<CStdString, CCachedTexture> index;
+  int lastID = 0;
+  while (true)
+  { // lookups and changes fall back to the database until we're done, so don't hold them up for long
+    CSingleLock lock(m_databaseSection);
+    if (!m_database.IsOpen())
+      return false;
+
+    int previousID = lastID;
+    if (!m_database.GetCachedTextures(index, lastID, textures_per_query))
+      return false;
+    if (lastID != previousID)
+      continue;
+
+    // all read - pick up the textures that were changed meanwhile
+    for (std::set<CStdString>::const_iterator i = m_indexStale.begin(); i != m_indexStale.end(); ++i)
+    {
+      index.erase(*i);
+      if (!m_database.GetCachedTextures(index, *i))
+        return false;
+    }
+    m_indexStale.clear();
+
+    CExclusiveLock indexLock(m_indexSection);
+    m_index.swap(index);
+    m_indexLoaded = true;
+    CLog::Log(LOGDEBUG, "%s - loaded %u textures", __FUNCTION__, (unsigned int)m_index.size());
+    return true;
+  }
+}
+
+void CTextureCache::WriteIndex()
 {
   CSingleLock lock(m_databaseSection);
-  return m_database.ClearCachedTexture(url, cachedURL);
+  std::vector<CIndexChange> changes;
+  {
+    CSingleLock changesLock(m_indexChangesSection);
+    changes.swap(m_indexChanges);
+    m_indexWriteQueued = false;
+  }
+  if (changes.empty() || !m_database.IsOpen())
+    return;
+
+  m_database.BeginTransaction();
+  for (std::vector<CIndexChange>::iterator i = changes.begin(); i != changes.end(); ++i)
+    WriteChange(*i);
+  if (!m_database.CommitTransaction())
+  {
+    // the index already has the changes, so keep them for the next write ahead of anything queued since
+    CLog::Log(LOGERROR, "%s - failed writing %u changes, retrying with the next write", __FUNCTION__, (unsigned int)changes.size());
+    m_database.RollbackTransaction();
+    CSingleLock changesLock(m_indexChangesSection);
+    changes.insert(changes.end(), m_indexChanges.begin(), m_indexChanges.end());
+    m_indexChanges.swap(changes);
+    return;
+  }
+
+  // fill in the ids of added textures. Only the last addition of a url is still in the database.
+  CExclusiveLock indexLock(m_indexSection);
+  for (std::vector<CIndexChange>::reverse_iterator i = changes.rbegin(); i != changes.rend(); ++i)
+  {
+    if (i->m_type != CIndexChange::ADD_TEXTURE)
+      continue;
+    std::map<CStdString, CCachedTexture>::iterator texture = m_index.find(i->m_url);
+    if (texture != m_index.end() && texture->second.id < 0 && texture->second.file == i->m_details.file)
+      texture->second.id = i->m_details.id;
+  }
 }
 
 CStdString CTextureCache::GetCacheFile(const CStdString &url)
@@ -260,6 +480,19 @@ CStdString CTextureCache::GetCachedPath(const CStdString &file)
   return URIUtils::AddFileToFolder(g_settings.GetThumbnailsFolder(), file);
 }
 
+bool CTextureCache::OnCachingStart(CTextureCacheJob *job)
+{
+  // check whether we need cache the job anyway
+  bool needsRecaching = false;
+  CStdString path(CheckCachedImage(job->m_url, false, needsRecaching));
+  if (!path.IsEmpty() && !needsRecaching)
+    return false;
+
+  // and that it isn't being cached already
+  CSingleLock lock(m_processingSection);
+  return m_processing.insert(job->m_url).second;
+}
+
 void CTextureCache::OnCachingComplete(bool success, CTextureCacheJob *job)
 {
   if (success)
@@ -284,31 +517,13 @@ void CTextureCache::OnCachingComplete(bool success, CTextureCacheJob *job)
     AddJob(new CTextureDDSJob(GetCachedPath(job->m_details.file)));
 }
 
-void CTextureCache::OnJobComplete(unsigned int jobID, bool success, CJob *job)
+void CTextureCache::OnCachingCancelled(const CStdString &url)
 {
-  if (strcmp(job->GetType(), "cacheimage") == 0)
-    OnCachingComplete(success, (CTextureCacheJob *)job);
-  return CJobQueue::OnJobComplete(jobID, success, job);
-}
-
-void CTextureCache::OnJobProgress(unsigned int jobID, unsigned int progress, unsigned int total, const CJob *job)
-{
-  if (strcmp(job->GetType(), "cacheimage") == 0 && !progress)
-  { // check our processing list
-    {
-      CSingleLock lock(m_processingSection);
-      const CTextureCacheJob *cacheJob = (CTextureCacheJob *)job;
-      std::set<CStdString>::iterator i = m_processing.find(cacheJob->m_url);
-      if (i == m_processing.end())
-      {
-        m_processing.insert(cacheJob->m_url);
-        return;
-      }
-    }
-    CancelJob(job);
+  {
+    CSingleLock lock(m_processingSection);
+    m_processing.erase(url);
   }
-  else
-    CJobQueue::OnJobProgress(jobID, progress, total, job);
+  m_completeEvent.Set();
 }
 
 bool CTextureCache::Export(const CStdString &image, const CStdString &destination, bool overwrite)
@@ -20,11 +20,14 @@
 
 #pragma once
 
+#include <map>
 #include <set>
 #include "utils/StdString.h"
 #include "utils/JobManager.h"
 #include "TextureDatabase.h"
+#include "TextureCachePipeline.h"
 #include "threads/Event.h"
+#include "threads/SharedSection.h"
 
 class CBaseTexture;
 
@@ -37,8 +40,17 @@ class CBaseTexture;
  may be periodically checked for updates and may be purged from the cache if
  unused for a set period of time.
 
+ Lookups are served from an in-memory copy of the texture table, so that the
+ GUI thread doesn't hit the database while thumbs come into view. The index is
+ loaded in the background at initialization, until which the database is used.
+ Changes are made to the index straight away and written back to the database
+ in batches by a CTextureIndexJob.
+
+ Images are cached in the background by a CTextureCachePipeline, which fetches,
+ decodes and writes images as separate stages.
+
  */
-class CTextureCache : public CJobQueue
+class CTextureCache : public CJobQueue, public ITextureCacheCallback
 {
 public:
   /*!
@@ -142,6 +154,13 @@ public:
    */
   bool AddCachedTexture(const CStdString &image, const CTextureDetails &details);
 
+  /*! \brief Invalidate a previously cached image so that it is checked for updates next time it is loaded
+   \param image url of the original image
+   \return true if successful, false otherwise.
+   \sa CTextureDatabase::InvalidateCachedTexture
+   */
+  bool InvalidateCachedImage(const CStdString &image);
+
   /*! \brief Export a (possibly) cached image to a file
    \param image url of the original image
    \param destination url of the destination image, excluding extension.
@@ -151,6 +170,9 @@ public:
   bool Export(const CStdString &image, const CStdString &destination, bool overwrite);
   bool Export(const CStdString &image, const CStdString &destination); // TODO: BACKWARD COMPATIBILITY FOR MUSIC THUMBS
 private:
+  friend class CTextureIndexJob;
+  friend class TestTextureCache;
+
   // private construction, and no assignements; use the provided singleton methods
   CTextureCache();
   CTextureCache(const CTextureCache&);
@@ -202,8 +224,67 @@ private:
    */
   bool SetCachedTextureValid(const CStdString &url, bool updateable);
 
-  virtual void OnJobComplete(unsigned int jobID, bool success, CJob *job);
-  virtual void OnJobProgress(unsigned int jobID, unsigned int progress, unsigned int total, const CJob *job);
+  /*! \brief A change to the texture index that is yet to be written to the database
+   \sa ChangeTexture, WriteIndex
+   */
+  class CIndexChange
+  {
+  public:
+    enum TYPE { ADD_TEXTURE = 0,
+                SET_VALID,
+                INVALIDATE,
+                CLEAR_TEXTURE };
+
+    CIndexChange(TYPE type, const CStdString &url) : m_type(type), m_url(url) {};
+
+    TYPE            m_type;
+    CStdString      m_url;
+    CTextureDetails m_details; ///< details for ADD_TEXTURE, updateable for SET_VALID, cached file for CLEAR_TEXTURE
+  };
+
+  /*! \brief Make a change to a texture, in the index if it is loaded and in the database otherwise
+   \param change the change to make.
+   \return true if successful, false otherwise. For CLEAR_TEXTURE, whether the texture was cached.
+   */
+  bool ChangeTexture(CIndexChange &change);
+
+  /*! \brief Make a change to the texture index and queue it for writing to the database
+   \param change the change to make. For CLEAR_TEXTURE the cached file is filled in.
+   \param result [out] the result of the change, as for ChangeTexture.
+   \return true if the index is loaded and has been changed, false otherwise.
+   */
+  bool ChangeIndex(CIndexChange &change, bool &result);
+
+  /*! \brief Look up a texture in the texture index
+   \param url url of the original image
+   \param details [out] details of the texture, as for CTextureDatabase::GetCachedTexture
+   \param result [out] whether the texture is cached.
+   \return true if the index is loaded, false otherwise.
+   */
+  bool LookupIndex(const CStdString &url, CTextureDetails &details, bool &result) const;
+
+  /*! \brief Apply a change to the database. m_databaseSection must be held.
+   */
+  bool WriteChange(CIndexChange &change);
+
+  /*! \brief Load the texture index from the database
+   Called from a CTextureIndexJob on initialization. The index is read a part at a time
+   so that lookups and changes to the database aren't held up for long while it loads.
+   \return true if the index is loaded, false otherwise.
+   */
+  bool LoadIndex();
+
+  /*! \brief Write changes made to the texture index back to the database
+   Called from a CTextureIndexJob once changes are queued, and on deinitialization.
+   */
+  void WriteIndex();
+
+  /*! \brief Called when a caching job is about to start.
+   Checks whether the image still needs caching, and adds it to our processing list.
+   \param job the caching job.
+   \return false if the image is cached or is being cached already, true otherwise.
+   */
+  virtual bool OnCachingStart(CTextureCacheJob *job);
 
   /*! \brief Called when a caching job has completed.
    Removes the job from our processing list, updates the database
@@ -211,7 +292,13 @@ private:
    \param success whether the job was successful.
    \param job the caching job.
    */
-  void OnCachingComplete(bool success, CTextureCacheJob *job);
+  virtual void OnCachingComplete(bool success, CTextureCacheJob *job);
+
+  /*! \brief Called when a caching job was cancelled after it started.
+   Removes the image from our processing list, so that it can be cached again.
+   \param url the url of the image.
+   */
+  virtual void OnCachingCancelled(const CStdString &url);
 
   CCriticalSection m_databaseSection;
   CTextureDatabase m_database;
@@ -220,5 +307,15 @@ private:
   CEvent               m_completeEvent; ///< Set whenever a job has finished
   std::vector<CTextureDetails> m_useCounts; ///< Use count tracking
   CCriticalSection             m_useCountSection;
+
+  std::map<CStdString, CCachedTexture> m_index; ///< in-memory copy of the texture table, keyed by url
+  bool                                 m_indexLoaded;
+  std::set<CStdString>                 m_indexStale; ///< textures changed in the database while the index was loading, guarded by m_databaseSection
+  CSharedSection                       m_indexSection;
+  std::vector<CIndexChange>            m_indexChanges; ///< changes yet to be written to the database
+  bool                                 m_indexWriteQueued;
+  CCriticalSection                     m_indexChangesSection;
+
+  CTextureCachePipeline m_pipeline; ///< last, so that it is cancelled before the rest is destroyed
 };
 
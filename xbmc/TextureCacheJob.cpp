@@ -26,6 +26,7 @@
 #include "settings/AdvancedSettings.h"
 #include "settings/GUISettings.h"
 #include "utils/log.h"
+#include "utils/Mime.h"
 #include "filesystem/File.h"
 #include "pictures/Picture.h"
 #include "utils/URIUtils.h"
@@ -40,10 +41,13 @@ CTextureCacheJob::CTextureCacheJob(const CStdString &url, const CStdString &oldH
   m_url = url;
   m_oldHash = oldHash;
   m_cachePath = CTextureCache::GetCacheFile(m_url);
+  m_width = m_height = 0;
+  m_pixels = NULL;
 }
 
 CTextureCacheJob::~CTextureCacheJob()
 {
+  delete[] m_pixels;
 }
 
 bool CTextureCacheJob::operator==(const CJob* job) const
@@ -74,34 +78,20 @@ bool CTextureCacheJob::DoWork()
 
 bool CTextureCacheJob::CacheTexture(CBaseTexture **out_texture)
 {
-  // unwrap the URL as required
-  std::string additional_info;
-  unsigned int width, height;
-  CStdString image = DecodeImageURL(m_url, width, height, additional_info);
-
-  m_details.updateable = additional_info != "music" && UpdateableURL(image);
-
-  // generate the hash
-  m_details.hash = GetImageHash(image);
-  if (m_details.hash.empty())
+  if (!Fetch())
     return false;
-  else if (m_details.hash == m_oldHash)
+  else if (!NeedsCaching())
     return true;
 
-  CBaseTexture *texture = LoadImage(image, width, height, additional_info);
+  CBaseTexture *texture = LoadTexture();
   if (texture)
   {
-    if (texture->HasAlpha())
-      m_details.file = m_cachePath + ".png";
-    else
-      m_details.file = m_cachePath + ".jpg";
+    CLog::Log(LOGDEBUG, "%s image '%s' to '%s':", m_oldHash.IsEmpty() ? "Caching" : "Recaching", m_image.c_str(), m_details.file.c_str());
 
-    CLog::Log(LOGDEBUG, "%s image '%s' to '%s':", m_oldHash.IsEmpty() ? "Caching" : "Recaching", image.c_str(), m_details.file.c_str());
-
-    if (CPicture::CacheTexture(texture, width, height, CTextureCache::GetCachedPath(m_details.file)))
+    if (CPicture::CacheTexture(texture, m_width, m_height, CTextureCache::GetCachedPath(m_details.file)))
     {
-      m_details.width = width;
-      m_details.height = height;
+      m_details.width = m_width;
+      m_details.height = m_height;
       if (out_texture) // caller wants the texture
         *out_texture = texture;
       else
@@ -113,6 +103,110 @@ bool CTextureCacheJob::CacheTexture(CBaseTexture **out_texture)
   return false;
 }
 
+bool CTextureCacheJob::Fetch()
+{
+  // unwrap the URL as required
+  m_image = DecodeImageURL(m_url, m_width, m_height, m_additionalInfo);
+
+  m_details.updateable = m_additionalInfo != "music" && UpdateableURL(m_image);
+
+  // generate the hash
+  m_details.hash = GetImageHash(m_image);
+  if (m_details.hash.empty())
+    return false;
+  else if (m_details.hash == m_oldHash)
+    return true;
+
+  // read the image into memory, so that decoding it doesn't wait on the filesystem
+  if (m_additionalInfo == "music")
+  { // special case for embedded music images
+    MUSIC_INFO::EmbeddedArt art;
+    if (!CMusicThumbLoader::GetEmbeddedThumb(m_image, art) || art.data.empty())
+      return false;
+    m_data.assign(art.data.begin(), art.data.end());
+    m_mimeType = art.mime;
+    return true;
+  }
+
+  // images that the loader handles specially are left to it
+  m_mimeType = CMime::GetMimeType(URIUtils::GetExtension(m_image));
+  if (m_mimeType.compare(0, 6, "image/") != 0 ||
+      URIUtils::GetExtension(m_image).Equals(".dds") ||
+      URIUtils::IsInPath(m_image, "androidapp://"))
+    return true;
+#if defined(HAS_OMXPLAYER)
+  if (m_mimeType == "image/jpeg")
+    return true;
+#endif
+
+  XFILE::CFile file;
+  if (file.Open(m_image, 0))
+  {
+    int64_t length = file.GetLength();
+    if (length > 0)
+    {
+      m_data.resize((size_t)length);
+      if (file.Read(&m_data[0], length) != length)
+        m_data.clear(); // leave it to the loader
+    }
+    file.Close();
+  }
+  return true;
+}
+
+bool CTextureCacheJob::Decode()
+{
+  CBaseTexture *texture = LoadTexture();
+  if (!texture)
+    return false;
+
+  CLog::Log(LOGDEBUG, "%s image '%s' to '%s':", m_oldHash.IsEmpty() ? "Caching" : "Recaching", m_image.c_str(), m_details.file.c_str());
+
+  m_pixels = CPicture::ScaleTexture(texture, m_width, m_height);
+  delete texture;
+  return m_pixels != NULL;
+}
+
+bool CTextureCacheJob::Encode()
+{
+  bool success = CPicture::CreateThumbnailFromSurface((unsigned char *)m_pixels, m_width, m_height, m_width * 4,
+                                                      CTextureCache::GetCachedPath(m_details.file));
+  delete[] m_pixels;
+  m_pixels = NULL;
+  if (!success)
+    return false;
+
+  m_details.width = m_width;
+  m_details.height = m_height;
+  return true;
+}
+
+CBaseTexture *CTextureCacheJob::LoadTexture()
+{
+  CBaseTexture *texture = NULL;
+  if (m_data.empty())
+    texture = LoadImage(m_image, m_width, m_height, m_additionalInfo);
+  else
+  {
+    bool autoRotate = m_additionalInfo != "music" && g_guiSettings.GetBool("pictures.useexifrotation");
+    texture = CBaseTexture::LoadFromFileInMemory(&m_data[0], m_data.size(), m_mimeType, m_width, m_height, autoRotate);
+    std::vector<unsigned char>().swap(m_data);
+
+    // see LoadImage()
+    if (texture && m_additionalInfo == "flipped")
+      texture->SetOrientation(texture->GetOrientation() ^ 1);
+  }
+
+  if (texture)
+  {
+    if (texture->HasAlpha())
+      m_details.file = m_cachePath + ".png";
+    else
+      m_details.file = m_cachePath + ".jpg";
+  }
+  return texture;
+}
+
 CStdString CTextureCacheJob::DecodeImageURL(const CStdString &url, unsigned int &width, unsigned int &height, std::string &additional_info)
 {
   // unwrap the URL as required
@@ -282,3 +376,26 @@ bool CTextureUseCountJob::DoWork()
   }
   return true;
 }
+
+CTextureIndexJob::CTextureIndexJob(TASK task) : m_task(task)
+{
+}
+
+bool CTextureIndexJob::operator==(const CJob* job) const
+{
+  if (strcmp(job->GetType(),GetType()) == 0)
+  {
+    const CTextureIndexJob* indexJob = dynamic_cast<const CTextureIndexJob*>(job);
+    if (indexJob && indexJob->m_task == m_task)
+      return true;
+  }
+  return false;
+}
+
+bool CTextureIndexJob::DoWork()
+{
+  if (m_task == LOAD_INDEX)
+    return CTextureCache::Get().LoadIndex();
+  CTextureCache::Get().WriteIndex();
+  return true;
+}
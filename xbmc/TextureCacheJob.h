@@ -75,12 +75,31 @@ public:
    */
   bool CacheTexture(CBaseTexture **texture = NULL);
 
+  /*! \brief The stages of CacheTexture, for running on separate threads
+   Fetch() hashes the image and reads it into memory, Decode() loads and scales it, and
+   Encode() writes the cached file. Each stage returns false if caching has failed.
+   The later stages are only needed if NeedsCaching() is true after Fetch().
+   \sa CacheTexture, CTextureCachePipeline
+   */
+  bool Fetch();
+  bool Decode();
+  bool Encode();
+
+  /*! \brief Whether the image has changed since it was cached, once fetched
+   */
+  bool NeedsCaching() const { return m_details.hash != m_oldHash; };
+
   CStdString m_url;
   CStdString m_oldHash;
   CTextureDetails m_details;
 private:
   friend class CEdenVideoArtUpdater;
 
+  /*! \brief Load the fetched image, setting the cached file name by whether it has alpha
+   \return a pointer to a CBaseTexture object, NULL if failed.
+   */
+  CBaseTexture *LoadTexture();
+
   /*! \brief retrieve a hash for the given image
    Combines the size, ctime and mtime of the image file into a "unique" hash
    \param url location of the image
@@ -120,6 +139,14 @@ private:
   static CBaseTexture *LoadImage(const CStdString &image, unsigned int width, unsigned int height, const std::string &additional_info);
 
   CStdString    m_cachePath;
+
+  CStdString                 m_image;          ///< unwrapped url of the image
+  std::string                m_additionalInfo;
+  unsigned int               m_width;          ///< size to cache at, replaced with the cached size
+  unsigned int               m_height;
+  std::vector<unsigned char> m_data;           ///< image file read by Fetch(), if it can be loaded from memory
+  std::string                m_mimeType;
+  uint32_t                  *m_pixels;         ///< image scaled by Decode()
 };
 
 /* \brief Job class for creating .dds versions of textures
@@ -150,3 +177,23 @@ public:
 private:
   std::vector<CTextureDetails> m_textures;
 };
+
+/* \brief Job class for keeping the in-memory texture index of CTextureCache in sync with the database
+ Loads the index when the texture cache is initialized, and writes changes made to it
+ back to the database in batches.
+ */
+class CTextureIndexJob : public CJob
+{
+public:
+  enum TASK { LOAD_INDEX = 0,
+              WRITE_INDEX };
+
+  CTextureIndexJob(TASK task);
+
+  virtual const char* GetType() const { return "textureindex"; };
+  virtual bool operator==(const CJob *job) const;
+  virtual bool DoWork();
+
+private:
+  TASK m_task;
+};
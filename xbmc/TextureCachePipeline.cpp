@@ -0,0 +1,202 @@
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "TextureCachePipeline.h"
+#include "TextureCacheJob.h"
+#include "threads/SingleLock.h"
+
+#include <algorithm>
+
+/* runs one stage of caching an image, owning the caching job until it is handed on to the next stage */
+class CTextureStageJob : public CJob
+{
+public:
+  CTextureStageJob(CTextureCacheJob *job, CTextureCachePipeline::STAGE stage, CTextureCachePipeline *pipeline, unsigned int generation)
+    : m_job(job), m_stage(stage), m_pipeline(pipeline), m_generation(generation), m_dropped(false) {}
+
+  virtual ~CTextureStageJob()
+  {
+    delete m_job;
+  }
+
+  virtual const char* GetType() const { return "cacheimage"; };
+
+  virtual bool DoWork()
+  {
+    switch (m_stage)
+    {
+    case CTextureCachePipeline::STAGE_FETCH:
+      if (!m_pipeline->StartCaching(m_job, m_generation))
+      {
+        m_dropped = true;
+        return false;
+      }
+      return m_job->Fetch();
+    case CTextureCachePipeline::STAGE_DECODE:
+      return m_job->Decode();
+    default:
+      return m_job->Encode();
+    }
+  }
+
+  CTextureCacheJob                   *m_job;
+  const CTextureCachePipeline::STAGE  m_stage;
+  CTextureCachePipeline              *m_pipeline;
+  const unsigned int                  m_generation;
+  bool                                m_dropped; ///< the callback didn't want the image cached
+};
+
+CTextureCachePipeline::CTextureCachePipeline(ITextureCacheCallback *callback, unsigned int fetchers, unsigned int decoders,
+                                             unsigned int encoders, unsigned int capacity)
+  : m_callback(callback), m_generation(0)
+{
+  m_stages[STAGE_FETCH].m_limit = std::max(fetchers, 1U);
+  m_stages[STAGE_DECODE].m_limit = std::max(decoders, 1U);
+  m_stages[STAGE_DECODE].m_capacity = std::max(capacity, 1U);
+  m_stages[STAGE_ENCODE].m_limit = std::max(encoders, 1U);
+  m_stages[STAGE_ENCODE].m_capacity = std::max(capacity, 1U);
+}
+
+CTextureCachePipeline::~CTextureCachePipeline()
+{
+  Cancel();
+}
+
+void CTextureCachePipeline::Add(CTextureCacheJob *job)
+{
+  CSingleLock lock(m_section);
+  if (!m_urls.insert(job->m_url).second)
+  { // already on its way
+    delete job;
+    return;
+  }
+  m_stages[STAGE_FETCH].m_queue.push_back(job);
+  QueueNextJobs();
+}
+
+void CTextureCachePipeline::Cancel()
+{
+  CSingleLock lock(m_section);
+  m_generation++;
+  for (std::vector<unsigned int>::iterator i = m_jobIDs.begin(); i != m_jobIDs.end(); ++i)
+    CJobManager::GetInstance().CancelJob(*i);
+  m_jobIDs.clear();
+
+  for (unsigned int i = 0; i < STAGE_COUNT; i++)
+  {
+    CStage &stage = m_stages[i];
+    for (std::deque<CTextureCacheJob*>::iterator j = stage.m_queue.begin(); j != stage.m_queue.end(); ++j)
+      delete *j;
+    stage.m_queue.clear();
+    stage.m_running = 0;
+  }
+  m_urls.clear();
+
+  // the callback still counts the started images as being cached
+  std::set<CStdString> started;
+  started.swap(m_started);
+  lock.Leave();
+  for (std::set<CStdString>::iterator i = started.begin(); i != started.end(); ++i)
+    m_callback->OnCachingCancelled(*i);
+}
+
+bool CTextureCachePipeline::StartCaching(CTextureCacheJob *job, unsigned int generation)
+{
+  {
+    CSingleLock lock(m_section);
+    if (generation != m_generation)
+      return false;
+  }
+
+  // without the lock, the callback may look the image up in the texture cache first
+  if (!m_callback->OnCachingStart(job))
+    return false;
+
+  CSingleLock lock(m_section);
+  if (generation == m_generation)
+  {
+    m_started.insert(job->m_url);
+    return true;
+  }
+  // cancelled while the callback decided
+  lock.Leave();
+  m_callback->OnCachingCancelled(job->m_url);
+  return false;
+}
+
+bool CTextureCachePipeline::IsActive() const
+{
+  CSingleLock lock(m_section);
+  return !m_urls.empty();
+}
+
+void CTextureCachePipeline::OnJobComplete(unsigned int jobID, bool success, CJob *job)
+{
+  CTextureStageJob *stageJob = (CTextureStageJob *)job;
+  CTextureCacheJob *cacheJob = stageJob->m_job;
+
+  CSingleLock lock(m_section);
+  std::vector<unsigned int>::iterator i = find(m_jobIDs.begin(), m_jobIDs.end(), jobID);
+  if (i == m_jobIDs.end())
+    return; // cancelled
+  m_jobIDs.erase(i);
+  m_stages[stageJob->m_stage].m_running--;
+
+  bool finished = !success || stageJob->m_stage + 1 == STAGE_COUNT || !cacheJob->NeedsCaching();
+  if (finished)
+  {
+    m_urls.erase(cacheJob->m_url);
+    m_started.erase(cacheJob->m_url);
+  }
+  else
+  { // hand on to the next stage
+    stageJob->m_job = NULL;
+    m_stages[stageJob->m_stage + 1].m_queue.push_back(cacheJob);
+  }
+  QueueNextJobs();
+  lock.Leave();
+
+  // the job manager deletes the stage job, along with the caching job, once we return
+  if (finished && !stageJob->m_dropped)
+    m_callback->OnCachingComplete(success, cacheJob);
+}
+
+void CTextureCachePipeline::QueueNextJobs()
+{
+  CSingleLock lock(m_section);
+  // later stages first, so that images further along are finished before more are started
+  for (int i = STAGE_COUNT - 1; i >= 0; i--)
+  {
+    CStage &stage = m_stages[i];
+    while (!stage.m_queue.empty() && stage.m_running < stage.m_limit)
+    {
+      if (i + 1 < STAGE_COUNT)
+      { // make sure there is room for the result in front of the next stage
+        const CStage &next = m_stages[i + 1];
+        if (next.m_capacity && next.m_queue.size() + stage.m_running >= next.m_capacity)
+          break;
+      }
+      CTextureCacheJob *job = stage.m_queue.front();
+      stage.m_queue.pop_front();
+      stage.m_running++;
+      m_jobIDs.push_back(CJobManager::GetInstance().AddJob(new CTextureStageJob(job, (STAGE)i, this, m_generation), this));
+    }
+  }
+}
@@ -0,0 +1,140 @@
+#pragma once
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "utils/JobManager.h"
+#include "utils/StdString.h"
+
+#include <deque>
+#include <set>
+
+class CTextureCacheJob;
+
+/*!
+ \ingroup textures
+ \brief Callback interface for the owner of a CTextureCachePipeline
+ */
+class ITextureCacheCallback
+{
+public:
+  virtual ~ITextureCacheCallback() {};
+
+  /*! \brief Called before an image is fetched
+   \param job the caching job.
+   \return true to cache the image, false to drop it.
+   */
+  virtual bool OnCachingStart(CTextureCacheJob *job)=0;
+
+  /*! \brief Called once an image has been cached, or has failed to be
+   \param success whether the image was cached.
+   \param job the caching job.
+   */
+  virtual void OnCachingComplete(bool success, CTextureCacheJob *job)=0;
+
+  /*! \brief Called for an image that was started, but is dropped by CTextureCachePipeline::Cancel()
+   OnCachingComplete() isn't called for it.
+   \param url the url of the image.
+   */
+  virtual void OnCachingCancelled(const CStdString &url)=0;
+};
+
+/*!
+ \ingroup textures
+ \brief Caches images in stages on the job manager
+
+ Caching an image is split into fetching (hashing and reading the file), decoding and
+ scaling, and encoding and writing the cached file. Each stage has its own limit on
+ the number of images processed at once, so that slow network fetches don't hold up
+ the CPU bound stages, and a bounded queue in front of it, so that the images fetched
+ or decoded ahead of the next stage don't build up in memory. Adding the caching
+ results to the database is left to the callback.
+
+ \sa CTextureCacheJob, ITextureCacheCallback
+ */
+class CTextureCachePipeline : public IJobCallback
+{
+public:
+  enum STAGE { STAGE_FETCH = 0,
+               STAGE_DECODE,
+               STAGE_ENCODE,
+               STAGE_COUNT };
+
+  /*! \brief Construct a pipeline
+   \param callback the owner of the pipeline, called as images start and finish.
+   \param fetchers number of images fetched at once.
+   \param decoders number of images decoded and scaled at once.
+   \param encoders number of images encoded and written at once.
+   \param capacity number of images that may wait in front of each stage after the first.
+   */
+  CTextureCachePipeline(ITextureCacheCallback *callback, unsigned int fetchers, unsigned int decoders,
+                        unsigned int encoders, unsigned int capacity);
+  virtual ~CTextureCachePipeline();
+
+  /*! \brief Queue an image for caching
+   Images already in the pipeline are not added again.
+   \param job the caching job. The pipeline takes ownership.
+   */
+  void Add(CTextureCacheJob *job);
+
+  /*! \brief Drop all images in the pipeline
+   Images being processed may finish after this call, but OnCachingComplete() is not called
+   for them. OnCachingCancelled() is called instead for the images that were started.
+   */
+  void Cancel();
+
+  /*! \brief Whether any images are in the pipeline
+   */
+  bool IsActive() const;
+
+  virtual void OnJobComplete(unsigned int jobID, bool success, CJob *job);
+
+private:
+  friend class CTextureStageJob;
+
+  /*! \brief Start as many queued images on their next stage as the limits allow
+   */
+  void QueueNextJobs();
+
+  /*! \brief Ask the callback whether an image is to be cached, from its fetch job
+   \param job the caching job.
+   \param generation the value of m_generation when the fetch job was queued.
+   \return true to cache the image, false if it was dropped or cancelled.
+   */
+  bool StartCaching(CTextureCacheJob *job, unsigned int generation);
+
+  class CStage
+  {
+  public:
+    CStage() : m_limit(1), m_capacity(0), m_running(0) {};
+
+    std::deque<CTextureCacheJob*> m_queue;
+    unsigned int                  m_limit;    ///< images processed at once
+    unsigned int                  m_capacity; ///< images that may wait in m_queue, 0 for no limit
+    unsigned int                  m_running;
+  };
+
+  ITextureCacheCallback     *m_callback;
+  CStage                     m_stages[STAGE_COUNT];
+  std::set<CStdString>       m_urls;     ///< urls of the images in the pipeline
+  std::set<CStdString>       m_started;  ///< urls of the images the callback was told about
+  unsigned int               m_generation; ///< counts the calls to Cancel()
+  std::vector<unsigned int>  m_jobIDs;   ///< ids of the stage jobs with the job manager
+  mutable CCriticalSection   m_section;
+};
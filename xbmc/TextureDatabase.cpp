@@ -177,6 +177,50 @@ bool CTextureDatabase::GetCachedTexture(const CStdString &url, CTextureDetails &
   return false;
 }
 
+bool CTextureDatabase::GetCachedTextures(std::map<CStdString, CCachedTexture> &textures, int &lastID, unsigned int limit)
+{
+  CStdString sql = PrepareSQL("SELECT id, cachedurl, lasthashcheck, imagehash, width, height, url FROM texture JOIN sizes ON (texture.id=sizes.idtexture AND sizes.size=1) WHERE id>%i ORDER BY id LIMIT %u", lastID, limit);
+  return GetCachedTextures(sql, textures, lastID);
+}
+
+bool CTextureDatabase::GetCachedTextures(std::map<CStdString, CCachedTexture> &textures, const CStdString &url)
+{
+  CStdString sql = PrepareSQL("SELECT id, cachedurl, lasthashcheck, imagehash, width, height, url FROM texture JOIN sizes ON (texture.id=sizes.idtexture AND sizes.size=1) WHERE url='%s'", url.c_str());
+  int lastID;
+  return GetCachedTextures(sql, textures, lastID);
+}
+
+bool CTextureDatabase::GetCachedTextures(const CStdString &sql, std::map<CStdString, CCachedTexture> &textures, int &lastID)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    m_pDS->query(sql.c_str());
+    while (!m_pDS->eof())
+    {
+      CCachedTexture texture;
+      texture.id = m_pDS->fv(0).get_asInt();
+      texture.file = m_pDS->fv(1).get_asString();
+      texture.lastHashCheck.SetFromDBDateTime(m_pDS->fv(2).get_asString());
+      texture.hash = m_pDS->fv(3).get_asString();
+      texture.width = m_pDS->fv(4).get_asInt();
+      texture.height = m_pDS->fv(5).get_asInt();
+      textures[m_pDS->fv(6).get_asString()] = texture;
+      lastID = texture.id;
+      m_pDS->next();
+    }
+    m_pDS->close();
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed with sql '%s'", __FUNCTION__, sql.c_str());
+  }
+  return false;
+}
+
 bool CTextureDatabase::SetCachedTextureValid(const CStdString &url, bool updateable)
 {
   CStdString date = updateable ? CDateTime::GetCurrentDateTime().GetAsDBDateTime() : "";
@@ -184,7 +228,7 @@ bool CTextureDatabase::SetCachedTextureValid(const CStdString &url, bool updatea
   return ExecuteQuery(sql);
 }
 
-bool CTextureDatabase::AddCachedTexture(const CStdString &url, const CTextureDetails &details)
+bool CTextureDatabase::AddCachedTexture(const CStdString &url, CTextureDetails &details)
 {
   try
   {
@@ -202,12 +246,14 @@ bool CTextureDatabase::AddCachedTexture(const CStdString &url, const CTextureDet
     // set the size information
     sql = PrepareSQL("INSERT INTO sizes (idtexture, size, usecount, lastusetime, width, height) VALUES(%u, 1, 1, CURRENT_TIMESTAMP, %u, %u)", textureID, details.width, details.height);
     m_pDS->exec(sql.c_str());
+    details.id = textureID;
+    return true;
   }
   catch (...)
   {
     CLog::Log(LOGERROR, "%s failed on url '%s'", __FUNCTION__, url.c_str());
   }
-  return true;
+  return false;
 }
 
 bool CTextureDatabase::ClearCachedTexture(const CStdString &url, CStdString &cacheFile)
@@ -22,6 +22,31 @@
 
 #include "dbwrappers/Database.h"
 #include "TextureCacheJob.h"
+#include "XBDateTime.h"
+
+#include <map>
+
+/*!
+ \ingroup textures
+ \brief Details of a cached texture along with when its hash was last checked.
+
+ Used for the in-memory copy of the texture table kept by CTextureCache. Unlike
+ CTextureDetails returned from CTextureDatabase::GetCachedTexture, the hash is
+ always set, and NeedsCheck() determines whether it should be handed out.
+ */
+class CCachedTexture : public CTextureDetails
+{
+public:
+  /*! \brief Whether the texture is due to be checked for updates
+   \param now the current time.
+   \return true if the texture was last checked more than a day ago, false otherwise.
+   */
+  bool NeedsCheck(const CDateTime &now) const
+  {
+    return lastHashCheck.IsValid() && lastHashCheck + CDateTimeSpan(1,0,0,0) < now;
+  };
+  CDateTime lastHashCheck; ///< invalid if the texture isn't updateable
+};
 
 class CTextureDatabase : public CDatabase
 {
@@ -31,7 +56,29 @@ public:
   virtual bool Open();
 
   bool GetCachedTexture(const CStdString &originalURL, CTextureDetails &details);
-  bool AddCachedTexture(const CStdString &originalURL, const CTextureDetails &details);
+
+  /*! \brief Get the details of a range of cached textures
+   Used to fill the in-memory index of CTextureCache a part at a time, in order of id.
+   \param textures [in/out] texture details keyed by url, the retrieved textures are added.
+   \param lastID [in/out] only textures with an id greater than this are retrieved. Set to the id of the last texture retrieved.
+   \param limit the maximum number of textures to retrieve.
+   \return true if successful, false otherwise.
+   */
+  bool GetCachedTextures(std::map<CStdString, CCachedTexture> &textures, int &lastID, unsigned int limit);
+
+  /*! \brief Get the details of a single cached texture for the in-memory index of CTextureCache
+   \param textures [in/out] texture details keyed by url, the texture is added if it is cached.
+   \param originalURL url of the original image.
+   \return true if successful, false otherwise.
+   */
+  bool GetCachedTextures(std::map<CStdString, CCachedTexture> &textures, const CStdString &originalURL);
+
+  /*! \brief Add a texture to the database, replacing any previous version
+   \param originalURL url of the original image
+   \param details details of the cached texture. The id is set to that of the added texture.
+   \return true if successful, false otherwise.
+   */
+  bool AddCachedTexture(const CStdString &originalURL, CTextureDetails &details);
   bool SetCachedTextureValid(const CStdString &originalURL, bool updateable);
   bool ClearCachedTexture(const CStdString &originalURL, CStdString &cacheFile);
   bool IncrementUseCount(const CTextureDetails &details);
@@ -72,6 +119,8 @@ public:
   void ClearTextureForPath(const CStdString &url, const CStdString &type);
 
 protected:
+  friend class TestTextureCache;
+
   /*! \brief retrieve a hash for the given url
    Computes a hash of the current url to use for lookups in the database
    \param url url to hash
@@ -79,6 +128,11 @@ protected:
    */
   unsigned int GetURLHash(const CStdString &url) const;
 
+  /*! \brief Run a query on the texture and sizes tables and add the results to the given map
+   \sa GetCachedTextures
+   */
+  bool GetCachedTextures(const CStdString &sql, std::map<CStdString, CCachedTexture> &textures, int &lastID);
+
   virtual bool CreateTables();
   virtual bool UpdateOldVersion(int version);
   virtual int GetMinVersion() const { return 13; };
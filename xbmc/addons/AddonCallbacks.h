@@ -227,6 +227,8 @@ typedef void (*PVRTriggerEpgUpdate)(void *addonData, unsigned int iChannelUid);
 
 typedef void (*PVRTransferChannelGroup)(void *addonData, const ADDON_HANDLE handle, const PVR_CHANNEL_GROUP *group);
 typedef void (*PVRTransferChannelGroupMember)(void *addonData, const ADDON_HANDLE handle, const PVR_CHANNEL_GROUP_MEMBER *member);
+typedef void (*PVRTransferEpgEntries)(void *userData, const ADDON_HANDLE handle, const EPG_TAG *epgentries, unsigned int iEntries);
+typedef void (*PVRTransferChannelEntries)(void *userData, const ADDON_HANDLE handle, const PVR_CHANNEL *channels, unsigned int iChannels);
 
 typedef void (*PVRFreeDemuxPacket)(void *addonData, DemuxPacket* pPacket);
 typedef DemuxPacket* (*PVRAllocateDemuxPacket)(void *addonData, int iDataSize);
@@ -248,6 +250,8 @@ typedef struct CB_PVRLib
   PVRAllocateDemuxPacket        AllocateDemuxPacket;
   PVRTransferChannelGroup       TransferChannelGroup;
   PVRTransferChannelGroupMember TransferChannelGroupMember;
+  PVRTransferEpgEntries         TransferEpgEntries;
+  PVRTransferChannelEntries     TransferChannelEntries;
 
 } CB_PVRLib;
 
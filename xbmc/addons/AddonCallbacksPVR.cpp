@@ -60,6 +60,8 @@ CAddonCallbacksPVR::CAddonCallbacksPVR(CAddon* addon)
   m_callbacks->AllocateDemuxPacket        = PVRAllocateDemuxPacket;
   m_callbacks->TransferChannelGroup       = PVRTransferChannelGroup;
   m_callbacks->TransferChannelGroupMember = PVRTransferChannelGroupMember;
+  m_callbacks->TransferEpgEntries         = PVRTransferEpgEntries;
+  m_callbacks->TransferChannelEntries     = PVRTransferChannelEntries;
 }
 
 CAddonCallbacksPVR::~CAddonCallbacksPVR()
@@ -174,6 +176,45 @@ void CAddonCallbacksPVR::PVRTransferChannelEntry(void *addonData, const ADDON_HA
   xbmcChannels->UpdateFromClient(transferChannel);
 }
 
+void CAddonCallbacksPVR::PVRTransferEpgEntries(void *addonData, const ADDON_HANDLE handle, const EPG_TAG *entries, unsigned int iEntries)
+{
+  if (!handle)
+  {
+    CLog::Log(LOGERROR, "PVR - %s - invalid handler data", __FUNCTION__);
+    return;
+  }
+
+  CEpg *xbmcEpg = static_cast<CEpg *>(handle->dataAddress);
+  if (!xbmcEpg || (!entries && iEntries > 0))
+  {
+    CLog::Log(LOGERROR, "PVR - %s - invalid handler data", __FUNCTION__);
+    return;
+  }
+
+  /* transfer these entries to the epg */
+  xbmcEpg->UpdateEntries(entries, iEntries, handle->dataIdentifier == 1 /* update db */);
+}
+
+void CAddonCallbacksPVR::PVRTransferChannelEntries(void *addonData, const ADDON_HANDLE handle, const PVR_CHANNEL *channels, unsigned int iChannels)
+{
+  if (!handle)
+  {
+    CLog::Log(LOGERROR, "PVR - %s - invalid handler data", __FUNCTION__);
+    return;
+  }
+
+  CPVRClient *client                     = GetPVRClient(addonData);
+  CPVRChannelGroupInternal *xbmcChannels = static_cast<CPVRChannelGroupInternal *>(handle->dataAddress);
+  if ((!channels && iChannels > 0) || !client || !xbmcChannels)
+  {
+    CLog::Log(LOGERROR, "PVR - %s - invalid handler data", __FUNCTION__);
+    return;
+  }
+
+  /* transfer these entries to the internal channels group */
+  xbmcChannels->UpdateFromClient(channels, iChannels, client->GetID());
+}
+
 void CAddonCallbacksPVR::PVRTransferRecordingEntry(void *addonData, const ADDON_HANDLE handle, const PVR_RECORDING *recording)
 {
   if (!handle)
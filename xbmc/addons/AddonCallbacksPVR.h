@@ -78,6 +78,24 @@ public:
    */
   static void PVRTransferChannelEntry(void* addonData, const ADDON_HANDLE handle, const PVR_CHANNEL* entry);
 
+  /*!
+   * @brief Transfer a list of EPG tags from the add-on to XBMC
+   * @param addonData A pointer to the add-on.
+   * @param handle The handle parameter that XBMC used when requesting the EPG data
+   * @param entries The entries to transfer to XBMC
+   * @param iEntries The number of entries
+   */
+  static void PVRTransferEpgEntries(void* addonData, const ADDON_HANDLE handle, const EPG_TAG* entries, unsigned int iEntries);
+
+  /*!
+   * @brief Transfer a list of channel entries from the add-on to XBMC
+   * @param addonData A pointer to the add-on.
+   * @param handle The handle parameter that XBMC used when requesting the channel list
+   * @param entries The entries to transfer to XBMC
+   * @param iEntries The number of entries
+   */
+  static void PVRTransferChannelEntries(void* addonData, const ADDON_HANDLE handle, const PVR_CHANNEL* entries, unsigned int iEntries);
+
   /*!
    * @brief Transfer a timer entry from the add-on to XBMC
    * @param addonData A pointer to the add-on.
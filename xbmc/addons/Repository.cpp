@@ -30,7 +30,7 @@
 #include "utils/URIUtils.h"
 #include "dialogs/GUIDialogYesNo.h"
 #include "dialogs/GUIDialogKaiToast.h"
-#include "TextureDatabase.h"
+#include "TextureCache.h"
 #include "URL.h"
 
 using namespace XFILE;
@@ -199,8 +199,6 @@ bool CRepositoryUpdateJob::DoWork()
   CAddonDatabase database;
   database.Open();
   
-  CTextureDatabase textureDB;
-  textureDB.Open();
   for (unsigned int i=0;i<addons.size();++i)
   {
     // manager told us to feck off
@@ -211,9 +209,9 @@ bool CRepositoryUpdateJob::DoWork()
 
     // invalidate the art associated with this item
     if (!addons[i]->Props().fanart.empty())
-      textureDB.InvalidateCachedTexture(addons[i]->Props().fanart);
+      CTextureCache::Get().InvalidateCachedImage(addons[i]->Props().fanart);
     if (!addons[i]->Props().icon.empty())
-      textureDB.InvalidateCachedTexture(addons[i]->Props().icon);
+      CTextureCache::Get().InvalidateCachedImage(addons[i]->Props().icon);
 
     AddonPtr addon;
     CAddonMgr::Get().GetAddon(addons[i]->ID(),addon);
@@ -104,7 +104,8 @@ extern "C"
   //@{
   /*!
    * Request the EPG for a channel from the backend.
-   * EPG entries are added to XBMC by calling TransferEpgEntry() on the callback.
+   * EPG entries are added to XBMC by calling TransferEpgEntry() or TransferEpgEntries() on the callback.
+   * Transferring all entries of the table with a single TransferEpgEntries() call is preferred.
    * @param handle Handle to pass to the callback method.
    * @param channel The channel to get the EPG table for.
    * @param iStart Get events after this time (UTC).
@@ -170,7 +171,7 @@ extern "C"
 
   /*!
    * Request the list of all channels from the backend.
-   * Channel entries are added to XBMC by calling TransferChannelEntry() on the callback.
+   * Channel entries are added to XBMC by calling TransferChannelEntry() or TransferChannelEntries() on the callback.
    * @param handle Handle to pass to the callback method.
    * @param bRadio True to get the radio channels, false to get the TV channels.
    * @return PVR_ERROR_NO_ERROR if the list has been fetched successfully.
@@ -72,7 +72,7 @@ struct DemuxPacket;
 #define PVR_STREAM_MAX_STREAMS 20
 
 /* current PVR API version */
-#define XBMC_PVR_API_VERSION "1.5.0"
+#define XBMC_PVR_API_VERSION "1.6.0"
 
 /* min. PVR API version */
 #define XBMC_PVR_MIN_API_VERSION "1.5.0"
@@ -39,6 +39,18 @@
 #define LOGFATAL   6
 #define LOGNONE    7
 
+// components, or'ed into the level of a message so that it can be filtered
+// by the level set for its component with CLog::SetComponentLogLevel()
+#define LOGCOMPONENTSHIFT 16
+#define LOGLEVELMASK      ((1 << LOGCOMPONENTSHIFT) - 1)
+#define LOGPLAYER   (1 << LOGCOMPONENTSHIFT)
+#define LOGAUDIO    (2 << LOGCOMPONENTSHIFT)
+#define LOGVIDEO    (3 << LOGCOMPONENTSHIFT)
+#define LOGGUI      (4 << LOGCOMPONENTSHIFT)
+#define LOGNETWORK  (5 << LOGCOMPONENTSHIFT)
+#define LOGDATABASE (6 << LOGCOMPONENTSHIFT)
+#define LOGCOMPONENTS 7 // including the general component 0
+
 #ifdef __GNUC__
 #define ATTRIB_LOG_FORMAT __attribute__((format(printf,3,4)))
 #else
@@ -74,6 +74,9 @@ CSoftAE::CSoftAE():
   m_outputStageFn      (NULL        ),
   m_streamStageFn      (NULL        )
 {
+  /* more than enough for the GUI sounds queued between two mixer runs */
+  m_soundQueue.Create(64);
+
   CAESinkFactory::EnumerateEx(m_sinkInfoList);
   for (AESinkInfoList::iterator itt = m_sinkInfoList.begin(); itt != m_sinkInfoList.end(); ++itt)
   {
@@ -799,14 +802,20 @@ void CSoftAE::PlaySound(IAESound *sound)
   if (!samples)
     return;
 
-  /* add the sound to the play list */
-  CSingleLock soundSampleLock(m_soundSampleLock);
-  SoundState ss = {
-    ((CSoftAESound*)sound),
-    samples,
-    ((CSoftAESound*)sound)->GetSampleCount()
-  };
-  m_playing_sounds.push_back(ss);
+  /* queue the sound for the mixer, this never waits for the mixer thread */
+  CSingleLock soundQueueLock(m_soundQueueLock);
+  SoundState *ss = m_soundQueue.Reserve();
+  if (!ss)
+  {
+    ((CSoftAESound*)sound)->ReleaseSamples();
+    return;
+  }
+
+  ss->owner       = (CSoftAESound*)sound;
+  ss->samples     = samples;
+  ss->sampleCount = ((CSoftAESound*)sound)->GetSampleCount();
+  m_soundQueue.Commit();
+  soundQueueLock.Leave();
 
   /* wake to play the sound */
   m_softSuspend = false;
@@ -845,6 +854,7 @@ unsigned int CSoftAE::GetSampleRate()
 void CSoftAE::StopSound(IAESound *sound)
 {
   CSingleLock lock(m_soundSampleLock);
+  TakeQueuedSounds();
   for (SoundStateList::iterator itt = m_playing_sounds.begin(); itt != m_playing_sounds.end(); )
   {
     if ((*itt).owner == sound)
@@ -953,6 +963,7 @@ void CSoftAE::SetVolume(float volume)
 void CSoftAE::StopAllSounds()
 {
   CSingleLock lock(m_soundSampleLock);
+  TakeQueuedSounds();
   while (!m_playing_sounds.empty())
   {
     SoundState *ss = &(*m_playing_sounds.begin());
@@ -1017,7 +1028,7 @@ void CSoftAE::Run()
         restart = true;
     }
 
-    if (m_playingStreams.empty() && m_playing_sounds.empty() && m_streams.empty() && 
+    if (m_playingStreams.empty() && m_playing_sounds.empty() && !m_soundQueue.GetReadSize() && m_streams.empty() &&
        !m_softSuspend && !g_advancedSettings.m_streamSilence)
     {
       m_softSuspend = true;
@@ -1041,7 +1052,7 @@ void CSoftAE::Run()
         delete m_sink;
         m_sink = NULL;
       }
-      if (!m_playingStreams.empty() || !m_playing_sounds.empty() || m_sounds.empty())
+      if (!m_playingStreams.empty() || !m_playing_sounds.empty() || m_soundQueue.GetReadSize() || m_sounds.empty())
         m_softSuspend = false;
       m_wake.WaitMSec(SOFTAE_IDLE_WAIT_MSEC);
     }
@@ -1068,16 +1079,32 @@ void CSoftAE::AllocateConvIfNeeded(size_t convertedSize, bool prezero)
     memset(m_converted, 0x00, convertedSize);
 }
 
+void CSoftAE::TakeQueuedSounds()
+{
+  SoundState *ss;
+  while ((ss = m_soundQueue.Peek()))
+  {
+    m_playing_sounds.push_back(*ss);
+    m_soundQueue.Release();
+  }
+}
+
 unsigned int CSoftAE::MixSounds(float *buffer, unsigned int samples)
 {
   // no point doing anything if we have no sounds,
   // we do not have to take a lock just to check empty
-  if (m_playing_sounds.empty())
+  if (m_playing_sounds.empty() && !m_soundQueue.GetReadSize())
     return 0;
 
+  // never wait for StopSound, anything it leaves playing is mixed next time
+  CSingleTryLock lock(m_soundSampleLock);
+  if (!lock.IsOwner())
+    return 0;
+
+  TakeQueuedSounds();
+
   SoundStateList::iterator itt;
   unsigned int mixed = 0;
-  CSingleLock lock(m_soundSampleLock);
   for (itt = m_playing_sounds.begin(); itt != m_playing_sounds.end(); )
   {
     SoundState *ss = &(*itt);
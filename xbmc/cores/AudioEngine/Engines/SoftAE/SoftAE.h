@@ -30,6 +30,7 @@
 
 #include "Interfaces/ThreadedAE.h"
 #include "Utils/AEBuffer.h"
+#include "Utils/AERingBuffer.h"
 #include "AEAudioFormat.h"
 #include "AESinkFactory.h"
 
@@ -142,7 +143,8 @@ private:
   CCriticalSection m_runningLock;     /* released when the thread exits */
   CCriticalSection m_streamLock;      /* m_streams lock */
   CCriticalSection m_soundLock;       /* m_sounds lock */
-  CCriticalSection m_soundSampleLock; /* m_playing_sounds lock */
+  CCriticalSection m_soundSampleLock; /* m_playing_sounds lock, and consumer side of m_soundQueue */
+  CCriticalSection m_soundQueueLock;  /* producer side of m_soundQueue */
   CSharedSection   m_sinkLock;        /* lock for m_sink on re-open */
 
   /* the current configuration */
@@ -183,6 +185,7 @@ private:
   StreamList     m_newStreams, m_streams, m_playingStreams;
   SoundList      m_sounds;
   SoundStateList m_playing_sounds;
+  AESPSCRing<SoundState> m_soundQueue; /* sounds waiting to be picked up by MixSounds */
   int            m_soundMode;
   bool           m_streamsPlaying;
 
@@ -208,6 +211,11 @@ private:
    */
   unsigned int MixSounds        (float *buffer, unsigned int samples);
 
+  /*! \brief Move the sounds queued by PlaySound to m_playing_sounds.
+   Must be called while holding m_soundSampleLock.
+   */
+  void         TakeQueuedSounds ();
+
   /*! \brief Finalize samples ready for sending to the output device.
    Mixes in any UI sounds, applies volume adjustment, and clamps to [-1,1].
    \param buffer the audio data.
@@ -20,6 +20,7 @@
 
 #include "system.h"
 #include "threads/SingleLock.h"
+#include "threads/Atomics.h"
 #include "utils/log.h"
 #include "utils/MathUtils.h"
 
@@ -42,14 +43,25 @@ CSoftAEStream::CSoftAEStream(enum AEDataFormat dataFormat, unsigned int sampleRa
   m_delete          (false),
   m_volume          (1.0f ),
   m_rgain           (1.0f ),
-  m_refillBuffer    (0    ),
+  m_refillTarget    (0    ),
   m_convertFn       (NULL ),
   m_ssrc            (NULL ),
-  m_framesBuffered  (0    ),
+  m_framesQueued    (0    ),
+  m_framesPlayed    (0    ),
+  m_flushedAt       (0    ),
+  m_flushRequests   (0    ),
+  m_flushesDone     (0    ),
+  m_flushesSeen     (0    ),
+  m_ratioRequests   (0    ),
+  m_ratioApplied    (0    ),
   m_newPacket       (NULL ),
   m_packet          (NULL ),
   m_vizPacketPos    (NULL ),
   m_draining        (false),
+  m_underruns       (0    ),
+  m_underrunsSeen   (0    ),
+  m_overruns        (0    ),
+  m_maxQueued       (0    ),
   m_vizBufferSamples(0    ),
   m_audioCallback   (NULL ),
   m_fadeRunning     (false),
@@ -138,7 +150,7 @@ void CSoftAEStream::Initialize()
   // set the waterlevel to 75 percent of the number of frames per second.
   // this lets us drain the main buffer down futher before flagging an underrun.
   m_waterLevel      = AE.GetSampleRate() - (AE.GetSampleRate() / 4);
-  m_refillBuffer    = m_waterLevel;
+  m_refillTarget    = m_framesQueued + m_waterLevel;
 
   m_format.m_dataFormat    = useDataFormat;
   m_format.m_sampleRate    = m_initSampleRate;
@@ -148,6 +160,7 @@ void CSoftAEStream::Initialize()
   m_format.m_frameSamples  = m_format.m_frames * m_initChannelLayout.Count();
   m_format.m_frameSize     = m_bytesPerFrame;
 
+  FreePackets(m_freeBuffer);
   m_newPacket = new PPacket();
   if (AE_IS_RAW(m_initDataFormat))
     m_newPacket->data.Alloc(m_format.m_frames * m_format.m_frameSize);
@@ -185,6 +198,13 @@ void CSoftAEStream::Initialize()
   else
     m_convertBuffer = (float*)m_inputBuffer.Raw(m_format.m_frames * m_format.m_frameSize);
 
+  /* a re-init starts over at the internal ratio, drop what SetResampleRatio asked for */
+  {
+    CSingleLock ratioLock(m_ratioSection);
+    m_resampleRatio = 1.0;
+    m_ratioApplied  = m_ratioRequests;
+  }
+
   /* if we need to resample, set it up */
   if (m_resample)
   {
@@ -198,6 +218,18 @@ void CSoftAEStream::Initialize()
     m_ssrcData.end_of_input  = 0;
   }
 
+  /*
+    size the packet queues for the most GetSpace can let in: the water level,
+    plus the input buffer and the water level again after resampling
+  */
+  double       ratio   = m_resample ? std::ceil(m_internalRatio) + 1.0 : 1.0;
+  unsigned int packets = (unsigned int)((ratio + 1.0) * m_waterLevel / m_format.m_frames + ratio) + 2;
+  if (m_outBuffer.GetMaxSize() < packets)
+  {
+    m_outBuffer .Create(packets);
+    m_freeBuffer.Create(packets);
+  }
+
   m_chLayoutCount = m_format.m_channelLayout.Count();
   m_valid = true;
 }
@@ -214,6 +246,7 @@ CSoftAEStream::~CSoftAEStream()
   CExclusiveLock lock(m_lock);
 
   InternalFlush();
+  FreePackets(m_freeBuffer);
   if (m_convert)
     _aligned_free(m_convertBuffer);
 
@@ -224,7 +257,24 @@ CSoftAEStream::~CSoftAEStream()
     m_ssrc = NULL;
   }
 
-  CLog::Log(LOGDEBUG, "CSoftAEStream::~CSoftAEStream - Destructed");
+  CLog::Log(m_underruns || m_overruns ? LOGINFO : LOGDEBUG, "CSoftAEStream::~CSoftAEStream - Destructed, %u underruns, %u overruns, at most %u of %u packets queued",
+    m_underruns, m_overruns, m_maxQueued, m_outBuffer.GetMaxSize());
+}
+
+unsigned int CSoftAEStream::GetFramesBuffered()
+{
+  /* everything that was queued before a Flush AddData has not applied yet is stale */
+  if (IsFlushPending())
+    return 0;
+
+  /* and so are the frames before m_flushedAt, even if GetFrame did not drop them yet */
+  unsigned int played    = m_framesPlayed;
+  unsigned int flushedAt = m_flushedAt;
+  if ((int)(flushedAt - played) > 0)
+    played = flushedAt;
+
+  unsigned int queued = m_framesQueued;
+  return (int)(queued - played) > 0 ? queued - played : 0;
 }
 
 unsigned int CSoftAEStream::GetSpace()
@@ -232,23 +282,50 @@ unsigned int CSoftAEStream::GetSpace()
   if (!m_valid || m_draining)
     return 0;
 
-  if (m_framesBuffered >= m_waterLevel)
+  /* AddData empties everything before it takes more data */
+  if (IsFlushPending())
+    return m_inputBuffer.Size() + (m_waterLevel * m_format.m_frameSize);
+
+  /* packets the mixer had no room for yet have to go first */
+  if (!m_pendingPackets.empty())
+    return 0;
+
+  unsigned int buffered = GetFramesBuffered();
+  if (buffered >= m_waterLevel)
     return 0;
 
-  return m_inputBuffer.Free() + (std::max(0U, (m_waterLevel - m_framesBuffered)) * m_format.m_frameSize);
+  return m_inputBuffer.Free() + ((m_waterLevel - buffered) * m_format.m_frameSize);
 }
 
 unsigned int CSoftAEStream::AddData(void *data, unsigned int size)
 {
-  CExclusiveLock lock(m_lock);
+  /* GetFrame only takes the shared lock too, so the mixer never waits on us */
+  CSharedLock lock(m_lock);
   if (!m_valid || size == 0 || data == NULL)
     return 0;
 
+  /* apply what Flush and SetResampleRatio asked for since the last call */
+  if (IsFlushPending())
+    ApplyFlush();
+  if (m_ratioRequests != m_ratioApplied)
+    ApplyResampleRatio();
+
+  /* the mixer ran dry, refill before it gets any more frames */
+  if (m_underruns != m_underrunsSeen)
+  {
+    m_underrunsSeen = m_underruns;
+    unsigned int buffered = GetFramesBuffered();
+    m_refillTarget = m_framesQueued + (m_waterLevel > buffered ? m_waterLevel - buffered : 0);
+  }
+
+  if (!FlushPendingPackets())
+    return 0;
+
   /* if the stream is draining */
   if (m_draining)
   {
     /* if the stream has finished draining, cork it */
-    if (m_packet && !m_packet->data.Used() && m_outBuffer.empty())
+    if (!m_packet && !m_outBuffer.GetReadSize())
       m_draining = false;
     else
       return 0;
@@ -281,7 +358,7 @@ unsigned int CSoftAEStream::AddData(void *data, unsigned int size)
   lock.Leave();
 
   /* if the stream is flagged to autoStart when the buffer is full, then do it */
-  if (m_autoStart && m_framesBuffered >= m_waterLevel)
+  if (m_autoStart && GetFramesBuffered() >= m_waterLevel)
     Resume();
 
   return taken;
@@ -335,16 +412,7 @@ unsigned int CSoftAEStream::ProcessFrameBuffer()
     consumed = frames * m_bytesPerFrame;
   }
 
-  if (m_refillBuffer)
-  {
-    if (frames > m_refillBuffer)
-      m_refillBuffer = 0;
-    else
-      m_refillBuffer -= frames;
-  }
-
   /* buffer the data */
-  m_framesBuffered += frames;
   const unsigned int inputBlockSize = m_format.m_frames * m_format.m_channelLayout.Count() * sampleSize;
 
   size_t remaining = samples * sampleSize;
@@ -362,19 +430,18 @@ unsigned int CSoftAEStream::ProcessFrameBuffer()
     /* if we have a full block of data */
     if (AE_IS_RAW(m_initDataFormat))
     {
-      m_outBuffer.push_back(m_newPacket);
-      m_newPacket = new PPacket();
-      m_newPacket->data.Alloc(inputBlockSize);
+      QueuePacket(m_newPacket);
+      m_newPacket = GetFreePacket(inputBlockSize, 0);
       continue;
     }
 
-    /* make a new packet for downmix/remap */
-    PPacket *pkt = new PPacket();
+    /* get a packet for downmix/remap */
+    size_t frames  = m_newPacket->data.Used() / m_format.m_channelLayout.Count() / sizeof(float);
+    size_t used    = frames * m_aeChannelLayout.Count() * sizeof(float);
+    size_t vizUsed = m_audioCallback ? frames * 2 * sizeof(float) : 0;
+    PPacket *pkt = GetFreePacket(used, vizUsed);
 
     /* downmix/remap the data */
-    size_t frames = m_newPacket->data.Used() / m_format.m_channelLayout.Count() / sizeof(float);
-    size_t used   = frames * m_aeChannelLayout.Count() * sizeof(float);
-    pkt->data.Alloc(used);
     m_remap.Remap(
       (float*)m_newPacket->data.Raw (m_newPacket->data.Used()),
       (float*)pkt        ->data.Take(used),
@@ -382,10 +449,8 @@ unsigned int CSoftAEStream::ProcessFrameBuffer()
     );
 
     /* downmix for the viz if we have one */
-    if (m_audioCallback)
+    if (vizUsed)
     {
-      size_t vizUsed = frames * 2 * sizeof(float);
-      pkt->vizData.Alloc(vizUsed);
       m_vizRemap.Remap(
         (float*)m_newPacket->data   .Raw (m_newPacket->data.Used()),
         (float*)pkt        ->vizData.Take(vizUsed),
@@ -394,16 +459,106 @@ unsigned int CSoftAEStream::ProcessFrameBuffer()
     }
 
     /* add the packet to the output */
-    m_outBuffer.push_back(pkt);
+    QueuePacket(pkt);
     m_newPacket->data.Empty();
   }
 
+  /* count the frames after queueing the packets, so a refill can not end before they are visible */
+  m_framesQueued += frames;
   return consumed;
 }
 
+CSoftAEStream::PPacket *CSoftAEStream::GetFreePacket(size_t size, size_t vizSize)
+{
+  /* reuse a packet the mixer is done with if there is one */
+  PPacket *pkt;
+  PPacket **slot = m_freeBuffer.Peek();
+  if (slot)
+  {
+    pkt = *slot;
+    m_freeBuffer.Release();
+  }
+  else
+    pkt = new PPacket();
+
+  /* raw packets are only queued once full, so the size must match exactly */
+  if (pkt->data.Size() != size)
+    pkt->data.Alloc(size);
+  pkt->data.Empty();
+  pkt->data.CursorReset();
+
+  if (vizSize && pkt->vizData.Size() != vizSize)
+    pkt->vizData.Alloc(vizSize);
+  pkt->vizData.Empty();
+  pkt->vizData.CursorReset();
+
+  return pkt;
+}
+
+void CSoftAEStream::QueuePacket(PPacket *packet)
+{
+  PPacket **slot = FlushPendingPackets() ? m_outBuffer.Reserve() : NULL;
+  if (!slot)
+  {
+    /*
+      should never happen, the queue is sized for everything GetSpace lets in.
+      hold on to the packet and stop taking data until the mixer made room.
+    */
+    if (m_pendingPackets.empty())
+      CLog::Log(LOGWARNING, "CSoftAEStream::QueuePacket - Packet queue is full, holding back audio");
+    packet->generation = m_flushesDone;
+    m_pendingPackets.push_back(packet);
+    ++m_overruns;
+    return;
+  }
+
+  packet->generation = m_flushesDone;
+  *slot = packet;
+  m_outBuffer.Commit();
+  m_maxQueued = std::max(m_maxQueued, m_outBuffer.GetReadSize());
+}
+
+bool CSoftAEStream::FlushPendingPackets()
+{
+  while (!m_pendingPackets.empty())
+  {
+    PPacket **slot = m_outBuffer.Reserve();
+    if (!slot)
+      return false;
+
+    *slot = m_pendingPackets.front();
+    m_outBuffer.Commit();
+    m_pendingPackets.pop_front();
+  }
+  return true;
+}
+
+void CSoftAEStream::RecyclePacket(PPacket *packet)
+{
+  /* hand the packet back to AddData for reuse */
+  PPacket **slot = m_freeBuffer.Reserve();
+  if (slot)
+  {
+    *slot = packet;
+    m_freeBuffer.Commit();
+  }
+  else
+    delete packet;
+}
+
+void CSoftAEStream::FreePackets(AESPSCRing<PPacket*> &ring)
+{
+  PPacket **slot;
+  while ((slot = ring.Peek()))
+  {
+    delete *slot;
+    ring.Release();
+  }
+}
+
 uint8_t* CSoftAEStream::GetFrame()
 {
-  CExclusiveLock lock(m_lock);
+  CSharedLock lock(m_lock);
 
   /* if we are fading, this runs even if we have underrun as it is time based */
   if (m_fadeRunning)
@@ -422,34 +577,70 @@ uint8_t* CSoftAEStream::GetFrame()
     }
   }
 
-  /* if we have been deleted or are refilling but not draining */
-  if (!m_valid || m_delete || (m_refillBuffer && !m_draining))
+  /* if we have been deleted */
+  if (!m_valid || m_delete)
+    return NULL;
+
+  /*
+    drop the packets that were queued before the last Flush. this has to happen
+    even while refilling, or they could take the room AddData refills into.
+    AddData may already have applied a newer Flush, so only older packets go.
+  */
+  long flushes = m_flushRequests;
+  if (flushes != m_flushesSeen)
+  {
+    if (m_packet && (long)(flushes - m_packet->generation) > 0)
+    {
+      m_framesPlayed += (m_packet->data.Used() - m_packet->data.CursorOffset()) / m_aeBytesPerFrame;
+      RecyclePacket(m_packet);
+      m_packet = NULL;
+    }
+
+    PPacket **slot;
+    while ((slot = m_outBuffer.Peek()) && (long)(flushes - (*slot)->generation) > 0)
+    {
+      m_framesPlayed += (*slot)->data.Used() / m_aeBytesPerFrame;
+      RecyclePacket(*slot);
+      m_outBuffer.Release();
+    }
+
+    /* nothing new yet, AddData has set the refill target for after the flush */
+    if (!slot && !m_packet)
+      return NULL;
+    m_flushesSeen = flushes;
+  }
+
+  /* if we are refilling but not draining */
+  if (IsBuffering() && !m_draining)
     return NULL;
 
   /* if the packet is empty, advance to the next one */
   if (!m_packet || m_packet->data.CursorEnd())
   {
-    delete m_packet;
-    m_packet = NULL;
+    if (m_packet)
+    {
+      RecyclePacket(m_packet);
+      m_packet = NULL;
+    }
 
     /* no more packets, return null */
-    if (m_outBuffer.empty())
+    PPacket **slot = m_outBuffer.Peek();
+    if (!slot)
     {
       if (m_draining)
         return NULL;
       else
       {
-        /* underrun, we need to refill our buffers */
-        CLog::Log(LOGDEBUG, "CSoftAEStream::GetFrame - Underrun");
-        ASSERT(m_waterLevel > m_framesBuffered);
-        m_refillBuffer = m_waterLevel - m_framesBuffered;
+        /* underrun, AddData sets the refill target before it queues more */
+        ++m_underruns;
+        CLog::Log(LOGDEBUG, "CSoftAEStream::GetFrame - Underrun (%u so far, %u frames buffered)", m_underruns, GetFramesBuffered());
         return NULL;
       }
     }
 
     /* get the next packet */
-    m_packet = m_outBuffer.front();
-    m_outBuffer.pop_front();
+    m_packet = *slot;
+    m_outBuffer.Release();
   }
 
   /* fetch one frame of data */
@@ -468,7 +659,7 @@ uint8_t* CSoftAEStream::GetFrame()
     }
   }
 
-  --m_framesBuffered;
+  ++m_framesPlayed;
   return ret;
 }
 
@@ -478,8 +669,9 @@ double CSoftAEStream::GetDelay()
     return 0.0;
 
   double delay = AE.GetDelay();
-  delay += (double)(m_inputBuffer.Used() / m_format.m_frameSize) / (double)m_format.m_sampleRate;
-  delay += (double)m_framesBuffered                              / (double)AE.GetSampleRate();
+  if (!IsFlushPending())
+    delay += (double)(m_inputBuffer.Used() / m_format.m_frameSize) / (double)m_format.m_sampleRate;
+  delay += (double)GetFramesBuffered()                           / (double)AE.GetSampleRate();
 
   return delay;
 }
@@ -489,9 +681,10 @@ double CSoftAEStream::GetCacheTime()
   if (m_delete)
     return 0.0;
 
-  double time;
-  time  = (double)(m_inputBuffer.Used() / m_format.m_frameSize) / (double)m_format.m_sampleRate;
-  time += (double)(m_waterLevel - m_framesBuffered)             / (double)AE.GetSampleRate();
+  double time = 0.0;
+  if (!IsFlushPending())
+    time += (double)(m_inputBuffer.Used() / m_format.m_frameSize) / (double)m_format.m_sampleRate;
+  time += (double)(m_waterLevel - GetFramesBuffered())          / (double)AE.GetSampleRate();
   time += AE.GetCacheTime();
   return time;
 }
@@ -527,27 +720,28 @@ void CSoftAEStream::Resume()
 
 void CSoftAEStream::Drain()
 {
-  CSharedLock lock(m_lock);
   m_draining = true;
 }
 
 bool CSoftAEStream::IsDrained()
 {
   CSharedLock lock(m_lock);
-  return (m_draining && !m_packet && m_outBuffer.empty());
+  return (m_draining && !m_packet && !m_outBuffer.GetReadSize() && m_pendingPackets.empty());
 }
 
 void CSoftAEStream::Flush()
 {
   CLog::Log(LOGDEBUG, "CSoftAEStream::Flush");
-  CExclusiveLock lock(m_lock);
-  InternalFlush();
 
-  /* internal flush does not do this as these samples are still valid if we are re-initializing */
-  m_inputBuffer.Empty();
+  /*
+    AddData resets the input and resampler before it takes more data, and
+    GetFrame drops what was queued so far, see ApplyFlush
+  */
+  m_draining = false;
+  AtomicIncrement(&m_flushRequests);
 }
 
-void CSoftAEStream::InternalFlush()
+unsigned int CSoftAEStream::ResetProducer()
 {
   /* reset the resampler */
   if (m_resample)
@@ -556,28 +750,63 @@ void CSoftAEStream::InternalFlush()
     src_reset(m_ssrc);
   }
 
-  /* invalidate any incoming samples */
+  /* invalidate any incoming samples, they were counted in m_framesQueued already */
+  unsigned int frameSize = AE_IS_RAW(m_initDataFormat) ? m_bytesPerFrame : m_chLayoutCount * sizeof(float);
+  unsigned int dropped   = m_newPacket->data.Used() / frameSize;
   m_newPacket->data.Empty();
 
+  while (!m_pendingPackets.empty())
+  {
+    dropped += m_pendingPackets.front()->data.Used() / m_aeBytesPerFrame;
+    delete m_pendingPackets.front();
+    m_pendingPackets.pop_front();
+  }
+
+  return dropped;
+}
+
+void CSoftAEStream::ApplyFlush()
+{
+  long flushes = m_flushRequests;
+
+  /* only Flush drops the input, InternalFlush keeps it as the samples are still valid */
+  m_inputBuffer.Empty();
+  m_framesQueued -= ResetProducer();
+
+  /* GetFrame counts the packets it drops as played, so it catches up with m_flushedAt */
+  m_flushedAt     = m_framesQueued;
+  m_refillTarget  = m_framesQueued + m_waterLevel;
+  m_underrunsSeen = m_underruns;
+  m_flushesDone   = flushes;
+}
+
+void CSoftAEStream::InternalFlush()
+{
+  /* the exclusive lock is held, so both sides can be reset right here */
+  ResetProducer();
+  if (IsFlushPending())
+  {
+    m_inputBuffer.Empty();
+    m_flushesDone = m_flushRequests;
+  }
+
   /*
     clear the current buffered packet, we cant delete the data as it may be
     in use by the AE thread, so we just seek to the end of the buffer
   */
   if (m_packet)
-    m_packet->data.CursorSeek(m_packet->data.Size());
+    m_packet->data.CursorSeek(m_packet->data.Used());
 
-  /* clear any other buffered packets */
-  while (!m_outBuffer.empty())
-  {
-    PPacket *p = m_outBuffer.front();
-    m_outBuffer.pop_front();
-    delete p;
-  }
+  /* clear any other buffered packets, GetFrame can not run as we hold the exclusive lock */
+  FreePackets(m_outBuffer);
 
   /* reset our counts */
-  m_framesBuffered = 0;
-  m_refillBuffer   = m_waterLevel;
-  m_draining       = false;
+  m_framesQueued  = 0;
+  m_framesPlayed  = 0;
+  m_flushedAt     = 0;
+  m_refillTarget  = m_waterLevel;
+  m_underrunsSeen = m_underruns;
+  m_draining      = false;
 }
 
 double CSoftAEStream::GetResampleRatio()
@@ -585,8 +814,8 @@ double CSoftAEStream::GetResampleRatio()
   if (!m_resample)
     return 1.0f;
 
-  CSharedLock lock(m_lock);
-  return m_ssrcData.src_ratio;
+  CSingleLock lock(m_ratioSection);
+  return m_resampleRatio * m_internalRatio;
 }
 
 bool CSoftAEStream::SetResampleRatio(double ratio)
@@ -594,14 +823,26 @@ bool CSoftAEStream::SetResampleRatio(double ratio)
   if (!m_resample)
     return false;
 
-  CSharedLock lock(m_lock);
+  /* the resampler belongs to AddData, it picks the ratio up before the next block */
+  CSingleLock lock(m_ratioSection);
+  m_resampleRatio = ratio;
+  ++m_ratioRequests;
+  return true;
+}
 
-  int oldRatioInt = (int)std::ceil(m_ssrcData.src_ratio);
+void CSoftAEStream::ApplyResampleRatio()
+{
+  double ratio;
+  {
+    CSingleLock lock(m_ratioSection);
+    ratio          = m_resampleRatio * m_internalRatio;
+    m_ratioApplied = m_ratioRequests;
+  }
 
-  m_resampleRatio = ratio;
+  int oldRatioInt = (int)std::ceil(m_ssrcData.src_ratio);
 
-  src_set_ratio(m_ssrc, m_resampleRatio * m_internalRatio);
-  m_ssrcData.src_ratio = m_resampleRatio * m_internalRatio;
+  src_set_ratio(m_ssrc, ratio);
+  m_ssrcData.src_ratio = ratio;
 
   //Check the resample buffer size and resize if necessary.
   if (oldRatioInt < std::ceil(m_ssrcData.src_ratio))
@@ -610,7 +851,6 @@ bool CSoftAEStream::SetResampleRatio(double ratio)
     m_ssrcData.data_out      = (float*)_aligned_malloc(m_format.m_frameSamples * (int)std::ceil(m_ssrcData.src_ratio) * sizeof(float), 16);
     m_ssrcData.output_frames = m_format.m_frames * (long)std::ceil(m_ssrcData.src_ratio);
   }
-  return true;
 }
 
 void CSoftAEStream::RegisterAudioCallback(IAudioCallback* pCallback)
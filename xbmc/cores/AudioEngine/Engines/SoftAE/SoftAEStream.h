@@ -20,15 +20,18 @@
  */
 
 #include <samplerate.h>
+#include <deque>
 #include <list>
 
 #include "threads/SharedSection.h"
+#include "threads/CriticalSection.h"
 
 #include "AEAudioFormat.h"
 #include "Interfaces/AEStream.h"
 #include "Utils/AEConvert.h"
 #include "Utils/AERemap.h"
 #include "Utils/AEBuffer.h"
+#include "Utils/AERingBuffer.h"
 
 class IAEPostProc;
 class CSoftAEStream : public IAEStream
@@ -52,7 +55,7 @@ public:
   virtual unsigned int      GetSpace        ();
   virtual unsigned int      AddData         (void *data, unsigned int size);
   virtual double            GetDelay        ();
-  virtual bool              IsBuffering     () { return m_refillBuffer > 0; }
+  virtual bool              IsBuffering     () { return (int)(m_refillTarget - m_framesQueued) > 0; }
   virtual double            GetCacheTime    ();
   virtual double            GetCacheTotal   ();
 
@@ -82,9 +85,18 @@ public:
   virtual void              FadeVolume(float from, float to, unsigned int time);
   virtual bool              IsFading();
   virtual void              RegisterSlave(IAEStream *stream);
+
+  /* queue statistics, for profiling the handoff to the mixer */
+  unsigned int GetQueuedPackets   () { return m_outBuffer.GetReadSize(); }
+  unsigned int GetMaxQueuedPackets() { return m_maxQueued; }
+  unsigned int GetQueueSize       () { return m_outBuffer.GetMaxSize(); }
+  unsigned int GetUnderruns       () { return m_underruns; }
+  unsigned int GetOverruns        () { return m_overruns; }
 private:
   void InternalFlush();
-  void CheckResampleBuffers();
+  void ApplyFlush();
+  void ApplyResampleRatio();
+  unsigned int ResetProducer();
 
   CSharedSection    m_lock;
   enum AEDataFormat m_initDataFormat;
@@ -97,13 +109,14 @@ private:
   {
     CAEBuffer data;
     CAEBuffer vizData;
+    long      generation; /* the flushes the producer had applied when it queued the packet */
   } PPacket;
 
   AEAudioFormat m_format;
 
   bool                    m_forceResample; /* true if we are to force resample even when the rates match */
   bool                    m_resample;      /* true if the audio needs to be resampled  */
-  double                  m_resampleRatio; /* user specified resample ratio */
+  double                  m_resampleRatio; /* user specified resample ratio, guarded by m_ratioSection */
   double                  m_internalRatio; /* internal resample ratio */ 
   bool                    m_convert;       /* true if the bitspersample needs converting */
   float                  *m_convertBuffer; /* buffer for converted data */
@@ -113,7 +126,7 @@ private:
   float                   m_volume;        /* the volume level */
   float                   m_rgain;         /* replay gain level */
   unsigned int            m_waterLevel;    /* the fill level to fall below before calling the data callback */
-  unsigned int            m_refillBuffer;  /* how many frames that need to be buffered before we return any frames */
+  volatile unsigned int   m_refillTarget;  /* m_framesQueued has to reach this before we return any frames */
 
   CAEConvert::AEConvertToFn m_convertFn;
 
@@ -125,16 +138,49 @@ private:
   unsigned int        m_aeBytesPerFrame;
   SRC_STATE          *m_ssrc;
   SRC_DATA            m_ssrcData;
-  unsigned int        m_framesBuffered;
-  std::list<PPacket*> m_outBuffer;
+
+  /*
+    packets are handed to the mixer thread through m_outBuffer, and come back
+    through m_freeBuffer once played so AddData can reuse them. Each counter is
+    only written by one side, and the input, convert and resample state is only
+    touched by AddData. Flush and SetResampleRatio just post a request that
+    AddData applies before it takes more data, GetFrame drops the packets that
+    were queued before the last Flush by their generation. Both sides only hold
+    the shared lock, the exclusive one is for (re)initializing the stream.
+  */
+  AESPSCRing<PPacket*>  m_outBuffer;
+  AESPSCRing<PPacket*>  m_freeBuffer;
+  volatile unsigned int m_framesQueued;  /* frames added by AddData, only written by AddData */
+  volatile unsigned int m_framesPlayed;  /* frames taken or dropped by GetFrame, only written by GetFrame */
+  volatile unsigned int m_flushedAt;     /* m_framesQueued when AddData applied the last Flush */
+  volatile long         m_flushRequests; /* bumped by Flush */
+  volatile long         m_flushesDone;   /* the flush requests AddData has applied */
+  long                  m_flushesSeen;   /* the flush requests GetFrame has dropped the packets for */
+  CCriticalSection      m_ratioSection;  /* the SetResampleRatio command slot, never taken by GetFrame */
+  volatile long         m_ratioRequests; /* bumped by SetResampleRatio */
+  long                  m_ratioApplied;  /* the ratio requests AddData has applied */
+  bool                IsFlushPending() { return m_flushRequests != m_flushesDone; }
+  unsigned int        GetFramesBuffered();
   unsigned int        ProcessFrameBuffer();
+  PPacket            *GetFreePacket(size_t size, size_t vizSize);
+  void                QueuePacket(PPacket *packet);
+  bool                FlushPendingPackets();
+  void                RecyclePacket(PPacket *packet);
+  void                FreePackets(AESPSCRing<PPacket*> &ring);
+  std::deque<PPacket*> m_pendingPackets; /* packets that did not fit in m_outBuffer yet */
   PPacket            *m_newPacket;
   PPacket            *m_packet;
   uint8_t            *m_packetPos;
   float              *m_vizPacketPos;
   bool                m_paused;
   bool                m_autoStart;
-  bool                m_draining;
+  volatile bool       m_draining;
+
+  /* queue statistics */
+  unsigned int        m_underruns;     /* only written by GetFrame */
+  unsigned int        m_underrunsSeen; /* the underruns AddData has set a refill target for */
+  unsigned int        m_overruns;      /* packets that had to wait for room in m_outBuffer */
+  unsigned int        m_maxQueued;
 
   /* vizualization internals */
   CAERemap           m_vizRemap;
@@ -25,6 +25,8 @@
 #include "AEUtil.h"
 #include "utils/MathUtils.h"
 #include "utils/EndianSwap.h"
+#include "utils/CPUInfo.h"
+#include "utils/TimeUtils.h"
 #include <stdint.h>
 
 #if defined(TARGET_WINDOWS)
@@ -42,12 +44,16 @@
 #include <arm_neon.h>
 #endif
 
-#define CLAMP(x) std::min(-1.0f, std::max(1.0f, (float)(x)))
+#define CLAMP(x) std::max(-1.0f, std::min(1.0f, (float)(x)))
 
 #ifndef INT24_MAX
 #define INT24_MAX (0x7FFFFF)
 #endif
 
+#ifndef INT24_MIN
+#define INT24_MIN (-0x800000)
+#endif
+
 #define INT32_SCALE (-1.0f / INT_MIN)
 
 static inline int safeRound(double f)
@@ -65,8 +71,26 @@ static inline int safeRound(double f)
   return MathUtils::round_int(f);
 }
 
+static inline int clampInt(int value, int min, int max)
+{
+  if (value < min)
+    return min;
+  if (value > max)
+    return max;
+  return value;
+}
+
 CAEConvert::AEConvertToFn CAEConvert::ToFloat(enum AEDataFormat dataFormat)
 {
+#ifdef __SSE__
+  if (g_cpuInfo.GetCPUFeatures() & CPU_FEATURE_SSE2)
+  {
+    AEConvertToFn fn = ToFloatSSE(dataFormat);
+    if (fn)
+      return fn;
+  }
+#endif
+
   switch (dataFormat)
   {
     case AE_FMT_U8    : return &U8_Float;
@@ -103,6 +127,15 @@ CAEConvert::AEConvertToFn CAEConvert::ToFloat(enum AEDataFormat dataFormat)
 
 CAEConvert::AEConvertFrFn CAEConvert::FrFloat(enum AEDataFormat dataFormat)
 {
+#ifdef __SSE__
+  if (g_cpuInfo.GetCPUFeatures() & CPU_FEATURE_SSE2)
+  {
+    AEConvertFrFn fn = FrFloatSSE(dataFormat);
+    if (fn)
+      return fn;
+  }
+#endif
+
   switch (dataFormat)
   {
     case AE_FMT_U8    : return &Float_U8;
@@ -131,6 +164,60 @@ CAEConvert::AEConvertFrFn CAEConvert::FrFloat(enum AEDataFormat dataFormat)
   }
 }
 
+#ifdef __SSE__
+CAEConvert::AEConvertToFn CAEConvert::ToFloatSSE(enum AEDataFormat dataFormat)
+{
+#ifdef __BIG_ENDIAN__
+  return NULL;
+#else
+  switch (dataFormat)
+  {
+    case AE_FMT_U8    : return &U8_Float_SSE;
+    case AE_FMT_S8    : return &S8_Float_SSE;
+    case AE_FMT_S16NE :
+    case AE_FMT_S16LE : return &S16LE_Float_SSE;
+    case AE_FMT_S16BE : return &S16BE_Float_SSE;
+    case AE_FMT_S24NE4:
+    case AE_FMT_S24LE4: return &S24LE4_Float_SSE;
+    case AE_FMT_S24BE4: return &S24BE4_Float_SSE;
+    case AE_FMT_S24NE3:
+    case AE_FMT_S24LE3: return &S24LE3_Float_SSE;
+    case AE_FMT_S24BE3: return &S24BE3_Float_SSE;
+    case AE_FMT_S32NE :
+    case AE_FMT_S32LE : return &S32LE_Float_SSE;
+    case AE_FMT_S32BE : return &S32BE_Float_SSE;
+    case AE_FMT_DOUBLE: return &DOUBLE_Float_SSE;
+    default:
+      return NULL;
+  }
+#endif
+}
+
+CAEConvert::AEConvertFrFn CAEConvert::FrFloatSSE(enum AEDataFormat dataFormat)
+{
+#ifdef __BIG_ENDIAN__
+  return NULL;
+#else
+  switch (dataFormat)
+  {
+    case AE_FMT_U8    : return &Float_U8_SSE;
+    case AE_FMT_S8    : return &Float_S8_SSE;
+    case AE_FMT_S16NE :
+    case AE_FMT_S16LE : return &Float_S16LE_SSE;
+    case AE_FMT_S16BE : return &Float_S16BE_SSE;
+    case AE_FMT_S24NE4: return &Float_S24NE4_SSE;
+    case AE_FMT_S24NE3: return &Float_S24NE3_SSE;
+    case AE_FMT_S32NE :
+    case AE_FMT_S32LE : return &Float_S32LE_SSE;
+    case AE_FMT_S32BE : return &Float_S32BE_SSE;
+    case AE_FMT_DOUBLE: return &Float_DOUBLE_SSE;
+    default:
+      return NULL;
+  }
+#endif
+}
+#endif
+
 unsigned int CAEConvert::U8_Float(uint8_t *data, const unsigned int samples, float *dest)
 {
   const float mul = 2.0f / UINT8_MAX;
@@ -146,7 +233,7 @@ unsigned int CAEConvert::S8_Float(uint8_t *data, const unsigned int samples, flo
   const float mul = 1.0f / (INT8_MAX + 0.5f);
 
   for (unsigned int i = 0; i < samples; ++i)
-    *dest++ = *data++ * mul;
+    *dest++ = (int8_t)*data++ * mul;
 
   return samples;
 }
@@ -176,7 +263,7 @@ unsigned int CAEConvert::S16LE_Float(uint8_t* data, const unsigned int samples,
   }
 #else
   for (unsigned int i = 0; i < samples; ++i, data += 2)
-    *dest++ = Endian_SwapLE16(*(int16_t*)data) * mul;
+    *dest++ = (int16_t)Endian_SwapLE16(*(uint16_t*)data) * mul;
 #endif
 
   return samples;
@@ -207,7 +294,7 @@ unsigned int CAEConvert::S16BE_Float(uint8_t* data, const unsigned int samples,
   }
 #else
   for (unsigned int i = 0; i < samples; ++i, data += 2)
-    *dest++ = Endian_SwapBE16(*(int16_t*)data) * mul;
+    *dest++ = (int16_t)Endian_SwapBE16(*(uint16_t*)data) * mul;
 #endif
 
   return samples;
@@ -247,7 +334,7 @@ unsigned int CAEConvert::S24BE3_Float(uint8_t *data, const unsigned int samples,
 {
   for (unsigned int i = 0; i < samples; ++i, data += 3)
   {
-    int s = (data[1] << 24) | (data[2] << 16) | (data[3] << 8);
+    int s = (data[0] << 24) | (data[1] << 16) | (data[2] << 8);
     *dest++ = (float)s * INT32_SCALE;
   }
   return samples;
@@ -261,15 +348,15 @@ unsigned int CAEConvert::S32LE_Float(uint8_t *data, const unsigned int samples,
   /* do this in groups of 4 to give the compiler a better chance of optimizing this */
   for (float *end = dest + (samples & ~0x3); dest < end;)
   {
-    *dest++ = (float)Endian_SwapLE32(*src++) * factor;
-    *dest++ = (float)Endian_SwapLE32(*src++) * factor;
-    *dest++ = (float)Endian_SwapLE32(*src++) * factor;
-    *dest++ = (float)Endian_SwapLE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapLE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapLE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapLE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapLE32(*src++) * factor;
   }
 
   /* process any remaining samples */
   for (float *end = dest + (samples & 0x3); dest < end;)
-    *dest++ = (float)Endian_SwapLE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapLE32(*src++) * factor;
 
   return samples;
 }
@@ -320,15 +407,15 @@ unsigned int CAEConvert::S32BE_Float(uint8_t *data, const unsigned int samples,
   /* do this in groups of 4 to give the compiler a better chance of optimizing this */
   for (float *end = dest + (samples & ~0x3); dest < end;)
   {
-    *dest++ = (float)Endian_SwapBE32(*src++) * factor;
-    *dest++ = (float)Endian_SwapBE32(*src++) * factor;
-    *dest++ = (float)Endian_SwapBE32(*src++) * factor;
-    *dest++ = (float)Endian_SwapBE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapBE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapBE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapBE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapBE32(*src++) * factor;
   }
 
   /* process any remaining samples */
   for (float *end = dest + (samples & 0x3); dest < end;)
-    *dest++ = (float)Endian_SwapBE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapBE32(*src++) * factor;
 
   return samples;
 }
@@ -375,141 +462,23 @@ unsigned int CAEConvert::DOUBLE_Float(uint8_t *data, const unsigned int samples,
 {
   double *src = (double*)data;
   for (unsigned int i = 0; i < samples; ++i)
-    *dest++ = CLAMP(*src++ / (float)INT32_MAX);
+    *dest++ = CLAMP(*src++);
 
   return samples;
 }
 
 unsigned int CAEConvert::Float_U8(float *data, const unsigned int samples, uint8_t *dest)
 {
-  #ifdef __SSE__
-  const __m128 mul = _mm_set_ps1((float)INT8_MAX+.5f);
-  const __m128 add = _mm_set_ps1(1.0f);
-  unsigned int count = samples;
-
-  /* work around invalid alignment */
-  while ((((uintptr_t)data & 0xF) || ((uintptr_t)dest & 0xF)) && count > 0)
-  {
-    dest[0] = safeRound((data[0] + 1.0f) * ((float)INT8_MAX+.5f));
-    ++data;
-    ++dest;
-    --count;
-  }
-
-  const uint32_t even = count & ~0x3;
-  for (uint32_t i = 0; i < even; i += 4, data += 4)
-  {
-    __m128 in  = _mm_mul_ps(_mm_add_ps(_mm_load_ps(data), add), mul);
-    __m64  con = _mm_cvtps_pi16(in);
-
-    int16_t temp[4];
-    memcpy(temp, &con, sizeof(temp));
-    *dest++ = (uint8_t)temp[0];
-    *dest++ = (uint8_t)temp[1];
-    *dest++ = (uint8_t)temp[2];
-    *dest++ = (uint8_t)temp[3];
-  }
-
-  if (count != even)
-  {
-    const uint32_t odd = count - even;
-    if (odd == 1)
-    {
-      _mm_empty();
-      dest[0] = safeRound((data[0] + 1.0f) * ((float)INT8_MAX+.5f));
-    }
-    else
-    {
-      __m128 in;
-      if (odd == 2)
-      {
-        in = _mm_setr_ps(data[0], data[1], 0, 0);
-        in = _mm_mul_ps(_mm_add_ps(_mm_load_ps(data), add), mul);
-        __m64 con = _mm_cvtps_pi16(in);
-
-        int16_t temp[2];
-        memcpy(temp, &con, sizeof(temp));
-        dest[0] = (uint8_t)temp[0];
-        dest[1] = (uint8_t)temp[1];
-      }
-      else
-      {
-        in = _mm_setr_ps(data[0], data[1], data[2], 0);
-        in = _mm_mul_ps(_mm_add_ps(_mm_load_ps(data), add), mul);
-        __m64 con = _mm_cvtps_pi16(in);
-
-        int16_t temp[3];
-        memcpy(temp, &con, sizeof(temp));
-        dest[0] = (uint8_t)temp[0];
-        dest[1] = (uint8_t)temp[1];
-        dest[2] = (uint8_t)temp[2];
-      }
-    }
-  }
-  _mm_empty();
-  #else /* no SSE */
   for (uint32_t i = 0; i < samples; ++i)
-    *dest++ = safeRound((*data++ + 1.0f) * ((float)INT8_MAX+.5f));
-  #endif
+    *dest++ = clampInt(safeRound((*data++ + 1.0f) * ((float)INT8_MAX+.5f)), 0, UINT8_MAX);
 
   return samples;
 }
 
 unsigned int CAEConvert::Float_S8(float *data, const unsigned int samples, uint8_t *dest)
 {
-  #ifdef __SSE__
-  const __m128 mul = _mm_set_ps1((float)INT8_MAX+.5f);
-  unsigned int count = samples;
-
-  /* work around invalid alignment */
-  while ((((uintptr_t)data & 0xF) || ((uintptr_t)dest & 0xF)) && count > 0)
-  {
-    dest[0] = safeRound(data[0] * ((float)INT8_MAX+.5f));
-    ++data;
-    ++dest;
-    --count;
-  }
-
-  const uint32_t even = count & ~0x3;
-  for (uint32_t i = 0; i < even; i += 4, data += 4, dest += 4)
-  {
-    __m128 in  = _mm_mul_ps(_mm_load_ps(data), mul);
-    __m64  con = _mm_cvtps_pi8(in);
-    memcpy(dest, &con, 4);
-  }
-
-  if (count != even)
-  {
-    const uint32_t odd = count - even;
-    if (odd == 1)
-    {
-      _mm_empty();
-      dest[0] = safeRound(data[0] * ((float)INT8_MAX+.5f));
-    }
-    else
-    {
-      __m128 in;
-      if (odd == 2)
-      {
-        in = _mm_setr_ps(data[0], data[1], 0, 0);
-        in = _mm_mul_ps(_mm_load_ps(data), mul);
-        __m64 con = _mm_cvtps_pi8(in);
-        memcpy(dest, &con, 2);
-      }
-      else
-      {
-        in = _mm_setr_ps(data[0], data[1], data[2], 0);
-        in = _mm_mul_ps(_mm_load_ps(data), mul);
-        __m64 con = _mm_cvtps_pi8(in);
-        memcpy(dest, &con, 3);
-      }
-    }
-  }
-  _mm_empty();
-  #else /* no SSE */
   for (uint32_t i = 0; i < samples; ++i)
-    *dest++ = safeRound(*data++ * ((float)INT8_MAX+.5f));
-  #endif
+    *dest++ = clampInt(safeRound(*data++ * ((float)INT8_MAX+.5f)), INT8_MIN, INT8_MAX);
 
   return samples;
 }
@@ -517,114 +486,6 @@ unsigned int CAEConvert::Float_S8(float *data, const unsigned int samples, uint8
 unsigned int CAEConvert::Float_S16LE(float *data, const unsigned int samples, uint8_t *dest)
 {
   int16_t *dst = (int16_t*)dest;
-  #ifdef __SSE__
-
-  unsigned int count     = samples;
-  unsigned int unaligned = (0x10 - ((uintptr_t)data & 0xF)) >> 2;
-  if (unaligned == 4)
-    unaligned = 0;
-
-  /*
-    if we are only out by one, dont use SSE to correct it.
-    this must run before we do any SSE work so that the FPU
-    is in a working state without having to first call
-    _mm_empty()
-  */
-  if (unaligned == 1)
-    dst[0] = Endian_SwapLE16(safeRound(data[0] * ((float)INT16_MAX + CAEUtil::FloatRand1(-0.5f, 0.5f))));
-
-  MEMALIGN(16, static const __m128  mul) = _mm_set_ps1((float)INT16_MAX);
-  MEMALIGN(16, __m128  rand);
-  MEMALIGN(16, __m128  in  );
-  MEMALIGN(16, __m128i con );
-
-  /* if unaligned is greater then one, use SSE to correct it */
-  if (unaligned > 1)
-  {
-    switch (unaligned)
-    {
-      case 1: in = _mm_setr_ps(data[0], 0      , 0      , 0); break;
-      case 2: in = _mm_setr_ps(data[0], data[1], 0      , 0); break;
-      case 3: in = _mm_setr_ps(data[0], data[1], data[2], 0); break;
-    }
-
-    /* random round to dither */
-    CAEUtil::FloatRand4(-0.5f, 0.5f, NULL, &rand);
-    in  = _mm_mul_ps(in, _mm_add_ps(mul, rand));
-    con = _mm_cvtps_epi32(in);
-
-    #ifdef __BIG_ENDIAN__
-    con = _mm_or_si128(_mm_slli_epi16(con, 8), _mm_srli_epi16(con, 8));
-    #endif
-
-    dst[0] = _mm_extract_epi16(con, 0);
-    if (unaligned == 3)
-    {
-      dst[1] = _mm_extract_epi16(con, 2);
-      dst[2] = _mm_extract_epi16(con, 4);
-    }
-    else if (unaligned == 2)
-      dst[1] = _mm_extract_epi16(con, 2);
-  }
-
-  /* update our pointers and sample count */
-  data  += unaligned;
-  dst   += unaligned;
-  count -= unaligned;
-
-  const uint32_t even = count & ~0x3;
-  for (uint32_t i = 0; i < even; i += 4, data += 4, dst += 4)
-  {
-    /* random round to dither */
-    CAEUtil::FloatRand4(-0.5f, 0.5f, NULL, &rand);
-    in   = _mm_mul_ps(_mm_load_ps(data), _mm_add_ps(mul, rand));
-    con  = _mm_cvtps_epi32(in);
-
-    #ifdef __BIG_ENDIAN__
-    con = _mm_or_si128(_mm_slli_epi16(con, 8), _mm_srli_epi16(con, 8));
-    #endif
-
-    dst[0] = _mm_extract_epi16(con, 0);
-    dst[1] = _mm_extract_epi16(con, 2);
-    dst[2] = _mm_extract_epi16(con, 4);
-    dst[3] = _mm_extract_epi16(con, 6);
-  }
-
-  /* calculate the final unaligned samples if there is any */
-  if (samples != even)
-  {
-    unaligned = samples - even;
-    switch (unaligned)
-    {
-      case 1: in = _mm_setr_ps(data[0], 0      , 0      , 0); break;
-      case 2: in = _mm_setr_ps(data[0], data[1], 0      , 0); break;
-      case 3: in = _mm_setr_ps(data[0], data[1], data[2], 0); break;
-    }
-
-    /* random round to dither */
-    CAEUtil::FloatRand4(-0.5f, 0.5f, NULL, &rand);
-    in  = _mm_mul_ps(in, _mm_add_ps(mul, rand));
-    con = _mm_cvtps_epi32(in);
-
-    #ifdef __BIG_ENDIAN__
-    con = _mm_or_si128(_mm_slli_epi16(con, 8), _mm_srli_epi16(con, 8));
-    #endif
-
-    dst[0] = _mm_extract_epi16(con, 0);
-    if (unaligned == 3)
-    {
-      dst[1] = _mm_extract_epi16(con, 2);
-      dst[2] = _mm_extract_epi16(con, 4);
-    }
-    else if (unaligned == 2)
-      dst[1] = _mm_extract_epi16(con, 2);
-  }
-
-  /* cleanup */
-  _mm_empty();
-
-  #else /* no SSE */
-
   uint32_t i    = 0;
   uint32_t even = samples & ~0x3;
 
@@ -634,16 +495,14 @@ unsigned int CAEConvert::Float_S16LE(float *data, const unsigned int samples, ui
     float rand[4];
     CAEUtil::FloatRand4(-0.5f, 0.5f, rand);
 
-    *dst++ = Endian_SwapLE16(safeRound(*data++ * ((float)INT16_MAX + rand[0])));
-    *dst++ = Endian_SwapLE16(safeRound(*data++ * ((float)INT16_MAX + rand[1])));
-    *dst++ = Endian_SwapLE16(safeRound(*data++ * ((float)INT16_MAX + rand[2])));
-    *dst++ = Endian_SwapLE16(safeRound(*data++ * ((float)INT16_MAX + rand[3])));
+    *dst++ = Endian_SwapLE16(clampInt(safeRound(*data++ * ((float)INT16_MAX + rand[0])), INT16_MIN, INT16_MAX));
+    *dst++ = Endian_SwapLE16(clampInt(safeRound(*data++ * ((float)INT16_MAX + rand[1])), INT16_MIN, INT16_MAX));
+    *dst++ = Endian_SwapLE16(clampInt(safeRound(*data++ * ((float)INT16_MAX + rand[2])), INT16_MIN, INT16_MAX));
+    *dst++ = Endian_SwapLE16(clampInt(safeRound(*data++ * ((float)INT16_MAX + rand[3])), INT16_MIN, INT16_MAX));
   }
 
   for(; i < samples; ++i)
-    *dst++ = Endian_SwapLE16(safeRound(*data++ * ((float)INT16_MAX + CAEUtil::FloatRand1(-0.5f, 0.5f))));
-
-  #endif
+    *dst++ = Endian_SwapLE16(clampInt(safeRound(*data++ * ((float)INT16_MAX + CAEUtil::FloatRand1(-0.5f, 0.5f))), INT16_MIN, INT16_MAX));
 
   return samples << 1;
 }
@@ -651,114 +510,6 @@ unsigned int CAEConvert::Float_S16LE(float *data, const unsigned int samples, ui
 unsigned int CAEConvert::Float_S16BE(float *data, const unsigned int samples, uint8_t *dest)
 {
   int16_t *dst = (int16_t*)dest;
-  #ifdef __SSE__
-
-  unsigned int count     = samples;
-  unsigned int unaligned = (0x10 - ((uintptr_t)data & 0xF)) >> 2;
-  if (unaligned == 4)
-    unaligned = 0;
-
-  /*
-    if we are only out by one, dont use SSE to correct it.
-    this must run before we do any SSE work so that the FPU
-    is in a working state without having to first call
-    _mm_empty()
-  */
-  if (unaligned == 1)
-     dst[0] = Endian_SwapBE16(safeRound(data[0] * ((float)INT16_MAX + CAEUtil::FloatRand1(-0.5f, 0.5f))));
-
-  MEMALIGN(16, static const __m128  mul) = _mm_set_ps1((float)INT16_MAX);
-  MEMALIGN(16, __m128  rand);
-  MEMALIGN(16, __m128  in  ) = _mm_setr_ps(0, 0, 0, 0);
-  MEMALIGN(16, __m128i con );
-
-  /* if unaligned is greater then one, use SSE to correct it */
-  if (unaligned > 1)
-  {
-    switch (unaligned)
-    {
-      case 1: in = _mm_setr_ps(data[0], 0      , 0      , 0); break;
-      case 2: in = _mm_setr_ps(data[0], data[1], 0      , 0); break;
-      case 3: in = _mm_setr_ps(data[0], data[1], data[2], 0); break;
-    }
-
-    /* random round to dither */
-    CAEUtil::FloatRand4(-0.5f, 0.5f, NULL, &rand);
-    in  = _mm_mul_ps(in, _mm_add_ps(mul, rand));
-    con = _mm_cvtps_epi32(in);
-
-    #ifndef __BIG_ENDIAN__
-    con = _mm_or_si128(_mm_slli_epi16(con, 8), _mm_srli_epi16(con, 8));
-    #endif
-
-    dst[0] = _mm_extract_epi16(con, 0);
-    if (unaligned == 3)
-    {
-      dst[1] = _mm_extract_epi16(con, 2);
-      dst[2] = _mm_extract_epi16(con, 4);
-    }
-    else if (unaligned == 2)
-      dst[1] = _mm_extract_epi16(con, 2);
-  }
-
-  /* update our pointers and sample count */
-  data  += unaligned;
-  dst   += unaligned;
-  count -= unaligned;
-
-  const uint32_t even = count & ~0x3;
-  for (uint32_t i = 0; i < even; i += 4, data += 4, dst += 4)
-  {
-    /* random round to dither */
-    CAEUtil::FloatRand4(-0.5f, 0.5f, NULL, &rand);
-    in   = _mm_mul_ps(_mm_load_ps(data), _mm_add_ps(mul, rand));
-    con  = _mm_cvtps_epi32(in);
-
-    #ifndef __BIG_ENDIAN__
-    con = _mm_or_si128(_mm_slli_epi16(con, 8), _mm_srli_epi16(con, 8));
-    #endif
-
-    dst[0] = _mm_extract_epi16(con, 0);
-    dst[1] = _mm_extract_epi16(con, 2);
-    dst[2] = _mm_extract_epi16(con, 4);
-    dst[3] = _mm_extract_epi16(con, 6);
-  }
-
-  /* calculate the final unaligned samples if there is any */
-  if (samples != even)
-  {
-    unaligned = samples - even;
-    switch (unaligned)
-    {
-      case 1: in = _mm_setr_ps(data[0], 0      , 0      , 0); break;
-      case 2: in = _mm_setr_ps(data[0], data[1], 0      , 0); break;
-      case 3: in = _mm_setr_ps(data[0], data[1], data[2], 0); break;
-    }
-
-    /* random round to dither */
-    CAEUtil::FloatRand4(-0.5f, 0.5f, NULL, &rand);
-    in  = _mm_mul_ps(in, _mm_add_ps(mul, rand));
-    con = _mm_cvtps_epi32(in);
-
-    #ifndef __BIG_ENDIAN__
-    con = _mm_or_si128(_mm_slli_epi16(con, 8), _mm_srli_epi16(con, 8));
-    #endif
-
-    dst[0] = _mm_extract_epi16(con, 0);
-    if (unaligned == 3)
-    {
-      dst[1] = _mm_extract_epi16(con, 2);
-      dst[2] = _mm_extract_epi16(con, 4);
-    }
-    else if (unaligned == 2)
-      dst[1] = _mm_extract_epi16(con, 2);
-  }
-
-  /* cleanup */
-  _mm_empty();
-
-  #else /* no SSE */
-
   uint32_t i    = 0;
   uint32_t even = samples & ~0x3;
 
@@ -768,16 +519,14 @@ unsigned int CAEConvert::Float_S16BE(float *data, const unsigned int samples, ui
     float rand[4];
     CAEUtil::FloatRand4(-0.5f, 0.5f, rand);
 
-    *dst++ = Endian_SwapBE16(safeRound(*data++ * ((float)INT16_MAX + rand[0])));
-    *dst++ = Endian_SwapBE16(safeRound(*data++ * ((float)INT16_MAX + rand[1])));
-    *dst++ = Endian_SwapBE16(safeRound(*data++ * ((float)INT16_MAX + rand[2])));
-    *dst++ = Endian_SwapBE16(safeRound(*data++ * ((float)INT16_MAX + rand[3])));
+    *dst++ = Endian_SwapBE16(clampInt(safeRound(*data++ * ((float)INT16_MAX + rand[0])), INT16_MIN, INT16_MAX));
+    *dst++ = Endian_SwapBE16(clampInt(safeRound(*data++ * ((float)INT16_MAX + rand[1])), INT16_MIN, INT16_MAX));
+    *dst++ = Endian_SwapBE16(clampInt(safeRound(*data++ * ((float)INT16_MAX + rand[2])), INT16_MIN, INT16_MAX));
+    *dst++ = Endian_SwapBE16(clampInt(safeRound(*data++ * ((float)INT16_MAX + rand[3])), INT16_MIN, INT16_MAX));
   }
 
-  for(; i < samples; ++i, data++, dst++)
-    *dst++ = Endian_SwapBE16(safeRound(*data++ * ((float)INT16_MAX + CAEUtil::FloatRand1(-0.5f, 0.5f))));
-
-  #endif
+  for(; i < samples; ++i)
+    *dst++ = Endian_SwapBE16(clampInt(safeRound(*data++ * ((float)INT16_MAX + CAEUtil::FloatRand1(-0.5f, 0.5f))), INT16_MIN, INT16_MAX));
 
   return samples << 1;
 }
@@ -785,60 +534,8 @@ unsigned int CAEConvert::Float_S16BE(float *data, const unsigned int samples, ui
 unsigned int CAEConvert::Float_S24NE4(float *data, const unsigned int samples, uint8_t *dest)
 {
   int32_t *dst = (int32_t*)dest;
-  #ifdef __SSE__
-
-  const __m128 mul = _mm_set_ps1((float)INT24_MAX+.5f);
-  unsigned int count = samples;
-
-  /* work around invalid alignment */
-  while ((((uintptr_t)data & 0xF) || ((uintptr_t)dest & 0xF)) && count > 0)
-  {
-    dst[0] = safeRound(data[0] * ((float)INT24_MAX+.5f));
-    ++data;
-    ++dst;
-    --count;
-  }
-
-  const uint32_t even = count & ~0x3;
-  for (uint32_t i = 0; i < even; i += 4, data += 4, dst += 4)
-  {
-    __m128  in  = _mm_mul_ps(_mm_load_ps(data), mul);
-    __m128i con = _mm_cvtps_epi32(in);
-    con         = _mm_slli_epi32(con, 8);
-    memcpy(dst, &con, sizeof(int32_t) * 4);
-  }
-
-  if (samples != even)
-  {
-    const uint32_t odd = samples - even;
-    if (odd == 1)
-      dst[0] = safeRound(data[0] * ((float)INT24_MAX+.5f));
-    else
-    {
-      __m128 in;
-      if (odd == 2)
-      {
-        in = _mm_setr_ps(data[0], data[1], 0, 0);
-        in = _mm_mul_ps(in, mul);
-        __m64 con = _mm_cvtps_pi32(in);
-        con       = _mm_slli_pi32(con, 8);
-        memcpy(dst, &con, sizeof(int32_t) * 2);
-      }
-      else
-      {
-        in = _mm_setr_ps(data[0], data[1], data[2], 0);
-        in = _mm_mul_ps(in, mul);
-        __m128i con = _mm_cvtps_epi32(in);
-        con         = _mm_slli_epi32(con, 8);
-        memcpy(dst, &con, sizeof(int32_t) * 3);
-      }
-    }
-  }
-  _mm_empty();
-  #else /* no SSE */
   for (uint32_t i = 0; i < samples; ++i)
-    *dst++ = (safeRound(*data++ * ((float)INT24_MAX+.5f)) & 0xFFFFFF) << 8;
-  #endif
+    *dst++ = (clampInt(safeRound(*data++ * ((float)INT24_MAX+.5f)), INT24_MIN, INT24_MAX) & 0xFFFFFF) << 8;
 
   return samples << 2;
 }
@@ -854,70 +551,12 @@ unsigned int CAEConvert::Float_S24NE3(float *data, const unsigned int samples, u
     0;
 #endif
 
-  /* disabled as it does not currently work */
-  #if 0 && defined(__SSE__)
-  int32_t *dst = (int32_t*)dest;
-
-  const __m128 mul = _mm_set_ps1((float)INT24_MAX+.5f);
-  unsigned int count = samples;
-
-  /* work around invalid alignment */
-  while ((((uintptr_t)data & 0xF) || ((uintptr_t)dest & 0xF)) && count > 0)
-  {
-    *((uint32_t*)(dest)) = (safeRound(*data * ((float)INT24_MAX+.5f)) & 0xFFFFFF) << leftShift;
-    ++dest;
-    --count;
-  }
-
-  const uint32_t even = count & ~0x3;
-  for (uint32_t i = 0; i < count; i += 4, data += 4, dest += 12)
-  {
-    __m128  in  = _mm_mul_ps(_mm_load_ps(data), mul);
-    __m128i con = _mm_cvtps_epi32(in);
-    con         = _mm_slli_epi32(con, 8);
-    memcpy(dst, &con, sizeof(int32_t) * 4);
-    *((uint32_t*)(dest + 0)) = (dst[0] & 0xFFFFFF) << leftShift;
-    *((uint32_t*)(dest + 3)) = (dst[1] & 0xFFFFFF) << leftShift;
-    *((uint32_t*)(dest + 6)) = (dst[2] & 0xFFFFFF) << leftShift;
-    *((uint32_t*)(dest + 9)) = (dst[3] & 0xFFFFFF) << leftShift;
-  }
-
-  if (samples != even)
+  /* only copy the 3 bytes of the sample so that we never write past the end of the buffer */
+  for (uint32_t i = 0; i < samples; ++i, ++data, dest += 3)
   {
-    const uint32_t odd = samples - even;
-    if (odd == 1)
-      dst[0] = safeRound(data[0] * ((float)INT24_MAX+.5f)) & 0xFFFFFF;
-    else
-    {
-      __m128 in;
-      if (odd == 2)
-      {
-        in = _mm_setr_ps(data[0], data[1], 0, 0);
-        in = _mm_mul_ps(in, mul);
-        __m64 con = _mm_cvtps_pi32(in);
-        con       = _mm_slli_pi32(con, 8);
-        memcpy(dst, &con, sizeof(int32_t) * 2);
-        *((uint32_t*)(dest + 0)) = (dst[0] & 0xFFFFFF) << leftShift;
-        *((uint32_t*)(dest + 3)) = (dst[1] & 0xFFFFFF) << leftShift;
-      }
-      else
-      {
-        in = _mm_setr_ps(data[0], data[1], data[2], 0);
-        in = _mm_mul_ps(in, mul);
-        __m128i con = _mm_cvtps_epi32(in);
-        con         = _mm_slli_epi32(con, 8);
-        memcpy(dst, &con, sizeof(int32_t) * 3);
-        *((uint32_t*)(dest + 0)) = (dst[0] & 0xFFFFFF) << leftShift;
-        *((uint32_t*)(dest + 3)) = (dst[1] & 0xFFFFFF) << leftShift;
-        *((uint32_t*)(dest + 6)) = (dst[2] & 0xFFFFFF) << leftShift;
-      }
-    }
+    uint32_t s = (clampInt(safeRound(*data * ((float)INT24_MAX+.5f)), INT24_MIN, INT24_MAX) & 0xFFFFFF) << leftShift;
+    memcpy(dest, &s, 3);
   }
-  _mm_empty();
-  #else /* no SSE */
-  for (uint32_t i = 0; i < samples; ++i, ++data, dest += 3)
-    *((uint32_t*)(dest)) = (safeRound(*data * ((float)INT24_MAX+.5f)) & 0xFFFFFF) << leftShift;
-  #endif
 
   return samples * 3;
 }
@@ -925,77 +564,15 @@ unsigned int CAEConvert::Float_S24NE3(float *data, const unsigned int samples, u
 unsigned int CAEConvert::Float_S32LE(float *data, const unsigned int samples, uint8_t *dest)
 {
   int32_t *dst = (int32_t*)dest;
-  #ifdef __SSE__
-  const __m128 mul = _mm_set_ps1((float)INT32_MAX);
-  unsigned int count = samples;
-
-  /* work around invalid alignment */
-  while ((((uintptr_t)data & 0xF) || ((uintptr_t)dest & 0xF)) && count > 0)
-  {
-    dst[0] = safeRound(data[0] * (float)INT32_MAX);
-    ++data;
-    ++dst;
-    --count;
-  }
-
-  const uint32_t even = count & ~0x3;
-  for (uint32_t i = 0; i < even; i += 4, data += 4, dst += 4)
-  {
-    __m128  in  = _mm_mul_ps(_mm_load_ps(data), mul);
-    __m128i con = _mm_cvtps_epi32(in);
-    memcpy(dst, &con, sizeof(int32_t) * 4);
-    dst[0] = Endian_SwapLE32(dst[0]);
-    dst[1] = Endian_SwapLE32(dst[1]);
-    dst[2] = Endian_SwapLE32(dst[2]);
-    dst[3] = Endian_SwapLE32(dst[3]);
-  }
-
-  if (samples != even)
-  {
-    const uint32_t odd = samples - even;
-    if (odd == 1)
-    {
-      dst[0] = safeRound(data[0] * (float)INT32_MAX);
-      dst[0] = Endian_SwapLE32(dst[0]);
-    }
-    else
-    {
-      __m128 in;
-      if (odd == 2)
-      {
-        in = _mm_setr_ps(data[0], data[1], 0, 0);
-        in = _mm_mul_ps(in, mul);
-        __m64 con = _mm_cvtps_pi32(in);
-        memcpy(dst, &con, sizeof(int32_t) * 2);
-        dst[0] = Endian_SwapLE32(dst[0]);
-        dst[1] = Endian_SwapLE32(dst[1]);
-      }
-      else
-      {
-        in = _mm_setr_ps(data[0], data[1], data[2], 0);
-        in = _mm_mul_ps(in, mul);
-        __m128i con = _mm_cvtps_epi32(in);
-        memcpy(dst, &con, sizeof(int32_t) * 3);
-        dst[0] = Endian_SwapLE32(dst[0]);
-        dst[1] = Endian_SwapLE32(dst[1]);
-        dst[2] = Endian_SwapLE32(dst[2]);
-      }
-    }
-  }
-  _mm_empty();
-  #else
-
-  /* no SIMD */
   for (uint32_t i = 0; i < samples; ++i, ++data, ++dst)
   {
     dst[0] = safeRound(data[0] * (float)INT32_MAX);
     dst[0] = Endian_SwapLE32(dst[0]);
   }
-  #endif
+
   return samples << 2;
 }
 
-
 unsigned int CAEConvert::Float_S32LE_Neon(float *data, const unsigned int samples, uint8_t *dest)
 {
 #if defined(__ARM_NEON__)
@@ -1034,72 +611,11 @@ unsigned int CAEConvert::Float_S32LE_Neon(float *data, const unsigned int sample
 unsigned int CAEConvert::Float_S32BE(float *data, const unsigned int samples, uint8_t *dest)
 {
   int32_t *dst = (int32_t*)dest;
-  #ifdef __SSE__
-  const __m128 mul = _mm_set_ps1((float)INT32_MAX);
-  unsigned int count = samples;
-
-  /* work around invalid alignment */
-  while ((((uintptr_t)data & 0xF) || ((uintptr_t)dest & 0xF)) && count > 0)
-  {
-    dst[0] = safeRound(data[0] * (float)INT32_MAX);
-    ++data;
-    ++dst;
-    --count;
-  }
-
-  const uint32_t even = count & ~0x3;
-  for (uint32_t i = 0; i < even; i += 4, data += 4, dst += 4)
-  {
-    __m128  in  = _mm_mul_ps(_mm_load_ps(data), mul);
-    __m128i con = _mm_cvtps_epi32(in);
-    memcpy(dst, &con, sizeof(int32_t) * 4);
-    dst[0] = Endian_SwapBE32(dst[0]);
-    dst[1] = Endian_SwapBE32(dst[1]);
-    dst[2] = Endian_SwapBE32(dst[2]);
-    dst[3] = Endian_SwapBE32(dst[3]);
-  }
-
-  if (samples != even)
-  {
-    const uint32_t odd = samples - even;
-    if (odd == 1)
-    {
-      dst[0] = safeRound(data[0] * (float)INT32_MAX);
-      dst[0] = Endian_SwapBE32(dst[0]);
-    }
-    else
-    {
-      __m128 in;
-      if (odd == 2)
-      {
-        in = _mm_setr_ps(data[0], data[1], 0, 0);
-        in = _mm_mul_ps(in, mul);
-        __m64 con = _mm_cvtps_pi32(in);
-        memcpy(dst, &con, sizeof(int32_t) * 2);
-        dst[0] = Endian_SwapBE32(dst[0]);
-        dst[1] = Endian_SwapBE32(dst[1]);
-      }
-      else
-      {
-        in = _mm_setr_ps(data[0], data[1], data[2], 0);
-        in = _mm_mul_ps(in, mul);
-        __m128i con = _mm_cvtps_epi32(in);
-        memcpy(dst, &con, sizeof(int32_t) * 3);
-        dst[0] = Endian_SwapBE32(dst[0]);
-        dst[1] = Endian_SwapBE32(dst[1]);
-        dst[2] = Endian_SwapBE32(dst[2]);
-      }
-    }
-  }
-  _mm_empty();
-  #else
-  /* no SIMD */
   for (uint32_t i = 0; i < samples; ++i, ++data, ++dst)
   {
     dst[0] = safeRound(data[0] * (float)INT32_MAX);
     dst[0] = Endian_SwapBE32(dst[0]);
   }
-  #endif
 
   return samples << 2;
 }
@@ -1148,3 +664,406 @@ unsigned int CAEConvert::Float_DOUBLE(float *data, const unsigned int samples, u
   return samples * sizeof(double);
 }
 
+#ifdef __SSE__
+/*
+  SSE2 conversions, every function converts the bulk of the buffer with
+  unaligned loads and stores and hands the remaining samples to the plain
+  version above. Clamping and dithering are done in the same pass.
+*/
+
+/*
+  xorshift32 on four lanes, it only needs shifts so it runs on plain SSE2.
+  Every call seeds its own generator from the clock and the buffer, so
+  streams converted at the same time neither share nor correlate their dither.
+*/
+static inline __m128i DitherSeedSSE(const void *data)
+{
+  const uint32_t now = (uint32_t)CurrentHostCounter();
+  const uint32_t ptr = (uint32_t)(uintptr_t)data;
+
+  /* xorshift never leaves zero, so keep a bit set in every lane */
+  return _mm_or_si128(
+    _mm_set_epi32(now ^ 0x2545F491, ptr ^ 0x1B873593, (now * 0x9E3779B9) ^ 0x6A09E667, (ptr + now) ^ 0x3C6EF372),
+    _mm_set1_epi32(1)
+  );
+}
+
+/* returns four random values in the range of -0.5 to 0.5 */
+static inline __m128 DitherSSE(__m128i &seed)
+{
+  seed = _mm_xor_si128(seed, _mm_slli_epi32(seed, 13));
+  seed = _mm_xor_si128(seed, _mm_srli_epi32(seed, 17));
+  seed = _mm_xor_si128(seed, _mm_slli_epi32(seed,  5));
+  return _mm_mul_ps(_mm_cvtepi32_ps(seed), _mm_set_ps1(0.5f / 2147483648.0f));
+}
+
+static inline __m128i ByteSwap16SSE(const __m128i v)
+{
+  return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+static inline __m128i ByteSwap32SSE(const __m128i v)
+{
+  __m128i swapped = ByteSwap16SSE(v);
+  swapped = _mm_shufflelo_epi16(swapped, _MM_SHUFFLE(2, 3, 0, 1));
+  return    _mm_shufflehi_epi16(swapped, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+/* load 4 packed 24 bit samples into the upper 3 bytes of each 32 bit lane, reads exactly 12 bytes */
+static inline __m128i Unpack24SSE(const uint8_t *src)
+{
+  __m128i in = _mm_or_si128(
+    _mm_loadl_epi64((const __m128i*)src),
+    _mm_slli_si128(_mm_cvtsi32_si128(*(const int32_t*)(src + 8)), 8)
+  );
+
+  /* samples 0-1 go to the low quadword and samples 2-3 to the high quadword */
+  in = _mm_unpacklo_epi64(in, _mm_srli_si128(in, 6));
+  return _mm_or_si128(
+    _mm_and_si128(_mm_slli_epi64(in,  8), _mm_set_epi32(0, -1, 0, -1)),
+    _mm_and_si128(_mm_slli_epi64(in, 16), _mm_set_epi32((int)0xFFFFFF00, 0, (int)0xFFFFFF00, 0))
+  );
+}
+
+/* store the lower 3 bytes of each 32 bit lane as 4 packed 24 bit samples, writes exactly 12 bytes */
+static inline void Pack24SSE(__m128i v, uint8_t *dst)
+{
+  v = _mm_or_si128(
+    _mm_and_si128(v, _mm_set_epi32(0, 0x00FFFFFF, 0, 0x00FFFFFF)),
+    _mm_and_si128(_mm_srli_epi64(v, 8), _mm_set_epi32(0x0000FFFF, (int)0xFF000000, 0x0000FFFF, (int)0xFF000000))
+  );
+  v = _mm_or_si128(_mm_move_epi64(v), _mm_slli_si128(_mm_srli_si128(v, 8), 6));
+
+  _mm_storel_epi64((__m128i*)dst, v);
+  *((int32_t*)(dst + 8)) = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+}
+
+static inline __m128 ClampSSE(const __m128 v, const __m128 min, const __m128 max)
+{
+  return _mm_min_ps(_mm_max_ps(v, min), max);
+}
+
+unsigned int CAEConvert::U8_Float_SSE(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128  mul  = _mm_set_ps1(2.0f / UINT8_MAX);
+  const __m128  one  = _mm_set_ps1(1.0f);
+  const __m128i zero = _mm_setzero_si128();
+
+  const unsigned int even = samples & ~0xF;
+  for (unsigned int i = 0; i < even; i += 16, data += 16, dest += 16)
+  {
+    __m128i in = _mm_loadu_si128((const __m128i*)data);
+    __m128i lo = _mm_unpacklo_epi8(in, zero);
+    __m128i hi = _mm_unpackhi_epi8(in, zero);
+    _mm_storeu_ps(dest +  0, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), mul), one));
+    _mm_storeu_ps(dest +  4, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), mul), one));
+    _mm_storeu_ps(dest +  8, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), mul), one));
+    _mm_storeu_ps(dest + 12, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), mul), one));
+  }
+
+  U8_Float(data, samples - even, dest);
+  return samples;
+}
+
+unsigned int CAEConvert::S8_Float_SSE(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128 mul = _mm_set_ps1(1.0f / (INT8_MAX + 0.5f));
+
+  const unsigned int even = samples & ~0xF;
+  for (unsigned int i = 0; i < even; i += 16, data += 16, dest += 16)
+  {
+    /* sign extend by moving the byte to the top of the lane and shifting it back down */
+    __m128i in = _mm_loadu_si128((const __m128i*)data);
+    __m128i lo = _mm_unpacklo_epi8(in, in);
+    __m128i hi = _mm_unpackhi_epi8(in, in);
+    _mm_storeu_ps(dest +  0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 24)), mul));
+    _mm_storeu_ps(dest +  4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 24)), mul));
+    _mm_storeu_ps(dest +  8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 24)), mul));
+    _mm_storeu_ps(dest + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 24)), mul));
+  }
+
+  S8_Float(data, samples - even, dest);
+  return samples;
+}
+
+static inline void S16ToFloatSSE(const __m128i in, const __m128 mul, float *dest)
+{
+  _mm_storeu_ps(dest + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(in, in), 16)), mul));
+  _mm_storeu_ps(dest + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(in, in), 16)), mul));
+}
+
+unsigned int CAEConvert::S16LE_Float_SSE(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128 mul = _mm_set_ps1(1.0f / (INT16_MAX + 0.5f));
+
+  const unsigned int even = samples & ~0x7;
+  for (unsigned int i = 0; i < even; i += 8, data += 16, dest += 8)
+    S16ToFloatSSE(_mm_loadu_si128((const __m128i*)data), mul, dest);
+
+  S16LE_Float(data, samples - even, dest);
+  return samples;
+}
+
+unsigned int CAEConvert::S16BE_Float_SSE(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128 mul = _mm_set_ps1(1.0f / (INT16_MAX + 0.5f));
+
+  const unsigned int even = samples & ~0x7;
+  for (unsigned int i = 0; i < even; i += 8, data += 16, dest += 8)
+    S16ToFloatSSE(ByteSwap16SSE(_mm_loadu_si128((const __m128i*)data)), mul, dest);
+
+  S16BE_Float(data, samples - even, dest);
+  return samples;
+}
+
+unsigned int CAEConvert::S24LE4_Float_SSE(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128 mul = _mm_set_ps1(INT32_SCALE);
+
+  const unsigned int even = samples & ~0x3;
+  for (unsigned int i = 0; i < even; i += 4, data += 16, dest += 4)
+  {
+    __m128i in = _mm_slli_epi32(_mm_loadu_si128((const __m128i*)data), 8);
+    _mm_storeu_ps(dest, _mm_mul_ps(_mm_cvtepi32_ps(in), mul));
+  }
+
+  S24LE4_Float(data, samples - even, dest);
+  return samples;
+}
+
+unsigned int CAEConvert::S24BE4_Float_SSE(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128  mul  = _mm_set_ps1(INT32_SCALE);
+  const __m128i mask = _mm_set1_epi32((int)0xFFFFFF00);
+
+  const unsigned int even = samples & ~0x3;
+  for (unsigned int i = 0; i < even; i += 4, data += 16, dest += 4)
+  {
+    __m128i in = _mm_and_si128(ByteSwap32SSE(_mm_loadu_si128((const __m128i*)data)), mask);
+    _mm_storeu_ps(dest, _mm_mul_ps(_mm_cvtepi32_ps(in), mul));
+  }
+
+  S24BE4_Float(data, samples - even, dest);
+  return samples;
+}
+
+unsigned int CAEConvert::S24LE3_Float_SSE(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128 mul = _mm_set_ps1(INT32_SCALE);
+
+  const unsigned int even = samples & ~0x3;
+  for (unsigned int i = 0; i < even; i += 4, data += 12, dest += 4)
+    _mm_storeu_ps(dest, _mm_mul_ps(_mm_cvtepi32_ps(Unpack24SSE(data)), mul));
+
+  S24LE3_Float(data, samples - even, dest);
+  return samples;
+}
+
+unsigned int CAEConvert::S24BE3_Float_SSE(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128 mul = _mm_set_ps1(INT32_SCALE);
+
+  const unsigned int even = samples & ~0x3;
+  for (unsigned int i = 0; i < even; i += 4, data += 12, dest += 4)
+  {
+    /* the swap leaves the sample in the lower 3 bytes */
+    __m128i in = _mm_slli_epi32(ByteSwap32SSE(Unpack24SSE(data)), 8);
+    _mm_storeu_ps(dest, _mm_mul_ps(_mm_cvtepi32_ps(in), mul));
+  }
+
+  S24BE3_Float(data, samples - even, dest);
+  return samples;
+}
+
+unsigned int CAEConvert::S32LE_Float_SSE(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128 mul = _mm_set_ps1(1.0f / (float)INT32_MAX);
+
+  const unsigned int even = samples & ~0x3;
+  for (unsigned int i = 0; i < even; i += 4, data += 16, dest += 4)
+    _mm_storeu_ps(dest, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)data)), mul));
+
+  S32LE_Float(data, samples - even, dest);
+  return samples;
+}
+
+unsigned int CAEConvert::S32BE_Float_SSE(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128 mul = _mm_set_ps1(1.0f / (float)INT32_MAX);
+
+  const unsigned int even = samples & ~0x3;
+  for (unsigned int i = 0; i < even; i += 4, data += 16, dest += 4)
+    _mm_storeu_ps(dest, _mm_mul_ps(_mm_cvtepi32_ps(ByteSwap32SSE(_mm_loadu_si128((const __m128i*)data))), mul));
+
+  S32BE_Float(data, samples - even, dest);
+  return samples;
+}
+
+unsigned int CAEConvert::DOUBLE_Float_SSE(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128 min = _mm_set_ps1(-1.0f);
+  const __m128 max = _mm_set_ps1( 1.0f);
+  double *src = (double*)data;
+
+  const unsigned int even = samples & ~0x3;
+  for (unsigned int i = 0; i < even; i += 4, src += 4, dest += 4)
+  {
+    __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(src + 0));
+    __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(src + 2));
+    _mm_storeu_ps(dest, ClampSSE(_mm_movelh_ps(lo, hi), min, max));
+  }
+
+  DOUBLE_Float((uint8_t*)src, samples - even, dest);
+  return samples;
+}
+
+unsigned int CAEConvert::Float_U8_SSE(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const __m128 mul = _mm_set_ps1((float)INT8_MAX+.5f);
+  const __m128 add = _mm_set_ps1(1.0f);
+
+  /* the saturating packs clamp to 0..255 */
+  const unsigned int even = samples & ~0xF;
+  for (unsigned int i = 0; i < even; i += 16, data += 16, dest += 16)
+  {
+    __m128i a = _mm_cvtps_epi32(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(data +  0), add), mul));
+    __m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(data +  4), add), mul));
+    __m128i c = _mm_cvtps_epi32(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(data +  8), add), mul));
+    __m128i d = _mm_cvtps_epi32(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(data + 12), add), mul));
+    _mm_storeu_si128((__m128i*)dest, _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+  }
+
+  Float_U8(data, samples - even, dest);
+  return samples;
+}
+
+unsigned int CAEConvert::Float_S8_SSE(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const __m128 mul = _mm_set_ps1((float)INT8_MAX+.5f);
+
+  /* the saturating packs clamp to -128..127 */
+  const unsigned int even = samples & ~0xF;
+  for (unsigned int i = 0; i < even; i += 16, data += 16, dest += 16)
+  {
+    __m128i a = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(data +  0), mul));
+    __m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(data +  4), mul));
+    __m128i c = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(data +  8), mul));
+    __m128i d = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(data + 12), mul));
+    _mm_storeu_si128((__m128i*)dest, _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+  }
+
+  Float_S8(data, samples - even, dest);
+  return samples;
+}
+
+/* convert 8 samples to dithered and clamped signed 16 bit */
+static inline __m128i FloatToS16SSE(const float *data, __m128i &seed)
+{
+  const __m128 min = _mm_set_ps1(-1.0f);
+  const __m128 max = _mm_set_ps1( 1.0f);
+  const __m128 mul = _mm_set_ps1((float)INT16_MAX);
+
+  /* random round to dither, the same way as the plain version */
+  __m128 lo = _mm_mul_ps(ClampSSE(_mm_loadu_ps(data + 0), min, max), _mm_add_ps(mul, DitherSSE(seed)));
+  __m128 hi = _mm_mul_ps(ClampSSE(_mm_loadu_ps(data + 4), min, max), _mm_add_ps(mul, DitherSSE(seed)));
+  return _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi));
+}
+
+unsigned int CAEConvert::Float_S16LE_SSE(float *data, const unsigned int samples, uint8_t *dest)
+{
+  __m128i seed = DitherSeedSSE(data);
+
+  const unsigned int even = samples & ~0x7;
+  for (unsigned int i = 0; i < even; i += 8, data += 8, dest += 16)
+    _mm_storeu_si128((__m128i*)dest, FloatToS16SSE(data, seed));
+
+  Float_S16LE(data, samples - even, dest);
+  return samples << 1;
+}
+
+unsigned int CAEConvert::Float_S16BE_SSE(float *data, const unsigned int samples, uint8_t *dest)
+{
+  __m128i seed = DitherSeedSSE(data);
+
+  const unsigned int even = samples & ~0x7;
+  for (unsigned int i = 0; i < even; i += 8, data += 8, dest += 16)
+    _mm_storeu_si128((__m128i*)dest, ByteSwap16SSE(FloatToS16SSE(data, seed)));
+
+  Float_S16BE(data, samples - even, dest);
+  return samples << 1;
+}
+
+/* convert 4 samples to clamped 24 bit values in the lower 3 bytes of each lane */
+static inline __m128i FloatToS24SSE(const float *data)
+{
+  const __m128 min = _mm_set_ps1((float)INT24_MIN);
+  const __m128 max = _mm_set_ps1((float)INT24_MAX);
+  const __m128 mul = _mm_set_ps1((float)INT24_MAX+.5f);
+  return _mm_cvtps_epi32(ClampSSE(_mm_mul_ps(_mm_loadu_ps(data), mul), min, max));
+}
+
+unsigned int CAEConvert::Float_S24NE4_SSE(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const unsigned int even = samples & ~0x3;
+  for (unsigned int i = 0; i < even; i += 4, data += 4, dest += 16)
+    _mm_storeu_si128((__m128i*)dest, _mm_slli_epi32(FloatToS24SSE(data), 8));
+
+  Float_S24NE4(data, samples - even, dest);
+  return samples << 2;
+}
+
+unsigned int CAEConvert::Float_S24NE3_SSE(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const unsigned int even = samples & ~0x3;
+  for (unsigned int i = 0; i < even; i += 4, data += 4, dest += 12)
+    Pack24SSE(FloatToS24SSE(data), dest);
+
+  Float_S24NE3(data, samples - even, dest);
+  return samples * 3;
+}
+
+/* convert 4 samples to clamped signed 32 bit, INT32_MAX is not representable as float */
+static inline __m128i FloatToS32SSE(const float *data)
+{
+  const __m128 min = _mm_set_ps1(-2147483648.0f);
+  const __m128 max = _mm_set_ps1( 2147483520.0f);
+  const __m128 mul = _mm_set_ps1((float)INT32_MAX);
+  return _mm_cvtps_epi32(ClampSSE(_mm_mul_ps(_mm_loadu_ps(data), mul), min, max));
+}
+
+unsigned int CAEConvert::Float_S32LE_SSE(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const unsigned int even = samples & ~0x3;
+  for (unsigned int i = 0; i < even; i += 4, data += 4, dest += 16)
+    _mm_storeu_si128((__m128i*)dest, FloatToS32SSE(data));
+
+  Float_S32LE(data, samples - even, dest);
+  return samples << 2;
+}
+
+unsigned int CAEConvert::Float_S32BE_SSE(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const unsigned int even = samples & ~0x3;
+  for (unsigned int i = 0; i < even; i += 4, data += 4, dest += 16)
+    _mm_storeu_si128((__m128i*)dest, ByteSwap32SSE(FloatToS32SSE(data)));
+
+  Float_S32BE(data, samples - even, dest);
+  return samples << 2;
+}
+
+unsigned int CAEConvert::Float_DOUBLE_SSE(float *data, const unsigned int samples, uint8_t *dest)
+{
+  double *dst = (double*)dest;
+
+  const unsigned int even = samples & ~0x3;
+  for (unsigned int i = 0; i < even; i += 4, data += 4, dst += 4)
+  {
+    __m128 in = _mm_loadu_ps(data);
+    _mm_storeu_pd(dst + 0, _mm_cvtps_pd(in));
+    _mm_storeu_pd(dst + 2, _mm_cvtps_pd(_mm_movehl_ps(in, in)));
+  }
+
+  Float_DOUBLE(data, samples - even, (uint8_t*)dst);
+  return samples * sizeof(double);
+}
+#endif
@@ -51,10 +51,43 @@ private:
   static unsigned int Float_S32LE_Neon (float   *data, const unsigned int samples, uint8_t *dest);
   static unsigned int Float_S32BE_Neon (float   *data, const unsigned int samples, uint8_t *dest);
 
+#ifdef __SSE__
+  static unsigned int U8_Float_SSE    (uint8_t *data, const unsigned int samples, float   *dest);
+  static unsigned int S8_Float_SSE    (uint8_t *data, const unsigned int samples, float   *dest);
+  static unsigned int S16LE_Float_SSE (uint8_t *data, const unsigned int samples, float   *dest);
+  static unsigned int S16BE_Float_SSE (uint8_t *data, const unsigned int samples, float   *dest);
+  static unsigned int S24LE4_Float_SSE(uint8_t *data, const unsigned int samples, float   *dest);
+  static unsigned int S24BE4_Float_SSE(uint8_t *data, const unsigned int samples, float   *dest);
+  static unsigned int S24LE3_Float_SSE(uint8_t *data, const unsigned int samples, float   *dest);
+  static unsigned int S24BE3_Float_SSE(uint8_t *data, const unsigned int samples, float   *dest);
+  static unsigned int S32LE_Float_SSE (uint8_t *data, const unsigned int samples, float   *dest);
+  static unsigned int S32BE_Float_SSE (uint8_t *data, const unsigned int samples, float   *dest);
+  static unsigned int DOUBLE_Float_SSE(uint8_t *data, const unsigned int samples, float   *dest);
+
+  static unsigned int Float_U8_SSE    (float   *data, const unsigned int samples, uint8_t *dest);
+  static unsigned int Float_S8_SSE    (float   *data, const unsigned int samples, uint8_t *dest);
+  static unsigned int Float_S16LE_SSE (float   *data, const unsigned int samples, uint8_t *dest);
+  static unsigned int Float_S16BE_SSE (float   *data, const unsigned int samples, uint8_t *dest);
+  static unsigned int Float_S24NE4_SSE(float   *data, const unsigned int samples, uint8_t *dest);
+  static unsigned int Float_S24NE3_SSE(float   *data, const unsigned int samples, uint8_t *dest);
+  static unsigned int Float_S32LE_SSE (float   *data, const unsigned int samples, uint8_t *dest);
+  static unsigned int Float_S32BE_SSE (float   *data, const unsigned int samples, uint8_t *dest);
+  static unsigned int Float_DOUBLE_SSE(float   *data, const unsigned int samples, uint8_t *dest);
+#endif
+
 public:
   typedef unsigned int (*AEConvertToFn)(uint8_t *data, const unsigned int samples, float   *dest);
   typedef unsigned int (*AEConvertFrFn)(float   *data, const unsigned int samples, uint8_t *dest);
 
+private:
+#ifdef __SSE__
+  /* SSE2 versions of the conversions, NULL if there is none for the format */
+  static AEConvertToFn ToFloatSSE(enum AEDataFormat dataFormat);
+  static AEConvertFrFn FrFloatSSE(enum AEDataFormat dataFormat);
+#endif
+
+public:
+
   static AEConvertToFn ToFloat(enum AEDataFormat dataFormat);
   static AEConvertFrFn FrFloat(enum AEDataFormat dataFormat);
 };
@@ -24,13 +24,20 @@
 #include "AEFactory.h"
 #include "AEUtil.h"
 #include "utils/log.h"
+#include "utils/CPUInfo.h"
 #include "settings/GUISettings.h"
 
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
 using namespace std;
 
-CAERemap::CAERemap() : m_inChannels(0), m_outChannels(0) 
+CAERemap::CAERemap() : m_inChannels(0), m_outChannels(0), m_identity(false), m_remapFn(&CAERemap::RemapScalar)
 {
   memset(m_mixInfo, 0, sizeof(m_mixInfo));
+  memset(m_matrix , 0, sizeof(m_matrix ));
+  memset(m_rows   , 0, sizeof(m_rows   ));
 }
 
 CAERemap::~CAERemap()
@@ -87,7 +94,10 @@ bool CAERemap::Initialize(CAEChannelInfo input, CAEChannelInfo output, bool fina
 
   /* the final stage does not need any down/upmix */
   if (finalStage)
+  {
+    BuildMatrix();
     return true;
+  }
 
   /* downmix from the specified channel to the specified list of channels */
   #define RM(from, ...) \
@@ -239,6 +249,7 @@ bool CAERemap::Initialize(CAEChannelInfo input, CAEChannelInfo output, bool fina
   CLog::Log(LOGINFO, "====================\n");
 #endif
 
+  BuildMatrix();
   return true;
 }
 
@@ -279,92 +290,184 @@ void CAERemap::ResolveMix(const AEChannel from, CAEChannelInfo to)
   fromInfo->in_src   = false;
 }
 
-/* This method has unrolled loop for higher performance */
-void CAERemap::Remap(float * const in, float * const out, const unsigned int frames) const
+void CAERemap::BuildMatrix()
 {
-  const unsigned int frameBlocks = frames & ~0x3;
-
+  memset(m_matrix, 0, sizeof(m_matrix));
   for (int o = 0; o < m_outChannels; ++o)
   {
     const AEMixInfo *info = &m_mixInfo[m_output[o]];
     if (!info->in_dst)
-    {
-      unsigned int f = 0;
-      unsigned int odx = 0;
-      for(; f < frameBlocks; f += 4)
-      {
-        out[odx + o] = 0.0f, odx += m_outChannels;
-        out[odx + o] = 0.0f, odx += m_outChannels;
-        out[odx + o] = 0.0f, odx += m_outChannels;
-        out[odx + o] = 0.0f, odx += m_outChannels;
-      }
-
-      switch (frames & 0x3)
-      {
-        case 3: out[odx + o] = 0.0f, odx += m_outChannels;
-        case 2: out[odx + o] = 0.0f, odx += m_outChannels;
-        case 1: out[odx + o] = 0.0f;
-      }
       continue;
-    }
 
     /* if there is only 1 source, just copy it so we dont break DPL */
     if (info->srcCount == 1)
     {
-      unsigned int f = 0;
-      unsigned int idx = 0;
-      unsigned int odx = 0;
-      unsigned int srcIndex = info->srcIndex[0].index;
-      /* the compiler has a better chance of optimizing this if it is done in parallel */
-      for (; f < frameBlocks; f += 4)
-      {
-        out[odx + o] = in[idx + srcIndex], idx += m_inChannels, odx += m_outChannels;
-        out[odx + o] = in[idx + srcIndex], idx += m_inChannels, odx += m_outChannels;
-        out[odx + o] = in[idx + srcIndex], idx += m_inChannels, odx += m_outChannels;
-        out[odx + o] = in[idx + srcIndex], idx += m_inChannels, odx += m_outChannels;
-      }
+      m_matrix[info->srcIndex[0].index][o] = 1.0f;
+      continue;
+    }
 
-      switch (frames & 0x3)
+    for (int i = 0; i < info->srcCount; ++i)
+      m_matrix[info->srcIndex[i].index][o] += info->srcIndex[i].level;
+  }
+
+  /*
+    the sparse rows keep the same input order as the dense matrix, skipping
+    a zero level does not change the sum, so all kernels are bit exact
+  */
+  for (int o = 0; o < m_outChannels; ++o)
+  {
+    AEMixRow *row = &m_rows[o];
+    row->count = 0;
+    for (int i = 0; i < m_inChannels; ++i)
+      if (m_matrix[i][o] != 0.0f)
       {
-        case 3: out[odx + o] = in[idx + srcIndex], idx += m_inChannels, odx += m_outChannels;
-        case 2: out[odx + o] = in[idx + srcIndex], idx += m_inChannels, odx += m_outChannels;
-        case 1: out[odx + o] = in[idx + srcIndex];
+        row->index[row->count] = i;
+        row->level[row->count] = m_matrix[i][o];
+        ++row->count;
       }
+  }
+
+  /* a plain reorder of the channels does not need any maths */
+  bool copy = true;
+  m_identity = m_inChannels == m_outChannels;
+  for (int o = 0; o < m_outChannels && copy; ++o)
+  {
+    copy = m_rows[o].count == 0 || (m_rows[o].count == 1 && m_rows[o].level[0] == 1.0f);
+    m_identity = m_identity && copy && m_rows[o].count == 1 && m_rows[o].index[0] == o;
+  }
+
+  m_remapFn = copy ? &CAERemap::RemapCopy : &CAERemap::RemapScalar;
+  if (m_identity)
+    return;
+
+#ifdef __SSE__
+  if (!(g_cpuInfo.GetCPUFeatures() & CPU_FEATURE_SSE))
+    return;
+
+  /* specialised kernels for the common layouts */
+  #define RK(in, out) \
+    if (m_inChannels == in && m_outChannels == out) \
+    { \
+      m_remapFn = &CAERemap::RemapSSE<in, out>; \
+      return; \
     }
-    else
-    {
-      for (unsigned int f = 0; f < frames; ++f)
-      {
-        float *outOffset = out + (f * m_outChannels) + o;
-        float *inOffset  = in  + (f * m_inChannels);
-        *outOffset = 0.0f;
 
-        int blocks = info->srcCount & ~0x3;
+  RK(2, 2); RK(6, 2); RK(8, 2);
+  RK(2, 6); RK(6, 6); RK(8, 6);
+  RK(2, 8); RK(6, 8); RK(8, 8);
+  #undef RK
 
-        /* the compiler has a better chance of optimizing this if it is done in parallel */
-        int i = 0;
-        float f1 = 0.0, f2 = 0.0, f3 = 0.0, f4 = 0.0;
-        for (; i < blocks; i += 4)
-        {
-          f1 += inOffset[info->srcIndex[i].index] * info->srcIndex[i].level;
-          f2 += inOffset[info->srcIndex[i+1].index] * info->srcIndex[i+1].level;
-          f3 += inOffset[info->srcIndex[i+2].index] * info->srcIndex[i+2].level;
-          f4 += inOffset[info->srcIndex[i+3].index] * info->srcIndex[i+3].level;
-        }
+  /* any other input layout, the output is kept in registers up to 8 channels */
+  switch (m_outChannels)
+  {
+    case 1: m_remapFn = &CAERemap::RemapSSE<0, 1>; break;
+    case 2: m_remapFn = &CAERemap::RemapSSE<0, 2>; break;
+    case 3: m_remapFn = &CAERemap::RemapSSE<0, 3>; break;
+    case 4: m_remapFn = &CAERemap::RemapSSE<0, 4>; break;
+    case 5: m_remapFn = &CAERemap::RemapSSE<0, 5>; break;
+    case 6: m_remapFn = &CAERemap::RemapSSE<0, 6>; break;
+    case 7: m_remapFn = &CAERemap::RemapSSE<0, 7>; break;
+    case 8: m_remapFn = &CAERemap::RemapSSE<0, 8>; break;
+  }
+#endif
+}
 
-        /* unrolled loop for higher performance */
-        switch (info->srcCount & 0x3)
-        {
-          case 3: f3 += inOffset[info->srcIndex[i+2].index] * info->srcIndex[i+2].level;
-          case 2: f2 += inOffset[info->srcIndex[i+1].index] * info->srcIndex[i+1].level;
-          case 1: f1 += inOffset[info->srcIndex[i].index] * info->srcIndex[i].level;
-        }
+void CAERemap::Remap(float * const in, float * const out, const unsigned int frames) const
+{
+  (this->*m_remapFn)(in, out, frames);
+}
+
+void CAERemap::RemapCopy(const float *in, float *out, const unsigned int frames) const
+{
+  if (m_identity)
+  {
+    memcpy(out, in, frames * m_outChannels * sizeof(float));
+    return;
+  }
 
-        *outOffset += (f1+f2+f3+f4);
+  for (unsigned int f = 0; f < frames; ++f, in += m_inChannels, out += m_outChannels)
+    for (int o = 0; o < m_outChannels; ++o)
+      out[o] = m_rows[o].count ? in[m_rows[o].index[0]] : 0.0f;
+}
+
+void CAERemap::RemapScalar(const float *in, float *out, const unsigned int frames) const
+{
+  for (unsigned int f = 0; f < frames; ++f, in += m_inChannels, out += m_outChannels)
+  {
+    for (int o = 0; o < m_outChannels; ++o)
+    {
+      const AEMixRow *row = &m_rows[o];
+      float sum = 0.0f;
+      for (int i = 0; i < row->count; ++i)
+        sum += in[row->index[i]] * row->level[i];
+      out[o] = sum;
+    }
+  }
+}
+
+#ifdef __SSE__
+/* store the first count floats of v */
+static inline void StorePartial(float *out, const __m128 v, const int count)
+{
+  switch (count)
+  {
+    case 4: _mm_storeu_ps(out, v); break;
+    case 3: _mm_storel_pi((__m64*)out, v); _mm_store_ss(out + 2, _mm_movehl_ps(v, v)); break;
+    case 2: _mm_storel_pi((__m64*)out, v); break;
+    case 1: _mm_store_ss(out, v); break;
+  }
+}
+
+/*
+  inChannels of 0 takes the input channel count from m_inChannels. Every input
+  sample is broadcast and multiplied with its row of the dense matrix, so a
+  frame is mixed to all outputs at once without walking the source lists.
+*/
+template <int inChannels, int outChannels>
+void CAERemap::RemapSSE(const float *in, float *out, const unsigned int frames) const
+{
+  const int channels = inChannels ? inChannels : m_inChannels;
+  unsigned int f = 0;
+
+  /* stereo output fills a whole register with two frames */
+  if (outChannels == 2)
+  {
+    for (; f + 1 < frames; f += 2, in += channels * 2, out += 4)
+    {
+      __m128 sum = _mm_setzero_ps();
+      for (int i = 0; i < channels; ++i)
+      {
+        const __m128 pair   = _mm_unpacklo_ps(_mm_load_ss(in + i), _mm_load_ss(in + channels + i));
+        const __m128 sample = _mm_unpacklo_ps(pair, pair);
+        const __m128 level  = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)m_matrix[i]);
+        sum = _mm_add_ps(sum, _mm_mul_ps(sample, _mm_movelh_ps(level, level)));
       }
+      _mm_storeu_ps(out, sum);
     }
   }
+
+  for (; f < frames; ++f, in += channels, out += outChannels)
+  {
+    __m128 lo = _mm_setzero_ps();
+    __m128 hi = _mm_setzero_ps();
+    for (int i = 0; i < channels; ++i)
+    {
+      const __m128 sample = _mm_load1_ps(in + i);
+      lo = _mm_add_ps(lo, _mm_mul_ps(sample, _mm_loadu_ps(m_matrix[i])));
+      if (outChannels > 4)
+        hi = _mm_add_ps(hi, _mm_mul_ps(sample, _mm_loadu_ps(m_matrix[i] + 4)));
+    }
+
+    if (outChannels > 4)
+    {
+      _mm_storeu_ps(out, lo);
+      StorePartial(out + 4, hi, outChannels - 4);
+    }
+    else
+      StorePartial(out, lo, outChannels);
+  }
 }
+#endif
 
 inline void CAERemap::BuildUpmixMatrix(const CAEChannelInfo& input, const CAEChannelInfo& output)
 {
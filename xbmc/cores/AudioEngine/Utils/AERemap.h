@@ -20,6 +20,7 @@
  */
 
 #include "AEAudioFormat.h"
+#include "AEUtil.h"
 
 class CAERemap {
 public:
@@ -44,12 +45,35 @@ private:
     int               cpyCount; /* the number of times the channel has been cloned */
   } AEMixInfo;
 
+  /* the non zero mix levels of an output channel, ordered by input channel */
+  typedef struct {
+    int       count;
+    int       index[AE_CH_MAX];
+    float     level[AE_CH_MAX];
+  } AEMixRow;
+
+  typedef void (CAERemap::*RemapFn)(const float *in, float *out, const unsigned int frames) const;
+
   AEMixInfo      m_mixInfo[AE_CH_MAX+1];
   CAEChannelInfo m_output;
   int            m_inChannels;
   int            m_outChannels;
 
+  /* the mix compiled for the remap kernels, both forms give the same result */
+  float          m_matrix[AE_CH_MAX][AE_CH_MAX]; /* dense, [input][output] */
+  AEMixRow       m_rows[AE_CH_MAX];              /* sparse, per output */
+  bool           m_identity;                     /* output is a plain copy of the input */
+  RemapFn        m_remapFn;
+
   void ResolveMix(const AEChannel from, CAEChannelInfo to);
   void BuildUpmixMatrix(const CAEChannelInfo& input, const CAEChannelInfo& output);
+  void BuildMatrix();
+
+  void RemapCopy  (const float *in, float *out, const unsigned int frames) const;
+  void RemapScalar(const float *in, float *out, const unsigned int frames) const;
+#ifdef __SSE__
+  template <int inChannels, int outChannels>
+  void RemapSSE(const float *in, float *out, const unsigned int frames) const;
+#endif
 };
 
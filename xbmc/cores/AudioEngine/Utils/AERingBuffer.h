@@ -27,6 +27,7 @@
 //#define AE_RING_BUFFER_DEBUG
 
 #include "utils/log.h"  //CLog
+#include "threads/Atomics.h" //AtomicIncrement, AtomicAdd
 #include <string.h>     //memset, memcpy
 
 /**
@@ -251,3 +252,128 @@ private:
   unsigned int m_iSize;
   unsigned char *m_Buffer;
 };
+
+/**
+ * Ring of fixed size elements, for one producer and one consumer thread.
+ * Neither side ever takes a lock or waits for the other: the producer fills
+ * the slot returned by Reserve() and publishes it with Commit(), the consumer
+ * reads the slot returned by Peek() and hands it back with Release().
+ * If you intend to call the Create() or Reset() methods, please use Locks.
+ */
+template<typename T>
+class AESPSCRing {
+
+public:
+  AESPSCRing() :
+    m_iRead(0),
+    m_iWritten(0),
+    m_iSize(0),
+    m_Buffer(NULL)
+  {
+  }
+
+  ~AESPSCRing()
+  {
+    delete[] m_Buffer;
+  }
+
+  /**
+   * Allocates space for at least size elements, any elements in the ring are lost.
+   * The size is rounded up to a power of two so the counters can wrap around.
+   *
+   * @return true on success, false otherwise
+   */
+  bool Create(unsigned int size)
+  {
+    unsigned int pow2 = 1;
+    while (pow2 < size)
+      pow2 <<= 1;
+
+    delete[] m_Buffer;
+    m_Buffer = new T[pow2];
+    m_iSize  = pow2;
+    Reset();
+    return true;
+  }
+
+  /**
+   * Empties the ring.
+   * This method is not thread-safe, so before using this method
+   * please acquire a Lock()
+   */
+  void Reset()
+  {
+    m_iRead    = 0;
+    m_iWritten = 0;
+  }
+
+  /**
+   * Producer: returns the next free slot, or NULL if the ring is full.
+   * The slot is not visible to the consumer until Commit() is called.
+   */
+  T* Reserve()
+  {
+    if (m_iSize == 0 || GetReadSize() >= m_iSize)
+      return NULL;
+    return &m_Buffer[(unsigned long)m_iWritten & (m_iSize - 1)];
+  }
+
+  /**
+   * Producer: publishes the slot returned by Reserve().
+   */
+  void Commit()
+  {
+    //the full barrier makes sure the slot is written before the consumer can see it
+    AtomicIncrement(&m_iWritten);
+  }
+
+  /**
+   * Consumer: returns the oldest element, or NULL if the ring is empty.
+   */
+  T* Peek()
+  {
+    if (GetReadSize() == 0)
+      return NULL;
+    return &m_Buffer[(unsigned long)m_iRead & (m_iSize - 1)];
+  }
+
+  /**
+   * Consumer: hands the slot returned by Peek() back to the producer.
+   */
+  void Release()
+  {
+    //the full barrier makes sure we are done with the slot before the producer can reuse it
+    AtomicIncrement(&m_iRead);
+  }
+
+  /**
+   * Returns the number of elements waiting to be read.
+   */
+  unsigned int GetReadSize()
+  {
+    //AtomicAdd is used as a load with a full barrier
+    return (unsigned long)AtomicAdd(&m_iWritten, 0) - (unsigned long)AtomicAdd(&m_iRead, 0);
+  }
+
+  /**
+   * Returns the number of free slots.
+   */
+  unsigned int GetWriteSize()
+  {
+    return m_iSize - GetReadSize();
+  }
+
+  /**
+   * Returns the ring size.
+   */
+  unsigned int GetMaxSize()
+  {
+    return m_iSize;
+  }
+
+private:
+  volatile long m_iRead;
+  volatile long m_iWritten;
+  unsigned int  m_iSize;
+  T            *m_Buffer;
+};
@@ -0,0 +1,222 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AEConvert.h"
+#include "cores/AudioEngine/Utils/AEUtil.h"
+#include "utils/TimeUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+/* odd, so every conversion also has to handle the trailing samples */
+static const unsigned int TEST_SAMPLES = 1023;
+
+struct TestFormat
+{
+  enum AEDataFormat format;
+  const char       *name;
+  unsigned int      bits;  ///< resolution of the format, used for the allowed error
+};
+
+static const TestFormat formats[] =
+{
+  { AE_FMT_U8    , "U8"    ,  8 },
+  { AE_FMT_S8    , "S8"    ,  8 },
+  { AE_FMT_S16LE , "S16LE" , 16 },
+  { AE_FMT_S16BE , "S16BE" , 16 },
+  { AE_FMT_S16NE , "S16NE" , 16 },
+  { AE_FMT_S24NE3, "S24NE3", 24 },
+  { AE_FMT_S32LE , "S32LE" , 24 },
+  { AE_FMT_S32BE , "S32BE" , 24 },
+  { AE_FMT_S32NE , "S32NE" , 24 },
+  { AE_FMT_DOUBLE, "DOUBLE", 24 }
+};
+static const unsigned int formatCount = sizeof(formats) / sizeof(formats[0]);
+
+static void FillSamples(std::vector<float> &samples)
+{
+  srand(1234);
+  for (size_t i = 0; i < samples.size(); ++i)
+    samples[i] = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+}
+
+/* allow one step of the format, and another half step for the dither */
+static float Tolerance(const TestFormat &format)
+{
+  return 1.5f / (float)(1 << (format.bits - 1));
+}
+
+TEST(TestAEConvert, RoundTrip)
+{
+  std::vector<float> in(TEST_SAMPLES), out(TEST_SAMPLES);
+  FillSamples(in);
+
+  for (unsigned int f = 0; f < formatCount; ++f)
+  {
+    CAEConvert::AEConvertFrFn frFn = CAEConvert::FrFloat(formats[f].format);
+    CAEConvert::AEConvertToFn toFn = CAEConvert::ToFloat(formats[f].format);
+    ASSERT_TRUE(frFn != NULL && toFn != NULL) << formats[f].name;
+
+    std::vector<uint8_t> buffer(TEST_SAMPLES * CAEUtil::DataFormatToBits(formats[f].format) / 8);
+    EXPECT_EQ(buffer.size(), frFn(&in[0], TEST_SAMPLES, &buffer[0])) << formats[f].name;
+    EXPECT_EQ(TEST_SAMPLES, toFn(&buffer[0], TEST_SAMPLES, &out[0])) << formats[f].name;
+
+    for (unsigned int i = 0; i < TEST_SAMPLES; ++i)
+      ASSERT_NEAR(in[i], out[i], Tolerance(formats[f])) << formats[f].name << " sample " << i;
+  }
+}
+
+TEST(TestAEConvert, RoundTripS24NE4)
+{
+  /* S24NE4 is written into the upper three bytes, so it reads back as S32NE */
+  std::vector<float> in(TEST_SAMPLES), out(TEST_SAMPLES);
+  std::vector<int32_t> buffer(TEST_SAMPLES);
+  FillSamples(in);
+
+  CAEConvert::FrFloat(AE_FMT_S24NE4)(&in[0], TEST_SAMPLES, (uint8_t*)&buffer[0]);
+  CAEConvert::ToFloat(AE_FMT_S32NE )((uint8_t*)&buffer[0], TEST_SAMPLES, &out[0]);
+
+  for (unsigned int i = 0; i < TEST_SAMPLES; ++i)
+  {
+    ASSERT_EQ(0, buffer[i] & 0xFF);
+    ASSERT_NEAR(in[i], out[i], 1.5f / (1 << 23)) << "sample " << i;
+  }
+}
+
+TEST(TestAEConvert, Saturation)
+{
+  /* out of range input must clip rather than wrap around */
+  std::vector<float> in(TEST_SAMPLES), out(TEST_SAMPLES);
+  for (unsigned int i = 0; i < TEST_SAMPLES; ++i)
+    in[i] = (i & 1) ? -1.5f : 1.5f;
+
+  for (unsigned int f = 0; f < formatCount; ++f)
+  {
+    std::vector<uint8_t> buffer(TEST_SAMPLES * CAEUtil::DataFormatToBits(formats[f].format) / 8);
+    CAEConvert::FrFloat(formats[f].format)(&in[0], TEST_SAMPLES, &buffer[0]);
+    CAEConvert::ToFloat(formats[f].format)(&buffer[0], TEST_SAMPLES, &out[0]);
+
+    for (unsigned int i = 0; i < TEST_SAMPLES; ++i)
+      ASSERT_NEAR((i & 1) ? -1.0f : 1.0f, out[i], Tolerance(formats[f])) << formats[f].name << " sample " << i;
+  }
+}
+
+TEST(TestAEConvert, Unaligned)
+{
+  /* a whole buffer at odd addresses has to match the same samples converted one by one */
+  std::vector<float> in(TEST_SAMPLES + 1), out(TEST_SAMPLES + 1), single(TEST_SAMPLES);
+  FillSamples(in);
+
+  for (unsigned int f = 0; f < formatCount; ++f)
+  {
+    const unsigned int bytes = CAEUtil::DataFormatToBits(formats[f].format) / 8;
+    CAEConvert::AEConvertFrFn frFn = CAEConvert::FrFloat(formats[f].format);
+    CAEConvert::AEConvertToFn toFn = CAEConvert::ToFloat(formats[f].format);
+
+    std::vector<uint8_t> buffer((TEST_SAMPLES + 1) * bytes), reference(TEST_SAMPLES * bytes);
+    frFn(&in[1], TEST_SAMPLES, &buffer[1]);
+    toFn(&buffer[1], TEST_SAMPLES, &out[1]);
+
+    for (unsigned int i = 0; i < TEST_SAMPLES; ++i)
+    {
+      frFn(&in[i + 1], 1, &reference[i * bytes]);
+      toFn(&reference[i * bytes], 1, &single[i]);
+    }
+
+    for (unsigned int i = 0; i < TEST_SAMPLES; ++i)
+      ASSERT_NEAR(single[i], out[i + 1], Tolerance(formats[f])) << formats[f].name << " sample " << i;
+
+    /* reading back has no rounding to do, so that has to be exact */
+    for (unsigned int i = 0; i < TEST_SAMPLES; ++i)
+      toFn(&buffer[1 + i * bytes], 1, &single[i]);
+    EXPECT_EQ(0, memcmp(&single[0], &out[1], TEST_SAMPLES * sizeof(float))) << formats[f].name;
+  }
+}
+
+TEST(TestAEConvert, BigEndian)
+{
+  /* the byte swapped formats have to match their little endian counterparts */
+  static const enum AEDataFormat pairs[][2] =
+  {
+    { AE_FMT_S16LE , AE_FMT_S16BE  },
+    { AE_FMT_S24LE4, AE_FMT_S24BE4 },
+    { AE_FMT_S24LE3, AE_FMT_S24BE3 },
+    { AE_FMT_S32LE , AE_FMT_S32BE  }
+  };
+
+  std::vector<uint8_t> le(TEST_SAMPLES * 4), be(TEST_SAMPLES * 4);
+  std::vector<float> leOut(TEST_SAMPLES), beOut(TEST_SAMPLES);
+  srand(1234);
+  for (size_t i = 0; i < le.size(); ++i)
+    le[i] = rand() & 0xFF;
+
+  for (unsigned int p = 0; p < sizeof(pairs) / sizeof(pairs[0]); ++p)
+  {
+    /* the 4 byte 24 bit formats keep the sample in the first three bytes for both byte orders */
+    const unsigned int bytes = CAEUtil::DataFormatToBits(pairs[p][0]) / 8;
+    const unsigned int width = pairs[p][0] == AE_FMT_S24LE4 ? 3 : bytes;
+    be = le;
+    for (unsigned int i = 0; i < TEST_SAMPLES; ++i)
+      for (unsigned int b = 0; b < width; ++b)
+        be[i * bytes + b] = le[i * bytes + width - 1 - b];
+
+    CAEConvert::ToFloat(pairs[p][0])(&le[0], TEST_SAMPLES, &leOut[0]);
+    CAEConvert::ToFloat(pairs[p][1])(&be[0], TEST_SAMPLES, &beOut[0]);
+    EXPECT_EQ(0, memcmp(&leOut[0], &beOut[0], TEST_SAMPLES * sizeof(float))) << CAEUtil::DataFormatToStr(pairs[p][1]);
+  }
+}
+
+static void RunBenchmark(const TestFormat &format)
+{
+  /* one second of 24/192 stereo */
+  const unsigned int samples = 192000 * 2;
+  const unsigned int loops   = 100;
+
+  std::vector<float> in(samples), out(samples);
+  std::vector<uint8_t> buffer(samples * CAEUtil::DataFormatToBits(format.format) / 8);
+  FillSamples(in);
+
+  CAEConvert::AEConvertFrFn frFn = CAEConvert::FrFloat(format.format);
+  CAEConvert::AEConvertToFn toFn = CAEConvert::ToFloat(format.format);
+
+  int64_t start = CurrentHostCounter();
+  for (unsigned int i = 0; i < loops; ++i)
+    frFn(&in[0], samples, &buffer[0]);
+  double frTime = (CurrentHostCounter() - start) * 1000000000.0 / CurrentHostFrequency();
+
+  start = CurrentHostCounter();
+  for (unsigned int i = 0; i < loops; ++i)
+    toFn(&buffer[0], samples, &out[0]);
+  double toTime = (CurrentHostCounter() - start) * 1000000000.0 / CurrentHostFrequency();
+
+  std::cout << "Float -> " << format.name << " Samples/ns: " << testing::PrintToString(frTime > 0 ? samples * loops / frTime : 0.0)
+            << " " << format.name << " -> Float Samples/ns: " << testing::PrintToString(toTime > 0 ? samples * loops / toTime : 0.0) << std::endl;
+}
+
+/* a benchmark, run it with --gtest_also_run_disabled_tests */
+TEST(TestAEConvert, DISABLED_Performance)
+{
+  for (unsigned int f = 0; f < formatCount; ++f)
+    RunBenchmark(formats[f]);
+}
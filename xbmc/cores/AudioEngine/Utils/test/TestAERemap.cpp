@@ -0,0 +1,143 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AERemap.h"
+#include "utils/TimeUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+/* odd, so the stereo kernels also have to handle a single trailing frame */
+static const unsigned int TEST_FRAMES = 1023;
+
+static void FillSamples(std::vector<float> &samples)
+{
+  srand(1234);
+  for (size_t i = 0; i < samples.size(); ++i)
+    samples[i] = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+}
+
+/* recover the mix matrix from the impulse response of every input channel */
+static void GetMatrix(const CAERemap &remap, unsigned int inChannels, unsigned int outChannels, std::vector<float> &matrix)
+{
+  std::vector<float> in(inChannels), out(outChannels);
+  matrix.assign(inChannels * outChannels, 0.0f);
+  for (unsigned int i = 0; i < inChannels; ++i)
+  {
+    std::fill(in.begin(), in.end(), 0.0f);
+    in[i] = 1.0f;
+    remap.Remap(&in[0], &out[0], 1);
+    for (unsigned int o = 0; o < outChannels; ++o)
+      matrix[i * outChannels + o] = out[o];
+  }
+}
+
+static void CheckBitExact(enum AEStdChLayout inLayout, enum AEStdChLayout outLayout, bool finalStage)
+{
+  CAEChannelInfo input(inLayout), output(outLayout);
+  unsigned int inChannels = input.Count(), outChannels = output.Count();
+
+  CAERemap remap;
+  ASSERT_TRUE(remap.Initialize(input, output, finalStage, true));
+
+  std::vector<float> matrix;
+  GetMatrix(remap, inChannels, outChannels, matrix);
+
+  std::vector<float> in(TEST_FRAMES * inChannels), out(TEST_FRAMES * outChannels);
+  FillSamples(in);
+  remap.Remap(&in[0], &out[0], TEST_FRAMES);
+
+  /* every kernel has to sum the inputs in channel order */
+  for (unsigned int f = 0; f < TEST_FRAMES; ++f)
+    for (unsigned int o = 0; o < outChannels; ++o)
+    {
+      float sum = 0.0f;
+      for (unsigned int i = 0; i < inChannels; ++i)
+        if (matrix[i * outChannels + o] != 0.0f)
+          sum += in[f * inChannels + i] * matrix[i * outChannels + o];
+
+      ASSERT_EQ(0, memcmp(&sum, &out[f * outChannels + o], sizeof(float)))
+        << (std::string)input << " -> " << (std::string)output << " frame " << f << " channel " << o;
+    }
+}
+
+TEST(TestAERemap, Copy)
+{
+  CAEChannelInfo layout(AE_CH_LAYOUT_5_1);
+  CAERemap remap;
+  ASSERT_TRUE(remap.Initialize(layout, layout, true));
+
+  std::vector<float> in(TEST_FRAMES * layout.Count()), out(in.size());
+  FillSamples(in);
+  remap.Remap(&in[0], &out[0], TEST_FRAMES);
+
+  EXPECT_EQ(0, memcmp(&in[0], &out[0], in.size() * sizeof(float)));
+}
+
+TEST(TestAERemap, BitExact)
+{
+  static const enum AEStdChLayout layouts[] =
+  {
+    AE_CH_LAYOUT_1_0, AE_CH_LAYOUT_2_0, AE_CH_LAYOUT_2_1, AE_CH_LAYOUT_3_0,
+    AE_CH_LAYOUT_4_1, AE_CH_LAYOUT_5_1, AE_CH_LAYOUT_7_0, AE_CH_LAYOUT_7_1
+  };
+  static const unsigned int count = sizeof(layouts) / sizeof(layouts[0]);
+
+  for (unsigned int i = 0; i < count; ++i)
+    for (unsigned int o = 0; o < count; ++o)
+    {
+      CheckBitExact(layouts[i], layouts[o], false);
+      CheckBitExact(layouts[i], layouts[o], true);
+    }
+}
+
+static void RunBenchmark(enum AEStdChLayout inLayout, enum AEStdChLayout outLayout)
+{
+  CAEChannelInfo input(inLayout), output(outLayout);
+  CAERemap remap;
+  ASSERT_TRUE(remap.Initialize(input, output, false, true));
+
+  /* a typical SoftAE packet */
+  const unsigned int frames = 4096;
+  const unsigned int loops  = 1000;
+  std::vector<float> in(frames * input.Count()), out(frames * output.Count());
+  FillSamples(in);
+
+  int64_t start = CurrentHostCounter();
+  for (unsigned int i = 0; i < loops; ++i)
+    remap.Remap(&in[0], &out[0], frames);
+  double seconds = (CurrentHostCounter() - start) / (double)CurrentHostFrequency();
+
+  std::cout << "Remap " << (std::string)input << " -> " << (std::string)output
+            << " Frames/sec: " << testing::PrintToString(seconds > 0 ? frames * loops / seconds : 0.0) << std::endl;
+}
+
+/* a benchmark, run it with --gtest_also_run_disabled_tests */
+TEST(TestAERemap, DISABLED_Performance)
+{
+  RunBenchmark(AE_CH_LAYOUT_7_1, AE_CH_LAYOUT_2_0);
+  RunBenchmark(AE_CH_LAYOUT_5_1, AE_CH_LAYOUT_2_0);
+  RunBenchmark(AE_CH_LAYOUT_2_0, AE_CH_LAYOUT_5_1);
+  RunBenchmark(AE_CH_LAYOUT_7_1, AE_CH_LAYOUT_7_1);
+  RunBenchmark(AE_CH_LAYOUT_4_1, AE_CH_LAYOUT_2_1);
+}
@@ -0,0 +1,120 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "system.h"
+#include "cores/AudioEngine/Utils/AERingBuffer.h"
+#include "threads/test/TestHelpers.h"
+
+#include "gtest/gtest.h"
+
+static const unsigned int TEST_ITEMS = 100000;
+
+TEST(TestAESPSCRing, Create)
+{
+  AESPSCRing<int> ring;
+  EXPECT_TRUE(ring.Reserve() == NULL);
+
+  /* the size is rounded up to a power of two */
+  ASSERT_TRUE(ring.Create(5));
+  EXPECT_EQ(8U, ring.GetMaxSize());
+  EXPECT_EQ(0U, ring.GetReadSize());
+  EXPECT_EQ(8U, ring.GetWriteSize());
+  EXPECT_TRUE(ring.Peek() == NULL);
+}
+
+TEST(TestAESPSCRing, Full)
+{
+  AESPSCRing<int> ring;
+  ring.Create(4);
+
+  for (int i = 0; i < 4; ++i)
+  {
+    int *slot = ring.Reserve();
+    ASSERT_TRUE(slot != NULL);
+    *slot = i;
+    ring.Commit();
+  }
+  EXPECT_TRUE(ring.Reserve() == NULL);
+  EXPECT_EQ(4U, ring.GetReadSize());
+
+  /* wrap around a few times */
+  for (int i = 0; i < 10; ++i)
+  {
+    int *item = ring.Peek();
+    ASSERT_TRUE(item != NULL);
+    EXPECT_EQ(i, *item);
+    ring.Release();
+
+    int *slot = ring.Reserve();
+    ASSERT_TRUE(slot != NULL);
+    *slot = i + 4;
+    ring.Commit();
+  }
+
+  ring.Reset();
+  EXPECT_TRUE(ring.Peek() == NULL);
+}
+
+class Producer : public IRunnable
+{
+  AESPSCRing<unsigned int> &ring;
+public:
+  Producer(AESPSCRing<unsigned int> &r) : ring(r) {}
+
+  void Run()
+  {
+    for (unsigned int i = 0; i < TEST_ITEMS; ++i)
+    {
+      unsigned int *slot;
+      while ((slot = ring.Reserve()) == NULL)
+        XbmcThreads::ThreadSleep(0);
+      *slot = i;
+      ring.Commit();
+    }
+  }
+};
+
+TEST(TestAESPSCRing, Threaded)
+{
+  /* a small ring so both sides keep running into each other */
+  AESPSCRing<unsigned int> ring;
+  ring.Create(16);
+
+  Producer producer(ring);
+  thread t(producer);
+
+  unsigned int expected = 0;
+  while (expected < TEST_ITEMS)
+  {
+    unsigned int *item = ring.Peek();
+    if (!item)
+    {
+      XbmcThreads::ThreadSleep(0);
+      continue;
+    }
+    ASSERT_EQ(expected, *item);
+    ring.Release();
+    ++expected;
+  }
+
+  EXPECT_TRUE(t.timed_join(10000));
+  EXPECT_EQ(0U, ring.GetReadSize());
+}
@@ -180,7 +180,22 @@ static int dvd_file_read(void *h, uint8_t* buf, int size)
     return -1;
 
   CDVDInputStream* pInputStream = (CDVDInputStream*)h;
-  return pInputStream->Read(buf, size);
+
+  // take the data straight from the file cache where possible. the buffer
+  // belongs to ffmpeg, so the bytes are still copied into it once here, the
+  // same single copy Read() makes. the copy that's saved is on the fill side
+  // of the cache, see CFileCache::Process()
+  const BYTE* data;
+  int ret = pInputStream->GetReadBuffer(&data, size);
+  if(ret < 0)
+    return pInputStream->Read(buf, size);
+
+  if(ret > 0)
+  {
+    memcpy(buf, data, ret);
+    pInputStream->ReleaseReadBuffer(ret);
+  }
+  return ret;
 }
 /*
 static int dvd_file_write(URLContext *h, BYTE* buf, int size)
@@ -684,7 +699,7 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
         {
           if(pkt.stream_index == (int)m_pFormatContext->programs[m_program]->stream_index[i])
           {
-            pPacket = CDVDDemuxUtils::AllocateDemuxPacket(pkt.size);
+            pPacket = CDVDDemuxUtils::AllocateDemuxPacket(&pkt);
             break;
           }
         }
@@ -693,7 +708,7 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
           bReturnEmpty = true;
       }
       else
-        pPacket = CDVDDemuxUtils::AllocateDemuxPacket(pkt.size);
+        pPacket = CDVDDemuxUtils::AllocateDemuxPacket(&pkt);
 
       if (pPacket)
       {
@@ -729,13 +744,6 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
           pkt.pts = AV_NOPTS_VALUE;
         }
 
-        // copy contents into our own packet
-        pPacket->iSize = pkt.size;
-
-        // maybe we can avoid a memcpy here by detecting where pkt.destruct is pointing too?
-        if (pkt.data)
-          memcpy(pPacket->pData, pkt.data, pPacket->iSize);
-
         pPacket->pts = ConvertTimestamp(pkt.pts, stream->time_base.den, stream->time_base.num);
         pPacket->dts = ConvertTimestamp(pkt.dts, stream->time_base.den, stream->time_base.num);
         pPacket->duration =  DVD_SEC_TO_TIME((double)pkt.duration * stream->time_base.num / stream->time_base.den);
@@ -24,16 +24,153 @@
 #include "DVDDemuxUtils.h"
 #include "DVDClock.h"
 #include "utils/log.h"
-extern "C" {
-#if (defined USE_EXTERNAL_FFMPEG)
-  #if (defined HAVE_LIBAVCODEC_AVCODEC_H)
-    #include <libavcodec/avcodec.h>
-  #else
-    #include <ffmpeg/avcodec.h>
-  #endif
-#else
-  #include "libavcodec/avcodec.h"
-#endif
+#include "threads/CriticalSection.h"
+#include "threads/SingleLock.h"
+#include "DllAvCodec.h"
+
+// payloads are pooled in power of two size classes from 1KB up to 4MB,
+// anything bigger goes straight to the heap
+#define POOL_MIN_SHIFT  10
+#define POOL_CLASSES    13
+#define POOL_MAX_CACHED (32 * 1024 * 1024)
+
+namespace
+{
+  // DemuxPacket has to stay the first member, FreeDemuxPacket casts back to it
+  struct PooledPacket
+  {
+    DemuxPacket   packet;
+    int           sizeClass; // size class of pData, -1 if it isn't pooled
+    bool          adopted;   // pData belongs to avpkt, it's freed with av_free_packet
+    AVPacket      avpkt;
+    PooledPacket* next;
+  };
+
+  // a free payload keeps the link to the next one in its own memory
+  struct PooledPayload
+  {
+    PooledPayload* next;
+  };
+}
+
+// packets are freed by whichever player thread consumed them, so all of this is
+// guarded by one lock. it is only held to push or pop a list entry.
+static CCriticalSection          g_poolSection;
+static PooledPacket*             g_freePackets = NULL;
+static PooledPayload*            g_freePayloads[POOL_CLASSES];
+static CDVDDemuxUtils::PoolStats g_poolStats;
+// loaded by the first packet taken over from ffmpeg, kept while packets are outstanding
+static DllAvCodec*               g_dllAvCodec = NULL;
+
+static DllAvCodec* GetDllAvCodec()
+{
+  CSingleLock lock(g_poolSection);
+  if (!g_dllAvCodec)
+  {
+    DllAvCodec* dll = new DllAvCodec;
+    if (!dll->Load())
+    {
+      delete dll;
+      return NULL;
+    }
+    g_dllAvCodec = dll;
+  }
+  return g_dllAvCodec;
+}
+
+static int GetSizeClass(int iSize)
+{
+  for (int i = 0; i < POOL_CLASSES; i++)
+  {
+    if (iSize <= (1 << (i + POOL_MIN_SHIFT)))
+      return i;
+  }
+  return -1;
+}
+
+static PooledPacket* GetPacket()
+{
+  PooledPacket* pooled = NULL;
+  {
+    CSingleLock lock(g_poolSection);
+    if (g_freePackets)
+    {
+      pooled        = g_freePackets;
+      g_freePackets = pooled->next;
+    }
+  }
+
+  if (!pooled)
+    pooled = new PooledPacket;
+
+  {
+    CSingleLock lock(g_poolSection);
+    g_poolStats.allocated++;
+    g_poolStats.outstanding++;
+  }
+
+  memset(pooled, 0, sizeof(PooledPacket));
+  pooled->sizeClass = -1;
+
+  // setup defaults
+  pooled->packet.dts       = DVD_NOPTS_VALUE;
+  pooled->packet.pts       = DVD_NOPTS_VALUE;
+  pooled->packet.iStreamId = -1;
+  return pooled;
+}
+
+static void PutPacket(PooledPacket* pooled)
+{
+  CSingleLock lock(g_poolSection);
+  pooled->next  = g_freePackets;
+  g_freePackets = pooled;
+  g_poolStats.outstanding--;
+}
+
+static BYTE* GetPayload(int iSize, int& sizeClass)
+{
+  sizeClass = GetSizeClass(iSize);
+  if (sizeClass < 0)
+  {
+    CSingleLock lock(g_poolSection);
+    g_poolStats.oversized++;
+    lock.Leave();
+    return (BYTE*)_aligned_malloc(iSize, 16);
+  }
+
+  {
+    CSingleLock lock(g_poolSection);
+    PooledPayload* payload = g_freePayloads[sizeClass];
+    if (payload)
+    {
+      g_freePayloads[sizeClass] = payload->next;
+      g_poolStats.cached       -= 1 << (sizeClass + POOL_MIN_SHIFT);
+      g_poolStats.reused++;
+      return (BYTE*)payload;
+    }
+  }
+  return (BYTE*)_aligned_malloc(1 << (sizeClass + POOL_MIN_SHIFT), 16);
+}
+
+static void PutPayload(BYTE* pData, int sizeClass)
+{
+  if (sizeClass >= 0)
+  {
+    size_t size = 1 << (sizeClass + POOL_MIN_SHIFT);
+
+    CSingleLock lock(g_poolSection);
+    if (g_poolStats.cached + size <= POOL_MAX_CACHED)
+    {
+      PooledPayload* payload    = (PooledPayload*)pData;
+      payload->next             = g_freePayloads[sizeClass];
+      g_freePayloads[sizeClass] = payload;
+      g_poolStats.cached       += size;
+      if (g_poolStats.cached > g_poolStats.peak)
+        g_poolStats.peak = g_poolStats.cached;
+      return;
+    }
+  }
+  _aligned_free(pData);
 }
 
 void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
@@ -41,8 +178,12 @@ void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
   if (pPacket)
   {
     try {
-      if (pPacket->pData) _aligned_free(pPacket->pData);
-      delete pPacket;
+      PooledPacket* pooled = (PooledPacket*)pPacket;
+      if (pooled->adopted)
+        g_dllAvCodec->av_free_packet(&pooled->avpkt);
+      else if (pPacket->pData)
+        PutPayload(pPacket->pData, pooled->sizeClass);
+      PutPacket(pooled);
     }
     catch(...) {
       CLog::Log(LOGERROR, "%s - Exception thrown while freeing packet", __FUNCTION__);
@@ -52,12 +193,11 @@ void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
 
 DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
 {
-  DemuxPacket* pPacket = new DemuxPacket;
-  if (!pPacket) return NULL;
+  PooledPacket* pooled = NULL;
 
   try
   {
-    memset(pPacket, 0, sizeof(DemuxPacket));
+    pooled = GetPacket();
 
     if (iDataSize > 0)
     {
@@ -70,27 +210,136 @@ DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
         * Note, if the first 23 bits of the additional bytes are not 0 then damaged
         * MPEG bitstreams could cause overread and segfault
         */
-      pPacket->pData =(BYTE*)_aligned_malloc(iDataSize + FF_INPUT_BUFFER_PADDING_SIZE, 16);
-      if (!pPacket->pData)
+      pooled->packet.pData = GetPayload(iDataSize + FF_INPUT_BUFFER_PADDING_SIZE, pooled->sizeClass);
+      if (!pooled->packet.pData)
       {
-        FreeDemuxPacket(pPacket);
+        FreeDemuxPacket(&pooled->packet);
         return NULL;
       }
 
       // reset the last 8 bytes to 0;
-      memset(pPacket->pData + iDataSize, 0, FF_INPUT_BUFFER_PADDING_SIZE);
+      memset(pooled->packet.pData + iDataSize, 0, FF_INPUT_BUFFER_PADDING_SIZE);
+    }
+  }
+  catch(...)
+  {
+    CLog::Log(LOGERROR, "%s - Exception thrown", __FUNCTION__);
+    if (pooled)
+      FreeDemuxPacket(&pooled->packet);
+    return NULL;
+  }
+  return &pooled->packet;
+}
+
+DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(AVPacket* pkt)
+{
+  DllAvCodec* dll = pkt->data ? GetDllAvCodec() : NULL;
+  if (!dll)
+  {
+    DemuxPacket* pPacket = AllocateDemuxPacket(pkt->size);
+    if (pPacket && pkt->data)
+    {
+      memcpy(pPacket->pData, pkt->data, pkt->size);
+      pPacket->iSize = pkt->size;
     }
+    return pPacket;
+  }
+
+  // data that still belongs to the demuxer or a parser is only valid until the next
+  // read, av_dup_packet copies it. buffers ffmpeg allocated for the packet are kept.
+  if (dll->av_dup_packet(pkt) < 0)
+  {
+    CLog::Log(LOGERROR, "%s - av_dup_packet failed", __FUNCTION__);
+    return NULL;
+  }
 
-    // setup defaults
-    pPacket->dts       = DVD_NOPTS_VALUE;
-    pPacket->pts       = DVD_NOPTS_VALUE;
-    pPacket->iStreamId = -1;
+  PooledPacket* pooled = NULL;
+  try
+  {
+    pooled = GetPacket();
   }
   catch(...)
   {
     CLog::Log(LOGERROR, "%s - Exception thrown", __FUNCTION__);
-    FreeDemuxPacket(pPacket);
-    pPacket = NULL;
+    return NULL;
+  }
+
+  // either way the buffer is padded, so it can be used as is
+  pooled->adopted      = true;
+  pooled->avpkt        = *pkt;
+  pooled->packet.pData = pkt->data;
+  pooled->packet.iSize = pkt->size;
+
+  // the buffer and side data now belong to avpkt. the timing of the packet is still
+  // read by the demuxer, so only the ownership is reset.
+  dll->av_init_packet(pkt);
+  pkt->data                 = NULL;
+  pkt->size                 = 0;
+  pkt->pts                  = pooled->avpkt.pts;
+  pkt->dts                  = pooled->avpkt.dts;
+  pkt->pos                  = pooled->avpkt.pos;
+  pkt->duration             = pooled->avpkt.duration;
+  pkt->convergence_duration = pooled->avpkt.convergence_duration;
+  pkt->flags                = pooled->avpkt.flags;
+  pkt->stream_index         = pooled->avpkt.stream_index;
+
+  CSingleLock lock(g_poolSection);
+  g_poolStats.adopted++;
+  return &pooled->packet;
+}
+
+void CDVDDemuxUtils::GetPoolStats(PoolStats& stats)
+{
+  CSingleLock lock(g_poolSection);
+  stats = g_poolStats;
+}
+
+void CDVDDemuxUtils::ReleasePool()
+{
+  PooledPacket*  packets = NULL;
+  PooledPayload* payloads[POOL_CLASSES];
+  DllAvCodec*    dll = NULL;
+  {
+    CSingleLock lock(g_poolSection);
+    CLog::Log(LOGDEBUG, "%s - allocated: %u, reused: %u, adopted: %u, oversized: %u, outstanding: %u, cached: %u KB, peak: %u KB", __FUNCTION__,
+              g_poolStats.allocated, g_poolStats.reused, g_poolStats.adopted, g_poolStats.oversized, g_poolStats.outstanding,
+              (unsigned int)(g_poolStats.cached / 1024), (unsigned int)(g_poolStats.peak / 1024));
+
+    packets       = g_freePackets;
+    g_freePackets = NULL;
+    for (int i = 0; i < POOL_CLASSES; i++)
+    {
+      payloads[i]       = g_freePayloads[i];
+      g_freePayloads[i] = NULL;
+    }
+
+    // outstanding packets are still in use, keep counting them
+    unsigned int outstanding = g_poolStats.outstanding;
+    memset(&g_poolStats, 0, sizeof(g_poolStats));
+    g_poolStats.outstanding = outstanding;
+
+    if (outstanding == 0)
+    {
+      dll          = g_dllAvCodec;
+      g_dllAvCodec = NULL;
+    }
+  }
+  delete dll;
+
+  while (packets)
+  {
+    PooledPacket* next = packets->next;
+    delete packets;
+    packets = next;
+  }
+
+  for (int i = 0; i < POOL_CLASSES; i++)
+  {
+    while (payloads[i])
+    {
+      PooledPayload* next = payloads[i]->next;
+      _aligned_free(payloads[i]);
+      payloads[i] = next;
+    }
   }
-  return pPacket;
 }
@@ -22,10 +22,39 @@
 
 #include "DVDDemuxPacket.h"
 
+#include <stddef.h>
+
+struct AVPacket;
+
 class CDVDDemuxUtils
 {
 public:
+  struct PoolStats
+  {
+    unsigned int allocated;   // packets handed out
+    unsigned int reused;      // payloads taken from the pool instead of the heap
+    unsigned int adopted;     // ffmpeg buffers taken over without a copy
+    unsigned int oversized;   // payloads too big to be pooled
+    unsigned int outstanding; // packets not freed yet
+    size_t       cached;      // bytes of payload kept for reuse
+    size_t       peak;        // highest value of cached
+  };
+
   static void FreeDemuxPacket(DemuxPacket* pPacket);
   static DemuxPacket* AllocateDemuxPacket(int iDataSize = 0);
+
+  /*! \brief Create a packet holding the data of an ffmpeg packet.
+   The data is made to belong to the packet with av_dup_packet, and freed with av_free_packet
+   when the packet is. pkt is left without data, so av_free_packet on it is a no-op afterwards,
+   its timestamps, duration, flags and stream index are kept.
+   */
+  static DemuxPacket* AllocateDemuxPacket(AVPacket* pkt);
+
+  static void GetPoolStats(PoolStats& stats);
+
+  /*! \brief Give the memory cached for reuse back to the heap and log the statistics.
+   Packets still in use are not affected and return to the pool when freed.
+   */
+  static void ReleasePool();
 };
 
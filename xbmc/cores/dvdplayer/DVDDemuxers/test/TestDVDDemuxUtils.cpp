@@ -0,0 +1,140 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/dvdplayer/DVDDemuxers/DVDDemuxUtils.h"
+#include "cores/dvdplayer/DVDClock.h"
+#include "DllAvCodec.h"
+
+#include "gtest/gtest.h"
+
+TEST(TestDVDDemuxUtils, Reuse)
+{
+  CDVDDemuxUtils::PoolStats stats;
+  CDVDDemuxUtils::ReleasePool();
+
+  DemuxPacket *packet = CDVDDemuxUtils::AllocateDemuxPacket(1000);
+  ASSERT_TRUE(packet != NULL);
+  EXPECT_EQ(0, packet->iSize);
+  EXPECT_EQ(-1, packet->iStreamId);
+  EXPECT_EQ(DVD_NOPTS_VALUE, packet->pts);
+  EXPECT_EQ(DVD_NOPTS_VALUE, packet->dts);
+  BYTE *pData = packet->pData;
+  packet->iSize     = 1000;
+  packet->iStreamId = 1;
+  packet->pts       = 0.0;
+  CDVDDemuxUtils::FreeDemuxPacket(packet);
+
+  CDVDDemuxUtils::GetPoolStats(stats);
+  EXPECT_EQ(1U, stats.allocated);
+  EXPECT_EQ(0U, stats.reused);
+  EXPECT_EQ(0U, stats.outstanding);
+  EXPECT_GT(stats.cached, 0U);
+
+  /* the payload and the packet come back, reset */
+  DemuxPacket *again = CDVDDemuxUtils::AllocateDemuxPacket(900);
+  ASSERT_TRUE(again != NULL);
+  EXPECT_EQ(packet, again);
+  EXPECT_EQ(pData, again->pData);
+  EXPECT_EQ(0, again->iSize);
+  EXPECT_EQ(-1, again->iStreamId);
+  EXPECT_EQ(DVD_NOPTS_VALUE, again->pts);
+
+  CDVDDemuxUtils::GetPoolStats(stats);
+  EXPECT_EQ(2U, stats.allocated);
+  EXPECT_EQ(1U, stats.reused);
+  EXPECT_EQ(1U, stats.outstanding);
+  EXPECT_EQ(0U, stats.cached);
+
+  /* a payload of another size class isn't reused for it */
+  DemuxPacket *bigger = CDVDDemuxUtils::AllocateDemuxPacket(100000);
+  ASSERT_TRUE(bigger != NULL);
+  CDVDDemuxUtils::GetPoolStats(stats);
+  EXPECT_EQ(1U, stats.reused);
+  EXPECT_EQ(2U, stats.outstanding);
+
+  CDVDDemuxUtils::FreeDemuxPacket(again);
+  CDVDDemuxUtils::FreeDemuxPacket(bigger);
+  CDVDDemuxUtils::GetPoolStats(stats);
+  EXPECT_EQ(0U, stats.outstanding);
+  EXPECT_EQ(stats.cached, stats.peak);
+
+  CDVDDemuxUtils::ReleasePool();
+  CDVDDemuxUtils::GetPoolStats(stats);
+  EXPECT_EQ(0U, stats.cached);
+  EXPECT_EQ(0U, stats.allocated);
+}
+
+TEST(TestDVDDemuxUtils, Oversized)
+{
+  CDVDDemuxUtils::PoolStats stats;
+  CDVDDemuxUtils::ReleasePool();
+
+  /* payloads bigger than the largest size class go straight back to the heap */
+  DemuxPacket *packet = CDVDDemuxUtils::AllocateDemuxPacket(8 * 1024 * 1024);
+  ASSERT_TRUE(packet != NULL);
+  CDVDDemuxUtils::FreeDemuxPacket(packet);
+
+  CDVDDemuxUtils::GetPoolStats(stats);
+  EXPECT_EQ(1U, stats.oversized);
+  EXPECT_EQ(0U, stats.cached);
+  EXPECT_EQ(0U, stats.outstanding);
+  CDVDDemuxUtils::ReleasePool();
+}
+
+TEST(TestDVDDemuxUtils, AVPacket)
+{
+  DllAvCodec dllAvCodec;
+  ASSERT_TRUE(dllAvCodec.Load());
+
+  /* data that belongs to the demuxer, like a parser hands out */
+  uint8_t data[100];
+  for (unsigned int i = 0; i < sizeof(data); i++)
+    data[i] = i;
+
+  AVPacket pkt;
+  dllAvCodec.av_init_packet(&pkt);
+  pkt.data                 = data;
+  pkt.size                 = sizeof(data);
+  pkt.pts                  = 3000;
+  pkt.dts                  = 2000;
+  pkt.duration             = 40;
+  pkt.convergence_duration = 50;
+  pkt.flags                = AV_PKT_FLAG_KEY;
+  pkt.stream_index         = 2;
+
+  DemuxPacket *packet = CDVDDemuxUtils::AllocateDemuxPacket(&pkt);
+  ASSERT_TRUE(packet != NULL);
+  ASSERT_EQ((int)sizeof(data), packet->iSize);
+  EXPECT_TRUE(packet->pData != data);
+  EXPECT_EQ(0, memcmp(data, packet->pData, sizeof(data)));
+
+  /* the demuxer still reads the timing of the packet */
+  EXPECT_TRUE(pkt.data == NULL);
+  EXPECT_EQ(0, pkt.size);
+  EXPECT_EQ(3000, pkt.pts);
+  EXPECT_EQ(2000, pkt.dts);
+  EXPECT_EQ(40, pkt.duration);
+  EXPECT_EQ(50, pkt.convergence_duration);
+  EXPECT_EQ(AV_PKT_FLAG_KEY, pkt.flags);
+  EXPECT_EQ(2, pkt.stream_index);
+
+  dllAvCodec.av_free_packet(&pkt);
+  CDVDDemuxUtils::FreeDemuxPacket(packet);
+}
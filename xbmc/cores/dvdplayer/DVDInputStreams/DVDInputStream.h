@@ -134,6 +134,14 @@ public:
   virtual bool Open(const char* strFileName, const std::string& content);
   virtual void Close() = 0;
   virtual int Read(BYTE* buf, int buf_size) = 0;
+
+  /*! \brief Borrow the next bytes of the stream without copying them, see XFILE::IFile::GetReadBuffer()
+   \return bytes available at *buf, 0 at the end of the stream or -1 if Read() has to be used instead
+   */
+  virtual int GetReadBuffer(const BYTE** buf, int buf_size) { return -1; }
+
+  /*! \brief Consume size bytes of the data returned by GetReadBuffer() */
+  virtual void ReleaseReadBuffer(int size) {}
   virtual int64_t Seek(int64_t offset, int whence) = 0;
   virtual bool Pause(double dTime) = 0;
   virtual int64_t GetLength() = 0;
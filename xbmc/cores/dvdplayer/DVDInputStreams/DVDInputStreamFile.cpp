@@ -92,6 +92,22 @@ int CDVDInputStreamFile::Read(BYTE* buf, int buf_size)
   return (int)(ret & 0xFFFFFFFF);
 }
 
+int CDVDInputStreamFile::GetReadBuffer(const BYTE** buf, int buf_size)
+{
+  if(!m_pFile) return -1;
+
+  int ret = m_pFile->GetReadBuffer((const void**)buf, buf_size);
+  if( ret == 0 ) m_eof = true;
+
+  return ret;
+}
+
+void CDVDInputStreamFile::ReleaseReadBuffer(int size)
+{
+  if(m_pFile)
+    m_pFile->ReleaseReadBuffer(size);
+}
+
 int64_t CDVDInputStreamFile::Seek(int64_t offset, int whence)
 {
   if(!m_pFile) return -1;
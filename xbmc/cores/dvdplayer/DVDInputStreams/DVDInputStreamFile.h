@@ -30,6 +30,8 @@ public:
   virtual bool Open(const char* strFile, const std::string &content);
   virtual void Close();
   virtual int Read(BYTE* buf, int buf_size);
+  virtual int GetReadBuffer(const BYTE** buf, int buf_size);
+  virtual void ReleaseReadBuffer(int size);
   virtual int64_t Seek(int64_t offset, int whence);
   virtual bool Pause(double dTime) { return false; };
   virtual bool IsEOF();
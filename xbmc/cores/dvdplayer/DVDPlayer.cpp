@@ -1962,6 +1962,9 @@ void CDVDPlayer::OnExit()
     }
     m_pSubtitleDemuxer = NULL;
 
+    // give the memory kept for demux packets back
+    CDVDDemuxUtils::ReleasePool();
+
     // destroy the inputstream
     if (m_pInputStream)
     {
@@ -649,7 +649,7 @@ void CDVDPlayerAudio::HandleSyncError(double duration)
   {
     m_pClock->Discontinuity(clock+error);
     if(m_speed == DVD_PLAYSPEED_NORMAL)
-      CLog::Log(LOGDEBUG, "CDVDPlayerAudio:: Discontinuity - was:%f, should be:%f, error:%f", clock, clock+error, error);
+      CLog::Log(LOGDEBUG | LOGAUDIO, "CDVDPlayerAudio:: Discontinuity - was:%f, should be:%f, error:%f", clock, clock+error, error);
 
     m_errorbuff = 0;
     m_errorcount = 0;
@@ -710,7 +710,7 @@ void CDVDPlayerAudio::HandleSyncError(double duration)
       {
         m_pClock->Discontinuity(clock+error);
         if(m_speed == DVD_PLAYSPEED_NORMAL)
-          CLog::Log(LOGDEBUG, "CDVDPlayerAudio:: Discontinuity - was:%f, should be:%f, error:%f", clock, clock+error, error);
+          CLog::Log(LOGDEBUG | LOGAUDIO, "CDVDPlayerAudio:: Discontinuity - was:%f, should be:%f, error:%f", clock, clock+error, error);
       }
     }
     else if (m_synctype == SYNC_SKIPDUP && m_skipdupcount == 0 && fabs(m_error) > DVD_MSEC_TO_TIME(10))
@@ -722,10 +722,10 @@ void CDVDPlayerAudio::HandleSyncError(double duration)
         m_skipdupcount = (int)(m_error / (duration / 3 * 2));
 
       if (m_skipdupcount > 0)
-        CLog::Log(LOGDEBUG, "CDVDPlayerAudio:: Duplicating %i packet(s) of %.2f ms duration",
+        CLog::Log(LOGDEBUG | LOGAUDIO, "CDVDPlayerAudio:: Duplicating %i packet(s) of %.2f ms duration",
                   m_skipdupcount, duration / DVD_TIME_BASE * 1000.0);
       else if (m_skipdupcount < 0)
-        CLog::Log(LOGDEBUG, "CDVDPlayerAudio:: Skipping %i packet(s) of %.2f ms duration ",
+        CLog::Log(LOGDEBUG | LOGAUDIO, "CDVDPlayerAudio:: Skipping %i packet(s) of %.2f ms duration ",
                   m_skipdupcount * -1,  duration / DVD_TIME_BASE * 1000.0);
     }
     else if (m_synctype == SYNC_RESAMPLE)
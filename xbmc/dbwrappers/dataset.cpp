@@ -365,6 +365,95 @@ const sql_record* const Dataset::get_sql_record()
   return result.records[frecno];
 }
 
+void Dataset::prepare_statement(const string &sql) {
+  prepared_sql = sql;
+  prepared_params.clear();
+}
+
+void Dataset::bind_value(int param, const field_value &value) {
+  if (param < 1) throw DbErrors("Parameter index out of range: %d", param);
+  if ((int)prepared_params.size() < param) prepared_params.resize(param);
+  prepared_params[param-1] = value;
+}
+
+void Dataset::bind_int(int param, int value) {
+  bind_value(param, field_value((int64_t)value));
+}
+
+void Dataset::bind_int64(int param, int64_t value) {
+  bind_value(param, field_value(value));
+}
+
+void Dataset::bind_double(int param, double value) {
+  bind_value(param, field_value(value));
+}
+
+void Dataset::bind_text(int param, const string &value) {
+  field_value v;
+  v.set_asString(value);
+  bind_value(param, v);
+}
+
+void Dataset::bind_null(int param) {
+  field_value v;
+  v.set_isNull();
+  bind_value(param, v);
+}
+
+string Dataset::expand_prepared() {
+  if (db == NULL) throw DbErrors("No Database Connection");
+
+  string expanded;
+  expanded.reserve(prepared_sql.size() + 32 * prepared_params.size());
+  unsigned int param = 0;
+  char quote = 0;
+  for (string::const_iterator i = prepared_sql.begin(); i != prepared_sql.end(); ++i)
+  {
+    // placeholders inside quoted strings are literal question marks
+    if (quote)
+    {
+      if (*i == quote) quote = 0;
+    }
+    else if (*i == '\'' || *i == '"')
+      quote = *i;
+    else if (*i == '?')
+    {
+      if (param >= prepared_params.size())
+        throw DbErrors("Parameter %u is not bound: %s", param + 1, prepared_sql.c_str());
+      const field_value &value = prepared_params[param++];
+      if (value.get_isNull())
+        expanded += "NULL";
+      else if (value.get_fType() == ft_String)
+        expanded += db->prepare("'%s'", value.get_asString().c_str());
+      else if (value.get_fType() == ft_Double)
+      {
+        char number[32];
+        sprintf(number, "%.17g", value.get_asDouble());
+        expanded += number;
+      }
+      else
+        expanded += value.get_asString();
+      continue;
+    }
+    expanded += *i;
+  }
+  return expanded;
+}
+
+bool Dataset::query_prepared() {
+  string sql = expand_prepared();
+  prepared_sql.clear();
+  prepared_params.clear();
+  return query(sql.c_str());
+}
+
+int Dataset::exec_prepared() {
+  string sql = expand_prepared();
+  prepared_sql.clear();
+  prepared_params.clear();
+  return exec(sql);
+}
+
 const field_value Dataset::f_old(const char *f_name) {
   if (ds_state != dsInactive)
     for (int unsigned i=0; i < fields_object->size(); i++) 
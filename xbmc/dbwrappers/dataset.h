@@ -34,6 +34,7 @@
 #include <string>
 #include <map>
 #include <list>
+#include <vector>
 #include "qry_dat.h"
 #include <stdarg.h>
 
@@ -200,6 +201,14 @@ protected:
   bool fbof, feof;
   bool autocommit;		// for transactions
 
+/* prepared statement (see prepare_statement) and the values bound to it */
+  std::string prepared_sql;
+  std::vector<field_value> prepared_params;
+/* store a bound value for the default prepared statement implementation */
+  void bind_value(int param, const field_value &value);
+/* prepared_sql with the bound values substituted for its placeholders */
+  std::string expand_prepared();
+
 
 /* Variables to store SQL statements */
   std::string empty_sql; 		// Executed when result set is empty
@@ -296,6 +305,30 @@ public:
   virtual const void* getExecRes()=0;
 /* as open, but with our query exept Sql */
   virtual bool query(const char *sql) = 0;
+/* as query, but forward-only: rows are fetched from the database as the dataset is
+   navigated with next() instead of being read into memory up front. Only fv(),
+   get_sql_record(), next(), eof() and close() may be used on a streamed result,
+   and num_rows() only reports the rows fetched so far. Datasets that can't stream
+   fall back to query() */
+  virtual bool query_streaming(const std::string &sql) { return query(sql.c_str()); }
+/* Is the current result set streamed (see query_streaming)? */
+  virtual bool is_streaming() const { return false; }
+
+/* --------------- for prepared statements ---------------- */
+/* prepare a statement with '?' placeholders for its parameters. Drivers that can
+   do so compile the statement once and keep it in a per-connection cache keyed
+   by the sql text, others substitute the bound values into the sql when it runs */
+  virtual void prepare_statement(const std::string &sql);
+/* bind a value to the parameter with the given index (starting with 1) */
+  virtual void bind_int(int param, int value);
+  virtual void bind_int64(int param, int64_t value);
+  virtual void bind_double(int param, double value);
+  virtual void bind_text(int param, const std::string &value);
+  virtual void bind_null(int param);
+/* run the prepared statement as query() or exec() would. The statement and its
+   bindings are released afterwards, so prepare_statement() must be called again */
+  virtual bool query_prepared();
+  virtual int  exec_prepared();
 /* Close SQL Query*/
   virtual void close();
 /* This function looks for field Field_name with value equal Field_value
@@ -390,7 +423,7 @@ public:
 
 /* --------------- for fast access ---------------- */
   const result_set& get_result_set() { return result; }
-  const sql_record* const get_sql_record();
+  virtual const sql_record* const get_sql_record();
 
  private:
   void set_ds_state(dsStates new_state) {ds_state = new_state;};	
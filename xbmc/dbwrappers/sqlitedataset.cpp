@@ -28,6 +28,7 @@
 
 #include <iostream>
 #include <string>
+#include <cstring>
 
 #include "sqlitedataset.h"
 #include "utils/log.h"
@@ -79,6 +80,30 @@ int callback(void* res_ptr,int ncol, char** reslt,char** cols)
   return 0;  
 }
 
+static void get_column_value(sqlite3_stmt *stmt, int column, field_value &v)
+{
+  switch (sqlite3_column_type(stmt, column))
+  {
+  case SQLITE_INTEGER:
+    v.set_asInt64(sqlite3_column_int64(stmt, column));
+    break;
+  case SQLITE_FLOAT:
+    v.set_asDouble(sqlite3_column_double(stmt, column));
+    break;
+  case SQLITE_TEXT:
+    v.set_asString((const char *)sqlite3_column_text(stmt, column));
+    break;
+  case SQLITE_BLOB:
+    v.set_asString((const char *)sqlite3_column_text(stmt, column));
+    break;
+  case SQLITE_NULL:
+  default:
+    v.set_asString("");
+    v.set_isNull();
+    break;
+  }
+}
+
 static int busy_callback(void*, int busyCount)
 {
 	Sleep(100);
@@ -92,6 +117,7 @@ SqliteDatabase::SqliteDatabase() {
 
   active = false;	
   _in_transaction = false;		// for transaction
+  stmt_cache_size = 32;
 
   error = "Unknown database error";//S_NO_CONNECTION;
   host = "localhost";
@@ -260,7 +286,14 @@ bool SqliteDatabase::exists(void)
 
 void SqliteDatabase::disconnect(void) {
   if (active == false) return;
-  sqlite3_close(conn);
+  flush_statements();
+  if (sqlite3_close(conn) == SQLITE_BUSY)
+  {
+    // a dataset still holds a statement, a streamed query that wasn't closed.
+    // the connection can't be closed under it, it's leaked instead.
+    for (sqlite3_stmt *stmt = sqlite3_next_stmt(conn, NULL); stmt; stmt = sqlite3_next_stmt(conn, stmt))
+      CLog::Log(LOGERROR, "%s - %s is still in use by \"%s\"", __FUNCTION__, db.c_str(), sqlite3_sql(stmt));
+  }
   active = false;
 }
 
@@ -373,6 +406,69 @@ void SqliteDatabase::rollback_transaction() {
 }
 
 
+// methods for the statement cache
+// ---------------------------------------------
+sqlite3_stmt *SqliteDatabase::acquire_statement(const string &sql) {
+  if (!active) throw DbErrors("No Database Connection");
+
+  map<string, StatementList::iterator>::iterator it = stmt_cache.find(sql);
+  if (it != stmt_cache.end())
+  {
+    sqlite3_stmt *stmt = it->second->second;
+    stmt_lru.erase(it->second);
+    stmt_cache.erase(it);
+    return stmt;
+  }
+
+  sqlite3_stmt *stmt = NULL;
+  #if defined(TARGET_DARWIN)
+  if (setErr(sqlite3_prepare(conn,sql.c_str(),-1,&stmt, NULL),sql.c_str()) != SQLITE_OK)
+  #else
+  if (setErr(sqlite3_prepare_v2(conn,sql.c_str(),-1,&stmt, NULL),sql.c_str()) != SQLITE_OK)
+  #endif
+    throw DbErrors(getErrorMsg());
+  return stmt;
+}
+
+void SqliteDatabase::release_statement(const string &sql, sqlite3_stmt *stmt) {
+  // another dataset may have run the same statement at the same time
+  if (stmt_cache_size == 0 || stmt_cache.find(sql) != stmt_cache.end())
+  {
+    sqlite3_finalize(stmt);
+    return;
+  }
+
+  sqlite3_reset(stmt);
+  sqlite3_clear_bindings(stmt);
+  stmt_lru.push_front(make_pair(sql, stmt));
+  stmt_cache[sql] = stmt_lru.begin();
+
+  while (stmt_lru.size() > stmt_cache_size)
+  {
+    sqlite3_finalize(stmt_lru.back().second);
+    stmt_cache.erase(stmt_lru.back().first);
+    stmt_lru.pop_back();
+  }
+}
+
+void SqliteDatabase::set_statement_cache_size(unsigned int size) {
+  stmt_cache_size = size;
+  while (stmt_lru.size() > stmt_cache_size)
+  {
+    sqlite3_finalize(stmt_lru.back().second);
+    stmt_cache.erase(stmt_lru.back().first);
+    stmt_lru.pop_back();
+  }
+}
+
+void SqliteDatabase::flush_statements() {
+  for (StatementList::iterator i = stmt_lru.begin(); i != stmt_lru.end(); ++i)
+    sqlite3_finalize(i->second);
+  stmt_lru.clear();
+  stmt_cache.clear();
+}
+
+
 // methods for formatting
 // ---------------------------------------------
 string SqliteDatabase::vprepare(const char *format, va_list args)
@@ -408,6 +504,10 @@ string SqliteDatabase::vprepare(const char *format, va_list args)
 //************* SqliteDataset implementation ***************
 
 SqliteDataset::SqliteDataset():Dataset() {
+  stream_stmt = NULL;
+  prepared_stmt = NULL;
+  stream_record_valid = false;
+  stream_rows = 0;
   haveError = false;
   db = NULL;
   errmsg = NULL;
@@ -416,6 +516,10 @@ SqliteDataset::SqliteDataset():Dataset() {
 
 
 SqliteDataset::SqliteDataset(SqliteDatabase *newDb):Dataset(newDb) {
+  stream_stmt = NULL;
+  prepared_stmt = NULL;
+  stream_record_valid = false;
+  stream_rows = 0;
   haveError = false;
   db = newDb;
   errmsg = NULL;
@@ -423,6 +527,8 @@ SqliteDataset::SqliteDataset(SqliteDatabase *newDb):Dataset(newDb) {
 }
 
  SqliteDataset::~SqliteDataset(){
+   if (stream_stmt) sqlite3_finalize(stream_stmt);
+   release_prepared();
    if (errmsg) sqlite3_free(errmsg);
  }
 
@@ -615,6 +721,25 @@ bool SqliteDataset::query(const char *query) {
   #endif
     throw DbErrors(db->getErrorMsg());
 
+  fetch_rows(stmt);
+  if (db->setErr(sqlite3_finalize(stmt),query) == SQLITE_OK)
+  {
+    active = true;
+    ds_state = dsSelect;
+    this->first();
+    return true;
+  }
+  else
+  {
+    throw DbErrors(db->getErrorMsg());
+  }  
+}
+
+bool SqliteDataset::query(const string &q){
+  return query(q.c_str());
+}
+
+int SqliteDataset::fetch_rows(sqlite3_stmt *stmt) {
   // column headers
   const unsigned int numColumns = sqlite3_column_count(stmt);
   result.record_header.resize(numColumns);
@@ -622,51 +747,160 @@ bool SqliteDataset::query(const char *query) {
     result.record_header[i].name = sqlite3_column_name(stmt, i);
 
   // returned rows
-  while (sqlite3_step(stmt) == SQLITE_ROW)
+  int rc;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
   { // have a row of data
     sql_record *res = new sql_record;
     res->resize(numColumns);
     for (unsigned int i = 0; i < numColumns; i++)
-    {
-      field_value &v = res->at(i);
-      switch (sqlite3_column_type(stmt, i))
-      {
-      case SQLITE_INTEGER:
-        v.set_asInt64(sqlite3_column_int64(stmt, i));
-        break;
-      case SQLITE_FLOAT:
-        v.set_asDouble(sqlite3_column_double(stmt, i));
-        break;
-      case SQLITE_TEXT:
-        v.set_asString((const char *)sqlite3_column_text(stmt, i));
-        break;
-      case SQLITE_BLOB:
-        v.set_asString((const char *)sqlite3_column_text(stmt, i));
-        break;
-      case SQLITE_NULL:
-      default:
-        v.set_asString("");
-        v.set_isNull();
-        break;
-      }
-    }
+      get_column_value(stmt, i, res->at(i));
     result.records.push_back(res);
   }
-  if (db->setErr(sqlite3_finalize(stmt),query) == SQLITE_OK)
+  return rc;
+}
+
+void SqliteDataset::prepare_statement(const string &sql) {
+  if(!handle()) throw DbErrors("No Database Connection");
+  release_prepared();
+  prepared_sql = sql;
+  prepared_stmt = static_cast<SqliteDatabase*>(db)->acquire_statement(sql);
+}
+
+void SqliteDataset::release_prepared(bool reuse) {
+  if (!prepared_stmt)
+    return;
+  if (reuse)
+    static_cast<SqliteDatabase*>(db)->release_statement(prepared_sql, prepared_stmt);
+  else
+    sqlite3_finalize(prepared_stmt);
+  prepared_stmt = NULL;
+  prepared_sql.clear();
+}
+
+void SqliteDataset::check_bind(int rc) {
+  if (db->setErr(rc, prepared_sql.c_str()) != SQLITE_OK)
+    throw DbErrors(db->getErrorMsg());
+}
+
+void SqliteDataset::bind_int(int param, int value) {
+  if (!prepared_stmt) throw DbErrors("No prepared statement");
+  check_bind(sqlite3_bind_int(prepared_stmt, param, value));
+}
+
+void SqliteDataset::bind_int64(int param, int64_t value) {
+  if (!prepared_stmt) throw DbErrors("No prepared statement");
+  check_bind(sqlite3_bind_int64(prepared_stmt, param, value));
+}
+
+void SqliteDataset::bind_double(int param, double value) {
+  if (!prepared_stmt) throw DbErrors("No prepared statement");
+  check_bind(sqlite3_bind_double(prepared_stmt, param, value));
+}
+
+void SqliteDataset::bind_text(int param, const string &value) {
+  if (!prepared_stmt) throw DbErrors("No prepared statement");
+  check_bind(sqlite3_bind_text(prepared_stmt, param, value.c_str(), value.size(), SQLITE_TRANSIENT));
+}
+
+void SqliteDataset::bind_null(int param) {
+  if (!prepared_stmt) throw DbErrors("No prepared statement");
+  check_bind(sqlite3_bind_null(prepared_stmt, param));
+}
+
+bool SqliteDataset::query_prepared() {
+  if (!prepared_stmt) throw DbErrors("No prepared statement");
+  if (prepared_sql.find("select") == string::npos && prepared_sql.find("SELECT") == string::npos)
+    throw DbErrors("MUST be select SQL!");
+
+  close();
+
+  if (fetch_rows(prepared_stmt) != SQLITE_DONE)
   {
-    active = true;
-    ds_state = dsSelect;
-    this->first();
-    return true;
+    db->setErr(sqlite3_reset(prepared_stmt), prepared_sql.c_str());
+    release_prepared(false);
+    throw DbErrors(db->getErrorMsg());
   }
-  else
+  release_prepared();
+
+  active = true;
+  ds_state = dsSelect;
+  this->first();
+  return true;
+}
+
+int SqliteDataset::exec_prepared() {
+  if (!prepared_stmt) throw DbErrors("No prepared statement");
+  exec_res.clear();
+
+  int rc;
+  while ((rc = sqlite3_step(prepared_stmt)) == SQLITE_ROW)
+    ;
+  if (rc != SQLITE_DONE)
   {
+    db->setErr(sqlite3_reset(prepared_stmt), prepared_sql.c_str());
+    release_prepared(false);
     throw DbErrors(db->getErrorMsg());
-  }  
+  }
+  release_prepared();
+  return SQLITE_OK;
 }
 
-bool SqliteDataset::query(const string &q){
-  return query(q.c_str());
+bool SqliteDataset::query_streaming(const string &query) {
+  if(!handle()) throw DbErrors("No Database Connection");
+  if (query.find("select") == string::npos && query.find("SELECT") == string::npos)
+    throw DbErrors("MUST be select SQL!");
+
+  close();
+
+  sqlite3_stmt *stmt = NULL;
+  #if defined(TARGET_DARWIN)
+  if (db->setErr(sqlite3_prepare(handle(),query.c_str(),-1,&stmt, NULL),query.c_str()) != SQLITE_OK)
+  #else
+  if (db->setErr(sqlite3_prepare_v2(handle(),query.c_str(),-1,&stmt, NULL),query.c_str()) != SQLITE_OK)
+  #endif
+    throw DbErrors(db->getErrorMsg());
+
+  // column headers, which also make fieldIndex() and friends work
+  const unsigned int numColumns = sqlite3_column_count(stmt);
+  result.record_header.resize(numColumns);
+  fields_object->resize(numColumns);
+  for (unsigned int i = 0; i < numColumns; i++)
+  {
+    result.record_header[i].name = sqlite3_column_name(stmt, i);
+    (*fields_object)[i].props = result.record_header[i];
+  }
+
+  stream_stmt = stmt;
+  stream_rows = 0;
+  active = true;
+  ds_state = dsSelect;
+
+  // position on the first row
+  frecno = -1;
+  stream_step();
+  fbof = true;
+  return true;
+}
+
+void SqliteDataset::stream_step() {
+  stream_record_valid = false;
+  int rc = sqlite3_step(stream_stmt);
+  if (rc == SQLITE_ROW)
+  {
+    frecno++;
+    stream_rows++;
+    fbof = false;
+    feof = false;
+  }
+  else
+  {
+    feof = true;
+    if (rc != SQLITE_DONE)
+    {
+      db->setErr(rc, sqlite3_sql(stream_stmt));
+      throw DbErrors(db->getErrorMsg());
+    }
+  }
 }
 
 void SqliteDataset::open(const string &sql) {
@@ -685,6 +919,14 @@ void SqliteDataset::open() {
 
 
 void SqliteDataset::close() {
+  if (stream_stmt)
+  {
+    sqlite3_finalize(stream_stmt);
+    stream_stmt = NULL;
+  }
+  stream_record.clear();
+  stream_record_valid = false;
+  stream_rows = 0;
   Dataset::close();
   result.clear();
   edit_object->clear();
@@ -705,6 +947,8 @@ void SqliteDataset::cancel() {
 
 
 int SqliteDataset::num_rows() {
+  if (stream_stmt)
+    return stream_rows;
   return result.records.size();
 }
 
@@ -720,21 +964,35 @@ bool SqliteDataset::bof() {
 
 
 void SqliteDataset::first() {
+  if (stream_stmt)
+  {
+    if (frecno > 0)
+      throw DbErrors("Streamed datasets are forward-only");
+    return;
+  }
   Dataset::first();
   this->fill_fields();
 }
 
 void SqliteDataset::last() {
+  if (stream_stmt) throw DbErrors("Streamed datasets are forward-only");
   Dataset::last();
   fill_fields();
 }
 
 void SqliteDataset::prev(void) {
+  if (stream_stmt) throw DbErrors("Streamed datasets are forward-only");
   Dataset::prev();
   fill_fields();
 }
 
 void SqliteDataset::next(void) {
+  if (stream_stmt)
+  {
+    if (!feof)
+      stream_step();
+    return;
+  }
   Dataset::next();
   if (!eof()) 
       fill_fields();
@@ -754,6 +1012,7 @@ void SqliteDataset::free_row(void)
 }
 
 bool SqliteDataset::seek(int pos) {
+  if (stream_stmt) throw DbErrors("Streamed datasets are forward-only");
   if (ds_state == dsSelect) {
     Dataset::seek(pos);
     fill_fields();
@@ -762,6 +1021,54 @@ bool SqliteDataset::seek(int pos) {
   return false;
 }
 
+const field_value SqliteDataset::get_field_value(const char *f_name) {
+  if (!stream_stmt)
+    return Dataset::get_field_value(f_name);
+
+  const char* name=strstr(f_name, ".");
+  if (name) name++;
+  for (unsigned int i=0; i < result.record_header.size(); i++)
+    if (str_compare(result.record_header[i].name.c_str(), f_name)==0 || (name && str_compare(result.record_header[i].name.c_str(), name)==0))
+      return get_field_value(i);
+  throw DbErrors("Field not found: %s",f_name);
+}
+
+const field_value SqliteDataset::get_field_value(int index) {
+  if (!stream_stmt)
+    return Dataset::get_field_value(index);
+
+  if (index < 0 || index >= (int)result.record_header.size())
+    throw DbErrors("Field index not found: %d",index);
+  if (feof)
+    throw DbErrors("No current row");
+
+  if (stream_record_valid)
+    return stream_record[index];
+
+  field_value v;
+  get_column_value(stream_stmt, index, v);
+  return v;
+}
+
+const sql_record* const SqliteDataset::get_sql_record() {
+  if (!stream_stmt)
+    return Dataset::get_sql_record();
+
+  if (feof)
+    return NULL;
+
+  // decode the whole row at most once, it stays valid until the next call to next()
+  if (!stream_record_valid)
+  {
+    const unsigned int numColumns = result.record_header.size();
+    stream_record.resize(numColumns);
+    for (unsigned int i = 0; i < numColumns; i++)
+      get_column_value(stream_stmt, i, stream_record[i]);
+    stream_record_valid = true;
+  }
+  return &stream_record;
+}
+
 int64_t SqliteDataset::lastinsertid()
 {
   if(!handle()) throw DbErrors("No Database Connection");
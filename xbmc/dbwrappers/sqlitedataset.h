@@ -30,6 +30,8 @@
 #define _SQLITEDATASET_H
 
 #include <stdio.h>
+#include <list>
+#include <map>
 #include "dataset.h"
 #include <sqlite3.h>
 
@@ -46,6 +48,15 @@ protected:
   bool _in_transaction;
   int last_err;
 
+/* compiled statements that aren't in use, most recently used first */
+  typedef std::list< std::pair<std::string, sqlite3_stmt*> > StatementList;
+  StatementList stmt_lru;
+  std::map<std::string, StatementList::iterator> stmt_cache;
+  unsigned int stmt_cache_size;
+
+/* finalize all cached statements */
+  void flush_statements();
+
 public:
 /* default constructor */
   SqliteDatabase();
@@ -94,6 +105,14 @@ public:
 
   bool in_transaction() {return _in_transaction;}; 	
 
+/* methods for the statement cache */
+/* take the compiled statement for sql out of the cache, compiling it if it isn't cached */
+  sqlite3_stmt *acquire_statement(const std::string &sql);
+/* hand a statement back to the cache once it has run, evicting the least recently used one when full */
+  void release_statement(const std::string &sql, sqlite3_stmt *stmt);
+/* sets the number of statements kept compiled (0 disables the cache) */
+  void set_statement_cache_size(unsigned int size);
+
 };
 
 
@@ -125,6 +144,25 @@ protected:
 /* Changing field values during dataset navigation */
   virtual void free_row();  // free the memory allocated for the current row
 
+/* statement of a streamed query (see query_streaming), NULL otherwise */
+  sqlite3_stmt *stream_stmt;
+/* record of the current streamed row, decoded on demand by get_sql_record() */
+  sql_record stream_record;
+  bool stream_record_valid;
+  int stream_rows;
+
+/* fetch the next row of a streamed query */
+  void stream_step();
+
+/* statement taken from the connection's cache by prepare_statement() */
+  sqlite3_stmt *prepared_stmt;
+/* reset the prepared statement and give it back to the cache (or finalize it if it failed) */
+  void release_prepared(bool reuse = true);
+  void check_bind(int rc);
+
+/* read the column headers and all rows of stmt into the result set, returns the last sqlite3_step() result */
+  int fetch_rows(sqlite3_stmt *stmt);
+
 public:
 /* constructor */
   SqliteDataset();
@@ -147,6 +185,18 @@ or insert() operations default = false) */
 /* as open, but with our query exept Sql */
   virtual bool query(const char *query);
   virtual bool query(const std::string &query);
+/* forward-only query that reads rows from the live statement as next() is called */
+  virtual bool query_streaming(const std::string &query);
+  virtual bool is_streaming() const { return stream_stmt != NULL; }
+/* prepared statements, compiled once and cached by the connection */
+  virtual void prepare_statement(const std::string &sql);
+  virtual void bind_int(int param, int value);
+  virtual void bind_int64(int param, int64_t value);
+  virtual void bind_double(int param, double value);
+  virtual void bind_text(int param, const std::string &value);
+  virtual void bind_null(int param);
+  virtual bool query_prepared();
+  virtual int  exec_prepared();
 /* func. closes a query */
   virtual void close(void);
 /* Cancel changes, made in insert or edit states of dataset */
@@ -169,6 +219,11 @@ or insert() operations default = false) */
 /* Go to record No (starting with 0) */
   virtual bool seek(int pos=0);
 
+/* streamed results decode the requested column straight from the statement */
+  virtual const field_value get_field_value(const char *f_name);
+  virtual const field_value get_field_value(int index);
+  virtual const sql_record* const get_sql_record();
+
   virtual bool dropIndex(const char *table, const char *index);
 };
 } //namespace
@@ -0,0 +1,252 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "dbwrappers/sqlitedataset.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "utils/StdString.h"
+#include "utils/TimeUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <memory>
+
+using namespace dbiplus;
+
+class TestSqliteDataset : public testing::Test
+{
+protected:
+  TestSqliteDataset()
+  {
+    XFILE::CFile::Delete("special://temp/TestSqliteDataset.db");
+    m_db.setHostName(CSpecialProtocol::TranslatePath("special://temp/").c_str());
+    m_db.setDatabase("TestSqliteDataset.db");
+    m_db.connect(true);
+    m_ds.reset(m_db.CreateDataset());
+
+    m_ds->exec("CREATE TABLE path ( idPath integer primary key, strPath text, strHash text)");
+    m_ds->exec("CREATE UNIQUE INDEX ix_path ON path ( strPath(255) )");
+    m_ds->exec("CREATE TABLE files ( idFile integer primary key, idPath integer, strFileName text)");
+    m_ds->exec("CREATE INDEX ix_files ON files ( idPath, strFileName(255) )");
+  }
+
+  ~TestSqliteDataset()
+  {
+    m_ds.reset();
+    m_db.disconnect();
+    XFILE::CFile::Delete("special://temp/TestSqliteDataset.db");
+  }
+
+  /* the lookups CVideoDatabase::AddFile() does for every file of a scan,
+     either with formatted sql or with prepared statements */
+  int AddFile(const CStdString &path, const CStdString &file, bool prepared)
+  {
+    int idPath = -1;
+    if (prepared)
+    {
+      m_ds->prepare_statement("select idPath from path where strPath=?");
+      m_ds->bind_text(1, path);
+      m_ds->query_prepared();
+    }
+    else
+      m_ds->query(m_db.prepare("select idPath from path where strPath='%s'", path.c_str()).c_str());
+    if (!m_ds->eof())
+      idPath = m_ds->fv("idPath").get_asInt();
+    m_ds->close();
+
+    if (idPath < 0)
+    {
+      if (prepared)
+      {
+        m_ds->prepare_statement("insert into path (idPath, strPath) values (NULL,?)");
+        m_ds->bind_text(1, path);
+        m_ds->exec_prepared();
+      }
+      else
+        m_ds->exec(m_db.prepare("insert into path (idPath, strPath) values (NULL,'%s')", path.c_str()));
+      idPath = (int)m_ds->lastinsertid();
+    }
+
+    int idFile = -1;
+    if (prepared)
+    {
+      m_ds->prepare_statement("select idFile from files where strFileName=? and idPath=?");
+      m_ds->bind_text(1, file);
+      m_ds->bind_int(2, idPath);
+      m_ds->query_prepared();
+    }
+    else
+      m_ds->query(m_db.prepare("select idFile from files where strFileName='%s' and idPath=%i", file.c_str(), idPath).c_str());
+    if (!m_ds->eof())
+      idFile = m_ds->fv("idFile").get_asInt();
+    m_ds->close();
+
+    if (idFile < 0)
+    {
+      if (prepared)
+      {
+        m_ds->prepare_statement("insert into files (idFile, idPath, strFileName) values(NULL, ?, ?)");
+        m_ds->bind_int(1, idPath);
+        m_ds->bind_text(2, file);
+        m_ds->exec_prepared();
+      }
+      else
+        m_ds->exec(m_db.prepare("insert into files (idFile, idPath, strFileName) values(NULL, %i, '%s')", idPath, file.c_str()));
+      idFile = (int)m_ds->lastinsertid();
+    }
+    return idFile;
+  }
+
+  /* scan a synthetic tree of 500 folders with 100 files each, twice, so that
+     both the inserts of a new library and the lookups of a rescan are timed */
+  void ScanTree(const char *name, bool prepared)
+  {
+    int64_t start = CurrentHostCounter();
+    for (int pass = 0; pass < 2; pass++)
+    {
+      for (int folder = 0; folder < 500; folder++)
+      {
+        CStdString path;
+        path.Format("smb://server/share/Movies/Folder %d/", folder);
+        m_db.start_transaction();
+        for (int file = 0; file < 100; file++)
+        {
+          CStdString fileName;
+          fileName.Format("Movie's title %d (%d).mkv", file, folder);
+          EXPECT_LT(0, AddFile(path, fileName, prepared));
+        }
+        m_db.commit_transaction();
+      }
+    }
+    double seconds = (CurrentHostCounter() - start) / (double)CurrentHostFrequency();
+
+    m_ds->query("select count(*) from files");
+    EXPECT_EQ(50000, m_ds->fv(0).get_asInt());
+    m_ds->close();
+    m_ds->exec("delete from files");
+    m_ds->exec("delete from path");
+
+    std::cout << name << " Files/sec: " << testing::PrintToString(seconds > 0 ? 100000 / seconds : 0.0)
+              << " Total (s): " << testing::PrintToString(seconds) << std::endl;
+  }
+
+  SqliteDatabase m_db;
+  std::auto_ptr<Dataset> m_ds;
+};
+
+TEST_F(TestSqliteDataset, PreparedStatement)
+{
+  m_ds->prepare_statement("insert into path (idPath, strPath, strHash) values (?, ?, ?)");
+  m_ds->bind_int64(1, 5000000000LL);
+  m_ds->bind_text(2, "smb://server/It's a \"path\"?/");
+  m_ds->bind_null(3);
+  EXPECT_EQ(SQLITE_OK, m_ds->exec_prepared());
+
+  m_ds->prepare_statement("select idPath, strHash from path where strPath=? and strPath<>'?'");
+  m_ds->bind_text(1, "smb://server/It's a \"path\"?/");
+  EXPECT_TRUE(m_ds->query_prepared());
+  ASSERT_EQ(1, m_ds->num_rows());
+  EXPECT_EQ(5000000000LL, m_ds->fv("idPath").get_asInt64());
+  EXPECT_TRUE(m_ds->fv("strHash").get_isNull());
+  m_ds->close();
+
+  // the statement comes out of the cache the second time, without the old bindings
+  m_ds->prepare_statement("select idPath, strHash from path where strPath=? and strPath<>'?'");
+  m_ds->bind_text(1, "smb://server/another path/");
+  EXPECT_TRUE(m_ds->query_prepared());
+  EXPECT_EQ(0, m_ds->num_rows());
+  m_ds->close();
+}
+
+TEST_F(TestSqliteDataset, PreparedStatementExpanded)
+{
+  // the generic implementation used by datasets without native prepared statements
+  m_ds->Dataset::prepare_statement("insert into path (idPath, strPath, strHash) values (?, ?, ?)");
+  m_ds->Dataset::bind_int(1, 7);
+  m_ds->Dataset::bind_text(2, "smb://server/It's a path?/");
+  m_ds->Dataset::bind_null(3);
+  m_ds->Dataset::exec_prepared();
+
+  m_ds->Dataset::prepare_statement("select idPath, strHash from path where strPath=?");
+  m_ds->Dataset::bind_text(1, "smb://server/It's a path?/");
+  EXPECT_TRUE(m_ds->Dataset::query_prepared());
+  ASSERT_EQ(1, m_ds->num_rows());
+  EXPECT_EQ(7, m_ds->fv("idPath").get_asInt());
+  EXPECT_TRUE(m_ds->fv("strHash").get_isNull());
+  m_ds->close();
+}
+
+TEST_F(TestSqliteDataset, QueryStreaming)
+{
+  m_db.start_transaction();
+  for (int i = 1; i <= 10; i++)
+    m_ds->exec(m_db.prepare("insert into files (idFile, idPath, strFileName) values(%i, %i, 'file%i.mkv')", i, i % 3, i));
+  m_db.commit_transaction();
+
+  ASSERT_TRUE(m_ds->query_streaming("select idFile, strFileName from files where idFile > 2 order by idFile"));
+  EXPECT_TRUE(m_ds->is_streaming());
+
+  /* the rows come one by one, num_rows() counts the ones read so far */
+  int idFile = 3;
+  while (!m_ds->eof())
+  {
+    EXPECT_EQ(idFile - 2, m_ds->num_rows());
+    EXPECT_EQ(idFile, m_ds->fv("idFile").get_asInt());
+    EXPECT_EQ(idFile, m_ds->fv("files.idFile").get_asInt());
+    CStdString fileName;
+    fileName.Format("file%i.mkv", idFile);
+    EXPECT_EQ(fileName, m_ds->fv(1).get_asString());
+
+    const sql_record* const record = m_ds->get_sql_record();
+    ASSERT_TRUE(record != NULL);
+    EXPECT_EQ(idFile, record->at(0).get_asInt());
+    EXPECT_EQ(fileName, record->at(1).get_asString());
+
+    m_ds->next();
+    idFile++;
+  }
+  EXPECT_EQ(11, idFile);
+  EXPECT_EQ(8, m_ds->num_rows());
+  EXPECT_TRUE(m_ds->get_sql_record() == NULL);
+  EXPECT_THROW(m_ds->seek(0), DbErrors);
+  m_ds->close();
+  EXPECT_FALSE(m_ds->is_streaming());
+
+  /* the dataset can be used for other queries afterwards */
+  ASSERT_TRUE(m_ds->query("select count(*) from files"));
+  EXPECT_EQ(10, m_ds->fv(0).get_asInt());
+  m_ds->close();
+
+  /* an empty result is at eof straight away */
+  ASSERT_TRUE(m_ds->query_streaming("select idFile from files where idFile > 100"));
+  EXPECT_TRUE(m_ds->eof());
+  EXPECT_EQ(0, m_ds->num_rows());
+  m_ds->close();
+}
+
+/* a benchmark, run it with --gtest_also_run_disabled_tests */
+TEST_F(TestSqliteDataset, DISABLED_ScanPerformance)
+{
+  ScanTree("Formatted sql:", false);
+  m_db.set_statement_cache_size(0);
+  ScanTree("Prepared, no cache:", true);
+  m_db.set_statement_cache_size(32);
+  ScanTree("Prepared, cached:", true);
+}
@@ -45,7 +45,8 @@ CEpg::CEpg(int iEpgID, const CStdString &strName /* = "" */, const CStdString &s
     m_bUpdatePending(false),
     m_iEpgID(iEpgID),
     m_strName(strName),
-    m_strScraperName(strScraperName)
+    m_strScraperName(strScraperName),
+    m_bIndexDirty(true)
 {
   CPVRChannelPtr empty;
   m_pvrChannel = empty;
@@ -59,7 +60,8 @@ CEpg::CEpg(CPVRChannelPtr channel, bool bLoadedFromDb /* = false */) :
     m_iEpgID(channel->EpgID()),
     m_strName(channel->ChannelName()),
     m_strScraperName(channel->EPGScraper()),
-    m_pvrChannel(channel)
+    m_pvrChannel(channel),
+    m_bIndexDirty(true)
 {
 }
 
@@ -68,7 +70,8 @@ CEpg::CEpg(void) :
     m_bTagsChanged(false),
     m_bLoaded(false),
     m_bUpdatePending(false),
-    m_iEpgID(0)
+    m_iEpgID(0),
+    m_bIndexDirty(true)
 {
   CPVRChannelPtr empty;
   m_pvrChannel = empty;
@@ -88,12 +91,13 @@ CEpg &CEpg::operator =(const CEpg &right)
   m_iEpgID            = right.m_iEpgID;
   m_strName           = right.m_strName;
   m_strScraperName    = right.m_strScraperName;
-  m_nowActiveStart    = right.m_nowActiveStart;
   m_lastScanTime      = right.m_lastScanTime;
   m_pvrChannel        = right.m_pvrChannel;
 
   for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = right.m_tags.begin(); it != right.m_tags.end(); it++)
     m_tags.insert(make_pair(it->first, new CEpgInfoTag(*it->second)));
+  InvalidateIndex();
+  ResetNowActive(m_nowActiveTag);
 
   return *this;
 }
@@ -152,6 +156,8 @@ void CEpg::Clear(void)
 {
   CSingleLock lock(m_critSection);
   m_tags.clear();
+  InvalidateIndex();
+  ResetNowActive(m_nowActiveTag);
 }
 
 void CEpg::Cleanup(void)
@@ -168,50 +174,52 @@ void CEpg::Cleanup(const CDateTime &Time)
   {
     if (it->second->EndAsUTC() < Time)
     {
-      if (m_nowActiveStart == it->first)
-        m_nowActiveStart.SetValid(false);
+      ResetNowActive(it->second);
 
       it->second->ClearTimer();
       m_tags.erase(it++);
+      InvalidateIndex();
     }
   }
 }
 
 bool CEpg::InfoTagNow(CEpgInfoTag &tag, bool bUpdateIfNeeded /* = true */)
 {
-  CSingleLock lock(m_critSection);
-  if (m_nowActiveStart.IsValid())
+  CEpgInfoTagPtr nowActiveTag;
   {
-    map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.find(m_nowActiveStart);
-    if (it != m_tags.end() && it->second->IsActive())
-    {
-      tag = *it->second;
-      return true;
-    }
+    CSharedLock lock(m_indexSection);
+    nowActiveTag = m_nowActiveTag;
+  }
+
+  if (nowActiveTag && nowActiveTag->IsActive())
+  {
+    tag = *nowActiveTag;
+    return true;
   }
 
   if (bUpdateIfNeeded)
   {
-    CDateTime lastActiveTag;
+    CEpgTagIndexPtr index = GetIndex();
+    time_t now;
+    CDateTime::GetUTCDateTime().GetAsTime(now);
 
-    /* one of the first items will always match if the list is sorted */
-    for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); it++)
+    int iActive = index->Active(now);
+    if (iActive >= 0)
     {
-      if (it->second->IsActive())
+      nowActiveTag = index->Tag(iActive);
       {
-        m_nowActiveStart = it->first;
-        tag = *it->second;
-        return true;
+        CExclusiveLock lock(m_indexSection);
+        m_nowActiveTag = nowActiveTag;
       }
-      else if (it->second->WasActive())
-        lastActiveTag = it->first;
+      tag = *nowActiveTag;
+      return true;
     }
 
     /* there might be a gap between the last and next event. just return the last if found */
-    map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.find(lastActiveTag);
-    if (it != m_tags.end())
+    int iLastActive = index->LastEndedBefore(now);
+    if (iLastActive >= 0)
     {
-      tag = *it->second;
+      tag = *index->Tag(iLastActive);
       return true;
     }
   }
@@ -221,28 +229,20 @@ bool CEpg::InfoTagNow(CEpgInfoTag &tag, bool bUpdateIfNeeded /* = true */)
 
 bool CEpg::InfoTagNext(CEpgInfoTag &tag)
 {
+  time_t after;
   CEpgInfoTag nowTag;
   if (InfoTagNow(nowTag))
+    nowTag.StartAsUTC().GetAsTime(after);
+  else
+    CDateTime::GetUTCDateTime().GetAsTime(after);
+
+  /* the event following the current one, or the first event that is in the future */
+  CEpgTagIndexPtr index = GetIndex();
+  int iNext = index->FirstStartingAfter(after);
+  if (iNext >= 0)
   {
-    CSingleLock lock(m_critSection);
-    map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.find(nowTag.StartAsUTC());
-    if (it != m_tags.end() && ++it != m_tags.end())
-    {
-      tag = *it->second;
-      return true;
-    }
-  }
-  else if (Size() > 0)
-  {
-    /* return the first event that is in the future */
-    for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); it++)
-    {
-      if (it->second->InTheFuture())
-      {
-        tag = *it->second;
-        return true;
-      }
-    }
+    tag = *index->Tag(iNext);
+    return true;
   }
 
   return false;
@@ -281,12 +281,14 @@ CEpgInfoTagPtr CEpg::GetTag(const CDateTime &StartTime) const
 
 CEpgInfoTagPtr CEpg::GetTagBetween(const CDateTime &beginTime, const CDateTime &endTime) const
 {
-  CSingleLock lock(m_critSection);
-  for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); it++)
-  {
-    if (it->second->StartAsUTC() >= beginTime && it->second->EndAsUTC() <= endTime)
-      return it->second;
-  }
+  time_t begin, end;
+  beginTime.GetAsTime(begin);
+  endTime.GetAsTime(end);
+
+  CEpgTagIndexPtr index = GetIndex();
+  int iFound = index->FirstWithin(begin, end);
+  if (iFound >= 0)
+    return index->Tag(iFound);
 
   CEpgInfoTagPtr retVal;
   return retVal;
@@ -294,15 +296,55 @@ CEpgInfoTagPtr CEpg::GetTagBetween(const CDateTime &beginTime, const CDateTime &
 
 CEpgInfoTagPtr CEpg::GetTagAround(const CDateTime &time) const
 {
+  time_t around;
+  time.GetAsTime(around);
+
+  CEpgTagIndexPtr index = GetIndex();
+  int iFound = index->Around(around);
+  if (iFound >= 0)
+    return index->Tag(iFound);
+
+  CEpgInfoTagPtr retVal;
+  return retVal;
+}
+
+int CEpg::GetTagsBetween(const CDateTime &beginTime, const CDateTime &endTime, vector<CEpgInfoTagPtr> &tags) const
+{
+  time_t begin, end;
+  beginTime.GetAsTime(begin);
+  endTime.GetAsTime(end);
+
+  return GetIndex()->Overlapping(begin, end, tags);
+}
+
+CEpgTagIndexPtr CEpg::GetIndex(void) const
+{
+  CSingleTryLock tryLock((CCriticalSection &)m_critSection);
+  if (!tryLock.IsOwner())
+  {
+    /* this table is being updated. use the last index rather than waiting for the update to finish */
+    CSharedLock lock(m_indexSection);
+    if (m_index)
+      return m_index;
+  }
+
   CSingleLock lock(m_critSection);
-  for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); it++)
+  if (m_bIndexDirty || !m_index)
   {
-    if ((it->second->StartAsUTC() <= time) && (it->second->EndAsUTC() >= time))
-      return it->second;
+    CEpgTagIndexPtr index(new CEpgTagIndex(m_tags));
+    CExclusiveLock indexLock(m_indexSection);
+    m_index = index;
+    m_bIndexDirty = false;
   }
 
-  CEpgInfoTagPtr retVal;
-  return retVal;
+  return m_index;
+}
+
+void CEpg::ResetNowActive(const CEpgInfoTagPtr &tag)
+{
+  CExclusiveLock lock(m_indexSection);
+  if (m_nowActiveTag == tag)
+    m_nowActiveTag.reset();
 }
 
 void CEpg::AddEntry(const CEpgInfoTag &tag)
@@ -317,6 +359,7 @@ void CEpg::AddEntry(const CEpgInfoTag &tag)
     newTag = CEpgInfoTagPtr(new CEpgInfoTag(this, m_pvrChannel, m_strName, m_pvrChannel ? m_pvrChannel->IconPath() : StringUtils::EmptyString));
     m_tags.insert(make_pair(tag.StartAsUTC(), newTag));
   }
+  InvalidateIndex();
 
   if (newTag)
   {
@@ -351,6 +394,7 @@ bool CEpg::UpdateEntry(const CEpgInfoTag &tag, bool bUpdateDatabase /* = false *
     infoTag->Update(tag, bNewTag);
     infoTag->m_epg          = this;
     infoTag->m_pvrChannel   = m_pvrChannel;
+    InvalidateIndex();
   }
 
   if (bUpdateDatabase)
@@ -396,6 +440,7 @@ bool CEpg::Load(void)
 bool CEpg::UpdateEntries(const CEpg &epg, bool bStoreInDb /* = true */)
 {
   bool bReturn(false);
+  bool bPersisted(true);
   CEpgDatabase *database = g_EpgContainer.GetDatabase();
 
   if (epg.m_tags.size() > 0)
@@ -417,7 +462,7 @@ bool CEpg::UpdateEntries(const CEpg &epg, bool bStoreInDb /* = true */)
 #endif
       /* copy over tags */
       for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = epg.m_tags.begin(); it != epg.m_tags.end(); it++)
-        UpdateEntry(*it->second, bStoreInDb, false);
+        UpdateEntry(*it->second, false, false);
 
 #if EPG_DEBUGGING
       CLog::Log(LOGDEBUG, "%s - %zu entries in memory after merging and before fixing", __FUNCTION__, m_tags.size());
@@ -427,6 +472,10 @@ bool CEpg::UpdateEntries(const CEpg &epg, bool bStoreInDb /* = true */)
 #if EPG_DEBUGGING
       CLog::Log(LOGDEBUG, "%s - %zu entries in memory after fixing", __FUNCTION__, m_tags.size());
 #endif
+      /* only write the tags that were added or changed */
+      if (bStoreInDb)
+        bPersisted = PersistChangedTags();
+
       /* update the last scan time of this table */
       m_lastScanTime = CDateTime::GetCurrentDateTime().GetAsUTCDateTime();
 
@@ -438,6 +487,7 @@ bool CEpg::UpdateEntries(const CEpg &epg, bool bStoreInDb /* = true */)
       bReturn = database->CommitTransaction();
       if (bReturn)
         Persist(true);
+      bReturn &= bPersisted;
     }
     else
       bReturn = true;
@@ -688,8 +738,7 @@ bool CEpg::FixOverlappingEvents(bool bUpdateDb /* = false */)
       if (bUpdateDb)
         bReturn &= database->Delete(*currentTag);
 
-      if (m_nowActiveStart == it->first)
-        m_nowActiveStart.SetValid(false);
+      ResetNowActive(currentTag);
 
       it->second->ClearTimer();
       m_tags.erase(it++);
@@ -697,8 +746,6 @@ bool CEpg::FixOverlappingEvents(bool bUpdateDb /* = false */)
     else if (previousTag->EndAsUTC() > currentTag->StartAsUTC())
     {
       currentTag->SetStartFromUTC(previousTag->EndAsUTC());
-      if (bUpdateDb)
-        bReturn &= currentTag->Persist();
 
       previousTag = it->second;
     }
@@ -713,15 +760,6 @@ bool CEpg::FixOverlappingEvents(bool bUpdateDb /* = false */)
       currentTag->SetStartFromUTC(newTime);
       previousTag->SetEndFromUTC(newTime);
 
-      if (m_nowActiveStart == it->first)
-        m_nowActiveStart = currentTag->StartAsUTC();
-
-      if (bUpdateDb)
-      {
-        bReturn &= currentTag->Persist();
-        bReturn &= previousTag->Persist();
-      }
-
       previousTag = it->second;
     }
     else
@@ -729,6 +767,7 @@ bool CEpg::FixOverlappingEvents(bool bUpdateDb /* = false */)
       previousTag = it->second;
     }
   }
+  InvalidateIndex();
 
   return bReturn;
 }
@@ -863,6 +902,59 @@ bool CEpg::UpdateEntry(const EPG_TAG *data, bool bUpdateDatabase /* = false */)
   return UpdateEntry(tag, bUpdateDatabase);
 }
 
+bool CEpg::UpdateEntries(const EPG_TAG *data, unsigned int iEntries, bool bUpdateDatabase /* = false */)
+{
+  bool bReturn(true);
+  CEpgDatabase *database = NULL;
+  if (bUpdateDatabase)
+  {
+    database = g_EpgContainer.GetDatabase();
+    if (!database || !database->IsOpen())
+    {
+      CLog::Log(LOGERROR, "%s - could not open the database", __FUNCTION__);
+      return false;
+    }
+    database->BeginTransaction();
+  }
+
+  {
+    CSingleLock lock(m_critSection);
+    for (unsigned int iEntryPtr = 0; iEntryPtr < iEntries; iEntryPtr++)
+    {
+      CEpgInfoTag tag(data[iEntryPtr]);
+      bReturn &= UpdateEntry(tag, false, false);
+    }
+
+    if (bUpdateDatabase)
+      bReturn &= PersistChangedTags();
+  }
+
+  if (bUpdateDatabase)
+    bReturn &= database->CommitTransaction();
+
+  return bReturn;
+}
+
+bool CEpg::PersistChangedTags(void)
+{
+  CEpgDatabase *database = g_EpgContainer.GetDatabase();
+  if (!database || !database->IsOpen())
+  {
+    CLog::Log(LOGERROR, "%s - could not open the database", __FUNCTION__);
+    return false;
+  }
+
+  vector<CEpgInfoTagPtr> changedTags;
+  CSingleLock lock(m_critSection);
+  for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); it++)
+  {
+    if (it->second->m_bChanged)
+      changedTags.push_back(it->second);
+  }
+
+  return changedTags.empty() || database->Persist(changedTags);
+}
+
 bool CEpg::IsRadio(void) const
 {
   CPVRChannelPtr channel = Channel();
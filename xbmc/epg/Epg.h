@@ -23,9 +23,11 @@
 #include "FileItem.h"
 
 #include "threads/CriticalSection.h"
+#include "threads/SharedSection.h"
 
 #include "EpgInfoTag.h"
 #include "EpgSearchFilter.h"
+#include "EpgTagIndex.h"
 #include "utils/Observer.h"
 #include "pvr/channels/PVRChannel.h"
 
@@ -198,6 +200,15 @@ namespace EPG
      */
     CEpgInfoTagPtr GetTagBetween(const CDateTime &beginTime, const CDateTime &endTime) const;
 
+    /*!
+     * @brief Get all events that are on some time between the given begin and end time.
+     * @param beginTime The start of the range in UTC.
+     * @param endTime The end of the range in UTC.
+     * @param tags The events that were found, ordered by start time.
+     * @return The amount of events that were found.
+     */
+    int GetTagsBetween(const CDateTime &beginTime, const CDateTime &endTime, std::vector<CEpgInfoTagPtr> &tags) const;
+
     /*!
      * @brief Get the infotag with the given ID.
      *
@@ -289,6 +300,15 @@ namespace EPG
      */
     bool UpdateEntry(const EPG_TAG *data, bool bUpdateDatabase = false);
 
+    /*!
+     * @brief Update a list of entries in this EPG, taking the lock once for all of them.
+     * @param data The tags to update.
+     * @param iEntries The number of tags.
+     * @param bUpdateDatabase If set to true, the entries that changed will be persisted in the database.
+     * @return True if they were updated successfully, false otherwise.
+     */
+    bool UpdateEntries(const EPG_TAG *data, unsigned int iEntries, bool bUpdateDatabase = false);
+
     /*!
      * @return True if this is an EPG table for a radio channel, false otherwise.
      */
@@ -316,9 +336,15 @@ namespace EPG
      */
     bool PersistTags(void) const;
 
+    /*!
+     * @brief Persist all tags in this container that changed since they were last persisted.
+     * @return True if all changed tags were persisted, false otherwise.
+     */
+    bool PersistChangedTags(void);
+
     /*!
      * @brief Fix overlapping events from the tables.
-     * @param bUpdateDb If set to yes, any changes to tags during fixing will be persisted to database
+     * @param bUpdateDb If set to yes, tags that are removed during fixing will be deleted from the database. Tags that are changed are left to PersistChangedTags().
      * @return True if anything changed, false otherwise.
      */
     bool FixOverlappingEvents(bool bUpdateDb = false);
@@ -347,6 +373,27 @@ namespace EPG
 
     bool IsRemovableTag(const EPG::CEpgInfoTag &tag) const;
 
+    /*!
+     * @brief Get the index of the tags in this table.
+     *
+     * The index is rebuilt when the tags changed, unless the table is being updated at the same time.
+     * The previous index is returned in that case, so readers never wait for an update to finish.
+     *
+     * @return The index.
+     */
+    CEpgTagIndexPtr GetIndex(void) const;
+
+    /*!
+     * @brief Rebuild the index of the tags when it's requested next. Must be called with m_critSection held.
+     */
+    void InvalidateIndex(void) { m_bIndexDirty = true; }
+
+    /*!
+     * @brief Forget the currently active tag if it's the given one.
+     * @param tag The tag that is removed from this table.
+     */
+    void ResetNowActive(const CEpgInfoTagPtr &tag);
+
     std::map<CDateTime, CEpgInfoTagPtr> m_tags;
     bool                                m_bChanged;        /*!< true if anything changed that needs to be persisted, false otherwise */
     bool                                m_bTagsChanged;    /*!< true when any tags are changed and not persisted, false otherwise */
@@ -355,12 +402,16 @@ namespace EPG
     int                                 m_iEpgID;          /*!< the database ID of this table */
     CStdString                          m_strName;         /*!< the name of this table */
     CStdString                          m_strScraperName;  /*!< the name of the scraper to use */
-    CDateTime                           m_nowActiveStart;  /*!< the start time of the tag that is currently active */
+    CEpgInfoTagPtr                      m_nowActiveTag;    /*!< the tag that is currently active */
 
     CDateTime                           m_lastScanTime;    /*!< the last time the EPG has been updated */
 
     PVR::CPVRChannelPtr                 m_pvrChannel;      /*!< the channel this EPG belongs to */
 
     CCriticalSection                    m_critSection;     /*!< critical section for changes in this table */
+
+    mutable CEpgTagIndexPtr             m_index;           /*!< the index of the tags, rebuilt after they changed */
+    mutable bool                        m_bIndexDirty;     /*!< true when the tags changed since the index was built */
+    CSharedSection                      m_indexSection;    /*!< guards the index and the currently active tag */
   };
 }
@@ -21,6 +21,7 @@
 #include "dbwrappers/dataset.h"
 #include "settings/AdvancedSettings.h"
 #include "settings/VideoSettings.h"
+#include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "addons/include/xbmc_pvr_types.h"
 
@@ -370,54 +371,105 @@ int CEpgDatabase::Persist(const CEpgInfoTag &tag, bool bSingleUpdate /* = true *
     return iReturn;
   }
 
+  if (NULL == m_pDB.get() || NULL == m_pDS.get())
+    return iReturn;
+
+  try
+  {
+    PrepareTag(tag, tag.BroadcastId());
+    m_pDS->exec_prepared();
+    iReturn = (int) m_pDS->lastinsertid();
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s - failed to persist tag '%s'", __FUNCTION__, tag.Title(true).c_str());
+  }
+
+  return iReturn;
+}
+
+bool CEpgDatabase::Persist(const vector<CEpgInfoTagPtr> &tags)
+{
+  if (NULL == m_pDB.get() || NULL == m_pDS.get())
+    return false;
+
+  bool bReturn(true);
+  for (vector<CEpgInfoTagPtr>::const_iterator it = tags.begin(); it != tags.end(); it++)
+  {
+    CEpgInfoTag &tag = **it;
+    CSingleLock lock(tag.m_critSection);
+    if (!tag.m_bChanged)
+      continue;
+
+    if (tag.EpgID() <= 0)
+    {
+      CLog::Log(LOGERROR, "%s - tag '%s' does not have a valid table", __FUNCTION__, tag.Title(true).c_str());
+      bReturn = false;
+      continue;
+    }
+
+    try
+    {
+      PrepareTag(tag, tag.m_iBroadcastId);
+      m_pDS->exec_prepared();
+
+      tag.m_iBroadcastId = (int) m_pDS->lastinsertid();
+      tag.m_bChanged     = false;
+    }
+    catch (...)
+    {
+      CLog::Log(LOGERROR, "%s - failed to persist tag '%s'", __FUNCTION__, tag.Title(true).c_str());
+      bReturn = false;
+    }
+  }
+
+  return bReturn;
+}
+
+void CEpgDatabase::PrepareTag(const CEpgInfoTag &tag, int iBroadcastId)
+{
   time_t iStartTime, iEndTime, iFirstAired;
   tag.StartAsUTC().GetAsTime(iStartTime);
   tag.EndAsUTC().GetAsTime(iEndTime);
   tag.FirstAiredAsUTC().GetAsTime(iFirstAired);
 
-  int iBroadcastId = tag.BroadcastId();
-  CStdString strQuery;
-  
   /* Only store the genre string when needed */
   CStdString strGenre = (tag.GenreType() == EPG_GENRE_USE_STRING) ? StringUtils::Join(tag.Genre(), g_advancedSettings.m_videoItemSeparator) : "";
 
   if (iBroadcastId < 0)
   {
-    strQuery = FormatSQL("INSERT INTO epgtags (idEpg, iStartTime, "
+    m_pDS->prepare_statement("INSERT INTO epgtags (idEpg, iStartTime, "
         "iEndTime, sTitle, sPlotOutline, sPlot, iGenreType, iGenreSubType, sGenre, "
         "iFirstAired, iParentalRating, iStarRating, bNotify, iSeriesId, "
         "iEpisodeId, iEpisodePart, sEpisodeName, iBroadcastUid) "
-        "VALUES (%u, %u, %u, '%s', '%s', '%s', %i, %i, '%s', %u, %i, %i, %i, %i, %i, %i, '%s', %i);",
-        tag.EpgID(), iStartTime, iEndTime,
-        tag.Title(true).c_str(), tag.PlotOutline(true).c_str(), tag.Plot(true).c_str(), tag.GenreType(), tag.GenreSubType(), strGenre.c_str(),
-        iFirstAired, tag.ParentalRating(), tag.StarRating(), tag.Notify(),
-        tag.SeriesNum(), tag.EpisodeNum(), tag.EpisodePart(), tag.EpisodeName().c_str(),
-        tag.UniqueBroadcastID());
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
   }
   else
   {
-    strQuery = FormatSQL("REPLACE INTO epgtags (idEpg, iStartTime, "
+    m_pDS->prepare_statement("REPLACE INTO epgtags (idEpg, iStartTime, "
         "iEndTime, sTitle, sPlotOutline, sPlot, iGenreType, iGenreSubType, sGenre, "
         "iFirstAired, iParentalRating, iStarRating, bNotify, iSeriesId, "
         "iEpisodeId, iEpisodePart, sEpisodeName, iBroadcastUid, idBroadcast) "
-        "VALUES (%u, %u, %u, '%s', '%s', '%s', %i, %i, '%s', %u, %i, %i, %i, %i, %i, %i, '%s', %i, %i);",
-        tag.EpgID(), iStartTime, iEndTime,
-        tag.Title(true).c_str(), tag.PlotOutline(true).c_str(), tag.Plot(true).c_str(), tag.GenreType(), tag.GenreSubType(), strGenre.c_str(),
-        iFirstAired, tag.ParentalRating(), tag.StarRating(), tag.Notify(),
-        tag.SeriesNum(), tag.EpisodeNum(), tag.EpisodePart(), tag.EpisodeName().c_str(),
-        tag.UniqueBroadcastID(), iBroadcastId);
-  }
-
-  if (bSingleUpdate)
-  {
-    if (ExecuteQuery(strQuery))
-      iReturn = (int) m_pDS->lastinsertid();
-  }
-  else
-  {
-    QueueInsertQuery(strQuery);
-    iReturn = 0;
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+    m_pDS->bind_int(19, iBroadcastId);
   }
 
-  return iReturn;
+  m_pDS->bind_int(1, tag.EpgID());
+  m_pDS->bind_int64(2, iStartTime);
+  m_pDS->bind_int64(3, iEndTime);
+  m_pDS->bind_text(4, tag.Title(true));
+  m_pDS->bind_text(5, tag.PlotOutline(true));
+  m_pDS->bind_text(6, tag.Plot(true));
+  m_pDS->bind_int(7, tag.GenreType());
+  m_pDS->bind_int(8, tag.GenreSubType());
+  m_pDS->bind_text(9, strGenre);
+  m_pDS->bind_int64(10, iFirstAired);
+  m_pDS->bind_int(11, tag.ParentalRating());
+  m_pDS->bind_int(12, tag.StarRating());
+  m_pDS->bind_int(13, tag.Notify() ? 1 : 0);
+  m_pDS->bind_int(14, tag.SeriesNum());
+  m_pDS->bind_int(15, tag.EpisodeNum());
+  m_pDS->bind_int(16, tag.EpisodePart());
+  m_pDS->bind_text(17, tag.EpisodeName());
+  m_pDS->bind_int(18, tag.UniqueBroadcastID());
 }
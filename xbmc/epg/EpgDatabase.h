@@ -21,6 +21,9 @@
 
 #include "dbwrappers/Database.h"
 #include "XBDateTime.h"
+#include "EpgInfoTag.h"
+
+#include <vector>
 
 namespace EPG
 {
@@ -134,12 +137,27 @@ namespace EPG
 
     /*!
      * @brief Persist an infotag.
+     *
+     * The tag is written right away, through the same prepared statement as Persist(tags).
+     * Use that one to persist many tags within a transaction.
+     *
      * @param tag The tag to persist.
-     * @param bSingleUpdate If true, this is a single update and the query will be executed immediately.
-     * @return The database ID of this entry or 0 if bSingleUpdate is false and the query was queued.
+     * @param bSingleUpdate Kept for compatibility, the query is always executed immediately.
+     * @return The database ID of this entry or -1 if it could not be persisted.
      */
     virtual int Persist(const CEpgInfoTag &tag, bool bSingleUpdate = true);
 
+    /*!
+     * @brief Persist the given infotags that changed since they were last persisted.
+     *
+     * The rows are written through prepared statements, so the queries are only compiled once.
+     * Call this within a transaction when persisting more than a few tags.
+     *
+     * @param tags The tags to persist.
+     * @return True if all changed tags were persisted, false otherwise.
+     */
+    virtual bool Persist(const std::vector<CEpgInfoTagPtr> &tags);
+
     //@}
 
   protected:
@@ -155,5 +173,12 @@ namespace EPG
      * @return True if it was updated successfully, false otherwise.
      */
     virtual bool UpdateOldVersion(int version);
+
+    /*!
+     * @brief Prepare the statement that writes a tag and bind its values.
+     * @param tag The tag to write.
+     * @param iBroadcastId The database ID of the tag, a new row is inserted if it's negative.
+     */
+    void PrepareTag(const CEpgInfoTag &tag, int iBroadcastId);
   };
 }
@@ -0,0 +1,123 @@
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EpgTagIndex.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace EPG;
+
+CEpgTagIndex::CEpgTagIndex(const map<CDateTime, CEpgInfoTagPtr> &tags)
+{
+  m_starts.reserve(tags.size());
+  m_ends.reserve(tags.size());
+  m_maxEnds.reserve(tags.size());
+  m_tags.reserve(tags.size());
+
+  time_t maxEnd = 0;
+  for (map<CDateTime, CEpgInfoTagPtr>::const_iterator it = tags.begin(); it != tags.end(); it++)
+  {
+    time_t start, end;
+    it->second->StartAsUTC().GetAsTime(start);
+    it->second->EndAsUTC().GetAsTime(end);
+
+    maxEnd = m_tags.empty() ? end : std::max(maxEnd, end);
+    m_starts.push_back(start);
+    m_ends.push_back(end);
+    m_maxEnds.push_back(maxEnd);
+    m_tags.push_back(it->second);
+  }
+}
+
+int CEpgTagIndex::UpperBound(time_t time) const
+{
+  return upper_bound(m_starts.begin(), m_starts.end(), time) - m_starts.begin();
+}
+
+int CEpgTagIndex::FirstEndingFrom(time_t time) const
+{
+  /* the latest end times only ever grow, so no tag before this one can end at or after the given time */
+  return lower_bound(m_maxEnds.begin(), m_maxEnds.end(), time) - m_maxEnds.begin();
+}
+
+int CEpgTagIndex::Around(time_t time) const
+{
+  int iLast = UpperBound(time);
+  for (int iPtr = FirstEndingFrom(time); iPtr < iLast; iPtr++)
+  {
+    if (m_ends[iPtr] >= time)
+      return iPtr;
+  }
+  return -1;
+}
+
+int CEpgTagIndex::Active(time_t time) const
+{
+  int iLast = UpperBound(time);
+  for (int iPtr = FirstEndingFrom(time + 1); iPtr < iLast; iPtr++)
+  {
+    if (m_ends[iPtr] > time)
+      return iPtr;
+  }
+  return -1;
+}
+
+int CEpgTagIndex::LastEndedBefore(time_t time) const
+{
+  for (int iPtr = UpperBound(time) - 1; iPtr >= 0; iPtr--)
+  {
+    if (m_ends[iPtr] < time)
+      return iPtr;
+  }
+  return -1;
+}
+
+int CEpgTagIndex::FirstStartingAfter(time_t time) const
+{
+  int iPtr = UpperBound(time);
+  return iPtr < Size() ? iPtr : -1;
+}
+
+int CEpgTagIndex::FirstWithin(time_t begin, time_t end) const
+{
+  int iLast = UpperBound(end);
+  for (int iPtr = lower_bound(m_starts.begin(), m_starts.end(), begin) - m_starts.begin(); iPtr < iLast; iPtr++)
+  {
+    if (m_ends[iPtr] <= end)
+      return iPtr;
+  }
+  return -1;
+}
+
+int CEpgTagIndex::Overlapping(time_t begin, time_t end, vector<CEpgInfoTagPtr> &tags) const
+{
+  int iFound = 0;
+  int iLast = lower_bound(m_starts.begin(), m_starts.end(), end) - m_starts.begin();
+  for (int iPtr = FirstEndingFrom(begin + 1); iPtr < iLast; iPtr++)
+  {
+    if (m_ends[iPtr] > begin)
+    {
+      tags.push_back(m_tags[iPtr]);
+      iFound++;
+    }
+  }
+  return iFound;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "EpgInfoTag.h"
+
+#include <map>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+namespace EPG
+{
+  class CEpgTagIndex;
+  typedef boost::shared_ptr<const CEpgTagIndex> CEpgTagIndexPtr;
+
+  /** an immutable, time sorted index of the tags of an EPG table */
+  class CEpgTagIndex
+  {
+  public:
+    /*!
+     * @brief Index a snapshot of the given tags.
+     * @param tags The tags of a table, sorted by start time.
+     */
+    CEpgTagIndex(const std::map<CDateTime, CEpgInfoTagPtr> &tags);
+
+    /*!
+     * @return The number of tags in this index.
+     */
+    int Size(void) const { return (int)m_tags.size(); }
+
+    /*!
+     * @brief Get a tag from this index.
+     * @param iIndex The position of the tag, ordered by start time.
+     * @return The tag.
+     */
+    const CEpgInfoTagPtr &Tag(int iIndex) const { return m_tags[iIndex]; }
+
+    time_t Start(int iIndex) const { return m_starts[iIndex]; }
+    time_t End(int iIndex) const { return m_ends[iIndex]; }
+
+    /*!
+     * @brief Find the first tag that starts at or before and ends at or after the given time.
+     * @param time The time in UTC.
+     * @return The position of the tag or -1 if there is a gap at the given time.
+     */
+    int Around(time_t time) const;
+
+    /*!
+     * @brief Find the first tag that is active at the given time, i.e. ends after it.
+     * @param time The time in UTC.
+     * @return The position of the tag or -1 if there is a gap at the given time.
+     */
+    int Active(time_t time) const;
+
+    /*!
+     * @brief Find the last tag that ended before the given time.
+     * @param time The time in UTC.
+     * @return The position of the tag or -1 if none ended yet.
+     */
+    int LastEndedBefore(time_t time) const;
+
+    /*!
+     * @brief Find the first tag that starts after the given time.
+     * @param time The time in UTC.
+     * @return The position of the tag or -1 if none starts after it.
+     */
+    int FirstStartingAfter(time_t time) const;
+
+    /*!
+     * @brief Find the first tag that lies completely within the given times.
+     * @param begin Minimum start time in UTC.
+     * @param end Maximum end time in UTC.
+     * @return The position of the tag or -1 if it wasn't found.
+     */
+    int FirstWithin(time_t begin, time_t end) const;
+
+    /*!
+     * @brief Get all tags that are on some time between the given times.
+     * @param begin The start of the range in UTC.
+     * @param end The end of the range in UTC.
+     * @param tags The tags that overlap the range, ordered by start time.
+     * @return The number of tags found.
+     */
+    int Overlapping(time_t begin, time_t end, std::vector<CEpgInfoTagPtr> &tags) const;
+
+  private:
+    /*!
+     * @return The position of the first tag that starts after the given time, or Size().
+     */
+    int UpperBound(time_t time) const;
+
+    /*!
+     * @return The position of the first tag that ends at or after the given time, or Size().
+     */
+    int FirstEndingFrom(time_t time) const;
+
+    std::vector<time_t>         m_starts;  /*!< the start times of the tags */
+    std::vector<time_t>         m_ends;    /*!< the end times of the tags */
+    std::vector<time_t>         m_maxEnds; /*!< the latest end time of the tags up to and including each one */
+    std::vector<CEpgInfoTagPtr> m_tags;    /*!< the tags, sorted by start time */
+  };
+}
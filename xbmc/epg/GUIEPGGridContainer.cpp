@@ -40,7 +40,6 @@ using namespace EPG;
 using namespace std;
 
 #define SHORTGAP     5 // how many blocks is considered a short-gap in nav logic
-#define MINSPERBLOCK 5 /// would be nice to offer zooming of busy schedules /// performance cost to increase resolution 5 fold?
 #define BLOCKJUMP    4 // how many blocks are jumped with each analogue scroll action
 
 CGUIEPGGridContainer::CGUIEPGGridContainer(int parentID, int controlID, float posX, float posY, float width,
@@ -89,7 +88,6 @@ CGUIEPGGridContainer::CGUIEPGGridContainer(int parentID, int controlID, float po
   m_cacheChannelItems     = preloadItems;
   m_cacheRulerItems       = preloadItems;
   m_cacheProgrammeItems   = preloadItems;
-  m_gridIndex             = NULL;
 }
 
 CGUIEPGGridContainer::~CGUIEPGGridContainer(void)
@@ -313,29 +311,18 @@ void CGUIEPGGridContainer::Render()
     if (channel >= (int)m_channelItems.size())
       break;
 
-    int block = blockOffset;
-    float posA2 = posA;
-
-    CGUIListItemPtr item = m_gridIndex[channel][block].item;
-    if (blockOffset > 0 && item == m_gridIndex[channel][blockOffset-1].item)
-    {
-      /* first program starts before current view */
-      int startBlock = blockOffset - 1;
-      while (m_gridIndex[channel][startBlock].item == item)
-        startBlock--;
-
-      block = startBlock + 1;
-      int missingSection = blockOffset - block;
-      posA2 -= missingSection * m_blockSize;
-    }
+    /* first program may start before current view */
+    int block = m_gridModel.GetSpanStart(channel, blockOffset);
+    float posA2 = posA - (blockOffset - block) * m_blockSize;
 
     while (posA2 < endA && m_programmeItems.size())   // FOR EACH ITEM ///////////////
     {
-      item = m_gridIndex[channel][block].item;
+      GridItemsPtr *gridItem = m_gridModel.GetBlock(channel, block);
+      CGUIListItemPtr item = gridItem->item;
       if (!item || !item.get()->IsFileItem())
         break;
 
-      bool focused = (channel == m_channelOffset + m_channelCursor) && (item == m_gridIndex[m_channelOffset + m_channelCursor][m_blockOffset + m_blockCursor].item);
+      bool focused = (channel == m_channelOffset + m_channelCursor) && (item == m_gridModel.GetBlock(m_channelOffset + m_channelCursor, m_blockOffset + m_blockCursor)->item);
 
       // render our item
       if (focused)
@@ -351,27 +338,27 @@ void CGUIEPGGridContainer::Render()
           focusedPosY = posA2;
         }
         focusedItem = item;
-        focusedwidth = m_gridIndex[channel][block].width;
-        focusedheight = m_gridIndex[channel][block].height;
+        focusedwidth = gridItem->width;
+        focusedheight = gridItem->height;
       }
       else
       {
         if (m_orientation == VERTICAL)
-          RenderProgrammeItem(posA2, posB, m_gridIndex[channel][block].width, m_gridIndex[channel][block].height, item.get(), focused);
+          RenderProgrammeItem(posA2, posB, gridItem->width, gridItem->height, item.get(), focused);
         else
-          RenderProgrammeItem(posB, posA2, m_gridIndex[channel][block].width, m_gridIndex[channel][block].height, item.get(), focused);
+          RenderProgrammeItem(posB, posA2, gridItem->width, gridItem->height, item.get(), focused);
       }
 
       // increment our X position
       if (m_orientation == VERTICAL)
       {
-        posA2 += m_gridIndex[channel][block].width; // assumes focused & unfocused layouts have equal length
-        block += (int)(m_gridIndex[channel][block].width / m_blockSize);
+        posA2 += gridItem->width; // assumes focused & unfocused layouts have equal length
+        block += (int)(gridItem->width / m_blockSize);
       }
       else
       {
-        posA2 += m_gridIndex[channel][block].height; // assumes focused & unfocused layouts have equal length
-        block += (int)(m_gridIndex[channel][block].height / m_blockSize);
+        posA2 += gridItem->height; // assumes focused & unfocused layouts have equal length
+        block += (int)(gridItem->height / m_blockSize);
       }
     }
 
@@ -667,7 +654,17 @@ bool CGUIEPGGridContainer::OnMessage(CGUIMessage& message)
     }
     else if (message.GetMessage() == GUI_MSG_LABEL_BIND && message.GetPointer())
     {
-      Reset();
+      /* keep the grid, so only channels that changed have to be laid out again */
+      m_wasReset = true;
+      m_channelItems.clear();
+      m_programmeItems.clear();
+      m_rulerItems.clear();
+      m_epgItemsPtr.clear();
+
+      m_item        = NULL;
+      m_lastItem    = NULL;
+      m_lastChannel = NULL;
+
       CFileItemList *items = (CFileItemList *)message.GetPointer();
 
       /* Create Channel items */
@@ -708,16 +705,6 @@ bool CGUIEPGGridContainer::OnMessage(CGUIMessage& message)
       for (int i = 0; i < items->Size(); i++)
         m_programmeItems.push_back(items->Get(i));
 
-      ClearGridIndex();
-      m_gridIndex = (struct GridItemsPtr **) calloc(1,m_channelItems.size()*sizeof(struct GridItemsPtr*));
-      if (m_gridIndex != NULL)
-      {
-        for (unsigned int i = 0; i < m_channelItems.size(); i++)
-        {
-          m_gridIndex[i] = (struct GridItemsPtr*) calloc(1,MAXBLOCKS*sizeof(struct GridItemsPtr));
-        }
-      }
-
       UpdateLayout(true); // true to refresh all items
 
       /* Create Ruler items */
@@ -755,12 +742,13 @@ bool CGUIEPGGridContainer::OnMessage(CGUIMessage& message)
 
 void CGUIEPGGridContainer::UpdateItems()
 {
-  CDateTimeSpan blockDuration, gridDuration;
+  CDateTimeSpan gridDuration;
 
   /* check for invalid start and end time */
   if (m_gridStart >= m_gridEnd)
   {
     CLog::Log(LOGERROR, "CGUIEPGGridContainer - %s - invalid start and end time set", __FUNCTION__);
+    ClearGridIndex();
     CGUIMessage msg(GUI_MSG_LABEL_RESET, GetID(), GetParentID()); // message the window
     SendWindowMessage(msg);
     return;
@@ -776,104 +764,19 @@ void CGUIEPGGridContainer::UpdateItems()
   if (m_blocks < m_blocksPerPage)
   {
     CLog::Log(LOGERROR, "(%s) - Less than one page of data available.", __FUNCTION__);
+    ClearGridIndex();
     CGUIMessage msg(GUI_MSG_LABEL_RESET, GetID(), GetParentID()); // message the window
     SendWindowMessage(msg);
     return;
   }
 
-  blockDuration.SetDateTimeSpan(0, 0, MINSPERBLOCK, 0);
-
   long tick(XbmcThreads::SystemClockMillis());
 
-  for (unsigned int row = 0; row < m_channelItems.size(); ++row)
-  {
-    CDateTime gridCursor  = m_gridStart; //reset cursor for new channel
-    unsigned long progIdx = m_epgItemsPtr[row].start;
-    unsigned long lastIdx = m_epgItemsPtr[row].stop;
-    int iEpgId            = ((CFileItem *)m_programmeItems[progIdx].get())->GetEPGInfoTag()->EpgID();
-
-    /** FOR EACH BLOCK **********************************************************************/
-
-    for (int block = 0; block < m_blocks; block++)
-    {
-      while (progIdx <= lastIdx)
-      {
-        CGUIListItemPtr item = m_programmeItems[progIdx];
-        const CEpgInfoTag* tag = ((CFileItem *)item.get())->GetEPGInfoTag();
-        if (tag == NULL)
-          progIdx++;
-
-        if (tag->EpgID() != iEpgId)
-          break;
-
-        if (m_gridEnd <= tag->StartAsUTC())
-        {
-          break;
-        }
-        else if (gridCursor >= tag->EndAsUTC())
-        {
-          progIdx++;
-        }
-        else if (gridCursor < tag->EndAsUTC())
-        {
-          m_gridIndex[row][block].item = item;
-          break;
-        }
-        else
-        {
-          progIdx++;
-        }
-      }
-
-      gridCursor += blockDuration;
-    }
-
-    /** FOR EACH BLOCK **********************************************************************/
-    int itemSize = 1; // size of the programme in blocks
-    int savedBlock = 0;
-
-    for (int block = 0; block < m_blocks; block++)
-    {
-      if (m_gridIndex[row][block].item != m_gridIndex[row][block+1].item)
-      {
-        if (!m_gridIndex[row][block].item)
-        {
-          CEpgInfoTag broadcast;
-          CFileItemPtr unknown(new CFileItem(broadcast));
-          for (int i = block ; i > block - itemSize; i--)
-          {
-            m_gridIndex[row][i].item = unknown;
-          }
-        }
-
-        CGUIListItemPtr item = m_gridIndex[row][block].item;
-        CFileItem *fileItem = (CFileItem *)item.get();
+  m_gridModel.SetGrid(m_gridStart, m_blocks);
+  int iChanged = m_gridModel.Update(m_programmeItems, m_epgItemsPtr);
 
-        m_gridIndex[row][savedBlock].item->SetProperty("GenreType", fileItem->GetEPGInfoTag()->GenreType());
-        if (m_orientation == VERTICAL)
-        {
-          m_gridIndex[row][savedBlock].width   = itemSize*m_blockSize;
-          m_gridIndex[row][savedBlock].height  = m_channelHeight;
-        }
-        else
-        {
-          m_gridIndex[row][savedBlock].width   = m_channelWidth;
-          m_gridIndex[row][savedBlock].height  = itemSize*m_blockSize;
-        }
-
-        itemSize = 1;
-        savedBlock = block+1;
-      }
-      else
-      {
-        itemSize++;
-      }
-    }
-  }
-
-  /******************************************* END ******************************************/
-
-  CLog::Log(LOGDEBUG, "%s completed successfully in %u ms", __FUNCTION__, (unsigned int)(XbmcThreads::SystemClockMillis()-tick));
+  CLog::Log(LOGDEBUG, "%s completed successfully in %u ms, %d of %d channels changed", __FUNCTION__,
+      (unsigned int)(XbmcThreads::SystemClockMillis()-tick), iChanged, m_gridModel.ChannelCount());
 
   m_channels = (int)m_epgItemsPtr.size();
   m_item = GetItem(m_channelCursor);
@@ -966,7 +869,7 @@ bool CGUIEPGGridContainer::MoveChannel(bool direction, bool wrapAround)
 
 bool CGUIEPGGridContainer::MoveProgrammes(bool direction)
 {
-  if (!m_gridIndex || !m_item)
+  if (m_gridModel.IsEmpty() || !m_item)
     return false;
 
   if (direction)
@@ -974,7 +877,7 @@ bool CGUIEPGGridContainer::MoveProgrammes(bool direction)
     if (m_channelCursor + m_channelOffset < 0 || m_blockOffset < 0)
       return false;
 
-    if (m_item->item != m_gridIndex[m_channelCursor + m_channelOffset][m_blockOffset].item)
+    if (m_item->item != m_gridModel.GetBlock(m_channelCursor + m_channelOffset, m_blockOffset)->item)
     {
       // this is not first item on page
       m_item = GetPrevItem(m_channelCursor);
@@ -1023,7 +926,7 @@ bool CGUIEPGGridContainer::MoveProgrammes(bool direction)
   }
   else
   {
-    if (m_item->item != m_gridIndex[m_channelCursor + m_channelOffset][m_blocksPerPage + m_blockOffset - 1].item)
+    if (m_item->item != m_gridModel.GetBlock(m_channelCursor + m_channelOffset, m_blocksPerPage + m_blockOffset - 1)->item)
     {
       // this is not last item on page
       m_item = GetNextItem(m_channelCursor);
@@ -1313,13 +1216,13 @@ bool CGUIEPGGridContainer::OnMouseWheel(char wheel, const CPoint &point)
 
 int CGUIEPGGridContainer::GetSelectedItem() const
 {
-  if (!m_gridIndex ||
+  if (m_gridModel.IsEmpty() ||
       !m_epgItemsPtr.size() ||
       m_channelCursor + m_channelOffset >= (int)m_channelItems.size() ||
       m_blockCursor + m_blockOffset >= (int)m_programmeItems.size())
     return 0;
 
-  CGUIListItemPtr currentItem = m_gridIndex[m_channelCursor + m_channelOffset][m_blockCursor + m_blockOffset].item;
+  CGUIListItemPtr currentItem = m_gridModel.GetItem(m_channelCursor + m_channelOffset, m_blockCursor + m_blockOffset);
   if (!currentItem)
     return 0;
 
@@ -1368,9 +1271,9 @@ GridItemsPtr *CGUIEPGGridContainer::GetClosestItem(const int &channel)
   }
 
   if (right <= SHORTGAP && right <= left && m_blockCursor + right < m_blocksPerPage)
-    return &m_gridIndex[channel + m_channelOffset][m_blockCursor + right + m_blockOffset];
+    return m_gridModel.GetBlock(channel + m_channelOffset, m_blockCursor + right + m_blockOffset);
 
-  return &m_gridIndex[channel + m_channelOffset][m_blockCursor - left  + m_blockOffset];
+  return m_gridModel.GetBlock(channel + m_channelOffset, m_blockCursor - left  + m_blockOffset);
 }
 
 int CGUIEPGGridContainer::GetItemSize(GridItemsPtr *item)
@@ -1391,40 +1294,33 @@ int CGUIEPGGridContainer::GetBlock(const CGUIListItemPtr &item, const int &chann
 
 int CGUIEPGGridContainer::GetRealBlock(const CGUIListItemPtr &item, const int &channel)
 {
-  int block = 0;
-
-  while (m_gridIndex[channel + m_channelOffset][block].item != item && block < m_blocks)
-    block++;
-
-  return block;
+  return m_gridModel.GetSpanStart(channel + m_channelOffset, item);
 }
 
 GridItemsPtr *CGUIEPGGridContainer::GetNextItem(const int &channel)
 {
   int i = m_blockCursor;
 
-  while (m_gridIndex[channel + m_channelOffset][i + m_blockOffset].item == m_gridIndex[channel + m_channelOffset][m_blockCursor + m_blockOffset].item && i < m_blocksPerPage)
+  while (m_gridModel.GetBlock(channel + m_channelOffset, i + m_blockOffset)->item == m_gridModel.GetBlock(channel + m_channelOffset, m_blockCursor + m_blockOffset)->item && i < m_blocksPerPage)
     i++;
 
-  return &m_gridIndex[channel + m_channelOffset][i + m_blockOffset];
+  return m_gridModel.GetBlock(channel + m_channelOffset, i + m_blockOffset);
 }
 
 GridItemsPtr *CGUIEPGGridContainer::GetPrevItem(const int &channel)
 {
   int i = m_blockCursor;
 
-  while (m_gridIndex[channel + m_channelOffset][i + m_blockOffset].item == m_gridIndex[channel + m_channelOffset][m_blockCursor + m_blockOffset].item && i > 0)
+  while (m_gridModel.GetBlock(channel + m_channelOffset, i + m_blockOffset)->item == m_gridModel.GetBlock(channel + m_channelOffset, m_blockCursor + m_blockOffset)->item && i > 0)
     i--;
 
-  return &m_gridIndex[channel + m_channelOffset][i + m_blockOffset];
-
-//  return &m_gridIndex[channel + m_channelOffset][m_blockCursor + m_blockOffset - 1];
+  return m_gridModel.GetBlock(channel + m_channelOffset, i + m_blockOffset);
 }
 
 GridItemsPtr *CGUIEPGGridContainer::GetItem(const int &channel)
 {
   if ( (channel >= 0) && (channel < m_channels) )
-    return &m_gridIndex[channel + m_channelOffset][m_blockCursor + m_blockOffset];
+    return m_gridModel.GetBlock(channel + m_channelOffset, m_blockCursor + m_blockOffset);
   else
     return NULL;
 }
@@ -1602,19 +1498,7 @@ CStdString CGUIEPGGridContainer::GetDescription() const
 
 void CGUIEPGGridContainer::ClearGridIndex(void)
 {
-  if (m_gridIndex)
-  {
-    for (unsigned int i = 0; i < m_channelItems.size(); i++)
-    {
-      for (int block = 0; block < m_blocks; block++)
-      {
-        if (m_gridIndex[i][block].item)
-          m_gridIndex[i][block].item.get()->ClearProperties();
-      }
-      free(m_gridIndex[i]);
-    }
-    free(m_gridIndex);
-  }
+  m_gridModel.Clear();
 }
 
 void CGUIEPGGridContainer::Reset()
@@ -1627,9 +1511,9 @@ void CGUIEPGGridContainer::Reset()
   m_rulerItems.clear();
   m_epgItemsPtr.clear();
 
+  m_item        = NULL;
   m_lastItem    = NULL;
   m_lastChannel = NULL;
-  m_gridIndex   = NULL;
 }
 
 void CGUIEPGGridContainer::GoToBegin()
@@ -1640,17 +1524,10 @@ void CGUIEPGGridContainer::GoToBegin()
 
 void CGUIEPGGridContainer::GoToEnd()
 {
-  int blocksEnd = 0;   // the end block of the last epg element for the selected channel
-  int blocksStart = 0; // the start block of the last epg element for the selected channel
+  /* the end and start block of the last epg element for the selected channel */
+  int blocksEnd   = m_blocks - 1;
+  int blocksStart = m_gridModel.GetSpanStart(m_channelCursor + m_channelOffset, blocksEnd);
   int blockOffset = 0; // the block offset to scroll to
-  for (int blockIndex = m_blocks; blockIndex >= 0 && (!blocksEnd || !blocksStart); blockIndex--)
-  {
-    if (!blocksEnd && m_gridIndex[m_channelCursor + m_channelOffset][blockIndex].item != NULL)
-      blocksEnd = blockIndex;
-    if (blocksEnd && m_gridIndex[m_channelCursor + m_channelOffset][blocksEnd].item != 
-                     m_gridIndex[m_channelCursor + m_channelOffset][blockIndex].item)
-      blocksStart = blockIndex + 1;
-  }
   if (blocksEnd - blocksStart > m_blocksPerPage)
     blockOffset = blocksStart;
   else if (blocksEnd > m_blocksPerPage)
@@ -1721,6 +1598,8 @@ void CGUIEPGGridContainer::CalculateLayout()
     m_ProgrammesPerPage = (int)(m_gridHeight / m_blockSize) + 1;
   }
 
+  m_gridModel.SetLayout(m_orientation == VERTICAL, m_blockSize, m_orientation == VERTICAL ? m_channelHeight : m_channelWidth);
+
   // ensure that the scroll offsets are a multiple of our sizes
   m_channelScrollOffset   = m_channelOffset * m_programmeLayout->Size(m_orientation);
   m_programmeScrollOffset = m_blockOffset * m_blockSize;
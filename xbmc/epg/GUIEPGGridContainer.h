@@ -24,6 +24,7 @@
 #include "FileItem.h"
 #include "guilib/GUIControl.h"
 #include "guilib/GUIListItemLayout.h"
+#include "GUIEPGGridModel.h"
 
 namespace PVR
 {
@@ -33,14 +34,6 @@ namespace PVR
 namespace EPG
 {
   #define MAXCHANNELS 20
-  #define MAXBLOCKS   2304 //! !!_EIGHT_!! days of 5 minute blocks
-
-  struct GridItemsPtr
-  {
-    CGUIListItemPtr item;
-    float width;
-    float height;
-  };
 
   class CGUIEPGGridContainer : public CGUIControl
   {
@@ -136,11 +129,6 @@ namespace EPG
 
     ORIENTATION m_orientation;
 
-    struct ItemsPtr
-    {
-      long start;
-      long stop;
-    };
     std::vector< ItemsPtr > m_epgItemsPtr;
     std::vector< CGUIListItemPtr > m_channelItems;
     std::vector< CGUIListItemPtr > m_rulerItems;
@@ -205,7 +193,7 @@ namespace EPG
     CDateTime m_gridStart;
     CDateTime m_gridEnd;
 
-    struct GridItemsPtr **m_gridIndex;
+    CGUIEPGGridModel m_gridModel;
     GridItemsPtr *m_item;
     CGUIListItem *m_lastItem;
     CGUIListItem *m_lastChannel;
@@ -0,0 +1,265 @@
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "GUIEPGGridModel.h"
+#include "FileItem.h"
+#include "epg/EpgInfoTag.h"
+#include "utils/Variant.h"
+
+#include <algorithm>
+
+#define SECSPERBLOCK (MINSPERBLOCK * 60)
+
+using namespace std;
+using namespace EPG;
+
+CGUIEPGGridModel::CGUIEPGGridModel(void) :
+    m_gridStart(0),
+    m_iBlocks(0),
+    m_bVertical(true),
+    m_fBlockSize(0),
+    m_fChannelSize(0),
+    m_iLayout(1)
+{
+  m_empty.width  = 0;
+  m_empty.height = 0;
+}
+
+CGUIEPGGridModel::~CGUIEPGGridModel(void)
+{
+  Clear();
+}
+
+void CGUIEPGGridModel::SetGrid(const CDateTime &gridStart, int iBlocks)
+{
+  time_t start;
+  gridStart.GetAsTime(start);
+  if (start == m_gridStart && iBlocks == m_iBlocks)
+    return;
+
+  /* every programme moves to other blocks */
+  Clear();
+  m_gridStart = start;
+  m_iBlocks   = iBlocks;
+}
+
+void CGUIEPGGridModel::SetLayout(bool bVertical, float fBlockSize, float fChannelSize)
+{
+  if (bVertical == m_bVertical && fBlockSize == m_fBlockSize && fChannelSize == m_fChannelSize)
+    return;
+
+  m_bVertical    = bVertical;
+  m_fBlockSize   = fBlockSize;
+  m_fChannelSize = fChannelSize;
+
+  /* items are resized when they're used again */
+  m_iLayout++;
+}
+
+int CGUIEPGGridModel::Update(const vector<CGUIListItemPtr> &programmes, const vector<ItemsPtr> &channels)
+{
+  int iChanged = 0;
+  m_channels.resize(channels.size());
+
+  for (unsigned int iChannel = 0; iChannel < channels.size(); iChannel++)
+  {
+    LayoutChannel(programmes, channels[iChannel], m_scratch);
+
+    GridSpans &spans = m_channels[iChannel];
+    bool bSame = spans.size() == m_scratch.size();
+    for (unsigned int iPtr = 0; bSame && iPtr < spans.size(); iPtr++)
+    {
+      bSame = spans[iPtr].iStartBlock == m_scratch[iPtr].iStartBlock &&
+              spans[iPtr].iBlocks     == m_scratch[iPtr].iBlocks &&
+              spans[iPtr].bGap        == m_scratch[iPtr].bGap;
+    }
+
+    if (!bSame)
+    {
+      spans = m_scratch;
+      iChanged++;
+      continue;
+    }
+
+    /* the programmes didn't move, so gaps and sizes can be kept */
+    for (unsigned int iPtr = 0; iPtr < spans.size(); iPtr++)
+    {
+      if (!spans[iPtr].bGap && spans[iPtr].cell.item != m_scratch[iPtr].cell.item)
+      {
+        spans[iPtr].cell.item = m_scratch[iPtr].cell.item;
+        spans[iPtr].iLayout   = 0;
+      }
+    }
+  }
+
+  return iChanged;
+}
+
+void CGUIEPGGridModel::Clear(void)
+{
+  for (unsigned int iChannel = 0; iChannel < m_channels.size(); iChannel++)
+  {
+    for (unsigned int iPtr = 0; iPtr < m_channels[iChannel].size(); iPtr++)
+    {
+      if (m_channels[iChannel][iPtr].cell.item)
+        m_channels[iChannel][iPtr].cell.item->ClearProperties();
+    }
+  }
+  m_channels.clear();
+  m_scratch.clear();
+}
+
+GridItemsPtr *CGUIEPGGridModel::GetBlock(int iChannel, int iBlock)
+{
+  GridSpan *span = const_cast<GridSpan *>(FindSpan(iChannel, iBlock));
+  if (!span)
+    return &m_empty;
+
+  if (span->iLayout != m_iLayout)
+    Materialise(*span);
+
+  return &span->cell;
+}
+
+CGUIListItemPtr CGUIEPGGridModel::GetItem(int iChannel, int iBlock) const
+{
+  const GridSpan *span = FindSpan(iChannel, iBlock);
+  return span ? span->cell.item : CGUIListItemPtr();
+}
+
+int CGUIEPGGridModel::GetSpanStart(int iChannel, int iBlock) const
+{
+  const GridSpan *span = FindSpan(iChannel, iBlock);
+  return span ? span->iStartBlock : iBlock;
+}
+
+int CGUIEPGGridModel::GetSpanStart(int iChannel, const CGUIListItemPtr &item) const
+{
+  if (iChannel >= 0 && iChannel < (int)m_channels.size())
+  {
+    const GridSpans &spans = m_channels[iChannel];
+    for (unsigned int iPtr = 0; iPtr < spans.size(); iPtr++)
+    {
+      if (spans[iPtr].cell.item == item)
+        return spans[iPtr].iStartBlock;
+    }
+  }
+  return m_iBlocks;
+}
+
+int CGUIEPGGridModel::SpanCount(void) const
+{
+  int iSpans = 0;
+  for (unsigned int iChannel = 0; iChannel < m_channels.size(); iChannel++)
+    iSpans += m_channels[iChannel].size();
+  return iSpans;
+}
+
+size_t CGUIEPGGridModel::MemoryUsage(void) const
+{
+  size_t iBytes = sizeof(*this) +
+                  m_channels.capacity() * sizeof(GridSpans) +
+                  m_scratch.capacity() * sizeof(GridSpan);
+  for (unsigned int iChannel = 0; iChannel < m_channels.size(); iChannel++)
+    iBytes += m_channels[iChannel].capacity() * sizeof(GridSpan);
+  return iBytes;
+}
+
+void CGUIEPGGridModel::LayoutChannel(const vector<CGUIListItemPtr> &programmes, const ItemsPtr &range, GridSpans &spans) const
+{
+  spans.clear();
+  time_t gridEnd = m_gridStart + (time_t)m_iBlocks * SECSPERBLOCK;
+
+  int iBlock = 0;
+  for (long iPtr = range.start; iPtr <= range.stop && iBlock < m_iBlocks; iPtr++)
+  {
+    const CEpgInfoTag *tag = ((CFileItem *)programmes[iPtr].get())->GetEPGInfoTag();
+    if (!tag)
+      continue;
+
+    time_t start, end;
+    tag->StartAsUTC().GetAsTime(start);
+    if (start >= gridEnd)
+      break;
+
+    /* a programme takes all blocks that start before it ends and aren't taken yet */
+    tag->EndAsUTC().GetAsTime(end);
+    int iEnd = end <= m_gridStart ? 0 : (int)std::min((time_t)m_iBlocks, (end - m_gridStart + SECSPERBLOCK - 1) / SECSPERBLOCK);
+    if (iEnd <= iBlock)
+      continue;
+
+    AddSpan(spans, iBlock, iEnd - iBlock, programmes[iPtr]);
+    iBlock = iEnd;
+  }
+
+  if (iBlock < m_iBlocks)
+    AddSpan(spans, iBlock, m_iBlocks - iBlock, CGUIListItemPtr());
+}
+
+void CGUIEPGGridModel::AddSpan(GridSpans &spans, int iStartBlock, int iBlocks, const CGUIListItemPtr &item) const
+{
+  GridSpan span;
+  span.iStartBlock = iStartBlock;
+  span.iBlocks     = iBlocks;
+  span.bGap        = !item;
+  span.iLayout     = 0;
+  span.cell.item   = item;
+  span.cell.width  = 0;
+  span.cell.height = 0;
+  spans.push_back(span);
+}
+
+const CGUIEPGGridModel::GridSpan *CGUIEPGGridModel::FindSpan(int iChannel, int iBlock) const
+{
+  if (iChannel < 0 || iChannel >= (int)m_channels.size() || iBlock < 0 || iBlock >= m_iBlocks)
+    return NULL;
+
+  const GridSpans &spans = m_channels[iChannel];
+  GridSpans::const_iterator it = upper_bound(spans.begin(), spans.end(), iBlock, StartsAfter);
+  if (it == spans.begin())
+    return NULL;
+
+  return &*(--it);
+}
+
+void CGUIEPGGridModel::Materialise(GridSpan &span)
+{
+  if (!span.cell.item)
+  {
+    CEpgInfoTag broadcast;
+    CFileItemPtr unknown(new CFileItem(broadcast));
+    span.cell.item = unknown;
+  }
+
+  CFileItem *fileItem = (CFileItem *)span.cell.item.get();
+  fileItem->SetProperty("GenreType", fileItem->GetEPGInfoTag()->GenreType());
+
+  if (m_bVertical)
+  {
+    span.cell.width  = span.iBlocks * m_fBlockSize;
+    span.cell.height = m_fChannelSize;
+  }
+  else
+  {
+    span.cell.width  = m_fChannelSize;
+    span.cell.height = span.iBlocks * m_fBlockSize;
+  }
+  span.iLayout = m_iLayout;
+}
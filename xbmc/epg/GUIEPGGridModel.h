@@ -0,0 +1,162 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "XBDateTime.h"
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+class CGUIListItem; typedef boost::shared_ptr<CGUIListItem> CGUIListItemPtr;
+
+namespace EPG
+{
+  #define MAXBLOCKS    2304 //! !!_EIGHT_!! days of 5 minute blocks
+  #define MINSPERBLOCK 5 /// would be nice to offer zooming of busy schedules /// performance cost to increase resolution 5 fold?
+
+  struct GridItemsPtr
+  {
+    CGUIListItemPtr item;
+    float width;
+    float height;
+  };
+
+  struct ItemsPtr
+  {
+    long start;
+    long stop;
+  };
+
+  /** the programmes of the EPG grid, stored as one span of blocks per programme and channel */
+  class CGUIEPGGridModel
+  {
+  public:
+    CGUIEPGGridModel(void);
+    virtual ~CGUIEPGGridModel(void);
+
+    /*!
+     * @brief Set the time the grid starts at and the number of blocks it has.
+     * @param gridStart The start of the grid in UTC.
+     * @param iBlocks The number of blocks of MINSPERBLOCK minutes.
+     */
+    void SetGrid(const CDateTime &gridStart, int iBlocks);
+
+    /*!
+     * @brief Set the size the grid items are rendered at.
+     * @param bVertical True if the programmes of a channel are laid out left to right.
+     * @param fBlockSize The size of a block in pixels.
+     * @param fChannelSize The size of a channel row or column in pixels.
+     */
+    void SetLayout(bool bVertical, float fBlockSize, float fChannelSize);
+
+    /*!
+     * @brief Update the grid with new programmes.
+     *
+     * Channels that end up with the same spans keep them and only refer to the new items,
+     * the others are laid out again.
+     *
+     * @param programmes The programme items, sorted by channel and start time.
+     * @param channels The range of programme items of each channel.
+     * @return The number of channels that were laid out again.
+     */
+    int Update(const std::vector<CGUIListItemPtr> &programmes, const std::vector<ItemsPtr> &channels);
+
+    /*!
+     * @brief Remove all channels from the grid.
+     */
+    void Clear(void);
+
+    bool IsEmpty(void) const { return m_channels.empty(); }
+    int ChannelCount(void) const { return (int)m_channels.size(); }
+    int BlockCount(void) const { return m_iBlocks; }
+
+    /*!
+     * @brief Get the grid item of a block, creating and sizing it when it's first used.
+     * @param iChannel The channel.
+     * @param iBlock The block.
+     * @return The item of the programme on this block, sized for the whole programme.
+     *         An empty item if the block is outside the grid.
+     */
+    GridItemsPtr *GetBlock(int iChannel, int iBlock);
+
+    /*!
+     * @brief Get the item of a block without creating it.
+     * @param iChannel The channel.
+     * @param iBlock The block.
+     * @return The item of the programme on this block or NULL if there is none.
+     */
+    CGUIListItemPtr GetItem(int iChannel, int iBlock) const;
+
+    /*!
+     * @brief Get the first block of the programme on a block.
+     * @param iChannel The channel.
+     * @param iBlock The block.
+     * @return The first block or iBlock if it's outside the grid.
+     */
+    int GetSpanStart(int iChannel, int iBlock) const;
+
+    /*!
+     * @brief Get the first block of a programme.
+     * @param iChannel The channel.
+     * @param item The item of the programme.
+     * @return The first block or BlockCount() if the item isn't on this channel.
+     */
+    int GetSpanStart(int iChannel, const CGUIListItemPtr &item) const;
+
+    /*!
+     * @return The number of spans in the grid.
+     */
+    int SpanCount(void) const;
+
+    /*!
+     * @return The number of bytes used by the grid, not counting the items.
+     */
+    size_t MemoryUsage(void) const;
+
+  private:
+    struct GridSpan
+    {
+      int          iStartBlock; /*!< the first block of the programme */
+      int          iBlocks;     /*!< the number of blocks of the programme */
+      bool         bGap;        /*!< true if there is no programme on these blocks */
+      unsigned int iLayout;     /*!< the layout the item was sized for, 0 if it wasn't yet */
+      GridItemsPtr cell;        /*!< the item, which is created on first use for a gap */
+    };
+    typedef std::vector<GridSpan> GridSpans;
+
+    static bool StartsAfter(int iBlock, const GridSpan &span) { return iBlock < span.iStartBlock; }
+
+    void LayoutChannel(const std::vector<CGUIListItemPtr> &programmes, const ItemsPtr &range, GridSpans &spans) const;
+    void AddSpan(GridSpans &spans, int iStartBlock, int iBlocks, const CGUIListItemPtr &item) const;
+    const GridSpan *FindSpan(int iChannel, int iBlock) const;
+    void Materialise(GridSpan &span);
+
+    std::vector<GridSpans> m_channels; /*!< the spans of each channel, sorted by block */
+    GridSpans              m_scratch;  /*!< the spans of the channel being updated */
+    time_t                 m_gridStart;
+    int                    m_iBlocks;
+    bool                   m_bVertical;
+    float                  m_fBlockSize;
+    float                  m_fChannelSize;
+    unsigned int           m_iLayout;
+    GridItemsPtr           m_empty;
+  };
+}
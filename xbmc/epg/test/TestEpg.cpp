@@ -0,0 +1,410 @@
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "addons/AddonCallbacksPVR.h"
+#include "dbwrappers/dataset.h"
+#include "epg/Epg.h"
+#include "epg/EpgDatabase.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SingleLock.h"
+#include "utils/TimeUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#define BENCHMARK_CHANNELS 500
+#define BENCHMARK_DAYS     14
+#define BENCHMARK_QUERIES  100000
+#define TRANSFER_CHANNELS  100
+
+using namespace ADDON;
+using namespace EPG;
+
+/* gives access to the tags, for comparing against the linear walks the index replaces */
+class CTestEpg : public CEpg
+{
+public:
+  CTestEpg(int iEpgID) : CEpg(iEpgID) {}
+
+  /* merge the contents of another table, as an EPG update does */
+  bool Merge(const CEpg &epg) { return UpdateEntries(epg, false); }
+
+  void Tags(std::vector<CEpgInfoTagPtr> &tags) const
+  {
+    CSingleLock lock(m_critSection);
+    for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); it++)
+      tags.push_back(it->second);
+  }
+
+  CEpgInfoTagPtr LinearTagAround(const CDateTime &time) const
+  {
+    CSingleLock lock(m_critSection);
+    for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); it++)
+    {
+      if ((it->second->StartAsUTC() <= time) && (it->second->EndAsUTC() >= time))
+        return it->second;
+    }
+    return CEpgInfoTagPtr();
+  }
+
+  CEpgInfoTagPtr LinearTagBetween(const CDateTime &beginTime, const CDateTime &endTime) const
+  {
+    CSingleLock lock(m_critSection);
+    for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); it++)
+    {
+      if (it->second->StartAsUTC() >= beginTime && it->second->EndAsUTC() <= endTime)
+        return it->second;
+    }
+    return CEpgInfoTagPtr();
+  }
+
+  int LinearTagsBetween(const CDateTime &beginTime, const CDateTime &endTime, std::vector<CEpgInfoTagPtr> &tags) const
+  {
+    CSingleLock lock(m_critSection);
+    int iFound = 0;
+    for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); it++)
+    {
+      if (it->second->StartAsUTC() < endTime && it->second->EndAsUTC() > beginTime)
+      {
+        tags.push_back(it->second);
+        iFound++;
+      }
+    }
+    return iFound;
+  }
+};
+
+/* a fresh database in special://temp instead of the profile folder */
+class CTestEpgDatabase : public CEpgDatabase
+{
+public:
+  bool Create()
+  {
+    DatabaseSettings settings;
+    settings.type = "sqlite3";
+    settings.host = CSpecialProtocol::TranslatePath("special://temp/");
+    settings.name = "TestEpg";
+    return Update(settings);
+  }
+
+  CStdString GetFileName() const
+  {
+    return CStdString("special://temp/") + m_pDB->getDatabase();
+  }
+};
+
+/* programmes of 5 minutes to 2 hours, with the odd gap between them */
+static void Populate(CEpg &epg, unsigned int seed, time_t start, int iDays)
+{
+  CEpgInfoTag tag;
+  time_t end = start + iDays * 24 * 60 * 60;
+  for (time_t time = start; time < end;)
+  {
+    seed = seed * 1103515245 + 12345;
+    time_t duration = 5 * 60 * (1 + (seed >> 16) % 24);
+    tag.SetStartFromUTC(CDateTime(time));
+    tag.SetEndFromUTC(CDateTime(time + duration));
+    epg.UpdateEntry(tag, false, false);
+
+    time += duration;
+    if ((seed >> 8) % 16 == 0)
+      time += 10 * 60;
+  }
+}
+
+/* stands in for a PVR add-on, sending the guide of a channel through the add-on callbacks */
+class CFakePVRClient
+{
+public:
+  CFakePVRClient(unsigned int seed, time_t start, int iDays) :
+    m_strTitle("Programme"),
+    m_strPlot("A programme of the fake PVR client, with a plot that is about as long as a real one.")
+  {
+    time_t end = start + iDays * 24 * 60 * 60;
+    for (time_t time = start; time < end;)
+    {
+      seed = seed * 1103515245 + 12345;
+      time_t duration = 5 * 60 * (1 + (seed >> 16) % 24);
+
+      EPG_TAG tag;
+      memset(&tag, 0, sizeof(tag));
+      tag.iUniqueBroadcastId  = m_tags.size() + 1;
+      tag.strTitle            = m_strTitle.c_str();
+      tag.startTime           = time;
+      tag.endTime             = time + duration;
+      tag.strPlotOutline      = m_strTitle.c_str();
+      tag.strPlot             = m_strPlot.c_str();
+      tag.strIconPath         = "";
+      tag.iGenreType          = EPG_GENRE_USE_STRING;
+      tag.strGenreDescription = "Fake";
+      tag.strEpisodeName      = "";
+      m_tags.push_back(tag);
+
+      time += duration;
+    }
+  }
+
+  void GetEpg(CEpg &epg, bool bBatch)
+  {
+    ADDON_HANDLE_STRUCT handle;
+    handle.callerAddress  = this;
+    handle.dataAddress    = &epg;
+    handle.dataIdentifier = 0;
+
+    if (bBatch)
+      CAddonCallbacksPVR::PVRTransferEpgEntries(NULL, &handle, &m_tags[0], m_tags.size());
+    else
+    {
+      for (size_t i = 0; i < m_tags.size(); i++)
+        CAddonCallbacksPVR::PVRTransferEpgEntry(NULL, &handle, &m_tags[i]);
+    }
+  }
+
+  size_t Size(void) const { return m_tags.size(); }
+
+private:
+  std::string          m_strTitle;
+  std::string          m_strPlot;
+  std::vector<EPG_TAG> m_tags;
+};
+
+static time_t Now(void)
+{
+  time_t now;
+  CDateTime::GetUTCDateTime().GetAsTime(now);
+  return now;
+}
+
+TEST(TestEpg, Queries)
+{
+  time_t start = Now() - 24 * 60 * 60;
+  CTestEpg epg(1);
+  Populate(epg, 1, start, 2);
+
+  /* every minute of the table, plus a bit before and after it */
+  for (time_t time = start - 60 * 60; time < start + 50 * 60 * 60; time += 60)
+  {
+    CDateTime at(time);
+    EXPECT_EQ(epg.LinearTagAround(at), epg.GetTagAround(at));
+
+    CDateTime end(time + 90 * 60);
+    EXPECT_EQ(epg.LinearTagBetween(at, end), epg.GetTagBetween(at, end));
+
+    std::vector<CEpgInfoTagPtr> linear, indexed;
+    EXPECT_EQ(epg.LinearTagsBetween(at, end, linear), epg.GetTagsBetween(at, end, indexed));
+    EXPECT_TRUE(linear == indexed);
+  }
+
+  CEpgInfoTag now, next;
+  ASSERT_TRUE(epg.InfoTagNow(now));
+  EXPECT_TRUE(now.IsActive() || now.WasActive());
+  ASSERT_TRUE(epg.InfoTagNext(next));
+  EXPECT_TRUE(next.InTheFuture());
+  EXPECT_TRUE(next.StartAsUTC() >= now.EndAsUTC());
+}
+
+TEST(TestEpg, QueriesAfterUpdate)
+{
+  time_t start = Now() - 60 * 60;
+  CTestEpg epg(1);
+  Populate(epg, 2, start, 1);
+
+  CDateTime at(start + 30 * 60);
+  CEpgInfoTagPtr before = epg.GetTagAround(at);
+  ASSERT_TRUE(before.get() != NULL);
+
+  /* a programme that replaces everything around the given time must be found straight away */
+  CEpgInfoTag tag;
+  tag.SetStartFromUTC(CDateTime(start + 29 * 60));
+  tag.SetEndFromUTC(CDateTime(start + 31 * 60));
+  epg.UpdateEntry(tag, false);
+  EXPECT_EQ(epg.LinearTagAround(at), epg.GetTagAround(at));
+
+  epg.Clear();
+  EXPECT_TRUE(epg.GetTagAround(at).get() == NULL);
+}
+
+/* a benchmark, run it with --gtest_also_run_disabled_tests */
+TEST(TestEpg, DISABLED_Benchmark)
+{
+  time_t start = Now() - 24 * 60 * 60;
+  std::vector<CTestEpg *> tables;
+  size_t iTags = 0;
+  for (int i = 0; i < BENCHMARK_CHANNELS; i++)
+  {
+    tables.push_back(new CTestEpg(i + 1));
+    Populate(*tables.back(), i + 1, start, BENCHMARK_DAYS);
+    iTags += tables.back()->Size();
+  }
+  std::cout << "Populated " << testing::PrintToString(BENCHMARK_CHANNELS) << " channels with "
+            << testing::PrintToString(iTags) << " tags" << std::endl;
+
+  std::vector<CDateTime> times;
+  unsigned int seed = 1;
+  for (int i = 0; i < BENCHMARK_QUERIES; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    times.push_back(CDateTime(start + (time_t)(seed % (BENCHMARK_DAYS * 24 * 60 * 60))));
+  }
+
+  /* build the indices up front, the update thread would have done so already */
+  for (int i = 0; i < BENCHMARK_CHANNELS; i++)
+    tables[i]->GetTagAround(times[0]);
+
+  int iFound = 0;
+  int64_t begin = CurrentHostCounter();
+  for (int i = 0; i < BENCHMARK_QUERIES; i++)
+    iFound += tables[i % BENCHMARK_CHANNELS]->LinearTagAround(times[i]) ? 1 : 0;
+  double linearMs = 1000.0 * (CurrentHostCounter() - begin) / CurrentHostFrequency();
+
+  int iIndexedFound = 0;
+  begin = CurrentHostCounter();
+  for (int i = 0; i < BENCHMARK_QUERIES; i++)
+    iIndexedFound += tables[i % BENCHMARK_CHANNELS]->GetTagAround(times[i]) ? 1 : 0;
+  double indexedMs = 1000.0 * (CurrentHostCounter() - begin) / CurrentHostFrequency();
+
+  std::cout << testing::PrintToString(BENCHMARK_QUERIES) << " lookups: linear " << testing::PrintToString(linearMs)
+            << "ms, indexed " << testing::PrintToString(indexedMs) << "ms" << std::endl;
+  EXPECT_EQ(iFound, iIndexedFound);
+
+  /* one screen of the guide: two hours of every channel */
+  CDateTime viewStart(start + 24 * 60 * 60);
+  CDateTime viewEnd(start + 26 * 60 * 60);
+  std::vector<CEpgInfoTagPtr> tags;
+  begin = CurrentHostCounter();
+  for (int i = 0; i < BENCHMARK_CHANNELS; i++)
+    tables[i]->LinearTagsBetween(viewStart, viewEnd, tags);
+  linearMs = 1000.0 * (CurrentHostCounter() - begin) / CurrentHostFrequency();
+
+  size_t iLinearTags = tags.size();
+  tags.clear();
+  begin = CurrentHostCounter();
+  for (int i = 0; i < BENCHMARK_CHANNELS; i++)
+    tables[i]->GetTagsBetween(viewStart, viewEnd, tags);
+  indexedMs = 1000.0 * (CurrentHostCounter() - begin) / CurrentHostFrequency();
+
+  std::cout << "Guide page of " << testing::PrintToString(tags.size()) << " tags: linear " << testing::PrintToString(linearMs)
+            << "ms, indexed " << testing::PrintToString(indexedMs) << "ms" << std::endl;
+  EXPECT_EQ(iLinearTags, tags.size());
+
+  for (size_t i = 0; i < tables.size(); i++)
+    delete tables[i];
+}
+
+/* the first and second update of every table, one tag at a time and then all at once */
+static void TransferFromClients(int iChannels, int iDays, bool bReport)
+{
+  time_t start = Now() - 24 * 60 * 60;
+  std::vector<CFakePVRClient *> clients;
+  for (int i = 0; i < iChannels; i++)
+    clients.push_back(new CFakePVRClient(i + 1, start, iDays));
+
+  for (int iBatch = 0; iBatch < 2; iBatch++)
+  {
+    std::vector<CTestEpg *> tables;
+    for (int i = 0; i < iChannels; i++)
+      tables.push_back(new CTestEpg(i + 1));
+
+    for (int iUpdate = 0; iUpdate < 2; iUpdate++)
+    {
+      size_t iTags = 0;
+      int64_t begin = CurrentHostCounter();
+      for (int i = 0; i < iChannels; i++)
+      {
+        CTestEpg tmpEpg(i + 1);
+        clients[i]->GetEpg(tmpEpg, iBatch == 1);
+        EXPECT_TRUE(tables[i]->Merge(tmpEpg));
+        iTags += tables[i]->Size();
+        EXPECT_EQ(clients[i]->Size(), tables[i]->Size());
+      }
+      double ms = 1000.0 * (CurrentHostCounter() - begin) / CurrentHostFrequency();
+      if (bReport)
+        std::cout << (iBatch ? "Batched" : "Single") << " transfer, update " << testing::PrintToString(iUpdate + 1)
+                  << ": " << testing::PrintToString(iTags) << " tags in " << testing::PrintToString(ms) << "ms" << std::endl;
+    }
+
+    for (size_t i = 0; i < tables.size(); i++)
+      delete tables[i];
+  }
+
+  for (size_t i = 0; i < clients.size(); i++)
+    delete clients[i];
+}
+
+TEST(TestEpg, TransferFromClient)
+{
+  TransferFromClients(10, 2, false);
+}
+
+/* a benchmark, run it with --gtest_also_run_disabled_tests */
+TEST(TestEpg, DISABLED_TransferBenchmark)
+{
+  TransferFromClients(TRANSFER_CHANNELS, BENCHMARK_DAYS, true);
+}
+
+TEST(TestEpg, PersistBatch)
+{
+  CTestEpgDatabase database;
+  ASSERT_TRUE(database.Create());
+  CStdString strFile = database.GetFileName();
+  database.Close();
+  XFILE::CFile::Delete(strFile);
+  ASSERT_TRUE(database.Create());
+
+  time_t start = Now() - 24 * 60 * 60;
+  CTestEpg epg(1);
+  epg.SetName("Test");
+  Populate(epg, 1, start, 2);
+  ASSERT_EQ(1, database.Persist(epg));
+
+  /* the new tags are inserted and get their database IDs */
+  std::vector<CEpgInfoTagPtr> tags;
+  epg.Tags(tags);
+  database.BeginTransaction();
+  EXPECT_TRUE(database.Persist(tags));
+  EXPECT_TRUE(database.CommitTransaction());
+  for (size_t i = 0; i < tags.size(); i++)
+    EXPECT_LT(0, tags[i]->BroadcastId());
+
+  CTestEpg loaded(1);
+  EXPECT_EQ((int) tags.size(), database.Get(loaded));
+  EXPECT_EQ(epg.Size(), loaded.Size());
+
+  /* a changed tag replaces its row, the unchanged ones aren't written again */
+  int iBroadcastId = tags[0]->BroadcastId();
+  tags[0]->SetTitle("Changed");
+  EXPECT_TRUE(database.Persist(tags));
+  CTestEpg reloaded(1);
+  EXPECT_EQ((int) tags.size(), database.Get(reloaded));
+  CEpgInfoTagPtr changed = reloaded.GetTagAround(tags[0]->StartAsUTC());
+  ASSERT_TRUE(changed.get() != NULL);
+  EXPECT_EQ(iBroadcastId, changed->BroadcastId());
+  EXPECT_EQ("Changed", changed->Title(true));
+
+  /* and a single tag goes through the same statement */
+  tags[1]->SetTitle("Single");
+  EXPECT_EQ(tags[1]->BroadcastId(), database.Persist(*tags[1]));
+
+  database.Close();
+  XFILE::CFile::Delete(strFile);
+}
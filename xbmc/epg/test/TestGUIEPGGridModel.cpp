@@ -0,0 +1,216 @@
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileItem.h"
+#include "epg/EpgInfoTag.h"
+#include "epg/GUIEPGGridModel.h"
+#include "utils/TimeUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#define GRID_DAYS         3
+#define GRID_BLOCKS       (GRID_DAYS * 24 * 60 / MINSPERBLOCK)
+#define GRID_GUIDES       16
+#define VIEWPORT_CHANNELS 10
+#define VIEWPORT_BLOCKS   24
+
+using namespace EPG;
+
+static CGUIListItemPtr Programme(time_t start, time_t end)
+{
+  CEpgInfoTag tag;
+  tag.SetTitle("Programme");
+  tag.SetStartFromUTC(CDateTime(start));
+  tag.SetEndFromUTC(CDateTime(end));
+  return CGUIListItemPtr(new CFileItem(tag));
+}
+
+/* programmes of 5 minutes to 2 hours, with the odd gap between them */
+static void Populate(std::vector<CGUIListItemPtr> &guide, unsigned int seed, time_t start, time_t end)
+{
+  for (time_t time = start; time < end;)
+  {
+    seed = seed * 1103515245 + 12345;
+    time_t duration = 5 * 60 * (1 + (seed >> 16) % 24);
+    guide.push_back(Programme(time, time + duration));
+
+    time += duration;
+    if ((seed >> 8) % 16 == 0)
+      time += 10 * 60;
+  }
+}
+
+/* the programme items of a number of channels, which show one of GRID_GUIDES guides each */
+class CTestGrid
+{
+public:
+  CTestGrid(time_t start) : m_guides(GRID_GUIDES)
+  {
+    for (unsigned int i = 0; i < m_guides.size(); i++)
+      Populate(m_guides[i], i + 1, start, start + GRID_DAYS * 24 * 60 * 60);
+  }
+
+  void Bind(int iChannels)
+  {
+    m_programmes.clear();
+    m_channels.clear();
+    for (int i = 0; i < iChannels; i++)
+    {
+      const std::vector<CGUIListItemPtr> &guide = m_guides[i % m_guides.size()];
+      ItemsPtr range;
+      range.start = m_programmes.size();
+      m_programmes.insert(m_programmes.end(), guide.begin(), guide.end());
+      range.stop  = m_programmes.size() - 1;
+      m_channels.push_back(range);
+    }
+  }
+
+  std::vector<std::vector<CGUIListItemPtr> > m_guides;
+  std::vector<CGUIListItemPtr>               m_programmes;
+  std::vector<ItemsPtr>                      m_channels;
+};
+
+TEST(TestGUIEPGGridModel, Layout)
+{
+  time_t start = 1346500800;
+  std::vector<CGUIListItemPtr> programmes;
+  programmes.push_back(Programme(start - 600, start + 600));  /* blocks 0-1, started before the grid */
+  programmes.push_back(Programme(start + 900, start + 1820)); /* blocks 2-6, takes the gap before it */
+  programmes.push_back(Programme(start + 1820, start + 1900)); /* within block 6, which is taken */
+  programmes.push_back(Programme(start + 3600, start + 4200)); /* blocks 7-13 */
+
+  std::vector<ItemsPtr> channels(1);
+  channels[0].start = 0;
+  channels[0].stop  = programmes.size() - 1;
+
+  CGUIEPGGridModel grid;
+  grid.SetGrid(CDateTime(start), 24);
+  grid.SetLayout(true, 10.0f, 50.0f);
+  EXPECT_EQ(1, grid.Update(programmes, channels));
+  EXPECT_EQ(4, grid.SpanCount());
+
+  EXPECT_EQ(0, grid.GetSpanStart(0, 1));
+  EXPECT_EQ(2, grid.GetSpanStart(0, 6));
+  EXPECT_EQ(7, grid.GetSpanStart(0, 13));
+  EXPECT_EQ(14, grid.GetSpanStart(0, 23));
+  EXPECT_EQ(2, grid.GetSpanStart(0, programmes[1]));
+  EXPECT_EQ(24, grid.GetSpanStart(0, programmes[2]));
+
+  GridItemsPtr *item = grid.GetBlock(0, 4);
+  EXPECT_EQ(programmes[1], item->item);
+  EXPECT_FLOAT_EQ(50.0f, item->width);
+  EXPECT_FLOAT_EQ(50.0f, item->height);
+
+  /* the gap at the end gets an item of its own when it's used */
+  EXPECT_FALSE(grid.GetItem(0, 20));
+  item = grid.GetBlock(0, 20);
+  EXPECT_TRUE(item->item);
+  EXPECT_FLOAT_EQ(100.0f, item->width);
+  EXPECT_EQ(item, grid.GetBlock(0, 14));
+
+  /* and nothing outside the grid */
+  EXPECT_FALSE(grid.GetBlock(0, 24)->item);
+  EXPECT_FALSE(grid.GetBlock(1, 0)->item);
+
+  grid.SetLayout(false, 5.0f, 80.0f);
+  item = grid.GetBlock(0, 7);
+  EXPECT_FLOAT_EQ(80.0f, item->width);
+  EXPECT_FLOAT_EQ(35.0f, item->height);
+}
+
+TEST(TestGUIEPGGridModel, Update)
+{
+  time_t start = 1346500800;
+  CTestGrid data(start);
+  data.Bind(32);
+
+  CGUIEPGGridModel grid;
+  grid.SetGrid(CDateTime(start), GRID_BLOCKS);
+  grid.SetLayout(true, 10.0f, 50.0f);
+  EXPECT_EQ(32, grid.Update(data.m_programmes, data.m_channels));
+
+  /* nothing moved */
+  GridItemsPtr *last = grid.GetBlock(0, GRID_BLOCKS - 1);
+  EXPECT_EQ(0, grid.Update(data.m_programmes, data.m_channels));
+  EXPECT_EQ(last, grid.GetBlock(0, GRID_BLOCKS - 1));
+
+  /* new items for the same programmes replace the old ones */
+  CGUIListItemPtr item = Programme(start, start + 60);
+  *((CFileItem *)item.get())->GetEPGInfoTag() = *((CFileItem *)data.m_programmes[0].get())->GetEPGInfoTag();
+  data.m_programmes[0] = item;
+  EXPECT_EQ(0, grid.Update(data.m_programmes, data.m_channels));
+  EXPECT_EQ(item, grid.GetBlock(0, 0)->item);
+
+  /* only channels that show another guide are laid out again */
+  std::swap(data.m_channels[3], data.m_channels[4]);
+  EXPECT_EQ(2, grid.Update(data.m_programmes, data.m_channels));
+
+  /* another grid start moves everything */
+  grid.SetGrid(CDateTime(start + 30 * 60), GRID_BLOCKS);
+  EXPECT_EQ(32, grid.Update(data.m_programmes, data.m_channels));
+}
+
+/* a benchmark, run it with --gtest_also_run_disabled_tests */
+TEST(TestGUIEPGGridModel, DISABLED_Benchmark)
+{
+  time_t start = 1346500800;
+  CTestGrid data(start);
+  int channels[] = { 100, 500, 1000 };
+
+  for (unsigned int i = 0; i < sizeof(channels) / sizeof(channels[0]); i++)
+  {
+    CGUIEPGGridModel grid;
+    grid.SetGrid(CDateTime(start), GRID_BLOCKS);
+    grid.SetLayout(true, 10.0f, 50.0f);
+
+    data.Bind(channels[i]);
+    int64_t begin = CurrentHostCounter();
+    EXPECT_EQ(channels[i], grid.Update(data.m_programmes, data.m_channels));
+    double msBuild = 1000.0 * (CurrentHostCounter() - begin) / CurrentHostFrequency();
+
+    /* a refresh after some channels swapped their guides */
+    for (unsigned int iChannel = 0; iChannel < data.m_channels.size(); iChannel += GRID_GUIDES)
+      std::swap(data.m_channels[iChannel], data.m_channels[data.m_channels.size() - 1 - iChannel]);
+    begin = CurrentHostCounter();
+    int iChanged = grid.Update(data.m_programmes, data.m_channels);
+    double msUpdate = 1000.0 * (CurrentHostCounter() - begin) / CurrentHostFrequency();
+    EXPECT_LT(iChanged, channels[i]);
+
+    /* a page of the guide, somewhere in the middle */
+    begin = CurrentHostCounter();
+    for (int iChannel = channels[i] / 2; iChannel < channels[i] / 2 + VIEWPORT_CHANNELS; iChannel++)
+    {
+      for (int iBlock = GRID_BLOCKS / 2; iBlock < GRID_BLOCKS / 2 + VIEWPORT_BLOCKS; iBlock++)
+        EXPECT_TRUE(grid.GetBlock(iChannel, iBlock)->item);
+    }
+    double msPage = 1000.0 * (CurrentHostCounter() - begin) / CurrentHostFrequency();
+
+    size_t iBlockGrid = (size_t)channels[i] * MAXBLOCKS * sizeof(GridItemsPtr);
+    std::cout << testing::PrintToString(channels[i]) << " channels: built in " << testing::PrintToString(msBuild)
+              << "ms, updated " << testing::PrintToString(iChanged) << " channels in " << testing::PrintToString(msUpdate)
+              << "ms, page in " << testing::PrintToString(msPage) << "ms, "
+              << testing::PrintToString(grid.SpanCount()) << " spans in " << testing::PrintToString(grid.MemoryUsage() / 1024)
+              << "KiB (block grid: " << testing::PrintToString(iBlockGrid / 1024) << "KiB)" << std::endl;
+
+    EXPECT_LT(grid.MemoryUsage(), iBlockGrid);
+  }
+}
@@ -43,6 +43,34 @@ CCacheStrategy::~CCacheStrategy()
 {
 }
 
+int CCacheStrategy::GetWriteBuffer(char **pBuffer, size_t iMaxSize)
+{
+  return CACHE_RC_ERROR;
+}
+
+void CCacheStrategy::CommitWriteBuffer(size_t iSize)
+{
+}
+
+int CCacheStrategy::GetReadBuffer(const char **pBuffer, size_t iMaxSize)
+{
+  return CACHE_RC_ERROR;
+}
+
+void CCacheStrategy::ReleaseReadBuffer(size_t iSize)
+{
+}
+
+int64_t CCacheStrategy::GetResumePosition()
+{
+  return -1;
+}
+
+void CCacheStrategy::Resume(int64_t iSourcePosition)
+{
+  Reset(iSourcePosition);
+}
+
 void CCacheStrategy::EndOfInput() {
   m_bEndOfInput = true;
 }
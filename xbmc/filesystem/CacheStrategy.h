@@ -50,9 +50,37 @@ public:
   virtual int ReadFromCache(char *pBuffer, size_t iMaxSize) = 0;
   virtual int64_t WaitForData(unsigned int iMinAvail, unsigned int iMillis) = 0;
 
+  /*! \brief Get free space of the cache to write to directly, instead of copying with WriteToCache().
+   \return bytes available at *pBuffer, 0 if the cache is full or CACHE_RC_ERROR if not supported
+   \sa CommitWriteBuffer
+   */
+  virtual int GetWriteBuffer(char **pBuffer, size_t iMaxSize);
+
+  /*! \brief Add iSize bytes written to the space returned by GetWriteBuffer() to the cache */
+  virtual void CommitWriteBuffer(size_t iSize);
+
+  /*! \brief Borrow the cached data at the read position, instead of copying it with ReadFromCache().
+   The data stays valid until ReleaseReadBuffer(), the cache may not be read from or seeked meanwhile.
+   \return bytes available at *pBuffer, or the same as ReadFromCache() when there are none.
+   CACHE_RC_ERROR if not supported.
+   */
+  virtual int GetReadBuffer(const char **pBuffer, size_t iMaxSize);
+
+  /*! \brief Consume iSize bytes of the data returned by GetReadBuffer() */
+  virtual void ReleaseReadBuffer(size_t iSize);
+
   virtual int64_t Seek(int64_t iFilePosition) = 0;
   virtual void Reset(int64_t iSourcePosition) = 0;
 
+  /*! \brief Position the source has to continue from for reading to go on past the cached data
+   at the read position, when a seek was served from data that is no longer being written to.
+   \return the position to continue from, or -1 if the source can carry on where it is
+   */
+  virtual int64_t GetResumePosition();
+
+  /*! \brief Continue writing at the position returned by GetResumePosition(), keeping the cached data */
+  virtual void Resume(int64_t iSourcePosition);
+
   virtual void EndOfInput(); // mark the end of the input stream so that Read will know when to return EOF
   virtual bool IsEndOfInput();
   virtual void ClearEndOfInput();
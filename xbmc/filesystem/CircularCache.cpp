@@ -77,8 +77,8 @@ void CCircularCache::Close()
 }
 
 /**
- * Function will write to m_buf at m_end % m_size location
- * it will write at maximum m_size, but it will only write
+ * Function will return the space at m_end % m_size location
+ * it will return at maximum m_size, but it will only return
  * as much it can without wrapping around in the buffer
  *
  * It will always leave m_size_back of the backbuffer intact
@@ -95,7 +95,7 @@ void CCircularCache::Close()
  *
  * Multiple calls may be needed to fill buffer completely.
  */
-int CCircularCache::WriteToCache(const char *buf, size_t len)
+int CCircularCache::GetWriteBuffer(char **buf, size_t len)
 {
   CSingleLock lock(m_sync);
 
@@ -118,25 +118,44 @@ int CCircularCache::WriteToCache(const char *buf, size_t len)
   if(len == 0)
     return 0;
 
-  // write the data
-  memcpy(m_buf + pos, buf, len);
-  m_end += len;
+  // drop the history about to be overwritten, so nobody seeks into it while it is written
+  if(m_end + len - m_beg > m_size)
+    m_beg = m_end + len - m_size;
 
-  // drop history that was overwritten
-  if(m_end - m_beg > m_size)
-    m_beg = m_end - m_size;
+  *buf = (char*)m_buf + pos;
+  return len;
+}
 
+void CCircularCache::CommitWriteBuffer(size_t len)
+{
+  CSingleLock lock(m_sync);
+  m_end += len;
   m_written.Set();
+}
 
-  return len;
+int CCircularCache::WriteToCache(const char *buf, size_t len)
+{
+  char *dst;
+  int size = GetWriteBuffer(&dst, len);
+  if(size <= 0)
+    return size;
+
+  // the space can't be handed out twice, so it is written to without the lock
+  memcpy(dst, buf, size);
+  CommitWriteBuffer(size);
+
+  return size;
 }
 
 /**
- * Reads data from cache. Will only read up till
- * the buffer wrap point. So multiple calls
+ * Returns the data at the read position. Will only return
+ * up till the buffer wrap point. So multiple calls
  * may be needed to empty the whole cache
+ *
+ * The writer never overwrites data ahead of m_cur, so the
+ * data stays valid until it is released
  */
-int CCircularCache::ReadFromCache(char *buf, size_t len)
+int CCircularCache::GetReadBuffer(const char **buf, size_t len)
 {
   CSingleLock lock(m_sync);
 
@@ -155,15 +174,28 @@ int CCircularCache::ReadFromCache(char *buf, size_t len)
   if(len > avail)
     len = avail;
 
-  if(len == 0)
-    return 0;
+  *buf = (const char*)m_buf + pos;
+  return len;
+}
 
-  memcpy(buf, m_buf + pos, len);
+void CCircularCache::ReleaseReadBuffer(size_t len)
+{
+  CSingleLock lock(m_sync);
   m_cur += len;
-
   m_space.Set();
+}
 
-  return len;
+int CCircularCache::ReadFromCache(char *buf, size_t len)
+{
+  const char *src;
+  int size = GetReadBuffer(&src, len);
+  if(size <= 0)
+    return size;
+
+  memcpy(buf, src, size);
+  ReleaseReadBuffer(size);
+
+  return size;
 }
 
 int64_t CCircularCache::WaitForData(unsigned int minumum, unsigned int millis)
@@ -219,3 +251,21 @@ void CCircularCache::Reset(int64_t pos)
   m_cur = pos;
 }
 
+
+bool CCircularCache::IsCachedPosition(int64_t pos)
+{
+  CSingleLock lock(m_sync);
+  return (uint64_t)pos >= m_beg && (uint64_t)pos <= m_end;
+}
+
+int64_t CCircularCache::CachedDataBeginPos()
+{
+  CSingleLock lock(m_sync);
+  return m_beg;
+}
+
+int64_t CCircularCache::CachedDataEndPos()
+{
+  CSingleLock lock(m_sync);
+  return m_end;
+}
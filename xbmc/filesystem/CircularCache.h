@@ -38,11 +38,20 @@ public:
 
     virtual int WriteToCache(const char *buf, size_t len) ;
     virtual int ReadFromCache(char *buf, size_t len) ;
+
+    virtual int GetWriteBuffer(char **buf, size_t len);
+    virtual void CommitWriteBuffer(size_t len);
+    virtual int GetReadBuffer(const char **buf, size_t len);
+    virtual void ReleaseReadBuffer(size_t len);
     virtual int64_t WaitForData(unsigned int minimum, unsigned int iMillis) ;
 
     virtual int64_t Seek(int64_t pos) ;
     virtual void Reset(int64_t pos) ;
 
+    bool    IsCachedPosition(int64_t pos); ///< whether pos can be seeked to without waiting for data
+    int64_t CachedDataBeginPos();
+    int64_t CachedDataEndPos();
+
 protected:
     uint64_t          m_beg;       /**< index in file (not buffer) of beginning of valid data */
     uint64_t          m_end;       /**< index in file (not buffer) of end of valid data */
@@ -19,45 +19,81 @@
  */
 
 #include "DirectoryCache.h"
+#include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
 #include "FileItem.h"
+#include "File.h"
 #include "threads/SingleLock.h"
+#include "utils/Archive.h"
 #include "utils/log.h"
 #include "utils/URIUtils.h"
 #include "climits"
 
+#define CACHE_FILE    "special://temp/directorycache.dat"
+#define CACHE_VERSION 1
+
 using namespace std;
 using namespace XFILE;
 
 CDirectoryCache::CDir::CDir(DIR_CACHE_TYPE cacheType)
 {
   m_cacheType = cacheType;
-  m_lastAccess = 0;
-  m_Items = new CFileItemList;
+  m_mtime = 0;
+  m_revalidate = false;
+  m_id = 0;
+  m_size = 0;
+  m_Items.reset(new CFileItemList);
   m_Items->SetFastLookup(true);
+  if (g_advancedSettings.m_dirCacheTTL > 0)
+    m_expiry.Set(g_advancedSettings.m_dirCacheTTL * 1000);
 }
 
 CDirectoryCache::CDir::~CDir()
 {
-  delete m_Items;
 }
 
-void CDirectoryCache::CDir::SetLastAccess(unsigned int &accessCounter)
+void CDirectoryCache::CDir::UpdateSize()
+{
+  // only the strings every item has are counted, tags and art are not
+  m_size = sizeof(CDir) + sizeof(CFileItemList) + m_Items->GetPath().size();
+  for (int i = 0; i < m_Items->Size(); i++)
+  {
+    const CFileItemPtr item = m_Items->Get(i);
+    m_size += sizeof(CFileItem) + item->GetPath().size() + item->GetLabel().size() + item->GetLabel2().size();
+  }
+}
+
+bool CDirectoryCache::CDir::IsFresh(bool retrieveAll)
 {
-  m_lastAccess = accessCounter++;
+  if (m_revalidate)
+    return false;
+  if (m_cacheType == XFILE::DIR_CACHE_ALWAYS ||
+     (m_cacheType == XFILE::DIR_CACHE_ONCE && retrieveAll))
+    return true;
+  return g_advancedSettings.m_dirCacheTTL > 0 && !m_expiry.IsTimePast();
 }
 
 CDirectoryCache::CDirectoryCache(void)
 {
-  m_accessCounter = 0;
-#ifdef _DEBUG
+  m_size = 0;
+  m_idCounter = 0;
   m_cacheHits = 0;
   m_cacheMisses = 0;
-#endif
+  m_cacheEvictions = 0;
 }
 
 CDirectoryCache::~CDirectoryCache(void)
 {
+  Clear();
+}
+
+// the modification time of a directory, if the filesystem can tell
+static int64_t GetModificationTime(const CStdString& strPath)
+{
+  struct __stat64 buffer;
+  if (CFile::Stat(strPath, &buffer) == 0 && buffer.st_mtime > 0)
+    return buffer.st_mtime;
+  return 0;
 }
 
 bool CDirectoryCache::GetDirectory(const CStdString& strPath, CFileItemList &items, bool retrieveAll)
@@ -67,22 +103,58 @@ bool CDirectoryCache::GetDirectory(const CStdString& strPath, CFileItemList &ite
   CStdString storedPath = URIUtils::SubstitutePath(strPath);
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ciCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
+  iCache i = m_cache.find(storedPath);
+  if (i == m_cache.end())
+  {
+    m_cacheMisses++;
+    return false;
+  }
+
+  CDir* dir = i->second;
+  if (!dir->IsFresh(retrieveAll))
   {
-    CDir* dir = i->second;
-    if (dir->m_cacheType == XFILE::DIR_CACHE_ALWAYS ||
-       (dir->m_cacheType == XFILE::DIR_CACHE_ONCE && retrieveAll))
+    if (dir->m_mtime == 0)
+    {
+      m_cacheMisses++;
+      return false;
+    }
+
+    // ask the filesystem whether the directory changed, without blocking the cache meanwhile
+    unsigned int id = dir->m_id;
+    int64_t mtime = dir->m_mtime;
+    lock.Leave();
+    bool unchanged = GetModificationTime(storedPath) == mtime;
+    lock.Enter();
+
+    i = m_cache.find(storedPath);
+    if (i == m_cache.end() || i->second->m_id != id)
     {
-      items.Copy(*dir->m_Items);
-      dir->SetLastAccess(m_accessCounter);
-#ifdef _DEBUG
-      m_cacheHits+=items.Size();
-#endif
-      return true;
+      m_cacheMisses++;
+      return false;
     }
+
+    dir = i->second;
+    if (!unchanged)
+    {
+      Delete(i);
+      m_cacheMisses++;
+      return false;
+    }
+
+    dir->m_revalidate = false;
+    if (g_advancedSettings.m_dirCacheTTL > 0)
+      dir->m_expiry.Set(g_advancedSettings.m_dirCacheTTL * 1000);
   }
-  return false;
+
+  Touch(i);
+  m_cacheHits++;
+
+  // the listing can't change underneath us, so it is copied without the lock
+  boost::shared_ptr<CFileItemList> snapshot = dir->m_Items;
+  lock.Leave();
+
+  items.Copy(*snapshot);
+  return true;
 }
 
 void CDirectoryCache::SetDirectory(const CStdString& strPath, const CFileItemList &items, DIR_CACHE_TYPE cacheType)
@@ -101,19 +173,25 @@ void CDirectoryCache::SetDirectory(const CStdString& strPath, const CFileItemLis
   // IDEALLY, any further processing on the item would actually create a new item
   // instead of altering it, but we can't really enforce that in an easy way, so
   // this is the best solution for now.
-  CSingleLock lock (m_cs);
-
   CStdString storedPath = URIUtils::SubstitutePath(strPath);
   URIUtils::RemoveSlashAtEnd(storedPath);
 
+  // copy the items before taking the lock, large listings take a while
+  CDir* dir = new CDir(cacheType);
+  dir->m_Items->Copy(items);
+  dir->UpdateSize();
+
+  // remember the modification time if the listing can be revalidated later
+  if (g_advancedSettings.m_dirCacheTTL > 0 || g_advancedSettings.m_dirCachePersist)
+    dir->m_mtime = GetModificationTime(storedPath);
+
+  CSingleLock lock (m_cs);
+
   ClearDirectory(storedPath);
 
-  CheckIfFull();
+  Insert(storedPath, dir);
 
-  CDir* dir = new CDir(cacheType);
-  dir->m_Items->Copy(items);
-  dir->SetLastAccess(m_accessCounter);
-  m_cache.insert(pair<CStdString, CDir*>(storedPath, dir));
+  CheckIfFull();
 }
 
 void CDirectoryCache::ClearFile(const CStdString& strFile)
@@ -142,15 +220,10 @@ void CDirectoryCache::ClearSubPaths(const CStdString& strPath)
   CStdString storedPath = URIUtils::SubstitutePath(strPath);
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  iCache i = m_cache.begin();
-  while (i != m_cache.end())
-  {
-    CStdString path = i->first;
-    if (strncmp(path.c_str(), storedPath.c_str(), storedPath.GetLength()) == 0)
-      Delete(i++);
-    else
-      i++;
-  }
+  // the map is sorted, so all sub paths follow the path itself
+  iCache i = m_cache.lower_bound(storedPath);
+  while (i != m_cache.end() && strncmp(i->first.c_str(), storedPath.c_str(), storedPath.GetLength()) == 0)
+    Delete(i++);
 }
 
 void CDirectoryCache::AddFile(const CStdString& strFile)
@@ -161,13 +234,26 @@ void CDirectoryCache::AddFile(const CStdString& strFile)
   URIUtils::GetDirectory(strFile, strPath);
   URIUtils::RemoveSlashAtEnd(strPath);
 
-  ciCache i = m_cache.find(strPath);
+  iCache i = m_cache.find(strPath);
   if (i != m_cache.end())
   {
     CDir *dir = i->second;
+
+    // somebody may still be copying the listing, so change a copy of it
+    if (!dir->m_Items.unique())
+    {
+      boost::shared_ptr<CFileItemList> items(new CFileItemList);
+      items->SetFastLookup(true);
+      items->Assign(*dir->m_Items);
+      dir->m_Items = items;
+    }
+
     CFileItemPtr item(new CFileItem(strFile, false));
     dir->m_Items->Add(item);
-    dir->SetLastAccess(m_accessCounter);
+    m_size -= dir->m_size;
+    dir->UpdateSize();
+    m_size += dir->m_size;
+    Touch(i);
   }
 }
 
@@ -180,20 +266,17 @@ bool CDirectoryCache::FileExists(const CStdString& strFile, bool& bInCache)
   URIUtils::GetDirectory(strFile, strPath);
   URIUtils::RemoveSlashAtEnd(strPath);
 
-  ciCache i = m_cache.find(strPath);
-  if (i != m_cache.end())
+  iCache i = m_cache.find(strPath);
+  // listings restored from disk might be out of date
+  if (i != m_cache.end() && !i->second->m_revalidate)
   {
     bInCache = true;
     CDir *dir = i->second;
-    dir->SetLastAccess(m_accessCounter);
-#ifdef _DEBUG
+    Touch(i);
     m_cacheHits++;
-#endif
     return dir->m_Items->Contains(strFile);
   }
-#ifdef _DEBUG
   m_cacheMisses++;
-#endif
   return false;
 }
 
@@ -207,6 +290,96 @@ void CDirectoryCache::Clear()
     Delete(i++);
 }
 
+bool CDirectoryCache::Save()
+{
+  if (!g_advancedSettings.m_dirCachePersist)
+    return false;
+
+  // only listings we can revalidate are worth saving, grab them and write without the lock
+  vector< pair<CStdString, CDir> > dirs;
+  {
+    CSingleLock lock (m_cs);
+    for (list<iCache>::reverse_iterator i = m_lru.rbegin(); i != m_lru.rend(); ++i)
+    {
+      if ((*i)->second->m_mtime != 0)
+        dirs.push_back(make_pair((*i)->first, *(*i)->second));
+    }
+  }
+
+  CFile file;
+  if (!file.OpenForWrite(CACHE_FILE, true))
+  {
+    CLog::Log(LOGERROR, "%s - unable to write %s", __FUNCTION__, CACHE_FILE);
+    return false;
+  }
+
+  CArchive ar(&file, CArchive::store);
+  ar << (int)CACHE_VERSION;
+  ar << (int)dirs.size();
+  for (vector< pair<CStdString, CDir> >::iterator i = dirs.begin(); i != dirs.end(); ++i)
+  {
+    ar << i->first;
+    ar << (int)i->second.m_cacheType;
+    ar << i->second.m_mtime;
+    ar << *i->second.m_Items;
+  }
+  ar.Close();
+  file.Close();
+
+  CLog::Log(LOGDEBUG, "%s - saved %u directories", __FUNCTION__, (unsigned int)dirs.size());
+  return true;
+}
+
+bool CDirectoryCache::Load()
+{
+  if (!g_advancedSettings.m_dirCachePersist)
+    return false;
+
+  CFile file;
+  if (!file.Open(CACHE_FILE))
+    return false;
+
+  CArchive ar(&file, CArchive::load);
+  int version = 0, count = 0;
+  ar >> version;
+  if (version != CACHE_VERSION)
+  {
+    ar.Close();
+    file.Close();
+    return false;
+  }
+
+  // stored least recently used first, so the order survives the restart
+  ar >> count;
+  for (int i = 0; i < count; i++)
+  {
+    CStdString path;
+    int cacheType;
+    ar >> path;
+    ar >> cacheType;
+
+    CDir* dir = new CDir((DIR_CACHE_TYPE)cacheType);
+    ar >> dir->m_mtime;
+    ar >> *dir->m_Items;
+    dir->m_revalidate = true;
+    dir->UpdateSize();
+
+    CSingleLock lock (m_cs);
+    if (m_cache.find(path) != m_cache.end())
+    {
+      delete dir;
+      continue;
+    }
+    Insert(path, dir);
+    CheckIfFull();
+  }
+  ar.Close();
+  file.Close();
+
+  CLog::Log(LOGDEBUG, "%s - restored %i directories", __FUNCTION__, count);
+  return true;
+}
+
 void CDirectoryCache::InitCache(set<CStdString>& dirs)
 {
   set<CStdString>::iterator it;
@@ -234,48 +407,64 @@ void CDirectoryCache::ClearCache(set<CStdString>& dirs)
 void CDirectoryCache::CheckIfFull()
 {
   CSingleLock lock (m_cs);
-  static const unsigned int max_cached_dirs = 10;
+  size_t maxSize = (size_t)g_advancedSettings.m_dirCacheSize * 1024;
 
-  // find the last accessed folder, and remove if the number of cached folders is too many
-  iCache lastAccessed = m_cache.end();
-  unsigned int numCached = 0;
-  for (iCache i = m_cache.begin(); i != m_cache.end(); i++)
+  // drop the least recently used directories, but always keep the latest one.
+  // directories that are always cached are never dropped.
+  list<iCache>::iterator i = m_lru.end();
+  while (m_size > maxSize && i != m_lru.begin())
   {
-    // ensure dirs that are always cached aren't cleared
-    if (i->second->m_cacheType != DIR_CACHE_ALWAYS)
-    {
-      if (lastAccessed == m_cache.end() || i->second->GetLastAccess() < lastAccessed->second->GetLastAccess())
-        lastAccessed = i;
-      numCached++;
-    }
+    iCache dir = *--i;
+    if (i == m_lru.begin())
+      break;
+    if (dir->second->m_cacheType == DIR_CACHE_ALWAYS)
+      continue;
+    ++i; // Delete() takes it out of the list
+    Delete(dir);
+    m_cacheEvictions++;
   }
-  if (lastAccessed != m_cache.end() && numCached >= max_cached_dirs)
-    Delete(lastAccessed);
+}
+
+void CDirectoryCache::Insert(const CStdString& strPath, CDir* dir)
+{
+  dir->m_id = ++m_idCounter;
+  iCache i = m_cache.insert(pair<CStdString, CDir*>(strPath, dir)).first;
+  m_lru.push_front(i);
+  dir->m_lruPosition = m_lru.begin();
+  m_size += dir->m_size;
+}
+
+void CDirectoryCache::Touch(iCache i)
+{
+  m_lru.splice(m_lru.begin(), m_lru, i->second->m_lruPosition);
 }
 
 void CDirectoryCache::Delete(iCache it)
 {
   CDir* dir = it->second;
+  m_lru.erase(dir->m_lruPosition);
+  m_size -= dir->m_size;
   delete dir;
   m_cache.erase(it);
 }
 
-#ifdef _DEBUG
-void CDirectoryCache::PrintStats() const
+void CDirectoryCache::GetStats(Stats &stats) const
 {
   CSingleLock lock (m_cs);
-  CLog::Log(LOGDEBUG, "%s - total of %u cache hits, and %u cache misses", __FUNCTION__, m_cacheHits, m_cacheMisses);
-  // run through and find the oldest and the number of items cached
-  unsigned int oldest = UINT_MAX;
-  unsigned int numItems = 0;
-  unsigned int numDirs = 0;
+  stats.hits = m_cacheHits;
+  stats.misses = m_cacheMisses;
+  stats.evictions = m_cacheEvictions;
+  stats.dirs = m_cache.size();
+  stats.items = 0;
   for (ciCache i = m_cache.begin(); i != m_cache.end(); i++)
-  {
-    CDir *dir = i->second;
-    oldest = min(oldest, dir->GetLastAccess());
-    numItems += dir->m_Items->Size();
-    numDirs++;
-  }
-  CLog::Log(LOGDEBUG, "%s - %u folders cached, with %u items total.  Oldest is %u, current is %u", __FUNCTION__, numDirs, numItems, oldest, m_accessCounter);
+    stats.items += i->second->m_Items->Size();
+  stats.size = m_size;
+}
+
+void CDirectoryCache::PrintStats() const
+{
+  Stats stats;
+  GetStats(stats);
+  CLog::Log(LOGDEBUG, "%s - total of %u cache hits, %u cache misses and %u evictions", __FUNCTION__, stats.hits, stats.misses, stats.evictions);
+  CLog::Log(LOGDEBUG, "%s - %u folders cached, with %u items total using about %u KB", __FUNCTION__, stats.dirs, stats.items, (unsigned int)(stats.size / 1024));
 }
-#endif
@@ -22,7 +22,10 @@
 #include "IDirectory.h"
 #include "Directory.h"
 #include "threads/CriticalSection.h"
+#include "threads/SystemClock.h"
 
+#include <boost/shared_ptr.hpp>
+#include <list>
 #include <map>
 #include <set>
 
@@ -38,15 +41,36 @@ namespace XFILE
       CDir(DIR_CACHE_TYPE cacheType);
       virtual ~CDir();
 
-      void SetLastAccess(unsigned int &accessCounter);
-      unsigned int GetLastAccess() const { return m_lastAccess; };
+      /*! \brief Estimate the memory used by the listing, this is what the cache size is bounded by */
+      void UpdateSize();
 
-      CFileItemList* m_Items;
+      /*! \brief Check whether the listing may be used without asking the filesystem
+       \param retrieveAll whether the caller asked for DIR_FLAG_READ_CACHE
+       */
+      bool IsFresh(bool retrieveAll);
+
+      // the listing is never changed once it is cached, AddFile() replaces it instead.
+      // that way it can be copied and saved without holding the cache lock.
+      boost::shared_ptr<CFileItemList> m_Items;
       DIR_CACHE_TYPE m_cacheType;
-    private:
-      unsigned int m_lastAccess;
+      int64_t m_mtime;                ///< modification time of the directory, 0 if unknown
+      bool m_revalidate;              ///< restored from disk, has to be checked before use
+      XbmcThreads::EndTime m_expiry;  ///< when DIR_CACHE_ONCE listings have to be revalidated
+      unsigned int m_id;              ///< tells a revalidated listing apart from a replaced one
+      size_t m_size;
+      std::list<std::map<CStdString, CDir*>::iterator>::iterator m_lruPosition;
     };
   public:
+    struct Stats
+    {
+      unsigned int hits;      ///< lookups answered from the cache
+      unsigned int misses;    ///< lookups that had to go to the filesystem
+      unsigned int evictions; ///< directories dropped to stay within the size limit
+      unsigned int dirs;      ///< directories cached
+      unsigned int items;     ///< items in all cached directories
+      size_t       size;      ///< estimated memory used, in bytes
+    };
+
     CDirectoryCache(void);
     virtual ~CDirectoryCache(void);
     bool GetDirectory(const CStdString& strPath, CFileItemList &items, bool retrieveAll = false);
@@ -57,9 +81,15 @@ namespace XFILE
     void Clear();
     void AddFile(const CStdString& strFile);
     bool FileExists(const CStdString& strPath, bool& bInCache);
-#ifdef _DEBUG
+
+    /*! \brief Save the listings that can be revalidated to disk, if enabled in advancedsettings */
+    bool Save();
+
+    /*! \brief Restore the listings saved by Save(), they are revalidated before they are used */
+    bool Load();
+
+    void GetStats(Stats &stats) const;
     void PrintStats() const;
-#endif
   protected:
     void InitCache(std::set<CStdString>& dirs);
     void ClearCache(std::set<CStdString>& dirs);
@@ -69,15 +99,19 @@ namespace XFILE
     typedef std::map<CStdString, CDir*>::iterator iCache;
     typedef std::map<CStdString, CDir*>::const_iterator ciCache;
     void Delete(iCache i);
+    void Insert(const CStdString& strPath, CDir* dir);
+    void Touch(iCache i);
 
-    CCriticalSection m_cs;
+    mutable CCriticalSection m_cs;
 
-    unsigned int m_accessCounter;
+    // least recently used directory at the back
+    std::list<iCache> m_lru;
+    size_t m_size;
+    unsigned int m_idCounter;
 
-#ifdef _DEBUG
     unsigned int m_cacheHits;
     unsigned int m_cacheMisses;
-#endif
+    unsigned int m_cacheEvictions;
   };
 }
 extern XFILE::CDirectoryCache g_directoryCache;
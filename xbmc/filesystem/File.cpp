@@ -512,6 +512,26 @@ unsigned int CFile::Read(void *lpBuf, int64_t uiBufSize)
   return 0;
 }
 
+//*********************************************************************************************
+int CFile::GetReadBuffer(const void** lpBuf, int64_t uiBufSize)
+{
+  // the stream buffer has its own copy of the data
+  if (!m_pFile || m_pBuffer)
+    return -1;
+
+  return m_pFile->GetReadBuffer(lpBuf, uiBufSize);
+}
+
+void CFile::ReleaseReadBuffer(unsigned int uiSize)
+{
+  if (!m_pFile)
+    return;
+
+  m_pFile->ReleaseReadBuffer(uiSize);
+  if (m_bitStreamStats && uiSize > 0)
+    m_bitStreamStats->AddSampleBytes(uiSize);
+}
+
 //*********************************************************************************************
 void CFile::Close()
 {
@@ -84,6 +84,8 @@ public:
   int64_t GetLength();
   void Close();
   int GetChunkSize();
+  int GetReadBuffer(const void** lpBuf, int64_t uiBufSize);
+  void ReleaseReadBuffer(unsigned int uiSize);
 
   // will return a size, that is aligned to chunk size
   // but always greater or equal to the file's chunk size
@@ -26,6 +26,7 @@
 #include "URL.h"
 
 #include "CircularCache.h"
+#include "SegmentedCache.h"
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "utils/TimeUtils.h"
@@ -83,10 +84,19 @@ CFileCache::CFileCache() : CThread("CFileCache")
    m_bDeleteCache = true;
    m_nSeekResult = 0;
    m_seekPos = 0;
+   m_seekResume = false;
    m_readPos = 0;
    m_writePos = 0;
    if (g_advancedSettings.m_cacheMemBufferSize == 0)
      m_pCache = new CSimpleFileCache();
+   else if (g_advancedSettings.m_cacheSegments > 1)
+   {
+     // the segments share the configured memory rather than each taking all of it
+     unsigned int segment = g_advancedSettings.m_cacheMemBufferSize / g_advancedSettings.m_cacheSegments;
+     m_pCache = new CSegmentedCache(segment
+                                  , std::max<unsigned int>( segment / 4, 1024 * 1024)
+                                  , g_advancedSettings.m_cacheSegments);
+   }
    else
      m_pCache = new CCircularCache(g_advancedSettings.m_cacheMemBufferSize
                                  , std::max<unsigned int>( g_advancedSettings.m_cacheMemBufferSize / 4, 1024 * 1024));
@@ -99,6 +109,7 @@ CFileCache::CFileCache(CCacheStrategy *pCache, bool bDeleteCache) : CThread("CFi
   m_pCache = pCache;
   m_bDeleteCache = bDeleteCache;
   m_seekPos = 0;
+  m_seekResume = false;
   m_readPos = 0;
   m_writePos = 0;
   m_nSeekResult = 0;
@@ -171,6 +182,9 @@ bool CFileCache::Open(const CURL& url)
   m_writePos = 0;
   m_writeRate = 1024 * 1024;
   m_writeRateActual = 0;
+  m_readRate = 0;
+  m_readRatePos = 0;
+  m_readRateStamp = XbmcThreads::SystemClockMillis();
   m_cacheFull = false;
   m_seekEvent.Reset();
   m_seekEnded.Reset();
@@ -204,36 +218,60 @@ void CFileCache::Process()
     // check for seek events
     if (m_seekEvent.WaitMSec(0))
     {
-      m_seekEvent.Reset();
-      CLog::Log(LOGDEBUG,"%s, request seek on source to %"PRId64, __FUNCTION__, m_seekPos);
-      m_nSeekResult = m_source.Seek(m_seekPos, SEEK_SET);
-      if (m_nSeekResult != m_seekPos)
+      int64_t seekPos;
+      bool    resume;
       {
-        CLog::Log(LOGERROR,"%s, error %d seeking. seek returned %"PRId64, __FUNCTION__, (int)GetLastError(), m_nSeekResult);
+        CSingleLock lock(m_seekSync);
+        m_seekEvent.Reset();
+        seekPos = m_seekPos;
+        resume  = m_seekResume;
+      }
+      CLog::Log(LOGDEBUG,"%s, request %s on source to %"PRId64, __FUNCTION__, resume ? "resume" : "seek", seekPos);
+      int64_t seekResult = m_source.Seek(seekPos, SEEK_SET);
+      if (seekResult != seekPos)
+      {
+        CLog::Log(LOGERROR,"%s, error %d seeking. seek returned %"PRId64, __FUNCTION__, (int)GetLastError(), seekResult);
         m_seekPossible = m_source.IoControl(IOCTRL_SEEK_POSSIBLE, NULL);
       }
+      else if (resume)
+      {
+        // the reader is already positioned in the cached data, the source only catches up with it
+        m_pCache->Resume(seekPos);
+        average.Reset(seekPos);
+        limiter.Reset(seekPos);
+        m_writePos = seekPos;
+        m_cacheFull = false;
+      }
       else
       {
-        m_pCache->Reset(m_seekPos);
-        average.Reset(m_seekPos);
-        limiter.Reset(m_seekPos);
-        m_writePos = m_seekPos;
-        m_readPos = m_seekPos;
+        m_pCache->Reset(seekPos);
+        average.Reset(seekPos);
+        limiter.Reset(seekPos);
+        m_writePos = seekPos;
+        m_readPos = seekPos;
         m_cacheFull = false;
       }
 
-      m_seekEnded.Set();
+      // nobody waits for a resume, and signalling it could end the wait of a seek requested meanwhile
+      if (!resume)
+      {
+        m_nSeekResult = seekResult;
+        m_seekEnded.Set();
+      }
     }
 
-    while (m_writeRate)
+    // fill at least as fast as the cache is being read, in case the
+    // rate we were given is too low or we were never given one
+    unsigned writeRate = m_writeRate ? std::max(m_writeRate, m_readRate + m_readRate / 4) : 0;
+    while (writeRate)
     {
-      if (m_writePos - m_readPos < m_writeRate)
+      if (m_writePos - m_readPos < writeRate)
       {
         limiter.Reset(m_writePos);
         break;
       }
 
-      if (limiter.Rate(m_writePos) < m_writeRate)
+      if (limiter.Rate(m_writePos) < writeRate)
         break;
 
       if (m_seekEvent.WaitMSec(100))
@@ -243,7 +281,17 @@ void CFileCache::Process()
       }
     }
 
-    int iRead = m_source.Read(buffer.get(), m_chunkSize);
+    // read straight into the cache when it has room for a whole chunk, saving a copy
+    char *direct = NULL;
+    int iRead;
+    if (m_pCache->GetWriteBuffer(&direct, m_chunkSize) >= (int)m_chunkSize)
+      iRead = m_source.Read(direct, m_chunkSize);
+    else
+    {
+      direct = NULL;
+      iRead = m_source.Read(buffer.get(), m_chunkSize);
+    }
+
     if (iRead == 0)
     {
       CLog::Log(LOGINFO, "CFileCache::Process - Hit eof.");
@@ -262,6 +310,13 @@ void CFileCache::Process()
       m_bStop = true;
 
     int iTotalWrite=0;
+    if (direct && iRead > 0)
+    {
+      m_pCache->CommitWriteBuffer(iRead);
+      m_cacheFull = false;
+      iTotalWrite = iRead;
+    }
+
     while (!m_bStop && (iTotalWrite < iRead))
     {
       int iWrite = 0;
@@ -341,6 +396,7 @@ retry:
   if (iRc > 0)
   {
     m_readPos += iRc;
+    UpdateReadRate();
     return (int)iRc;
   }
 
@@ -366,6 +422,60 @@ retry:
   return 0;
 }
 
+int CFileCache::GetReadBuffer(const void** lpBuf, int64_t uiBufSize)
+{
+  CSingleLock lock(m_sync);
+  if (!m_pCache)
+  {
+    CLog::Log(LOGERROR,"%s - sanity failed. no cache strategy!", __FUNCTION__);
+    return -1;
+  }
+
+  int iRc;
+  while ((iRc = m_pCache->GetReadBuffer((const char**)lpBuf, (size_t)uiBufSize)) == CACHE_RC_WOULD_BLOCK)
+  {
+    // just wait for some data to show up
+    int64_t iAvail = m_pCache->WaitForData(1, 10000);
+    if (iAvail == CACHE_RC_TIMEOUT)
+    {
+      CLog::Log(LOGWARNING, "%s - timeout waiting for data", __FUNCTION__);
+      return 0;
+    }
+    if (iAvail <= 0)
+      return 0;
+  }
+
+  // not supported by the strategy, the caller has to fall back to Read()
+  if (iRc == CACHE_RC_ERROR)
+    return -1;
+
+  return iRc;
+}
+
+void CFileCache::ReleaseReadBuffer(unsigned int uiSize)
+{
+  CSingleLock lock(m_sync);
+  if (!m_pCache)
+    return;
+
+  m_pCache->ReleaseReadBuffer(uiSize);
+  m_readPos += uiSize;
+  UpdateReadRate();
+}
+
+void CFileCache::UpdateReadRate()
+{
+  // average over a second or more, the demuxer reads in bursts
+  const unsigned ts = XbmcThreads::SystemClockMillis();
+  if (ts - m_readRateStamp >= 1000)
+  {
+    unsigned rate = (unsigned)(1000 * (m_readPos - m_readRatePos) / (ts - m_readRateStamp));
+    m_readRate = m_readRate ? (m_readRate + rate) / 2 : rate;
+    m_readRatePos = m_readPos;
+    m_readRateStamp = ts;
+  }
+}
+
 int64_t CFileCache::Seek(int64_t iFilePosition, int iWhence)
 {
   CSingleLock lock(m_sync);
@@ -394,20 +504,25 @@ int64_t CFileCache::Seek(int64_t iFilePosition, int iWhence)
       return m_nSeekResult;
 
     /* never request closer to end than 2k, speeds up tag reading */
-    m_seekPos = std::min(iTarget, std::max((int64_t)0, m_source.GetLength() - m_chunkSize));
+    int64_t seekPos = std::min(iTarget, std::max((int64_t)0, m_source.GetLength() - m_chunkSize));
+    {
+      CSingleLock seekLock(m_seekSync);
+      m_seekPos = seekPos;
+      m_seekResume = false;
+      m_seekEvent.Set();
+    }
 
-    m_seekEvent.Set();
     if (!m_seekEnded.Wait())
     {
-      CLog::Log(LOGWARNING,"%s - seek to %"PRId64" failed.", __FUNCTION__, m_seekPos);
+      CLog::Log(LOGWARNING,"%s - seek to %"PRId64" failed.", __FUNCTION__, seekPos);
       return -1;
     }
 
     /* wait for any remainin data */
-    if(m_seekPos < iTarget)
+    if(seekPos < iTarget)
     {
       CLog::Log(LOGDEBUG,"%s - waiting for position %"PRId64".", __FUNCTION__, iTarget);
-      if(m_pCache->WaitForData((unsigned)(iTarget - m_seekPos), 10000) < iTarget - m_seekPos)
+      if(m_pCache->WaitForData((unsigned)(iTarget - seekPos), 10000) < iTarget - seekPos)
       {
         CLog::Log(LOGWARNING,"%s - failed to get remaining data", __FUNCTION__);
         return -1;
@@ -418,8 +533,24 @@ int64_t CFileCache::Seek(int64_t iFilePosition, int iWhence)
     m_seekEvent.Reset();
   }
   else
+  {
     m_readPos = iTarget;
 
+    // the seek may have landed in data the source is no longer writing to, in which
+    // case it has to continue after that data before reading reaches the end of it
+    int64_t resumePos = m_pCache->GetResumePosition();
+    if (resumePos >= 0 && m_seekPossible != 0)
+    {
+      CSingleLock seekLock(m_seekSync);
+      m_seekPos = resumePos;
+      m_seekResume = true;
+      m_seekEvent.Set();
+    }
+  }
+
+  m_readRatePos = m_readPos;
+  m_readRateStamp = XbmcThreads::SystemClockMillis();
+
   return m_nSeekResult;
 }
 
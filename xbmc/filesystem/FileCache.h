@@ -49,6 +49,8 @@ namespace XFILE
     virtual int           Stat(const CURL& url, struct __stat64* buffer);
 
     virtual unsigned int  Read(void* lpBuf, int64_t uiBufSize);
+    virtual int           GetReadBuffer(const void** lpBuf, int64_t uiBufSize);
+    virtual void          ReleaseReadBuffer(unsigned int uiSize);
 
     virtual int64_t       Seek(int64_t iFilePosition, int iWhence);
     virtual int64_t       GetPosition();
@@ -61,6 +63,8 @@ namespace XFILE
     virtual CStdString GetContent();
 
   private:
+    void UpdateReadRate();
+
     CCacheStrategy *m_pCache;
     bool      m_bDeleteCache;
     int        m_seekPossible;
@@ -70,13 +74,18 @@ namespace XFILE
     CEvent      m_seekEnded;
     int64_t      m_nSeekResult;
     int64_t      m_seekPos;
+    bool         m_seekResume;  // continue a cached segment rather than start a new one
     int64_t      m_readPos;
     int64_t      m_writePos;
     unsigned     m_chunkSize;
     unsigned     m_writeRate;
     unsigned     m_writeRateActual;
+    unsigned     m_readRate;    // measured rate the cache is read at
+    int64_t      m_readRatePos;
+    unsigned     m_readRateStamp;
     bool         m_cacheFull;
     CCriticalSection m_sync;
+    CCriticalSection m_seekSync;  // guards m_seekPos and m_seekResume, m_sync is held while a seek waits
   };
 
 }
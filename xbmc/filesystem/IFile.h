@@ -73,6 +73,14 @@ public:
    * but accepts any read size, have it return the value 1         */
   virtual int  GetChunkSize() {return 0;}
 
+  /* Borrows the next bytes of the file without copying them, for   *
+   * files that hold them in memory already. They stay valid until  *
+   * ReleaseReadBuffer(), the file may not be used meanwhile.       *
+   * Returns the bytes available, 0 at end of file and -1 when the  *
+   * file can't lend its data, in which case Read() has to be used. */
+  virtual int  GetReadBuffer(const void** lpBuf, int64_t uiBufSize) { return -1; }
+  virtual void ReleaseReadBuffer(unsigned int uiSize) { }
+
   virtual bool SkipNext(){return false;}
 
   virtual bool Delete(const CURL& url) { return false; }
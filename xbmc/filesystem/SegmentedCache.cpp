@@ -0,0 +1,285 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+#include "utils/log.h"
+#include "threads/SingleLock.h"
+#include "SegmentedCache.h"
+#include "CircularCache.h"
+
+using namespace XFILE;
+
+CSegmentedCache::CSegmentedCache(size_t front, size_t back, unsigned int segments)
+ : CCacheStrategy()
+ , m_useCounter(0)
+ , m_read(0)
+ , m_write(0)
+ , m_front(front)
+ , m_back(back)
+ , m_maxSegments(std::max(segments, 1u))
+{
+}
+
+CSegmentedCache::~CSegmentedCache()
+{
+  Close();
+}
+
+int CSegmentedCache::Open()
+{
+  Close();
+
+  CSingleLock lock(m_sync);
+
+  // further segments are only allocated once a seek needs them
+  CCircularCache *segment = new CCircularCache(m_front, m_back);
+  if (segment->Open() != CACHE_RC_OK)
+  {
+    delete segment;
+    return CACHE_RC_ERROR;
+  }
+
+  m_segments.push_back(segment);
+  m_lastUsed.push_back(0);
+  m_read  = 0;
+  m_write = 0;
+  Touch(0);
+  return CACHE_RC_OK;
+}
+
+void CSegmentedCache::Close()
+{
+  CSingleLock lock(m_sync);
+  for (std::vector<CCircularCache*>::iterator it = m_segments.begin(); it != m_segments.end(); ++it)
+    delete *it;
+  m_segments.clear();
+  m_lastUsed.clear();
+}
+
+int CSegmentedCache::WriteToCache(const char *buf, size_t len)
+{
+  CCircularCache *segment;
+  {
+    CSingleLock lock(m_sync);
+    segment = m_segments[m_write];
+  }
+  return segment->WriteToCache(buf, len);
+}
+
+int CSegmentedCache::ReadFromCache(char *buf, size_t len)
+{
+  CCircularCache *segment;
+  {
+    CSingleLock lock(m_sync);
+    segment = m_segments[m_read];
+  }
+
+  int rc = segment->ReadFromCache(buf, len);
+  if (rc > 0)
+    m_space.Set();
+  return rc;
+}
+
+int CSegmentedCache::GetWriteBuffer(char **buf, size_t len)
+{
+  CCircularCache *segment;
+  {
+    CSingleLock lock(m_sync);
+    segment = m_segments[m_write];
+  }
+  return segment->GetWriteBuffer(buf, len);
+}
+
+void CSegmentedCache::CommitWriteBuffer(size_t len)
+{
+  CCircularCache *segment;
+  {
+    CSingleLock lock(m_sync);
+    segment = m_segments[m_write];
+  }
+  segment->CommitWriteBuffer(len);
+}
+
+int CSegmentedCache::GetReadBuffer(const char **buf, size_t len)
+{
+  CCircularCache *segment;
+  {
+    CSingleLock lock(m_sync);
+    segment = m_segments[m_read];
+  }
+  return segment->GetReadBuffer(buf, len);
+}
+
+void CSegmentedCache::ReleaseReadBuffer(size_t len)
+{
+  CCircularCache *segment;
+  {
+    CSingleLock lock(m_sync);
+    segment = m_segments[m_read];
+  }
+  segment->ReleaseReadBuffer(len);
+  m_space.Set();
+}
+
+int64_t CSegmentedCache::WaitForData(unsigned int minimum, unsigned int millis)
+{
+  CCircularCache *segment;
+  {
+    CSingleLock lock(m_sync);
+    if (m_segments.empty())
+      return CACHE_RC_ERROR;
+    segment = m_segments[m_read];
+  }
+  return segment->WaitForData(minimum, millis);
+}
+
+int64_t CSegmentedCache::Seek(int64_t pos)
+{
+  CSingleLock lock(m_sync);
+
+  // of the segments holding the position take the one reaching furthest, the written one on a tie
+  size_t found = m_write;
+  int64_t end = m_segments[m_write]->IsCachedPosition(pos) ? m_segments[m_write]->CachedDataEndPos() : -1;
+  for (size_t i = 0; i < m_segments.size(); i++)
+  {
+    if (i != m_write && m_segments[i]->IsCachedPosition(pos) && m_segments[i]->CachedDataEndPos() > end)
+    {
+      found = i;
+      end = m_segments[i]->CachedDataEndPos();
+    }
+  }
+
+  if (end < 0)
+  {
+    // just past the data being written, the segment can wait for it
+    CCircularCache *segment = m_segments[m_write];
+    lock.Leave();
+    if (segment->Seek(pos) != pos)
+      return CACHE_RC_ERROR;
+    lock.Enter();
+  }
+  else if (m_segments[found]->Seek(pos) != pos)
+    return CACHE_RC_ERROR;
+
+  if (found != m_read)
+    CLog::Log(LOGDEBUG, "CSegmentedCache::Seek - serving %"PRId64" from segment %u", pos, (unsigned int)found);
+
+  m_read = found;
+  Touch(found);
+  m_space.Set();
+  return pos;
+}
+
+void CSegmentedCache::Reset(int64_t pos)
+{
+  CSingleLock lock(m_sync);
+
+  size_t segment = NextSegment(m_segments.size());
+  m_segments[segment]->Reset(pos);
+  m_segments[segment]->ClearEndOfInput();
+  m_read  = segment;
+  m_write = segment;
+  Touch(segment);
+}
+
+int64_t CSegmentedCache::GetResumePosition()
+{
+  CSingleLock lock(m_sync);
+  if (m_read == m_write || m_segments[m_read]->IsEndOfInput())
+    return -1;
+  return m_segments[m_read]->CachedDataEndPos();
+}
+
+void CSegmentedCache::Resume(int64_t pos)
+{
+  CSingleLock lock(m_sync);
+  if (m_read != m_write && m_segments[m_read]->CachedDataEndPos() == pos)
+  {
+    m_write = m_read;
+    Touch(m_write);
+    return;
+  }
+
+  // the reader moved elsewhere since the resume was requested, only the
+  // written side starts over at pos, in a segment the reader isn't using
+  size_t segment = NextSegment(m_read);
+  if (segment == m_segments.size())
+  {
+    CLog::Log(LOGWARNING, "CSegmentedCache::Resume - no segment to continue %"PRId64" in", pos);
+    Reset(pos);
+    return;
+  }
+
+  m_segments[segment]->Reset(pos);
+  m_segments[segment]->ClearEndOfInput();
+  m_write = segment;
+  Touch(segment);
+}
+
+void CSegmentedCache::EndOfInput()
+{
+  CCacheStrategy::EndOfInput();
+
+  // the other segments stop wherever they stopped, only the written one reached the end
+  CSingleLock lock(m_sync);
+  if (!m_segments.empty())
+    m_segments[m_write]->EndOfInput();
+}
+
+bool CSegmentedCache::IsEndOfInput()
+{
+  CSingleLock lock(m_sync);
+  if (m_segments.empty())
+    return CCacheStrategy::IsEndOfInput();
+  return m_segments[m_read]->IsEndOfInput();
+}
+
+size_t CSegmentedCache::NextSegment(size_t exclude)
+{
+  // keep what the current segment holds, unless there is nothing worth keeping
+  if (m_write != exclude && m_segments[m_write]->CachedDataBeginPos() == m_segments[m_write]->CachedDataEndPos())
+    return m_write;
+
+  if (m_segments.size() < m_maxSegments)
+  {
+    CCircularCache *cache = new CCircularCache(m_front, m_back);
+    if (cache->Open() == CACHE_RC_OK)
+    {
+      m_segments.push_back(cache);
+      m_lastUsed.push_back(0);
+      return m_segments.size() - 1;
+    }
+    CLog::Log(LOGWARNING, "CSegmentedCache::NextSegment - unable to allocate another segment");
+    delete cache;
+  }
+
+  size_t segment = m_segments.size();
+  for (size_t i = 0; i < m_segments.size(); i++)
+  {
+    if (i != exclude && (segment == m_segments.size() || m_lastUsed[i] < m_lastUsed[segment]))
+      segment = i;
+  }
+  return segment;
+}
+
+void CSegmentedCache::Touch(size_t segment)
+{
+  m_lastUsed[segment] = ++m_useCounter;
+}
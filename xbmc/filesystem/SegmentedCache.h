@@ -0,0 +1,84 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef CACHESEGMENTED_H
+#define CACHESEGMENTED_H
+
+#include "CacheStrategy.h"
+#include "threads/CriticalSection.h"
+
+#include <vector>
+
+namespace XFILE {
+
+class CCircularCache;
+
+/**
+ * Cache strategy keeping several independently filled regions of the file,
+ * each one a CCircularCache. A seek outside the region being written starts
+ * a new one instead of throwing the cache away, so that seeking back, for
+ * instance from the index at the end of the file to the playback position,
+ * is served from memory. The least recently used region is reused once
+ * the maximum number of regions is reached.
+ */
+class CSegmentedCache : public CCacheStrategy
+{
+public:
+    CSegmentedCache(size_t front, size_t back, unsigned int segments);
+    virtual ~CSegmentedCache();
+
+    virtual int Open() ;
+    virtual void Close();
+
+    virtual int WriteToCache(const char *buf, size_t len) ;
+    virtual int ReadFromCache(char *buf, size_t len) ;
+    virtual int64_t WaitForData(unsigned int minimum, unsigned int iMillis) ;
+
+    virtual int GetWriteBuffer(char **buf, size_t len);
+    virtual void CommitWriteBuffer(size_t len);
+    virtual int GetReadBuffer(const char **buf, size_t len);
+    virtual void ReleaseReadBuffer(size_t len);
+
+    virtual int64_t Seek(int64_t pos) ;
+    virtual void Reset(int64_t pos) ;
+
+    virtual int64_t GetResumePosition();
+    virtual void Resume(int64_t pos);
+
+    virtual void EndOfInput();
+    virtual bool IsEndOfInput();
+
+protected:
+    size_t NextSegment(size_t exclude);   /**< segment to write a new region to, other than exclude, m_segments.size() if none */
+    void Touch(size_t segment);
+
+    std::vector<CCircularCache*> m_segments;
+    std::vector<unsigned int>    m_lastUsed;    /**< when each segment was last read from or written to */
+    unsigned int                 m_useCounter;
+    size_t                       m_read;        /**< segment holding the read position */
+    size_t                       m_write;       /**< segment the source is written to */
+    size_t                       m_front;
+    size_t                       m_back;
+    unsigned int                 m_maxSegments;
+    CCriticalSection             m_sync;
+};
+
+} // namespace XFILE
+#endif
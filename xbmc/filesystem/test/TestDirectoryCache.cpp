@@ -0,0 +1,281 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/DirectoryCache.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "settings/AdvancedSettings.h"
+#include "FileItem.h"
+
+#include "gtest/gtest.h"
+
+#define TEST_DIR   "special://temp/TestDirectoryCache"
+#define CACHE_FILE "special://temp/directorycache.dat"
+
+using namespace XFILE;
+
+/* lets the tests expire a listing without waiting for its ttl */
+class CTestDirectoryCache : public CDirectoryCache
+{
+public:
+  void Expire(const CStdString &path)
+  {
+    iCache i = m_cache.find(path);
+    if (i != m_cache.end())
+      i->second->m_expiry.SetExpired();
+  }
+};
+
+class TestDirectoryCache : public testing::Test
+{
+protected:
+  TestDirectoryCache()
+  {
+    m_cacheSize = g_advancedSettings.m_dirCacheSize;
+    m_cacheTTL = g_advancedSettings.m_dirCacheTTL;
+    m_cachePersist = g_advancedSettings.m_dirCachePersist;
+  }
+
+  ~TestDirectoryCache()
+  {
+    g_advancedSettings.m_dirCacheSize = m_cacheSize;
+    g_advancedSettings.m_dirCacheTTL = m_cacheTTL;
+    g_advancedSettings.m_dirCachePersist = m_cachePersist;
+    CDirectory::Remove(TEST_DIR);
+    CFile::Delete(CACHE_FILE);
+  }
+
+  static void FillListing(const CStdString &path, int count, CFileItemList &items)
+  {
+    items.Clear();
+    items.SetPath(path);
+    for (int i = 0; i < count; i++)
+    {
+      CStdString file;
+      file.Format("%s/file%04i.mkv", path.c_str(), i);
+      items.Add(CFileItemPtr(new CFileItem(file, false)));
+    }
+  }
+
+  int m_cacheSize;
+  int m_cacheTTL;
+  bool m_cachePersist;
+};
+
+TEST_F(TestDirectoryCache, GetDirectory)
+{
+  CDirectoryCache cache;
+  CFileItemList items, cached;
+  FillListing("/test/dir", 10, items);
+  cache.SetDirectory("/test/dir/", items, DIR_CACHE_ALWAYS);
+
+  EXPECT_TRUE(cache.GetDirectory("/test/dir", cached));
+  EXPECT_EQ(10, cached.Size());
+  EXPECT_FALSE(cache.GetDirectory("/test/other", cached));
+
+  CDirectoryCache::Stats stats;
+  cache.GetStats(stats);
+  EXPECT_EQ(1U, stats.hits);
+  EXPECT_EQ(1U, stats.misses);
+  EXPECT_EQ(1U, stats.dirs);
+  EXPECT_EQ(10U, stats.items);
+}
+
+TEST_F(TestDirectoryCache, Copies)
+{
+  /* callers change the items they get, that must not show up in the cache */
+  CDirectoryCache cache;
+  CFileItemList items, cached;
+  FillListing("/test/dir", 10, items);
+  cache.SetDirectory("/test/dir", items, DIR_CACHE_ALWAYS);
+
+  ASSERT_TRUE(cache.GetDirectory("/test/dir", cached));
+  cached[0]->SetPath("/test/dir/changed.mkv");
+
+  bool inCache;
+  EXPECT_TRUE(cache.FileExists("/test/dir/file0000.mkv", inCache));
+  EXPECT_TRUE(inCache);
+  EXPECT_FALSE(cache.FileExists("/test/dir/changed.mkv", inCache));
+}
+
+TEST_F(TestDirectoryCache, AddFile)
+{
+  CDirectoryCache cache;
+  CFileItemList items, before, after;
+  FillListing("/test/dir", 10, items);
+  cache.SetDirectory("/test/dir", items, DIR_CACHE_ALWAYS);
+
+  ASSERT_TRUE(cache.GetDirectory("/test/dir", before));
+  cache.AddFile("/test/dir/new.mkv");
+  ASSERT_TRUE(cache.GetDirectory("/test/dir", after));
+
+  EXPECT_EQ(10, before.Size());
+  EXPECT_EQ(11, after.Size());
+  bool inCache;
+  EXPECT_TRUE(cache.FileExists("/test/dir/new.mkv", inCache));
+}
+
+TEST_F(TestDirectoryCache, Eviction)
+{
+  g_advancedSettings.m_dirCacheSize = 256;
+
+  CDirectoryCache cache;
+  CFileItemList items;
+  for (int i = 0; i < 100; i++)
+  {
+    CStdString path;
+    path.Format("/test/dir%03i", i);
+    FillListing(path, 10, items);
+    cache.SetDirectory(path, items, DIR_CACHE_ONCE);
+
+    /* keep the first directory in use, so it is never the least recently used */
+    CFileItemList cached;
+    EXPECT_TRUE(cache.GetDirectory("/test/dir000", cached, true)) << path;
+  }
+
+  CDirectoryCache::Stats stats;
+  cache.GetStats(stats);
+  EXPECT_GT(stats.evictions, 0U);
+  EXPECT_LE(stats.size, 256U * 1024);
+  EXPECT_EQ(100U - stats.evictions, stats.dirs);
+
+  CFileItemList cached;
+  EXPECT_FALSE(cache.GetDirectory("/test/dir001", cached, true));
+  EXPECT_TRUE(cache.GetDirectory("/test/dir099", cached, true));
+}
+
+TEST_F(TestDirectoryCache, EvictionKeepsAlways)
+{
+  g_advancedSettings.m_dirCacheSize = 256;
+
+  CDirectoryCache cache;
+  CFileItemList items, cached;
+  FillListing("/test/always", 10, items);
+  cache.SetDirectory("/test/always", items, DIR_CACHE_ALWAYS);
+
+  /* the always cached directory is the least recently used from here on */
+  for (int i = 0; i < 100; i++)
+  {
+    CStdString path;
+    path.Format("/test/dir%03i", i);
+    FillListing(path, 10, items);
+    cache.SetDirectory(path, items, DIR_CACHE_ONCE);
+  }
+
+  CDirectoryCache::Stats stats;
+  cache.GetStats(stats);
+  EXPECT_GT(stats.evictions, 0U);
+  EXPECT_TRUE(cache.GetDirectory("/test/always", cached));
+  EXPECT_EQ(10, cached.Size());
+}
+
+TEST_F(TestDirectoryCache, Expiry)
+{
+  g_advancedSettings.m_dirCacheTTL = 60;
+  ASSERT_TRUE(CDirectory::Create(TEST_DIR));
+
+  CTestDirectoryCache cache;
+  CFileItemList items, cached;
+  FillListing("/test/dir", 10, items);
+  cache.SetDirectory("/test/dir", items, DIR_CACHE_ONCE);
+  FillListing(TEST_DIR, 10, items);
+  cache.SetDirectory(TEST_DIR, items, DIR_CACHE_ONCE);
+
+  /* used without asking the filesystem until the ttl is up */
+  EXPECT_TRUE(cache.GetDirectory("/test/dir", cached));
+  EXPECT_TRUE(cache.GetDirectory(TEST_DIR, cached));
+
+  /* then a listing without a modification time has to be read again, one with
+     is revalidated against the directory */
+  cache.Expire("/test/dir");
+  cache.Expire(TEST_DIR);
+  EXPECT_FALSE(cache.GetDirectory("/test/dir", cached));
+  EXPECT_TRUE(cache.GetDirectory(TEST_DIR, cached));
+  EXPECT_EQ(10, cached.Size());
+
+  /* a directory that changed isn't used anymore */
+  cache.Expire(TEST_DIR);
+  ASSERT_TRUE(CDirectory::Remove(TEST_DIR));
+  EXPECT_FALSE(cache.GetDirectory(TEST_DIR, cached));
+
+  CDirectoryCache::Stats stats;
+  cache.GetStats(stats);
+  EXPECT_EQ(1U, stats.dirs);
+}
+
+TEST_F(TestDirectoryCache, Persistence)
+{
+  g_advancedSettings.m_dirCachePersist = true;
+  ASSERT_TRUE(CDirectory::Create(TEST_DIR));
+
+  {
+    CDirectoryCache cache;
+    CFileItemList items;
+    FillListing(TEST_DIR, 10, items);
+    cache.SetDirectory(TEST_DIR, items, DIR_CACHE_ONCE);
+    /* without a modification time it can't be revalidated, so it isn't saved */
+    FillListing("/test/dir", 10, items);
+    cache.SetDirectory("/test/dir", items, DIR_CACHE_ALWAYS);
+    ASSERT_TRUE(cache.Save());
+  }
+
+  CDirectoryCache cache;
+  ASSERT_TRUE(cache.Load());
+  CDirectoryCache::Stats stats;
+  cache.GetStats(stats);
+  EXPECT_EQ(1U, stats.dirs);
+  EXPECT_EQ(10U, stats.items);
+
+  /* restored listings aren't trusted before they are revalidated */
+  CStdString file;
+  file.Format("%s/file0000.mkv", TEST_DIR);
+  bool inCache;
+  EXPECT_FALSE(cache.FileExists(file, inCache));
+  EXPECT_FALSE(inCache);
+
+  CFileItemList cached;
+  EXPECT_TRUE(cache.GetDirectory(TEST_DIR, cached, true));
+  EXPECT_EQ(10, cached.Size());
+  EXPECT_EQ(file, cached[0]->GetPath());
+  EXPECT_TRUE(cache.FileExists(file, inCache));
+  EXPECT_TRUE(inCache);
+  EXPECT_FALSE(cache.GetDirectory("/test/dir", cached));
+
+  /* nothing is restored from an outdated directory */
+  CDirectoryCache outdated;
+  ASSERT_TRUE(outdated.Load());
+  ASSERT_TRUE(CDirectory::Remove(TEST_DIR));
+  EXPECT_FALSE(outdated.GetDirectory(TEST_DIR, cached, true));
+}
+
+TEST_F(TestDirectoryCache, ClearSubPaths)
+{
+  CDirectoryCache cache;
+  CFileItemList items, cached;
+  FillListing("/test/dir", 1, items);
+  cache.SetDirectory("/test/dir", items, DIR_CACHE_ALWAYS);
+  cache.SetDirectory("/test/dir/sub", items, DIR_CACHE_ALWAYS);
+  cache.SetDirectory("/test/other", items, DIR_CACHE_ALWAYS);
+
+  cache.ClearSubPaths("/test/dir");
+  EXPECT_FALSE(cache.GetDirectory("/test/dir", cached));
+  EXPECT_FALSE(cache.GetDirectory("/test/dir/sub", cached));
+  EXPECT_TRUE(cache.GetDirectory("/test/other", cached));
+}
@@ -0,0 +1,492 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+#include "filesystem/CircularCache.h"
+#include "filesystem/FileCache.h"
+#include "filesystem/SegmentedCache.h"
+#include "filesystem/File.h"
+#include "filesystem/IFile.h"
+#include "test/TestUtils.h"
+#include "threads/Event.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "threads/Thread.h"
+#include "URL.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+using namespace XFILE;
+
+#define TEST_FILE_SIZE (64 * 1024 * 1024)
+
+static inline uint8_t PatternByte(int64_t pos)
+{
+  return (uint8_t)(pos ^ (pos >> 8) ^ (pos >> 16));
+}
+
+static void WritePattern(CCacheStrategy &cache, int64_t pos, size_t len)
+{
+  std::vector<char> buffer(len);
+  for (size_t i = 0; i < len; i++)
+    buffer[i] = PatternByte(pos + i);
+
+  size_t done = 0;
+  while (done < len)
+  {
+    int rc = cache.WriteToCache(&buffer[done], len - done);
+    ASSERT_GT(rc, 0);
+    done += rc;
+  }
+}
+
+static void CheckPattern(CCacheStrategy &cache, int64_t pos, size_t len)
+{
+  std::vector<char> buffer(len);
+  size_t done = 0;
+  while (done < len)
+  {
+    int rc = cache.ReadFromCache(&buffer[done], len - done);
+    ASSERT_GT(rc, 0) << "at " << pos + done;
+    done += rc;
+  }
+
+  for (size_t i = 0; i < len; i++)
+    ASSERT_EQ(PatternByte(pos + i), (uint8_t)buffer[i]) << "at " << pos + i;
+}
+
+TEST(TestFileCache, SegmentedSeekBack)
+{
+  CSegmentedCache cache(1024 * 1024, 256 * 1024, 2);
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  /* the start of the file, then the index at the end */
+  WritePattern(cache, 0, 64 * 1024);
+  cache.Reset(TEST_FILE_SIZE - 32 * 1024);
+  WritePattern(cache, TEST_FILE_SIZE - 32 * 1024, 32 * 1024);
+  cache.EndOfInput();
+  CheckPattern(cache, TEST_FILE_SIZE - 32 * 1024, 32 * 1024);
+  EXPECT_EQ(-1, cache.GetResumePosition());
+
+  /* back to the start is served from memory, the source only has to catch up */
+  EXPECT_EQ(1000, cache.Seek(1000));
+  EXPECT_FALSE(cache.IsEndOfInput());
+  EXPECT_EQ(64 * 1024, cache.GetResumePosition());
+  CheckPattern(cache, 1000, 64 * 1024 - 1000);
+  EXPECT_EQ(CACHE_RC_WOULD_BLOCK, cache.ReadFromCache(NULL, 1));
+
+  cache.Resume(64 * 1024);
+  EXPECT_EQ(-1, cache.GetResumePosition());
+  WritePattern(cache, 64 * 1024, 64 * 1024);
+  CheckPattern(cache, 64 * 1024, 64 * 1024);
+
+  /* and the end is still there */
+  EXPECT_EQ(TEST_FILE_SIZE - 1000, cache.Seek(TEST_FILE_SIZE - 1000));
+  EXPECT_EQ(-1, cache.GetResumePosition());
+  CheckPattern(cache, TEST_FILE_SIZE - 1000, 1000);
+  EXPECT_EQ(0, cache.ReadFromCache(NULL, 1));
+}
+
+TEST(TestFileCache, SegmentedRecycle)
+{
+  CSegmentedCache cache(1024 * 1024, 256 * 1024, 2);
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  WritePattern(cache, 0, 1024);
+  cache.Reset(1024 * 1024);
+  WritePattern(cache, 1024 * 1024, 1024);
+  EXPECT_EQ(0, cache.Seek(0));
+  EXPECT_EQ(1024 * 1024, cache.Seek(1024 * 1024));
+
+  /* the segment at 0 was used least recently, so it makes way */
+  cache.Reset(2 * 1024 * 1024);
+  WritePattern(cache, 2 * 1024 * 1024, 1024);
+  EXPECT_EQ(CACHE_RC_ERROR, cache.Seek(0));
+  EXPECT_EQ(1024 * 1024, cache.Seek(1024 * 1024));
+  EXPECT_EQ(2 * 1024 * 1024, cache.Seek(2 * 1024 * 1024));
+}
+
+TEST(TestFileCache, CircularSpans)
+{
+  /* fill and drain through the spans, several times round the buffer */
+  CCircularCache cache(48 * 1024, 16 * 1024);
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  const char *data;
+  EXPECT_EQ(CACHE_RC_WOULD_BLOCK, cache.GetReadBuffer(&data, 1));
+
+  int64_t written = 0, read = 0;
+  while (read < 1024 * 1024)
+  {
+    char *space;
+    int size = cache.GetWriteBuffer(&space, 10000);
+    ASSERT_GE(size, 0);
+    for (int i = 0; i < size; i++)
+      space[i] = PatternByte(written + i);
+    cache.CommitWriteBuffer(size);
+    written += size;
+
+    size = cache.GetReadBuffer(&data, 7000);
+    ASSERT_GT(size, 0);
+    for (int i = 0; i < size; i++)
+      ASSERT_EQ(PatternByte(read + i), (uint8_t)data[i]) << "at " << read + i;
+    cache.ReleaseReadBuffer(size);
+    read += size;
+  }
+
+  /* the data borrowed is never handed out for writing */
+  int size = cache.GetReadBuffer(&data, 64 * 1024);
+  ASSERT_GT(size, 0);
+  char *space;
+  int free;
+  while ((free = cache.GetWriteBuffer(&space, 64 * 1024)) > 0)
+  {
+    EXPECT_TRUE(space + free <= data || space >= data + size);
+    cache.CommitWriteBuffer(1);
+  }
+  cache.ReleaseReadBuffer(size);
+
+  /* nor can it be seeked back to once it is about to be overwritten */
+  EXPECT_EQ(CACHE_RC_ERROR, cache.Seek(read - 48 * 1024));
+}
+
+/* reads through the whole CFileCache, its source thread included, and checks what comes out */
+static void CheckFileCache(CFileCache &file, int64_t pos, unsigned int len)
+{
+  ASSERT_EQ(pos, file.Seek(pos, SEEK_SET));
+
+  std::vector<char> buffer(len);
+  unsigned int done = 0;
+  while (done < len)
+  {
+    unsigned int rc = file.Read(&buffer[done], len - done);
+    ASSERT_GT(rc, 0U) << "at " << pos + done;
+    done += rc;
+  }
+
+  for (unsigned int i = 0; i < len; i++)
+    ASSERT_EQ(PatternByte(pos + i), (uint8_t)buffer[i]) << "at " << pos + i;
+}
+
+TEST(TestFileCache, SegmentedStaleResume)
+{
+  CSegmentedCache cache(1024 * 1024, 256 * 1024, 2);
+  ASSERT_EQ(CACHE_RC_OK, cache.Open());
+
+  WritePattern(cache, 0, 64 * 1024);
+  cache.Reset(TEST_FILE_SIZE - 32 * 1024);
+  WritePattern(cache, TEST_FILE_SIZE - 32 * 1024, 32 * 1024);
+
+  /* a resume is requested, but the reader is back at the end before it is handled */
+  EXPECT_EQ(1000, cache.Seek(1000));
+  EXPECT_EQ(64 * 1024, cache.GetResumePosition());
+  EXPECT_EQ(TEST_FILE_SIZE - 1000, cache.Seek(TEST_FILE_SIZE - 1000));
+  cache.Resume(64 * 1024);
+
+  /* which leaves the reader where it is, and the source writes elsewhere */
+  CheckPattern(cache, TEST_FILE_SIZE - 1000, 1000);
+  WritePattern(cache, 64 * 1024, 64 * 1024);
+  EXPECT_EQ(TEST_FILE_SIZE - 32 * 1024, cache.Seek(TEST_FILE_SIZE - 32 * 1024));
+  CheckPattern(cache, TEST_FILE_SIZE - 32 * 1024, 32 * 1024);
+  EXPECT_EQ(100 * 1024, cache.Seek(100 * 1024));
+  CheckPattern(cache, 100 * 1024, 28 * 1024);
+}
+
+TEST(TestFileCache, AccessPattern)
+{
+  static const int64_t size = 4 * 1024 * 1024;
+
+  XFILE::CFile *source;
+  ASSERT_TRUE((source = XBMC_CREATETEMPFILE("")) != NULL);
+  source->Close();
+  ASSERT_TRUE(source->OpenForWrite(XBMC_TEMPFILEPATH(source), true));
+  std::vector<char> data(64 * 1024);
+  for (int64_t pos = 0; pos < size; pos += data.size())
+  {
+    for (size_t i = 0; i < data.size(); i++)
+      data[i] = PatternByte(pos + i);
+    ASSERT_EQ((int)data.size(), source->Write(&data[0], data.size()));
+  }
+  source->Close();
+
+  /* an mp4 with the index at the end, played back and skipped around in */
+  static const struct { int64_t pos; unsigned int size; } pattern[] =
+  {
+    { 0                 , 64 * 1024   }, // header
+    { size - 256 * 1024 , 256 * 1024  }, // index
+    { 64 * 1024         , 1024 * 1024 }, // playback
+    { size - 128 * 1024 , 16 * 1024   }, // index lookup, while the source resumes playback
+    { 1024 * 1024       , 512 * 1024  }, // back to playback
+    { 128 * 1024        , 256 * 1024  }, // skip back
+    { size - 64 * 1024  , 64 * 1024   }, // index again
+    { 1536 * 1024       , 1024 * 1024 }, // and playback until the end of the segment
+  };
+
+  CFileCache file(new CSegmentedCache(1024 * 1024, 256 * 1024, 3));
+  ASSERT_TRUE(file.Open(CURL(XBMC_TEMPFILEPATH(source))));
+  for (unsigned int p = 0; p < sizeof(pattern) / sizeof(pattern[0]); p++)
+    CheckFileCache(file, pattern[p].pos, pattern[p].size);
+
+  /* seeking back and forth before the source thread catches up */
+  for (unsigned int i = 0; i < 20; i++)
+  {
+    int64_t pos = (i % 2) ? size - 4096 - i * 1024 : i * 64 * 1024;
+    CheckFileCache(file, pos, 4096);
+  }
+  file.Close();
+
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(source));
+}
+
+/* stand-in for a network source, with a limited bitrate and slow seeks */
+class CThrottledFile : public IFile
+{
+public:
+  CThrottledFile(unsigned int rate, unsigned int seekLatency)
+  {
+    m_rate = rate;
+    m_seekLatency = seekLatency;
+    m_pos = 0;
+    m_seeks = 0;
+    Throttle();
+  }
+
+  virtual bool Open(const CURL& url) { return true; }
+  virtual bool Exists(const CURL& url) { return true; }
+  virtual int Stat(const CURL& url, struct __stat64* buffer) { return -1; }
+  virtual void Close() {}
+  virtual int64_t GetPosition() { return m_pos; }
+  virtual int64_t GetLength() { return TEST_FILE_SIZE; }
+
+  virtual unsigned int Read(void* lpBuf, int64_t uiBufSize)
+  {
+    unsigned int size = (unsigned int)std::min(uiBufSize, (int64_t)TEST_FILE_SIZE - m_pos);
+    for (unsigned int i = 0; i < size; i++)
+      ((uint8_t*)lpBuf)[i] = PatternByte(m_pos + i);
+
+    m_pos += size;
+    m_sent += size;
+    unsigned int due = m_start + (unsigned int)(m_sent * 1000 / m_rate);
+    unsigned int now = XbmcThreads::SystemClockMillis();
+    if ((int)(due - now) > 0)
+      Sleep(due - now);
+    return size;
+  }
+
+  virtual int64_t Seek(int64_t iFilePosition, int iWhence = SEEK_SET)
+  {
+    Sleep(m_seekLatency);
+    m_seeks++;
+    m_pos = iFilePosition;
+    Throttle();
+    return m_pos;
+  }
+
+  unsigned int GetSeeks() const { return m_seeks; }
+
+private:
+  void Throttle()
+  {
+    m_start = XbmcThreads::SystemClockMillis();
+    m_sent = 0;
+  }
+
+  unsigned int m_rate;
+  unsigned int m_seekLatency;
+  unsigned int m_start;
+  int64_t      m_sent;
+  int64_t      m_pos;
+  unsigned int m_seeks;
+};
+
+/* the source side of CFileCache, reduced to filling the cache and handling seeks */
+class CCacheFiller : public CThread
+{
+public:
+  CCacheFiller(CCacheStrategy &cache, IFile &source)
+    : CThread("CCacheFiller"), m_cache(cache), m_source(source)
+  {
+    m_seekPos = 0;
+    m_seekResume = false;
+  }
+
+  void RequestSeek(int64_t pos, bool resume)
+  {
+    {
+      CSingleLock lock(m_sync);
+      m_seekPos = pos;
+      m_seekResume = resume;
+    }
+    m_seekEvent.Set();
+    if (!resume)
+      m_seekEnded.Wait();
+  }
+
+  virtual void StopThread(bool bWait = true)
+  {
+    m_bStop = true;
+    m_seekEvent.Set();
+    CThread::StopThread(bWait);
+  }
+
+protected:
+  virtual void Process()
+  {
+    std::vector<char> buffer(64 * 1024);
+    while (!m_bStop)
+    {
+      if (m_seekEvent.WaitMSec(0))
+      {
+        int64_t pos;
+        bool resume;
+        {
+          CSingleLock lock(m_sync);
+          pos = m_seekPos;
+          resume = m_seekResume;
+        }
+        m_source.Seek(pos);
+        if (resume)
+          m_cache.Resume(pos);
+        else
+        {
+          m_cache.Reset(pos);
+          m_seekEnded.Set();
+        }
+      }
+
+      unsigned int read = m_source.Read(&buffer[0], buffer.size());
+      if (read == 0)
+      {
+        m_cache.EndOfInput();
+        if (AbortableWait(m_seekEvent) != WAIT_SIGNALED)
+          break;
+        m_cache.ClearEndOfInput();
+        m_seekEvent.Set();
+        continue;
+      }
+
+      unsigned int written = 0;
+      while (!m_bStop && written < read)
+      {
+        int rc = m_cache.WriteToCache(&buffer[written], read - written);
+        if (rc < 0)
+          return;
+        if (rc == 0)
+        {
+          if (m_seekEvent.WaitMSec(0))
+          {
+            m_seekEvent.Set();
+            break;
+          }
+          m_cache.m_space.WaitMSec(5);
+        }
+        written += rc;
+      }
+    }
+  }
+
+  CCacheStrategy  &m_cache;
+  IFile           &m_source;
+  CCriticalSection m_sync;
+  CEvent           m_seekEvent;
+  CEvent           m_seekEnded;
+  int64_t          m_seekPos;
+  bool             m_seekResume;
+};
+
+/* plays an mp4 with the index at the end, and returns the time spent waiting for data */
+static unsigned int PlayAccessPattern(CCacheStrategy &cache, CThrottledFile &source)
+{
+  CCacheFiller filler(cache, source);
+  EXPECT_EQ(CACHE_RC_OK, cache.Open());
+  filler.Create();
+
+  static const struct { int64_t pos; unsigned int size; } pattern[] =
+  {
+    { 0                          , 64 * 1024        }, // header
+    { TEST_FILE_SIZE - 2097152   , 2 * 1024 * 1024  }, // index
+    { 64 * 1024                  , 8 * 1024 * 1024  }, // playback
+    { 1024 * 1024                , 2 * 1024 * 1024  }, // skip back
+    { TEST_FILE_SIZE - 1048576   , 256 * 1024       }, // index lookup
+    { 3 * 1024 * 1024            , 4 * 1024 * 1024  }, // back to playback
+  };
+
+  unsigned int stall = 0;
+  std::vector<char> buffer(256 * 1024);
+  for (unsigned int p = 0; p < sizeof(pattern) / sizeof(pattern[0]); p++)
+  {
+    int64_t pos = pattern[p].pos;
+    if (cache.Seek(pos) == pos)
+    {
+      int64_t resume = cache.GetResumePosition();
+      if (resume >= 0)
+        filler.RequestSeek(resume, true);
+    }
+    else
+    {
+      unsigned int start = XbmcThreads::SystemClockMillis();
+      filler.RequestSeek(pos, false);
+      stall += XbmcThreads::SystemClockMillis() - start;
+    }
+
+    unsigned int done = 0;
+    while (done < pattern[p].size)
+    {
+      unsigned int size = std::min((unsigned int)buffer.size(), pattern[p].size - done);
+      int rc = cache.ReadFromCache(&buffer[0], size);
+      if (rc == CACHE_RC_WOULD_BLOCK)
+      {
+        unsigned int start = XbmcThreads::SystemClockMillis();
+        cache.WaitForData(1, 10000);
+        stall += XbmcThreads::SystemClockMillis() - start;
+        continue;
+      }
+      EXPECT_GT(rc, 0);
+      if (rc <= 0)
+        break;
+
+      for (int i = 0; i < rc; i++)
+        EXPECT_EQ(PatternByte(pos + done + i), (uint8_t)buffer[i]) << "at " << pos + done + i;
+      done += rc;
+    }
+  }
+
+  filler.StopThread();
+  cache.Close();
+  return stall;
+}
+
+/* a benchmark, run it with --gtest_also_run_disabled_tests */
+TEST(TestFileCache, DISABLED_StallTime)
+{
+  /* 16MB/s with 200ms to reconnect after a seek */
+  CThrottledFile circularSource(16 * 1024 * 1024, 200);
+  CCircularCache circular(8 * 1024 * 1024, 2 * 1024 * 1024);
+  unsigned int circularStall = PlayAccessPattern(circular, circularSource);
+
+  CThrottledFile segmentedSource(16 * 1024 * 1024, 200);
+  CSegmentedCache segmented(8 * 1024 * 1024, 2 * 1024 * 1024, 3);
+  unsigned int segmentedStall = PlayAccessPattern(segmented, segmentedSource);
+
+  std::cout << "CCircularCache stalled " << circularStall << "ms with " << circularSource.GetSeeks() << " source seeks, "
+            << "CSegmentedCache stalled " << segmentedStall << "ms with " << segmentedSource.GetSeeks() << " source seeks" << std::endl;
+}
@@ -29,6 +29,7 @@
 #include "JpegIO.h"
 
 #include <setjmp.h>
+#include <algorithm>
 
 #define EXIF_TAG_ORIENTATION    0x0112
 
@@ -306,9 +307,11 @@ bool CJpegIO::Read(unsigned char* buffer, unsigned int bufSize, unsigned int min
     num/denom, where (for our purposes) that is [1-8]/8 where 8/8 is the unscaled image.
     The only way to know how big a resulting image will be is to try a ratio and
     test its resulting size.
-    If the res is greater than the one desired, use that one since there's no need
+    If the res covers the one desired, use that one since there's no need
     to decode a bigger one just to squish it back down. If the res is greater than
-    the gpu can hold, use the previous one.*/
+    the gpu can hold, use the previous one.
+    The desired res is the image scaled to fit within minx x miny, so only the
+    dimension that limits the fit needs to cover the box.*/
     if (minx == 0 || miny == 0)
     {
       miny = g_advancedSettings.m_imageRes;
@@ -323,6 +326,13 @@ bool CJpegIO::Read(unsigned char* buffer, unsigned int bufSize, unsigned int min
       minx = miny * 16/9;
     }
 
+    unsigned int targetx = std::min(minx, m_cinfo.image_width);
+    unsigned int targety = std::min(miny, m_cinfo.image_height);
+    if ((uint64_t)m_cinfo.image_width * miny > (uint64_t)m_cinfo.image_height * minx)
+      targety = (unsigned int)(((uint64_t)m_cinfo.image_height * targetx + m_cinfo.image_width - 1) / m_cinfo.image_width);
+    else
+      targetx = (unsigned int)(((uint64_t)m_cinfo.image_width * targety + m_cinfo.image_height - 1) / m_cinfo.image_height);
+
     m_cinfo.scale_denom = 8;
     m_cinfo.out_color_space = JCS_RGB;
     unsigned int maxtexsize = g_Windowing.GetMaxTextureSize();
@@ -334,7 +344,7 @@ bool CJpegIO::Read(unsigned char* buffer, unsigned int bufSize, unsigned int min
         m_cinfo.scale_num--;
         break;
       }
-      if (m_cinfo.output_width >= minx && m_cinfo.output_height >= miny)
+      if (m_cinfo.output_width >= targetx && m_cinfo.output_height >= targety)
         break;
     }
     jpeg_calc_output_dimensions(&m_cinfo);
@@ -206,10 +206,10 @@ CBaseTexture *CBaseTexture::LoadFromFile(const CStdString& texturePath, unsigned
   return NULL;
 }
 
-CBaseTexture *CBaseTexture::LoadFromFileInMemory(unsigned char *buffer, size_t bufferSize, const std::string &mimeType, unsigned int idealWidth, unsigned int idealHeight)
+CBaseTexture *CBaseTexture::LoadFromFileInMemory(unsigned char *buffer, size_t bufferSize, const std::string &mimeType, unsigned int idealWidth, unsigned int idealHeight, bool autoRotate)
 {
   CTexture *texture = new CTexture();
-  if (texture->LoadFromFileInMem(buffer, bufferSize, mimeType, idealWidth, idealHeight))
+  if (texture->LoadFromFileInMem(buffer, bufferSize, mimeType, idealWidth, idealHeight, autoRotate))
     return texture;
   delete texture;
   return NULL;
@@ -345,7 +345,7 @@ bool CBaseTexture::LoadFromFileInternal(const CStdString& texturePath, unsigned
   return true;
 }
 
-bool CBaseTexture::LoadFromFileInMem(unsigned char* buffer, size_t size, const std::string& mimeType, unsigned int maxWidth, unsigned int maxHeight)
+bool CBaseTexture::LoadFromFileInMem(unsigned char* buffer, size_t size, const std::string& mimeType, unsigned int maxWidth, unsigned int maxHeight, bool autoRotate)
 {
   if (!buffer || !size)
     return false;
@@ -361,6 +361,8 @@ bool CBaseTexture::LoadFromFileInMem(unsigned char* buffer, size_t size, const s
         Allocate(jpegfile.Width(), jpegfile.Height(), XB_FMT_A8R8G8B8);
         if (jpegfile.Decode(m_pixels, GetPitch(), XB_FMT_A8R8G8B8))
         {
+          if (autoRotate && jpegfile.Orientation())
+            m_orientation = jpegfile.Orientation() - 1;
           m_hasAlpha=false;
           ClampToEdge();
           return true;
@@ -388,7 +390,7 @@ bool CBaseTexture::LoadFromFileInMem(unsigned char* buffer, size_t size, const s
     CLog::Log(LOGERROR, "Texture manager unable to load image from memory");
     return false;
   }
-  LoadFromImage(image);
+  LoadFromImage(image, autoRotate);
   dll.ReleaseImage(&image);
 
   return true;
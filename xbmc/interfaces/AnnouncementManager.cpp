@@ -20,7 +20,9 @@
 
 #include "AnnouncementManager.h"
 #include "threads/SingleLock.h"
+#include "threads/Thread.h"
 #include <stdio.h>
+#include <deque>
 #include "utils/log.h"
 #include "utils/Variant.h"
 #include "utils/StringUtils.h"
@@ -38,12 +40,146 @@ using namespace ANNOUNCEMENT;
 
 #define m_announcers XBMC_GLOBAL_USE(ANNOUNCEMENT::CAnnouncementManager::Globals).m_announcers
 #define m_critSection XBMC_GLOBAL_USE(ANNOUNCEMENT::CAnnouncementManager::Globals).m_critSection
+#define m_synchronousAnnouncers XBMC_GLOBAL_USE(ANNOUNCEMENT::CAnnouncementManager::Globals).m_synchronousAnnouncers
+#define m_synchronousSection XBMC_GLOBAL_USE(ANNOUNCEMENT::CAnnouncementManager::Globals).m_synchronousSection
+#define m_dispatcher XBMC_GLOBAL_USE(ANNOUNCEMENT::CAnnouncementManager::Globals).m_dispatcher
+#define m_dispatcherSection XBMC_GLOBAL_USE(ANNOUNCEMENT::CAnnouncementManager::Globals).m_dispatcherSection
 
-void CAnnouncementManager::AddAnnouncer(IAnnouncer *listener)
+#define ANNOUNCEMENT_QUEUE_SIZE 4096
+
+namespace ANNOUNCEMENT
+{
+  /* an announcement waiting to be delivered */
+  class CAnnouncement
+  {
+  public:
+    CAnnouncement() : m_flag(Other), m_delivered(NULL) {}
+    CAnnouncement(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data, CEvent *delivered)
+      : m_flag(flag), m_sender(sender), m_message(message), m_data(data), m_delivered(delivered) {}
+
+    AnnouncementFlag m_flag;
+    std::string      m_sender;
+    std::string      m_message;
+    CVariant         m_data;
+    CEvent          *m_delivered; ///< set once the announcers have seen it, if not NULL
+  };
+
+  /* delivers announcements to the announcers on its own thread, so that whoever
+     announces doesn't wait on the announcers */
+  class CAnnouncementDispatcher : public CThread
+  {
+  public:
+    CAnnouncementDispatcher() : CThread("Announcements"), m_backlog(false) {}
+
+    void Queue(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data, CEvent *delivered = NULL)
+    {
+      CSingleLock lock(m_section);
+      if (!delivered && Coalesce(flag, sender, message, data))
+        return;
+
+      // nothing is dropped, a backlog only means the announcers are slow
+      if (m_queue.size() >= ANNOUNCEMENT_QUEUE_SIZE && !m_backlog)
+      {
+        CLog::Log(LOGWARNING, "CAnnouncementManager - %u announcements waiting to be delivered", (unsigned int)m_queue.size());
+        m_backlog = true;
+      }
+      m_queue.push_back(CAnnouncement(flag, sender, message, data, delivered));
+      m_pending.Set();
+    }
+
+    void Flush()
+    {
+      CSingleLock lock(m_section);
+      while (!m_queue.empty())
+      {
+        CAnnouncement announcement;
+        std::swap(announcement.m_flag, m_queue.front().m_flag);
+        announcement.m_sender.swap(m_queue.front().m_sender);
+        announcement.m_message.swap(m_queue.front().m_message);
+        announcement.m_data.swap(m_queue.front().m_data);
+        announcement.m_delivered = m_queue.front().m_delivered;
+        m_queue.pop_front();
+        lock.Leave();
+
+        CAnnouncementManager::Deliver(announcement.m_flag, announcement.m_sender.c_str(), announcement.m_message.c_str(), announcement.m_data);
+        if (announcement.m_delivered)
+          announcement.m_delivered->Set();
+
+        lock.Enter();
+      }
+      m_backlog = false;
+    }
+
+  protected:
+    virtual void Process()
+    {
+      while (!m_bStop)
+      {
+        AbortableWait(m_pending);
+        Flush();
+      }
+    }
+
+  private:
+    /* fold a high rate announcement into one about the same player or item that
+       is still queued, so that a burst of seeks or updates goes out once */
+    bool Coalesce(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
+    {
+      if (!((flag == Player && strcmp(message, "OnSeek") == 0) ||
+            ((flag == VideoLibrary || flag == AudioLibrary) && strcmp(message, "OnUpdate") == 0)))
+        return false;
+
+      const CVariant *subject = GetSubject(flag, data);
+      if (!subject)
+        return false;
+
+      for (std::deque<CAnnouncement>::reverse_iterator i = m_queue.rbegin(); i != m_queue.rend(); ++i)
+      {
+        if (i->m_flag != flag)
+          continue;
+        if (i->m_message != message || i->m_sender != sender)
+          return false; // don't reorder around anything else of the same kind
+        const CVariant *queuedSubject = GetSubject(flag, i->m_data);
+        if (!queuedSubject || !(*queuedSubject == *subject))
+          continue;
+
+        // later values win, anything only in the earlier one (such as a playcount) is kept
+        for (CVariant::const_iterator_map member = data.begin_map(); member != data.end_map(); ++member)
+          i->m_data[member->first] = member->second;
+        return true;
+      }
+      return false;
+    }
+
+    /* the player or library item an announcement is about */
+    static const CVariant *GetSubject(AnnouncementFlag flag, const CVariant &data)
+    {
+      if (!data.isObject())
+        return NULL;
+      if (flag == Player)
+        return data.isMember("player") && data["player"].isMember("playerid") ? &data["player"]["playerid"] : NULL;
+      return data.isMember("item") ? &data["item"] : NULL;
+    }
+
+    CCriticalSection          m_section;
+    std::deque<CAnnouncement> m_queue;
+    bool                      m_backlog;
+    CEvent                    m_pending;
+  };
+}
+
+void CAnnouncementManager::AddAnnouncer(IAnnouncer *listener, bool synchronous /* = false */)
 {
   if (!listener)
     return;
 
+  if (synchronous)
+  {
+    CSingleLock lock (m_synchronousSection);
+    m_synchronousAnnouncers.push_back(listener);
+    return;
+  }
+
   CSingleLock lock (m_critSection);
   m_announcers.push_back(listener);
 }
@@ -53,6 +189,20 @@ void CAnnouncementManager::RemoveAnnouncer(IAnnouncer *listener)
   if (!listener)
     return;
 
+  // the sections are taken one after the other, an announcer may remove itself
+  // while it's being told on either path
+  {
+    CSingleLock lock (m_synchronousSection);
+    for (unsigned int i = 0; i < m_synchronousAnnouncers.size(); i++)
+    {
+      if (m_synchronousAnnouncers[i] == listener)
+      {
+        m_synchronousAnnouncers.erase(m_synchronousAnnouncers.begin() + i);
+        return;
+      }
+    }
+  }
+
   CSingleLock lock (m_critSection);
   for (unsigned int i = 0; i < m_announcers.size(); i++)
   {
@@ -64,6 +214,31 @@ void CAnnouncementManager::RemoveAnnouncer(IAnnouncer *listener)
   }
 }
 
+void CAnnouncementManager::Initialize()
+{
+  CSingleLock lock(m_dispatcherSection);
+  if (!m_dispatcher)
+  {
+    m_dispatcher = new CAnnouncementDispatcher;
+    m_dispatcher->Create();
+  }
+}
+
+void CAnnouncementManager::Deinitialize()
+{
+  CSingleLock lock(m_dispatcherSection);
+  CAnnouncementDispatcher *dispatcher = m_dispatcher;
+  m_dispatcher = NULL;
+  lock.Leave();
+
+  if (dispatcher)
+  {
+    dispatcher->StopThread();
+    dispatcher->Flush();
+    delete dispatcher;
+  }
+}
+
 void CAnnouncementManager::Announce(AnnouncementFlag flag, const char *sender, const char *message)
 {
   CVariant data;
@@ -73,11 +248,56 @@ void CAnnouncementManager::Announce(AnnouncementFlag flag, const char *sender, c
 void CAnnouncementManager::Announce(AnnouncementFlag flag, const char *sender, const char *message, CVariant &data)
 {
   CLog::Log(LOGDEBUG, "CAnnouncementManager - Announcement: %s from %s", message, sender);
+
+  DeliverSynchronous(flag, sender, message, data);
+
+  CSingleLock lock(m_dispatcherSection);
+  if (!m_dispatcher)
+  {
+    // not initialized yet or deinitialized already
+    lock.Leave();
+    Deliver(flag, sender, message, data);
+    return;
+  }
+
+  if (flag != System)
+  {
+    m_dispatcher->Queue(flag, sender, message, data);
+    return;
+  }
+
+  // system announcements (sleep, quit, ...) have to reach the announcers before
+  // the caller goes on. they're queued all the same, so they don't overtake
+  // anything announced before them.
+  if (m_dispatcher->IsCurrentThread())
+  {
+    // announced by an announcer. the dispatcher isn't deleted under its own thread.
+    CAnnouncementDispatcher *dispatcher = m_dispatcher;
+    dispatcher->Queue(flag, sender, message, data);
+    lock.Leave();
+    dispatcher->Flush();
+    return;
+  }
+  CEvent delivered;
+  m_dispatcher->Queue(flag, sender, message, data, &delivered);
+  lock.Leave();
+  delivered.Wait();
+}
+
+void CAnnouncementManager::Deliver(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
+{
   CSingleLock lock (m_critSection);
   for (unsigned int i = 0; i < m_announcers.size(); i++)
     m_announcers[i]->Announce(flag, sender, message, data);
 }
 
+void CAnnouncementManager::DeliverSynchronous(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
+{
+  CSingleLock lock (m_synchronousSection);
+  for (unsigned int i = 0; i < m_synchronousAnnouncers.size(); i++)
+    m_synchronousAnnouncers[i]->Announce(flag, sender, message, data);
+}
+
 void CAnnouncementManager::Announce(AnnouncementFlag flag, const char *sender, const char *message, CFileItemPtr item)
 {
   CVariant data;
@@ -27,6 +27,8 @@
 
 namespace ANNOUNCEMENT
 {
+  class CAnnouncementDispatcher;
+
   class CAnnouncementManager
   {
   public:
@@ -34,17 +36,41 @@ namespace ANNOUNCEMENT
      class Globals
      {
      public:
+       Globals() : m_dispatcher(NULL) {}
        CCriticalSection m_critSection;
        std::vector<IAnnouncer *> m_announcers;
+       CCriticalSection m_synchronousSection;
+       std::vector<IAnnouncer *> m_synchronousAnnouncers;
+       CCriticalSection m_dispatcherSection;
+       CAnnouncementDispatcher *m_dispatcher;
      };
 
-    static void AddAnnouncer(IAnnouncer *listener);
+    /*! \brief Add an announcer.
+     \param listener the announcer to add.
+     \param synchronous true if the announcer reads the state of the application when
+     announced to (such as the file that's playing), it's then always told on the
+     announcing thread while that state still matches the announcement.
+     */
+    static void AddAnnouncer(IAnnouncer *listener, bool synchronous = false);
     static void RemoveAnnouncer(IAnnouncer *listener);
     static void Announce(AnnouncementFlag flag, const char *sender, const char *message);
     static void Announce(AnnouncementFlag flag, const char *sender, const char *message, CVariant &data);
     static void Announce(AnnouncementFlag flag, const char *sender, const char *message, CFileItemPtr item);
     static void Announce(AnnouncementFlag flag, const char *sender, const char *message, CFileItemPtr item, CVariant &data);
+
+    /*! \brief Start the dispatch thread, which delivers the announcements from
+     here on. Before, announcements are delivered on the announcing thread.
+     */
+    static void Initialize();
+
+    /*! \brief Stop the dispatch thread, delivering anything still queued.
+     From here on announcements are delivered on the announcing thread again.
+     */
+    static void Deinitialize();
   private:
+    friend class CAnnouncementDispatcher;
+    static void Deliver(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data);
+    static void DeliverSynchronous(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data);
   };
 }
 
@@ -194,10 +194,7 @@ JSONRPC_STATUS CVideoLibrary::GetTVShows(const CStdString &method, ITransportLay
   }
 
   if (additionalInfo)
-  {
-    for (int index = 0; index < items.Size(); index++)
-      videodatabase.GetTvShowInfo("", *(items[index]->GetVideoInfoTag()), items[index]->GetVideoInfoTag()->m_iDbId);
-  }
+    videodatabase.GetLinkedDetails(items);
 
   int size = items.Size();
   if (items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
@@ -771,15 +768,13 @@ JSONRPC_STATUS CVideoLibrary::GetAdditionalMovieDetails(const CVariant &paramete
       streamdetails = true;
   }
 
-  if (additionalInfo || streamdetails)
+  if (additionalInfo)
+    videodatabase.GetLinkedDetails(items);
+
+  if (streamdetails)
   {
     for (int index = 0; index < items.Size(); index++)
-    {
-      if (additionalInfo)
-        videodatabase.GetMovieInfo("", *(items[index]->GetVideoInfoTag()), items[index]->GetVideoInfoTag()->m_iDbId);
-      if (streamdetails)
-        videodatabase.GetStreamDetails(*(items[index]->GetVideoInfoTag()));
-    }
+      videodatabase.GetStreamDetails(*(items[index]->GetVideoInfoTag()));
   }
 
   int size = items.Size();
@@ -806,15 +801,13 @@ JSONRPC_STATUS CVideoLibrary::GetAdditionalEpisodeDetails(const CVariant &parame
       streamdetails = true;
   }
 
-  if (additionalInfo || streamdetails)
+  if (additionalInfo)
+    videodatabase.GetLinkedDetails(items);
+
+  if (streamdetails)
   {
     for (int index = 0; index < items.Size(); index++)
-    {
-      if (additionalInfo)
-        videodatabase.GetEpisodeInfo("", *(items[index]->GetVideoInfoTag()), items[index]->GetVideoInfoTag()->m_iDbId);
-      if (streamdetails)
-        videodatabase.GetStreamDetails(*(items[index]->GetVideoInfoTag()));
-    }
+      videodatabase.GetStreamDetails(*(items[index]->GetVideoInfoTag()));
   }
   
   int size = items.Size();
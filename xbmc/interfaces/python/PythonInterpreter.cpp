@@ -0,0 +1,274 @@
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+// python.h should always be included first before any other includes
+#include "PythonInterpreter.h"
+
+#include <string.h>
+
+// the attributes of sys that aren't restored
+static bool IsSkipped(PyObject *key)
+{
+  if (!PyString_Check(key))
+    return false;
+  const char *name = PyString_AsString(key);
+  return strcmp(name, "modules") == 0 || strcmp(name, "path") == 0;
+}
+
+// new ref, lists and dicts are copied so changing them doesn't change the copy
+static PyObject* CopyValue(PyObject *value)
+{
+  if (PyList_CheckExact(value))
+    return PyList_GetSlice(value, 0, PyList_GET_SIZE(value));
+  if (PyDict_CheckExact(value))
+    return PyDict_Copy(value);
+  Py_INCREF(value);
+  return value;
+}
+
+// borrowed ref to a loaded module, NULL if it isn't loaded
+static PyObject* GetModule(const char *name)
+{
+  PyObject *module = PyDict_GetItemString(PyImport_GetModuleDict(), name);
+  return module && PyModule_Check(module) ? module : NULL;
+}
+
+CPythonInterpreter::CPythonInterpreter(PyInterpreterState *interp)
+{
+  m_interp = interp;
+  m_sys    = PyDict_New();
+
+  PyObject *key, *value;
+  Py_ssize_t pos = 0;
+  while (m_sys && PyDict_Next(m_interp->sysdict, &pos, &key, &value))
+  {
+    if (IsSkipped(key))
+      continue;
+    PyObject *copy = CopyValue(value);
+    if (!copy || PyDict_SetItem(m_sys, key, copy) == -1)
+    {
+      // without the snapshot the interpreter isn't reused
+      Py_CLEAR(m_sys);
+    }
+    Py_XDECREF(copy);
+  }
+  PyErr_Clear();
+}
+
+CPythonInterpreter::~CPythonInterpreter()
+{
+  Py_XDECREF(m_sys);
+}
+
+bool CPythonInterpreter::Reset(const std::vector<std::string> &addonPaths)
+{
+  PyErr_Clear();
+
+  if (!m_sys || HasSocketTimeout())
+    return false;
+
+  DropModules(addonPaths);
+  if (!ReplaceMain() || !RestoreSys())
+  {
+    PyErr_Clear();
+    return false;
+  }
+  ResetModules();
+
+  PyGC_Collect();
+
+  bool bReset = !PyErr_Occurred();
+  PyErr_Clear();
+  return bReset;
+}
+
+void CPythonInterpreter::Adopt()
+{
+  PyObject *threading = GetModule("threading");
+  if (!threading)
+    return;
+
+  // like the module does when it's imported
+  PyObject *thread = PyObject_CallMethod(threading, (char*)"_MainThread", NULL);
+  PyObject *exitfunc = thread ? PyObject_GetAttrString(thread, (char*)"_exitfunc") : NULL;
+  if (exitfunc)
+    PyObject_SetAttrString(threading, (char*)"_shutdown", exitfunc);
+  Py_XDECREF(exitfunc);
+  Py_XDECREF(thread);
+  PyErr_Clear();
+}
+
+void CPythonInterpreter::DropModules(const std::vector<std::string> &addonPaths)
+{
+  // the modules of add-ons hold the globals of the script, they're imported
+  // again by the next one. the standard library and the xbmc modules stay.
+  PyObject *modules = PyImport_GetModuleDict(); // borrowed ref, no need to delete
+  std::vector<std::string> names, packages;
+  PyObject *key, *value;
+  Py_ssize_t pos = 0;
+  while (PyDict_Next(modules, &pos, &key, &value))
+  {
+    if (!PyString_Check(key))
+      continue;
+    names.push_back(PyString_AsString(key));
+
+    const char *file = PyModule_Check(value) ? PyModule_GetFilename(value) : NULL;
+    if (!file)
+    {
+      PyErr_Clear();
+      continue;
+    }
+    for (unsigned int i = 0; i < addonPaths.size(); i++)
+    {
+      if (!addonPaths[i].empty() && strncmp(file, addonPaths[i].c_str(), addonPaths[i].size()) == 0)
+      {
+        packages.push_back(names.back() + ".");
+        break;
+      }
+    }
+  }
+
+  // along with their submodules and the relative imports python remembered
+  for (unsigned int i = 0; i < names.size(); i++)
+  {
+    std::string name = names[i] + ".";
+    for (unsigned int j = 0; j < packages.size(); j++)
+    {
+      if (name.compare(0, packages[j].size(), packages[j]) == 0)
+      {
+        if (PyDict_DelItemString(modules, (char*)names[i].c_str()) == -1)
+          PyErr_Clear();
+        break;
+      }
+    }
+  }
+}
+
+bool CPythonInterpreter::ReplaceMain()
+{
+  // a new __main__ for the globals of the next script
+  PyObject *modules = PyImport_GetModuleDict(); // borrowed ref, no need to delete
+  PyObject *oldMain = PyDict_GetItemString(modules, "__main__"); // borrowed ref
+  Py_XINCREF(oldMain);
+  PyObject *main = PyModule_New((char*)"__main__");
+  if (!main || PyDict_SetItemString(PyModule_GetDict(main), "__builtins__", PyEval_GetBuiltins()) == -1 ||
+      PyDict_SetItemString(modules, "__main__", main) == -1)
+  {
+    Py_XDECREF(main);
+    Py_XDECREF(oldMain);
+    return false;
+  }
+  Py_DECREF(main);
+  if (oldMain)
+  {
+    // break the cycles between the functions of the old script and its globals
+    PyDict_Clear(PyModule_GetDict(oldMain));
+    Py_DECREF(oldMain);
+  }
+  return true;
+}
+
+bool CPythonInterpreter::RestoreSys()
+{
+  PyObject *sysdict = m_interp->sysdict;
+
+  // drop what the script added
+  PyObject *keys = PyDict_Keys(sysdict);
+  if (!keys)
+    return false;
+  for (Py_ssize_t i = 0; i < PyList_GET_SIZE(keys); i++)
+  {
+    PyObject *key = PyList_GET_ITEM(keys, i);
+    if (!IsSkipped(key) && !PyDict_GetItem(m_sys, key) && PyDict_DelItem(sysdict, key) == -1)
+    {
+      Py_DECREF(keys);
+      return false;
+    }
+  }
+  Py_DECREF(keys);
+
+  // and put back what it changed. lists and dicts that weren't changed stay,
+  // other modules may hold on to them.
+  PyObject *key, *value;
+  Py_ssize_t pos = 0;
+  while (PyDict_Next(m_sys, &pos, &key, &value))
+  {
+    PyObject *current = PyDict_GetItem(sysdict, key); // borrowed ref
+    if (current == value)
+      continue;
+    if (current && (PyList_CheckExact(value) || PyDict_CheckExact(value)) && Py_TYPE(current) == Py_TYPE(value))
+    {
+      int equal = PyObject_RichCompareBool(current, value, Py_EQ);
+      if (equal == 1)
+        continue;
+      if (equal == -1)
+        PyErr_Clear();
+    }
+    PyObject *copy = CopyValue(value);
+    if (!copy || PyDict_SetItem(sysdict, key, copy) == -1)
+    {
+      Py_XDECREF(copy);
+      return false;
+    }
+    Py_DECREF(copy);
+  }
+  return true;
+}
+
+void CPythonInterpreter::ResetModules()
+{
+  // the openers, they may carry cookies and credentials of the script
+  PyObject *urllib2 = GetModule("urllib2");
+  if (urllib2 && PyObject_SetAttrString(urllib2, (char*)"_opener", Py_None) == -1)
+    PyErr_Clear();
+  PyObject *urllib = GetModule("urllib");
+  if (urllib && PyObject_SetAttrString(urllib, (char*)"_urlopener", Py_None) == -1)
+    PyErr_Clear();
+
+  // the threads of the script have finished, but the thread that ran it
+  // and the ones the xbmc modules called back on are still known
+  PyObject *threading = GetModule("threading");
+  if (threading)
+  {
+    const char *names[] = { "_active", "_limbo" };
+    for (unsigned int i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+      PyObject *threads = PyObject_GetAttrString(threading, (char*)names[i]);
+      if (threads && PyDict_Check(threads))
+        PyDict_Clear(threads);
+      Py_XDECREF(threads);
+    }
+    PyErr_Clear();
+  }
+}
+
+bool CPythonInterpreter::HasSocketTimeout()
+{
+  PyObject *socket = GetModule("_socket");
+  if (!socket)
+    return false;
+
+  PyObject *timeout = PyObject_CallMethod(socket, (char*)"getdefaulttimeout", NULL);
+  bool bTimeout = !timeout || timeout != Py_None;
+  Py_XDECREF(timeout);
+  PyErr_Clear();
+  return bTimeout;
+}
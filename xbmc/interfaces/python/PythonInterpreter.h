@@ -0,0 +1,85 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+// python.h should always be included first before any other includes
+#include <Python.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * An interpreter that runs the scripts of an add-on one after the other.
+ *
+ * Reset() undoes what a script did, so the next one starts out like it
+ * would in a new interpreter:
+ *  - the modules loaded from the add-on paths, with their submodules, are
+ *    dropped and __main__ is replaced, which takes the globals with it
+ *  - the attributes of sys are put back to what they were when the
+ *    interpreter was created. the ones the script added (argv, excepthook,
+ *    last_traceback, ...) are deleted, the ones it replaced (stdout,
+ *    excepthook, ...) or changed the contents of (meta_path, path_hooks,
+ *    ...) are restored. sys.modules is handled above, sys.path is set for
+ *    every script by XBPyThread.
+ *  - the opener installed by urllib2.install_opener() and the one cached by
+ *    urllib.urlopen() are dropped
+ *  - the threading module forgets the threads of the script, Adopt() makes
+ *    the thread of the next script its main thread
+ *
+ * The default timeout of the socket module is shared by all interpreters,
+ * resetting it would change it under the scripts that are still running.
+ * While one is set interpreters aren't reset, they're ended instead.
+ *
+ * Anything else a script changes in the modules that stay, like patching a
+ * function of the standard library, is seen by the next script.
+ *
+ * Everything must be called with the GIL held and a thread state of the
+ * interpreter swapped in, deleting it included.
+ */
+class CPythonInterpreter
+{
+public:
+  // the interpreter must be new, its sys module is what Reset() restores
+  CPythonInterpreter(PyInterpreterState *interp);
+  ~CPythonInterpreter();
+
+  PyInterpreterState* Get() const { return m_interp; }
+
+  // undo what the last script did. the modules that were loaded from below
+  // one of addonPaths are dropped. returns false if the interpreter can't
+  // be reused.
+  bool Reset(const std::vector<std::string> &addonPaths);
+
+  // make the current thread, which runs the next script, the main thread
+  // of the threading module
+  void Adopt();
+
+private:
+  void DropModules(const std::vector<std::string> &addonPaths);
+  bool ReplaceMain();
+  bool RestoreSys();
+  void ResetModules();
+  bool HasSocketTimeout();
+
+  PyInterpreterState *m_interp;
+  PyObject           *m_sys;    // copy of the dict of sys, lists and dicts are copied too
+};
@@ -0,0 +1,90 @@
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "PythonInterpreterPool.h"
+
+CPythonInterpreterPool::CPythonInterpreterPool(unsigned int maxSize, unsigned int idleTime)
+{
+  m_maxSize  = maxSize;
+  m_idleTime = idleTime;
+}
+
+void* CPythonInterpreterPool::Take(const std::string &strKey, std::string &strPath)
+{
+  PyPooledInterpreters::iterator it = m_interpreters.find(strKey);
+  if (it == m_interpreters.end())
+    return NULL;
+
+  void *interpreter = it->second.interpreter;
+  strPath = it->second.strPath;
+  m_interpreters.erase(it);
+  return interpreter;
+}
+
+void CPythonInterpreterPool::Put(const std::string &strKey, void *interpreter, const std::string &strPath, unsigned int now, std::vector<void*> &ended)
+{
+  if (m_maxSize == 0 || m_interpreters.find(strKey) != m_interpreters.end())
+  {
+    ended.push_back(interpreter);
+    return;
+  }
+
+  // make room by ending the interpreter that was used least recently
+  if (m_interpreters.size() >= m_maxSize)
+  {
+    PyPooledInterpreters::iterator oldest = m_interpreters.begin();
+    for (PyPooledInterpreters::iterator it = m_interpreters.begin(); it != m_interpreters.end(); ++it)
+    {
+      if (now - it->second.lastUsed > now - oldest->second.lastUsed)
+        oldest = it;
+    }
+    ended.push_back(oldest->second.interpreter);
+    m_interpreters.erase(oldest);
+  }
+
+  PyPooledInterpreter pooled;
+  pooled.interpreter = interpreter;
+  pooled.strPath     = strPath;
+  pooled.lastUsed    = now;
+  m_interpreters.insert(std::make_pair(strKey, pooled));
+}
+
+void CPythonInterpreterPool::Expire(unsigned int now, std::vector<void*> &ended)
+{
+  PyPooledInterpreters::iterator it = m_interpreters.begin();
+  while (it != m_interpreters.end())
+  {
+    if (now - it->second.lastUsed >= m_idleTime)
+    {
+      ended.push_back(it->second.interpreter);
+      m_interpreters.erase(it++);
+    }
+    else
+      ++it;
+  }
+}
+
+void CPythonInterpreterPool::Clear(std::vector<void*> &ended)
+{
+  for (PyPooledInterpreters::iterator it = m_interpreters.begin(); it != m_interpreters.end(); ++it)
+    ended.push_back(it->second.interpreter);
+  m_interpreters.clear();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+// the number of idle interpreters that are kept around
+#define PYTHON_POOL_SIZE     4
+// time after which an idle interpreter is ended
+#define PYTHON_POOL_IDLETIME 60000 // ms
+
+/**
+ * Keeps the interpreters of finished scripts, so the next script of the same
+ * add-on doesn't have to create one and initialize the xbmc modules again.
+ *
+ * The interpreters are opaque to the pool, ending the ones it hands back is up
+ * to the caller. It isn't thread safe, XBPython guards it with its lock.
+ */
+class CPythonInterpreterPool
+{
+public:
+  CPythonInterpreterPool(unsigned int maxSize = PYTHON_POOL_SIZE, unsigned int idleTime = PYTHON_POOL_IDLETIME);
+
+  // take the idle interpreter of an add-on out of the pool, NULL if there is none.
+  // strPath is set to the python path the interpreter started with.
+  void* Take(const std::string &strKey, std::string &strPath);
+
+  // put the interpreter of a finished script in the pool. interpreters that
+  // don't fit, because the add-on has one already or the pool is full, are
+  // added to ended.
+  void Put(const std::string &strKey, void *interpreter, const std::string &strPath, unsigned int now, std::vector<void*> &ended);
+
+  // remove the interpreters that have been idle for too long
+  void Expire(unsigned int now, std::vector<void*> &ended);
+
+  // remove all interpreters
+  void Clear(std::vector<void*> &ended);
+
+  unsigned int Size() const { return m_interpreters.size(); }
+
+private:
+  typedef struct {
+    void*        interpreter;
+    std::string  strPath;
+    unsigned int lastUsed;
+  } PyPooledInterpreter;
+
+  typedef std::map<std::string, PyPooledInterpreter> PyPooledInterpreters;
+
+  unsigned int         m_maxSize;
+  unsigned int         m_idleTime;
+  PyPooledInterpreters m_interpreters;
+};
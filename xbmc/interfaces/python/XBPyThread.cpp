@@ -26,6 +26,7 @@
 // python.h should always be included first before any other includes
 #include <Python.h>
 #include <osdefs.h>
+#include <marshal.h>
 
 #include "system.h"
 #include "filesystem/SpecialProtocol.h"
@@ -35,6 +36,8 @@
 #include "utils/log.h"
 #include "threads/SingleLock.h"
 #include "utils/URIUtils.h"
+#include "utils/Crc32.h"
+#include "utils/TimeUtils.h"
 #include "addons/AddonManager.h"
 #include "addons/Addon.h"
 #include "Application.h"
@@ -49,6 +52,7 @@
 #include "interfaces/legacy/ModuleXbmc.h"
 
 #include "interfaces/python/pythreadstate.h"
+#include "interfaces/python/PythonInterpreter.h"
 #include "interfaces/python/swig.h"
 #include "utils/CharsetConverter.h"
 
@@ -140,15 +144,94 @@ int XBPyThread::setArgv(const std::vector<CStdString> &argv)
   return 0;
 }
 
+static double ElapsedMs(int64_t &start)
+{
+  int64_t now = CurrentHostCounter();
+  double ms = 1000.0 * (now - start) / CurrentHostFrequency();
+  start = now;
+  return ms;
+}
+
+// read and compile a script, or take its code from the cache if the source didn't change
+static PyObject* CompileFile(XBPython *pExecuter, const CStdString &file, bool &bCached)
+{
+  bCached = false;
+
+  // We need to have python open the file because on Windows the DLL that python
+  //  is linked against may not be the DLL that xbmc is linked against so
+  //  passing a FILE* to python from an fopen has the potential to crash.
+  PyObject* pyFile = PyFile_FromString((char *) file.c_str(), (char*)"r");
+  if (!pyFile)
+    return NULL;
+  PyObject* pySource = PyObject_CallMethod(pyFile, (char*)"read", NULL);
+  Py_DECREF(pyFile);
+  if (!pySource)
+    return NULL;
+
+  std::string source(PyString_AsString(pySource), PyString_Size(pySource));
+  Py_DECREF(pySource);
+
+  // compiling from a string doesn't translate newlines like reading the file does
+  std::string::size_type pos = 0;
+  while ((pos = source.find('\r', pos)) != std::string::npos)
+  {
+    if (pos + 1 < source.size() && source[pos + 1] == '\n')
+      source.erase(pos, 1);
+    else
+      source[pos++] = '\n';
+  }
+  if (source.empty() || source[source.size() - 1] != '\n')
+    source += '\n';
+
+  Crc32 crc;
+  crc.Compute(source.c_str(), source.size());
+
+  std::string code;
+  if (pExecuter->GetCompiledScript(file, crc, code))
+  {
+    PyObject* compiled = PyMarshal_ReadObjectFromString((char *)code.data(), code.size());
+    if (compiled && PyCode_Check(compiled))
+    {
+      bCached = true;
+      return compiled;
+    }
+    Py_XDECREF(compiled);
+    PyErr_Clear();
+  }
+
+  PyObject* compiled = Py_CompileString(source.c_str(), file.c_str(), Py_file_input);
+  if (!compiled)
+    return NULL;
+
+  PyObject* marshalled = PyMarshal_WriteObjectToString(compiled, Py_MARSHAL_VERSION);
+  if (marshalled)
+  {
+    pExecuter->SetCompiledScript(file, crc, std::string(PyString_AsString(marshalled), PyString_Size(marshalled)));
+    Py_DECREF(marshalled);
+  }
+  else
+    PyErr_Clear();
+
+  return compiled;
+}
+
 void XBPyThread::Process()
 {
   CLog::Log(LOGDEBUG,"Python thread: start processing");
 
   int m_Py_file_input = Py_file_input;
 
+  PyTiming timing;
+  memset(&timing, 0, sizeof(timing));
+  int64_t start = CurrentHostCounter();
+
+  // reuse the interpreter of the last script of this add-on if there is one
+  std::string basePath;
+  CPythonInterpreter* pooled = m_type == 'F' ? m_pExecuter->TakeInterpreter(addon, basePath) : NULL;
+
   // get the global lock
   PyEval_AcquireLock();
-  PyThreadState* state = Py_NewInterpreter();
+  PyThreadState* state = pooled ? PyThreadState_New(pooled->Get()) : Py_NewInterpreter();
   if (!state)
   {
     PyEval_ReleaseLock();
@@ -158,7 +241,16 @@ void XBPyThread::Process()
   // swap in my thread state
   PyThreadState_Swap(state);
 
-  m_pExecuter->InitializeInterpreter(addon);
+  // the interpreters of add-on scripts may be kept for the next script
+  CPythonInterpreter* interpreter = pooled;
+  if (pooled)
+    pooled->Adopt();
+  else if (addon.get() != NULL && m_type == 'F')
+    interpreter = new CPythonInterpreter(state->interp);
+
+  m_pExecuter->InitializeInterpreter(addon, pooled != NULL);
+  timing.bPooled     = pooled != NULL;
+  timing.interpreter = ElapsedMs(start);
 
   CLog::Log(LOGDEBUG, "%s - The source file to load is %s", __FUNCTION__, m_source);
 
@@ -186,29 +278,35 @@ void XBPyThread::Process()
   // and add on whatever our default path is
   path += PY_PATH_SEP;
 
-  // we want to use sys.path so it includes site-packages
-  // if this fails, default to using Py_GetPath
-  PyObject *sysMod(PyImport_ImportModule((char*)"sys")); // must call Py_DECREF when finished
-  PyObject *sysModDict(PyModule_GetDict(sysMod)); // borrowed ref, no need to delete
-  PyObject *pathObj(PyDict_GetItemString(sysModDict, "path")); // borrowed ref, no need to delete
-
-  if( pathObj && PyList_Check(pathObj) )
+  // a pooled interpreter remembers the path it started with, its sys.path
+  // has the paths of the previous script in front
+  if (!pooled)
   {
-    for( int i = 0; i < PyList_Size(pathObj); i++ )
+    // we want to use sys.path so it includes site-packages
+    // if this fails, default to using Py_GetPath
+    PyObject *sysMod(PyImport_ImportModule((char*)"sys")); // must call Py_DECREF when finished
+    PyObject *sysModDict(PyModule_GetDict(sysMod)); // borrowed ref, no need to delete
+    PyObject *pathObj(PyDict_GetItemString(sysModDict, "path")); // borrowed ref, no need to delete
+
+    if( pathObj && PyList_Check(pathObj) )
     {
-      PyObject *e = PyList_GetItem(pathObj, i); // borrowed ref, no need to delete
-      if( e && PyString_Check(e) )
+      for( int i = 0; i < PyList_Size(pathObj); i++ )
       {
-        path += PyString_AsString(e); // returns internal data, don't delete or modify
-        path += PY_PATH_SEP;
+        PyObject *e = PyList_GetItem(pathObj, i); // borrowed ref, no need to delete
+        if( e && PyString_Check(e) )
+        {
+          basePath += PyString_AsString(e); // returns internal data, don't delete or modify
+          basePath += PY_PATH_SEP;
+        }
       }
     }
+    else
+    {
+      basePath += Py_GetPath();
+    }
+    Py_DECREF(sysMod); // release ref to sysMod
   }
-  else
-  {
-    path += Py_GetPath();
-  }
-  Py_DECREF(sysMod); // release ref to sysMod
+  path += basePath;
 
   // set current directory and python's path.
   if (m_argv != NULL)
@@ -222,6 +320,7 @@ void XBPyThread::Process()
 
   PyObject* module = PyImport_AddModule((char*)"__main__");
   PyObject* moduleDict = PyModule_GetDict(module);
+  timing.setup = ElapsedMs(start);
 
   // when we are done initing we store thread state so we can be aborted
   PyThreadState_Swap(NULL);
@@ -244,13 +343,11 @@ void XBPyThread::Process()
     if (m_type == 'F')
     {
       // run script from file
-      // We need to have python open the file because on Windows the DLL that python
-      //  is linked against may not be the DLL that xbmc is linked against so
-      //  passing a FILE* to python from an fopen has the potential to crash.
-      PyObject* file = PyFile_FromString((char *) CSpecialProtocol::TranslatePath(m_source).c_str(), (char*)"r");
-      FILE *fp = PyFile_AsFile(file);
+      ElapsedMs(start);
+      PyObject* code = CompileFile(m_pExecuter, CSpecialProtocol::TranslatePath(m_source), timing.bCached);
+      timing.compile = ElapsedMs(start);
 
-      if (fp)
+      if (code)
       {
         PyObject *f = PyString_FromString(CSpecialProtocol::TranslatePath(m_source).c_str());
         PyDict_SetItemString(moduleDict, "__file__", f);
@@ -266,9 +363,11 @@ void XBPyThread::Process()
           CLog::Log(LOGDEBUG,"Instantiating addon using automatically obtained id of \"%s\" dependent on version %s of the xbmc.python api",addon->ID().c_str(),version.c_str());
         }
         Py_DECREF(f);
-        PyRun_FileExFlags(fp, CSpecialProtocol::TranslatePath(m_source).c_str(), m_Py_file_input, moduleDict, moduleDict,1,NULL);
+        PyObject* result = PyEval_EvalCode((PyCodeObject*)code, moduleDict, moduleDict);
+        Py_XDECREF(result);
+        Py_DECREF(code);
       }
-      else
+      else if (!PyErr_Occurred() || PyErr_ExceptionMatches(PyExc_IOError))
         CLog::Log(LOGERROR, "%s not found!", m_source);
     }
     else
@@ -286,6 +385,10 @@ void XBPyThread::Process()
       CLog::Log(LOGERROR, "failure in %s", m_source);
     }
   }
+  timing.run = ElapsedMs(start);
+
+  // only interpreters of scripts that ended well are reused
+  bool bFailed = PyErr_Occurred() && !PyErr_ExceptionMatches(PyExc_SystemExit);
 
   if (!PyErr_Occurred())
     CLog::Log(LOGINFO, "Scriptresult: Success");
@@ -360,17 +463,37 @@ void XBPyThread::Process()
 
   { CSingleLock lock(m_pExecuter->m_critSection);
     m_threadState = NULL;
+    stopping = m_stopping;
   }
 
   PyEval_AcquireLock();
   PyThreadState_Swap(state);
 
-  m_pExecuter->DeInitializeInterpreter();
+  // keep the interpreter for the next script of this add-on, with a thread
+  // state of its own
+  if (interpreter && !stopping && !bFailed && m_pExecuter->ResetInterpreter(addon, *interpreter))
+  {
+    // like a python thread ends, the state is cleared while it's current
+    PyThreadState_Clear(state);
+    PyThreadState_Swap(NULL);
+    PyThreadState_Delete(state);
+    PyEval_ReleaseLock();
 
-  Py_EndInterpreter(state);
-  PyThreadState_Swap(NULL);
+    m_pExecuter->ReturnInterpreter(addon, interpreter, basePath);
+  }
+  else
+  {
+    delete interpreter;
+    m_pExecuter->DeInitializeInterpreter();
 
-  PyEval_ReleaseLock();
+    Py_EndInterpreter(state);
+    PyThreadState_Swap(NULL);
+
+    PyEval_ReleaseLock();
+  }
+
+  timing.teardown = ElapsedMs(start);
+  m_pExecuter->ReportTiming(m_type == 'F' ? m_source : "<string>", timing);
 }
 
 void XBPyThread::OnExit()
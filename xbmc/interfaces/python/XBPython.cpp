@@ -35,6 +35,7 @@
 #include "filesystem/SpecialProtocol.h"
 #include "utils/log.h"
 #include "pythreadstate.h"
+#include "PythonInterpreter.h"
 #include "utils/TimeUtils.h"
 #include "Util.h"
 
@@ -44,6 +45,11 @@
 
 #include "interfaces/legacy/Monitor.h"
 
+#include <string.h>
+
+// the size of the marshalled code of all compiled scripts that is kept
+#define PYTHON_CODECACHE_SIZE (2 * 1024 * 1024)
+
 using namespace ANNOUNCEMENT;
 
 namespace PythonBindings {
@@ -66,6 +72,12 @@ XBPython::XBPython()
   m_iDllScriptCounter = 0;
   m_endtime           = 0;
   m_pDll              = NULL;
+  m_compiledSize      = 0;
+  m_compiledCounter   = 0;
+  m_timingCount       = 0;
+  m_timingPooled      = 0;
+  m_timingCached      = 0;
+  memset(&m_timingTotal, 0, sizeof(m_timingTotal));
   m_vecPlayerCallbackList.clear();
   m_vecMonitorCallbackList.clear();
 
@@ -459,8 +471,11 @@ void XBPython::UnloadExtensionLibs()
 #define RUNSCRIPT_COMPLIANT \
   RUNSCRIPT_PRAMBLE RUNSCRIPT_POSTSCRIPT
 
-void XBPython::InitializeInterpreter(ADDON::AddonPtr addon)
+void XBPython::InitializeInterpreter(ADDON::AddonPtr addon, bool bReused /* = false */)
 {
+  // a pooled interpreter has the modules already, the preamble replaces
+  // whatever the previous script did to sys.stdout and xbmc.abortRequested
+  if (!bReused)
   {
     GilSafeSingleLock lock(m_critSection);
     initModule_xbmcgui();
@@ -485,6 +500,130 @@ void XBPython::DeInitializeInterpreter()
 {
 }
 
+bool XBPython::ResetInterpreter(ADDON::AddonPtr addon, CPythonInterpreter &interpreter)
+{
+  std::vector<std::string> addonPaths;
+  addonPaths.push_back(CSpecialProtocol::TranslatePath("special://home/addons/"));
+  addonPaths.push_back(CSpecialProtocol::TranslatePath("special://xbmc/addons/"));
+  if (addon.get() != NULL)
+    addonPaths.push_back(CSpecialProtocol::TranslatePath(addon->Path()));
+
+  return interpreter.Reset(addonPaths);
+}
+
+std::string XBPython::GetPoolKey(ADDON::AddonPtr addon)
+{
+  // the preamble depends on the version of the api the add-on wants
+  return addon->ID() + " " + ADDON::GetXbmcApiVersionDependency(addon);
+}
+
+CPythonInterpreter* XBPython::TakeInterpreter(ADDON::AddonPtr addon, std::string &strPath)
+{
+  if (addon.get() == NULL)
+    return NULL;
+
+  CSingleLock lock(m_critSection);
+  return (CPythonInterpreter*)m_interpreterPool.Take(GetPoolKey(addon), strPath);
+}
+
+void XBPython::ReturnInterpreter(ADDON::AddonPtr addon, CPythonInterpreter *interpreter, const std::string &strPath)
+{
+  std::vector<void*> ended;
+  {
+    CSingleLock lock(m_critSection);
+    m_interpreterPool.Put(GetPoolKey(addon), interpreter, strPath, XbmcThreads::SystemClockMillis(), ended);
+  }
+  EndInterpreters(ended);
+}
+
+void XBPython::EndInterpreters(const std::vector<void*> &interpreters)
+{
+  if (interpreters.empty())
+    return;
+
+  PyEval_AcquireLock();
+  PyThreadState *old = PyThreadState_Swap(NULL);
+  for (unsigned int i = 0; i < interpreters.size(); i++)
+  {
+    CPythonInterpreter *interpreter = (CPythonInterpreter*)interpreters[i];
+    PyThreadState *state = PyThreadState_New(interpreter->Get());
+    PyThreadState_Swap(state);
+    delete interpreter;
+    Py_EndInterpreter(state);
+    PyThreadState_Swap(NULL);
+  }
+  PyThreadState_Swap(old);
+  PyEval_ReleaseLock();
+
+  CLog::Log(LOGDEBUG, "%s - ended %u pooled interpreters", __FUNCTION__, (unsigned int)interpreters.size());
+}
+
+bool XBPython::GetCompiledScript(const std::string &strFile, unsigned int crc, std::string &code)
+{
+  CSingleLock lock(m_compiledSection);
+  PyCompiledScripts::iterator it = m_compiledScripts.find(strFile);
+  if (it == m_compiledScripts.end() || it->second.crc != crc)
+    return false;
+
+  it->second.lastUsed = ++m_compiledCounter;
+  code = it->second.code;
+  return true;
+}
+
+void XBPython::SetCompiledScript(const std::string &strFile, unsigned int crc, const std::string &code)
+{
+  if (code.size() > PYTHON_CODECACHE_SIZE)
+    return;
+
+  CSingleLock lock(m_compiledSection);
+  PyCompiledScripts::iterator it = m_compiledScripts.find(strFile);
+  if (it != m_compiledScripts.end())
+  {
+    m_compiledSize -= it->second.code.size();
+    m_compiledScripts.erase(it);
+  }
+
+  // drop the scripts that weren't used for the longest time
+  while (m_compiledSize + code.size() > PYTHON_CODECACHE_SIZE && !m_compiledScripts.empty())
+  {
+    PyCompiledScripts::iterator oldest = m_compiledScripts.begin();
+    for (it = m_compiledScripts.begin(); it != m_compiledScripts.end(); ++it)
+    {
+      if (it->second.lastUsed < oldest->second.lastUsed)
+        oldest = it;
+    }
+    m_compiledSize -= oldest->second.code.size();
+    m_compiledScripts.erase(oldest);
+  }
+
+  PyCompiledScript script;
+  script.crc      = crc;
+  script.code     = code;
+  script.lastUsed = ++m_compiledCounter;
+  m_compiledScripts.insert(std::make_pair(strFile, script));
+  m_compiledSize += code.size();
+}
+
+void XBPython::ReportTiming(const std::string &strFile, const PyTiming &timing)
+{
+  CLog::Log(LOGDEBUG, "Python script %s took %.1fms: %s interpreter %.1fms, setup %.1fms, %s %.1fms, run %.1fms, teardown %.1fms",
+            strFile.c_str(), timing.interpreter + timing.setup + timing.compile + timing.run + timing.teardown,
+            timing.bPooled ? "pooled" : "new", timing.interpreter, timing.setup,
+            timing.bCached ? "cached code" : "compile", timing.compile, timing.run, timing.teardown);
+
+  CSingleLock lock(m_critSection);
+  m_timingCount++;
+  if (timing.bPooled)
+    m_timingPooled++;
+  if (timing.bCached)
+    m_timingCached++;
+  m_timingTotal.interpreter += timing.interpreter;
+  m_timingTotal.setup       += timing.setup;
+  m_timingTotal.compile     += timing.compile;
+  m_timingTotal.run         += timing.run;
+  m_timingTotal.teardown    += timing.teardown;
+}
+
 /**
 * Should be called before executing a script
 */
@@ -596,8 +735,24 @@ void XBPython::Finalize()
   {
     CLog::Log(LOGINFO, "Python, unloading python shared library because no scripts are running anymore");
 
+    if (m_timingCount)
+    {
+      CLog::Log(LOGDEBUG, "Python, %d scripts ran, %d in pooled interpreters and %d from cached code. Totals: interpreter %.1fms, setup %.1fms, compile %.1fms, run %.1fms, teardown %.1fms",
+                m_timingCount, m_timingPooled, m_timingCached, m_timingTotal.interpreter, m_timingTotal.setup,
+                m_timingTotal.compile, m_timingTotal.run, m_timingTotal.teardown);
+      m_timingCount  = 0;
+      m_timingPooled = 0;
+      m_timingCached = 0;
+      memset(&m_timingTotal, 0, sizeof(m_timingTotal));
+    }
+
+    std::vector<void*> interpreters;
+    m_interpreterPool.Clear(interpreters);
+
     {
       CSingleExit exit(m_critSection);
+      EndInterpreters(interpreters);
+
       PyEval_AcquireLock();
       PyThreadState_Swap((PyThreadState*)m_mainThreadState);
 
@@ -677,7 +832,16 @@ void XBPython::Process()
       else ++it;
     }
 
-    if(m_iDllScriptCounter == 0 && (XbmcThreads::SystemClockMillis() - m_endtime) > 10000 )
+    std::vector<void*> expired;
+    m_interpreterPool.Expire(XbmcThreads::SystemClockMillis(), expired);
+    if (!expired.empty())
+    {
+      CSingleExit exit(m_critSection);
+      EndInterpreters(expired);
+    }
+
+    // python stays loaded while there are interpreters in the pool
+    if(m_iDllScriptCounter == 0 && m_interpreterPool.Size() == 0 && (XbmcThreads::SystemClockMillis() - m_endtime) > 10000 )
       Finalize();
   }
 }
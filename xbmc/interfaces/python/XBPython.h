@@ -22,11 +22,13 @@
  */
 
 #include "XBPyThread.h"
+#include "PythonInterpreterPool.h"
 #include "cores/IPlayer.h"
 #include "threads/CriticalSection.h"
 #include "interfaces/IAnnouncer.h"
 #include "addons/IAddon.h"
 
+#include <map>
 #include <vector>
 
 typedef struct {
@@ -36,7 +38,26 @@ typedef struct {
   XBPyThread *pyThread;
 }PyElem;
 
+// where the time of a script invocation went, in ms
+typedef struct {
+  bool   bPooled;     // the script ran in the pooled interpreter of its add-on
+  bool   bCached;     // the script's code came from the code cache
+  double interpreter; // creating or reusing the interpreter and running the preamble
+  double setup;       // setting up sys.path, sys.argv and __main__
+  double compile;     // reading and compiling the script
+  double run;         // running the script
+  double teardown;    // waiting for its threads and ending or pooling the interpreter
+}PyTiming;
+
+// the marshalled code of a script, along with the checksum of its source
+typedef struct {
+  unsigned int crc;
+  std::string  code;
+  unsigned int lastUsed;
+}PyCompiledScript;
+
 class LibraryLoader;
+class CPythonInterpreter;
 
 namespace XBMCAddon
 {
@@ -50,6 +71,7 @@ typedef std::vector<PyElem> PyList;
 typedef std::vector<PVOID> PlayerCallbackList;
 typedef std::vector<XBMCAddon::xbmc::Monitor*> MonitorCallbackList;
 typedef std::vector<LibraryLoader*> PythonExtensionLibraries;
+typedef std::map<std::string, PyCompiledScript> PyCompiledScripts;
 
 class XBPython : 
   public IPlayerCallback,
@@ -104,12 +126,33 @@ public:
   bool StopScript(const CStdString &path);
 
   // inject xbmc stuff into the interpreter.
-  // should be called for every new interpreter
-  void InitializeInterpreter(ADDON::AddonPtr addon);
+  // should be called for every new interpreter, and with bReused set for
+  // every interpreter that is taken from the pool
+  void InitializeInterpreter(ADDON::AddonPtr addon, bool bReused = false);
 
   // remove modules and references when interpreter done
   void DeInitializeInterpreter();
 
+  // undo what the script that ran in the current interpreter did, so it can
+  // run the next script of its add-on, see CPythonInterpreter.
+  // returns false if the interpreter can't be reused.
+  bool ResetInterpreter(ADDON::AddonPtr addon, CPythonInterpreter &interpreter);
+
+  // take the pooled interpreter of an add-on, NULL if there is none.
+  // strPath is set to the python path it was created with.
+  CPythonInterpreter* TakeInterpreter(ADDON::AddonPtr addon, std::string &strPath);
+
+  // put a reset interpreter in the pool, ending the one that doesn't fit.
+  // must be called without holding the GIL.
+  void ReturnInterpreter(ADDON::AddonPtr addon, CPythonInterpreter *interpreter, const std::string &strPath);
+
+  // get the marshalled code of a script if its source didn't change
+  bool GetCompiledScript(const std::string &strFile, unsigned int crc, std::string &code);
+  void SetCompiledScript(const std::string &strFile, unsigned int crc, const std::string &code);
+
+  // log where the time of a script invocation went, and add it to the totals
+  void ReportTiming(const std::string &strFile, const PyTiming &timing);
+
   void RegisterExtensionLib(LibraryLoader *pLib);
   void UnregisterExtensionLib(LibraryLoader *pLib);
   void UnloadExtensionLibs();
@@ -129,6 +172,8 @@ public:
   CCriticalSection    m_critSection;
 private:
   bool              FileExist(const char* strFile);
+  void              EndInterpreters(const std::vector<void*> &interpreters);
+  static std::string GetPoolKey(ADDON::AddonPtr addon);
 
   int               m_nextid;
   void*             m_mainThreadState;
@@ -149,6 +194,21 @@ private:
   // in order to finalize and unload the python library, need to save all the extension libraries that are
   // loaded by it and unload them first (not done by finalize)
   PythonExtensionLibraries m_extensions;
+
+  // the interpreters of finished add-on scripts
+  CPythonInterpreterPool m_interpreterPool;
+
+  // the compiled scripts, shared between all interpreters
+  CCriticalSection  m_compiledSection;
+  PyCompiledScripts m_compiledScripts;
+  size_t            m_compiledSize;
+  unsigned int      m_compiledCounter;
+
+  // the timing of all script invocations since python was initialized
+  PyTiming          m_timingTotal;
+  int               m_timingCount;
+  int               m_timingPooled;
+  int               m_timingCached;
 };
 
 extern XBPython g_pythonParser;
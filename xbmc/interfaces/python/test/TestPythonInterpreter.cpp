@@ -0,0 +1,155 @@
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+// python.h should always be included first before any other includes
+#include "../PythonInterpreter.h"
+
+#include "gtest/gtest.h"
+
+/* runs two scripts in one interpreter, the way XBPyThread does with a pooled one */
+class TestPythonInterpreter : public testing::Test
+{
+protected:
+  static void SetUpTestCase()
+  {
+    m_bFinalize = !Py_IsInitialized();
+    if (m_bFinalize)
+      Py_Initialize();
+  }
+
+  static void TearDownTestCase()
+  {
+    if (m_bFinalize)
+      Py_Finalize();
+  }
+
+  TestPythonInterpreter()
+  {
+    m_main        = PyThreadState_Swap(NULL);
+    m_state       = Py_NewInterpreter();
+    m_interpreter = new CPythonInterpreter(m_state->interp);
+  }
+
+  ~TestPythonInterpreter()
+  {
+    delete m_interpreter;
+    Py_EndInterpreter(m_state);
+    PyThreadState_Swap(m_main);
+  }
+
+  bool Run(const char *script)
+  {
+    PyObject *globals = PyModule_GetDict(PyImport_AddModule((char*)"__main__"));
+    PyObject *result = PyRun_String(script, Py_file_input, globals, globals);
+    if (!result)
+    {
+      PyErr_Print();
+      return false;
+    }
+    Py_DECREF(result);
+    return true;
+  }
+
+  std::string GetGlobal(const char *name)
+  {
+    PyObject *globals = PyModule_GetDict(PyImport_AddModule((char*)"__main__"));
+    PyObject *value = PyDict_GetItemString(globals, name);
+    return value && PyString_Check(value) ? PyString_AsString(value) : "";
+  }
+
+  // the next script runs on a thread state of its own
+  void NextScript()
+  {
+    PyThreadState_Clear(m_state);
+    PyThreadState_Swap(NULL);
+    PyThreadState_Delete(m_state);
+    m_state = PyThreadState_New(m_interpreter->Get());
+    PyThreadState_Swap(m_state);
+    m_interpreter->Adopt();
+  }
+
+  static bool         m_bFinalize;
+  PyThreadState      *m_main;
+  PyThreadState      *m_state;
+  CPythonInterpreter *m_interpreter;
+};
+
+bool TestPythonInterpreter::m_bFinalize = false;
+
+TEST_F(TestPythonInterpreter, Isolation)
+{
+  ASSERT_TRUE(Run(
+    "import os, sys, tempfile, threading, urllib2\n"
+    "addon_path = tempfile.mkdtemp()\n"
+    "open(os.path.join(addon_path, 'addonmodule.py'), 'w').write('value = 1\\n')\n"
+    "sys.path.insert(0, addon_path)\n"
+    "import addonmodule\n"
+    "addonmodule.value = 2\n"
+    "secret = 42\n"
+    "sys.argv = ['plugin://plugin.video.test/', '1', '?first']\n"
+    "sys.excepthook = lambda *args: None\n"
+    "sys.stdout = open(os.devnull, 'w')\n"
+    "sys.path_hooks.append(lambda path: None)\n"
+    "sys.foo = 'bar'\n"
+    "urllib2.install_opener(urllib2.build_opener())\n"
+    "threading.currentThread()\n"));
+
+  std::string addonPath = GetGlobal("addon_path");
+  ASSERT_FALSE(addonPath.empty());
+  std::vector<std::string> addonPaths;
+  addonPaths.push_back(addonPath + "/");
+  ASSERT_TRUE(m_interpreter->Reset(addonPaths));
+
+  NextScript();
+  EXPECT_TRUE(Run("assert 'secret' not in globals() and 'addon_path' not in globals()\n"));
+  EXPECT_TRUE(Run(
+    "import sys\n"
+    "assert '?first' not in getattr(sys, 'argv', [])\n"
+    "assert sys.excepthook is sys.__excepthook__\n"
+    "assert sys.stdout is sys.__stdout__\n"
+    "assert len([hook for hook in sys.path_hooks if getattr(hook, '__name__', '') == '<lambda>']) == 0\n"
+    "assert not hasattr(sys, 'foo')\n"));
+  EXPECT_TRUE(Run(
+    "import sys, urllib2, threading\n"
+    "assert urllib2._opener is None\n"
+    "assert isinstance(threading.currentThread(), threading._MainThread)\n"
+    "assert len(threading.enumerate()) == 1\n"));
+
+  /* the add-on modules are imported again, the others stay */
+  EXPECT_TRUE(Run(
+    "import sys, shutil\n"
+    "assert 'addonmodule' not in sys.modules and 'urllib2' in sys.modules\n"
+    "import addonmodule\n"
+    "assert addonmodule.value == 1\n"
+    "shutil.rmtree(sys.path.pop(0))\n"));
+}
+
+TEST_F(TestPythonInterpreter, SocketTimeout)
+{
+  std::vector<std::string> addonPaths;
+
+  /* the timeout is shared with the other interpreters, it can't be undone */
+  ASSERT_TRUE(Run("import socket\nsocket.setdefaulttimeout(5)\n"));
+  EXPECT_FALSE(m_interpreter->Reset(addonPaths));
+
+  ASSERT_TRUE(Run("import socket\nsocket.setdefaulttimeout(None)\n"));
+  EXPECT_TRUE(m_interpreter->Reset(addonPaths));
+}
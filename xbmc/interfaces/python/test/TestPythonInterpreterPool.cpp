@@ -0,0 +1,91 @@
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "../PythonInterpreterPool.h"
+
+#include "gtest/gtest.h"
+
+static int interpreters[8];
+
+TEST(TestPythonInterpreterPool, TakeAndPut)
+{
+  CPythonInterpreterPool pool(2, 1000);
+  std::vector<void*> ended;
+  std::string strPath;
+
+  EXPECT_TRUE(pool.Take("plugin.video.a", strPath) == NULL);
+
+  pool.Put("plugin.video.a", &interpreters[0], "/a", 0, ended);
+  EXPECT_EQ(1U, pool.Size());
+  EXPECT_TRUE(ended.empty());
+
+  /* one interpreter per add-on */
+  pool.Put("plugin.video.a", &interpreters[1], "/a", 10, ended);
+  ASSERT_EQ(1U, ended.size());
+  EXPECT_EQ(&interpreters[1], ended[0]);
+
+  EXPECT_TRUE(pool.Take("plugin.video.b", strPath) == NULL);
+  EXPECT_EQ(&interpreters[0], pool.Take("plugin.video.a", strPath));
+  EXPECT_EQ("/a", strPath);
+  EXPECT_TRUE(pool.Take("plugin.video.a", strPath) == NULL);
+  EXPECT_EQ(0U, pool.Size());
+}
+
+TEST(TestPythonInterpreterPool, Eviction)
+{
+  CPythonInterpreterPool pool(2, 1000);
+  std::vector<void*> ended;
+  std::string strPath;
+
+  pool.Put("plugin.video.a", &interpreters[0], "", 100, ended);
+  pool.Put("plugin.video.b", &interpreters[1], "", 50, ended);
+  EXPECT_TRUE(ended.empty());
+
+  /* a full pool ends the interpreter that was used least recently */
+  pool.Put("plugin.video.c", &interpreters[2], "", 200, ended);
+  ASSERT_EQ(1U, ended.size());
+  EXPECT_EQ(&interpreters[1], ended[0]);
+  EXPECT_EQ(2U, pool.Size());
+
+  ended.clear();
+  pool.Expire(1099, ended);
+  EXPECT_TRUE(ended.empty());
+  pool.Expire(1100, ended);
+  ASSERT_EQ(1U, ended.size());
+  EXPECT_EQ(&interpreters[0], ended[0]);
+
+  ended.clear();
+  pool.Clear(ended);
+  ASSERT_EQ(1U, ended.size());
+  EXPECT_EQ(&interpreters[2], ended[0]);
+  EXPECT_EQ(0U, pool.Size());
+}
+
+TEST(TestPythonInterpreterPool, Disabled)
+{
+  CPythonInterpreterPool pool(0, 1000);
+  std::vector<void*> ended;
+  std::string strPath;
+
+  pool.Put("plugin.video.a", &interpreters[0], "", 0, ended);
+  EXPECT_EQ(1U, ended.size());
+  EXPECT_TRUE(pool.Take("plugin.video.a", strPath) == NULL);
+}
@@ -782,7 +782,6 @@ bool CMusicDatabase::GetArtistsBySong(int idSong, bool includeFeatured, std::vec
 
 int CMusicDatabase::AddPath(const CStdString& strPath1)
 {
-  CStdString strSQL;
   try
   {
     CStdString strPath(strPath1);
@@ -798,14 +797,16 @@ int CMusicDatabase::AddPath(const CStdString& strPath1)
     if (it != m_pathCache.end())
       return it->second;
 
-    strSQL=PrepareSQL( "select * from path where strPath='%s'", strPath.c_str());
-    m_pDS->query(strSQL.c_str());
+    m_pDS->prepare_statement("select * from path where strPath=?");
+    m_pDS->bind_text(1, strPath);
+    m_pDS->query_prepared();
     if (m_pDS->num_rows() == 0)
     {
       m_pDS->close();
       // doesnt exists, add it
-      strSQL=PrepareSQL("insert into path (idPath, strPath) values( NULL, '%s' )", strPath.c_str());
-      m_pDS->exec(strSQL.c_str());
+      m_pDS->prepare_statement("insert into path (idPath, strPath) values( NULL, ? )");
+      m_pDS->bind_text(1, strPath);
+      m_pDS->exec_prepared();
 
       int idPath = (int)m_pDS->lastinsertid();
       m_pathCache.insert(pair<CStdString, int>(strPath, idPath));
@@ -821,7 +822,7 @@ int CMusicDatabase::AddPath(const CStdString& strPath1)
   }
   catch (...)
   {
-    CLog::Log(LOGERROR, "musicdatabase:unable to addpath (%s)", strSQL.c_str());
+    CLog::Log(LOGERROR, "musicdatabase:unable to addpath (%s)", strPath1.c_str());
   }
 
   return -1;
@@ -2907,9 +2908,10 @@ bool CMusicDatabase::GetArtistsByWhere(const CStdString& strBaseDir, const Filte
 
     strSQL = PrepareSQL(strSQL.c_str(), !extFilter.fields.empty() && extFilter.fields.compare("*") != 0 ? extFilter.fields.c_str() : "artistview.*") + strSQLExtra;
 
-    // run query
+    // run query, streaming the rows if they don't need sorting here
     CLog::Log(LOGDEBUG, "%s query: %s", __FUNCTION__, strSQL.c_str());
-    if (!m_pDS->query(strSQL.c_str())) return false;
+    bool streaming = !countOnly && sortDescription.sortBy == SortByNone;
+    if (!(streaming ? m_pDS->query_streaming(strSQL) : m_pDS->query(strSQL.c_str()))) return false;
     int iRowsFound = m_pDS->num_rows();
     if (iRowsFound == 0)
     {
@@ -2933,18 +2935,19 @@ bool CMusicDatabase::GetArtistsByWhere(const CStdString& strBaseDir, const Filte
     items.SetProperty("total", total);
     
     DatabaseResults results;
-    results.reserve(iRowsFound);
-    if (!SortUtils::SortFromDataset(sortDescription, MediaTypeArtist, m_pDS, results))
-      return false;
+    if (!streaming)
+    {
+      results.reserve(iRowsFound);
+      if (!SortUtils::SortFromDataset(sortDescription, MediaTypeArtist, m_pDS, results))
+        return false;
+    }
 
     // get data from returned rows
     items.Reserve(results.size());
-    const dbiplus::query_data &data = m_pDS->get_result_set().records;
-    for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); it++)
+    unsigned int index = 0, targetRow;
+    const dbiplus::sql_record *record;
+    while (DatabaseUtils::GetNextRecord(m_pDS, results, index, targetRow, record))
     {
-      unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
-      
       try
       {
         CArtist artist = GetArtistFromDataset(record, false);
@@ -2968,6 +2971,10 @@ bool CMusicDatabase::GetArtistsByWhere(const CStdString& strBaseDir, const Filte
       }
     }
 
+    // a streamed query only knows how many rows it had once they have all been read
+    if (streaming && total < m_pDS->num_rows())
+      items.SetProperty("total", m_pDS->num_rows());
+
     // cleanup
     m_pDS->close();
 
@@ -3103,9 +3110,10 @@ bool CMusicDatabase::GetAlbumsByWhere(const CStdString &baseDir, const Filter &f
     strSQL = PrepareSQL(strSQL, !filter.fields.empty() && filter.fields.compare("*") != 0 ? filter.fields.c_str() : "albumview.*") + strSQLExtra;
 
     CLog::Log(LOGDEBUG, "%s query: %s", __FUNCTION__, strSQL.c_str());
-    // run query
+    // run query, streaming the rows if they don't need sorting here
     unsigned int time = XbmcThreads::SystemClockMillis();
-    if (!m_pDS->query(strSQL.c_str()))
+    bool streaming = !countOnly && sortDescription.sortBy == SortByNone;
+    if (!(streaming ? m_pDS->query_streaming(strSQL) : m_pDS->query(strSQL.c_str())))
       return false;
     CLog::Log(LOGDEBUG, "%s - query took %i ms",
               __FUNCTION__, XbmcThreads::SystemClockMillis() - time); time = XbmcThreads::SystemClockMillis();
@@ -3133,18 +3141,19 @@ bool CMusicDatabase::GetAlbumsByWhere(const CStdString &baseDir, const Filter &f
     }
     
     DatabaseResults results;
-    results.reserve(iRowsFound);
-    if (!SortUtils::SortFromDataset(sortDescription, MediaTypeAlbum, m_pDS, results))
-      return false;
+    if (!streaming)
+    {
+      results.reserve(iRowsFound);
+      if (!SortUtils::SortFromDataset(sortDescription, MediaTypeAlbum, m_pDS, results))
+        return false;
+    }
 
     // get data from returned rows
     items.Reserve(results.size());
-    const dbiplus::query_data &data = m_pDS->get_result_set().records;
-    for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); it++)
+    unsigned int index = 0, targetRow;
+    const dbiplus::sql_record *record;
+    while (DatabaseUtils::GetNextRecord(m_pDS, results, index, targetRow, record))
     {
-      unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
-      
       try
       {
         CMusicDbUrl itemUrl = musicUrl;
@@ -3162,6 +3171,10 @@ bool CMusicDatabase::GetAlbumsByWhere(const CStdString &baseDir, const Filter &f
       }
     }
 
+    // a streamed query only knows how many rows it had once they have all been read
+    if (streaming && total < m_pDS->num_rows())
+      items.SetProperty("total", m_pDS->num_rows());
+
     // cleanup
     m_pDS->close();
     return true;
@@ -3218,8 +3231,9 @@ bool CMusicDatabase::GetSongsByWhere(const CStdString &baseDir, const Filter &fi
     strSQL = PrepareSQL(strSQL, !filter.fields.empty() && filter.fields.compare("*") != 0 ? filter.fields.c_str() : "songview.*") + strSQLExtra;
 
     CLog::Log(LOGDEBUG, "%s query = %s", __FUNCTION__, strSQL.c_str());
-    // run query
-    if (!m_pDS->query(strSQL.c_str()))
+    // run query, streaming the rows if they don't need sorting here
+    bool streaming = sortDescription.sortBy == SortByNone;
+    if (!(streaming ? m_pDS->query_streaming(strSQL) : m_pDS->query(strSQL.c_str())))
       return false;
 
     int iRowsFound = m_pDS->num_rows();
@@ -3235,19 +3249,20 @@ bool CMusicDatabase::GetSongsByWhere(const CStdString &baseDir, const Filter &fi
     items.SetProperty("total", total);
     
     DatabaseResults results;
-    results.reserve(iRowsFound);
-    if (!SortUtils::SortFromDataset(sortDescription, MediaTypeSong, m_pDS, results))
-      return false;
+    if (!streaming)
+    {
+      results.reserve(iRowsFound);
+      if (!SortUtils::SortFromDataset(sortDescription, MediaTypeSong, m_pDS, results))
+        return false;
+    }
 
     // get data from returned rows
     items.Reserve(results.size());
-    const dbiplus::query_data &data = m_pDS->get_result_set().records;
     int count = 0;
-    for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); it++)
+    unsigned int index = 0, targetRow;
+    const dbiplus::sql_record *record;
+    while (DatabaseUtils::GetNextRecord(m_pDS, results, index, targetRow, record))
     {
-      unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
-      
       try
       {
         CFileItemPtr item(new CFileItem);
@@ -3264,6 +3279,10 @@ bool CMusicDatabase::GetSongsByWhere(const CStdString &baseDir, const Filter &fi
       }
     }
 
+    // a streamed query only knows how many rows it had once they have all been read
+    if (streaming && total < m_pDS->num_rows())
+      items.SetProperty("total", m_pDS->num_rows());
+
     // cleanup
     m_pDS->close();
     CLog::Log(LOGDEBUG, "%s(%s) - took %d ms", __FUNCTION__, filter.where.c_str(), XbmcThreads::SystemClockMillis() - time);
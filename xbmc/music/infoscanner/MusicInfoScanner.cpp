@@ -20,7 +20,7 @@
 
 #include "threads/SystemClock.h"
 #include "MusicInfoScanner.h"
-#include "music/tags/MusicInfoTagLoaderFactory.h"
+#include "MusicTagReader.h"
 #include "MusicAlbumInfo.h"
 #include "MusicInfoScraper.h"
 #include "filesystem/MusicDatabaseDirectory.h"
@@ -68,6 +68,8 @@ CMusicInfoScanner::CMusicInfoScanner() : CThread("CMusicInfoScanner")
   m_currentItem=0;
   m_itemCount=0;
   m_flags = 0;
+  m_tagReader = NULL;
+  m_batchedDirectories = 0;
 }
 
 CMusicInfoScanner::~CMusicInfoScanner()
@@ -117,6 +119,7 @@ void CMusicInfoScanner::Process()
 
       bool commit = false;
       bool cancelled = false;
+      m_tagReader = new CMusicTagReader(g_advancedSettings.m_musicLibraryTagReaders);
       while (!cancelled && m_pathsToScan.size())
       {
         /*
@@ -131,6 +134,25 @@ void CMusicInfoScanner::Process()
         commit = !cancelled;
       }
 
+      // add the directories still waiting on their tags
+      while (!cancelled && !m_pendingDirectories.empty())
+        cancelled = !CompleteDirectory();
+      if (!cancelled)
+        cancelled = !CommitBatch();
+
+      if (cancelled)
+      { // drop whatever is still queued and undo the uncommitted batch
+        commit = false;
+        m_tagReader->Cancel();
+        m_pendingDirectories.clear();
+        if (m_musicDatabase.InTransaction())
+          m_musicDatabase.RollbackTransaction();
+        m_batchAlbums.clear();
+        m_batchArtists.clear();
+      }
+      delete m_tagReader;
+      m_tagReader = NULL;
+
       if (commit)
       {
         g_infoManager.ResetLibraryBools();
@@ -209,6 +231,9 @@ void CMusicInfoScanner::Process()
   {
     CLog::Log(LOGERROR, "MusicInfoScanner: Exception while scanning.");
   }
+  delete m_tagReader;
+  m_tagReader = NULL;
+  m_pendingDirectories.clear();
   ANNOUNCEMENT::CAnnouncementManager::Announce(ANNOUNCEMENT::AudioLibrary, "xbmc", "OnScanFinished");
   m_bRunning = false;
   if (m_showDialog)
@@ -421,15 +446,9 @@ bool CMusicInfoScanner::DoScan(const CStdString& strDirectory)
     items.FilterCueItems();
     items.Sort(SORT_METHOD_LABEL, SortOrderAscending);
 
-    // and then scan in the new information
-    if (RetrieveMusicInfo(items, strDirectory) > 0)
-    {
-      if (m_handle)
-        OnDirectoryScanned(strDirectory);
-    }
-
-    // save information about this folder
-    m_musicDatabase.SetPathHash(strDirectory, hash);
+    // and then scan in the new information, the database is updated once the tags are read
+    if (!QueueDirectory(items, strDirectory, hash))
+      m_bStop = true;
   }
   else
   { // path is the same - no need to rescan
@@ -466,127 +485,83 @@ bool CMusicInfoScanner::DoScan(const CStdString& strDirectory)
   return !m_bStop;
 }
 
-int CMusicInfoScanner::RetrieveMusicInfo(CFileItemList& items, const CStdString& strDirectory)
+static bool ShouldReadTag(const CFileItemPtr &pItem, const CStdStringArray &regexps)
 {
-  CSongMap songsMap;
-
-  // get all information for all files in current directory from database, and remove them
-  if (m_musicDatabase.RemoveSongsFromPath(strDirectory, songsMap))
-    m_needsCleanup = true;
+  // Discard all excluded files defined by m_musicExcludeRegExps
+  if (CUtil::ExcludeFileOrFolder(pItem->GetPath(), regexps))
+    return false;
 
-  VECSONGS songsToAdd;
+  // dont try reading id3tags for folders, playlists or shoutcast streams
+  return !pItem->m_bIsFolder && !pItem->IsPlayList() && !pItem->IsPicture() && !pItem->IsLyrics();
+}
 
+bool CMusicInfoScanner::QueueDirectory(const CFileItemList& items, const CStdString& strDirectory, const CStdString& hash)
+{
   CStdStringArray regexps = g_advancedSettings.m_audioExcludeFromScanRegExps;
 
-  // for every file found, but skip folder
+  vector<CFileItemPtr> files;
   for (int i = 0; i < items.Size(); ++i)
   {
-    CFileItemPtr pItem = items[i];
-    CStdString strExtension;
-    URIUtils::GetExtension(pItem->GetPath(), strExtension);
-
-    if (m_bStop)
-      return 0;
-
-    // Discard all excluded files defined by m_musicExcludeRegExps
-    if (CUtil::ExcludeFileOrFolder(pItem->GetPath(), regexps))
-      continue;
+    if (ShouldReadTag(items[i], regexps))
+      files.push_back(items[i]);
+  }
 
-    // dont try reading id3tags for folders, playlists or shoutcast streams
-    if (!pItem->m_bIsFolder && !pItem->IsPlayList() && !pItem->IsPicture() && !pItem->IsLyrics() )
-    {
-      m_currentItem++;
-//      CLog::Log(LOGDEBUG, "%s - Reading tag for: %s", __FUNCTION__, pItem->GetPath().c_str());
-
-      // grab info from the song
-      CSong *dbSong = songsMap.Find(pItem->GetPath());
-
-      CMusicInfoTag& tag = *pItem->GetMusicInfoTag();
-      if (!tag.Loaded() )
-      { // read the tag from a file
-        auto_ptr<IMusicInfoTagLoader> pLoader (CMusicInfoTagLoaderFactory::CreateLoader(pItem->GetPath()));
-        if (NULL != pLoader.get())
-          pLoader->Load(pItem->GetPath(), tag);
-      }
+  PendingDirectory directory;
+  directory.path = strDirectory;
+  directory.hash = hash;
+  directory.items.reset(new CFileItemList);
+  directory.items->Assign(items);
+  directory.group = m_tagReader->Queue(files);
+  m_pendingDirectories.push_back(directory);
 
-      // if we have the itemcount, update our
-      // dialog with the progress we made
-      if (m_handle && m_itemCount>0)
-        m_handle->SetPercentage(m_currentItem/(float)m_itemCount*100);
+  // keep the readers busy, but don't run too far ahead of the database
+  while (m_pendingDirectories.size() > 2 * m_tagReader->GetWorkers())
+  {
+    if (!CompleteDirectory())
+      return false;
+  }
+  return true;
+}
 
-      if (tag.Loaded())
-      {
-        CSong song(tag);
+bool CMusicInfoScanner::CompleteDirectory()
+{
+  PendingDirectory directory = m_pendingDirectories.front();
+  m_pendingDirectories.pop_front();
 
-        // ensure our song has a valid filename or else it will assert in AddSong()
-        if (song.strFileName.IsEmpty())
-        {
-          // copy filename from path in case UPnP or other tag loaders didn't specify one (FIXME?)
-          song.strFileName = pItem->GetPath();
+  while (!m_tagReader->Wait(directory.group, 100))
+  {
+    if (m_bStop)
+      return false;
+  }
 
-          // if we still don't have a valid filename, skip the song
-          if (song.strFileName.IsEmpty())
-          {
-            // this shouldn't ideally happen!
-            CLog::Log(LOGERROR, "Skipping song since it doesn't seem to have a filename");
-            continue;
-          }
-        }
+  if (!m_musicDatabase.InTransaction())
+    m_musicDatabase.BeginTransaction();
 
-        song.iStartOffset = pItem->m_lStartOffset;
-        song.iEndOffset = pItem->m_lEndOffset;
-        song.strThumb = pItem->GetUserMusicThumb(true);
-        if (dbSong)
-        { // keep the db-only fields intact on rescan...
-          song.iTimesPlayed = dbSong->iTimesPlayed;
-          song.lastPlayed = dbSong->lastPlayed;
-          song.iKaraokeNumber = dbSong->iKaraokeNumber;
-
-          if (song.rating == '0') song.rating = dbSong->rating;
-          if (song.strThumb.empty())
-            song.strThumb = dbSong->strThumb;
-        }
-        songsToAdd.push_back(song);
-//        CLog::Log(LOGDEBUG, "%s - Tag loaded for: %s", __FUNCTION__, pItem->GetPath().c_str());
-      }
-      else
-        CLog::Log(LOGDEBUG, "%s - No tag found for: %s", __FUNCTION__, pItem->GetPath().c_str());
-    }
+  if (RetrieveMusicInfo(*directory.items, directory.path) > 0)
+  {
+    if (m_handle)
+      OnDirectoryScanned(directory.path);
   }
+  if (m_bStop)
+    return false;
 
-  VECALBUMS albums;
-  CategoriseAlbums(songsToAdd, albums);
-  FindArtForAlbums(albums, items.GetPath());
+  // save information about this folder
+  m_musicDatabase.SetPathHash(directory.path, directory.hash);
 
-  // finally, add these to the database
-  m_musicDatabase.BeginTransaction();
-  int numAdded = 0;
-  set<long> albumsToScan;
-  set<long> artistsToScan;
-  for (VECALBUMS::iterator i = albums.begin(); i != albums.end(); ++i)
-  {
-    vector<int> songIDs;
-    int idAlbum = m_musicDatabase.AddAlbum(*i, songIDs);
-    numAdded += i->songs.size();
-    if (m_bStop)
-    {
-      m_musicDatabase.RollbackTransaction();
-      return numAdded;
-    }
+  if (++m_batchedDirectories >= g_advancedSettings.m_musicLibraryScanBatch)
+    return CommitBatch();
+  return true;
+}
 
-    // Build the artist & album sets
-    albumsToScan.insert(idAlbum);
-    for (vector<int>::iterator j = songIDs.begin(); j != songIDs.end(); ++j)
-    {
-      vector<long> songArtists;
-      m_musicDatabase.GetArtistsBySong(*j, false, songArtists);
-      artistsToScan.insert(songArtists.begin(), songArtists.end());
-    }
-    std::vector<long> albumArtists;
-    m_musicDatabase.GetArtistsByAlbum(idAlbum, false, albumArtists);
-    artistsToScan.insert(albumArtists.begin(), albumArtists.end());
-  }
-  m_musicDatabase.CommitTransaction();
+bool CMusicInfoScanner::CommitBatch()
+{
+  if (m_musicDatabase.InTransaction())
+    m_musicDatabase.CommitTransaction();
+  m_batchedDirectories = 0;
+
+  set<long> artistsToScan, albumsToScan;
+  artistsToScan.swap(m_batchArtists);
+  albumsToScan.swap(m_batchAlbums);
 
   // Download info & artwork
   bool bCanceled;
@@ -618,7 +593,7 @@ int CMusicInfoScanner::RetrieveMusicInfo(CFileItemList& items, const CStdString&
     for (set<long>::iterator it = albumsToScan.begin(); it != albumsToScan.end(); ++it)
     {
       if (m_bStop)
-        return songsToAdd.size();
+        return false;
 
       CStdString strPath;
       strPath.Format("musicdb://3/%u/",*it);
@@ -633,9 +608,113 @@ int CMusicInfoScanner::RetrieveMusicInfo(CFileItemList& items, const CStdString&
           m_albumsScanned.push_back(*it);
       }
     }
+    if (m_handle)
+      m_handle->SetTitle(g_localizeStrings.Get(505));
+  }
+
+  return !m_bStop;
+}
+
+int CMusicInfoScanner::RetrieveMusicInfo(CFileItemList& items, const CStdString& strDirectory)
+{
+  CSongMap songsMap;
+
+  // get all information for all files in current directory from database, and remove them
+  if (m_musicDatabase.RemoveSongsFromPath(strDirectory, songsMap))
+    m_needsCleanup = true;
+
+  VECSONGS songsToAdd;
+
+  CStdStringArray regexps = g_advancedSettings.m_audioExcludeFromScanRegExps;
+
+  // for every file found, but skip folder
+  for (int i = 0; i < items.Size(); ++i)
+  {
+    CFileItemPtr pItem = items[i];
+
+    if (m_bStop)
+      return 0;
+
+    if (!ShouldReadTag(pItem, regexps))
+      continue;
+
+    m_currentItem++;
+
+    // grab info from the song
+    CSong *dbSong = songsMap.Find(pItem->GetPath());
+
+    // the tag has been read by the tag readers already
+    CMusicInfoTag& tag = *pItem->GetMusicInfoTag();
+
+    // if we have the itemcount, update our
+    // dialog with the progress we made
+    if (m_handle && m_itemCount>0)
+      m_handle->SetPercentage(m_currentItem/(float)m_itemCount*100);
+
+    if (tag.Loaded())
+    {
+      CSong song(tag);
+
+      // ensure our song has a valid filename or else it will assert in AddSong()
+      if (song.strFileName.IsEmpty())
+      {
+        // copy filename from path in case UPnP or other tag loaders didn't specify one (FIXME?)
+        song.strFileName = pItem->GetPath();
+
+        // if we still don't have a valid filename, skip the song
+        if (song.strFileName.IsEmpty())
+        {
+          // this shouldn't ideally happen!
+          CLog::Log(LOGERROR, "Skipping song since it doesn't seem to have a filename");
+          continue;
+        }
+      }
+
+      song.iStartOffset = pItem->m_lStartOffset;
+      song.iEndOffset = pItem->m_lEndOffset;
+      song.strThumb = pItem->GetUserMusicThumb(true);
+      if (dbSong)
+      { // keep the db-only fields intact on rescan...
+        song.iTimesPlayed = dbSong->iTimesPlayed;
+        song.lastPlayed = dbSong->lastPlayed;
+        song.iKaraokeNumber = dbSong->iKaraokeNumber;
+
+        if (song.rating == '0') song.rating = dbSong->rating;
+        if (song.strThumb.empty())
+          song.strThumb = dbSong->strThumb;
+      }
+      songsToAdd.push_back(song);
+    }
+    else
+      CLog::Log(LOGDEBUG, "%s - No tag found for: %s", __FUNCTION__, pItem->GetPath().c_str());
+  }
+
+  VECALBUMS albums;
+  CategoriseAlbums(songsToAdd, albums);
+  FindArtForAlbums(albums, items.GetPath());
+
+  // finally, add these to the database, the transaction is committed with the rest of the batch
+  int numAdded = 0;
+  for (VECALBUMS::iterator i = albums.begin(); i != albums.end(); ++i)
+  {
+    vector<int> songIDs;
+    int idAlbum = m_musicDatabase.AddAlbum(*i, songIDs);
+    numAdded += i->songs.size();
+    if (m_bStop)
+      return numAdded;
+
+    // Build the artist & album sets
+    m_batchAlbums.insert(idAlbum);
+    for (vector<int>::iterator j = songIDs.begin(); j != songIDs.end(); ++j)
+    {
+      vector<long> songArtists;
+      m_musicDatabase.GetArtistsBySong(*j, false, songArtists);
+      m_batchArtists.insert(songArtists.begin(), songArtists.end());
+    }
+    std::vector<long> albumArtists;
+    m_musicDatabase.GetArtistsByAlbum(idAlbum, false, albumArtists);
+    m_batchArtists.insert(albumArtists.begin(), albumArtists.end());
   }
-  if (m_handle)
-    m_handle->SetTitle(g_localizeStrings.Get(505));
 
   return songsToAdd.size();
 }
@@ -22,12 +22,17 @@
 #include "music/MusicDatabase.h"
 #include "MusicAlbumInfo.h"
 
+#include <deque>
+#include <boost/shared_ptr.hpp>
+
 class CAlbum;
 class CArtist;
 class CGUIDialogProgressBarHandle;
 
 namespace MUSIC_INFO
 {
+class CMusicTagReader;
+
 class CMusicInfoScanner : CThread, public IRunnable
 {
 public:
@@ -102,6 +107,24 @@ protected:
 
   bool DoScan(const CStdString& strDirectory);
 
+  /*! \brief Hand the files of a changed directory to the tag readers
+   The directory is added to the database by CompleteDirectory() once its tags
+   have been read, which allows the scan to walk on while the tags are read.
+   \return false if the scan was cancelled.
+   */
+  bool QueueDirectory(const CFileItemList& items, const CStdString& strDirectory, const CStdString& hash);
+
+  /*! \brief Wait for the tags of the oldest queued directory and add it to the database
+   Directories are added in batches within a single transaction, see CommitBatch().
+   \return false if the scan was cancelled.
+   */
+  bool CompleteDirectory();
+
+  /*! \brief Commit the directories added since the last commit and fetch info and art for their albums and artists
+   \return false if the scan was cancelled.
+   */
+  bool CommitBatch();
+
   virtual void Run();
   int CountFiles(const CFileItemList& items, bool recursive);
   int CountFilesRecursively(const CStdString& strPath);
@@ -117,6 +140,19 @@ protected:
   int m_scanType; // 0 - load from files, 1 - albums, 2 - artists
   CMusicDatabase m_musicDatabase;
 
+  struct PendingDirectory
+  {
+    CStdString path;
+    CStdString hash;
+    boost::shared_ptr<CFileItemList> items;
+    unsigned int group; ///< tag reader group of the items
+  };
+  CMusicTagReader* m_tagReader;
+  std::deque<PendingDirectory> m_pendingDirectories;
+  int m_batchedDirectories;
+  std::set<long> m_batchAlbums;  ///< albums added in the current batch
+  std::set<long> m_batchArtists; ///< artists added in the current batch
+
   std::set<CStdString> m_pathsToScan;
   std::set<CAlbum> m_albumsToScan;
   std::set<CArtist> m_artistsToScan;
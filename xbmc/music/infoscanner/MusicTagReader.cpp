@@ -0,0 +1,187 @@
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "MusicTagReader.h"
+#include "music/tags/MusicInfoTagLoaderFactory.h"
+#include "music/tags/MusicInfoTag.h"
+#include "cores/paplayer/TimidityCodec.h"
+#ifdef HAS_ASAP_CODEC
+#include "cores/paplayer/ASAPCodec.h"
+#endif
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/URIUtils.h"
+
+#include <memory>
+
+using namespace std;
+using namespace MUSIC_INFO;
+
+// loaders that can't be run concurrently take this lock
+static CCriticalSection g_exclusiveLoaderSection;
+
+static bool NeedsExclusiveLoader(const CFileItem &item)
+{
+  if (item.IsMusicDb())
+    return true;
+
+  // these loaders wrap a codec dll which is shared between instances
+  CStdString strExtension;
+  URIUtils::GetExtension(item.GetPath(), strExtension);
+  strExtension.ToLower();
+  strExtension.TrimLeft('.');
+
+  return strExtension == "shn" || strExtension == "spc" ||
+         strExtension == "ym"  || strExtension == "cdda" ||
+#ifdef HAS_ASAP_CODEC
+         ASAPCodec::IsSupportedFormat(strExtension) || strExtension == "asapstream" ||
+#endif
+         TimidityCodec::IsSupportedFormat(strExtension);
+}
+
+CMusicTagReader::CMusicTagReader(unsigned int workers)
+{
+  m_nextGroup = 0;
+  m_stop = false;
+  if (workers < 1)
+    workers = 1;
+  for (unsigned int i = 0; i < workers; i++)
+  {
+    CThread *worker = new CThread(this, "CMusicTagReader");
+    worker->Create();
+    m_workers.push_back(worker);
+  }
+}
+
+CMusicTagReader::~CMusicTagReader()
+{
+  {
+    CSingleLock lock(m_section);
+    m_stop = true;
+    m_queue.clear();
+  }
+  for (vector<CThread*>::iterator i = m_workers.begin(); i != m_workers.end(); ++i)
+  {
+    m_jobAvailable.Set();
+    (*i)->StopThread();
+    delete *i;
+  }
+}
+
+unsigned int CMusicTagReader::Queue(const vector<CFileItemPtr> &items)
+{
+  CSingleLock lock(m_section);
+  unsigned int group = m_nextGroup++;
+  unsigned int pending = 0;
+  for (vector<CFileItemPtr>::const_iterator i = items.begin(); i != items.end(); ++i)
+  {
+    if ((*i)->GetMusicInfoTag()->Loaded())
+      continue;
+    m_queue.push_back(QueuedItem(group, *i));
+    pending++;
+  }
+  if (pending)
+  {
+    m_pending[group] = pending;
+    m_jobAvailable.Set();
+  }
+  return group;
+}
+
+bool CMusicTagReader::Wait(unsigned int group, unsigned int milliSeconds)
+{
+  XbmcThreads::EndTime timeout(milliSeconds);
+  CSingleLock lock(m_section);
+  while (m_pending.find(group) != m_pending.end())
+  {
+    if (timeout.IsTimePast())
+      return false;
+    lock.Leave();
+    m_itemRead.WaitMSec(timeout.MillisLeft());
+    lock.Enter();
+  }
+  return true;
+}
+
+void CMusicTagReader::Cancel()
+{
+  CSingleLock lock(m_section);
+  while (!m_queue.empty())
+  {
+    Complete(m_queue.front().first);
+    m_queue.pop_front();
+  }
+  m_itemRead.Set();
+}
+
+void CMusicTagReader::Complete(unsigned int group)
+{
+  map<unsigned int, unsigned int>::iterator i = m_pending.find(group);
+  if (i != m_pending.end() && --i->second == 0)
+    m_pending.erase(i);
+}
+
+void CMusicTagReader::Run()
+{
+  CSingleLock lock(m_section);
+  while (!m_stop)
+  {
+    if (m_queue.empty())
+    {
+      lock.Leave();
+      m_jobAvailable.WaitMSec(100);
+      lock.Enter();
+      continue;
+    }
+
+    QueuedItem job = m_queue.front();
+    m_queue.pop_front();
+    // pass the wakeup on to the next idle worker
+    if (!m_queue.empty())
+      m_jobAvailable.Set();
+    lock.Leave();
+
+    ReadTag(*job.second);
+
+    lock.Enter();
+    Complete(job.first);
+    m_itemRead.Set();
+  }
+}
+
+bool CMusicTagReader::ReadTag(CFileItem &item)
+{
+  CMusicInfoTag &tag = *item.GetMusicInfoTag();
+  if (tag.Loaded())
+    return true;
+
+  auto_ptr<IMusicInfoTagLoader> pLoader (CMusicInfoTagLoaderFactory::CreateLoader(item.GetPath()));
+  if (NULL == pLoader.get())
+    return false;
+
+  if (NeedsExclusiveLoader(item))
+  {
+    CSingleLock lock(g_exclusiveLoaderSection);
+    pLoader->Load(item.GetPath(), tag);
+  }
+  else
+    pLoader->Load(item.GetPath(), tag);
+  return tag.Loaded();
+}
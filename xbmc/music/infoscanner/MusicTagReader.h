@@ -0,0 +1,92 @@
+#pragma once
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+#include "threads/Thread.h"
+#include "FileItem.h"
+
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace MUSIC_INFO
+{
+/*! \brief Reads music tags on a pool of worker threads.
+
+ Items are queued in groups (the scanner uses one group per directory) and
+ the workers fill in the music info tag of each item. The caller waits for a
+ group to complete before it touches the items again, so an item is only ever
+ used by one thread at a time.
+
+ Loaders wrapping a codec dll share the dll between instances, so those are
+ serialized. TagLib and the wav loader run concurrently.
+ */
+class CMusicTagReader : public IRunnable
+{
+public:
+  CMusicTagReader(unsigned int workers);
+  virtual ~CMusicTagReader();
+
+  /*! \brief Queue items to have their tags read.
+   Items that already have a tag loaded are completed immediately.
+   \param items the items to read, in the order they should be read.
+   \return an identifier for the group, to be passed to Wait().
+   */
+  unsigned int Queue(const std::vector<CFileItemPtr> &items);
+
+  /*! \brief Wait for all items of a group to be read.
+   \param group identifier returned from Queue().
+   \param milliSeconds time to wait before giving up.
+   \return true once the group is complete, false on timeout.
+   */
+  bool Wait(unsigned int group, unsigned int milliSeconds);
+
+  /*! \brief Drop all items still queued.
+   Items already being read are finished, after which every group is complete.
+   */
+  void Cancel();
+
+  unsigned int GetWorkers() const { return m_workers.size(); }
+
+  /*! \brief Read the tag of a single item on the calling thread
+   \return true if a tag was loaded.
+   */
+  static bool ReadTag(CFileItem &item);
+
+protected:
+  virtual void Run();
+
+private:
+  void Complete(unsigned int group);
+
+  typedef std::pair<unsigned int, CFileItemPtr> QueuedItem;
+
+  CCriticalSection m_section;
+  CEvent m_jobAvailable;
+  CEvent m_itemRead;
+  std::deque<QueuedItem> m_queue;
+  std::map<unsigned int, unsigned int> m_pending; ///< items still to be read per group
+  unsigned int m_nextGroup;
+  bool m_stop;
+  std::vector<CThread*> m_workers;
+};
+}
@@ -0,0 +1,210 @@
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "music/infoscanner/MusicTagReader.h"
+#include "music/tags/MusicInfoTag.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "utils/TimeUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <string.h>
+
+using namespace MUSIC_INFO;
+using namespace XFILE;
+
+static const int TEST_DIRECTORIES = 20;
+static const int TEST_FILES       = 25; ///< per directory
+static const int MPEG_FRAMES      = 40;
+
+static void AppendTextFrame(std::string &tag, const char *id, const CStdString &text)
+{
+  /* ID3v2.3 frame sizes are plain big endian, the text is latin1 */
+  unsigned int size = text.size() + 1;
+  tag.append(id, 4);
+  tag += (char)(size >> 24);
+  tag += (char)(size >> 16);
+  tag += (char)(size >> 8);
+  tag += (char)size;
+  tag.append(2, '\0');
+  tag += '\0';
+  tag += text;
+}
+
+static bool WriteTrack(const CStdString &path, int album, int track)
+{
+  CStdString artist, title, albumName, trackNumber;
+  artist.Format("Artist %d", album % 5);
+  albumName.Format("Album %d", album);
+  title.Format("Track %d", track);
+  trackNumber.Format("%d", track + 1);
+
+  std::string frames;
+  AppendTextFrame(frames, "TPE1", artist);
+  AppendTextFrame(frames, "TALB", albumName);
+  AppendTextFrame(frames, "TIT2", title);
+  AppendTextFrame(frames, "TRCK", trackNumber);
+
+  /* the tag size is stored as a syncsafe integer */
+  std::string data("ID3\x03\x00\x00", 6);
+  unsigned int size = frames.size();
+  data += (char)((size >> 21) & 0x7f);
+  data += (char)((size >> 14) & 0x7f);
+  data += (char)((size >> 7) & 0x7f);
+  data += (char)(size & 0x7f);
+  data += frames;
+
+  /* silent MPEG-1 layer III frames, 128kbit/s at 44.1kHz */
+  static const char header[] = { (char)0xff, (char)0xfb, (char)0x90, (char)0x64 };
+  for (int i = 0; i < MPEG_FRAMES; ++i)
+  {
+    data.append(header, sizeof(header));
+    data.append(417 - sizeof(header), '\0');
+  }
+
+  CFile file;
+  if (!file.OpenForWrite(path, true))
+    return false;
+  bool ret = file.Write(data.c_str(), data.size()) == (int)data.size();
+  file.Close();
+  return ret;
+}
+
+class TestMusicTagReader : public testing::Test
+{
+protected:
+  TestMusicTagReader()
+  {
+    m_root = "special://temp/TestMusicTagReader/";
+    CDirectory::Create(m_root);
+    for (int d = 0; d < TEST_DIRECTORIES; ++d)
+    {
+      CStdString directory;
+      directory.Format("%sAlbum %02d/", m_root.c_str(), d);
+      CDirectory::Create(directory);
+      for (int f = 0; f < TEST_FILES; ++f)
+      {
+        CStdString path;
+        path.Format("%s%02d - Track.mp3", directory.c_str(), f);
+        if (WriteTrack(path, d, f))
+          m_files.push_back(path);
+      }
+      m_directories.push_back(directory);
+    }
+  }
+
+  ~TestMusicTagReader()
+  {
+    for (std::vector<CStdString>::iterator i = m_files.begin(); i != m_files.end(); ++i)
+      CFile::Delete(*i);
+    for (std::vector<CStdString>::iterator i = m_directories.begin(); i != m_directories.end(); ++i)
+      CDirectory::Remove(*i);
+    CDirectory::Remove(m_root);
+  }
+
+  /* the scanner queues one group per directory, so do the same */
+  void ReadAll(CMusicTagReader &reader, std::vector<CFileItemPtr> &items)
+  {
+    items.clear();
+    std::vector<unsigned int> groups;
+    for (int d = 0; d < TEST_DIRECTORIES; ++d)
+    {
+      std::vector<CFileItemPtr> directory;
+      for (int f = 0; f < TEST_FILES; ++f)
+      {
+        CFileItemPtr item(new CFileItem(m_files[d * TEST_FILES + f], false));
+        directory.push_back(item);
+        items.push_back(item);
+      }
+      groups.push_back(reader.Queue(directory));
+    }
+    for (std::vector<unsigned int>::iterator i = groups.begin(); i != groups.end(); ++i)
+      while (!reader.Wait(*i, 1000)) {}
+  }
+
+  CStdString m_root;
+  std::vector<CStdString> m_directories;
+  std::vector<CStdString> m_files;
+};
+
+TEST_F(TestMusicTagReader, Read)
+{
+  ASSERT_EQ((size_t)(TEST_DIRECTORIES * TEST_FILES), m_files.size());
+
+  CMusicTagReader reader(4);
+  std::vector<CFileItemPtr> items;
+  ReadAll(reader, items);
+
+  for (size_t i = 0; i < items.size(); ++i)
+  {
+    const CMusicInfoTag &tag = *items[i]->GetMusicInfoTag();
+    CStdString album, title;
+    album.Format("Album %d", (int)i / TEST_FILES);
+    title.Format("Track %d", (int)i % TEST_FILES);
+
+    ASSERT_TRUE(tag.Loaded()) << items[i]->GetPath();
+    EXPECT_STREQ(album.c_str(), tag.GetAlbum().c_str());
+    EXPECT_STREQ(title.c_str(), tag.GetTitle().c_str());
+    EXPECT_EQ((int)i % TEST_FILES + 1, tag.GetTrackNumber());
+  }
+}
+
+TEST_F(TestMusicTagReader, Cancel)
+{
+  CMusicTagReader reader(2);
+  std::vector<CFileItemPtr> items;
+  for (size_t i = 0; i < m_files.size(); ++i)
+    items.push_back(CFileItemPtr(new CFileItem(m_files[i], false)));
+
+  unsigned int group = reader.Queue(items);
+  reader.Cancel();
+  /* only the items already being read are finished */
+  EXPECT_TRUE(reader.Wait(group, 5000));
+
+  /* already loaded tags are not queued at all */
+  items.resize(1);
+  items[0]->GetMusicInfoTag()->SetLoaded(true);
+  EXPECT_TRUE(reader.Wait(reader.Queue(items), 0));
+}
+
+/* a benchmark, run it with --gtest_also_run_disabled_tests */
+TEST_F(TestMusicTagReader, DISABLED_Performance)
+{
+  std::vector<CFileItemPtr> items;
+
+  /* get the files into the os cache first so that the first run isn't penalised */
+  {
+    CMusicTagReader reader(1);
+    ReadAll(reader, items);
+  }
+
+  for (unsigned int workers = 1; workers <= 8; workers *= 2)
+  {
+    CMusicTagReader reader(workers);
+
+    int64_t start = CurrentHostCounter();
+    ReadAll(reader, items);
+    double seconds = (double)(CurrentHostCounter() - start) / CurrentHostFrequency();
+
+    std::cout << "Workers: " << workers << " Files/s: "
+              << testing::PrintToString(seconds > 0 ? items.size() / seconds : 0.0) << std::endl;
+  }
+}
@@ -24,6 +24,9 @@
 #include <memory.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#ifdef _LINUX
+#include <sys/ioctl.h>
+#endif
 
 #include "settings/AdvancedSettings.h"
 #include "interfaces/json-rpc/JSONRPC.h"
@@ -55,6 +58,17 @@ using namespace ANNOUNCEMENT;
 //using namespace std; On VS2010, bind conflicts with std::bind
 
 #define RECEIVEBUFFER 1024
+#define MAX_QUEUED_ANNOUNCEMENTS (256 * 1024) // bytes of announcements a slow client can have waiting
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#if defined(TARGET_WINDOWS)
+#define SEND_WOULD_BLOCK() (WSAGetLastError() == WSAEWOULDBLOCK)
+#else
+#define SEND_WOULD_BLOCK() (errno == EAGAIN || errno == EWOULDBLOCK)
+#endif
 
 CTCPServer *CTCPServer::ServerInstance = NULL;
 
@@ -99,9 +113,10 @@ void CTCPServer::Process()
   while (!m_bStop)
   {
     SOCKET          max_fd = 0;
-    fd_set          rfds;
+    fd_set          rfds, wfds;
     struct timeval  to     = {1, 0};
     FD_ZERO(&rfds);
+    FD_ZERO(&wfds);
 
     for (std::vector<SOCKET>::iterator it = m_servers.begin(); it != m_servers.end(); it++)
     {
@@ -113,11 +128,13 @@ void CTCPServer::Process()
     for (unsigned int i = 0; i < m_connections.size(); i++)
     {
       FD_SET(m_connections[i]->m_socket, &rfds);
+      if (m_connections[i]->HasQueuedData())
+        FD_SET(m_connections[i]->m_socket, &wfds);
       if ((intptr_t)m_connections[i]->m_socket > (intptr_t)max_fd)
         max_fd = m_connections[i]->m_socket;
     }
 
-    int res = select((intptr_t)max_fd+1, &rfds, NULL, NULL, &to);
+    int res = select((intptr_t)max_fd+1, &rfds, &wfds, NULL, &to);
     if (res < 0)
     {
       CLog::Log(LOGERROR, "JSONRPC Server: Select failed");
@@ -126,6 +143,19 @@ void CTCPServer::Process()
     }
     else if (res > 0)
     {
+      // send what slow clients couldn't take when it was queued
+      for (int i = m_connections.size() - 1; i >= 0; i--)
+      {
+        if (FD_ISSET(m_connections[i]->m_socket, &wfds) && !m_connections[i]->Flush())
+        {
+          CLog::Log(LOGINFO, "JSONRPC Server: Disconnection detected");
+          CSingleLock lock(m_critSection);
+          m_connections[i]->Disconnect();
+          delete m_connections[i];
+          m_connections.erase(m_connections.begin() + i);
+        }
+      }
+
       for (int i = m_connections.size() - 1; i >= 0; i--)
       {
         int socket = m_connections[i]->m_socket;
@@ -148,6 +178,7 @@ void CTCPServer::Process()
               if (websocket != NULL)
               {
                 // Replace the CTCPClient with a CWebSocketClient
+                CSingleLock lock(m_critSection);
                 CWebSocketClient *websocketClient = new CWebSocketClient(websocket, *(m_connections[i]));
                 delete m_connections[i];
                 m_connections.erase(m_connections.begin() + i);
@@ -166,6 +197,7 @@ void CTCPServer::Process()
           if (close)
           {
             CLog::Log(LOGINFO, "JSONRPC Server: Disconnection detected");
+            CSingleLock lock(m_critSection);
             m_connections[i]->Disconnect();
             delete m_connections[i];
             m_connections.erase(m_connections.begin() + i);
@@ -186,6 +218,11 @@ void CTCPServer::Process()
           else
           {
             CLog::Log(LOGINFO, "JSONRPC Server: New connection added");
+            // announcements are queued rather than waiting on the client
+            unsigned long nonblocking = 1;
+            ioctlsocket(newconnection->m_socket, FIONBIO, &nonblocking);
+
+            CSingleLock lock(m_critSection);
             m_connections.push_back(newconnection);
           }
         }
@@ -213,8 +250,9 @@ int CTCPServer::GetCapabilities()
 
 void CTCPServer::Announce(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
 {
-  std::string str = IJSONRPCAnnouncer::AnnouncementToJSONRPC(flag, sender, message, data, g_advancedSettings.m_jsonOutputCompact);
+  boost::shared_ptr<const std::string> str(new std::string(IJSONRPCAnnouncer::AnnouncementToJSONRPC(flag, sender, message, data, g_advancedSettings.m_jsonOutputCompact)));
 
+  CSingleLock lock (m_critSection);
   for (unsigned int i = 0; i < m_connections.size(); i++)
   {
     {
@@ -223,7 +261,7 @@ void CTCPServer::Announce(AnnouncementFlag flag, const char *sender, const char
         continue;
     }
 
-    m_connections[i]->Send(str.c_str(), str.size());
+    m_connections[i]->Announce(str);
   }
 }
 
@@ -467,6 +505,7 @@ bool CTCPServer::InitializeTCP()
 
 void CTCPServer::Deinitialize()
 {
+  CSingleLock lock (m_critSection);
   for (unsigned int i = 0; i < m_connections.size(); i++)
   {
     m_connections[i]->Disconnect();
@@ -498,6 +537,9 @@ CTCPServer::CTCPClient::CTCPClient()
   m_endBrackets = 0;
   m_beginChar = 0;
   m_endChar = 0;
+  m_queueSize = 0;
+  m_queueOffset = 0;
+  m_dropped = 0;
 
   m_addrlen = sizeof(m_cliaddr);
 }
@@ -531,12 +573,60 @@ bool CTCPServer::CTCPClient::SetAnnouncementFlags(int flags)
 
 void CTCPServer::CTCPClient::Send(const char *data, unsigned int size)
 {
-  unsigned int sent = 0;
-  do
+  Queue(boost::shared_ptr<const std::string>(new std::string(data, size)), false);
+}
+
+void CTCPServer::CTCPClient::Announce(const boost::shared_ptr<const std::string> &announcement)
+{
+  Queue(announcement, true);
+}
+
+void CTCPServer::CTCPClient::Queue(const boost::shared_ptr<const std::string> &data, bool announcement)
+{
+  CSingleLock lock (m_critSection);
+  // responses are always sent, so the client isn't left waiting
+  if (announcement && m_queueSize + data->size() > MAX_QUEUED_ANNOUNCEMENTS)
   {
-    CSingleLock lock (m_critSection);
-    sent += send(m_socket, data, size - sent, 0);
-  } while (sent < size);
+    if (m_dropped++ == 0)
+      CLog::Log(LOGWARNING, "JSONRPC Server: Client isn't keeping up, dropping announcements");
+    return;
+  }
+  m_queue.push_back(data);
+  m_queueSize += data->size();
+  Flush();
+}
+
+bool CTCPServer::CTCPClient::Flush()
+{
+  CSingleLock lock (m_critSection);
+  while (!m_queue.empty())
+  {
+    const std::string &data = *m_queue.front();
+    int sent = send(m_socket, data.c_str() + m_queueOffset, data.size() - m_queueOffset, MSG_NOSIGNAL);
+    if (sent < 0)
+      return SEND_WOULD_BLOCK();
+
+    m_queueOffset += sent;
+    if (m_queueOffset < data.size())
+      return true; // the rest once the socket takes more
+
+    m_queueSize -= data.size();
+    m_queueOffset = 0;
+    m_queue.pop_front();
+  }
+
+  if (m_dropped)
+  {
+    CLog::Log(LOGWARNING, "JSONRPC Server: Client caught up, %u announcements were dropped", m_dropped);
+    m_dropped = 0;
+  }
+  return true;
+}
+
+bool CTCPServer::CTCPClient::HasQueuedData()
+{
+  CSingleLock lock (m_critSection);
+  return !m_queue.empty();
 }
 
 void CTCPServer::CTCPClient::PushBuffer(CTCPServer *host, const char *buffer, int length)
@@ -599,6 +689,10 @@ void CTCPServer::CTCPClient::Copy(const CTCPClient& client)
   m_beginChar         = client.m_beginChar;
   m_endChar           = client.m_endChar;
   m_buffer            = client.m_buffer;
+  m_queue             = client.m_queue;
+  m_queueSize         = client.m_queueSize;
+  m_queueOffset       = client.m_queueOffset;
+  m_dropped           = client.m_dropped;
 }
 
 CTCPServer::CWebSocketClient::CWebSocketClient(CWebSocket *websocket)
@@ -643,6 +737,20 @@ void CTCPServer::CWebSocketClient::Send(const char *data, unsigned int size)
     CTCPClient::Send(frames.at(index)->GetFrameData(), (unsigned int)frames.at(index)->GetFrameLength());
 }
 
+void CTCPServer::CWebSocketClient::Announce(const boost::shared_ptr<const std::string> &announcement)
+{
+  const CWebSocketMessage *msg = m_websocket->Send(WebSocketTextFrame, announcement->c_str(), announcement->size());
+  if (msg == NULL || !msg->IsComplete())
+    return;
+
+  // the frames go out whole or not at all
+  std::string *framed = new std::string();
+  std::vector<const CWebSocketFrame *> frames = msg->GetFrames();
+  for (unsigned int index = 0; index < frames.size(); index++)
+    framed->append(frames.at(index)->GetFrameData(), frames.at(index)->GetFrameLength());
+  Queue(boost::shared_ptr<const std::string>(framed), true);
+}
+
 void CTCPServer::CWebSocketClient::PushBuffer(CTCPServer *host, const char *buffer, int length)
 {
   bool send;
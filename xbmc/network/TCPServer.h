@@ -19,8 +19,11 @@
  *
  */
 
+#include <deque>
+#include <string>
 #include <vector>
 #include <sys/socket.h>
+#include <boost/shared_ptr.hpp>
 
 #include "interfaces/json-rpc/IClient.h"
 #include "interfaces/json-rpc/IJSONRPCAnnouncer.h"
@@ -69,6 +72,18 @@ namespace JSONRPC
       virtual void PushBuffer(CTCPServer *host, const char *buffer, int length);
       virtual void Disconnect();
 
+      /*! \brief Queue an announcement for sending
+       The serialised announcement is shared by all clients. Announcements beyond
+       what a slow client can have waiting are dropped.
+       */
+      virtual void Announce(const boost::shared_ptr<const std::string> &announcement);
+
+      /*! \brief Send as much of the queued data as the socket takes without blocking
+       \return false if the connection failed.
+       */
+      bool Flush();
+      bool HasQueuedData();
+
       virtual bool IsNew() const { return m_new; }
       virtual bool Closing() const { return false; }
 
@@ -79,12 +94,17 @@ namespace JSONRPC
 
     protected:
       void Copy(const CTCPClient& client);
+      void Queue(const boost::shared_ptr<const std::string> &data, bool announcement);
     private:
       bool m_new;
       int m_announcementflags;
       int m_beginBrackets, m_endBrackets;
       char m_beginChar, m_endChar;
       std::string m_buffer;
+      std::deque<boost::shared_ptr<const std::string> > m_queue;
+      unsigned int m_queueSize;   ///< bytes waiting in m_queue
+      unsigned int m_queueOffset; ///< bytes of the first buffer already sent
+      unsigned int m_dropped;     ///< announcements dropped since the queue last emptied
     };
 
     class CWebSocketClient : public CTCPClient
@@ -99,6 +119,7 @@ namespace JSONRPC
       virtual void Send(const char *data, unsigned int size);
       virtual void PushBuffer(CTCPServer *host, const char *buffer, int length);
       virtual void Disconnect();
+      virtual void Announce(const boost::shared_ptr<const std::string> &announcement);
 
       virtual bool IsNew() const { return m_websocket == NULL; }
       virtual bool Closing() const { return m_websocket != NULL && m_websocket->GetState() == WebSocketStateClosed; }
@@ -108,6 +129,7 @@ namespace JSONRPC
     };
 
     std::vector<CTCPClient*> m_connections;
+    CCriticalSection m_critSection; ///< guards m_connections against the announcing thread
     std::vector<SOCKET> m_servers;
     int m_port;
     bool m_nonlocal;
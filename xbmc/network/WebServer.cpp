@@ -25,10 +25,20 @@
 #include "utils/URIUtils.h"
 #include "utils/Variant.h"
 #include "utils/Base64.h"
+#include "utils/StringUtils.h"
 #include "threads/SingleLock.h"
+#include "settings/AdvancedSettings.h"
+#include "filesystem/SpecialProtocol.h"
 #include "XBDateTime.h"
 #include "URL.h"
 
+#include <algorithm>
+#include <limits.h>
+#if defined(TARGET_POSIX)
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
 #ifdef _WIN32
 #pragma comment(lib, "libmicrohttpd.dll.lib")
 #endif
@@ -44,6 +54,28 @@ using namespace JSONRPC;
 
 vector<IHTTPRequestHandler *> CWebServer::m_requestHandlers;
 
+static bool RangeCompare(const CWebServer::HttpRange &left, const CWebServer::HttpRange &right)
+{
+  return left.first < right.first;
+}
+
+// checks whether the ETag is in the list of an If-None-Match header, weak tags match as well
+static bool MatchETag(const string &header, const string &eTag)
+{
+  CStdStringArray tags;
+  StringUtils::SplitString(header, ",", tags);
+  for (unsigned int i = 0; i < tags.size(); i++)
+  {
+    CStdString tag = tags[i];
+    tag.Trim();
+    if (tag.Left(2) == "W/")
+      tag = tag.Mid(2);
+    if (tag == "*" || tag == eTag)
+      return true;
+  }
+  return false;
+}
+
 CWebServer::CWebServer()
 {
   m_running = false;
@@ -358,105 +390,255 @@ int CWebServer::CreateFileDownloadResponse(struct MHD_Connection *connection, co
 {
   CFile *file = new CFile();
 
-  if (file->Open(strURL, READ_NO_CACHE))
+  // we read in large blocks ourselves, so the stream buffer would only add a copy
+  if (!file->Open(strURL, READ_NO_CACHE | READ_CHUNKED))
   {
-    bool getData = true;
-    if (methodType != HEAD)
+    delete file;
+    CLog::Log(LOGERROR, "WebServer: Failed to open %s", strURL.c_str());
+    return SendErrorResponse(connection, MHD_HTTP_NOT_FOUND, GET); /* GET Assumed Temporarily */
+  }
+
+  uint64_t fileLength = file->GetLength();
+
+  // get the Last-Modified date and derive the ETag from it and the length
+  CDateTime lastModified;
+  CStdString lastModifiedString, eTag;
+  struct __stat64 statBuffer;
+  if (file->Stat(&statBuffer) == 0)
+  {
+    struct tm *time = localtime((time_t *)&statBuffer.st_mtime);
+    if (time != NULL)
+    {
+      lastModified = *time;
+      lastModifiedString = lastModified.GetAsRFC1123DateTime();
+    }
+    eTag.Format("\"%" PRIx64 "-%" PRIx64 "\"", (uint64_t)statBuffer.st_mtime, fileLength);
+  }
+
+  // handle the conditional GET/HEAD headers, If-None-Match takes precedence over If-Modified-Since
+  bool getData = methodType != HEAD;
+  string ifNoneMatch = GetRequestHeaderValue(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_IF_NONE_MATCH);
+  if (!ifNoneMatch.empty())
+  {
+    if (!eTag.empty() && MatchETag(ifNoneMatch, eTag))
     {
-      if (methodType == GET)
+      getData = false;
+      responseCode = MHD_HTTP_NOT_MODIFIED;
+    }
+  }
+  else if (lastModified.IsValid())
+  {
+    string ifModifiedSince = GetRequestHeaderValue(connection, MHD_HEADER_KIND, "If-Modified-Since");
+    if (!ifModifiedSince.empty())
+    {
+      CDateTime ifModifiedSinceDate;
+      ifModifiedSinceDate.SetFromRFC1123DateTime(ifModifiedSince);
+      if (lastModified.GetAsUTCDateTime() <= ifModifiedSinceDate)
       {
-        string ifModifiedSince = GetRequestHeaderValue(connection, MHD_HEADER_KIND, "If-Modified-Since");
-        if (!ifModifiedSince.empty())
-        {
-          CDateTime ifModifiedSinceDate;
-          ifModifiedSinceDate.SetFromRFC1123DateTime(ifModifiedSince);
+        getData = false;
+        responseCode = MHD_HTTP_NOT_MODIFIED;
+      }
+    }
+  }
 
-          struct __stat64 statBuffer;
-          if (file->Stat(&statBuffer) == 0)
-          {
-            struct tm *time = localtime((time_t *)&statBuffer.st_mtime);
-            if (time != NULL)
-            {
-              CDateTime lastModified = *time;
-              if (lastModified.GetAsUTCDateTime() <= ifModifiedSinceDate)
-              {
-                getData = false;
-                response = MHD_create_response_from_data (0, NULL, MHD_NO, MHD_NO);
-                responseCode = MHD_HTTP_NOT_MODIFIED;
-              }
-            }
-          }
-        }
+  // a range is only sent if the client still has the same version of the file
+  vector<HttpRange> ranges;
+  if (getData && methodType == GET)
+  {
+    string range = GetRequestHeaderValue(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_RANGE);
+    string ifRange = GetRequestHeaderValue(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_IF_RANGE);
+    if (!range.empty() && (ifRange.empty() || ifRange == eTag || ifRange == lastModifiedString))
+    {
+      int rangeResult = ParseRangeHeader(range, fileLength, ranges);
+      if (rangeResult == MHD_HTTP_REQUESTED_RANGE_NOT_SATISFIABLE)
+      {
+        getData = false;
+        responseCode = rangeResult;
       }
+      else if (rangeResult == MHD_HTTP_PARTIAL_CONTENT)
+        responseCode = rangeResult;
+    }
+  }
 
-      if (getData)
-        response = MHD_create_response_from_callback(file->GetLength(),
-                                                     2048,
-                                                     &CWebServer::ContentReaderCallback, file,
-                                                     &CWebServer::ContentReaderFreeCallback);
-      if (response == NULL)
-        return MHD_NO;
+  CStdString ext = URIUtils::GetExtension(strURL);
+  ext = ext.ToLower();
+  const char *mime = CreateMimeTypeFromExtension(ext.c_str());
+
+  if (getData)
+  {
+    HttpFileDownloadContext *context = new HttpFileDownloadContext();
+    context->file = file;
+    context->currentPart = 0;
+
+    if (ranges.empty())
+    {
+      HttpFileDownloadPart part = { "", 0, fileLength, 0 };
+      context->parts.push_back(part);
+    }
+    else if (ranges.size() == 1)
+    {
+      HttpFileDownloadPart part = { "", ranges[0].first, ranges[0].last - ranges[0].first + 1, 0 };
+      context->parts.push_back(part);
     }
     else
     {
-      getData = false;
+      // send a multipart/byteranges body, every part carries its own Content-Range
+      CStdString boundary;
+      boundary.Format("XBMC-%08x%08x", (unsigned int)rand(), (unsigned int)fileLength);
 
-      CStdString contentLength;
-      contentLength.Format("%I64d", file->GetLength());
+      uint64_t position = 0;
+      for (vector<HttpRange>::const_iterator range = ranges.begin(); range != ranges.end(); range++)
+      {
+        CStdString partHeader;
+        partHeader.Format("\r\n--%s\r\n", boundary.c_str());
+        if (mime)
+          partHeader.AppendFormat("Content-Type: %s\r\n", mime);
+        partHeader.AppendFormat("Content-Range: bytes %" PRIu64 "-%" PRIu64 "/%" PRIu64 "\r\n\r\n", range->first, range->last, fileLength);
+
+        HttpFileDownloadPart part;
+        part.header   = partHeader;
+        part.first    = range->first;
+        part.length   = range->last - range->first + 1;
+        part.position = position;
+        position += part.header.size() + part.length;
+        context->parts.push_back(part);
+      }
+
+      CStdString endHeader;
+      endHeader.Format("\r\n--%s--\r\n", boundary.c_str());
+
+      HttpFileDownloadPart end;
+      end.header   = endHeader;
+      end.first    = 0;
+      end.length   = 0;
+      end.position = position;
+      context->parts.push_back(end);
+
+      mime = NULL;
+      CStdString contentType;
+      contentType.Format("multipart/byteranges; boundary=%s", boundary.c_str());
+      response = MHD_create_response_from_callback(position + end.header.size(),
+                                                   g_advancedSettings.m_webserverBlockSize,
+                                                   &CWebServer::ContentReaderCallback, context,
+                                                   &CWebServer::ContentReaderFreeCallback);
+      if (response != NULL)
+        MHD_add_response_header(response, MHD_HTTP_HEADER_CONTENT_TYPE, contentType.c_str());
+    }
 
-      response = MHD_create_response_from_data (0, NULL, MHD_NO, MHD_NO);
-      if (response == NULL)
+    if (context->parts.size() == 1)
+    {
+      const HttpFileDownloadPart &part = context->parts[0];
+
+      // local files can be sent straight from the file descriptor
+      response = CreateFileDescriptorResponse(strURL, part.first, part.length);
+      if (response != NULL)
       {
         file->Close();
         delete file;
-        return MHD_NO;
+        delete context;
       }
-      MHD_add_response_header(response, "Content-Length", contentLength);
-    }
-
-    // set the Content-Type header
-    CStdString ext = URIUtils::GetExtension(strURL);
-    ext = ext.ToLower();
-    const char *mime = CreateMimeTypeFromExtension(ext.c_str());
-    if (mime)
-      MHD_add_response_header(response, "Content-Type", mime);
+      else
+        response = MHD_create_response_from_callback(part.length,
+                                                     g_advancedSettings.m_webserverBlockSize,
+                                                     &CWebServer::ContentReaderCallback, context,
+                                                     &CWebServer::ContentReaderFreeCallback);
 
-    // set the Last-Modified header
-    struct __stat64 statBuffer;
-    if (file->Stat(&statBuffer) == 0)
-    {
-      struct tm *time = localtime((time_t *)&statBuffer.st_mtime);
-      if (time != NULL)
+      if (response != NULL && !ranges.empty())
       {
-        CDateTime lastModified = *time;
-        MHD_add_response_header(response, "Last-Modified", lastModified.GetAsRFC1123DateTime());
+        CStdString contentRange;
+        contentRange.Format("bytes %" PRIu64 "-%" PRIu64 "/%" PRIu64, ranges[0].first, ranges[0].last, fileLength);
+        MHD_add_response_header(response, MHD_HTTP_HEADER_CONTENT_RANGE, contentRange.c_str());
       }
     }
 
-    // set the Expires header
-    CDateTime expiryTime = CDateTime::GetCurrentDateTime();
-    if (mime && strncmp(mime, "text/html", 9) == 0)
-      expiryTime += CDateTimeSpan(1, 0, 0, 0);
-    else
-      expiryTime += CDateTimeSpan(365, 0, 0, 0);
-    MHD_add_response_header(response, "Expires", expiryTime.GetAsRFC1123DateTime());
-
-    // only close the CFile instance if libmicrohttpd doesn't have to grab the data of the file
-    if (!getData)
+    if (response == NULL)
     {
+      // the free callback is only called for responses that were created
       file->Close();
       delete file;
+      delete context;
+      return MHD_NO;
     }
   }
   else
   {
+    file->Close();
     delete file;
-    CLog::Log(LOGERROR, "WebServer: Failed to open %s", strURL.c_str());
-    return SendErrorResponse(connection, MHD_HTTP_NOT_FOUND, GET); /* GET Assumed Temporarily */
+
+    response = MHD_create_response_from_data (0, NULL, MHD_NO, MHD_NO);
+    if (response == NULL)
+      return MHD_NO;
+
+    if (responseCode == MHD_HTTP_REQUESTED_RANGE_NOT_SATISFIABLE)
+    {
+      CStdString contentRange;
+      contentRange.Format("bytes */%" PRIu64, fileLength);
+      MHD_add_response_header(response, MHD_HTTP_HEADER_CONTENT_RANGE, contentRange.c_str());
+    }
+    else if (methodType == HEAD && responseCode != MHD_HTTP_NOT_MODIFIED)
+    {
+      CStdString contentLength;
+      contentLength.Format("%" PRIu64, fileLength);
+      MHD_add_response_header(response, "Content-Length", contentLength);
+    }
   }
+
+  // set the Content-Type header
+  if (mime)
+    MHD_add_response_header(response, "Content-Type", mime);
+
+  MHD_add_response_header(response, MHD_HTTP_HEADER_ACCEPT_RANGES, "bytes");
+
+  // set the Last-Modified and ETag headers
+  if (!lastModifiedString.empty())
+    MHD_add_response_header(response, "Last-Modified", lastModifiedString.c_str());
+  if (!eTag.empty())
+    MHD_add_response_header(response, MHD_HTTP_HEADER_ETAG, eTag.c_str());
+
+  // set the Expires header
+  CDateTime expiryTime = CDateTime::GetCurrentDateTime();
+  if (mime && strncmp(mime, "text/html", 9) == 0)
+    expiryTime += CDateTimeSpan(1, 0, 0, 0);
+  else
+    expiryTime += CDateTimeSpan(365, 0, 0, 0);
+  MHD_add_response_header(response, "Expires", expiryTime.GetAsRFC1123DateTime());
+
   return MHD_YES;
 }
 
+struct MHD_Response* CWebServer::CreateFileDescriptorResponse(const string &strURL, uint64_t first, uint64_t length)
+{
+#if defined(TARGET_POSIX) && (MHD_VERSION >= 0x00091200)
+  // only plain local files, anything else has to go through the VFS
+  CStdString path = CSpecialProtocol::TranslatePath(strURL);
+  if (!CURL(path).GetProtocol().IsEmpty())
+    return NULL;
+
+  // the offset and size of the MHD interface can be 32 bit wide
+  if (sizeof(size_t) < sizeof(uint64_t) && first + length > INT_MAX)
+    return NULL;
+
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return NULL;
+
+  struct stat statBuffer;
+  if (fstat(fd, &statBuffer) != 0 || !S_ISREG(statBuffer.st_mode) || (uint64_t)statBuffer.st_size < first + length)
+  {
+    close(fd);
+    return NULL;
+  }
+
+  // libmicrohttpd owns the descriptor from now on and uses sendfile where it can
+  struct MHD_Response *response = MHD_create_response_from_fd_at_offset((size_t)length, fd, (off_t)first);
+  if (response == NULL)
+    close(fd);
+  return response;
+#else
+  return NULL;
+#endif
+}
+
 int CWebServer::CreateErrorResponse(struct MHD_Connection *connection, int responseType, HTTPMethod method, struct MHD_Response *&response)
 {
   size_t payloadSize = 0;
@@ -518,10 +700,32 @@ int CWebServer::ContentReaderCallback(void *cls, uint64_t pos, char *buf, int ma
 int CWebServer::ContentReaderCallback(void *cls, size_t pos, char *buf, int max)
 #endif
 {
-  CFile *file = (CFile *)cls;
-  if((unsigned int)pos != file->GetPosition())
-    file->Seek(pos);
-  unsigned res = file->Read(buf, max);
+  HttpFileDownloadContext *context = (HttpFileDownloadContext *)cls;
+
+  // libmicrohttpd reads front to back, so only start over if it goes back
+  if (context->currentPart >= context->parts.size() || pos < context->parts[context->currentPart].position)
+    context->currentPart = 0;
+  while (context->currentPart < context->parts.size() &&
+         pos >= context->parts[context->currentPart].position + context->parts[context->currentPart].header.size() + context->parts[context->currentPart].length)
+    context->currentPart++;
+  if (context->currentPart >= context->parts.size())
+    return -1;
+
+  const HttpFileDownloadPart &part = context->parts[context->currentPart];
+  uint64_t offset = pos - part.position;
+  if (offset < part.header.size())
+  {
+    size_t size = std::min((size_t)max, (size_t)(part.header.size() - offset));
+    memcpy(buf, part.header.c_str() + offset, size);
+    return size;
+  }
+
+  offset -= part.header.size();
+  int64_t filePos = part.first + offset;
+  if (filePos != context->file->GetPosition())
+    context->file->Seek(filePos);
+
+  unsigned res = context->file->Read(buf, std::min((uint64_t)max, part.length - offset));
   if(res == 0)
     return -1;
   return res;
@@ -529,10 +733,11 @@ int CWebServer::ContentReaderCallback(void *cls, size_t pos, char *buf, int max)
 
 void CWebServer::ContentReaderFreeCallback(void *cls)
 {
-  CFile *file = (CFile *)cls;
-  file->Close();
+  HttpFileDownloadContext *context = (HttpFileDownloadContext *)cls;
+  context->file->Close();
 
-  delete file;
+  delete context->file;
+  delete context;
 }
 
 struct MHD_Daemon* CWebServer::StartMHD(unsigned int flags, int port)
@@ -717,6 +922,88 @@ int CWebServer::GetRequestHeaderValues(struct MHD_Connection *connection, enum M
   return MHD_get_connection_values(connection, kind, FillArgumentMultiMap, &headerValues);
 }
 
+int CWebServer::ParseRangeHeader(const std::string &header, uint64_t length, std::vector<HttpRange> &ranges)
+{
+  ranges.clear();
+
+  // we only know about byte ranges, any other unit means the header is ignored
+  CStdString value = header;
+  value.Trim();
+  if (value.Left(6).ToLower() != "bytes=")
+    return MHD_HTTP_OK;
+
+  CStdStringArray specs;
+  StringUtils::SplitString(value.Mid(6), ",", specs);
+
+  vector<HttpRange> valid;
+  bool syntaxValid = false;
+  for (unsigned int i = 0; i < specs.size(); i++)
+  {
+    CStdString spec = specs[i];
+    spec.Trim();
+    if (spec.empty())
+      continue;
+
+    size_t dash = spec.find('-');
+    if (dash == string::npos)
+      return MHD_HTTP_OK;
+
+    CStdString firstString = spec.Left(dash), lastString = spec.Mid(dash + 1);
+    firstString.Trim();
+    lastString.Trim();
+    if ((!firstString.empty() && !StringUtils::IsNaturalNumber(firstString)) ||
+        (!lastString.empty() && !StringUtils::IsNaturalNumber(lastString)) ||
+        (firstString.empty() && lastString.empty()))
+      return MHD_HTTP_OK;
+
+    HttpRange range;
+    if (firstString.empty())
+    {
+      // suffix range: the last n bytes of the file
+      uint64_t suffix = strtoull(lastString.c_str(), NULL, 10);
+      syntaxValid = true;
+      if (suffix == 0 || length == 0)
+        continue;
+      range.first = suffix < length ? length - suffix : 0;
+      range.last  = length - 1;
+    }
+    else
+    {
+      range.first = strtoull(firstString.c_str(), NULL, 10);
+      range.last  = lastString.empty() ? range.first : strtoull(lastString.c_str(), NULL, 10);
+      if (range.last < range.first)
+        return MHD_HTTP_OK;
+
+      syntaxValid = true;
+      if (range.first >= length)
+        continue;
+      if (lastString.empty() || range.last >= length)
+        range.last = length - 1;
+    }
+    valid.push_back(range);
+  }
+
+  if (!syntaxValid)
+    return MHD_HTTP_OK;
+  if (valid.empty())
+    return MHD_HTTP_REQUESTED_RANGE_NOT_SATISFIABLE;
+
+  // merge overlapping and adjacent ranges, that also keeps clients from
+  // asking for the same data over and over again
+  sort(valid.begin(), valid.end(), RangeCompare);
+  ranges.push_back(valid[0]);
+  for (unsigned int i = 1; i < valid.size(); i++)
+  {
+    HttpRange &last = ranges.back();
+    if (valid[i].first <= last.last + 1)
+      last.last = std::max(last.last, valid[i].last);
+    else
+      ranges.push_back(valid[i]);
+  }
+
+  return MHD_HTTP_PARTIAL_CONTENT;
+}
+
 const char *CWebServer::CreateMimeTypeFromExtension(const char *ext)
 {
   if (strcmp(ext, ".aif") == 0)   return "audio/aiff";
@@ -33,6 +33,11 @@
 #include "threads/CriticalSection.h"
 #include "httprequesthandler/IHTTPRequestHandler.h"
 
+namespace XFILE
+{
+  class CFile;
+}
+
 class CWebServer : public JSONRPC::ITransportLayer
 {
 public:
@@ -54,6 +59,21 @@ public:
   static std::string GetRequestHeaderValue(struct MHD_Connection *connection, enum MHD_ValueKind kind, const std::string &key);
   static int GetRequestHeaderValues(struct MHD_Connection *connection, enum MHD_ValueKind kind, std::map<std::string, std::string> &headerValues);
   static int GetRequestHeaderValues(struct MHD_Connection *connection, enum MHD_ValueKind kind, std::multimap<std::string, std::string> &headerValues);
+
+  typedef struct HttpRange
+  {
+    uint64_t first;
+    uint64_t last;
+  } HttpRange;
+
+  /*!
+   \brief Parse the value of a Range header (RFC 7233) for a file of the given length.
+   Overlapping and adjacent ranges are merged.
+   \return MHD_HTTP_PARTIAL_CONTENT if ranges holds the ranges to send,
+           MHD_HTTP_REQUESTED_RANGE_NOT_SATISFIABLE if none of them lies within the file or
+           MHD_HTTP_OK if the header is invalid and the whole file has to be sent
+   */
+  static int ParseRangeHeader(const std::string &header, uint64_t length, std::vector<HttpRange> &ranges);
 private:
   struct MHD_Daemon* StartMHD(unsigned int flags, int port);
   static int AskForAuthentication (struct MHD_Connection *connection);
@@ -92,6 +112,7 @@ private:
   static void ContentReaderFreeCallback (void *cls);
   static int CreateRedirect(struct MHD_Connection *connection, const std::string &strURL, struct MHD_Response *&response);
   static int CreateFileDownloadResponse(struct MHD_Connection *connection, const std::string &strURL, HTTPMethod methodType, struct MHD_Response *&response, int &responseCode);
+  static struct MHD_Response* CreateFileDescriptorResponse(const std::string &strURL, uint64_t first, uint64_t length);
   static int CreateErrorResponse(struct MHD_Connection *connection, int responseType, HTTPMethod method, struct MHD_Response *&response);
   static int CreateMemoryDownloadResponse(struct MHD_Connection *connection, void *data, size_t size, bool free, bool copy, struct MHD_Response *&response);
 
@@ -114,5 +135,20 @@ private:
     IHTTPRequestHandler *requestHandler;
     struct MHD_PostProcessor *postprocessor;
   } ConnectionHandler;
+
+  typedef struct HttpFileDownloadPart
+  {
+    std::string header; // multipart boundary and headers sent in front of the data
+    uint64_t first;     // first byte of the file to send
+    uint64_t length;    // number of bytes of the file to send
+    uint64_t position;  // offset of the part in the response body
+  } HttpFileDownloadPart;
+
+  typedef struct HttpFileDownloadContext
+  {
+    XFILE::CFile *file;
+    std::vector<HttpFileDownloadPart> parts;
+    size_t currentPart;
+  } HttpFileDownloadContext;
 };
 #endif
@@ -0,0 +1,321 @@
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+#include "network/TCPServer.h"
+#include "interfaces/AnnouncementManager.h"
+#include "threads/SingleLock.h"
+#include "threads/Thread.h"
+#include "utils/StdString.h"
+#include "utils/Variant.h"
+
+#include "gtest/gtest.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+#define TEST_PORT         34568
+#define SLOW_CLIENTS      16
+#define ANNOUNCEMENTS     2000
+
+using namespace ANNOUNCEMENT;
+using namespace JSONRPC;
+
+static int Connect(int receiveBuffer)
+{
+  int fd = socket(PF_INET, SOCK_STREAM, 0);
+  if (receiveBuffer)
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, (const char *)&receiveBuffer, sizeof(receiveBuffer));
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(TEST_PORT);
+  inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr.s_addr);
+  if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+  {
+    closesocket(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/* reads everything sent to a client until told to stop */
+class CReadingClient : public CThread
+{
+public:
+  CReadingClient(int fd) : CThread("TestTCPClient"), m_fd(fd) {}
+
+  virtual void Process()
+  {
+    char buffer[4096];
+    while (!m_bStop)
+    {
+      fd_set rfds;
+      FD_ZERO(&rfds);
+      FD_SET(m_fd, &rfds);
+      struct timeval to = {0, 100000};
+      if (select(m_fd + 1, &rfds, NULL, NULL, &to) <= 0)
+        continue;
+
+      int nread = recv(m_fd, buffer, sizeof(buffer), 0);
+      if (nread <= 0)
+        break;
+      CSingleLock lock(m_section);
+      m_received.append(buffer, nread);
+    }
+  }
+
+  /* wait for the given text to turn up */
+  bool WaitFor(const char *text, unsigned int timeoutMs)
+  {
+    unsigned int waited = 0;
+    while (waited < timeoutMs)
+    {
+      {
+        CSingleLock lock(m_section);
+        if (m_received.find(text) != std::string::npos)
+          return true;
+      }
+      Sleep(50);
+      waited += 50;
+    }
+    return false;
+  }
+
+  unsigned int Count(const char *text)
+  {
+    CSingleLock lock(m_section);
+    unsigned int count = 0;
+    for (size_t pos = m_received.find(text); pos != std::string::npos; pos = m_received.find(text, pos + 1))
+      count++;
+    return count;
+  }
+
+  int m_fd;
+  CCriticalSection m_section;
+  std::string m_received;
+};
+
+/* keeps the dispatch thread busy, so that announcements pile up in the queue */
+class CHoldingAnnouncer : public IAnnouncer
+{
+public:
+  virtual void Announce(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
+  {
+    if (flag == Other && strcmp(message, "OnHold") == 0)
+    {
+      m_held.Set();
+      m_release.Wait();
+    }
+  }
+
+  CEvent m_held;
+  CEvent m_release;
+};
+
+/* remembers the thread it was last told on */
+class CThreadAnnouncer : public IAnnouncer
+{
+public:
+  CThreadAnnouncer() : m_count(0) {}
+  virtual void Announce(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
+  {
+    if (flag == Player && strcmp(message, "OnPlay") == 0)
+    {
+      m_thread = CThread::GetCurrentThreadId();
+      m_count++;
+    }
+  }
+
+  ThreadIdentifier m_thread;
+  int m_count;
+};
+
+class TestTCPServer : public testing::Test
+{
+protected:
+  TestTCPServer()
+  {
+    CAnnouncementManager::Initialize();
+    m_started = CTCPServer::StartServer(TEST_PORT, false);
+  }
+
+  ~TestTCPServer()
+  {
+    CTCPServer::StopServer(true);
+    CAnnouncementManager::Deinitialize();
+  }
+
+  /* the server accepts the clients in the order they connected, so once the
+     last one gets announcements all of them are connected */
+  bool WaitForAccept(CReadingClient &reader)
+  {
+    for (int i = 0; i < 100; i++)
+    {
+      CAnnouncementManager::Announce(Other, "xbmc", "OnAccepted");
+      if (reader.WaitFor("Other.OnAccepted", 100))
+        return true;
+    }
+    return false;
+  }
+
+  bool m_started;
+};
+
+TEST_F(TestTCPServer, SlowClients)
+{
+  ASSERT_TRUE(m_started);
+
+  /* clients that never read, with as little buffering as the system allows */
+  std::vector<int> slow;
+  for (int i = 0; i < SLOW_CLIENTS; i++)
+  {
+    int fd = Connect(1024);
+    if (fd >= 0)
+      slow.push_back(fd);
+  }
+  ASSERT_EQ((size_t)SLOW_CLIENTS, slow.size());
+
+  int fd = Connect(0);
+  ASSERT_GE(fd, 0);
+  CReadingClient reader(fd);
+  reader.Create();
+
+  ASSERT_TRUE(WaitForAccept(reader));
+
+  CVariant data;
+  data["player"]["playerid"] = 1;
+  data["property"]["padding"] = std::string(512, 'x');
+
+  /* far more than the slow clients take, the announcer would block on them
+     if it waited for the clients */
+  for (int i = 0; i < ANNOUNCEMENTS; i++)
+  {
+    data["property"]["index"] = i;
+    CAnnouncementManager::Announce(Player, "xbmc", "OnPropertyChanged", data);
+  }
+
+  /* and a client that keeps up isn't held up by the others */
+  CStdString last;
+  last.Format("\"index\":%d", ANNOUNCEMENTS - 1);
+  EXPECT_TRUE(reader.WaitFor(last.c_str(), 10000));
+
+  reader.StopThread();
+  closesocket(fd);
+  for (size_t i = 0; i < slow.size(); i++)
+    closesocket(slow[i]);
+}
+
+TEST_F(TestTCPServer, CoalesceSeeks)
+{
+  ASSERT_TRUE(m_started);
+
+  int fd = Connect(0);
+  ASSERT_GE(fd, 0);
+  CReadingClient reader(fd);
+  reader.Create();
+  ASSERT_TRUE(WaitForAccept(reader));
+
+  /* nothing is delivered while the dispatch thread is held */
+  CHoldingAnnouncer holder;
+  CAnnouncementManager::AddAnnouncer(&holder);
+  CAnnouncementManager::Announce(Other, "xbmc", "OnHold");
+  ASSERT_TRUE(holder.m_held.WaitMSec(10000));
+
+  CVariant data;
+  data["player"]["playerid"] = 1;
+  for (int i = 0; i < 100; i++)
+  {
+    data["player"]["seekoffset"] = i;
+    CAnnouncementManager::Announce(Player, "xbmc", "OnSeek", data);
+  }
+
+  /* a seek of another player and anything else in between are kept apart */
+  data["player"]["playerid"] = 2;
+  data["player"]["seekoffset"] = 200;
+  CAnnouncementManager::Announce(Player, "xbmc", "OnSeek", data);
+  CAnnouncementManager::Announce(Player, "xbmc", "OnPause");
+  data["player"]["playerid"] = 1;
+  data["player"]["seekoffset"] = 300;
+  CAnnouncementManager::Announce(Player, "xbmc", "OnSeek", data);
+
+  holder.m_release.Set();
+  EXPECT_TRUE(reader.WaitFor("\"seekoffset\":300", 10000));
+  CAnnouncementManager::RemoveAnnouncer(&holder);
+
+  /* the 100 queued seeks of the first player went out as one, with the last offset */
+  EXPECT_EQ(3U, reader.Count("Player.OnSeek"));
+  EXPECT_EQ(1U, reader.Count("\"seekoffset\":99"));
+  EXPECT_EQ(0U, reader.Count("\"seekoffset\":98"));
+  EXPECT_EQ(1U, reader.Count("\"seekoffset\":200"));
+
+  reader.StopThread();
+  closesocket(fd);
+}
+
+TEST_F(TestTCPServer, SystemAnnouncementsInOrder)
+{
+  ASSERT_TRUE(m_started);
+
+  int fd = Connect(0);
+  ASSERT_GE(fd, 0);
+  CReadingClient reader(fd);
+  reader.Create();
+  ASSERT_TRUE(WaitForAccept(reader));
+
+  /* a system announcement doesn't overtake what was queued before it, and the
+     announcers have seen it when Announce() returns */
+  CAnnouncementManager::Announce(Player, "xbmc", "OnStop");
+  CAnnouncementManager::Announce(System, "xbmc", "OnSleep");
+  EXPECT_TRUE(reader.WaitFor("System.OnSleep", 10000));
+  {
+    CSingleLock lock(reader.m_section);
+    size_t stop = reader.m_received.find("Player.OnStop");
+    ASSERT_NE(std::string::npos, stop);
+    EXPECT_LT(stop, reader.m_received.find("System.OnSleep"));
+  }
+
+  reader.StopThread();
+  closesocket(fd);
+}
+
+TEST_F(TestTCPServer, SynchronousAnnouncers)
+{
+  ASSERT_TRUE(m_started);
+
+  CHoldingAnnouncer holder;
+  CAnnouncementManager::AddAnnouncer(&holder);
+  CAnnouncementManager::Announce(Other, "xbmc", "OnHold");
+  ASSERT_TRUE(holder.m_held.WaitMSec(10000));
+
+  /* an announcer that reads the state of the application is told before
+     Announce() returns, even while the dispatch thread is busy */
+  CThreadAnnouncer announcer;
+  CAnnouncementManager::AddAnnouncer(&announcer, true);
+  CAnnouncementManager::Announce(Player, "xbmc", "OnPlay");
+  EXPECT_EQ(1, announcer.m_count);
+  EXPECT_TRUE(CThread::GetCurrentThreadId() == announcer.m_thread);
+  CAnnouncementManager::RemoveAnnouncer(&announcer);
+
+  holder.m_release.Set();
+  CAnnouncementManager::RemoveAnnouncer(&holder);
+}
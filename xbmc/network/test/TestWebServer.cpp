@@ -0,0 +1,341 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "network/WebServer.h"
+#ifdef HAS_WEB_SERVER
+#include "filesystem/File.h"
+#include "test/TestUtils.h"
+#include "utils/TimeUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+#define TEST_PORT 34567
+
+typedef std::vector<CWebServer::HttpRange> HttpRanges;
+
+static HttpRanges Parse(const std::string &header, uint64_t length, int expected)
+{
+  HttpRanges ranges;
+  EXPECT_EQ(expected, CWebServer::ParseRangeHeader(header, length, ranges)) << header;
+  return ranges;
+}
+
+TEST(TestWebServer, ParseRangeHeader)
+{
+  HttpRanges ranges = Parse("bytes=0-499", 10000, MHD_HTTP_PARTIAL_CONTENT);
+  ASSERT_EQ(1U, ranges.size());
+  EXPECT_EQ(0U, ranges[0].first);
+  EXPECT_EQ(499U, ranges[0].last);
+
+  ranges = Parse("bytes=9500-", 10000, MHD_HTTP_PARTIAL_CONTENT);
+  ASSERT_EQ(1U, ranges.size());
+  EXPECT_EQ(9500U, ranges[0].first);
+  EXPECT_EQ(9999U, ranges[0].last);
+
+  ranges = Parse("bytes=-500", 10000, MHD_HTTP_PARTIAL_CONTENT);
+  ASSERT_EQ(1U, ranges.size());
+  EXPECT_EQ(9500U, ranges[0].first);
+  EXPECT_EQ(9999U, ranges[0].last);
+
+  /* the end is clipped to the file */
+  ranges = Parse("bytes=9000-20000", 10000, MHD_HTTP_PARTIAL_CONTENT);
+  ASSERT_EQ(1U, ranges.size());
+  EXPECT_EQ(9999U, ranges[0].last);
+
+  ranges = Parse("bytes=-20000", 10000, MHD_HTTP_PARTIAL_CONTENT);
+  ASSERT_EQ(1U, ranges.size());
+  EXPECT_EQ(0U, ranges[0].first);
+}
+
+TEST(TestWebServer, ParseMultipleRanges)
+{
+  HttpRanges ranges = Parse("bytes=500-599, 0-99 ,9000-", 10000, MHD_HTTP_PARTIAL_CONTENT);
+  ASSERT_EQ(3U, ranges.size());
+  EXPECT_EQ(0U, ranges[0].first);
+  EXPECT_EQ(500U, ranges[1].first);
+  EXPECT_EQ(9000U, ranges[2].first);
+
+  /* overlapping and adjacent ranges are merged */
+  ranges = Parse("bytes=0-99,100-199,150-299,-100", 10000, MHD_HTTP_PARTIAL_CONTENT);
+  ASSERT_EQ(2U, ranges.size());
+  EXPECT_EQ(0U, ranges[0].first);
+  EXPECT_EQ(299U, ranges[0].last);
+  EXPECT_EQ(9900U, ranges[1].first);
+
+  /* ranges outside the file are dropped */
+  ranges = Parse("bytes=0-99,20000-", 10000, MHD_HTTP_PARTIAL_CONTENT);
+  EXPECT_EQ(1U, ranges.size());
+}
+
+TEST(TestWebServer, ParseInvalidRange)
+{
+  Parse("", 10000, MHD_HTTP_OK);
+  Parse("items=0-1", 10000, MHD_HTTP_OK);
+  Parse("bytes=", 10000, MHD_HTTP_OK);
+  Parse("bytes=abc", 10000, MHD_HTTP_OK);
+  Parse("bytes=-", 10000, MHD_HTTP_OK);
+  Parse("bytes=500-100", 10000, MHD_HTTP_OK);
+  Parse("bytes=0-1,x-5", 10000, MHD_HTTP_OK);
+
+  Parse("bytes=10000-", 10000, MHD_HTTP_REQUESTED_RANGE_NOT_SATISFIABLE);
+  Parse("bytes=-0", 10000, MHD_HTTP_REQUESTED_RANGE_NOT_SATISFIABLE);
+  Parse("bytes=0-", 0, MHD_HTTP_REQUESTED_RANGE_NOT_SATISFIABLE);
+}
+
+/* serves the file given by the url, /test/<path> */
+class CTestFileHandler : public IHTTPRequestHandler
+{
+public:
+  CTestFileHandler() { }
+
+  virtual IHTTPRequestHandler* GetInstance() { return new CTestFileHandler(); }
+  virtual bool CheckHTTPRequest(const HTTPRequest &request) { return request.url.find("/test/") == 0; }
+  virtual int HandleHTTPRequest(const HTTPRequest &request)
+  {
+    m_path = request.url.substr(6);
+    m_responseCode = MHD_HTTP_OK;
+    m_responseType = HTTPFileDownload;
+    return MHD_YES;
+  }
+
+  virtual std::string GetHTTPResponseFile() const { return m_path; }
+
+private:
+  std::string m_path;
+};
+
+typedef struct HttpResponse
+{
+  int status;
+  std::string headers;
+  std::string body;
+} HttpResponse;
+
+/* a minimal HTTP/1.0 client, the server closes the connection after the response */
+static bool HttpGet(const std::string &url, const std::string &extraHeaders, HttpResponse &response)
+{
+  int sock = socket(AF_INET, SOCK_STREAM, 0);
+  if (sock < 0)
+    return false;
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family      = AF_INET;
+  addr.sin_port        = htons(TEST_PORT);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+  {
+    close(sock);
+    return false;
+  }
+
+  std::string request = "GET " + url + " HTTP/1.0\r\n" + extraHeaders + "\r\n";
+  if (send(sock, request.c_str(), request.size(), 0) != (ssize_t)request.size())
+  {
+    close(sock);
+    return false;
+  }
+
+  std::string data;
+  std::vector<char> buffer(256 * 1024);
+  ssize_t size;
+  while ((size = recv(sock, &buffer[0], buffer.size(), 0)) > 0)
+    data.append(&buffer[0], size);
+  close(sock);
+
+  size_t end = data.find("\r\n\r\n");
+  if (end == std::string::npos || data.compare(0, 5, "HTTP/") != 0)
+    return false;
+
+  response.status  = atoi(data.c_str() + data.find(' ') + 1);
+  response.headers = data.substr(0, end + 2);
+  response.body    = data.substr(end + 4);
+  return true;
+}
+
+class TestWebServerDownload : public testing::Test
+{
+protected:
+  TestWebServerDownload()
+  {
+    CWebServer::RegisterRequestHandler(&m_handler);
+    m_server.Start(TEST_PORT, "", "");
+  }
+
+  ~TestWebServerDownload()
+  {
+    m_server.Stop();
+    CWebServer::UnregisterRequestHandler(&m_handler);
+  }
+
+  /* creates a temporary file of the given size, the content is derived from the offset */
+  XFILE::CFile *CreateFile(unsigned int size)
+  {
+    XFILE::CFile *file = XBMC_CREATETEMPFILE(".bin");
+    if (!file)
+      return NULL;
+
+    std::vector<unsigned char> block(64 * 1024);
+    for (unsigned int pos = 0; pos < size; pos += block.size())
+    {
+      for (unsigned int i = 0; i < block.size(); i++)
+        block[i] = (unsigned char)((pos + i) * 7 >> 3);
+      file->Write(&block[0], std::min((unsigned int)block.size(), size - pos));
+    }
+    file->Flush();
+    return file;
+  }
+
+  static bool CheckContent(const std::string &body, uint64_t offset)
+  {
+    for (size_t i = 0; i < body.size(); i++)
+      if ((unsigned char)body[i] != (unsigned char)((offset + i) * 7 >> 3))
+        return false;
+    return true;
+  }
+
+  CWebServer m_server;
+  CTestFileHandler m_handler;
+};
+
+TEST_F(TestWebServerDownload, Range)
+{
+  ASSERT_TRUE(m_server.IsStarted());
+  XFILE::CFile *file = CreateFile(100000);
+  ASSERT_TRUE(file != NULL);
+  std::string url = "/test/" + XBMC_TEMPFILEPATH(file);
+
+  HttpResponse response;
+  ASSERT_TRUE(HttpGet(url, "", response));
+  EXPECT_EQ(MHD_HTTP_OK, response.status);
+  EXPECT_EQ(100000U, response.body.size());
+  EXPECT_TRUE(CheckContent(response.body, 0));
+  EXPECT_NE(std::string::npos, response.headers.find("Accept-Ranges: bytes"));
+
+  ASSERT_TRUE(HttpGet(url, "Range: bytes=1000-1999\r\n", response));
+  EXPECT_EQ(MHD_HTTP_PARTIAL_CONTENT, response.status);
+  EXPECT_EQ(1000U, response.body.size());
+  EXPECT_TRUE(CheckContent(response.body, 1000));
+  EXPECT_NE(std::string::npos, response.headers.find("Content-Range: bytes 1000-1999/100000"));
+
+  ASSERT_TRUE(HttpGet(url, "Range: bytes=-10\r\n", response));
+  EXPECT_EQ(MHD_HTTP_PARTIAL_CONTENT, response.status);
+  EXPECT_TRUE(CheckContent(response.body, 99990));
+
+  ASSERT_TRUE(HttpGet(url, "Range: bytes=200000-\r\n", response));
+  EXPECT_EQ(MHD_HTTP_REQUESTED_RANGE_NOT_SATISFIABLE, response.status);
+  EXPECT_NE(std::string::npos, response.headers.find("Content-Range: bytes */100000"));
+
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(file));
+}
+
+TEST_F(TestWebServerDownload, MultipleRanges)
+{
+  ASSERT_TRUE(m_server.IsStarted());
+  XFILE::CFile *file = CreateFile(100000);
+  ASSERT_TRUE(file != NULL);
+  std::string url = "/test/" + XBMC_TEMPFILEPATH(file);
+
+  HttpResponse response;
+  ASSERT_TRUE(HttpGet(url, "Range: bytes=0-9,50000-50009\r\n", response));
+  EXPECT_EQ(MHD_HTTP_PARTIAL_CONTENT, response.status);
+  ASSERT_NE(std::string::npos, response.headers.find("Content-Type: multipart/byteranges; boundary="));
+
+  /* every part is introduced by its own Content-Range */
+  size_t first = response.body.find("Content-Range: bytes 0-9/100000\r\n\r\n");
+  size_t second = response.body.find("Content-Range: bytes 50000-50009/100000\r\n\r\n");
+  ASSERT_NE(std::string::npos, first);
+  ASSERT_NE(std::string::npos, second);
+  first = response.body.find("\r\n\r\n", first) + 4;
+  second = response.body.find("\r\n\r\n", second) + 4;
+  EXPECT_TRUE(CheckContent(response.body.substr(first, 10), 0));
+  EXPECT_TRUE(CheckContent(response.body.substr(second, 10), 50000));
+  EXPECT_EQ("--\r\n", response.body.substr(response.body.size() - 4));
+
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(file));
+}
+
+TEST_F(TestWebServerDownload, Conditional)
+{
+  ASSERT_TRUE(m_server.IsStarted());
+  XFILE::CFile *file = CreateFile(1000);
+  ASSERT_TRUE(file != NULL);
+  std::string url = "/test/" + XBMC_TEMPFILEPATH(file);
+
+  HttpResponse response;
+  ASSERT_TRUE(HttpGet(url, "", response));
+  size_t pos = response.headers.find("ETag: ");
+  ASSERT_NE(std::string::npos, pos);
+  std::string eTag = response.headers.substr(pos + 6, response.headers.find("\r\n", pos) - pos - 6);
+
+  ASSERT_TRUE(HttpGet(url, "If-None-Match: " + eTag + "\r\n", response));
+  EXPECT_EQ(MHD_HTTP_NOT_MODIFIED, response.status);
+  EXPECT_TRUE(response.body.empty());
+
+  ASSERT_TRUE(HttpGet(url, "If-None-Match: \"other\"\r\n", response));
+  EXPECT_EQ(MHD_HTTP_OK, response.status);
+
+  /* a range for another version of the file gets the whole file */
+  ASSERT_TRUE(HttpGet(url, "Range: bytes=0-9\r\nIf-Range: \"other\"\r\n", response));
+  EXPECT_EQ(MHD_HTTP_OK, response.status);
+  EXPECT_EQ(1000U, response.body.size());
+
+  ASSERT_TRUE(HttpGet(url, "Range: bytes=0-9\r\nIf-Range: " + eTag + "\r\n", response));
+  EXPECT_EQ(MHD_HTTP_PARTIAL_CONTENT, response.status);
+  EXPECT_EQ(10U, response.body.size());
+
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(file));
+}
+
+/* a benchmark, run it with --gtest_also_run_disabled_tests */
+TEST_F(TestWebServerDownload, DISABLED_Performance)
+{
+  ASSERT_TRUE(m_server.IsStarted());
+
+  static const unsigned int sizes[] = { 64 * 1024, 1024 * 1024, 16 * 1024 * 1024 };
+  for (unsigned int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+  {
+    XFILE::CFile *file = CreateFile(sizes[i]);
+    ASSERT_TRUE(file != NULL);
+    std::string url = "/test/" + XBMC_TEMPFILEPATH(file);
+
+    const unsigned int loops = std::max(1U, 64U * 1024 * 1024 / sizes[i]);
+    HttpResponse response;
+    int64_t start = CurrentHostCounter();
+    for (unsigned int loop = 0; loop < loops; loop++)
+    {
+      ASSERT_TRUE(HttpGet(url, "", response));
+      ASSERT_EQ(sizes[i], response.body.size());
+    }
+    double seconds = (CurrentHostCounter() - start) / (double)CurrentHostFrequency();
+
+    std::cout << "Download " << sizes[i] / 1024 << " KB"
+              << " Requests/sec: " << testing::PrintToString(seconds > 0 ? loops / seconds : 0.0)
+              << " MB/sec: " << testing::PrintToString(seconds > 0 ? (double)sizes[i] * loops / seconds / (1024 * 1024) : 0.0) << std::endl;
+
+    EXPECT_TRUE(XBMC_DELETETEMPFILE(file));
+  }
+}
+#endif
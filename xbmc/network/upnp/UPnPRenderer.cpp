@@ -30,7 +30,9 @@ CUPnPRenderer::CUPnPRenderer(const char* friendly_name, bool show_ip /*= false*/
                              const char* uuid /*= NULL*/, unsigned int port /*= 0*/)
     : PLT_MediaRenderer(friendly_name, show_ip, uuid, port)
 {
-    CAnnouncementManager::AddAnnouncer(this);
+    // Announce() reads the playing file and its metadata, which have to be the
+    // ones the announcement is about
+    CAnnouncementManager::AddAnnouncer(this, true);
 }
 
 /*----------------------------------------------------------------------
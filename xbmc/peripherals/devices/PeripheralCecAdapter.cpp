@@ -379,7 +379,8 @@ void CPeripheralCecAdapter::Process(void)
     m_bIsRunning = true;
   }
 
-  CAnnouncementManager::AddAnnouncer(this);
+  // Announce() looks at whether something is playing when the screensaver starts
+  CAnnouncementManager::AddAnnouncer(this, true);
 
   m_queryThread = new CPeripheralCecAdapterUpdateThread(this, &m_configuration);
   m_queryThread->Create(false);
@@ -34,10 +34,19 @@
 #include "DllSwScale.h"
 #include "guilib/JpegIO.h"
 #include "guilib/Texture.h"
+#include "utils/CPUInfo.h"
 #if defined(HAS_OMXPLAYER)
 #include "cores/omxplayer/OMXImage.h"
 #endif
 
+#ifdef __SSE__
+#include <emmintrin.h>
+#endif
+
+#ifdef __ARM_NEON__
+#include <arm_neon.h>
+#endif
+
 using namespace XFILE;
 
 bool CPicture::CreateThumbnailFromSurface(const unsigned char *buffer, int width, int height, int stride, const CStdString &thumbFile)
@@ -90,6 +99,46 @@ bool CPicture::CacheTexture(CBaseTexture *texture, uint32_t &dest_width, uint32_
 }
 
 bool CPicture::CacheTexture(uint8_t *pixels, uint32_t width, uint32_t height, uint32_t pitch, int orientation, uint32_t &dest_width, uint32_t &dest_height, const std::string &dest)
+{
+  if (GetCacheSize(width, height, orientation, dest_width, dest_height))
+  {
+    bool success = false;
+
+    // create a buffer large enough for the resulting image
+    uint32_t *buffer = new uint32_t[dest_width * dest_height];
+    if (buffer)
+    {
+      if (TransformImage(pixels, width, height, pitch, orientation,
+                         (uint8_t *)buffer, dest_width, dest_height, dest_width * 4))
+      {
+        success = CreateThumbnailFromSurface((unsigned char*)buffer, dest_width, dest_height, dest_width * 4, dest);
+      }
+      delete[] buffer;
+    }
+    return success;
+  }
+  else
+  { // no orientation needed
+    return CreateThumbnailFromSurface(pixels, width, height, pitch, dest);
+  }
+  return false;
+}
+
+uint32_t *CPicture::ScaleTexture(CBaseTexture *texture, uint32_t &dest_width, uint32_t &dest_height)
+{
+  GetCacheSize(texture->GetWidth(), texture->GetHeight(), texture->GetOrientation(), dest_width, dest_height);
+
+  uint32_t *buffer = new uint32_t[dest_width * dest_height];
+  if (!TransformImage(texture->GetPixels(), texture->GetWidth(), texture->GetHeight(), texture->GetPitch(), texture->GetOrientation(),
+                      (uint8_t *)buffer, dest_width, dest_height, dest_width * 4))
+  {
+    delete[] buffer;
+    return NULL;
+  }
+  return buffer;
+}
+
+bool CPicture::GetCacheSize(uint32_t width, uint32_t height, int orientation, uint32_t &dest_width, uint32_t &dest_height)
 {
   // if no max width or height is specified, don't resize
   if (dest_width == 0)
@@ -112,34 +161,16 @@ bool CPicture::CacheTexture(uint8_t *pixels, uint32_t width, uint32_t height, ui
 
   if (width > dest_width || height > dest_height || orientation)
   {
-    bool success = false;
-
     dest_width = std::min(width, dest_width);
     dest_height = std::min(height, dest_height);
 
-    // create a buffer large enough for the resulting image
     GetScale(width, height, dest_width, dest_height);
-    uint32_t *buffer = new uint32_t[dest_width * dest_height];
-    if (buffer)
-    {
-      if (ScaleImage(pixels, width, height, pitch,
-                     (uint8_t *)buffer, dest_width, dest_height, dest_width * 4))
-      {
-        if (!orientation || OrientateImage(buffer, dest_width, dest_height, orientation))
-        {
-          success = CreateThumbnailFromSurface((unsigned char*)buffer, dest_width, dest_height, dest_width * 4, dest);
-        }
-      }
-      delete[] buffer;
-    }
-    return success;
-  }
-  else
-  { // no orientation needed
-    dest_width = width;
-    dest_height = height;
-    return CreateThumbnailFromSurface(pixels, width, height, pitch, dest);
+    if (orientation >= 4)
+      std::swap(dest_width, dest_height);
+    return true;
   }
+  dest_width = width;
+  dest_height = height;
   return false;
 }
 
@@ -167,28 +198,15 @@ bool CPicture::CreateTiledThumb(const std::vector<std::string> &files, const std
     if (texture && texture->GetWidth() && texture->GetHeight())
     {
       GetScale(texture->GetWidth(), texture->GetHeight(), width, height);
-
-      // scale appropriately
-      uint32_t *scaled = new uint32_t[width * height];
-      if (ScaleImage(texture->GetPixels(), texture->GetWidth(), texture->GetHeight(), texture->GetPitch(),
-                     (uint8_t *)scaled, width, height, width * 4))
-      {
-        if (!texture->GetOrientation() || OrientateImage(scaled, width, height, texture->GetOrientation()))
-        {
-          // drop into the texture
-          unsigned int posX = x*tile_width + (tile_width - width)/2;
-          unsigned int posY = y*tile_height + (tile_height - height)/2;
-          uint32_t *dest = buffer + posX + posY*g_advancedSettings.GetThumbSize();
-          uint32_t *src = scaled;
-          for (unsigned int y = 0; y < height; ++y)
-          {
-            memcpy(dest, src, width*4);
-            dest += g_advancedSettings.GetThumbSize();
-            src += width;
-          }
-        }
-      }
-      delete[] scaled;
+      if (texture->GetOrientation() >= 4)
+        std::swap(width, height);
+
+      // scale and orientate straight into the tile
+      unsigned int posX = x*tile_width + (tile_width - width)/2;
+      unsigned int posY = y*tile_height + (tile_height - height)/2;
+      uint32_t *dest = buffer + posX + posY*g_advancedSettings.GetThumbSize();
+      TransformImage(texture->GetPixels(), texture->GetWidth(), texture->GetHeight(), texture->GetPitch(), texture->GetOrientation(),
+                     (uint8_t *)dest, width, height, g_advancedSettings.GetThumbSize() * 4);
       delete texture;
     }
   }
@@ -231,173 +249,342 @@ bool CPicture::ScaleImage(uint8_t *in_pixels, unsigned int in_width, unsigned in
   return false;
 }
 
-bool CPicture::OrientateImage(uint32_t *&pixels, unsigned int &width, unsigned int &height, int orientation)
+/*! \brief Box filter along one axis of a downscale
+ Each source pixel covers at most two destination pixels, so it is split between
+ index and index + 1, with weight (out of 256) going to index.
+ */
+class CBoxFilter
 {
-  // ideas for speeding these functions up: http://cgit.freedesktop.org/pixman/tree/pixman/pixman-fast-path.c
-  uint32_t *out = NULL;
-  switch (orientation)
+public:
+  CBoxFilter(unsigned int in_size, unsigned int out_size)
   {
-    case 1:
-      out = FlipHorizontal(pixels, width, height);
-      break;
-    case 2:
-      out = Rotate180CCW(pixels, width, height);
-      break;
-    case 3:
-      out = FlipVertical(pixels, width, height);
-      break;
-    case 4:
-      out = Transpose(pixels, width, height);
-      break;
-    case 5:
-      out = Rotate270CCW(pixels, width, height);
-      break;
-    case 6:
-      out = TransposeOffAxis(pixels, width, height);
-      break;
-    case 7:
-      out = Rotate90CCW(pixels, width, height);
-      break;
-    default:
-      CLog::Log(LOGERROR, "Unknown orientation %i", orientation);
-      break;
-  }
-  if (out)
+    index.resize(in_size);
+    weight.resize(in_size);
+    pairs.resize(in_size * 8);
+    total.assign(out_size, 0);
+    max_total = 0;
+    for (unsigned int x = 0; x < in_size; x++)
+    { // positions are in units of 1/in_size of a destination pixel
+      uint64_t start = (uint64_t)x * out_size;
+      uint64_t boundary = (start / in_size + 1) * in_size;
+      unsigned int d = (unsigned int)(start / in_size);
+      unsigned int w = 256;
+      if (start + out_size > boundary && d + 1 < out_size)
+        w = (unsigned int)(((boundary - start) * 256 + out_size / 2) / out_size);
+      index[x] = d;
+      weight[x] = w;
+      for (unsigned int c = 0; c < 4; c++)
+      {
+        pairs[x * 8 + c] = w;
+        pairs[x * 8 + 4 + c] = 256 - w;
+      }
+      total[d] += w;
+      if (w < 256)
+        total[d + 1] += 256 - w;
+    }
+    for (unsigned int d = 0; d < out_size; d++)
+      max_total = std::max(max_total, total[d]);
+  };
+
+  std::vector<unsigned int> index;
+  std::vector<uint16_t>     weight;
+  std::vector<uint16_t>     pairs;     ///< weight and 256 - weight, each repeated for the 4 channels
+  std::vector<uint32_t>     total;     ///< sum of the weights of each destination pixel
+  uint32_t                  max_total;
+};
+
+/* Reduce a row of source pixels horizontally, into 4 16bit channels per destination pixel */
+typedef void (*ScaleRowFn)(const uint32_t *src, const CBoxFilter &filter, unsigned int shift, uint16_t *dest);
+
+/* Add a row of reduced pixels to the accumulators of the destination rows it covers */
+typedef void (*AccumulateRowFn)(const uint16_t *src, unsigned int count, unsigned int weight, uint32_t *cur, uint32_t *next);
+
+static void ScaleRow(const uint32_t *src, const CBoxFilter &filter, unsigned int shift, uint16_t *dest)
+{
+  uint32_t cur[4] = { 0, 0, 0, 0 }, next[4] = { 0, 0, 0, 0 };
+  unsigned int d = 0;
+  for (unsigned int x = 0; x < filter.index.size(); x++)
   {
-    pixels = out;
-    std::swap(width, height);
-    return true;
+    if (filter.index[x] != d)
+    {
+      for (unsigned int c = 0; c < 4; c++)
+      {
+        dest[d * 4 + c] = cur[c] >> shift;
+        cur[c] = next[c];
+        next[c] = 0;
+      }
+      d = filter.index[x];
+    }
+    const uint8_t *pixel = (const uint8_t *)(src + x);
+    unsigned int w = filter.weight[x];
+    for (unsigned int c = 0; c < 4; c++)
+    {
+      cur[c] += pixel[c] * w;
+      next[c] += pixel[c] * (256 - w);
+    }
   }
-  return false;
+  for (unsigned int c = 0; c < 4; c++)
+    dest[d * 4 + c] = cur[c] >> shift;
 }
 
-uint32_t *CPicture::FlipHorizontal(uint32_t *pixels, unsigned int width, unsigned int height)
+static void AccumulateRow(const uint16_t *src, unsigned int count, unsigned int weight, uint32_t *cur, uint32_t *next)
 {
-  // this can be done in-place easily enough
-  for (unsigned int y = 0; y < height; ++y)
+  for (unsigned int i = 0; i < count; i++)
+    cur[i] += src[i] * weight;
+  if (weight < 256)
   {
-    uint32_t *line = pixels + y * width;
-    for (unsigned int x = 0; x < width / 2; ++x)
-      std::swap(line[x], line[width - 1 - x]);
+    for (unsigned int i = 0; i < count; i++)
+      next[i] += src[i] * (256 - weight);
   }
-  return NULL;
 }
 
-uint32_t *CPicture::FlipVertical(uint32_t *pixels, unsigned int width, unsigned int height)
+#ifdef __SSE__
+static void ScaleRowSSE2(const uint32_t *src, const CBoxFilter &filter, unsigned int shift, uint16_t *dest)
 {
-  // this can be done in-place easily enough
-  for (unsigned int y = 0; y < height / 2; ++y)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i count = _mm_cvtsi32_si128(shift);
+  __m128i cur = zero, next = zero;
+  unsigned int d = 0;
+  for (unsigned int x = 0; x < filter.index.size(); x++)
   {
-    uint32_t *line1 = pixels + y * width;
-    uint32_t *line2 = pixels + (height - 1 - y) * width;
-    for (unsigned int x = 0; x < width; ++x)
-      std::swap(*line1++, *line2++);
+    if (filter.index[x] != d)
+    { // values are shifted to fit 15 bits, so the signed pack doesn't saturate
+      __m128i value = _mm_srl_epi32(cur, count);
+      _mm_storel_epi64((__m128i *)(dest + d * 4), _mm_packs_epi32(value, value));
+      cur = next;
+      next = zero;
+      d = filter.index[x];
+    }
+    __m128i pixel = _mm_unpacklo_epi8(_mm_cvtsi32_si128(src[x]), zero);
+    __m128i product = _mm_mullo_epi16(_mm_unpacklo_epi64(pixel, pixel),
+                                      _mm_loadu_si128((const __m128i *)&filter.pairs[x * 8]));
+    cur = _mm_add_epi32(cur, _mm_unpacklo_epi16(product, zero));
+    next = _mm_add_epi32(next, _mm_unpackhi_epi16(product, zero));
   }
-  return NULL;
+  __m128i value = _mm_srl_epi32(cur, count);
+  _mm_storel_epi64((__m128i *)(dest + d * 4), _mm_packs_epi32(value, value));
 }
 
-uint32_t *CPicture::Rotate180CCW(uint32_t *pixels, unsigned int width, unsigned int height)
+static inline void AccumulateSSE2(const uint16_t *src, unsigned int count, __m128i weight, uint32_t *acc)
 {
-  // this can be done in-place easily enough
-  for (unsigned int y = 0; y < height / 2; ++y)
-  {
-    uint32_t *line1 = pixels + y * width;
-    uint32_t *line2 = pixels + (height - 1 - y) * width + width - 1;
-    for (unsigned int x = 0; x < width; ++x)
-      std::swap(*line1++, *line2--);
-  }
-  if (height % 2)
-  { // height is odd, so flip the middle row as well
-    uint32_t *line = pixels + (height - 1)/2 * width;
-    for (unsigned int x = 0; x < width / 2; ++x)
-      std::swap(line[x], line[width - 1 - x]);
+  unsigned int i = 0;
+  for (; i + 8 <= count; i += 8)
+  { // 16x16 bit products, combined from their low and high halves
+    __m128i values = _mm_loadu_si128((const __m128i *)(src + i));
+    __m128i lo = _mm_mullo_epi16(values, weight);
+    __m128i hi = _mm_mulhi_epu16(values, weight);
+    __m128i *a = (__m128i *)(acc + i);
+    _mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a), _mm_unpacklo_epi16(lo, hi)));
+    _mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1), _mm_unpackhi_epi16(lo, hi)));
   }
-  return NULL;
+  unsigned int w = _mm_cvtsi128_si32(weight) & 0xffff;
+  for (; i < count; i++)
+    acc[i] += src[i] * w;
+}
+
+static void AccumulateRowSSE2(const uint16_t *src, unsigned int count, unsigned int weight, uint32_t *cur, uint32_t *next)
+{
+  AccumulateSSE2(src, count, _mm_set1_epi16(weight), cur);
+  if (weight < 256)
+    AccumulateSSE2(src, count, _mm_set1_epi16(256 - weight), next);
 }
+#endif
 
-uint32_t *CPicture::Rotate90CCW(uint32_t *pixels, unsigned int width, unsigned int height)
+#if defined(__ARM_NEON__)
+static void ScaleRowNEON(const uint32_t *src, const CBoxFilter &filter, unsigned int shift, uint16_t *dest)
 {
-  uint32_t *dest = new uint32_t[width * height * 4];
-  if (dest)
+  const int32x4_t count = vdupq_n_s32(-(int)shift);
+  uint32x4_t cur = vdupq_n_u32(0), next = vdupq_n_u32(0);
+  unsigned int d = 0;
+  for (unsigned int x = 0; x < filter.index.size(); x++)
   {
-    unsigned int d_height = width, d_width = height;
-    for (unsigned int y = 0; y < d_height; y++)
+    if (filter.index[x] != d)
     {
-      const uint32_t *src = pixels + (d_height - 1 - y); // y-th col from right, starting at top
-      uint32_t *dst = dest + d_width * y;                // y-th row from top, starting at left
-      for (unsigned int x = 0; x < d_width; x++)
-      {
-        *dst++ = *src;
-        src += width;
-      }
+      vst1_u16(dest + d * 4, vmovn_u32(vshlq_u32(cur, count)));
+      cur = next;
+      next = vdupq_n_u32(0);
+      d = filter.index[x];
     }
+    uint16x4_t pixel = vget_low_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(src[x]))));
+    uint16_t w = filter.weight[x];
+    cur = vmlal_n_u16(cur, pixel, w);
+    next = vmlal_n_u16(next, pixel, 256 - w);
   }
-  delete[] pixels;
-  return dest;
+  vst1_u16(dest + d * 4, vmovn_u32(vshlq_u32(cur, count)));
 }
 
-uint32_t *CPicture::Rotate270CCW(uint32_t *pixels, unsigned int width, unsigned int height)
+static void AccumulateRowNEON(const uint16_t *src, unsigned int count, unsigned int weight, uint32_t *cur, uint32_t *next)
 {
-  uint32_t *dest = new uint32_t[width * height * 4];
-  if (!dest)
-    return NULL;
-
-  unsigned int d_height = width, d_width = height;
-  for (unsigned int y = 0; y < d_height; y++)
+  // count is always a multiple of 4 (one lane per channel)
+  for (unsigned int i = 0; i < count; i += 4)
+    vst1q_u32(cur + i, vmlal_n_u16(vld1q_u32(cur + i), vld1_u16(src + i), weight));
+  if (weight < 256)
   {
-    const uint32_t *src = pixels + width * (d_width - 1) + y; // y-th col from left, starting at bottom
-    uint32_t *dst = dest + d_width * y;                       // y-th row from top, starting at left
-    for (unsigned int x = 0; x < d_width; x++)
-    {
-      *dst++ = *src;
-      src -= width;
-    }
+    for (unsigned int i = 0; i < count; i += 4)
+      vst1q_u32(next + i, vmlal_n_u16(vld1q_u32(next + i), vld1_u16(src + i), 256 - weight));
   }
-
-  delete[] pixels;
-  return dest;
 }
+#endif
 
-uint32_t *CPicture::Transpose(uint32_t *pixels, unsigned int width, unsigned int height)
+/* Normalize a row of accumulated pixels */
+static void FinishRow(const uint32_t *acc, unsigned int width, const float *scale_x, float scale_y, uint32_t *out)
 {
-  uint32_t *dest = new uint32_t[width * height * 4];
-  if (!dest)
-    return NULL;
+  for (unsigned int x = 0; x < width; x++)
+  {
+    uint8_t *pixel = (uint8_t *)(out + x);
+    float scale = scale_x[x] * scale_y;
+    for (unsigned int c = 0; c < 4; c++)
+      pixel[c] = (uint8_t)std::min(255.0f, acc[x * 4 + c] * scale + 0.5f);
+  }
+}
 
-  unsigned int d_height = width, d_width = height;
-  for (unsigned int y = 0; y < d_height; y++)
+/* Write a block of finished rows into the orientated output. For orientations
+   that transpose the image, a row ends up as a column, so the block is written
+   a column at a time to fill whole cache lines of the output. */
+static void WriteBlock(const uint32_t *block, unsigned int width, unsigned int rows,
+                       uint8_t *origin, ptrdiff_t xstep, ptrdiff_t ystep, bool transpose)
+{
+  if (!transpose)
   {
-    const uint32_t *src = pixels + y;   // y-th col from left, starting at top
-    uint32_t *dst = dest + d_width * y; // y-th row from top, starting at left
-    for (unsigned int x = 0; x < d_width; x++)
+    for (unsigned int y = 0; y < rows; y++)
     {
-      *dst++ = *src;
-      src += width;
+      uint8_t *dest = origin + y * ystep;
+      const uint32_t *src = block + y * width;
+      for (unsigned int x = 0; x < width; x++, dest += xstep)
+        *(uint32_t *)dest = *src++;
+    }
+  }
+  else
+  {
+    for (unsigned int x = 0; x < width; x++)
+    {
+      uint8_t *dest = origin + x * xstep;
+      const uint32_t *src = block + x;
+      for (unsigned int y = 0; y < rows; y++, dest += ystep)
+        *(uint32_t *)dest = src[y * width];
     }
   }
-
-  delete[] pixels;
-  return dest;
 }
 
-uint32_t *CPicture::TransposeOffAxis(uint32_t *pixels, unsigned int width, unsigned int height)
+bool CPicture::TransformImage(const uint8_t *in_pixels, unsigned int in_width, unsigned int in_height, unsigned int in_pitch, int orientation,
+                              uint8_t *out_pixels, unsigned int out_width, unsigned int out_height, unsigned int out_pitch)
 {
-  uint32_t *dest = new uint32_t[width * height * 4];
-  if (!dest)
-    return NULL;
+  static const unsigned int block_rows = 16;
+  if (orientation < 0 || orientation > 7)
+  {
+    CLog::Log(LOGERROR, "Unknown orientation %i", orientation);
+    return false;
+  }
+  if (!in_width || !in_height || !out_width || !out_height)
+    return false;
+
+  // size of the scaled image before it is orientated
+  bool transpose = orientation >= 4;
+  unsigned int width = transpose ? out_height : out_width;
+  unsigned int height = transpose ? out_width : out_height;
+
+  if (width > in_width || height > in_height || in_height / height >= 500)
+  { // not a downscale the box filter handles (or one that would overflow it), so scale with swscale first
+    uint32_t *scaled = new uint32_t[width * height];
+    bool success = ScaleImage((uint8_t *)in_pixels, in_width, in_height, in_pitch, (uint8_t *)scaled, width, height, width * 4) &&
+                   TransformImage((uint8_t *)scaled, width, height, width * 4, orientation, out_pixels, out_width, out_height, out_pitch);
+    delete[] scaled;
+    return success;
+  }
+
+  ScaleRowFn scaleRow = ScaleRow;
+  AccumulateRowFn accumulateRow = AccumulateRow;
+#ifdef __SSE__
+  if (g_cpuInfo.GetCPUFeatures() & CPU_FEATURE_SSE2)
+  {
+    scaleRow = ScaleRowSSE2;
+    accumulateRow = AccumulateRowSSE2;
+  }
+#endif
+#if defined(__ARM_NEON__)
+  if ((g_cpuInfo.GetCPUFeatures() & CPU_FEATURE_NEON) == CPU_FEATURE_NEON)
+  {
+    scaleRow = ScaleRowNEON;
+    accumulateRow = AccumulateRowNEON;
+  }
+#endif
 
-  unsigned int d_height = width, d_width = height;
-  for (unsigned int y = 0; y < d_height; y++)
+  CBoxFilter filter_x(in_width, width);
+  CBoxFilter filter_y(in_height, height);
+
+  // horizontally reduced values are kept to 15 bits so that the rows of a destination pixel fit in 32 bits
+  unsigned int shift = 0;
+  while ((filter_x.max_total * 255) >> shift > 32767)
+    shift++;
+  std::vector<float> scale_x(width);
+  for (unsigned int x = 0; x < width; x++)
+    scale_x[x] = (float)(1 << shift) / filter_x.total[x];
+
+  // where the scaled pixel (x, y) ends up in the output is origin + x*xstep + y*ystep
+  ptrdiff_t pitch = out_pitch;
+  ptrdiff_t xstep = 4, ystep = pitch;
+  uint8_t *origin = out_pixels;
+  switch (orientation)
   {
-    const uint32_t *src = pixels + width * (d_width - 1) + (d_height - 1 - y); // y-th col from right, starting at bottom
-    uint32_t *dst = dest + d_width * y;                                        // y-th row, starting at left
-    for (unsigned int x = 0; x < d_width; x++)
+    case 1: // flip horizontally
+      origin += (width - 1) * 4;
+      xstep = -4;
+      break;
+    case 2: // rotate 180
+      origin += (width - 1) * 4 + (height - 1) * pitch;
+      xstep = -4;
+      ystep = -pitch;
+      break;
+    case 3: // flip vertically
+      origin += (height - 1) * pitch;
+      ystep = -pitch;
+      break;
+    case 4: // transpose
+      xstep = pitch;
+      ystep = 4;
+      break;
+    case 5: // rotate 270 CCW
+      origin += (height - 1) * 4;
+      xstep = pitch;
+      ystep = -4;
+      break;
+    case 6: // transpose off axis
+      origin += (height - 1) * 4 + (width - 1) * pitch;
+      xstep = -pitch;
+      ystep = -4;
+      break;
+    case 7: // rotate 90 CCW
+      origin += (width - 1) * pitch;
+      xstep = -pitch;
+      ystep = 4;
+      break;
+  }
+
+  std::vector<uint16_t> row(width * 4);
+  std::vector<uint32_t> acc(width * 8, 0);
+  std::vector<uint32_t> block(width * block_rows);
+  uint32_t *cur = &acc[0], *next = &acc[width * 4];
+  unsigned int dest_y = 0, rows = 0;
+
+  for (unsigned int y = 0; y < in_height; y++)
+  {
+    if (filter_y.index[y] != dest_y)
     {
-      *dst++ = *src;
-      src -= width;
+      FinishRow(cur, width, &scale_x[0], 1.0f / filter_y.total[dest_y], &block[rows * width]);
+      memset(cur, 0, width * 4 * sizeof(uint32_t));
+      std::swap(cur, next);
+      if (++rows == block_rows)
+      {
+        WriteBlock(&block[0], width, rows, origin + (dest_y + 1 - rows) * ystep, xstep, ystep, transpose);
+        rows = 0;
+      }
+      dest_y = filter_y.index[y];
     }
+    scaleRow((const uint32_t *)(in_pixels + y * in_pitch), filter_x, shift, &row[0]);
+    accumulateRow(&row[0], width * 4, filter_y.weight[y], cur, next);
   }
-
-  delete[] pixels;
-  return dest;
+  FinishRow(cur, width, &scale_x[0], 1.0f / filter_y.total[dest_y], &block[rows * width]);
+  rows++;
+  WriteBlock(&block[0], width, rows, origin + (dest_y + 1 - rows) * ystep, xstep, ystep, transpose);
+  return true;
 }
@@ -44,19 +44,42 @@ public:
   static bool CacheTexture(CBaseTexture *texture, uint32_t &dest_width, uint32_t &dest_height, const std::string &dest);
   static bool CacheTexture(uint8_t *pixels, uint32_t width, uint32_t height, uint32_t pitch, int orientation, uint32_t &dest_width, uint32_t &dest_height, const std::string &dest);
 
+  /*! \brief Resize, rotate and flip a texture as CacheTexture does, without saving it
+   Allows the scaling and the encoding of a cached texture to be done separately.
+   \param texture a pointer to a CBaseTexture
+   \param dest_width [in/out] maximum width in pixels of cached version - replaced with actual cached width
+   \param dest_height [in/out] maximum height in pixels of cached version - replaced with actual cached height
+   \return the resulting BGRA image with a pitch of dest_width * 4, to be delete[]'d by the caller. NULL if unsuccessful.
+   \sa CacheTexture, CreateThumbnailFromSurface
+   */
+  static uint32_t *ScaleTexture(CBaseTexture *texture, uint32_t &dest_width, uint32_t &dest_height);
+
+  /*! \brief Scale and orientate an image in one pass
+   Downscales are done with a box filter, reading the source once and writing each
+   destination pixel once, straight into its orientated position. Upscales go
+   through swscale first.
+   \param in_pixels the BGRA source image
+   \param in_width width of the source image
+   \param in_height height of the source image
+   \param in_pitch pitch of the source image in bytes
+   \param orientation orientation to apply: 0 for none, 1-7 for EXIF orientations 2-8
+   \param out_pixels buffer for the BGRA result
+   \param out_width width of the result, after orientation
+   \param out_height height of the result, after orientation
+   \param out_pitch pitch of the result in bytes
+   \return true if successful, false otherwise
+   */
+  static bool TransformImage(const uint8_t *in_pixels, unsigned int in_width, unsigned int in_height, unsigned int in_pitch, int orientation,
+                             uint8_t *out_pixels, unsigned int out_width, unsigned int out_height, unsigned int out_pitch);
+
 private:
+  /*! \brief Work out the size a texture is cached at
+   \return true if the texture needs to be scaled or orientated, false if it can be cached as is.
+   */
+  static bool GetCacheSize(uint32_t width, uint32_t height, int orientation, uint32_t &dest_width, uint32_t &dest_height);
   static void GetScale(unsigned int width, unsigned int height, unsigned int &out_width, unsigned int &out_height);
   static bool ScaleImage(uint8_t *in_pixels, unsigned int in_width, unsigned int in_height, unsigned int in_pitch,
                          uint8_t *out_pixels, unsigned int out_width, unsigned int out_height, unsigned int out_pitch);
-  static bool OrientateImage(uint32_t *&pixels, unsigned int &width, unsigned int &height, int orientation);
-
-  static uint32_t *FlipHorizontal(uint32_t *pixels, unsigned int width, unsigned int height);
-  static uint32_t *FlipVertical(uint32_t *pixels, unsigned int width, unsigned int height);
-  static uint32_t *Rotate90CCW(uint32_t *pixels, unsigned int width, unsigned int height);
-  static uint32_t *Rotate270CCW(uint32_t *pixels, unsigned int width, unsigned int height);
-  static uint32_t *Rotate180CCW(uint32_t *pixels, unsigned int width, unsigned int height);
-  static uint32_t *Transpose(uint32_t *pixels, unsigned int width, unsigned int height);
-  static uint32_t *TransposeOffAxis(uint32_t *pixels, unsigned int width, unsigned int height);
 };
 
 //this class calls CreateThumbnailFromSurface in a CJob, so a png file can be written without halting the render thread
@@ -0,0 +1,124 @@
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "pictures/Picture.h"
+#include "utils/TimeUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <stdlib.h>
+#include <vector>
+
+/* where the pixel (x, y) of a width x height image ends up for each orientation */
+static void GetOrientatedPosition(int orientation, unsigned int x, unsigned int y, unsigned int width, unsigned int height,
+                                  unsigned int &out_x, unsigned int &out_y)
+{
+  switch (orientation)
+  {
+    case 0: out_x = x;              out_y = y;              break;
+    case 1: out_x = width - 1 - x;  out_y = y;              break;
+    case 2: out_x = width - 1 - x;  out_y = height - 1 - y; break;
+    case 3: out_x = x;              out_y = height - 1 - y; break;
+    case 4: out_x = y;              out_y = x;              break;
+    case 5: out_x = height - 1 - y; out_y = x;              break;
+    case 6: out_x = height - 1 - y; out_y = width - 1 - x;  break;
+    case 7: out_x = y;              out_y = width - 1 - x;  break;
+  }
+}
+
+TEST(TestPicture, TransformOrientation)
+{
+  /* odd sizes, so that the row blocks and vector loops all have remainders */
+  const unsigned int width = 37, height = 23;
+  std::vector<uint32_t> in(width * height);
+  for (unsigned int i = 0; i < in.size(); i++)
+    in[i] = (uint32_t)rand();
+
+  for (int orientation = 0; orientation < 8; orientation++)
+  {
+    unsigned int out_width = orientation >= 4 ? height : width;
+    unsigned int out_height = orientation >= 4 ? width : height;
+    std::vector<uint32_t> out(out_width * out_height);
+    ASSERT_TRUE(CPicture::TransformImage((uint8_t *)&in[0], width, height, width * 4, orientation,
+                                         (uint8_t *)&out[0], out_width, out_height, out_width * 4));
+    for (unsigned int y = 0; y < height; y++)
+    {
+      for (unsigned int x = 0; x < width; x++)
+      {
+        unsigned int out_x, out_y;
+        GetOrientatedPosition(orientation, x, y, width, height, out_x, out_y);
+        ASSERT_EQ(in[y * width + x], out[out_y * out_width + out_x]) << "orientation " << orientation;
+      }
+    }
+  }
+}
+
+TEST(TestPicture, TransformUniform)
+{
+  /* a ratio that splits source pixels between destination pixels shouldn't change a flat colour */
+  std::vector<uint32_t> in(1000 * 700, 0x80c0ff10);
+  std::vector<uint32_t> out(333 * 211);
+  ASSERT_TRUE(CPicture::TransformImage((uint8_t *)&in[0], 1000, 700, 1000 * 4, 0,
+                                       (uint8_t *)&out[0], 333, 211, 333 * 4));
+  for (unsigned int i = 0; i < out.size(); i++)
+    ASSERT_EQ(0x80c0ff10u, out[i]) << "pixel " << i;
+}
+
+TEST(TestPicture, TransformAverage)
+{
+  /* halving each dimension averages each 2x2 block */
+  const unsigned int width = 8, height = 6;
+  std::vector<uint32_t> in(width * height);
+  for (unsigned int y = 0; y < height; y++)
+  {
+    for (unsigned int x = 0; x < width; x++)
+    {
+      unsigned int value = (x / 2) * 40 + (y / 2) * 10 + x % 2 + y % 2;
+      in[y * width + x] = value * 0x01010101u;
+    }
+  }
+
+  std::vector<uint32_t> out(width / 2 * height / 2);
+  ASSERT_TRUE(CPicture::TransformImage((uint8_t *)&in[0], width, height, width * 4, 0,
+                                       (uint8_t *)&out[0], width / 2, height / 2, width / 2 * 4));
+  for (unsigned int y = 0; y < height / 2; y++)
+  {
+    for (unsigned int x = 0; x < width / 2; x++)
+      EXPECT_EQ((x * 40 + y * 10 + 1) * 0x01010101u, out[y * width / 2 + x]);
+  }
+}
+
+/* a benchmark, run it with --gtest_also_run_disabled_tests */
+TEST(TestPicture, DISABLED_TransformPerformance)
+{
+  /* a 24 megapixel photo taken in portrait, down to a thumbnail */
+  const unsigned int width = 6000, height = 4000;
+  std::vector<uint32_t> in(width * height);
+  for (unsigned int i = 0; i < in.size(); i++)
+    in[i] = i * 2654435761u;
+
+  std::vector<uint32_t> out(213 * 320);
+  int64_t start = CurrentHostCounter();
+  ASSERT_TRUE(CPicture::TransformImage((uint8_t *)&in[0], width, height, width * 4, 7,
+                                       (uint8_t *)&out[0], 213, 320, 213 * 4));
+  double ms = 1000.0 * (CurrentHostCounter() - start) / CurrentHostFrequency();
+
+  std::cout << "Transform 6000x4000 to 213x320: " << testing::PrintToString(ms) << "ms" << std::endl;
+}
@@ -374,7 +374,7 @@ int CPVRDatabase::Get(CPVRChannelGroupInternal &results)
         CLog::Log(LOGDEBUG, "PVR - %s - channel '%s' loaded from the database", __FUNCTION__, channel->m_strChannelName.c_str());
 #endif
         PVRChannelGroupMember newMember = { channel, m_pDS->fv("iChannelNumber").get_asInt() };
-        results.m_members.push_back(newMember);
+        results.AddMember(newMember);
 
         m_pDS->next();
         ++iReturn;
@@ -718,7 +718,7 @@ int CPVRDatabase::Get(CPVRChannelGroup &group)
           CLog::Log(LOGDEBUG, "PVR - %s - channel '%s' loaded from the database", __FUNCTION__, channel->m_strChannelName.c_str());
 #endif
           PVRChannelGroupMember newMember = { channel, iChannelNumber };
-          group.m_members.push_back(newMember);
+          group.AddMember(newMember);
           iReturn++;
         }
         else
@@ -26,6 +26,7 @@
 #include "settings/GUISettings.h"
 #include "utils/StringUtils.h"
 #include "threads/SingleLock.h"
+#include "threads/Atomics.h"
 
 #include "PVRChannelGroupsContainer.h"
 #include "epg/EpgContainer.h"
@@ -37,6 +38,8 @@
 using namespace PVR;
 using namespace EPG;
 
+volatile long CPVRChannel::m_iIdGeneration = 0;
+
 bool CPVRChannel::operator==(const CPVRChannel &right) const
 {
   return (m_bIsRadio  == right.m_bIsRadio &&
@@ -110,13 +113,17 @@ CPVRChannel::CPVRChannel(const PVR_CHANNEL &channel, unsigned int iClientId)
   UpdateEncryptionName();
 }
 
-CPVRChannel::CPVRChannel(const CPVRChannel &channel)
+CPVRChannel::CPVRChannel(const CPVRChannel &channel) :
+    m_iUniqueId(channel.m_iUniqueId),
+    m_iClientId(channel.m_iClientId)
 {
+  // a new channel isn't indexed by any group yet, so this doesn't count as an ID change
   *this = channel;
 }
 
 CPVRChannel &CPVRChannel::operator=(const CPVRChannel &channel)
 {
+  bool bIdsChanged = m_iUniqueId != channel.m_iUniqueId || m_iClientId != channel.m_iClientId;
   m_iChannelId              = channel.m_iChannelId;
   m_bIsRadio                = channel.m_bIsRadio;
   m_bIsHidden               = channel.m_bIsHidden;
@@ -130,6 +137,8 @@ CPVRChannel &CPVRChannel::operator=(const CPVRChannel &channel)
   m_strEPGScraper           = channel.m_strEPGScraper;
   m_iUniqueId               = channel.m_iUniqueId;
   m_iClientId               = channel.m_iClientId;
+  if (bIdsChanged)
+    AtomicIncrement(&m_iIdGeneration);
   m_iClientChannelNumber    = channel.m_iClientChannelNumber;
   m_strClientChannelName    = channel.m_strClientChannelName;
   m_strInputFormat          = channel.m_strInputFormat;
@@ -401,6 +410,7 @@ bool CPVRChannel::SetUniqueID(int iUniqueId)
   {
     /* update the unique ID */
     m_iUniqueId = iUniqueId;
+    AtomicIncrement(&m_iIdGeneration);
     SetChanged();
     m_bChanged = true;
 
@@ -418,6 +428,7 @@ bool CPVRChannel::SetClientID(int iClientId)
   {
     /* update the client ID */
     m_iClientId = iClientId;
+    AtomicIncrement(&m_iIdGeneration);
     SetChanged();
     m_bChanged = true;
 
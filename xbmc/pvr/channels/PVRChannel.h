@@ -242,6 +242,11 @@ namespace PVR
      */
     bool SetClientID(int iClientId);
 
+    /*!
+     * @return A counter that goes up whenever the unique or client ID of any channel changes.
+     */
+    static long IdGeneration(void) { return m_iIdGeneration; }
+
     /*!
      * @return The channel number on the client.
      */
@@ -458,6 +463,8 @@ namespace PVR
      */
     void UpdateEncryptionName(void);
 
+    static volatile long m_iIdGeneration;      /*!< see IdGeneration() */
+
     /*! @name XBMC related channel data
      */
     //@{
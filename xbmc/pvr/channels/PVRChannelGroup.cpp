@@ -47,7 +47,11 @@ CPVRChannelGroup::CPVRChannelGroup(void) :
     m_iGroupId(-1),
     m_bLoaded(false),
     m_bChanged(false),
-    m_bUsingBackendChannelOrder(false)
+    m_bUsingBackendChannelOrder(false),
+    m_bIndexDirty(true),
+    m_bChannelNumbersDirty(true),
+    m_bMissingChannelIds(false),
+    m_iIdGeneration(0)
 {
 }
 
@@ -58,7 +62,11 @@ CPVRChannelGroup::CPVRChannelGroup(bool bRadio, unsigned int iGroupId, const CSt
     m_strGroupName(strGroupName),
     m_bLoaded(false),
     m_bChanged(false),
-    m_bUsingBackendChannelOrder(false)
+    m_bUsingBackendChannelOrder(false),
+    m_bIndexDirty(true),
+    m_bChannelNumbersDirty(true),
+    m_bMissingChannelIds(false),
+    m_iIdGeneration(0)
 {
 }
 
@@ -69,7 +77,11 @@ CPVRChannelGroup::CPVRChannelGroup(const PVR_CHANNEL_GROUP &group) :
     m_strGroupName(group.strGroupName),
     m_bLoaded(false),
     m_bChanged(false),
-    m_bUsingBackendChannelOrder(false)
+    m_bUsingBackendChannelOrder(false),
+    m_bIndexDirty(true),
+    m_bChannelNumbersDirty(true),
+    m_bMissingChannelIds(false),
+    m_iIdGeneration(0)
 {
 }
 
@@ -101,6 +113,10 @@ CPVRChannelGroup::CPVRChannelGroup(const CPVRChannelGroup &group)
   m_bChanged                    = group.m_bChanged;
   m_bUsingBackendChannelOrder   = group.m_bUsingBackendChannelOrder;
   m_bUsingBackendChannelNumbers = group.m_bUsingBackendChannelNumbers;
+  m_bIndexDirty                 = true;
+  m_bChannelNumbersDirty        = true;
+  m_bMissingChannelIds          = false;
+  m_iIdGeneration               = 0;
 
   for (int iPtr = 0; iPtr < group.Size(); iPtr++)
     m_members.push_back(group.m_members.at(iPtr));
@@ -139,6 +155,7 @@ void CPVRChannelGroup::Unload(void)
   CSingleLock lock(m_critSection);
   g_guiSettings.UnregisterObserver(this);
   m_members.clear();
+  InvalidateIndex();
 }
 
 bool CPVRChannelGroup::Update(void)
@@ -167,6 +184,7 @@ bool CPVRChannelGroup::SetChannelNumber(const CPVRChannel &channel, unsigned int
         m_bChanged = true;
         bReturn = true;
         m_members.at(iChannelPtr).iChannelNumber = iChannelNumber;
+        m_bChannelNumbersDirty = true;
       }
       break;
     }
@@ -296,14 +314,11 @@ void CPVRChannelGroup::SortByChannelNumber(void)
 CPVRChannelPtr CPVRChannelGroup::GetByClient(int iUniqueChannelId, int iClientID) const
 {
   CSingleLock lock(m_critSection);
+  UpdateIndex(false);
 
-  for (unsigned int ptr = 0; ptr < m_members.size(); ptr++)
-  {
-    PVRChannelGroupMember groupMember = m_members.at(ptr);
-    if (groupMember.channel->UniqueID() == iUniqueChannelId &&
-        groupMember.channel->ClientID() == iClientID)
-      return groupMember.channel;
-  }
+  PVRClientChannelIndex::const_iterator it = m_clientIndex.find(std::make_pair(iClientID, iUniqueChannelId));
+  if (it != m_clientIndex.end())
+    return it->second;
 
   CPVRChannelPtr empty;
   return empty;
@@ -313,13 +328,33 @@ CPVRChannelPtr CPVRChannelGroup::GetByChannelID(int iChannelID) const
 {
   CSingleLock lock(m_critSection);
 
-  for (unsigned int ptr = 0; ptr < m_members.size(); ptr++)
+  /* channels that weren't persisted yet all share an invalid ID */
+  if (iChannelID <= 0)
   {
-    PVRChannelGroupMember groupMember = m_members.at(ptr);
-    if (groupMember.channel->ChannelID() == iChannelID)
-      return groupMember.channel;
+    for (unsigned int ptr = 0; ptr < m_members.size(); ptr++)
+    {
+      PVRChannelGroupMember groupMember = m_members.at(ptr);
+      if (groupMember.channel->ChannelID() == iChannelID)
+        return groupMember.channel;
+    }
+
+    CPVRChannelPtr empty;
+    return empty;
   }
 
+  UpdateIndex(false);
+  PVRChannelIdIndex::const_iterator it = m_channelIdIndex.find(iChannelID);
+  if ((it == m_channelIdIndex.end() && m_bMissingChannelIds) ||
+      (it != m_channelIdIndex.end() && it->second->ChannelID() != iChannelID))
+  {
+    /* channels got their ID when they were persisted */
+    BuildIndex();
+    it = m_channelIdIndex.find(iChannelID);
+  }
+
+  if (it != m_channelIdIndex.end())
+    return it->second;
+
   CPVRChannelPtr empty;
   return empty;
 }
@@ -342,13 +377,11 @@ CPVRChannelPtr CPVRChannelGroup::GetByChannelEpgID(int iEpgID) const
 CPVRChannelPtr CPVRChannelGroup::GetByUniqueID(int iUniqueID) const
 {
   CSingleLock lock(m_critSection);
+  UpdateIndex(false);
 
-  for (unsigned int ptr = 0; ptr < m_members.size(); ptr++)
-  {
-    PVRChannelGroupMember groupMember = m_members.at(ptr);
-    if (groupMember.channel->UniqueID() == iUniqueID)
-      return groupMember.channel;
-  }
+  PVRChannelIdIndex::const_iterator it = m_uniqueIdIndex.find(iUniqueID);
+  if (it != m_uniqueIdIndex.end())
+    return it->second;
 
   CPVRChannelPtr empty;
   return empty;
@@ -400,33 +433,47 @@ unsigned int CPVRChannelGroup::GetChannelNumber(const CPVRChannel &channel) cons
 {
   unsigned int iReturn = 0;
   CSingleLock lock(m_critSection);
-  unsigned int iSize = m_members.size();
 
-  for (unsigned int iChannelPtr = 0; iChannelPtr < iSize; iChannelPtr++)
+  if (channel.ChannelID() <= 0)
   {
-    PVRChannelGroupMember member = m_members.at(iChannelPtr);
-    if (member.channel->ChannelID() == channel.ChannelID())
+    unsigned int iSize = m_members.size();
+    for (unsigned int iChannelPtr = 0; iChannelPtr < iSize; iChannelPtr++)
     {
-      iReturn = member.iChannelNumber;
-      break;
+      PVRChannelGroupMember member = m_members.at(iChannelPtr);
+      if (member.channel->ChannelID() == channel.ChannelID())
+      {
+        iReturn = member.iChannelNumber;
+        break;
+      }
     }
+
+    return iReturn;
+  }
+
+  UpdateIndex(true);
+  PVRChannelNumberByIdIndex::const_iterator it = m_channelNumbers.find(channel.ChannelID());
+  if (it == m_channelNumbers.end() && m_bMissingChannelIds)
+  {
+    BuildIndex();
+    it = m_channelNumbers.find(channel.ChannelID());
   }
 
+  if (it != m_channelNumbers.end())
+    iReturn = it->second;
+
   return iReturn;
 }
 
 CFileItemPtr CPVRChannelGroup::GetByChannelNumber(unsigned int iChannelNumber) const
 {
   CSingleLock lock(m_critSection);
+  UpdateIndex(true);
 
-  for (unsigned int ptr = 0; ptr < m_members.size(); ptr++)
+  PVRChannelNumberIndex::const_iterator it = m_channelNumberIndex.find(iChannelNumber);
+  if (it != m_channelNumberIndex.end())
   {
-    PVRChannelGroupMember groupMember = m_members.at(ptr);
-    if (groupMember.iChannelNumber == iChannelNumber)
-    {
-      CFileItemPtr retVal = CFileItemPtr(new CFileItem(*groupMember.channel));
-      return retVal;
-    }
+    CFileItemPtr retVal = CFileItemPtr(new CFileItem(*it->second));
+    return retVal;
   }
 
   CFileItemPtr retVal = CFileItemPtr(new CFileItem);
@@ -530,6 +577,76 @@ CPVRChannelGroupPtr CPVRChannelGroup::GetPreviousGroup(void) const
 
 /********** private methods **********/
 
+void CPVRChannelGroup::AddMember(const PVRChannelGroupMember &member)
+{
+  CSingleLock lock(m_critSection);
+  m_members.push_back(member);
+
+  if (!m_bIndexDirty)
+    IndexChannel(member.channel);
+  m_bChannelNumbersDirty = true;
+}
+
+void CPVRChannelGroup::RemoveMember(unsigned int iChannelPtr)
+{
+  CSingleLock lock(m_critSection);
+  m_members.erase(m_members.begin() + iChannelPtr);
+
+  /* another member may have the same unique ID */
+  InvalidateIndex();
+}
+
+void CPVRChannelGroup::UpdateIndex(bool bNumbers) const
+{
+  /* the unique or client ID of a channel changed since the indices were built */
+  if (m_bIndexDirty || m_iIdGeneration != CPVRChannel::IdGeneration())
+    BuildIndex();
+  else if (bNumbers && m_bChannelNumbersDirty)
+  {
+    m_channelNumberIndex.clear();
+    m_channelNumbers.clear();
+    for (unsigned int iChannelPtr = 0; iChannelPtr < m_members.size(); iChannelPtr++)
+    {
+      const PVRChannelGroupMember &member = m_members.at(iChannelPtr);
+      m_channelNumberIndex.insert(std::make_pair(member.iChannelNumber, member.channel));
+      if (member.channel->ChannelID() > 0)
+        m_channelNumbers.insert(std::make_pair(member.channel->ChannelID(), member.iChannelNumber));
+    }
+    m_bChannelNumbersDirty = false;
+  }
+}
+
+void CPVRChannelGroup::BuildIndex(void) const
+{
+  m_channelIdIndex.clear();
+  m_uniqueIdIndex.clear();
+  m_clientIndex.clear();
+  m_bMissingChannelIds = false;
+  m_bIndexDirty = false;
+  m_iIdGeneration = CPVRChannel::IdGeneration();
+
+  m_channelIdIndex.rehash(m_members.size());
+  m_uniqueIdIndex.rehash(m_members.size());
+  m_clientIndex.rehash(m_members.size());
+  for (unsigned int iChannelPtr = 0; iChannelPtr < m_members.size(); iChannelPtr++)
+    IndexChannel(m_members.at(iChannelPtr).channel);
+
+  m_bChannelNumbersDirty = true;
+  UpdateIndex(true);
+}
+
+void CPVRChannelGroup::IndexChannel(const CPVRChannelPtr &channel) const
+{
+  /* lookups return the first member with a key, like the linear searches did */
+  if (channel->ChannelID() > 0)
+    m_channelIdIndex.insert(std::make_pair(channel->ChannelID(), channel));
+  else
+    m_bMissingChannelIds = true;
+
+  m_uniqueIdIndex.insert(std::make_pair(channel->UniqueID(), channel));
+  m_clientIndex.insert(std::make_pair(std::make_pair(channel->ClientID(), channel->UniqueID()), channel));
+}
+
 int CPVRChannelGroup::LoadFromDb(bool bCompress /* = false */)
 {
   CPVRDatabase *database = GetPVRDatabase();
@@ -613,7 +730,7 @@ bool CPVRChannelGroup::RemoveDeletedChannels(const CPVRChannelGroup &channels)
         channel->Delete();
       }
 
-      m_members.erase(m_members.begin() + iChannelPtr);
+      RemoveMember(iChannelPtr);
       m_bChanged = true;
       bReturn = true;
     }
@@ -698,7 +815,7 @@ void CPVRChannelGroup::RemoveInvalidChannels(void)
       }
       else
       {
-        m_members.erase(m_members.begin() + ptr);
+        RemoveMember(ptr);
       }
       m_bChanged = true;
     }
@@ -715,7 +832,7 @@ bool CPVRChannelGroup::RemoveFromGroup(const CPVRChannel &channel)
     if (channel == *m_members.at(iChannelPtr).channel)
     {
       // TODO notify observers
-      m_members.erase(m_members.begin() + iChannelPtr);
+      RemoveMember(iChannelPtr);
       bReturn = true;
       m_bChanged = true;
       break;
@@ -745,7 +862,7 @@ bool CPVRChannelGroup::AddToGroup(CPVRChannel &channel, int iChannelNumber /* =
     if (realChannel)
     {
       PVRChannelGroupMember newMember = { realChannel, iChannelNumber };
-      m_members.push_back(newMember);
+      AddMember(newMember);
       m_bChanged = true;
 
       if (bSortAndRenumber)
@@ -767,36 +884,13 @@ bool CPVRChannelGroup::AddToGroup(CPVRChannel &channel, int iChannelNumber /* =
 
 bool CPVRChannelGroup::IsGroupMember(const CPVRChannel &channel) const
 {
-  bool bReturn(false);
-  CSingleLock lock(m_critSection);
-
-  for (unsigned int iChannelPtr = 0; iChannelPtr < m_members.size(); iChannelPtr++)
-  {
-    if (channel == *m_members.at(iChannelPtr).channel)
-    {
-      bReturn = true;
-      break;
-    }
-  }
-
-  return bReturn;
+  CPVRChannelPtr member = GetByClient(channel.UniqueID(), channel.ClientID());
+  return member && *member == channel;
 }
 
 bool CPVRChannelGroup::IsGroupMember(int iChannelId) const
 {
-  bool bReturn(false);
-  CSingleLock lock(m_critSection);
-
-  for (unsigned int iChannelPtr = 0; iChannelPtr < m_members.size(); iChannelPtr++)
-  {
-    if (iChannelId == m_members.at(iChannelPtr).channel->ChannelID())
-    {
-      bReturn = true;
-      break;
-    }
-  }
-
-  return bReturn;
+  return GetByChannelID(iChannelId) != NULL;
 }
 
 bool CPVRChannelGroup::SetGroupName(const CStdString &strGroupName, bool bSaveInDb /* = false */)
@@ -871,6 +965,7 @@ bool CPVRChannelGroup::Renumber(void)
 
     m_members.at(iChannelPtr).iChannelNumber = iCurrentChannelNumber;
   }
+  m_bChannelNumbersDirty = true;
 
   SortByChannelNumber();
   ResetChannelNumberCache();
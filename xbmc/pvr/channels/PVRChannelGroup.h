@@ -25,6 +25,7 @@
 #include "utils/JobManager.h"
 
 #include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
 
 namespace EPG
 {
@@ -447,6 +448,23 @@ namespace PVR
      */
     CPVRChannelPtr GetByChannelID(int iChannelID) const;
 
+    /*!
+     * @brief Add a channel to the members of this group and the lookup indices.
+     * @param member The new member.
+     */
+    void AddMember(const PVRChannelGroupMember &member);
+
+    /*!
+     * @brief Remove a channel from the members of this group.
+     * @param iChannelPtr The position of the member.
+     */
+    void RemoveMember(unsigned int iChannelPtr);
+
+    /*!
+     * @brief Rebuild the lookup indices when they're used next, after the members or their IDs changed.
+     */
+    void InvalidateIndex(void) { m_bIndexDirty = true; }
+
     bool             m_bRadio;                      /*!< true if this container holds radio channels, false if it holds TV channels */
     int              m_iGroupType;                  /*!< The type of this group */
     int              m_iGroupId;                    /*!< The ID of this group in the database */
@@ -457,6 +475,38 @@ namespace PVR
     bool             m_bUsingBackendChannelNumbers; /*!< true to use the channel numbers from 1 backend, false otherwise */
     std::vector<PVRChannelGroupMember> m_members;
     CCriticalSection m_critSection;
+
+  private:
+    typedef boost::unordered_map<int, CPVRChannelPtr>                 PVRChannelIdIndex;
+    typedef boost::unordered_map<std::pair<int, int>, CPVRChannelPtr> PVRClientChannelIndex;
+    typedef boost::unordered_map<unsigned int, CPVRChannelPtr>        PVRChannelNumberIndex;
+    typedef boost::unordered_map<int, unsigned int>                   PVRChannelNumberByIdIndex;
+
+    /*!
+     * @brief Rebuild the lookup indices if the members or the IDs of any channel changed since they were last built.
+     * @param bNumbers True to rebuild the channel number indices too.
+     */
+    void UpdateIndex(bool bNumbers) const;
+
+    /*!
+     * @brief Rebuild all lookup indices.
+     */
+    void BuildIndex(void) const;
+
+    /*!
+     * @brief Add a channel to the ID indices, unless another channel already has the same key.
+     */
+    void IndexChannel(const CPVRChannelPtr &channel) const;
+
+    mutable PVRChannelIdIndex         m_channelIdIndex;       /*!< the members by channel ID */
+    mutable PVRChannelIdIndex         m_uniqueIdIndex;        /*!< the members by unique ID on the client */
+    mutable PVRClientChannelIndex     m_clientIndex;          /*!< the members by client ID and unique ID */
+    mutable PVRChannelNumberIndex     m_channelNumberIndex;   /*!< the members by channel number in this group */
+    mutable PVRChannelNumberByIdIndex m_channelNumbers;       /*!< the channel numbers in this group by channel ID */
+    mutable bool                      m_bIndexDirty;          /*!< true if the indices have to be rebuilt */
+    mutable bool                      m_bChannelNumbersDirty; /*!< true if the channel number indices have to be rebuilt */
+    mutable bool                      m_bMissingChannelIds;   /*!< true if a member had no channel ID when it was indexed */
+    mutable long                      m_iIdGeneration;        /*!< CPVRChannel::IdGeneration() when the indices were built */
   };
 
   class CPVRPersistGroupJob : public CJob
@@ -95,7 +95,37 @@ void CPVRChannelGroupInternal::UpdateFromClient(const CPVRChannel &channel, unsi
   else
   {
     PVRChannelGroupMember newMember = { CPVRChannelPtr(new CPVRChannel(channel)), iChannelNumber > 0 ? iChannelNumber : m_members.size() + 1 };
-    m_members.push_back(newMember);
+    AddMember(newMember);
+    m_bChanged = true;
+
+    if (m_bUsingBackendChannelOrder)
+      SortByClientChannelNumber();
+    else
+      SortByChannelNumber();
+    Renumber();
+  }
+}
+
+void CPVRChannelGroupInternal::UpdateFromClient(const PVR_CHANNEL *channels, unsigned int iChannels, int iClientId)
+{
+  bool bAdded(false);
+  CSingleLock lock(m_critSection);
+  for (unsigned int iChannelPtr = 0; iChannelPtr < iChannels; iChannelPtr++)
+  {
+    CPVRChannel channel(channels[iChannelPtr], iClientId);
+    CPVRChannelPtr realChannel = GetByClient(channel.UniqueID(), channel.ClientID());
+    if (realChannel)
+      realChannel->UpdateFromClient(channel);
+    else
+    {
+      PVRChannelGroupMember newMember = { CPVRChannelPtr(new CPVRChannel(channel)), m_members.size() + 1 };
+      AddMember(newMember);
+      bAdded = true;
+    }
+  }
+
+  if (bAdded)
+  {
     m_bChanged = true;
 
     if (m_bUsingBackendChannelOrder)
@@ -283,11 +313,18 @@ bool CPVRChannelGroupInternal::UpdateChannel(const CPVRChannel &channel)
   if (!updateChannel)
   {
     updateChannel = CPVRChannelPtr(new CPVRChannel(channel.IsRadio()));
-    PVRChannelGroupMember newMember = { updateChannel, 0 };
-    m_members.push_back(newMember);
     updateChannel->SetUniqueID(channel.UniqueID());
+    updateChannel->UpdateFromClient(channel);
+    PVRChannelGroupMember newMember = { updateChannel, 0 };
+    AddMember(newMember);
+  }
+  else
+  {
+    int iClientId = updateChannel->ClientID();
+    updateChannel->UpdateFromClient(channel);
+    if (updateChannel->ClientID() != iClientId)
+      InvalidateIndex();
   }
-  updateChannel->UpdateFromClient(channel);
 
   return updateChannel->Persist(!m_bLoaded);
 }
@@ -72,6 +72,14 @@ namespace PVR
      */
     void UpdateFromClient(const CPVRChannel &channel, unsigned int iChannelNumber = 0);
 
+    /*!
+     * @brief Callback for add-ons to update a list of channels. The group is sorted and renumbered once, after all channels were added.
+     * @param channels The updated channels.
+     * @param iChannels The number of channels.
+     * @param iClientId The ID of the client that sent the channels.
+     */
+    void UpdateFromClient(const PVR_CHANNEL *channels, unsigned int iChannels, int iClientId);
+
     /*!
      * @see CPVRChannelGroup::IsGroupMember
      */
@@ -0,0 +1,265 @@
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "pvr/channels/PVRChannelGroup.h"
+#include "pvr/channels/PVRChannelGroupInternal.h"
+#include "threads/SingleLock.h"
+#include "utils/TimeUtils.h"
+
+#include "gtest/gtest.h"
+
+#define BENCHMARK_CHANNELS 3000
+#define BENCHMARK_CLIENTS  2
+#define BENCHMARK_TAGS     100000
+#define TRANSFER_CHANNELS  200
+
+using namespace PVR;
+
+/* gives access to the members, for comparing against the linear searches the indices replace */
+class CTestChannelGroup : public CPVRChannelGroup
+{
+public:
+  CTestChannelGroup(void) : CPVRChannelGroup(false, 1, "Test") {}
+
+  void Add(const CPVRChannelPtr &channel, unsigned int iChannelNumber)
+  {
+    PVRChannelGroupMember member = { channel, iChannelNumber };
+    AddMember(member);
+  }
+
+  void Remove(unsigned int iChannelPtr) { RemoveMember(iChannelPtr); }
+  bool Renumber(void) { return CPVRChannelGroup::Renumber(); }
+  bool RemoveDeleted(const CPVRChannelGroup &channels) { return RemoveDeletedChannels(channels); }
+  CPVRChannelPtr ByUniqueID(int iUniqueID) const { return GetByUniqueID(iUniqueID); }
+  CPVRChannelPtr ByChannelID(int iChannelID) const { return GetByChannelID(iChannelID); }
+  CPVRChannelPtr At(unsigned int iChannelPtr) const { return m_members.at(iChannelPtr).channel; }
+
+  CPVRChannelPtr LinearByClient(int iUniqueChannelId, int iClientID) const
+  {
+    CSingleLock lock(m_critSection);
+    for (unsigned int ptr = 0; ptr < m_members.size(); ptr++)
+    {
+      if (m_members.at(ptr).channel->UniqueID() == iUniqueChannelId &&
+          m_members.at(ptr).channel->ClientID() == iClientID)
+        return m_members.at(ptr).channel;
+    }
+    return CPVRChannelPtr();
+  }
+
+  CPVRChannelPtr LinearByChannelID(int iChannelID) const
+  {
+    CSingleLock lock(m_critSection);
+    for (unsigned int ptr = 0; ptr < m_members.size(); ptr++)
+    {
+      if (m_members.at(ptr).channel->ChannelID() == iChannelID)
+        return m_members.at(ptr).channel;
+    }
+    return CPVRChannelPtr();
+  }
+
+  CPVRChannelPtr LinearByChannelNumber(unsigned int iChannelNumber) const
+  {
+    CSingleLock lock(m_critSection);
+    for (unsigned int ptr = 0; ptr < m_members.size(); ptr++)
+    {
+      if (m_members.at(ptr).iChannelNumber == iChannelNumber)
+        return m_members.at(ptr).channel;
+    }
+    return CPVRChannelPtr();
+  }
+};
+
+static CPVRChannelPtr Channel(int iUniqueId, int iClientId, int iChannelId)
+{
+  PVR_CHANNEL channel;
+  memset(&channel, 0, sizeof(channel));
+  channel.iUniqueId      = iUniqueId;
+  channel.iChannelNumber = iUniqueId;
+  snprintf(channel.strChannelName, sizeof(channel.strChannelName), "Channel %d", iUniqueId);
+
+  CPVRChannelPtr newChannel(new CPVRChannel(channel, iClientId));
+  if (iChannelId > 0)
+    newChannel->SetChannelID(iChannelId);
+  return newChannel;
+}
+
+/* the channels of BENCHMARK_CLIENTS clients, which number their channels alike */
+static void Populate(CTestChannelGroup &group, int iChannels, bool bPersisted)
+{
+  for (int i = 0; i < iChannels; i++)
+    group.Add(Channel(i / BENCHMARK_CLIENTS + 1, i % BENCHMARK_CLIENTS + 1, bPersisted ? i + 1 : -1), i + 1);
+}
+
+TEST(TestPVRChannelGroup, Lookups)
+{
+  CTestChannelGroup group;
+  Populate(group, 20, false);
+
+  EXPECT_EQ(group.At(5), group.GetByClient(3, 2));
+  EXPECT_EQ(group.LinearByClient(7, 1), group.GetByClient(7, 1));
+  EXPECT_FALSE(group.GetByClient(11, 1));
+  EXPECT_TRUE(group.IsGroupMember(*group.At(5)));
+
+  /* the first channel with a unique ID, like before */
+  EXPECT_EQ(group.At(4), group.ByUniqueID(3));
+
+  /* channels get their ID when they're persisted */
+  EXPECT_FALSE(group.ByChannelID(6));
+  group.At(5)->SetChannelID(6);
+  EXPECT_EQ(group.At(5), group.ByChannelID(6));
+  EXPECT_TRUE(group.IsGroupMember(6));
+
+  /* numbers follow renumbering */
+  EXPECT_EQ(*group.At(5), *group.GetByChannelNumber(6)->GetPVRChannelInfoTag());
+  EXPECT_EQ(6U, group.GetChannelNumber(*group.At(5)));
+  group.Remove(0);
+  EXPECT_TRUE(group.Renumber());
+  EXPECT_EQ(*group.At(4), *group.GetByChannelNumber(5)->GetPVRChannelInfoTag());
+  EXPECT_EQ(5U, group.GetChannelNumber(*group.At(4)));
+  EXPECT_FALSE(group.GetByClient(1, 1));
+
+  /* and moves */
+  CPVRChannelPtr moved = group.At(4);
+  EXPECT_TRUE(group.MoveChannel(5, 1, false));
+  EXPECT_EQ(*moved, *group.GetByChannelNumber(1)->GetPVRChannelInfoTag());
+  EXPECT_EQ(1U, group.GetChannelNumber(*moved));
+  EXPECT_EQ(moved, group.GetByClient(moved->UniqueID(), moved->ClientID()));
+
+  group.Add(Channel(11, 1, 100), 20);
+  EXPECT_EQ(group.At(group.Size() - 1), group.GetByClient(11, 1));
+  EXPECT_EQ(group.At(group.Size() - 1), group.ByChannelID(100));
+  EXPECT_EQ(20U, group.GetChannelNumber(*group.At(group.Size() - 1)));
+
+  /* the client may change the IDs of a channel after it was indexed */
+  CPVRChannelPtr changed = group.At(2);
+  int iOldUniqueId = changed->UniqueID();
+  int iOldClientId = changed->ClientID();
+  ASSERT_TRUE(changed->SetUniqueID(50));
+  EXPECT_EQ(changed, group.GetByClient(50, iOldClientId));
+  EXPECT_EQ(changed, group.ByUniqueID(50));
+  EXPECT_NE(changed, group.GetByClient(iOldUniqueId, iOldClientId));
+  EXPECT_NE(changed, group.ByUniqueID(iOldUniqueId));
+  ASSERT_TRUE(changed->SetClientID(5));
+  EXPECT_EQ(changed, group.GetByClient(50, 5));
+  EXPECT_FALSE(group.GetByClient(50, iOldClientId));
+}
+
+TEST(TestPVRChannelGroup, TransferFromClient)
+{
+  /* a client that numbers its channels backwards */
+  std::vector<PVR_CHANNEL> channels(TRANSFER_CHANNELS);
+  for (int i = 0; i < TRANSFER_CHANNELS; i++)
+  {
+    memset(&channels[i], 0, sizeof(PVR_CHANNEL));
+    channels[i].iUniqueId      = i + 1;
+    channels[i].iChannelNumber = TRANSFER_CHANNELS - i;
+    snprintf(channels[i].strChannelName, sizeof(channels[i].strChannelName), "Channel %d", i + 1);
+  }
+
+  /* the whole list at once ends up like one channel at a time */
+  CPVRChannelGroupInternal single(false), batch(false);
+  for (int i = 0; i < TRANSFER_CHANNELS; i++)
+    single.UpdateFromClient(CPVRChannel(channels[i], 1));
+  batch.UpdateFromClient(&channels[0], channels.size(), 1);
+
+  ASSERT_EQ(TRANSFER_CHANNELS, single.Size());
+  ASSERT_EQ(TRANSFER_CHANNELS, batch.Size());
+  for (unsigned int iChannelNumber = 1; iChannelNumber <= TRANSFER_CHANNELS; iChannelNumber++)
+    EXPECT_EQ(single.GetByChannelNumber(iChannelNumber)->GetPVRChannelInfoTag()->UniqueID(),
+              batch.GetByChannelNumber(iChannelNumber)->GetPVRChannelInfoTag()->UniqueID());
+
+  /* known channels are updated in place */
+  snprintf(channels[0].strChannelName, sizeof(channels[0].strChannelName), "Renamed");
+  CPVRChannelPtr first = batch.GetByClient(1, 1);
+  batch.UpdateFromClient(&channels[0], channels.size(), 1);
+  EXPECT_EQ(TRANSFER_CHANNELS, batch.Size());
+  EXPECT_EQ(first, batch.GetByClient(1, 1));
+  EXPECT_EQ("Renamed", first->ClientChannelName());
+
+  /* and the channels of another client are added */
+  batch.UpdateFromClient(&channels[0], 1, 2);
+  EXPECT_EQ(TRANSFER_CHANNELS + 1, batch.Size());
+  EXPECT_TRUE(batch.GetByClient(1, 2));
+}
+
+/* a benchmark, run it with --gtest_also_run_disabled_tests */
+TEST(TestPVRChannelGroup, DISABLED_Startup)
+{
+  /* the channels as they're loaded from the database */
+  int64_t start = CurrentHostCounter();
+  CTestChannelGroup group;
+  Populate(group, BENCHMARK_CHANNELS, true);
+  group.SortByChannelNumber();
+  group.Renumber();
+  double msLoad = 1000.0 * (CurrentHostCounter() - start) / CurrentHostFrequency();
+
+  /* the same channels from the clients, which are matched up with the ones that are known */
+  CTestChannelGroup clients;
+  Populate(clients, BENCHMARK_CHANNELS, false);
+  start = CurrentHostCounter();
+  EXPECT_FALSE(group.RemoveDeleted(clients));
+  for (int i = 0; i < clients.Size(); i++)
+  {
+    CPVRChannelPtr channel = clients.At(i);
+    EXPECT_TRUE(group.GetByClient(channel->UniqueID(), channel->ClientID()));
+  }
+  double msUpdate = 1000.0 * (CurrentHostCounter() - start) / CurrentHostFrequency();
+
+  /* EPG tables, timers and recordings look up their channel */
+  unsigned int seed = 1;
+  std::vector<int> uids, clientIds, channelIds;
+  for (int i = 0; i < BENCHMARK_TAGS; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    int iChannel = (seed >> 8) % BENCHMARK_CHANNELS;
+    uids.push_back(iChannel / BENCHMARK_CLIENTS + 1);
+    clientIds.push_back(iChannel % BENCHMARK_CLIENTS + 1);
+    channelIds.push_back(iChannel + 1);
+  }
+
+  start = CurrentHostCounter();
+  for (int i = 0; i < BENCHMARK_TAGS; i++)
+  {
+    group.GetByClient(uids[i], clientIds[i]);
+    group.ByChannelID(channelIds[i]);
+  }
+  double msIndexed = 1000.0 * (CurrentHostCounter() - start) / CurrentHostFrequency();
+
+  start = CurrentHostCounter();
+  for (int i = 0; i < BENCHMARK_TAGS; i++)
+  {
+    group.LinearByClient(uids[i], clientIds[i]);
+    group.LinearByChannelID(channelIds[i]);
+  }
+  double msLinear = 1000.0 * (CurrentHostCounter() - start) / CurrentHostFrequency();
+
+  for (int i = 0; i < BENCHMARK_TAGS; i += 97)
+  {
+    EXPECT_EQ(group.LinearByClient(uids[i], clientIds[i]), group.GetByClient(uids[i], clientIds[i]));
+    EXPECT_EQ(group.LinearByChannelID(channelIds[i]), group.ByChannelID(channelIds[i]));
+  }
+  for (unsigned int iChannelNumber = 1; iChannelNumber <= BENCHMARK_CHANNELS; iChannelNumber += 31)
+    EXPECT_EQ(*group.LinearByChannelNumber(iChannelNumber), *group.GetByChannelNumber(iChannelNumber)->GetPVRChannelInfoTag());
+
+  std::cout << "Loaded " << testing::PrintToString(BENCHMARK_CHANNELS) << " channels in " << testing::PrintToString(msLoad)
+            << "ms, updated them from the clients in " << testing::PrintToString(msUpdate) << "ms" << std::endl;
+  std::cout << "Looked up the channels of " << testing::PrintToString(BENCHMARK_TAGS) << " tags in "
+            << testing::PrintToString(msIndexed) << "ms (linear: " << testing::PrintToString(msLinear) << "ms)" << std::endl;
+}
@@ -205,6 +205,8 @@ void CAdvancedSettings::Initialize()
   m_strMusicLibraryAlbumFormat = "";
   m_strMusicLibraryAlbumFormatRight = "";
   m_prioritiseAPEv2tags = false;
+  m_musicLibraryTagReaders = 4;
+  m_musicLibraryScanBatch = 16;
   m_musicItemSeparator = " / ";
   m_videoItemSeparator = " / ";
 
@@ -216,6 +218,7 @@ void CAdvancedSettings::Initialize()
   m_bVideoLibraryImportWatchedState = false;
   m_bVideoLibraryImportResumePoint = false;
   m_bVideoScannerIgnoreErrors = false;
+  m_videoScannerCrawlThreads = 4;
   m_iVideoLibraryDateAdded = 1; // prefer mtime over ctime and current time
 
   m_iTuxBoxStreamtsPort = 31339;
@@ -298,6 +301,11 @@ void CAdvancedSettings::Initialize()
   m_measureRefreshrate = false;
 
   m_cacheMemBufferSize = 1024 * 1024 * 20;
+  m_cacheSegments = 2;
+  m_webserverBlockSize = 128 * 1024;
+  m_dirCacheSize = 16 * 1024;
+  m_dirCacheTTL = 0;
+  m_dirCachePersist = false;
   m_addonPackageFolderSize = 200;
 
   m_jsonOutputCompact = true;
@@ -635,6 +643,8 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetString(pElement, "albumformat", m_strMusicLibraryAlbumFormat);
     XMLUtils::GetString(pElement, "albumformatright", m_strMusicLibraryAlbumFormatRight);
     XMLUtils::GetString(pElement, "itemseparator", m_musicItemSeparator);
+    XMLUtils::GetInt(pElement, "tagreaders", m_musicLibraryTagReaders, 1, 16);
+    XMLUtils::GetInt(pElement, "scanbatch", m_musicLibraryScanBatch, 1, 256);
   }
 
   pElement = pRootElement->FirstChildElement("videolibrary");
@@ -655,6 +665,7 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
   if (pElement)
   {
     XMLUtils::GetBoolean(pElement, "ignoreerrors", m_bVideoScannerIgnoreErrors);
+    XMLUtils::GetInt(pElement, "crawlthreads", m_videoScannerCrawlThreads, 0, 16);
   }
 
   // Backward-compatibility of ExternalPlayer config
@@ -687,6 +698,16 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetInt(pElement, "curlretries", m_curlretries, 0, 10);
     XMLUtils::GetBoolean(pElement,"disableipv6", m_curlDisableIPV6);
     XMLUtils::GetUInt(pElement, "cachemembuffersize", m_cacheMemBufferSize);
+    XMLUtils::GetInt(pElement, "cachesegments", m_cacheSegments, 1, 8);
+    XMLUtils::GetInt(pElement, "webserverblocksize", m_webserverBlockSize, 4096, 16 * 1024 * 1024);
+  }
+
+  pElement = pRootElement->FirstChildElement("dircache");
+  if (pElement)
+  {
+    XMLUtils::GetInt(pElement, "memorysize", m_dirCacheSize, 256, 1024 * 1024);
+    XMLUtils::GetInt(pElement, "ttl", m_dirCacheTTL, 0, 24 * 60 * 60);
+    XMLUtils::GetBoolean(pElement, "persist", m_dirCachePersist);
   }
 
   pElement = pRootElement->FirstChildElement("jsonrpc");
@@ -730,6 +751,31 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     CLog::SetLogLevel(g_advancedSettings.m_logLevel);
   }
 
+  pElement = pRootElement->FirstChildElement("logging");
+  if (pElement)
+  {
+    bool async;
+    if (XMLUtils::GetBoolean(pElement, "async", async))
+      CLog::SetAsync(async);
+
+    // lowest level logged per component, overriding the loglevel for it
+    static const struct { const char *tag; int component; } components[] =
+    {
+      { "player",   LOGPLAYER },
+      { "audio",    LOGAUDIO },
+      { "video",    LOGVIDEO },
+      { "gui",      LOGGUI },
+      { "network",  LOGNETWORK },
+      { "database", LOGDATABASE },
+    };
+    for (unsigned int i = 0; i < sizeof(components) / sizeof(components[0]); i++)
+    {
+      int level;
+      if (XMLUtils::GetInt(pElement, components[i].tag, level, -1, LOGNONE))
+        CLog::SetComponentLogLevel(components[i].component, level);
+    }
+  }
+
   XMLUtils::GetString(pRootElement, "cddbaddress", m_cddbAddress);
 
   //airtunes + airplay
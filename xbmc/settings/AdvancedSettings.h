@@ -240,6 +240,8 @@ class CAdvancedSettings
     CStdString m_strMusicLibraryAlbumFormat;
     CStdString m_strMusicLibraryAlbumFormatRight;
     bool m_prioritiseAPEv2tags;
+    int m_musicLibraryTagReaders; ///< number of threads reading tags during a library scan
+    int m_musicLibraryScanBatch;  ///< number of directories the scanner commits per transaction
     CStdString m_musicItemSeparator;
     CStdString m_videoItemSeparator;
     std::vector<CStdString> m_musicTagsFromFileFilters;
@@ -253,6 +255,7 @@ class CAdvancedSettings
     bool m_bVideoLibraryImportResumePoint;
 
     bool m_bVideoScannerIgnoreErrors;
+    int m_videoScannerCrawlThreads; ///< folders listed ahead of the video scanner at once, 0 to list them serially
     int m_iVideoLibraryDateAdded;
 
     std::vector<CStdString> m_vecTokens; // cleaning strings tied to language
@@ -349,6 +352,11 @@ class CAdvancedSettings
     unsigned int m_addonPackageFolderSize;
 
     unsigned int m_cacheMemBufferSize;
+    int m_cacheSegments;       // regions of a file kept in memory at once, sharing cachemembuffersize
+    int m_webserverBlockSize; // bytes read per call when the webserver sends a file
+    int m_dirCacheSize;       // KB of directory listings kept in memory
+    int m_dirCacheTTL;        // seconds before a cached listing is checked against the filesystem, 0 to never expire
+    bool m_dirCachePersist;   // keep the directory cache across restarts
 
     bool m_jsonOutputCompact;
     unsigned int m_jsonTcpPort;
@@ -402,6 +402,8 @@ protected:
   void LoadUserFolderLayout();
 
 private:
+  friend class TestTextureCachePipeline;
+
   std::vector<CProfile> m_vecProfiles;
   std::map<CStdString, int> m_watchMode;
   bool m_usingLoginScreen;
@@ -0,0 +1,426 @@
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "TextureCache.h"
+#include "TextureCacheJob.h"
+#include "TextureCachePipeline.h"
+#include "TextureDatabase.h"
+#include "dbwrappers/dataset.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "pictures/Picture.h"
+#include "settings/AdvancedSettings.h"
+#include "settings/Settings.h"
+#include "threads/Event.h"
+#include "threads/SingleLock.h"
+#include "utils/TimeUtils.h"
+#include "utils/URIUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace XFILE;
+
+static const int TEST_TEXTURES = 5000;
+static const int TEST_IMAGES   = 100; ///< for the pipeline
+
+static CStdString GetTestURL(int texture)
+{
+  CStdString url;
+  url.Format("smb://server/Movies/Movie %d/poster.jpg", texture);
+  return url;
+}
+
+/* friend of CTextureCache and CTextureDatabase, so that the tests can point the
+   cache at a database of their own and get at the lookups underneath GetCachedImage() */
+class TestTextureCache : public testing::Test
+{
+protected:
+  TestTextureCache() : m_cache(CTextureCache::Get())
+  {
+    m_settings.type = "sqlite3";
+    m_settings.host = CSpecialProtocol::TranslatePath("special://temp/");
+    m_settings.name = "TestTextures";
+
+    // start from an empty database, in case an earlier run left one behind
+    m_db.Update(m_settings);
+    m_file = CStdString("special://temp/") + m_db.m_pDB->getDatabase();
+    m_db.Close();
+    XFILE::CFile::Delete(m_file);
+    m_db.Update(m_settings);
+
+    m_db.BeginTransaction();
+    for (int texture = 0; texture < TEST_TEXTURES; texture++)
+    {
+      CTextureDetails details;
+      details.file = CTextureCache::GetCacheFile(GetTestURL(texture)) + ".jpg";
+      details.hash = "hash";
+      details.width = 1000;
+      details.height = 1500;
+      details.updateable = true;
+      m_db.AddCachedTexture(GetTestURL(texture), details);
+    }
+    m_db.CommitTransaction();
+
+    m_cache.m_database.Update(m_settings);
+  }
+
+  ~TestTextureCache()
+  {
+    m_cache.Deinitialize();
+    m_db.Close();
+    XFILE::CFile::Delete(m_file);
+  }
+
+  bool WaitForIndex()
+  {
+    for (int i = 0; i < 1000; i++)
+    {
+      {
+        CSharedLock lock(m_cache.m_indexSection);
+        if (m_cache.m_indexLoaded)
+          return true;
+      }
+      Sleep(10);
+    }
+    return false;
+  }
+
+  bool GetCachedTexture(const CStdString &url, CTextureDetails &details)
+  {
+    return m_cache.GetCachedTexture(url, details);
+  }
+
+  /* the lookup as it was before the index, straight from the database */
+  bool GetCachedTextureFromDatabase(const CStdString &url, CTextureDetails &details)
+  {
+    CSingleLock lock(m_cache.m_databaseSection);
+    return m_cache.m_database.GetCachedTexture(url, details);
+  }
+
+  bool ClearCachedTexture(const CStdString &url, CStdString &cachedFile)
+  {
+    return m_cache.ClearCachedTexture(url, cachedFile);
+  }
+
+  void WriteIndex()
+  {
+    m_cache.WriteIndex();
+  }
+
+  CTextureCache &m_cache;
+  DatabaseSettings m_settings;
+  CTextureDatabase m_db;
+  CStdString m_file;
+};
+
+static double Percentile(std::vector<double> &times, double percentile)
+{
+  std::sort(times.begin(), times.end());
+  return times[(size_t)((times.size() - 1) * percentile)];
+}
+
+TEST_F(TestTextureCache, Coherent)
+{
+  m_cache.Initialize();
+  ASSERT_TRUE(WaitForIndex());
+
+  for (int texture = 0; texture < TEST_TEXTURES; texture += 100)
+  {
+    CTextureDetails fromIndex, fromDatabase;
+    ASSERT_TRUE(GetCachedTexture(GetTestURL(texture), fromIndex));
+    ASSERT_TRUE(GetCachedTextureFromDatabase(GetTestURL(texture), fromDatabase));
+    EXPECT_EQ(fromDatabase.id, fromIndex.id);
+    EXPECT_EQ(fromDatabase.file, fromIndex.file);
+    EXPECT_EQ(fromDatabase.hash, fromIndex.hash);
+    EXPECT_EQ(fromDatabase.width, fromIndex.width);
+    EXPECT_EQ(fromDatabase.height, fromIndex.height);
+  }
+
+  // changes show up in lookups straight away
+  CTextureDetails details;
+  details.file = "a/added.png";
+  details.width = 10;
+  details.height = 20;
+  EXPECT_TRUE(m_cache.AddCachedTexture("smb://server/added.png", details));
+  CStdString cachedFile;
+  EXPECT_TRUE(ClearCachedTexture(GetTestURL(0), cachedFile));
+  EXPECT_STREQ((CTextureCache::GetCacheFile(GetTestURL(0)) + ".jpg").c_str(), cachedFile.c_str());
+  EXPECT_TRUE(m_cache.InvalidateCachedImage(GetTestURL(1)));
+
+  CTextureDetails added, cleared, invalidated;
+  EXPECT_TRUE(GetCachedTexture("smb://server/added.png", added));
+  EXPECT_EQ("a/added.png", added.file);
+  EXPECT_EQ(20u, added.height);
+  EXPECT_FALSE(GetCachedTexture(GetTestURL(0), cleared));
+  EXPECT_TRUE(GetCachedTexture(GetTestURL(1), invalidated));
+  EXPECT_EQ("hash", invalidated.hash);
+
+  // and make it to the database once written
+  WriteIndex();
+  CTextureDetails fromDatabase;
+  EXPECT_TRUE(GetCachedTextureFromDatabase("smb://server/added.png", fromDatabase));
+  EXPECT_EQ("a/added.png", fromDatabase.file);
+  EXPECT_FALSE(GetCachedTextureFromDatabase(GetTestURL(0), fromDatabase));
+  EXPECT_TRUE(GetCachedTextureFromDatabase(GetTestURL(1), fromDatabase));
+  EXPECT_EQ("hash", fromDatabase.hash);
+
+  // added textures get their id once written
+  EXPECT_TRUE(GetCachedTexture("smb://server/added.png", added));
+  EXPECT_GT(added.id, 0);
+}
+
+/* a benchmark, run it with --gtest_also_run_disabled_tests */
+TEST_F(TestTextureCache, DISABLED_LookupLatency)
+{
+  m_cache.Initialize();
+  ASSERT_TRUE(WaitForIndex());
+
+  std::vector<double> before, after;
+  for (int texture = 0; texture < TEST_TEXTURES; texture++)
+  {
+    CTextureDetails details;
+    int64_t start = CurrentHostCounter();
+    GetCachedTextureFromDatabase(GetTestURL(texture), details);
+    int64_t middle = CurrentHostCounter();
+    GetCachedTexture(GetTestURL(texture), details);
+    int64_t end = CurrentHostCounter();
+
+    before.push_back(1000000.0 * (middle - start) / CurrentHostFrequency());
+    after.push_back(1000000.0 * (end - middle) / CurrentHostFrequency());
+  }
+
+  std::cout << "Database lookup p50: " << testing::PrintToString(Percentile(before, 0.5)) << "us"
+            << " p99: " << testing::PrintToString(Percentile(before, 0.99)) << "us" << std::endl;
+  std::cout << "Index lookup p50: " << testing::PrintToString(Percentile(after, 0.5)) << "us"
+            << " p99: " << testing::PrintToString(Percentile(after, 0.99)) << "us" << std::endl;
+}
+
+/* collects the results of the pipeline, in place of CTextureCache */
+class CTestCachingCallback : public ITextureCacheCallback
+{
+public:
+  CTestCachingCallback() : m_complete(0) {}
+
+  virtual bool OnCachingStart(CTextureCacheJob *job)
+  {
+    return true;
+  }
+
+  virtual void OnCachingComplete(bool success, CTextureCacheJob *job)
+  {
+    CSingleLock lock(m_section);
+    m_complete++;
+    if (success)
+      m_cached.push_back(CTextureCache::GetCachedPath(job->m_details.file));
+    m_event.Set();
+  }
+
+  virtual void OnCachingCancelled(const CStdString &url)
+  {
+    CSingleLock lock(m_section);
+    m_cancelled.push_back(url);
+    m_cancelledEvent.Set();
+  }
+
+  bool Wait(int complete, unsigned int timeout)
+  {
+    int64_t end = CurrentHostCounter() + (int64_t)timeout * CurrentHostFrequency() / 1000;
+    while (CurrentHostCounter() < end)
+    {
+      {
+        CSingleLock lock(m_section);
+        if (m_complete >= complete)
+          return true;
+      }
+      m_event.WaitMSec(100);
+    }
+    return false;
+  }
+
+  int m_complete;
+  std::vector<CStdString> m_cached;
+  std::vector<CStdString> m_cancelled;
+  CCriticalSection m_section;
+  CEvent m_event;
+  CEvent m_cancelledEvent;
+};
+
+/* holds the first image in OnCachingStart() until it is released */
+class CHoldingCachingCallback : public CTestCachingCallback
+{
+public:
+  virtual bool OnCachingStart(CTextureCacheJob *job)
+  {
+    m_starting.Set();
+    m_release.Wait();
+    return true;
+  }
+
+  CEvent m_starting;
+  CEvent m_release;
+};
+
+class TestTextureCachePipeline : public testing::Test
+{
+protected:
+  TestTextureCachePipeline()
+  {
+    /* without a profile the thumbnails folder is relative to the working directory,
+       so give the test environment one in the temp folder, until the test is done */
+    m_profiles = g_settings.m_vecProfiles;
+    m_currentProfile = g_settings.m_currentProfile;
+    if (!g_settings.GetNumProfiles())
+      g_settings.AddProfile(CProfile("special://temp/"));
+    for (unsigned int hex = 0; hex < 16; hex++)
+    {
+      CStdString folder;
+      folder.Format("%x", hex);
+      CDirectory::Create(URIUtils::AddFileToFolder(g_settings.GetThumbnailsFolder(), folder));
+    }
+
+    m_root = "special://temp/TestTextureCachePipeline/";
+    CDirectory::Create(m_root);
+  }
+
+  ~TestTextureCachePipeline()
+  {
+    for (std::vector<CStdString>::iterator i = m_images.begin(); i != m_images.end(); ++i)
+      CFile::Delete(*i);
+    CDirectory::Remove(m_root);
+
+    g_settings.m_vecProfiles = m_profiles;
+    g_settings.m_currentProfile = m_currentProfile;
+  }
+
+  /* photo sized images, with enough detail that they don't compress to nothing */
+  void CreateImages(int count)
+  {
+    const unsigned int width = 1920, height = 1080;
+    std::vector<uint32_t> pixels(width * height);
+    for (int image = 0; image < count; image++)
+    {
+      for (unsigned int y = 0; y < height; y++)
+      {
+        for (unsigned int x = 0; x < width; x++)
+          pixels[y * width + x] = 0xff000000 | ((x * 255 / width) << 16) | ((y * 255 / height) << 8) | ((x ^ y ^ image) & 0xff);
+      }
+      CStdString path;
+      path.Format("%simage%03d.jpg", m_root.c_str(), image);
+      if (CPicture::CreateThumbnailFromSurface((unsigned char *)&pixels[0], width, height, width * 4, path))
+        m_images.push_back(path);
+    }
+  }
+
+  /* one image at a time, as a single queue of cacheimage jobs does */
+  void CacheSerial(std::vector<CStdString> &cached)
+  {
+    for (size_t i = 0; i < m_images.size(); i++)
+    {
+      CTextureCacheJob job(m_images[i]);
+      if (job.CacheTexture())
+        cached.push_back(CTextureCache::GetCachedPath(job.m_details.file));
+    }
+  }
+
+  bool CachePipeline(CTestCachingCallback &callback)
+  {
+    CTextureCachePipeline pipeline(&callback, 2, 2, 1, 8);
+    for (size_t i = 0; i < m_images.size(); i++)
+      pipeline.Add(new CTextureCacheJob(m_images[i]));
+    if (!callback.Wait((int)m_images.size(), 120000))
+      return false;
+    return !pipeline.IsActive();
+  }
+
+  static void DeleteCached(std::vector<CStdString> &cached)
+  {
+    for (std::vector<CStdString>::iterator i = cached.begin(); i != cached.end(); ++i)
+      CFile::Delete(*i);
+    cached.clear();
+  }
+
+  CStdString m_root;
+  std::vector<CStdString> m_images;
+  std::vector<CProfile> m_profiles;
+  unsigned int m_currentProfile;
+};
+
+TEST_F(TestTextureCachePipeline, SameAsSerial)
+{
+  CreateImages(8);
+  ASSERT_EQ(8U, m_images.size());
+
+  std::vector<CStdString> cached;
+  CacheSerial(cached);
+  EXPECT_EQ(m_images.size(), cached.size());
+  DeleteCached(cached);
+
+  /* both cache the same images */
+  CTestCachingCallback callback;
+  EXPECT_TRUE(CachePipeline(callback));
+  EXPECT_EQ(m_images.size(), callback.m_cached.size());
+  DeleteCached(callback.m_cached);
+}
+
+/* a benchmark, run it with --gtest_also_run_disabled_tests */
+TEST_F(TestTextureCachePipeline, DISABLED_Throughput)
+{
+  CreateImages(TEST_IMAGES);
+  ASSERT_EQ((size_t)TEST_IMAGES, m_images.size());
+
+  std::vector<CStdString> cached;
+  int64_t start = CurrentHostCounter();
+  CacheSerial(cached);
+  double serial = (double)(CurrentHostCounter() - start) / CurrentHostFrequency();
+  DeleteCached(cached);
+
+  CTestCachingCallback callback;
+  start = CurrentHostCounter();
+  EXPECT_TRUE(CachePipeline(callback));
+  double staged = (double)(CurrentHostCounter() - start) / CurrentHostFrequency();
+  DeleteCached(callback.m_cached);
+
+  std::cout << "Serial images/s: " << testing::PrintToString(serial > 0 ? TEST_IMAGES / serial : 0.0) << std::endl;
+  std::cout << "Pipeline images/s: " << testing::PrintToString(staged > 0 ? TEST_IMAGES / staged : 0.0) << std::endl;
+}
+
+TEST(TestTextureCachePipelineCancel, Started)
+{
+  CHoldingCachingCallback callback;
+  CTextureCachePipeline pipeline(&callback, 1, 1, 1, 8);
+  pipeline.Add(new CTextureCacheJob("special://temp/TestTextureCachePipelineCancel1.jpg"));
+  pipeline.Add(new CTextureCacheJob("special://temp/TestTextureCachePipelineCancel2.jpg"));
+  ASSERT_TRUE(callback.m_starting.WaitMSec(10000));
+
+  /* the first image is started once the callback returns, the second one never is */
+  pipeline.Cancel();
+  EXPECT_FALSE(pipeline.IsActive());
+  callback.m_release.Set();
+  ASSERT_TRUE(callback.m_cancelledEvent.WaitMSec(10000));
+
+  CSingleLock lock(callback.m_section);
+  ASSERT_EQ(1U, callback.m_cancelled.size());
+  EXPECT_EQ("special://temp/TestTextureCachePipelineCancel1.jpg", callback.m_cancelled[0]);
+  EXPECT_EQ(0, callback.m_complete);
+}
@@ -0,0 +1,273 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileItem.h"
+#include "dbwrappers/dataset.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "settings/AdvancedSettings.h"
+#include "utils/TimeUtils.h"
+#include "video/VideoDatabase.h"
+
+#include "gtest/gtest.h"
+
+#include <map>
+#include <string>
+
+static const int TEST_MOVIES = 2000; ///< for the benchmark, the fixture only adds a few
+static const int TEST_CAST   = 10;
+
+class CTestVideoDatabase : public CVideoDatabase
+{
+public:
+  /* create (or open) a fresh database in special://temp instead of the profile folder */
+  bool Create()
+  {
+    DatabaseSettings settings;
+    settings.type = "sqlite3";
+    settings.host = CSpecialProtocol::TranslatePath("special://temp/");
+    settings.name = "TestVideos";
+    return Update(settings);
+  }
+
+  CStdString GetFileName() const
+  {
+    return CStdString("special://temp/") + m_pDB->getDatabase();
+  }
+};
+
+class TestVideoDatabase : public testing::Test
+{
+protected:
+  TestVideoDatabase()
+  {
+    // start from an empty database, in case an earlier run left one behind
+    m_db.Create();
+    m_file = m_db.GetFileName();
+    m_db.Close();
+    XFILE::CFile::Delete(m_file);
+    m_db.Create();
+
+    std::map<std::string, std::string> artwork;
+    std::map<int, std::string> seasonArt;
+    int shows[2];
+    for (int show = 0; show < 2; show++)
+    {
+      CVideoInfoTag details;
+      details.m_strTitle.Format("Show %d", show);
+      details.m_tags.push_back("test");
+      details.m_tags.push_back(show ? "odd" : "even");
+      AddCast(details, show, 3);
+
+      CStdString path;
+      path.Format("smb://server/TV Shows/Show %d/", show);
+      shows[show] = m_db.SetDetailsForTvShow(path, details, artwork, seasonArt);
+
+      for (int episode = 1; episode <= 3; episode++)
+      {
+        CVideoInfoTag info;
+        info.m_strTitle.Format("Episode %d", episode);
+        info.m_iSeason = 1;
+        info.m_iEpisode = episode;
+        /* the first actor plays in the show as well, and is only listed once */
+        AddCast(info, show + 2, episode);
+        info.m_strFileNameAndPath.Format("%sS01E%02d.mkv", path.c_str(), episode);
+        m_db.SetDetailsForEpisode(info.m_strFileNameAndPath, info, artwork, shows[show]);
+        if (episode == 2)
+        {
+          CBookmark bookmark;
+          bookmark.timeInSeconds = 120;
+          m_db.AddBookMarkForEpisode(info, bookmark);
+        }
+      }
+    }
+
+    for (int movie = 0; movie < 5; movie++)
+    {
+      int idMovie = AddMovie(movie, 3);
+      /* linked backwards, the links still come in the order of the shows */
+      if (movie < 2)
+      {
+        m_db.LinkMovieToTvshow(idMovie, shows[1], false);
+        m_db.LinkMovieToTvshow(idMovie, shows[0], false);
+      }
+    }
+  }
+
+  ~TestVideoDatabase()
+  {
+    m_db.Close();
+    XFILE::CFile::Delete(m_file);
+  }
+
+  static void AddCast(CVideoInfoTag &details, int first, int count)
+  {
+    for (int actor = 0; actor < count; actor++)
+    {
+      SActorInfo info;
+      info.strName.Format("Actor %d", first + actor);
+      info.strRole.Format("Role %d", actor);
+      details.m_cast.push_back(info);
+    }
+  }
+
+  int AddMovie(int movie, int cast)
+  {
+    CVideoInfoTag details;
+    details.m_strTitle.Format("Movie %d", movie);
+    details.m_iYear = 1950 + movie % 60;
+    details.m_tags.push_back("test");
+    AddCast(details, movie * 7 % 1000, cast);
+
+    CStdString file;
+    file.Format("smb://server/Movies/Movie %d/movie.mkv", movie);
+    return m_db.SetDetailsForMovie(file, details, std::map<std::string, std::string>());
+  }
+
+  /* the details GetLinkedDetails() fills in have to match those of the per item lookups */
+  static void ExpectSameDetails(const CFileItemList &expectedItems, const CFileItemList &actualItems)
+  {
+    ASSERT_EQ(expectedItems.Size(), actualItems.Size());
+    for (int i = 0; i < expectedItems.Size(); i++)
+    {
+      const CVideoInfoTag *expected = expectedItems[i]->GetVideoInfoTag();
+      const CVideoInfoTag *actual = actualItems[i]->GetVideoInfoTag();
+      EXPECT_EQ(expected->m_iDbId, actual->m_iDbId);
+      ASSERT_EQ(expected->m_cast.size(), actual->m_cast.size());
+      for (unsigned int j = 0; j < expected->m_cast.size(); j++)
+      {
+        EXPECT_EQ(expected->m_cast[j].strName, actual->m_cast[j].strName);
+        EXPECT_EQ(expected->m_cast[j].strRole, actual->m_cast[j].strRole);
+      }
+      EXPECT_EQ(expected->m_tags, actual->m_tags);
+      EXPECT_EQ(expected->m_showLink, actual->m_showLink);
+      EXPECT_EQ(expected->m_fEpBookmark, actual->m_fEpBookmark);
+    }
+  }
+
+  CTestVideoDatabase m_db;
+  CStdString m_file;
+};
+
+TEST_F(TestVideoDatabase, GetLinkedDetails)
+{
+  CFileItemList perRow, bulk;
+  ASSERT_TRUE(m_db.GetMoviesByWhere("videodb://1/2/", CDatabase::Filter(), perRow));
+  ASSERT_TRUE(m_db.GetMoviesByWhere("videodb://1/2/", CDatabase::Filter(), bulk));
+  ASSERT_EQ(5, perRow.Size());
+
+  for (int i = 0; i < perRow.Size(); i++)
+    m_db.GetMovieInfo("", *perRow[i]->GetVideoInfoTag(), perRow[i]->GetVideoInfoTag()->m_iDbId);
+  EXPECT_TRUE(m_db.GetLinkedDetails(bulk));
+  ExpectSameDetails(perRow, bulk);
+
+  for (int i = 0; i < bulk.Size(); i++)
+  {
+    const CVideoInfoTag *tag = bulk[i]->GetVideoInfoTag();
+    EXPECT_EQ(3U, tag->m_cast.size());
+    if (tag->m_strTitle == "Movie 0")
+    {
+      ASSERT_EQ(2U, tag->m_showLink.size());
+      EXPECT_EQ("Show 0", tag->m_showLink[0]);
+      EXPECT_EQ("Show 1", tag->m_showLink[1]);
+    }
+  }
+}
+
+TEST_F(TestVideoDatabase, GetLinkedDetailsTvShows)
+{
+  CFileItemList perRow, bulk;
+  ASSERT_TRUE(m_db.GetTvShowsByWhere("videodb://2/2/", CDatabase::Filter(), perRow));
+  ASSERT_TRUE(m_db.GetTvShowsByWhere("videodb://2/2/", CDatabase::Filter(), bulk));
+  ASSERT_EQ(2, perRow.Size());
+
+  for (int i = 0; i < perRow.Size(); i++)
+    m_db.GetTvShowInfo("", *perRow[i]->GetVideoInfoTag(), perRow[i]->GetVideoInfoTag()->m_iDbId);
+  EXPECT_TRUE(m_db.GetLinkedDetails(bulk));
+  ExpectSameDetails(perRow, bulk);
+
+  for (int i = 0; i < bulk.Size(); i++)
+  {
+    EXPECT_EQ(3U, bulk[i]->GetVideoInfoTag()->m_cast.size());
+    EXPECT_EQ(2U, bulk[i]->GetVideoInfoTag()->m_tags.size());
+  }
+}
+
+TEST_F(TestVideoDatabase, GetLinkedDetailsEpisodes)
+{
+  CFileItemList perRow, bulk;
+  ASSERT_TRUE(m_db.GetEpisodesByWhere("videodb://2/2/-1/-1/", CDatabase::Filter(), perRow));
+  ASSERT_TRUE(m_db.GetEpisodesByWhere("videodb://2/2/-1/-1/", CDatabase::Filter(), bulk));
+  ASSERT_EQ(6, perRow.Size());
+
+  for (int i = 0; i < perRow.Size(); i++)
+    m_db.GetEpisodeInfo("", *perRow[i]->GetVideoInfoTag(), perRow[i]->GetVideoInfoTag()->m_iDbId);
+  EXPECT_TRUE(m_db.GetLinkedDetails(bulk));
+  ExpectSameDetails(perRow, bulk);
+
+  for (int i = 0; i < bulk.Size(); i++)
+  {
+    /* the cast of the episode, then that of the show without the actor already listed */
+    const CVideoInfoTag *tag = bulk[i]->GetVideoInfoTag();
+    EXPECT_EQ((unsigned int)tag->m_iEpisode + 2, tag->m_cast.size());
+    EXPECT_EQ(tag->m_iEpisode == 2 ? 120.0f : 0.0f, tag->m_fEpBookmark);
+  }
+}
+
+TEST_F(TestVideoDatabase, GetPathHashes)
+{
+  ASSERT_TRUE(m_db.SetPathHash("smb://server/Music Videos/", "base"));
+  ASSERT_TRUE(m_db.SetPathHash("smb://server/Music Videos/A/", "a"));
+  ASSERT_TRUE(m_db.SetPathHash("smb://server/Music Videos/B/", "b"));
+  ASSERT_TRUE(m_db.SetPathHash("smb://server/Music Videos/B/Extras/", "extras"));
+  ASSERT_TRUE(m_db.SetPathHash("smb://server/Music Videos 2/C/", "c"));
+
+  /* only the folders right below, not the folder itself, deeper ones or siblings */
+  std::map<CStdString, CStdString> hashes;
+  ASSERT_TRUE(m_db.GetPathHashes("smb://server/Music Videos/", hashes));
+  EXPECT_EQ(2U, hashes.size());
+  EXPECT_EQ("a", hashes["smb://server/Music Videos/A/"]);
+  EXPECT_EQ("b", hashes["smb://server/Music Videos/B/"]);
+}
+
+/* a benchmark, run it with --gtest_also_run_disabled_tests */
+TEST_F(TestVideoDatabase, DISABLED_GetLinkedDetailsPerformance)
+{
+  for (int movie = 5; movie < TEST_MOVIES; movie++)
+    AddMovie(movie, TEST_CAST);
+
+  CFileItemList perRow, bulk;
+  ASSERT_TRUE(m_db.GetMoviesByWhere("videodb://1/2/", CDatabase::Filter(), perRow));
+  ASSERT_TRUE(m_db.GetMoviesByWhere("videodb://1/2/", CDatabase::Filter(), bulk));
+
+  int64_t start = CurrentHostCounter();
+  for (int i = 0; i < perRow.Size(); i++)
+    m_db.GetMovieInfo("", *perRow[i]->GetVideoInfoTag(), perRow[i]->GetVideoInfoTag()->m_iDbId);
+  int64_t perRowTime = CurrentHostCounter() - start;
+
+  start = CurrentHostCounter();
+  EXPECT_TRUE(m_db.GetLinkedDetails(bulk));
+  int64_t bulkTime = CurrentHostCounter() - start;
+
+  double frequency = (double)CurrentHostFrequency();
+  std::cout << "Movies: " << testing::PrintToString(TEST_MOVIES)
+            << " Per row (ms): " << testing::PrintToString(perRowTime * 1000.0 / frequency)
+            << " Bulk (ms): " << testing::PrintToString(bulkTime * 1000.0 / frequency) << std::endl;
+}
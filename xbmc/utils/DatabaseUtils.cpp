@@ -654,6 +654,29 @@ bool DatabaseUtils::GetDatabaseResults(MediaType mediaType, const FieldList &fie
   return true;
 }
 
+bool DatabaseUtils::GetNextRecord(const std::auto_ptr<dbiplus::Dataset> &dataset, const DatabaseResults &results, unsigned int &index, unsigned int &targetRow, const dbiplus::sql_record* &record, unsigned int rowOffset /* = 0 */)
+{
+  if (dataset->is_streaming())
+  {
+    // only move on now, so the previous record stays valid until it has been processed
+    if (index > 0)
+      dataset->next();
+    if (dataset->eof())
+      return false;
+
+    targetRow = rowOffset + index++;
+    record = dataset->get_sql_record();
+    return true;
+  }
+
+  if (index >= results.size())
+    return false;
+
+  targetRow = (unsigned int)results[index++].at(FieldRow).asInteger();
+  record = targetRow >= rowOffset ? dataset->get_result_set().records.at(targetRow - rowOffset) : NULL;
+  return true;
+}
+
 std::string DatabaseUtils::BuildLimitClause(int end, int start /* = 0 */)
 {
   std::ostringstream sql;
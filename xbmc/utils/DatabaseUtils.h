@@ -27,10 +27,11 @@
 
 class CVariant;
 
+#include "dbwrappers/qry_dat.h"
+
 namespace dbiplus
 {
   class Dataset;
-  class field_value;
 }
 
 typedef enum {
@@ -160,5 +161,18 @@ public:
   static bool GetFieldValue(const dbiplus::field_value &fieldValue, CVariant &variantValue);
   static bool GetDatabaseResults(MediaType mediaType, const FieldList &fields, const std::auto_ptr<dbiplus::Dataset> &dataset, DatabaseResults &results);
 
+  /*! \brief Step through the rows of a listing query.
+   Rows of a streamed dataset are returned in the order the dataset delivers them, otherwise
+   they are returned in the order of the (sorted) results through their FieldRow.
+   \param dataset the dataset the listing query was run on.
+   \param results the results from SortUtils::SortFromDataset(), unused when streaming.
+   \param index position of the next row, start at 0. Advanced on every call.
+   \param targetRow [out] FieldRow of the returned row (its position in the dataset when streaming).
+   \param record [out] record of the returned row, NULL if targetRow is below rowOffset.
+   \param rowOffset number of leading results that don't come from the dataset.
+   \return true if a row was returned, false once all rows have been returned.
+   */
+  static bool GetNextRecord(const std::auto_ptr<dbiplus::Dataset> &dataset, const DatabaseResults &results, unsigned int &index, unsigned int &targetRow, const dbiplus::sql_record* &record, unsigned int rowOffset = 0);
+
   static std::string BuildLimitClause(int end, int start = 0);
 };
@@ -45,12 +45,10 @@ using namespace XFILE;
 
 CEdenVideoArtUpdater::CEdenVideoArtUpdater() : CThread("EdenVideoArtUpdater")
 {
-  m_textureDB.Open();
 }
 
 CEdenVideoArtUpdater::~CEdenVideoArtUpdater()
 {
-  m_textureDB.Close();
 }
 
 void CEdenVideoArtUpdater::Start()
@@ -287,7 +285,7 @@ bool CEdenVideoArtUpdater::CacheTexture(const std::string &originalUrl, const st
       details.width = width;
       details.height = height;
       delete texture;
-      m_textureDB.AddCachedTexture(originalUrl, details);
+      CTextureCache::Get().AddCachedTexture(originalUrl, details);
       return true;
     }
   }
@@ -21,7 +21,7 @@
 
 #include <string>
 #include "threads/Thread.h"
-#include "TextureDatabase.h"
+#include "utils/StdString.h"
 
 class CFileItem;
 
@@ -48,6 +48,4 @@ private:
   CStdString GetCachedVideoThumb(const CFileItem &item);
   CStdString GetCachedFanart(const CFileItem &item);
   CStdString GetThumb(const CStdString &path, const CStdString &path2, bool split /* = false */);
-
-  CTextureDatabase m_textureDB;
 };
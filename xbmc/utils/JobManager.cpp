@@ -21,6 +21,7 @@
 #include "JobManager.h"
 #include <algorithm>
 #include "threads/SingleLock.h"
+#include "threads/Atomics.h"
 #include "utils/log.h"
 
 #include "system.h"
@@ -35,9 +36,11 @@ bool CJob::ShouldCancel(unsigned int progress, unsigned int total) const
   return false;
 }
 
-CJobWorker::CJobWorker(CJobManager *manager) : CThread("Jobworker")
+CJobWorker::CJobWorker(CJobManager *manager, unsigned int shard) : CThread("Jobworker")
 {
   m_jobManager = manager;
+  m_shard = shard;
+  m_jobShard = shard;
   Create(true); // start work immediately, and kill ourselves when we're done
 }
 
@@ -70,7 +73,7 @@ void CJobWorker::Process()
     {
       CLog::Log(LOGERROR, "%s error processing job %s", __FUNCTION__, job->GetType());
     }
-    m_jobManager->OnJobComplete(success, job);
+    m_jobManager->OnJobComplete(success, job, this);
   }
 }
 
@@ -167,7 +170,16 @@ CJobManager &CJobManager::GetInstance()
 CJobManager::CJobManager()
 {
   m_jobCounter = 0;
+  m_nextShard = 0;
+  m_processingCount = 0;
+  m_idleWorkers = 0;
+  m_pausedCount = 0;
+  m_workerShard = 0;
   m_running = true;
+
+  // one shard per possible worker, so that each worker has a home shard to itself
+  for (unsigned int i = 0; i < GetMaxWorkers(CJob::PRIORITY_HIGH); ++i)
+    m_shards.push_back(new CJobShard);
 }
 
 void CJobManager::CancelJobs()
@@ -175,15 +187,21 @@ void CJobManager::CancelJobs()
   CSingleLock lock(m_section);
   m_running = false;
 
-  // clear any pending jobs
-  for (unsigned int priority = CJob::PRIORITY_LOW; priority <= CJob::PRIORITY_HIGH; ++priority)
+  for (std::vector<CJobShard*>::iterator shard = m_shards.begin(); shard != m_shards.end(); ++shard)
   {
-    for_each(m_jobQueue[priority].begin(), m_jobQueue[priority].end(), mem_fun_ref(&CWorkItem::FreeJob));
-    m_jobQueue[priority].clear();
-  }
+    CSingleLock shardLock((*shard)->m_section);
+
+    // clear any pending jobs
+    for (unsigned int priority = CJob::PRIORITY_LOW; priority <= CJob::PRIORITY_HIGH; ++priority)
+    {
+      for_each((*shard)->m_jobQueue[priority].begin(), (*shard)->m_jobQueue[priority].end(), mem_fun_ref(&CWorkItem::FreeJob));
+      (*shard)->m_jobQueue[priority].clear();
+      (*shard)->m_queued[priority] = 0;
+    }
 
-  // cancel any callbacks on jobs still processing
-  for_each(m_processing.begin(), m_processing.end(), mem_fun_ref(&CWorkItem::Cancel));
+    // cancel any callbacks on jobs still processing
+    for_each((*shard)->m_processing.begin(), (*shard)->m_processing.end(), mem_fun_ref(&CWorkItem::Cancel));
+  }
 
   // tell our workers to finish
   while (m_workers.size())
@@ -197,15 +215,22 @@ void CJobManager::CancelJobs()
 
 CJobManager::~CJobManager()
 {
+  for (std::vector<CJobShard*>::iterator shard = m_shards.begin(); shard != m_shards.end(); ++shard)
+    delete *shard;
 }
 
 unsigned int CJobManager::AddJob(CJob *job, IJobCallback *callback, CJob::PRIORITY priority)
 {
-  CSingleLock lock(m_section);
-
   // create a work item for this job
-  CWorkItem work(job, m_jobCounter++, callback);
-  m_jobQueue[priority].push_back(work);
+  CWorkItem work(job, AtomicIncrement(&m_jobCounter) - 1, callback);
+
+  // and queue it on the next shard, without touching the manager lock
+  CJobShard *shard = m_shards[(unsigned long)AtomicIncrement(&m_nextShard) % m_shards.size()];
+  {
+    CSingleLock lock(shard->m_section);
+    shard->m_jobQueue[priority].push_back(work);
+    shard->m_queued[priority]++;
+  }
 
   StartWorkers(priority);
   return work.m_id;
@@ -213,91 +238,213 @@ unsigned int CJobManager::AddJob(CJob *job, IJobCallback *callback, CJob::PRIORI
 
 void CJobManager::CancelJob(unsigned int jobID)
 {
-  CSingleLock lock(m_section);
-
-  // check whether we have this job in the queue
-  for (unsigned int priority = CJob::PRIORITY_LOW; priority <= CJob::PRIORITY_HIGH; ++priority)
+  for (std::vector<CJobShard*>::iterator shard = m_shards.begin(); shard != m_shards.end(); ++shard)
   {
-    JobQueue::iterator i = find(m_jobQueue[priority].begin(), m_jobQueue[priority].end(), jobID);
-    if (i != m_jobQueue[priority].end())
+    CSingleLock lock((*shard)->m_section);
+
+    // check whether we have this job in the queue
+    for (unsigned int priority = CJob::PRIORITY_LOW; priority <= CJob::PRIORITY_HIGH; ++priority)
     {
-      delete i->m_job;
-      m_jobQueue[priority].erase(i);
+      JobQueue::iterator i = find((*shard)->m_jobQueue[priority].begin(), (*shard)->m_jobQueue[priority].end(), jobID);
+      if (i != (*shard)->m_jobQueue[priority].end())
+      {
+        delete i->m_job;
+        (*shard)->m_jobQueue[priority].erase(i);
+        (*shard)->m_queued[priority]--;
+        return;
+      }
+    }
+    // or if we're processing it
+    Processing::iterator it = find((*shard)->m_processing.begin(), (*shard)->m_processing.end(), jobID);
+    if (it != (*shard)->m_processing.end())
+    {
+      it->m_callback = NULL; // job is in progress, so only thing to do is to remove callback
       return;
     }
   }
-  // or if we're processing it
-  Processing::iterator it = find(m_processing.begin(), m_processing.end(), jobID);
-  if (it != m_processing.end())
-    it->m_callback = NULL; // job is in progress, so only thing to do is to remove callback
 }
 
 void CJobManager::StartWorkers(CJob::PRIORITY priority)
 {
-  CSingleLock lock(m_section);
-
   // check how many free threads we have
-  if (m_processing.size() >= GetMaxWorkers(priority))
+  if ((unsigned long)m_processingCount >= GetMaxWorkers(priority))
     return;
 
   // do we have any sleeping threads?
-  if (m_processing.size() < m_workers.size())
+  if (m_idleWorkers > 0)
+  {
+    m_jobEvent.Set();
+    return;
+  }
+
+  CSingleLock lock(m_section);
+
+  // a worker that is between jobs will pick up the new one.  Setting the
+  // event also covers the case where it is just about to go to sleep.
+  if ((unsigned long)m_processingCount < m_workers.size())
   {
     m_jobEvent.Set();
     return;
   }
 
   // everyone is busy - we need more workers
-  m_workers.push_back(new CJobWorker(this));
+  m_workers.push_back(new CJobWorker(this, m_workerShard));
+  m_workerShard = (m_workerShard + 1) % m_shards.size();
 }
 
-CJob *CJobManager::PopJob()
+bool CJobManager::ReserveSlot(CJob::PRIORITY priority)
+{
+  while (true)
+  {
+    long processing = m_processingCount;
+    if ((unsigned long)processing >= GetMaxWorkers(priority))
+      return false;
+    if (cas(&m_processingCount, processing, processing + 1) == processing)
+      return true;
+  }
+}
+
+void CJobManager::ReleaseSlot()
+{
+  AtomicDecrement(&m_processingCount);
+}
+
+CJob *CJobManager::PopJob(CJobWorker *worker)
 {
-  CSingleLock lock(m_section);
   for (int priority = CJob::PRIORITY_HIGH; priority >= CJob::PRIORITY_LOW; --priority)
   {
-    if (m_jobQueue[priority].size() && m_processing.size() < GetMaxWorkers(CJob::PRIORITY(priority)))
+    if ((unsigned long)m_processingCount >= GetMaxWorkers(CJob::PRIORITY(priority)))
+      continue;
+
+    // while any type is paused, low priority jobs are taken strictly in the
+    // order they were added, so a paused job holds up the ones behind it
+    if (priority <= CJob::PRIORITY_LOW && m_pausedCount > 0)
     {
-      CWorkItem job = m_jobQueue[priority].front();
+      CJob *job = PopOldestJob(worker, CJob::PRIORITY(priority));
+      if (job)
+        return job;
+      continue;
+    }
 
-      // skip adding any paused types
-      if (priority <= CJob::PRIORITY_LOW)
+    // our own shard first, then steal from the others
+    for (unsigned int i = 0; i < m_shards.size(); ++i)
+    {
+      unsigned int shard = (worker->m_shard + i) % m_shards.size();
+      bool full = false;
+      CJob *job = PopJob(*m_shards[shard], CJob::PRIORITY(priority), full);
+      if (job)
       {
-        std::vector<std::string>::iterator i = find(m_pausedTypes.begin(), m_pausedTypes.end(), job.m_job->GetType());
-        if (i != m_pausedTypes.end())
-          return NULL;
+        worker->m_jobShard = shard;
+        return job;
       }
-
-      m_jobQueue[priority].pop_front();
-      // add to the processing vector
-      m_processing.push_back(job);
-      job.m_job->m_callback = this;
-      return job.m_job;
+      if (full)
+        break;
     }
   }
   return NULL;
 }
 
+CJob *CJobManager::PopJob(CJobShard &shard, CJob::PRIORITY priority, bool &full)
+{
+  if (shard.m_queued[priority] == 0)
+    return NULL;
+
+  CSingleLock lock(shard.m_section);
+  JobQueue &queue = shard.m_jobQueue[priority];
+  if (queue.empty())
+    return NULL;
+
+  // the slot is only taken once there is a job for it, so StartWorkers()
+  // never sees a slot that a worker holds while it looks for work
+  if (!ReserveSlot(priority))
+  {
+    full = true;
+    return NULL;
+  }
+
+  CWorkItem job = queue.front();
+  queue.pop_front();
+  shard.m_queued[priority]--;
+  // add to the processing vector
+  shard.m_processing.push_back(job);
+  job.m_job->m_callback = this;
+  return job.m_job;
+}
+
+CJob *CJobManager::PopOldestJob(CJobWorker *worker, CJob::PRIORITY priority)
+{
+  while (true)
+  {
+    // job ids are handed out in order, the oldest job has the lowest
+    unsigned int oldest = 0, oldestId = 0;
+    bool found = false;
+    for (unsigned int i = 0; i < m_shards.size(); ++i)
+    {
+      CSingleLock lock(m_shards[i]->m_section);
+      JobQueue &queue = m_shards[i]->m_jobQueue[priority];
+      if (!queue.empty() && (!found || (int)(queue.front().m_id - oldestId) < 0))
+      {
+        oldest   = i;
+        oldestId = queue.front().m_id;
+        found    = true;
+      }
+    }
+    if (!found)
+      return NULL;
+
+    CJobShard &shard = *m_shards[oldest];
+    CSingleLock lock(shard.m_section);
+    JobQueue &queue = shard.m_jobQueue[priority];
+    // another worker got there first, look again
+    if (queue.empty() || queue.front().m_id != oldestId)
+      continue;
+
+    if (IsPausedType(queue.front().m_job->GetType()) || !ReserveSlot(priority))
+      return NULL;
+
+    CWorkItem job = queue.front();
+    queue.pop_front();
+    shard.m_queued[priority]--;
+    shard.m_processing.push_back(job);
+    job.m_job->m_callback = this;
+    worker->m_jobShard = oldest;
+    return job.m_job;
+  }
+}
+
+bool CJobManager::IsPausedType(const char *type)
+{
+  if (m_pausedCount == 0)
+    return false;
+  return IsPaused(type);
+}
+
 void CJobManager::Pause(const std::string &pausedType)
 {
-  CSingleLock lock(m_section);
+  CSingleLock lock(m_pausedSection);
   // just push it in so we get ref counting,
   // the queue will resume when all Pause requests
   // for a given type have been UnPaused.
   m_pausedTypes.push_back(pausedType);
+  m_pausedCount = m_pausedTypes.size();
 }
 
 void CJobManager::UnPause(const std::string &pausedType)
 {
-  CSingleLock lock(m_section);
+  CSingleLock lock(m_pausedSection);
   std::vector<std::string>::iterator i = find(m_pausedTypes.begin(), m_pausedTypes.end(), pausedType);
   if (i != m_pausedTypes.end())
     m_pausedTypes.erase(i);
+  m_pausedCount = m_pausedTypes.size();
+  lock.Leave();
+
+  // paused jobs may now be runnable
+  StartWorkers(CJob::PRIORITY_LOW);
 }
 
 bool CJobManager::IsPaused(const std::string &pausedType)
 {
-  CSingleLock lock(m_section);
+  CSingleLock lock(m_pausedSection);
   std::vector<std::string>::iterator i = find(m_pausedTypes.begin(), m_pausedTypes.end(), pausedType);
   return (i != m_pausedTypes.end());
 }
@@ -305,34 +452,37 @@ bool CJobManager::IsPaused(const std::string &pausedType)
 int CJobManager::IsProcessing(const std::string &pausedType)
 {
   int jobsMatched = 0;
-  CSingleLock lock(m_section);
-  for(Processing::iterator it = m_processing.begin(); it < m_processing.end(); it++)
+  for (std::vector<CJobShard*>::iterator shard = m_shards.begin(); shard != m_shards.end(); ++shard)
   {
-    if (pausedType == std::string(it->m_job->GetType()))
-      jobsMatched++;
+    CSingleLock lock((*shard)->m_section);
+    for(Processing::iterator it = (*shard)->m_processing.begin(); it < (*shard)->m_processing.end(); it++)
+    {
+      if (pausedType == std::string(it->m_job->GetType()))
+        jobsMatched++;
+    }
   }
   return jobsMatched;
 }
 
-CJob *CJobManager::GetNextJob(const CJobWorker *worker)
+CJob *CJobManager::GetNextJob(CJobWorker *worker)
 {
-  CSingleLock lock(m_section);
   while (m_running)
   {
     // grab a job off the queue if we have one
-    CJob *job = PopJob();
+    CJob *job = PopJob(worker);
     if (job)
       return job;
     // no jobs are left - sleep for 30 seconds to allow new jobs to come in
-    lock.Leave();
+    AtomicIncrement(&m_idleWorkers);
     bool newJob = m_jobEvent.WaitMSec(30000);
-    lock.Enter();
+    AtomicDecrement(&m_idleWorkers);
     if (!newJob)
       break;
   }
   // ensure no jobs have come in during the period after
   // timeout and before we held the lock
-  CJob *job = PopJob();
+  CSingleLock lock(m_section);
+  CJob *job = PopJob(worker);
   if (job)
     return job;
   // have no jobs
@@ -342,28 +492,40 @@ CJob *CJobManager::GetNextJob(const CJobWorker *worker)
 
 bool CJobManager::OnJobProgress(unsigned int progress, unsigned int total, const CJob *job) const
 {
-  CSingleLock lock(m_section);
-  // find the job in the processing queue, and check whether it's cancelled (no callback)
-  Processing::const_iterator i = find(m_processing.begin(), m_processing.end(), job);
-  if (i != m_processing.end())
+  // the job is normally reporting from its own worker, so try that worker's shard first
+  unsigned int first = 0;
+  CJobWorker *worker = dynamic_cast<CJobWorker*>(CThread::GetCurrentThread());
+  if (worker && worker->m_jobManager == this)
+    first = worker->m_jobShard;
+
+  for (unsigned int i = 0; i < m_shards.size(); ++i)
   {
-    CWorkItem item(*i);
-    lock.Leave(); // leave section prior to call
-    if (item.m_callback)
+    CJobShard *shard = m_shards[(first + i) % m_shards.size()];
+    CSingleLock lock(shard->m_section);
+    // find the job in the processing queue, and check whether it's cancelled (no callback)
+    Processing::const_iterator it = find(shard->m_processing.begin(), shard->m_processing.end(), job);
+    if (it != shard->m_processing.end())
     {
-      item.m_callback->OnJobProgress(item.m_id, progress, total, job);
-      return false;
+      CWorkItem item(*it);
+      lock.Leave(); // leave section prior to call
+      if (item.m_callback)
+      {
+        item.m_callback->OnJobProgress(item.m_id, progress, total, job);
+        return false;
+      }
+      return true;
     }
   }
   return true; // couldn't find the job, or it's been cancelled
 }
 
-void CJobManager::OnJobComplete(bool success, CJob *job)
+void CJobManager::OnJobComplete(bool success, CJob *job, const CJobWorker *worker)
 {
-  CSingleLock lock(m_section);
+  CJobShard *shard = m_shards[worker->m_jobShard];
+  CSingleLock lock(shard->m_section);
   // remove the job from the processing queue
-  Processing::iterator i = find(m_processing.begin(), m_processing.end(), job);
-  if (i != m_processing.end())
+  Processing::iterator i = find(shard->m_processing.begin(), shard->m_processing.end(), job);
+  if (i != shard->m_processing.end())
   {
     // tell any listeners we're done with the job, then delete it
     CWorkItem item(*i);
@@ -378,12 +540,14 @@ void CJobManager::OnJobComplete(bool success, CJob *job)
       CLog::Log(LOGERROR, "%s error processing job %s", __FUNCTION__, item.m_job->GetType());
     }
     lock.Enter();
-    Processing::iterator j = find(m_processing.begin(), m_processing.end(), job);
-    if (j != m_processing.end())
-      m_processing.erase(j);
+    Processing::iterator j = find(shard->m_processing.begin(), shard->m_processing.end(), job);
+    if (j != shard->m_processing.end())
+      shard->m_processing.erase(j);
     lock.Leave();
     item.FreeJob();
   }
+  // free up the slot we reserved in PopJob
+  ReleaseSlot();
 }
 
 void CJobManager::RemoveWorker(const CJobWorker *worker)
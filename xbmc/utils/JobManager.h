@@ -31,12 +31,15 @@ class CJobManager;
 class CJobWorker : public CThread
 {
 public:
-  CJobWorker(CJobManager *manager);
+  CJobWorker(CJobManager *manager, unsigned int shard);
   virtual ~CJobWorker();
 
   void Process();
 private:
+  friend class CJobManager;
   CJobManager  *m_jobManager;
+  unsigned int  m_shard;     ///< home shard this worker pulls from first
+  unsigned int  m_jobShard;  ///< shard that holds the processing entry of the current job
 };
 
 /*!
@@ -158,6 +161,13 @@ private:
  priority levels.  Lower priority jobs are executed only if there are sufficient
  spare worker threads free to allow for higher priority jobs that may arise.
 
+ Queued and processing jobs are spread over a set of shards, each with its own
+ lock and per-priority queues.  Jobs are submitted round-robin to the shards,
+ and every worker drains its home shard first and steals from the others when
+ that runs dry, so submitters and workers rarely contend on the same lock.
+ The number of processing jobs and idle workers is tracked atomically, so the
+ manager-wide lock is only taken when workers are started or retired.
+
  \sa CJob and IJobCallback
  */
 class CJobManager
@@ -266,16 +276,17 @@ protected:
    \param worker a pointer to the current CJobWorker instance requesting a job.
    \sa CJob
    */
-  CJob *GetNextJob(const CJobWorker *worker);
+  CJob *GetNextJob(CJobWorker *worker);
 
   /*!
    \brief Callback from CJobWorker after a job has completed.
    Calls IJobCallback::OnJobComplete(), and then destroys job.
-   \param job a pointer to the calling subclassed CJob instance.
    \param success the result from the DoWork call
+   \param job a pointer to the calling subclassed CJob instance.
+   \param worker the CJobWorker instance that processed the job.
    \sa IJobCallback, CJob
    */
-  void  OnJobComplete(bool success, CJob *job);
+  void  OnJobComplete(bool success, CJob *job, const CJobWorker *worker);
 
   /*!
    \brief Callback from CJob to report progress and check for cancellation.
@@ -295,27 +306,75 @@ private:
   CJobManager const& operator=(CJobManager const&);
   virtual ~CJobManager();
 
+  typedef std::deque<CWorkItem>    JobQueue;
+  typedef std::vector<CWorkItem>   Processing;
+  typedef std::vector<CJobWorker*> Workers;
+
+  /*!
+   \brief A slice of the job queue with its own lock.
+   Holds the queued jobs of each priority that were submitted to this shard, as
+   well as the jobs taken from this shard that are currently being processed.
+   m_queued mirrors the queue sizes so that workers can skip empty shards
+   without taking the lock; it is only modified while holding m_section.
+   */
+  class CJobShard
+  {
+  public:
+    CJobShard()
+    {
+      for (unsigned int priority = CJob::PRIORITY_LOW; priority <= CJob::PRIORITY_HIGH; ++priority)
+        m_queued[priority] = 0;
+    }
+    CCriticalSection m_section;
+    JobQueue         m_jobQueue[CJob::PRIORITY_HIGH+1];
+    volatile long    m_queued[CJob::PRIORITY_HIGH+1];
+    Processing       m_processing;
+  };
+
   /*! \brief Pop a job off the job queue and add to the processing queue ready to process
+   Looks in the worker's home shard first, then steals from the remaining shards.
+   \param worker the worker that will process the job.
    \return the job to process, NULL if no jobs are available
    */
-  CJob *PopJob();
+  CJob *PopJob(CJobWorker *worker);
+
+  /*! \brief Pop the first job of the given priority from a shard, reserving a processing slot for it
+   \param full set to true if the shard had a job but GetMaxWorkers(priority) jobs are already processing.
+   \return the job to process, NULL if the shard has no job at that priority or no slot is free
+   */
+  CJob *PopJob(CJobShard &shard, CJob::PRIORITY priority, bool &full);
+
+  /*! \brief Pop the oldest job of the given priority over all shards, reserving a processing slot for it
+   Used for PRIORITY_LOW while types are paused: if the oldest job is paused, nothing is popped.
+   \return the job to process, NULL if there is none, it is paused or no slot is free
+   */
+  CJob *PopOldestJob(CJobWorker *worker, CJob::PRIORITY priority);
+
+  /*! \brief Reserve a processing slot for a job of the given priority
+   \return true if fewer than GetMaxWorkers(priority) jobs were processing and a slot was taken.
+   */
+  bool ReserveSlot(CJob::PRIORITY priority);
+  void ReleaseSlot();
 
+  bool IsPausedType(const char *type);
   void StartWorkers(CJob::PRIORITY priority);
   void RemoveWorker(const CJobWorker *worker);
   unsigned int GetMaxWorkers(CJob::PRIORITY priority) const;
 
-  unsigned int m_jobCounter;
+  volatile long m_jobCounter;
+  volatile long m_nextShard;     ///< round-robin counter used to pick the shard for new jobs
+  volatile long m_processingCount;
+  volatile long m_idleWorkers;
+  volatile long m_pausedCount;
 
-  typedef std::deque<CWorkItem>    JobQueue;
-  typedef std::vector<CWorkItem>   Processing;
-  typedef std::vector<CJobWorker*> Workers;
-
-  JobQueue   m_jobQueue[CJob::PRIORITY_HIGH+1];
-  Processing m_processing;
+  std::vector<CJobShard*> m_shards;
   Workers    m_workers;
+  unsigned int m_workerShard;    ///< home shard handed to the next worker
 
   CCriticalSection m_section;
   CEvent           m_jobEvent;
-  bool             m_running;
+  volatile bool    m_running;
+
+  CCriticalSection m_pausedSection;
   std::vector<std::string>  m_pausedTypes;
 };
@@ -18,6 +18,8 @@
  *
  */
 
+#include <algorithm>
+
 #include "SortUtils.h"
 #include "URL.h"
 #include "Util.h"
@@ -411,111 +413,73 @@ string ByChannel(SortAttribute attributes, const SortItem &values)
   return values.at(FieldChannelName).asString();
 }
 
-bool preliminarySort(const SortItem &left, const SortItem &right, bool handleFolder, bool &result, std::wstring &labelLeft, std::wstring &labelRight)
-{
-  // make sure both items have the necessary data to do the sorting
-  SortItem::const_iterator itLeftSort, itRightSort;
-  if ((itLeftSort = left.find(FieldSort)) == left.end())
-  {
-    result = false;
-    return true;
-  }
-  if ((itRightSort = right.find(FieldSort)) == right.end())
+/*! \brief Precomputed sort key of a single item.
+ The comparison only ever looks at these flat keys instead of searching the
+ SortItem maps, and the items themselves are never moved while sorting.
+ */
+typedef struct
+{
+  std::wstring label;
+  SortSpecial  special;
+  int          folder;  ///< -1 if the item has no FieldFolder, otherwise 0 or 1
+} SortKey;
+
+class SortKeyComparator
+{
+public:
+  SortKeyComparator(const vector<SortKey> &keys, bool descending, bool handleFolders)
+    : m_keys(keys), m_descending(descending), m_handleFolders(handleFolders)
+  { }
+
+  /*! \brief Order two items by their index in the key array.
+   Items that compare equal keep their original order, which makes the ordering
+   strict and total so that sort() and partial_sort() give the same result as a
+   stable_sort() would.
+   */
+  bool operator()(size_t left, size_t right) const
   {
-    result = true;
-    return true;
-  }
+    int result = Compare(m_keys[left], m_keys[right]);
+    if (result != 0)
+      return result < 0;
 
-  // look at special sorting behaviour
-  SortItem::const_iterator itLeft, itRight;
-  SortSpecial leftSortSpecial = SortSpecialNone;
-  SortSpecial rightSortSpecial = SortSpecialNone;
-  if ((itLeft = left.find(FieldSortSpecial)) != left.end() && itLeft->second.asInteger() <= (int64_t)SortSpecialOnBottom)
-    leftSortSpecial = (SortSpecial)itLeft->second.asInteger();
-  if ((itRight = right.find(FieldSortSpecial)) != right.end() && itRight->second.asInteger() <= (int64_t)SortSpecialOnBottom)
-    rightSortSpecial = (SortSpecial)itRight->second.asInteger();
-  
-  // one has a special sort
-  if (leftSortSpecial != rightSortSpecial)
-  {
-    // left should be sorted on top
-    // or right should be sorted on bottom
-    // => left is sorted above right
-    if (leftSortSpecial == SortSpecialOnTop ||
-        rightSortSpecial == SortSpecialOnBottom)
-    {
-      result = true;
-      return true;
-    }
-    
-    // otherwise right is sorted above left
-    result = false;
-    return true;
-  }
-  // both have either sort on top or sort on bottom -> leave as-is
-  else if (leftSortSpecial != SortSpecialNone && leftSortSpecial == rightSortSpecial)
-  {
-    result = false;
-    return true;
+    return left < right;
   }
 
-  if (handleFolder)
+private:
+  int Compare(const SortKey &left, const SortKey &right) const
   {
-    itLeft = left.find(FieldFolder);
-    itRight = right.find(FieldFolder);
-    if (itLeft != left.end() && itRight != right.end() &&
-        itLeft->second.asBoolean() != itRight->second.asBoolean())
+    // one has a special sort
+    if (left.special != right.special)
     {
-      result = itLeft->second.asBoolean();
-      return true;
+      // left should be sorted on top
+      // or right should be sorted on bottom
+      // => left is sorted above right
+      if (left.special == SortSpecialOnTop ||
+          right.special == SortSpecialOnBottom)
+        return -1;
+
+      // otherwise right is sorted above left
+      return 1;
     }
-  }
+    // both have either sort on top or sort on bottom -> leave as-is
+    else if (left.special != SortSpecialNone)
+      return 0;
 
-  labelLeft = itLeftSort->second.asWideString();
-  labelRight = itRightSort->second.asWideString();
+    if (m_handleFolders && left.folder >= 0 && right.folder >= 0 &&
+        left.folder != right.folder)
+      return left.folder ? -1 : 1;
 
-  return false;
-}
+    int64_t result = StringUtils::AlphaNumericCompare(left.label.c_str(), right.label.c_str());
+    if (result == 0)
+      return 0;
 
-bool SorterAscending(const SortItem &left, const SortItem &right)
-{
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, true, result, labelLeft, labelRight))
-    return result;
-
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) < 0;
-}
-
-bool SorterDescending(const SortItem &left, const SortItem &right)
-{
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, true, result, labelLeft, labelRight))
-    return result;
-
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) > 0;
-}
-
-bool SorterIgnoreFoldersAscending(const SortItem &left, const SortItem &right)
-{
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, false, result, labelLeft, labelRight))
-    return result;
-
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) < 0;
-}
-
-bool SorterIgnoreFoldersDescending(const SortItem &left, const SortItem &right)
-{
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, false, result, labelLeft, labelRight))
-    return result;
+    return (result < 0) != m_descending ? -1 : 1;
+  }
 
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) > 0;
-}
+  const vector<SortKey> &m_keys;
+  bool m_descending;
+  bool m_handleFolders;
+};
 
 map<SortBy, SortUtils::SortPreparator> fillPreparators()
 {
@@ -644,46 +608,92 @@ map<SortBy, Fields> SortUtils::m_sortingFields = fillSortingFields();
 
 void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attributes, SortItems& items, int limitEnd /* = -1 */, int limitStart /* = 0 */)
 {
+  vector<size_t> order;
+  Sort(sortBy, sortOrder, attributes, items, order, limitEnd, limitStart);
+
+  // apply the permutation in one go, swapping the maps instead of copying them
+  SortItems sortedItems(order.size());
+  for (size_t index = 0; index < order.size(); index++)
+    sortedItems[index].swap(items[order[index]]);
+
+  items.swap(sortedItems);
+}
+
+void SortUtils::Sort(const SortDescription &sortDescription, SortItems& items)
+{
+  Sort(sortDescription.sortBy, sortDescription.sortOrder, sortDescription.sortAttributes, items, sortDescription.limitEnd, sortDescription.limitStart);
+}
+
+void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attributes, SortItems& items, vector<size_t>& order, int limitEnd /* = -1 */, int limitStart /* = 0 */)
+{
+  size_t count = items.size();
+
+  // work out which part of the sorted list is kept
+  size_t start = 0, end = count;
+  if (limitStart > 0 && (size_t)limitStart < count)
+    start = limitStart;
+  if (limitEnd > (int)start && (size_t)limitEnd < count)
+    end = limitEnd;
+
+  order.resize(count);
+  for (size_t index = 0; index < count; index++)
+    order[index] = index;
+
+  SortPreparator preparator = NULL;
   if (sortBy != SortByNone)
+    preparator = getPreparator(sortBy);
+
+  if (preparator != NULL)
   {
-    // get the matching SortPreparator
-    SortPreparator preparator = getPreparator(sortBy);
-    if (preparator != NULL)
+    const Fields &sortingFields = GetFieldsForSorting(sortBy);
+
+    // extract the sort keys once so that the comparison never touches the maps
+    vector<SortKey> keys(count);
+    for (size_t index = 0; index < count; index++)
     {
-      Fields sortingFields = GetFieldsForSorting(sortBy);
+      SortItem &item = items[index];
 
-      // Prepare the string used for sorting and store it under FieldSort
-      for (SortItems::iterator item = items.begin(); item != items.end(); item++)
+      // add all fields to the item that are required for sorting if they are currently missing
+      for (Fields::const_iterator field = sortingFields.begin(); field != sortingFields.end(); field++)
       {
-        // add all fields to the item that are required for sorting if they are currently missing
-        for (Fields::const_iterator field = sortingFields.begin(); field != sortingFields.end(); field++)
-        {
-          if (item->find(*field) == item->end())
-            item->insert(pair<Field, CVariant>(*field, CVariant::ConstNullVariant));
-        }
-
-        CStdStringW sortLabel;
-        g_charsetConverter.utf8ToW(preparator(attributes, *item), sortLabel, false);
-        item->insert(pair<Field, CVariant>(FieldSort, CVariant(sortLabel)));
+        if (item.find(*field) == item.end())
+          item.insert(pair<Field, CVariant>(*field, CVariant::ConstNullVariant));
       }
 
-      // Do the sorting
-      std::stable_sort(items.begin(), items.end(), getSorter(sortOrder, attributes));
+      SortKey &key = keys[index];
+      CStdStringW sortLabel;
+      g_charsetConverter.utf8ToW(preparator(attributes, item), sortLabel, false);
+      key.label = sortLabel;
+
+      key.special = SortSpecialNone;
+      SortItem::const_iterator it = item.find(FieldSortSpecial);
+      if (it != item.end() && it->second.asInteger() <= (int64_t)SortSpecialOnBottom)
+        key.special = (SortSpecial)it->second.asInteger();
+
+      key.folder = -1;
+      if ((it = item.find(FieldFolder)) != item.end())
+        key.folder = it->second.asBoolean() ? 1 : 0;
     }
-  }
 
-  if (limitStart > 0 && (size_t)limitStart < items.size())
-  {
-    items.erase(items.begin(), items.begin() + limitStart);
-    limitEnd -= limitStart;
+    // sort the indices, only as far as the requested limit reaches
+    SortKeyComparator comparator(keys, sortOrder == SortOrderDescending, !(attributes & SortAttributeIgnoreFolders));
+    if (end < count)
+      std::partial_sort(order.begin(), order.begin() + end, order.end(), comparator);
+    else
+      std::sort(order.begin(), order.end(), comparator);
+
+    // only the items that are kept need their sort label
+    for (size_t index = start; index < end; index++)
+      items[order[index]].insert(pair<Field, CVariant>(FieldSort, CVariant(keys[order[index]].label)));
   }
-  if (limitEnd > 0 && (size_t)limitEnd < items.size())
-    items.erase(items.begin() + limitEnd, items.end());
+
+  order.erase(order.begin() + end, order.end());
+  order.erase(order.begin(), order.begin() + start);
 }
 
-void SortUtils::Sort(const SortDescription &sortDescription, SortItems& items)
+void SortUtils::Sort(const SortDescription &sortDescription, SortItems& items, vector<size_t>& order)
 {
-  Sort(sortDescription.sortBy, sortDescription.sortOrder, sortDescription.sortAttributes, items, sortDescription.limitEnd, sortDescription.limitStart);
+  Sort(sortDescription.sortBy, sortDescription.sortOrder, sortDescription.sortAttributes, items, order, sortDescription.limitEnd, sortDescription.limitStart);
 }
 
 bool SortUtils::SortFromDataset(const SortDescription &sortDescription, MediaType mediaType, const std::auto_ptr<dbiplus::Dataset> &dataset, DatabaseResults &results)
@@ -716,14 +726,6 @@ const SortUtils::SortPreparator& SortUtils::getPreparator(SortBy sortBy)
   return m_preparators[SortByNone];
 }
 
-SortUtils::Sorter SortUtils::getSorter(SortOrder sortOrder, SortAttribute attributes)
-{
-  if (attributes & SortAttributeIgnoreFolders)
-    return sortOrder == SortOrderDescending ? SorterIgnoreFoldersDescending : SorterIgnoreFoldersAscending;
-
-  return sortOrder == SortOrderDescending ? SorterDescending : SorterAscending;
-}
-
 const Fields& SortUtils::GetFieldsForSorting(SortBy sortBy)
 {
   map<SortBy, Fields>::const_iterator it = m_sortingFields.find(sortBy);
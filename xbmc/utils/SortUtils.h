@@ -21,6 +21,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "DatabaseUtils.h"
 
@@ -111,17 +112,25 @@ class SortUtils
 public:
   static void Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attributes, SortItems& items, int limitEnd = -1, int limitStart = 0);
   static void Sort(const SortDescription &sortDescription, SortItems& items);
+  /*!
+   \brief Sort the given items without reordering them.
+   The sort keys of all items are extracted into a flat array and only a list of
+   indices is sorted. If a limit is given the indices are only sorted as far as
+   the limit reaches. The items keep their position but the ones that are part
+   of the result get their FieldSort value.
+   \param order receives the indices of the resulting items in sorted order
+   */
+  static void Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attributes, SortItems& items, std::vector<size_t>& order, int limitEnd = -1, int limitStart = 0);
+  static void Sort(const SortDescription &sortDescription, SortItems& items, std::vector<size_t>& order);
   static bool SortFromDataset(const SortDescription &sortDescription, MediaType mediaType, const std::auto_ptr<dbiplus::Dataset> &dataset, DatabaseResults &results);
   
   static const Fields& GetFieldsForSorting(SortBy sortBy);
   static std::string RemoveArticles(const std::string &label);
   
   typedef std::string (*SortPreparator) (SortAttribute, const SortItem&);
-  typedef bool (*Sorter) (const SortItem&, const SortItem&);
   
 private:
   static const SortPreparator& getPreparator(SortBy sortBy);
-  static Sorter getSorter(SortOrder sortOrder, SortAttribute attributes);
 
   static std::map<SortBy, SortPreparator> m_preparators;
   static std::map<SortBy, Fields> m_sortingFields;
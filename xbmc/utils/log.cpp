@@ -24,8 +24,11 @@
 #include "stat_utf8.h"
 #include "threads/CriticalSection.h"
 #include "threads/SingleLock.h"
+#include "threads/Atomics.h"
 #include "threads/Thread.h"
 #include "utils/StdString.h"
+
+#include <vector>
 #if defined(TARGET_ANDROID)
 #include "android/activity/XBMCApp.h"
 #elif defined(TARGET_WINDOWS)
@@ -38,10 +41,187 @@
 #define m_repeatLogLevel XBMC_GLOBAL_USE(CLog::CLogGlobals).m_repeatLogLevel
 #define m_repeatLine XBMC_GLOBAL_USE(CLog::CLogGlobals).m_repeatLine
 #define m_logLevel XBMC_GLOBAL_USE(CLog::CLogGlobals).m_logLevel
+#define m_componentLevels XBMC_GLOBAL_USE(CLog::CLogGlobals).m_componentLevels
+#define m_queue XBMC_GLOBAL_USE(CLog::CLogGlobals).m_queue
+#define m_writer XBMC_GLOBAL_USE(CLog::CLogGlobals).m_writer
+#define m_async XBMC_GLOBAL_USE(CLog::CLogGlobals).m_async
+#define m_queueing XBMC_GLOBAL_USE(CLog::CLogGlobals).m_queueing
+#define m_asyncSection XBMC_GLOBAL_USE(CLog::CLogGlobals).m_asyncSection
+
+#define LOG_QUEUE_SLOTS     8192              // must be a power of two
+#define LOG_QUEUE_BYTES     (4 * 1024 * 1024) // memory the queued lines may take up
+#define LOG_WRITE_INTERVAL  100               // ms between writes of the queue
 
 static char levelNames[][8] =
 {"DEBUG", "INFO", "NOTICE", "WARNING", "ERROR", "SEVERE", "FATAL", "NONE"};
 
+/* a message as passed to CLog::Log(), waiting to be written out */
+class CLogRecord
+{
+public:
+  SYSTEMTIME time;
+  uint64_t   threadId;
+  int        level;
+  CStdString data;
+};
+
+/* bounded queue of log records with any number of lock free producers and a single consumer.
+   Each slot carries a sequence number telling whether it is free for the producer at that
+   position or filled for the consumer, so producers only contend on claiming a position. */
+class CLogQueue
+{
+public:
+  CLogQueue(unsigned long slots, long maxBytes)
+    : m_slots(slots), m_mask(slots - 1), m_enqueue(0), m_dequeue(0), m_bytes(0), m_maxBytes(maxBytes), m_dropped(0), m_reported(0)
+  {
+    for (unsigned long i = 0; i < slots; i++)
+    {
+      m_slots[i].sequence = (long)i;
+      m_slots[i].record = NULL;
+    }
+  }
+
+  /* queue a record, or drop it if the queue is full. Called from any thread. */
+  bool Push(CLogRecord *record)
+  {
+    long size = sizeof(CLogRecord) + record->data.size();
+    long bytes = AtomicAdd(&m_bytes, size);
+    if (bytes > m_maxBytes)
+      return Drop(size);
+
+    Slot *slot;
+    long pos = Read(&m_enqueue);
+    for (;;)
+    {
+      slot = &m_slots[pos & m_mask];
+      long diff = (long)((unsigned long)Read(&slot->sequence) - (unsigned long)pos);
+      if (diff == 0)
+      {
+        long current = cas(&m_enqueue, pos, Next(pos));
+        if (current == pos)
+          break;
+        pos = current;
+      }
+      else if (diff < 0)
+        return Drop(size);
+      else
+        pos = Read(&m_enqueue);
+    }
+    slot->record = record;
+    cas(&slot->sequence, pos, Next(pos)); // publish to the consumer
+
+    // don't leave it to the next interval if we're filling up fast
+    if (bytes > m_maxBytes / 2 && bytes - size <= m_maxBytes / 2)
+      m_pending.Set();
+    return true;
+  }
+
+  /* take the oldest record, NULL if there is none. Called from the writer only. */
+  CLogRecord *Pop()
+  {
+    Slot &slot = m_slots[m_dequeue & m_mask];
+    if (Read(&slot.sequence) != Next(m_dequeue))
+      return NULL;
+    CLogRecord *record = slot.record;
+    slot.record = NULL;
+    cas(&slot.sequence, Next(m_dequeue), Next(m_dequeue, m_slots.size())); // free for the producer a lap ahead
+    m_dequeue = Next(m_dequeue);
+    AtomicSubtract(&m_bytes, sizeof(CLogRecord) + record->data.size());
+    return record;
+  }
+
+  /* number of records dropped since the last call */
+  long TakeDropped()
+  {
+    long dropped = Read(&m_dropped);
+    long unreported = dropped - m_reported;
+    m_reported = dropped;
+    return unreported;
+  }
+
+  long Dropped() { return Read(&m_dropped); }
+
+  CEvent m_pending; ///< set when the writer shouldn't wait for the next interval
+
+private:
+  bool Drop(long size)
+  {
+    AtomicSubtract(&m_bytes, size);
+    AtomicIncrement(&m_dropped);
+    m_pending.Set();
+    return false;
+  }
+
+  /* read with a full barrier, so that the slot contents are seen once its sequence is */
+  static long Read(volatile long *value) { return cas(value, 0, 0); }
+  static long Next(long pos, unsigned long count = 1) { return (long)((unsigned long)pos + count); }
+
+  struct Slot
+  {
+    volatile long sequence;
+    CLogRecord   *record;
+  };
+
+  std::vector<Slot> m_slots;
+  unsigned long     m_mask;
+  volatile long     m_enqueue;
+  long              m_dequeue;
+  volatile long     m_bytes;
+  const long        m_maxBytes;
+  volatile long     m_dropped;
+  long              m_reported;
+};
+
+/* writes out the queued records in one go every LOG_WRITE_INTERVAL, so that logging threads
+   (and the render thread in particular) never wait on the disk */
+class CLogWriter : public CThread
+{
+public:
+  CLogWriter(CLogQueue &queue) : CThread("LogWriter"), m_logQueue(queue) {}
+
+  void Flush()
+  {
+    CSingleLock waitLock(critSec);
+    std::string lines;
+    CLogRecord *record;
+    while ((record = m_logQueue.Pop()) != NULL)
+    {
+      CLog::FormatLine(*record, lines);
+      delete record;
+    }
+
+    long dropped = m_logQueue.TakeDropped();
+    if (dropped)
+    {
+      CLogRecord warning;
+      GetLocalTime(&warning.time);
+      warning.threadId = CThread::GetCurrentThreadId();
+      warning.level = LOGWARNING;
+      warning.data.Format("Log queue full, dropped %ld lines", dropped);
+      CLog::FormatLine(warning, lines);
+    }
+
+    if (m_file && !lines.empty())
+    {
+      fwrite(lines.c_str(), lines.size(), 1, m_file);
+      fflush(m_file);
+    }
+  }
+
+protected:
+  virtual void Process()
+  {
+    while (!m_bStop)
+    {
+      AbortableWait(m_logQueue.m_pending, LOG_WRITE_INTERVAL);
+      Flush();
+    }
+  }
+
+private:
+  CLogQueue &m_logQueue;
+};
+
 CLog::CLog()
 {}
 
@@ -50,7 +230,8 @@ CLog::~CLog()
 
 void CLog::Close()
 {
-  
+  SetAsync(false);
+
   CSingleLock waitLock(critSec);
   if (m_file)
   {
@@ -62,76 +243,115 @@ void CLog::Close()
 
 void CLog::Log(int loglevel, const char *format, ... )
 {
-  static const char* prefixFormat = "%02.2d:%02.2d:%02.2d T:%"PRIu64" %7s: ";
+  if (!m_file || !IsLogged(loglevel))
+    return;
+
+  // queued records are handed to the writer, so only those go on the heap.
+  // while counted in m_queueing, SetAsync(false) waits for the record to be queued
+  // before it writes out the queue, and loggers never block each other.
+  AtomicIncrement(&m_queueing);
+  CLogRecord local;
+  CLogRecord *record = m_async ? new CLogRecord : &local;
+  if (record == &local)
+    AtomicDecrement(&m_queueing);
+  GetLocalTime(&record->time);
+  record->threadId = CThread::GetCurrentThreadId();
+  record->level = loglevel & LOGLEVELMASK;
+
+  va_list va;
+  va_start(va, format);
+  record->data.FormatV(format,va);
+  va_end(va);
+
+  if (record != &local)
+  { // the queue takes ownership, or drops the record
+    bool urgent = record->level >= LOGERROR;
+    if (!m_queue->Push(record))
+      delete record;
+    else if (urgent) // get errors to disk in case we're about to go down
+      m_queue->m_pending.Set();
+    AtomicDecrement(&m_queueing);
+    return;
+  }
+
+  std::string line;
   CSingleLock waitLock(critSec);
+  FormatLine(local, line);
+  if (m_file && !line.empty())
+  {
+    fputs(line.c_str(), m_file);
+    fflush(m_file);
+  }
+}
+
+bool CLog::IsLogged(int loglevel)
+{
+  int component = loglevel >> LOGCOMPONENTSHIFT;
+  if (component > 0 && component < LOGCOMPONENTS && m_componentLevels[component] >= 0)
+    return m_logLevel > LOG_LEVEL_NONE && (loglevel & LOGLEVELMASK) >= m_componentLevels[component];
+
 #if !(defined(_DEBUG) || defined(PROFILE))
-  if (m_logLevel > LOG_LEVEL_NORMAL ||
-     (m_logLevel > LOG_LEVEL_NONE && loglevel >= LOGNOTICE))
+  return m_logLevel > LOG_LEVEL_NORMAL ||
+        (m_logLevel > LOG_LEVEL_NONE && (loglevel & LOGLEVELMASK) >= LOGNOTICE);
+#else
+  return true;
 #endif
-  {
-    if (!m_file)
-      return;
+}
 
-    SYSTEMTIME time;
-    GetLocalTime(&time);
+void CLog::FormatLine(CLogRecord &record, std::string &out)
+{
+  static const char* prefixFormat = "%02.2d:%02.2d:%02.2d T:%"PRIu64" %7s: ";
+  const SYSTEMTIME &time = record.time;
+  CStdString &strData = record.data;
+  CStdString strPrefix;
 
-    CStdString strPrefix, strData;
+  if (m_repeatLogLevel == record.level && m_repeatLine == strData)
+  {
+    m_repeatCount++;
+    return;
+  }
+  else if (m_repeatCount)
+  {
+    CStdString strData2;
+    strPrefix.Format(prefixFormat, time.wHour, time.wMinute, time.wSecond, record.threadId, levelNames[m_repeatLogLevel]);
 
-    strData.reserve(16384);
-    va_list va;
-    va_start(va, format);
-    strData.FormatV(format,va);
-    va_end(va);
+    strData2.Format("Previous line repeats %d times." LINE_ENDING, m_repeatCount);
+    out += strPrefix;
+    out += strData2;
+    OutputDebugString(strData2);
+    m_repeatCount = 0;
+  }
 
-    if (m_repeatLogLevel == loglevel && m_repeatLine == strData)
-    {
-      m_repeatCount++;
-      return;
-    }
-    else if (m_repeatCount)
-    {
-      CStdString strData2;
-      strPrefix.Format(prefixFormat, time.wHour, time.wMinute, time.wSecond, (uint64_t)CThread::GetCurrentThreadId(), levelNames[m_repeatLogLevel]);
-
-      strData2.Format("Previous line repeats %d times." LINE_ENDING, m_repeatCount);
-      fputs(strPrefix.c_str(), m_file);
-      fputs(strData2.c_str(), m_file);
-      OutputDebugString(strData2);
-      m_repeatCount = 0;
-    }
-    
-    m_repeatLine      = strData;
-    m_repeatLogLevel  = loglevel;
+  m_repeatLine      = strData;
+  m_repeatLogLevel  = record.level;
 
-    unsigned int length = 0;
-    while ( length != strData.length() )
-    {
-      length = strData.length();
-      strData.TrimRight(" ");
-      strData.TrimRight('\n');
-      strData.TrimRight("\r");
-    }
+  unsigned int length = 0;
+  while ( length != strData.length() )
+  {
+    length = strData.length();
+    strData.TrimRight(" ");
+    strData.TrimRight('\n');
+    strData.TrimRight("\r");
+  }
 
-    if (!length)
-      return;
-    
-    OutputDebugString(strData);
+  if (!length)
+    return;
 
-    /* fixup newline alignment, number of spaces should equal prefix length */
-    strData.Replace("\n", LINE_ENDING"                                            ");
-    strData += LINE_ENDING;
+  OutputDebugString(strData);
 
-    strPrefix.Format(prefixFormat, time.wHour, time.wMinute, time.wSecond, (uint64_t)CThread::GetCurrentThreadId(), levelNames[loglevel]);
+  /* fixup newline alignment, number of spaces should equal prefix length */
+  strData.Replace("\n", LINE_ENDING"                                            ");
+  strData += LINE_ENDING;
+
+  strPrefix.Format(prefixFormat, time.wHour, time.wMinute, time.wSecond, record.threadId, levelNames[record.level]);
 
 //print to adb
 #if defined(TARGET_ANDROID) && defined(_DEBUG)
   CXBMCApp::android_printf("%s%s",strPrefix.c_str(), strData.c_str());
 #endif
 
-    fputs(strPrefix.c_str(), m_file);
-    fputs(strData.c_str(), m_file);
-    fflush(m_file);
-  }
+  out += strPrefix;
+  out += strData;
 }
 
 bool CLog::Init(const char* path)
@@ -218,6 +438,58 @@ int CLog::GetLogLevel()
   return m_logLevel;
 }
 
+void CLog::SetComponentLogLevel(int component, int level)
+{
+  component >>= LOGCOMPONENTSHIFT;
+  if (component <= 0 || component >= LOGCOMPONENTS)
+    return;
+
+  CSingleLock waitLock(critSec);
+  m_componentLevels[component] = level;
+}
+
+void CLog::SetAsync(bool async)
+{
+  CSingleLock asyncLock(m_asyncSection);
+  if (async == IsAsync())
+    return;
+
+  if (async)
+  {
+    if (!m_queue)
+      m_queue = new CLogQueue(LOG_QUEUE_SLOTS, LOG_QUEUE_BYTES);
+    m_writer = new CLogWriter(*m_queue);
+    m_writer->Create();
+    cas(&m_async, 0, 1);
+  }
+  else
+  {
+    // stop the writer first, it needs critSec to write out the queue
+    m_writer->StopThread();
+
+    // loggers switch to writing synchronously, and wait on critSec until the
+    // lines queued before are out, so the log stays in order
+    CSingleLock waitLock(critSec);
+    cas(&m_async, 1, 0);
+    while (cas(&m_queueing, 0, 0) != 0)
+      Sleep(0);
+
+    m_writer->Flush();
+    delete m_writer;
+    m_writer = NULL;
+  }
+}
+
+bool CLog::IsAsync()
+{
+  return m_async != 0;
+}
+
+long CLog::GetDroppedCount()
+{
+  return m_queue ? m_queue->Dropped() : 0;
+}
+
 void CLog::OutputDebugString(const std::string& line)
 {
 #if defined(_DEBUG) || defined(PROFILE)
@@ -33,6 +33,10 @@
 #define ATTRIB_LOG_FORMAT
 #endif
 
+class CLogRecord;
+class CLogQueue;
+class CLogWriter;
+
 class CLog
 {
 public:
@@ -40,12 +44,22 @@ public:
   class CLogGlobals
   {
   public:
-    CLogGlobals() : m_file(NULL), m_repeatCount(0), m_repeatLogLevel(-1), m_logLevel(LOG_LEVEL_DEBUG) {}
+    CLogGlobals() : m_file(NULL), m_repeatCount(0), m_repeatLogLevel(-1), m_logLevel(LOG_LEVEL_DEBUG), m_queue(NULL), m_writer(NULL), m_async(0), m_queueing(0)
+    {
+      for (int i = 0; i < LOGCOMPONENTS; i++)
+        m_componentLevels[i] = -1;
+    }
     FILE*       m_file;
     int         m_repeatCount;
     int         m_repeatLogLevel;
     std::string m_repeatLine;
     int         m_logLevel;
+    int         m_componentLevels[LOGCOMPONENTS]; ///< lowest message level logged per component, -1 to follow m_logLevel
+    CLogQueue*  m_queue;  ///< lines waiting for m_writer. Never freed, as logging threads may still be using it
+    CLogWriter* m_writer; ///< writes out m_queue in the background while logging asynchronously
+    volatile long m_async;     ///< non zero while Log() queues for m_writer
+    volatile long m_queueing;  ///< Log() calls that may be queueing, waited for when switching to synchronous
+    CCriticalSection m_asyncSection; ///< serialises SetAsync(), so only one writer drains m_queue
     CCriticalSection critSec;
   };
 
@@ -57,7 +71,30 @@ public:
   static bool Init(const char* path);
   static void SetLogLevel(int level);
   static int  GetLogLevel();
+
+  /*! \brief Set the lowest level of messages logged for a component
+   Messages of the component are filtered by this level instead of the global log level.
+   \param component one of the LOGPLAYER, LOGAUDIO, ... components.
+   \param level the lowest message level (LOGDEBUG ... LOGNONE) logged, or -1 to follow the global log level.
+   */
+  static void SetComponentLogLevel(int component, int level);
+
+  /*! \brief Switch between synchronous and asynchronous logging
+   When asynchronous, Log() formats the message and queues it without waiting on the file, and
+   a background thread writes out the queued lines a few times a second. If the queue is
+   full, messages are dropped and a count of them is written instead.
+   Switching back to synchronous logging writes out everything queued first.
+   */
+  static void SetAsync(bool async);
+  static bool IsAsync();
+
+  /*! \brief Number of messages dropped because the asynchronous queue was full
+   */
+  static long GetDroppedCount();
 private:
+  friend class CLogWriter;
+  static bool IsLogged(int loglevel);
+  static void FormatLine(CLogRecord &record, std::string &out);
   static void OutputDebugString(const std::string& line);
 };
 
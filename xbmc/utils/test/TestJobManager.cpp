@@ -21,6 +21,8 @@
 #include "utils/JobManager.h"
 #include "settings/GUISettings.h"
 #include "utils/SystemInfo.h"
+#include "threads/Event.h"
+#include "threads/SingleLock.h"
 
 #include "gtest/gtest.h"
 
@@ -79,6 +81,87 @@ TEST_F(TestJobManager, Pause)
   CJobManager::GetInstance().CancelJobs();
 }
 
+/* records the order the jobs start in, and keeps its slot until released if given an event to wait for */
+class CPauseOrderJob : public CJob
+{
+public:
+  CPauseOrderJob(const char *type, std::vector<std::string> &started, CCriticalSection &section, CEvent &event, CEvent *release = NULL)
+    : m_type(type), m_started(started), m_section(section), m_event(event), m_release(release) {}
+
+  virtual const char *GetType() const { return m_type; }
+  virtual bool DoWork()
+  {
+    {
+      CSingleLock lock(m_section);
+      m_started.push_back(m_type);
+      m_event.Set();
+    }
+    if (m_release)
+      m_release->Wait();
+    return true;
+  }
+
+private:
+  const char               *m_type;
+  std::vector<std::string> &m_started;
+  CCriticalSection         &m_section;
+  CEvent                   &m_event;
+  CEvent                   *m_release;
+};
+
+static bool WaitForStarted(std::vector<std::string> &started, CCriticalSection &section, CEvent &event, size_t count)
+{
+  for (unsigned int i = 0; i < 10; i++)
+  {
+    {
+      CSingleLock lock(section);
+      if (started.size() >= count)
+        return true;
+    }
+    event.WaitMSec(1000);
+  }
+  return false;
+}
+
+TEST_F(TestJobManager, PauseKeepsOrder)
+{
+  std::vector<std::string> started;
+  CCriticalSection section;
+  CEvent event;
+  CEvent release(true);
+
+  /* low priority jobs get three slots. all but one of them are taken, so the
+     jobs below run one after the other, in the order they leave the queue */
+  const unsigned int blockers = 2;
+  bool bBlocked = true;
+  for (unsigned int i = 0; i < blockers; i++)
+  {
+    /* one at a time, a worker that was just started only picks up one job */
+    CJobManager::GetInstance().AddJob(new CPauseOrderJob("blocker", started, section, event, &release), NULL);
+    bBlocked = WaitForStarted(started, section, event, i + 1) && bBlocked;
+  }
+  if (!bBlocked)
+    release.Set();
+  ASSERT_TRUE(bBlocked);
+
+  /* a paused low priority job holds up the ones behind it */
+  CJobManager::GetInstance().Pause("paused");
+  CJobManager::GetInstance().AddJob(new CPauseOrderJob("paused", started, section, event), NULL);
+  CJobManager::GetInstance().AddJob(new CPauseOrderJob("other", started, section, event), NULL);
+  EXPECT_FALSE(event.WaitMSec(100));
+
+  CJobManager::GetInstance().UnPause("paused");
+  bool bAllStarted = WaitForStarted(started, section, event, blockers + 2);
+  release.Set();
+  ASSERT_TRUE(bAllStarted);
+
+  /* once resumed, the paused job goes first and the one behind it follows */
+  CSingleLock lock(section);
+  ASSERT_EQ(blockers + 2, started.size());
+  EXPECT_EQ("paused", started[blockers]);
+  EXPECT_EQ("other", started[blockers + 1]);
+}
+
 TEST_F(TestJobManager, IsProcessing)
 {
   CJob* job = new CSysInfoJob();
@@ -0,0 +1,170 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "utils/JobManager.h"
+#include "utils/TimeUtils.h"
+#include "threads/Atomics.h"
+#include "threads/Event.h"
+#include "threads/SingleLock.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+/* Micro-benchmark for the job manager.  A number of submitter threads flood
+ * the manager with empty jobs, and we measure the time from AddJob() until the
+ * job starts running, as well as the overall job throughput.
+ *
+ * The benchmarks are disabled so they don't slow down make check, run them
+ * with --gtest_also_run_disabled_tests.
+ */
+
+static const unsigned int TOTAL_JOBS = 4096;
+
+class CBenchmarkStats : public IJobCallback
+{
+public:
+  CBenchmarkStats(unsigned int expected)
+  {
+    m_expected = expected;
+    m_completed = 0;
+    m_latencyTotal = 0;
+    m_latencyMax = 0;
+  }
+
+  void AddLatency(int64_t latency)
+  {
+    CSingleLock lock(m_section);
+    m_latencyTotal += latency;
+    if (latency > m_latencyMax)
+      m_latencyMax = latency;
+  }
+
+  virtual void OnJobComplete(unsigned int jobID, bool success, CJob *job)
+  {
+    if ((unsigned long)AtomicIncrement(&m_completed) == m_expected)
+      m_done.Set();
+  }
+
+  unsigned int     m_expected;
+  volatile long    m_completed;
+  int64_t          m_latencyTotal;
+  int64_t          m_latencyMax;
+  CCriticalSection m_section;
+  CEvent           m_done;
+};
+
+class CBenchmarkJob : public CJob
+{
+public:
+  CBenchmarkJob(CBenchmarkStats &stats) : m_stats(stats)
+  {
+    m_submitted = CurrentHostCounter();
+  }
+
+  virtual bool DoWork()
+  {
+    m_stats.AddLatency(CurrentHostCounter() - m_submitted);
+    return true;
+  }
+
+  virtual const char *GetType() const { return "benchmark"; }
+
+private:
+  CBenchmarkStats &m_stats;
+  int64_t          m_submitted;
+};
+
+class CBenchmarkSubmitter : public IRunnable
+{
+public:
+  CBenchmarkSubmitter(CBenchmarkStats &stats, unsigned int jobs, CJob::PRIORITY priority)
+    : m_stats(stats), m_jobs(jobs), m_priority(priority)
+  {
+  }
+
+  virtual void Run()
+  {
+    for (unsigned int i = 0; i < m_jobs; i++)
+      CJobManager::GetInstance().AddJob(new CBenchmarkJob(m_stats), &m_stats, m_priority);
+  }
+
+private:
+  CBenchmarkStats &m_stats;
+  unsigned int     m_jobs;
+  CJob::PRIORITY   m_priority;
+};
+
+static void RunBenchmark(unsigned int threads, CJob::PRIORITY priority)
+{
+  unsigned int jobsPerThread = TOTAL_JOBS / threads;
+  CBenchmarkStats stats(jobsPerThread * threads);
+
+  std::vector<CBenchmarkSubmitter*> submitters;
+  std::vector<CThread*> submitterThreads;
+  for (unsigned int i = 0; i < threads; i++)
+  {
+    submitters.push_back(new CBenchmarkSubmitter(stats, jobsPerThread, priority));
+    submitterThreads.push_back(new CThread(submitters.back(), "JobSubmitter"));
+  }
+
+  int64_t start = CurrentHostCounter();
+  for (unsigned int i = 0; i < threads; i++)
+    submitterThreads[i]->Create();
+
+  EXPECT_TRUE(stats.m_done.WaitMSec(60000));
+  int64_t elapsed = CurrentHostCounter() - start;
+
+  // the last callback may still be returning, so wait for it before the stats go out of scope
+  while (CJobManager::GetInstance().IsProcessing("benchmark") > 0)
+    XbmcThreads::ThreadSleep(1);
+
+  for (unsigned int i = 0; i < threads; i++)
+  {
+    submitterThreads[i]->StopThread();
+    delete submitterThreads[i];
+    delete submitters[i];
+  }
+
+  EXPECT_EQ((long)stats.m_expected, stats.m_completed);
+
+  double frequency = (double)CurrentHostFrequency();
+  double seconds = elapsed / frequency;
+  double meanLatency = stats.m_completed ? stats.m_latencyTotal * 1000000.0 / frequency / stats.m_completed : 0.0;
+  double maxLatency = stats.m_latencyMax * 1000000.0 / frequency;
+
+  std::cout << "Threads: " << testing::PrintToString(threads)
+            << " Priority: " << testing::PrintToString((int)priority)
+            << " Jobs/sec: " << testing::PrintToString(seconds > 0 ? stats.m_completed / seconds : 0.0)
+            << " Mean latency (us): " << testing::PrintToString(meanLatency)
+            << " Max latency (us): " << testing::PrintToString(maxLatency) << std::endl;
+}
+
+TEST(TestJobManagerPerformance, DISABLED_SubmitLatencyLow)
+{
+  for (unsigned int threads = 1; threads <= 64; threads *= 2)
+    RunBenchmark(threads, CJob::PRIORITY_LOW);
+}
+
+TEST(TestJobManagerPerformance, DISABLED_SubmitLatencyHigh)
+{
+  for (unsigned int threads = 1; threads <= 64; threads *= 2)
+    RunBenchmark(threads, CJob::PRIORITY_HIGH);
+}
@@ -19,6 +19,8 @@
  */
 
 #include "utils/SortUtils.h"
+#include "utils/StdString.h"
+#include "utils/StringUtils.h"
 #include "utils/Variant.h"
 
 #include "gtest/gtest.h"
@@ -115,6 +117,51 @@ TEST(TestSortUtils, Sort_SortDescription)
   EXPECT_STREQ("R Artist", items.at(6)[FieldArtist].asString().c_str());
 }
 
+static void FillArtists(SortItems &items, unsigned int count)
+{
+  for (unsigned int i = 0; i < count; i++)
+  {
+    CStdString artist;
+    artist.Format("Artist %u", (i * 7919) % count);
+    SortItem item;
+    item[FieldArtist] = artist;
+    item[FieldId] = i;
+    items.push_back(item);
+  }
+}
+
+TEST(TestSortUtils, Sort_Limit)
+{
+  SortItems items, limitedItems;
+  FillArtists(items, 200);
+  limitedItems = items;
+
+  SortUtils::Sort(SortByArtist, SortOrderDescending, SortAttributeNone, items);
+  SortUtils::Sort(SortByArtist, SortOrderDescending, SortAttributeNone, limitedItems, 30, 10);
+
+  ASSERT_EQ((size_t)20, limitedItems.size());
+  for (unsigned int i = 0; i < limitedItems.size(); i++)
+    EXPECT_EQ(items.at(i + 10)[FieldId].asInteger(), limitedItems.at(i)[FieldId].asInteger());
+}
+
+TEST(TestSortUtils, Sort_Order)
+{
+  SortItems items;
+  FillArtists(items, 50);
+
+  std::vector<size_t> order;
+  SortUtils::Sort(SortByArtist, SortOrderAscending, SortAttributeNone, items, order);
+
+  // the items stay where they are, only the order is returned
+  ASSERT_EQ((size_t)50, order.size());
+  for (unsigned int i = 0; i < items.size(); i++)
+    EXPECT_EQ((int64_t)i, items.at(i)[FieldId].asInteger());
+
+  for (unsigned int i = 1; i < order.size(); i++)
+    EXPECT_LT(StringUtils::AlphaNumericCompare(items.at(order[i - 1])[FieldSort].asWideString().c_str(),
+                                               items.at(order[i])[FieldSort].asWideString().c_str()), 0);
+}
+
 TEST(TestSortUtils, GetFieldsForSorting)
 {
   Fields fields;
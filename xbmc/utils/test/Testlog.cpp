@@ -22,11 +22,15 @@
 #include "utils/RegExp.h"
 #include "filesystem/File.h"
 #include "filesystem/SpecialProtocol.h"
+#include "threads/Thread.h"
+#include "utils/TimeUtils.h"
 
 #include "test/TestUtils.h"
 
 #include "gtest/gtest.h"
 
+#include <vector>
+
 class Testlog : public testing::Test
 {
 protected:
@@ -38,9 +42,65 @@ protected:
     g_log_globalsRef->m_repeatCount = 0;
     g_log_globalsRef->m_repeatLogLevel = -1;
     g_log_globalsRef->m_logLevel = LOG_LEVEL_DEBUG;
+    for (int i = 0; i < LOGCOMPONENTS; i++)
+      g_log_globalsRef->m_componentLevels[i] = -1;
+  }
+};
+
+static CStdString ReadLog(const CStdString &logfile)
+{
+  CStdString logstring;
+  char buf[4096];
+  unsigned int bytesread;
+  XFILE::CFile file;
+  if (file.Open(logfile))
+  {
+    while ((bytesread = file.Read(buf, sizeof(buf) - 1)) > 0)
+    {
+      buf[bytesread] = '\0';
+      logstring.append(buf);
+    }
+    file.Close();
+  }
+  return logstring;
+}
+
+class CLogThread : public CThread
+{
+public:
+  CLogThread(int lines) : CThread("TestLog"), m_lines(lines), m_ticks(0) {}
+
+  virtual void Process()
+  {
+    int64_t start = CurrentHostCounter();
+    for (int i = 0; i < m_lines; i++)
+      CLog::Log(LOGDEBUG, "log message %d from a benchmark thread, long enough to look like a real one", i);
+    m_ticks = CurrentHostCounter() - start;
   }
+
+  int     m_lines;
+  int64_t m_ticks; ///< spent in CLog::Log()
 };
 
+/* logs from several threads at once, returning the lines logged per second */
+static double LogFromThreads(int threads, int lines)
+{
+  std::vector<CLogThread*> loggers;
+  for (int i = 0; i < threads; i++)
+    loggers.push_back(new CLogThread(lines));
+
+  int64_t start = CurrentHostCounter();
+  for (int i = 0; i < threads; i++)
+    loggers[i]->Create();
+  for (int i = 0; i < threads; i++)
+    loggers[i]->StopThread();
+  int64_t ticks = CurrentHostCounter() - start;
+
+  for (int i = 0; i < threads; i++)
+    delete loggers[i];
+  return (double)threads * lines * CurrentHostFrequency() / ticks;
+}
+
 TEST_F(Testlog, Log)
 {
   CStdString logfile, logstring;
@@ -146,3 +206,116 @@ TEST_F(Testlog, SetLogLevel)
   CLog::Close();
   EXPECT_TRUE(XFILE::CFile::Delete(logfile));
 }
+
+TEST_F(Testlog, AsyncLog)
+{
+  CStdString logfile, logstring;
+  CRegExp regex;
+
+  logfile = CSpecialProtocol::TranslatePath("special://temp/") + "xbmc.log";
+  EXPECT_TRUE(CLog::Init(CSpecialProtocol::TranslatePath("special://temp/")));
+  CLog::SetAsync(true);
+  EXPECT_TRUE(CLog::IsAsync());
+
+  CLog::Log(LOGDEBUG, "debug log message");
+  CLog::Log(LOGWARNING, "warning log message");
+  CLog::Log(LOGNOTICE, "repeated log message");
+  CLog::Log(LOGNOTICE, "repeated log message");
+  CLog::Log(LOGNOTICE, "repeated log message");
+  CLog::Log(LOGERROR, "multi line\nlog message");
+
+  /* closing writes out everything queued */
+  CLog::Close();
+  EXPECT_FALSE(CLog::IsAsync());
+
+  logstring = ReadLog(logfile);
+  EXPECT_STREQ("\xEF\xBB\xBF", logstring.substr(0, 3).c_str());
+
+  EXPECT_TRUE(regex.RegComp("[0-9]{2}:[0-9]{2}:[0-9]{2} T:[0-9]+ +DEBUG: debug log message"));
+  EXPECT_GE(regex.RegFind(logstring), 0);
+  EXPECT_TRUE(regex.RegComp("WARNING: warning log message"));
+  EXPECT_GE(regex.RegFind(logstring), 0);
+  EXPECT_TRUE(regex.RegComp("NOTICE: Previous line repeats 2 times."));
+  EXPECT_GE(regex.RegFind(logstring), 0);
+  EXPECT_TRUE(regex.RegComp("ERROR: multi line\r?\n {44}log message"));
+  EXPECT_GE(regex.RegFind(logstring), 0);
+
+  /* and in order */
+  EXPECT_LT(logstring.Find("debug log message"), logstring.Find("warning log message"));
+  EXPECT_LT(logstring.Find("warning log message"), logstring.Find("multi line"));
+
+  EXPECT_TRUE(XFILE::CFile::Delete(logfile));
+}
+
+TEST_F(Testlog, SetAsyncFalse)
+{
+  CStdString logfile, logstring;
+
+  logfile = CSpecialProtocol::TranslatePath("special://temp/") + "xbmc.log";
+  EXPECT_TRUE(CLog::Init(CSpecialProtocol::TranslatePath("special://temp/")));
+  CLog::SetAsync(true);
+  CLog::Log(LOGDEBUG, "queued log message");
+
+  /* what was queued goes out before anything logged synchronously */
+  CLog::SetAsync(false);
+  EXPECT_FALSE(CLog::IsAsync());
+  CLog::Log(LOGDEBUG, "synchronous log message");
+  CLog::SetAsync(true);
+  CLog::Log(LOGDEBUG, "queued again log message");
+  CLog::Close();
+
+  logstring = ReadLog(logfile);
+  EXPECT_GE(logstring.Find("queued log message"), 0);
+  EXPECT_LT(logstring.Find("queued log message"), logstring.Find("synchronous log message"));
+  EXPECT_LT(logstring.Find("synchronous log message"), logstring.Find("queued again log message"));
+
+  EXPECT_TRUE(XFILE::CFile::Delete(logfile));
+}
+
+TEST_F(Testlog, SetComponentLogLevel)
+{
+  CStdString logfile, logstring;
+
+  logfile = CSpecialProtocol::TranslatePath("special://temp/") + "xbmc.log";
+  EXPECT_TRUE(CLog::Init(CSpecialProtocol::TranslatePath("special://temp/")));
+
+  CLog::SetComponentLogLevel(LOGAUDIO, LOGWARNING);
+  CLog::Log(LOGDEBUG | LOGAUDIO, "filtered audio message");
+  CLog::Log(LOGWARNING | LOGAUDIO, "audio warning message");
+  CLog::Log(LOGDEBUG | LOGVIDEO, "video debug message");
+  CLog::Log(LOGDEBUG, "general debug message");
+  CLog::Close();
+
+  logstring = ReadLog(logfile);
+  EXPECT_EQ(-1, logstring.Find("filtered audio message"));
+  EXPECT_GE(logstring.Find("WARNING: audio warning message"), 0);
+  EXPECT_GE(logstring.Find("DEBUG: video debug message"), 0);
+  EXPECT_GE(logstring.Find("DEBUG: general debug message"), 0);
+
+  EXPECT_TRUE(XFILE::CFile::Delete(logfile));
+}
+
+/* a benchmark, run it with --gtest_also_run_disabled_tests */
+TEST_F(Testlog, DISABLED_Throughput)
+{
+  const int threads = 4;
+  const int lines = 20000;
+  CStdString logfile;
+
+  logfile = CSpecialProtocol::TranslatePath("special://temp/") + "xbmc.log";
+  EXPECT_TRUE(CLog::Init(CSpecialProtocol::TranslatePath("special://temp/")));
+  double sync = LogFromThreads(threads, lines);
+
+  CLog::SetAsync(true);
+  long dropped = CLog::GetDroppedCount();
+  double async = LogFromThreads(threads, lines);
+  dropped = CLog::GetDroppedCount() - dropped;
+  CLog::Close();
+
+  std::cout << "Synchronous: " << testing::PrintToString((int)sync) << " lines/s" << std::endl;
+  std::cout << "Asynchronous: " << testing::PrintToString((int)async) << " lines/s, "
+            << testing::PrintToString(dropped) << " dropped" << std::endl;
+  EXPECT_GT(async, 0);
+
+  EXPECT_TRUE(XFILE::CFile::Delete(logfile));
+}
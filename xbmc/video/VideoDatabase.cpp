@@ -441,7 +441,6 @@ void CVideoDatabase::CreateViews()
 //********************************************************************************************************************************
 int CVideoDatabase::GetPathId(const CStdString& strPath)
 {
-  CStdString strSQL;
   try
   {
     int idPath=-1;
@@ -454,8 +453,9 @@ int CVideoDatabase::GetPathId(const CStdString& strPath)
 
     URIUtils::AddSlashAtEnd(strPath1);
 
-    strSQL=PrepareSQL("select idPath from path where strPath='%s'",strPath1.c_str());
-    m_pDS->query(strSQL.c_str());
+    m_pDS->prepare_statement("select idPath from path where strPath=?");
+    m_pDS->bind_text(1, strPath1);
+    m_pDS->query_prepared();
     if (!m_pDS->eof())
       idPath = m_pDS->fv("path.idPath").get_asInt();
 
@@ -464,7 +464,7 @@ int CVideoDatabase::GetPathId(const CStdString& strPath)
   }
   catch (...)
   {
-    CLog::Log(LOGERROR, "%s unable to getpath (%s)", __FUNCTION__, strSQL.c_str());
+    CLog::Log(LOGERROR, "%s unable to getpath (%s)", __FUNCTION__, strPath.c_str());
   }
   return -1;
 }
@@ -563,11 +563,11 @@ bool CVideoDatabase::GetPathsForTvShow(int idShow, set<int>& paths)
   return false;
 }
 
-int CVideoDatabase::RunQuery(const CStdString &sql)
+int CVideoDatabase::RunQuery(const CStdString &sql, bool streaming /* = false */)
 {
   unsigned int time = XbmcThreads::SystemClockMillis();
   int rows = -1;
-  if (m_pDS->query(sql.c_str()))
+  if (streaming ? m_pDS->query_streaming(sql) : m_pDS->query(sql.c_str()))
   {
     rows = m_pDS->num_rows();
     if (rows == 0)
@@ -606,7 +606,6 @@ bool CVideoDatabase::GetSubPaths(const CStdString &basepath, vector< pair<int,st
 
 int CVideoDatabase::AddPath(const CStdString& strPath, const CStdString &strDateAdded /*= "" */)
 {
-  CStdString strSQL;
   try
   {
     int idPath = GetPathId(strPath);
@@ -624,16 +623,20 @@ int CVideoDatabase::AddPath(const CStdString& strPath, const CStdString &strDate
 
     // only set dateadded if we got one
     if (!strDateAdded.empty())
-      strSQL=PrepareSQL("insert into path (idPath, strPath, strContent, strScraper, dateAdded) values (NULL,'%s','','', '%s')", strPath1.c_str(), strDateAdded.c_str());
+    {
+      m_pDS->prepare_statement("insert into path (idPath, strPath, strContent, strScraper, dateAdded) values (NULL,?,'','',?)");
+      m_pDS->bind_text(2, strDateAdded);
+    }
     else
-      strSQL=PrepareSQL("insert into path (idPath, strPath, strContent, strScraper) values (NULL,'%s','','')", strPath1.c_str());
-    m_pDS->exec(strSQL.c_str());
+      m_pDS->prepare_statement("insert into path (idPath, strPath, strContent, strScraper) values (NULL,?,'','')");
+    m_pDS->bind_text(1, strPath1);
+    m_pDS->exec_prepared();
     idPath = (int)m_pDS->lastinsertid();
     return idPath;
   }
   catch (...)
   {
-    CLog::Log(LOGERROR, "%s unable to addpath (%s)", __FUNCTION__, strSQL.c_str());
+    CLog::Log(LOGERROR, "%s unable to addpath (%s)", __FUNCTION__, strPath.c_str());
   }
   return -1;
 }
@@ -645,8 +648,9 @@ bool CVideoDatabase::GetPathHash(const CStdString &path, CStdString &hash)
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
-    CStdString strSQL=PrepareSQL("select strHash from path where strPath='%s'", path.c_str());
-    m_pDS->query(strSQL.c_str());
+    m_pDS->prepare_statement("select strHash from path where strPath=?");
+    m_pDS->bind_text(1, path);
+    m_pDS->query_prepared();
     if (m_pDS->num_rows() == 0)
       return false;
     hash = m_pDS->fv("strHash").get_asString();
@@ -660,10 +664,43 @@ bool CVideoDatabase::GetPathHash(const CStdString &path, CStdString &hash)
   return false;
 }
 
+bool CVideoDatabase::GetPathHashes(const CStdString &basePath, map<CStdString, CStdString> &hashes)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    CStdString strPath(basePath);
+    URIUtils::AddSlashAtEnd(strPath);
+    CStdString separator = strPath.Right(1);
+
+    // only the folders right below the base path, the ones further down end in a
+    // separator that is followed by more of the path. like may match a few paths
+    // too many if the base path holds wildcards, callers look up exact paths.
+    m_pDS->prepare_statement("select strPath,strHash from path where strPath like ? and strPath not like ?");
+    m_pDS->bind_text(1, strPath + "_%");
+    m_pDS->bind_text(2, strPath + "%" + separator + "_%");
+    m_pDS->query_prepared();
+    while (!m_pDS->eof())
+    {
+      hashes[m_pDS->fv("strPath").get_asString()] = m_pDS->fv("strHash").get_asString();
+      m_pDS->next();
+    }
+    m_pDS->close();
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s (%s) failed", __FUNCTION__, basePath.c_str());
+  }
+
+  return false;
+}
+
 //********************************************************************************************************************************
 int CVideoDatabase::AddFile(const CStdString& strFileNameAndPath)
 {
-  CStdString strSQL = "";
   try
   {
     int idFile;
@@ -677,9 +714,10 @@ int CVideoDatabase::AddFile(const CStdString& strFileNameAndPath)
     if (idPath < 0)
       return -1;
 
-    CStdString strSQL=PrepareSQL("select idFile from files where strFileName='%s' and idPath=%i", strFileName.c_str(),idPath);
-
-    m_pDS->query(strSQL.c_str());
+    m_pDS->prepare_statement("select idFile from files where strFileName=? and idPath=?");
+    m_pDS->bind_text(1, strFileName);
+    m_pDS->bind_int(2, idPath);
+    m_pDS->query_prepared();
     if (m_pDS->num_rows() > 0)
     {
       idFile = m_pDS->fv("idFile").get_asInt() ;
@@ -688,14 +726,16 @@ int CVideoDatabase::AddFile(const CStdString& strFileNameAndPath)
     }
     m_pDS->close();
 
-    strSQL=PrepareSQL("insert into files (idFile, idPath, strFileName) values(NULL, %i, '%s')", idPath, strFileName.c_str());
-    m_pDS->exec(strSQL.c_str());
+    m_pDS->prepare_statement("insert into files (idFile, idPath, strFileName) values(NULL, ?, ?)");
+    m_pDS->bind_int(1, idPath);
+    m_pDS->bind_text(2, strFileName);
+    m_pDS->exec_prepared();
     idFile = (int)m_pDS->lastinsertid();
     return idFile;
   }
   catch (...)
   {
-    CLog::Log(LOGERROR, "%s unable to addfile (%s)", __FUNCTION__, strSQL.c_str());
+    CLog::Log(LOGERROR, "%s unable to addfile (%s)", __FUNCTION__, strFileNameAndPath.c_str());
   }
   return -1;
 }
@@ -790,8 +830,10 @@ bool CVideoDatabase::SetPathHash(const CStdString &path, const CStdString &hash)
     int idPath = AddPath(path);
     if (idPath < 0) return false;
 
-    CStdString strSQL=PrepareSQL("update path set strHash='%s' where idPath=%ld", hash.c_str(), idPath);
-    m_pDS->exec(strSQL.c_str());
+    m_pDS->prepare_statement("update path set strHash=? where idPath=?");
+    m_pDS->bind_text(1, hash);
+    m_pDS->bind_int(2, idPath);
+    m_pDS->exec_prepared();
 
     return true;
   }
@@ -896,9 +938,10 @@ int CVideoDatabase::GetFileId(const CStdString& strFilenameAndPath)
     int idPath = GetPathId(strPath);
     if (idPath >= 0)
     {
-      CStdString strSQL;
-      strSQL=PrepareSQL("select idFile from files where strFileName='%s' and idPath=%i", strFileName.c_str(),idPath);
-      m_pDS->query(strSQL.c_str());
+      m_pDS->prepare_statement("select idFile from files where strFileName=? and idPath=?");
+      m_pDS->bind_text(1, strFileName);
+      m_pDS->bind_int(2, idPath);
+      m_pDS->query_prepared();
       if (m_pDS->num_rows() > 0)
       {
         int idFile = m_pDS->fv("files.idFile").get_asInt();
@@ -3443,6 +3486,201 @@ void CVideoDatabase::GetCast(const CStdString &table, const CStdString &table_id
   }
 }
 
+bool CVideoDatabase::GetLinkedDetails(CFileItemList &items)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS2.get()) return false;
+
+    VideoTagMap movies, tvshows, episodes, episodeShows;
+    for (int i = 0; i < items.Size(); i++)
+    {
+      if (!items[i]->HasVideoInfoTag())
+        continue;
+
+      CVideoInfoTag *tag = items[i]->GetVideoInfoTag();
+      if (tag->m_iDbId <= 0)
+        continue;
+
+      // reset whatever we are about to fill in, just as GetMovieInfo() and friends replace it
+      if (tag->m_type.Equals("movie"))
+      {
+        movies[tag->m_iDbId].push_back(tag);
+        tag->m_tags.clear();
+        tag->m_showLink.clear();
+      }
+      else if (tag->m_type.Equals("tvshow"))
+      {
+        tvshows[tag->m_iDbId].push_back(tag);
+        tag->m_tags.clear();
+      }
+      else if (tag->m_type.Equals("episode"))
+      {
+        episodes[tag->m_iDbId].push_back(tag);
+        episodeShows[tag->m_iIdShow].push_back(tag);
+        tag->m_fEpBookmark = 0;
+      }
+      else
+        continue;
+
+      tag->m_cast.clear();
+      if (tag->m_strPictureURL.m_url.empty())
+        tag->m_strPictureURL.Parse();
+    }
+
+    unsigned int time = XbmcThreads::SystemClockMillis();
+    GetCast("movie", "idMovie", movies);
+    GetCast("tvshow", "idShow", tvshows);
+    // episodes list their own cast first, followed by the cast of the show
+    GetCast("episode", "idEpisode", episodes);
+    GetCast("tvshow", "idShow", episodeShows);
+    castTime += XbmcThreads::SystemClockMillis() - time;
+
+    GetTags("movie", movies);
+    GetTags("tvshow", tvshows);
+    GetShowLinks(movies);
+    GetEpisodeBookmarks(episodes);
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+  }
+  return false;
+}
+
+CStdString CVideoDatabase::GetIdList(const VideoTagMap &tags, VideoTagMap::const_iterator &it)
+{
+  CStdString ids;
+  for (unsigned int count = 0; it != tags.end() && count < 500; ++it, ++count)
+  {
+    if (count)
+      ids += ",";
+    ids.AppendFormat("%i", it->first);
+  }
+  return ids;
+}
+
+void CVideoDatabase::GetCast(const CStdString &table, const CStdString &table_id, const VideoTagMap &tags)
+{
+  VideoTagMap::const_iterator it = tags.begin();
+  while (it != tags.end())
+  {
+    CStdString ids = GetIdList(tags, it);
+    CStdString sql = PrepareSQL("SELECT actorlink%s.%s,"
+                                "  actors.strActor,"
+                                "  actorlink%s.strRole,"
+                                "  actors.strThumb,"
+                                "  art.url "
+                                "FROM actorlink%s"
+                                "  JOIN actors ON"
+                                "    actorlink%s.idActor=actors.idActor"
+                                "  LEFT JOIN art ON"
+                                "    art.media_id=actors.idActor AND art.media_type='actor' AND art.type='thumb' "
+                                "WHERE actorlink%s.%s IN (%s) "
+                                "ORDER BY actorlink%s.%s, actorlink%s.iOrder",
+                                table.c_str(), table_id.c_str(), table.c_str(), table.c_str(), table.c_str(),
+                                table.c_str(), table_id.c_str(), ids.c_str(), table.c_str(), table_id.c_str(), table.c_str());
+    m_pDS2->query(sql.c_str());
+    while (!m_pDS2->eof())
+    {
+      VideoTagMap::const_iterator owner = tags.find(m_pDS2->fv(0).get_asInt());
+      if (owner != tags.end())
+      {
+        SActorInfo info;
+        info.strName = m_pDS2->fv(1).get_asString();
+        info.strRole = m_pDS2->fv(2).get_asString();
+        info.thumbUrl.ParseString(m_pDS2->fv(3).get_asString());
+        info.thumb = m_pDS2->fv(4).get_asString();
+        for (vector<CVideoInfoTag*>::const_iterator tag = owner->second.begin(); tag != owner->second.end(); ++tag)
+        {
+          vector<SActorInfo> &cast = (*tag)->m_cast;
+          bool found = false;
+          for (vector<SActorInfo>::const_iterator i = cast.begin(); i != cast.end(); ++i)
+          {
+            if (i->strName == info.strName)
+            {
+              found = true;
+              break;
+            }
+          }
+          if (!found)
+            cast.push_back(info);
+        }
+      }
+      m_pDS2->next();
+    }
+    m_pDS2->close();
+  }
+}
+
+void CVideoDatabase::GetTags(const CStdString &mediaType, const VideoTagMap &tags)
+{
+  VideoTagMap::const_iterator it = tags.begin();
+  while (it != tags.end())
+  {
+    CStdString ids = GetIdList(tags, it);
+    CStdString sql = PrepareSQL("SELECT taglinks.idMedia, tag.strTag FROM tag, taglinks WHERE taglinks.idMedia IN (%s) AND taglinks.media_type = '%s' AND taglinks.idTag = tag.idTag ORDER BY taglinks.idMedia, tag.idTag", ids.c_str(), mediaType.c_str());
+    m_pDS2->query(sql.c_str());
+    while (!m_pDS2->eof())
+    {
+      VideoTagMap::const_iterator owner = tags.find(m_pDS2->fv(0).get_asInt());
+      if (owner != tags.end())
+      {
+        for (vector<CVideoInfoTag*>::const_iterator tag = owner->second.begin(); tag != owner->second.end(); ++tag)
+          (*tag)->m_tags.push_back(m_pDS2->fv(1).get_asString());
+      }
+      m_pDS2->next();
+    }
+    m_pDS2->close();
+  }
+}
+
+void CVideoDatabase::GetShowLinks(const VideoTagMap &movies)
+{
+  VideoTagMap::const_iterator it = movies.begin();
+  while (it != movies.end())
+  {
+    CStdString ids = GetIdList(movies, it);
+    CStdString sql = PrepareSQL("SELECT movielinktvshow.idMovie, tvshow.c%02d FROM movielinktvshow JOIN tvshow ON tvshow.idShow=movielinktvshow.idShow WHERE movielinktvshow.idMovie IN (%s) ORDER BY movielinktvshow.idMovie, movielinktvshow.idShow", VIDEODB_ID_TV_TITLE, ids.c_str());
+    m_pDS2->query(sql.c_str());
+    while (!m_pDS2->eof())
+    {
+      VideoTagMap::const_iterator owner = movies.find(m_pDS2->fv(0).get_asInt());
+      if (owner != movies.end())
+      {
+        for (vector<CVideoInfoTag*>::const_iterator tag = owner->second.begin(); tag != owner->second.end(); ++tag)
+          (*tag)->m_showLink.push_back(m_pDS2->fv(1).get_asString());
+      }
+      m_pDS2->next();
+    }
+    m_pDS2->close();
+  }
+}
+
+void CVideoDatabase::GetEpisodeBookmarks(const VideoTagMap &episodes)
+{
+  VideoTagMap::const_iterator it = episodes.begin();
+  while (it != episodes.end())
+  {
+    CStdString ids = GetIdList(episodes, it);
+    CStdString sql = PrepareSQL("SELECT episode.idEpisode, bookmark.timeInSeconds FROM bookmark JOIN episode ON episode.c%02d=bookmark.idBookmark WHERE episode.idEpisode IN (%s) AND bookmark.type=%i", VIDEODB_ID_EPISODE_BOOKMARK, ids.c_str(), CBookmark::EPISODE);
+    m_pDS2->query(sql.c_str());
+    while (!m_pDS2->eof())
+    {
+      VideoTagMap::const_iterator owner = episodes.find(m_pDS2->fv(0).get_asInt());
+      if (owner != episodes.end())
+      {
+        for (vector<CVideoInfoTag*>::const_iterator tag = owner->second.begin(); tag != owner->second.end(); ++tag)
+          (*tag)->m_fEpBookmark = m_pDS2->fv(1).get_asFloat();
+      }
+      m_pDS2->next();
+    }
+    m_pDS2->close();
+  }
+}
+
 /// \brief GetVideoSettings() obtains any saved video settings for the current file.
 /// \retval Returns true if the settings exist, false otherwise.
 bool CVideoDatabase::GetVideoSettings(const CStdString &strFilenameAndPath, CVideoSettings &settings)
@@ -5760,7 +5998,9 @@ bool CVideoDatabase::GetMoviesByWhere(const CStdString& strBaseDir, const Filter
 
     strSQL = PrepareSQL(strSQL, !extFilter.fields.empty() ? extFilter.fields.c_str() : "*") + strSQLExtra;
 
-    int iRowsFound = RunQuery(strSQL);
+    // rows that don't need sorting here are read straight from the database
+    bool streaming = sorting.sortBy == SortByNone && setItems.Size() == 0;
+    int iRowsFound = RunQuery(strSQL, streaming);
     if (iRowsFound <= 0 && setItems.Size() == 0)
       return iRowsFound == 0;
 
@@ -5771,34 +6011,34 @@ bool CVideoDatabase::GetMoviesByWhere(const CStdString& strBaseDir, const Filter
     items.SetProperty("total", total);
     
     DatabaseResults results;
-    results.reserve(iRowsFound);
-
-    // Add the previously retrieved sets
-    for (int index = 0; index < setItems.Size(); index++)
+    if (!streaming)
     {
-      DatabaseResult result;
-      setItems[index]->ToSortable(result);
-      result[FieldRow] = (unsigned int)index;
-      results.push_back(result);
-    }
+      results.reserve(iRowsFound);
 
-    if (!SortUtils::SortFromDataset(sorting, MediaTypeMovie, m_pDS, results))
-      return false;
+      // Add the previously retrieved sets
+      for (int index = 0; index < setItems.Size(); index++)
+      {
+        DatabaseResult result;
+        setItems[index]->ToSortable(result);
+        result[FieldRow] = (unsigned int)index;
+        results.push_back(result);
+      }
+
+      if (!SortUtils::SortFromDataset(sorting, MediaTypeMovie, m_pDS, results))
+        return false;
+    }
 
     // get data from returned rows
     items.Reserve(results.size());
-    const query_data &data = m_pDS->get_result_set().records;
-    for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); it++)
+    unsigned int index = 0, targetRow;
+    const dbiplus::sql_record *record;
+    while (DatabaseUtils::GetNextRecord(m_pDS, results, index, targetRow, record, setItems.Size()))
     {
-      unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
       if (targetRow < (unsigned int)setItems.Size())
       {
         items.Add(setItems[targetRow]);
         continue;
       }
-      targetRow -= setItems.Size();
-
-      const dbiplus::sql_record* const record = data.at(targetRow);
 
       CVideoInfoTag movie = GetDetailsForMovie(record);
       if (g_settings.GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE ||
@@ -5817,6 +6057,10 @@ bool CVideoDatabase::GetMoviesByWhere(const CStdString& strBaseDir, const Filter
       }
     }
 
+    // a streamed query only knows how many rows it had once they have all been read
+    if (streaming && total < m_pDS->num_rows())
+      items.SetProperty("total", m_pDS->num_rows());
+
     // cleanup
     m_pDS->close();
     return true;
@@ -5885,7 +6129,9 @@ bool CVideoDatabase::GetTvShowsByWhere(const CStdString& strBaseDir, const Filte
 
     strSQL = PrepareSQL(strSQL, !extFilter.fields.empty() ? extFilter.fields.c_str() : "*") + strSQLExtra;
 
-    int iRowsFound = RunQuery(strSQL);
+    // rows that don't need sorting here are read straight from the database
+    bool streaming = sorting.sortBy == SortByNone;
+    int iRowsFound = RunQuery(strSQL, streaming);
     if (iRowsFound <= 0)
       return iRowsFound == 0;
 
@@ -5895,18 +6141,19 @@ bool CVideoDatabase::GetTvShowsByWhere(const CStdString& strBaseDir, const Filte
     items.SetProperty("total", total);
     
     DatabaseResults results;
-    results.reserve(iRowsFound);
-    if (!SortUtils::SortFromDataset(sorting, MediaTypeTvShow, m_pDS, results))
-      return false;
+    if (!streaming)
+    {
+      results.reserve(iRowsFound);
+      if (!SortUtils::SortFromDataset(sorting, MediaTypeTvShow, m_pDS, results))
+        return false;
+    }
 
     // get data from returned rows
     items.Reserve(results.size());
-    const query_data &data = m_pDS->get_result_set().records;
-    for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); it++)
+    unsigned int index = 0, targetRow;
+    const dbiplus::sql_record *record;
+    while (DatabaseUtils::GetNextRecord(m_pDS, results, index, targetRow, record))
     {
-      unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
-      
       CVideoInfoTag movie = GetDetailsForTvShow(record, false);
       if ((g_settings.GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE ||
            g_passwordManager.bMasterUser                                     ||
@@ -5933,6 +6180,10 @@ bool CVideoDatabase::GetTvShowsByWhere(const CStdString& strBaseDir, const Filte
       }
     }
 
+    // a streamed query only knows how many rows it had once they have all been read
+    if (streaming && total < m_pDS->num_rows())
+      items.SetProperty("total", m_pDS->num_rows());
+
     Stack(items, VIDEODB_CONTENT_TVSHOWS, !filter.order.empty() || sorting.sortBy != SortByNone);
 
     // cleanup
@@ -6206,7 +6457,9 @@ bool CVideoDatabase::GetEpisodesByWhere(const CStdString& strBaseDir, const Filt
 
     strSQL = PrepareSQL(strSQL, !extFilter.fields.empty() ? extFilter.fields.c_str() : "*") + strSQLExtra;
 
-    int iRowsFound = RunQuery(strSQL);
+    // rows that don't need sorting here are read straight from the database
+    bool streaming = sorting.sortBy == SortByNone;
+    int iRowsFound = RunQuery(strSQL, streaming);
     if (iRowsFound <= 0)
       return iRowsFound == 0;
 
@@ -6216,20 +6469,21 @@ bool CVideoDatabase::GetEpisodesByWhere(const CStdString& strBaseDir, const Filt
     items.SetProperty("total", total);
     
     DatabaseResults results;
-    results.reserve(iRowsFound);
-    if (!SortUtils::SortFromDataset(sorting, MediaTypeEpisode, m_pDS, results))
-      return false;
+    if (!streaming)
+    {
+      results.reserve(iRowsFound);
+      if (!SortUtils::SortFromDataset(sorting, MediaTypeEpisode, m_pDS, results))
+        return false;
+    }
     
     // get data from returned rows
     items.Reserve(results.size());
     CLabelFormatter formatter("%H. %T", "");
 
-    const query_data &data = m_pDS->get_result_set().records;
-    for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); it++)
+    unsigned int index = 0, targetRow;
+    const dbiplus::sql_record *record;
+    while (DatabaseUtils::GetNextRecord(m_pDS, results, index, targetRow, record))
     {
-      unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
-
       CVideoInfoTag movie = GetDetailsForEpisode(record);
       if (g_settings.GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE ||
           g_passwordManager.bMasterUser                                     ||
@@ -6256,6 +6510,10 @@ bool CVideoDatabase::GetEpisodesByWhere(const CStdString& strBaseDir, const Filt
       }
     }
 
+    // a streamed query only knows how many rows it had once they have all been read
+    if (streaming && total < m_pDS->num_rows())
+      items.SetProperty("total", m_pDS->num_rows());
+
     // cleanup
     m_pDS->close();
     return true;
@@ -7060,7 +7318,9 @@ bool CVideoDatabase::GetMusicVideosByWhere(const CStdString &baseDir, const Filt
 
     strSQL = PrepareSQL(strSQL, !extFilter.fields.empty() ? extFilter.fields.c_str() : "*") + strSQLExtra;
 
-    int iRowsFound = RunQuery(strSQL);
+    // rows that don't need sorting here are read straight from the database
+    bool streaming = sorting.sortBy == SortByNone;
+    int iRowsFound = RunQuery(strSQL, streaming);
     if (iRowsFound <= 0)
       return iRowsFound == 0;
 
@@ -7070,19 +7330,20 @@ bool CVideoDatabase::GetMusicVideosByWhere(const CStdString &baseDir, const Filt
     items.SetProperty("total", total);
     
     DatabaseResults results;
-    results.reserve(iRowsFound);
-    if (!SortUtils::SortFromDataset(sorting, MediaTypeMusicVideo, m_pDS, results))
-      return false;
+    if (!streaming)
+    {
+      results.reserve(iRowsFound);
+      if (!SortUtils::SortFromDataset(sorting, MediaTypeMusicVideo, m_pDS, results))
+        return false;
+    }
     
     // get data from returned rows
     items.Reserve(results.size());
     // get songs from returned subtable
-    const query_data &data = m_pDS->get_result_set().records;
-    for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); it++)
+    unsigned int index = 0, targetRow;
+    const dbiplus::sql_record *record;
+    while (DatabaseUtils::GetNextRecord(m_pDS, results, index, targetRow, record))
     {
-      unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
-      
       CVideoInfoTag musicvideo = GetDetailsForMusicVideo(record);
       if (!checkLocks || g_settings.GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE || g_passwordManager.bMasterUser ||
           g_passwordManager.IsDatabasePathUnlocked(musicvideo.m_strPath, g_settings.m_videoSources))
@@ -7099,6 +7360,10 @@ bool CVideoDatabase::GetMusicVideosByWhere(const CStdString &baseDir, const Filt
       }
     }
 
+    // a streamed query only knows how many rows it had once they have all been read
+    if (streaming && total < m_pDS->num_rows())
+      items.SetProperty("total", m_pDS->num_rows());
+
     // cleanup
     m_pDS->close();
     return true;
@@ -435,6 +435,15 @@ public:
   bool GetSetInfo(int idSet, CVideoInfoTag& details);
   bool GetFileInfo(const CStdString& strFilenameAndPath, CVideoInfoTag& details, int idFile = -1);
 
+  /*! \brief Fetch the cast and other linked details for a list of movies, tvshows and episodes
+   Fills in what GetMovieInfo(), GetTvShowInfo() and GetEpisodeInfo() add to the details of a listing
+   (cast, tags, linked tvshows and episode bookmarks) with a single query per link table for the
+   whole list, rather than several queries per item.
+   \param items the items to fill in, as retrieved by GetMoviesByWhere(), GetTvShowsByWhere() or GetEpisodesByWhere()
+   \return true on success, false otherwise
+   */
+  bool GetLinkedDetails(CFileItemList &items);
+
   int GetPathId(const CStdString& strPath);
   int GetTvShowId(const CStdString& strPath);
   int GetEpisodeId(const CStdString& strFilenameAndPath, int idEpisode=-1, int idSeason=-1); // idEpisode, idSeason are used for multipart episodes as hints
@@ -526,6 +535,13 @@ public:
   // scanning hashes and paths scanned
   bool SetPathHash(const CStdString &path, const CStdString &hash);
   bool GetPathHash(const CStdString &path, CStdString &hash);
+
+  /*! \brief Retrieve the hashes of the folders directly below a folder in one go
+   \param basePath folder to retrieve the hashes of subfolders for. Neither the folder itself nor anything deeper is returned.
+   \param hashes [out] map of path to hash.
+   \return true on success, false otherwise.
+   */
+  bool GetPathHashes(const CStdString &basePath, std::map<CStdString, CStdString> &hashes);
   bool GetPaths(std::set<CStdString> &paths);
   bool GetPathsForTvShow(int idShow, std::set<int>& paths);
 
@@ -759,6 +775,20 @@ protected:
   bool GetNavCommon(const CStdString& strBaseDir, CFileItemList& items, const CStdString& type, int idContent=-1, const Filter &filter = Filter(), bool countOnly = false);
   void GetCast(const CStdString &table, const CStdString &table_id, int type_id, std::vector<SActorInfo> &cast);
 
+  typedef std::map<int, std::vector<CVideoInfoTag*> > VideoTagMap;
+  /*! \brief Bulk versions of GetCast() and friends used by GetLinkedDetails()
+   Each fills in the details of all tags in the map, keyed by the id in the link table.
+   */
+  void GetCast(const CStdString &table, const CStdString &table_id, const VideoTagMap &tags);
+  void GetTags(const CStdString &mediaType, const VideoTagMap &tags);
+  void GetShowLinks(const VideoTagMap &movies);
+  void GetEpisodeBookmarks(const VideoTagMap &episodes);
+  /*! \brief Get a comma separated list of the next (at most 500) ids of a tag map, for use in an IN clause
+   \param tags the map to take the ids from.
+   \param it the first id to add, advanced past the last id added.
+   */
+  static CStdString GetIdList(const VideoTagMap &tags, VideoTagMap::const_iterator &it);
+
   void GetDetailsFromDB(std::auto_ptr<dbiplus::Dataset> &pDS, int min, int max, const SDbTableOffsets *offsets, CVideoInfoTag &details, int idxOffset = 2);
   void GetDetailsFromDB(const dbiplus::sql_record* const record, int min, int max, const SDbTableOffsets *offsets, CVideoInfoTag &details, int idxOffset = 2);
   CStdString GetValueString(const CVideoInfoTag &details, int min, int max, const SDbTableOffsets *offsets) const;
@@ -775,9 +805,10 @@ private:
   /*! \brief Run a query on the main dataset and return the number of rows
    If no rows are found we close the dataset and return 0.
    \param sql the sql query to run
-   \return the number of rows, -1 for an error.
+   \param streaming whether to stream the rows rather than read them all up front, see dbiplus::Dataset::query_streaming.
+   \return the number of rows (only the rows fetched so far when streaming), -1 for an error.
    */
-  int RunQuery(const CStdString &sql);
+  int RunQuery(const CStdString &sql, bool streaming = false);
 
   /*! \brief Update routine for base path of videos
    Only required for videodb version < 59
@@ -0,0 +1,155 @@
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "VideoDirectoryCrawler.h"
+#include "VideoInfoScanner.h"
+#include "FileItem.h"
+#include "filesystem/Directory.h"
+#include "settings/Settings.h"
+#include "threads/Event.h"
+#include "threads/SingleLock.h"
+
+using namespace std;
+using namespace XFILE;
+
+namespace VIDEO
+{
+  /* shared between the job and the crawler so the job doesn't depend on the crawler
+     still being around when it runs */
+  class CVideoCrawlResult
+  {
+  public:
+    CVideoCrawlResult(const CStdString &path, const CStdString &dbHash)
+      : m_path(path), m_dbHash(dbHash), m_started(false), m_abandoned(false), m_listed(false), m_done(true) {}
+
+    const CStdString m_path;
+    const CStdString m_dbHash;
+
+    CCriticalSection m_section;
+    bool m_started;   ///< set by the job once it starts
+    bool m_abandoned; ///< set by the crawler if the results aren't wanted anymore
+
+    CStdString m_fastHash;
+    bool m_listed;
+    CFileItemList m_items;
+    CStdString m_hash;
+    CEvent m_done;
+  };
+
+  class CVideoCrawlJob : public CJob
+  {
+  public:
+    CVideoCrawlJob(const boost::shared_ptr<CVideoCrawlResult> &result) : m_result(result) {}
+
+    virtual bool DoWork()
+    {
+      CVideoCrawlResult &result = *m_result;
+      {
+        CSingleLock lock(result.m_section);
+        if (result.m_abandoned)
+          return false;
+        result.m_started = true;
+      }
+
+      // the same steps as CVideoInfoScanner::DoScan() takes for movie and music video folders
+      result.m_fastHash = CVideoInfoScanner::GetFastHash(result.m_path);
+      if (result.m_fastHash.IsEmpty() || result.m_fastHash != result.m_dbHash)
+      {
+        CDirectory::GetDirectory(result.m_path, result.m_items, g_settings.m_videoExtensions);
+        result.m_items.Stack();
+        CVideoInfoScanner::GetPathHash(result.m_items, result.m_hash);
+        result.m_listed = true;
+      }
+      result.m_done.Set();
+      return true;
+    }
+
+  private:
+    boost::shared_ptr<CVideoCrawlResult> m_result;
+  };
+
+  CVideoDirectoryCrawler::CVideoDirectoryCrawler(unsigned int jobsAtOnce)
+    : CJobQueue(false, jobsAtOnce, CJob::PRIORITY_NORMAL)
+  {
+  }
+
+  CVideoDirectoryCrawler::~CVideoDirectoryCrawler()
+  {
+    for (map<CStdString, CrawlResultPtr>::iterator i = m_results.begin(); i != m_results.end(); ++i)
+    {
+      CSingleLock lock(i->second->m_section);
+      i->second->m_abandoned = true;
+    }
+    CancelJobs();
+  }
+
+  void CVideoDirectoryCrawler::Prefetch(const CStdString &path, const CStdString &dbHash)
+  {
+    if (m_results.find(path) != m_results.end())
+      return;
+
+    CrawlResultPtr result(new CVideoCrawlResult(path, dbHash));
+    m_results.insert(make_pair(path, result));
+    AddJob(new CVideoCrawlJob(result));
+  }
+
+  bool CVideoDirectoryCrawler::Get(const CStdString &path, CStdString &fastHash, CFileItemList &items, CStdString &hash, bool &listed)
+  {
+    map<CStdString, CrawlResultPtr>::iterator i = m_results.find(path);
+    if (i == m_results.end())
+      return false;
+
+    CrawlResultPtr result = i->second;
+    m_results.erase(i);
+    {
+      CSingleLock lock(result->m_section);
+      if (!result->m_started)
+      { // not got to it yet - the scanner is quicker doing it itself than waiting on the queue
+        result->m_abandoned = true;
+        return false;
+      }
+    }
+
+    result->m_done.Wait();
+    fastHash = result->m_fastHash;
+    listed = result->m_listed;
+    if (listed)
+    {
+      items.Assign(result->m_items);
+      hash = result->m_hash;
+    }
+    return true;
+  }
+
+  void CVideoDirectoryCrawler::Discard(const CFileItemList &items)
+  {
+    for (int i = 0; i < items.Size(); ++i)
+    {
+      map<CStdString, CrawlResultPtr>::iterator result = m_results.find(items[i]->GetPath());
+      if (result == m_results.end())
+        continue;
+
+      CSingleLock lock(result->second->m_section);
+      result->second->m_abandoned = true;
+      lock.Leave();
+      m_results.erase(result);
+    }
+  }
+}
@@ -0,0 +1,79 @@
+#pragma once
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "utils/JobManager.h"
+#include "utils/StdString.h"
+
+#include <map>
+#include <boost/shared_ptr.hpp>
+
+class CFileItemList;
+
+namespace VIDEO
+{
+  class CVideoCrawlResult;
+
+  /*! \brief Lists and hashes folders ahead of the video scanner.
+
+   The scanner walks the tree one folder at a time, and for unchanged libraries
+   most of its time goes to stat'ing and listing folders on network shares.
+   The crawler does this for the subfolders of the folder being scanned on the
+   job manager, a bounded number at once, and hands the results to the scanner
+   when it gets to each folder. The results are those the scanner would compute
+   itself, so scanning order and outcome are unchanged.
+
+   All functions are to be called from the scanner thread.
+   */
+  class CVideoDirectoryCrawler : public CJobQueue
+  {
+  public:
+    CVideoDirectoryCrawler(unsigned int jobsAtOnce);
+    virtual ~CVideoDirectoryCrawler();
+
+    /*! \brief Queue a folder to be hashed and listed
+     \param path folder to crawl.
+     \param dbHash hash of the folder in the database. If the fast hash of the folder
+     matches it the folder is unchanged and isn't listed.
+     */
+    void Prefetch(const CStdString &path, const CStdString &dbHash);
+
+    /*! \brief Retrieve the results for a folder, waiting for it if it is being crawled.
+     Folders that haven't been started yet are dropped, so the scanner isn't held
+     up behind the rest of the queue.
+     \param path folder to retrieve the results for.
+     \param fastHash [out] fast hash of the folder, see CVideoInfoScanner::GetFastHash().
+     \param items [out] stacked listing of the folder, if listed.
+     \param hash [out] hash of the listing, see CVideoInfoScanner::GetPathHash(), if listed.
+     \param listed [out] whether the folder was listed.
+     \return true if results are available, false if the scanner should do the work itself.
+     */
+    bool Get(const CStdString &path, CStdString &fastHash, CFileItemList &items, CStdString &hash, bool &listed);
+
+    /*! \brief Drop any results not retrieved for the subfolders of a listing
+     \param items listing whose subfolders should be dropped.
+     */
+    void Discard(const CFileItemList &items);
+
+  private:
+    typedef boost::shared_ptr<CVideoCrawlResult> CrawlResultPtr;
+    std::map<CStdString, CrawlResultPtr> m_results;
+  };
+}
@@ -21,6 +21,7 @@
 #include "threads/SystemClock.h"
 #include "FileItem.h"
 #include "VideoInfoScanner.h"
+#include "VideoDirectoryCrawler.h"
 #include "addons/AddonManager.h"
 #include "filesystem/DirectoryCache.h"
 #include "Util.h"
@@ -68,6 +69,7 @@ namespace VIDEO
     m_itemCount = 0;
     m_bClean = false;
     m_scanAll = false;
+    m_crawler = NULL;
   }
 
   CVideoInfoScanner::~CVideoInfoScanner()
@@ -105,6 +107,9 @@ namespace VIDEO
       // result in unexpected behaviour.
       m_bCanInterrupt = false;
 
+      if (g_advancedSettings.m_videoScannerCrawlThreads > 0)
+        m_crawler = new CVideoDirectoryCrawler(g_advancedSettings.m_videoScannerCrawlThreads);
+
       bool bCancelled = false;
       while (!bCancelled && m_pathsToScan.size())
       {
@@ -119,6 +124,9 @@ namespace VIDEO
           bCancelled = true;
       }
 
+      delete m_crawler;
+      m_crawler = NULL;
+
       if (!bCancelled)
       {
         if (m_bClean)
@@ -143,6 +151,8 @@ namespace VIDEO
     {
       CLog::Log(LOGERROR, "VideoInfoScanner: Exception while scanning.");
     }
+    delete m_crawler;
+    m_crawler = NULL;
     if (m_handle)
       m_handle->MarkFinished();
     m_handle = NULL;
@@ -247,19 +257,28 @@ namespace VIDEO
         m_handle->SetTitle(g_localizeStrings.Get(str));
       }
 
-      CStdString fastHash = GetFastHash(strDirectory);
+      // the crawler may have hashed and listed the folder already
+      CStdString fastHash;
+      bool listed = false;
+      if (!m_crawler || !m_crawler->Get(strDirectory, fastHash, items, hash, listed))
+        fastHash = GetFastHash(strDirectory);
+
       if (m_database.GetPathHash(strDirectory, dbHash) && !fastHash.IsEmpty() && fastHash == dbHash)
       { // fast hashes match - no need to process anything
         CLog::Log(LOGDEBUG, "VideoInfoScanner: Skipping dir '%s' due to no change (fasthash)", strDirectory.c_str());
         hash = fastHash;
+        items.Clear();
         bSkip = true;
       }
       if (!bSkip)
       { // need to fetch the folder
-        CDirectory::GetDirectory(strDirectory, items, g_settings.m_videoExtensions);
-        items.Stack();
-        // compute hash
-        GetPathHash(items, hash);
+        if (!listed)
+        {
+          CDirectory::GetDirectory(strDirectory, items, g_settings.m_videoExtensions);
+          items.Stack();
+          // compute hash
+          GetPathHash(items, hash);
+        }
         if (hash != dbHash && !hash.IsEmpty())
         {
           if (dbHash.IsEmpty())
@@ -339,6 +358,10 @@ namespace VIDEO
     if (m_handle)
       OnDirectoryScanned(strDirectory);
 
+    bool recurse = settings.recurse > 0 && content != CONTENT_TVSHOWS;
+    if (m_crawler && recurse)
+      PrefetchFolders(strDirectory, items, regexps);
+
     for (int i = 0; i < items.Size(); ++i)
     {
       CFileItemPtr pItem = items[i];
@@ -348,7 +371,7 @@ namespace VIDEO
 
       // if we have a directory item (non-playlist) we then recurse into that folder
       // do not recurse for tv shows - we have already looked recursively for episodes
-      if (pItem->m_bIsFolder && !pItem->IsParentFolder() && !pItem->IsPlayList() && settings.recurse > 0 && content != CONTENT_TVSHOWS)
+      if (pItem->m_bIsFolder && !pItem->IsParentFolder() && !pItem->IsPlayList() && recurse)
       {
         if (!DoScan(pItem->GetPath()))
         {
@@ -356,9 +379,37 @@ namespace VIDEO
         }
       }
     }
+
+    // drop whatever DoScan() didn't pick up, eg excluded folders
+    if (m_crawler && recurse)
+      m_crawler->Discard(items);
+
     return !m_bStop;
   }
 
+  void CVideoInfoScanner::PrefetchFolders(const CStdString& strDirectory, const CFileItemList& items, const CStdStringArray& regexps)
+  {
+    // compare against the hashes of the whole folder in one query rather than one per subfolder
+    map<CStdString, CStdString> dbHashes;
+    bool queried = false;
+    for (int i = 0; i < items.Size(); ++i)
+    {
+      const CFileItemPtr pItem = items[i];
+      if (!pItem->m_bIsFolder || pItem->IsParentFolder() || pItem->IsPlayList() ||
+          CUtil::ExcludeFileOrFolder(pItem->GetPath(), regexps))
+        continue;
+
+      if (!queried)
+      {
+        m_database.GetPathHashes(strDirectory, dbHashes);
+        queried = true;
+      }
+
+      map<CStdString, CStdString>::const_iterator dbHash = dbHashes.find(pItem->GetPath());
+      m_crawler->Prefetch(pItem->GetPath(), dbHash != dbHashes.end() ? dbHash->second : "");
+    }
+  }
+
   bool CVideoInfoScanner::RetrieveVideoInfo(CFileItemList& items, bool bDirNames, CONTENT_TYPE content, bool useLocal, CScraperUrl* pURL, bool fetchEpisodes, CGUIDialogProgress* pDlgProgress)
   {
     if (pDlgProgress)
@@ -1595,7 +1646,7 @@ namespace VIDEO
     return items.GetFolderCount() == 0;
   }
 
-  CStdString CVideoInfoScanner::GetFastHash(const CStdString &directory) const
+  CStdString CVideoInfoScanner::GetFastHash(const CStdString &directory)
   {
     struct __stat64 buffer;
     if (XFILE::CFile::Stat(directory, &buffer) == 0)
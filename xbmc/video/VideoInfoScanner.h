@@ -48,6 +48,8 @@ namespace VIDEO
                   INFO_NOT_FOUND,
                   INFO_ADDED };
 
+  class CVideoDirectoryCrawler;
+
   class CVideoInfoScanner : CThread
   {
   public:
@@ -112,10 +114,28 @@ namespace VIDEO
     static std::string GetImage(CFileItem *pItem, bool useLocal, bool bApplyToDir, const std::string &type = "");
     static std::string GetFanart(CFileItem *pItem, bool useLocal);
 
+    static int GetPathHash(const CFileItemList &items, CStdString &hash);
+
+    /*! \brief Retrieve a "fast" hash of the given directory (if available)
+     Performs a stat() on the directory, and uses modified time to create a "fast"
+     hash of the folder. If no modified time is available, the create time is used,
+     and if neither are available, an empty hash is returned.
+     \param directory folder to hash
+     \return the hash of the folder of the form "fast<datetime>"
+     */
+    static CStdString GetFastHash(const CStdString &directory);
+
   protected:
     virtual void Process();
     bool DoScan(const CStdString& strDirectory);
 
+    /*! \brief Have the crawler list and hash the subfolders of a folder ahead of DoScan()
+     \param strDirectory folder the listing is of.
+     \param items listing of the folder.
+     \param regexps exclude regexps for the folder content.
+     */
+    void PrefetchFolders(const CStdString& strDirectory, const CFileItemList& items, const CStdStringArray& regexps);
+
     INFO_RET RetrieveInfoForTvShow(CFileItem *pItem, bool bDirNames, ADDON::ScraperPtr &scraper, bool useLocal, CScraperUrl* pURL, bool fetchEpisodes, CGUIDialogProgress* pDlgProgress);
     INFO_RET RetrieveInfoForMovie(CFileItem *pItem, bool bDirNames, ADDON::ScraperPtr &scraper, bool useLocal, CScraperUrl* pURL, CGUIDialogProgress* pDlgProgress);
     INFO_RET RetrieveInfoForMusicVideo(CFileItem *pItem, bool bDirNames, ADDON::ScraperPtr &scraper, bool useLocal, CScraperUrl* pURL, CGUIDialogProgress* pDlgProgress);
@@ -171,17 +191,6 @@ namespace VIDEO
      */
     void FetchActorThumbs(std::vector<SActorInfo>& actors, const CStdString& strPath);
 
-    static int GetPathHash(const CFileItemList &items, CStdString &hash);
-
-    /*! \brief Retrieve a "fast" hash of the given directory (if available)
-     Performs a stat() on the directory, and uses modified time to create a "fast"
-     hash of the folder. If no modified time is available, the create time is used,
-     and if neither are available, an empty hash is returned.
-     \param directory folder to hash
-     \return the hash of the folder of the form "fast<datetime>"
-     */
-    CStdString GetFastHash(const CStdString &directory) const;
-
     /*! \brief Decide whether a folder listing could use the "fast" hash
      Fast hashing can be done whenever the folder contains no scannable subfolders, as the
      fast hash technique uses modified time to determine when folder content changes, which
@@ -230,6 +239,7 @@ namespace VIDEO
     std::set<CStdString> m_pathsToCount;
     std::set<int> m_pathsToClean;
     CNfoFile m_nfoReader;
+    CVideoDirectoryCrawler* m_crawler;
   };
 }
 
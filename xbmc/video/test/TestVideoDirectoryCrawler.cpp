@@ -0,0 +1,187 @@
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+#include "video/VideoDirectoryCrawler.h"
+#include "video/VideoInfoScanner.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "settings/Settings.h"
+#include "threads/Event.h"
+#include "threads/SingleLock.h"
+#include "FileItem.h"
+
+#include "gtest/gtest.h"
+
+using namespace VIDEO;
+using namespace XFILE;
+
+static const int TEST_FOLDERS = 12;
+static const int TEST_FILES   = 3; ///< per folder
+
+/* counts the folders crawled so the tests can wait for them */
+class CTestVideoDirectoryCrawler : public CVideoDirectoryCrawler
+{
+public:
+  CTestVideoDirectoryCrawler(unsigned int jobsAtOnce) : CVideoDirectoryCrawler(jobsAtOnce), m_completed(0) {}
+
+  virtual void OnJobComplete(unsigned int jobID, bool success, CJob *job)
+  {
+    CVideoDirectoryCrawler::OnJobComplete(jobID, success, job);
+    CSingleLock lock(m_section);
+    m_completed++;
+    m_jobDone.Set();
+  }
+
+  bool WaitForJobs(int count)
+  {
+    CSingleLock lock(m_section);
+    while (m_completed < count)
+    {
+      lock.Leave();
+      if (!m_jobDone.WaitMSec(10000))
+        return false;
+      lock.Enter();
+    }
+    return true;
+  }
+
+private:
+  CCriticalSection m_section;
+  CEvent m_jobDone;
+  int m_completed;
+};
+
+class TestVideoDirectoryCrawler : public testing::Test
+{
+protected:
+  TestVideoDirectoryCrawler()
+  {
+    m_root = "special://temp/TestVideoDirectoryCrawler/";
+    CDirectory::Create(m_root);
+    for (int d = 0; d < TEST_FOLDERS; ++d)
+    {
+      CStdString folder;
+      folder.Format("%sMovie %02d/", m_root.c_str(), d);
+      CDirectory::Create(folder);
+      m_folders.push_back(folder);
+      for (int f = 0; f < TEST_FILES; ++f)
+      {
+        CStdString path;
+        path.Format("%sMovie %02d cd%d.avi", folder.c_str(), d, f + 1);
+        CFile file;
+        if (file.OpenForWrite(path, true))
+        {
+          file.Write(path.c_str(), path.size());
+          file.Close();
+          m_files.push_back(path);
+        }
+      }
+    }
+  }
+
+  ~TestVideoDirectoryCrawler()
+  {
+    for (std::vector<CStdString>::iterator i = m_files.begin(); i != m_files.end(); ++i)
+      CFile::Delete(*i);
+    for (std::vector<CStdString>::iterator i = m_folders.begin(); i != m_folders.end(); ++i)
+      CDirectory::Remove(*i);
+    CDirectory::Remove(m_root);
+  }
+
+  CStdString m_root;
+  std::vector<CStdString> m_folders;
+  std::vector<CStdString> m_files;
+};
+
+TEST_F(TestVideoDirectoryCrawler, SameAsSerial)
+{
+  CTestVideoDirectoryCrawler crawler(4);
+  for (size_t i = 0; i < m_folders.size(); ++i)
+    crawler.Prefetch(m_folders[i], "");
+
+  /* folders that haven't been started are left to the caller, so let the crawler get through them */
+  ASSERT_TRUE(crawler.WaitForJobs(TEST_FOLDERS));
+
+  for (size_t i = 0; i < m_folders.size(); ++i)
+  {
+    CStdString fastHash, hash;
+    CFileItemList items;
+    bool listed = false;
+    ASSERT_TRUE(crawler.Get(m_folders[i], fastHash, items, hash, listed));
+
+    /* the listing has to be exactly what the scanner would have come up with */
+    CFileItemList serialItems;
+    CStdString serialHash;
+    CDirectory::GetDirectory(m_folders[i], serialItems, g_settings.m_videoExtensions);
+    serialItems.Stack();
+    CVideoInfoScanner::GetPathHash(serialItems, serialHash);
+
+    EXPECT_TRUE(listed);
+    EXPECT_STREQ(CVideoInfoScanner::GetFastHash(m_folders[i]).c_str(), fastHash.c_str());
+    EXPECT_STREQ(serialHash.c_str(), hash.c_str());
+    ASSERT_EQ(serialItems.Size(), items.Size());
+    for (int j = 0; j < items.Size(); ++j)
+      EXPECT_STREQ(serialItems[j]->GetPath().c_str(), items[j]->GetPath().c_str());
+
+    /* retrieved results are handed out once */
+    EXPECT_FALSE(crawler.Get(m_folders[i], fastHash, items, hash, listed));
+  }
+}
+
+TEST_F(TestVideoDirectoryCrawler, Unchanged)
+{
+  /* folders whose fast hash matches the database are not listed */
+  CTestVideoDirectoryCrawler crawler(4);
+  for (size_t i = 0; i < m_folders.size(); ++i)
+    crawler.Prefetch(m_folders[i], CVideoInfoScanner::GetFastHash(m_folders[i]));
+
+  ASSERT_TRUE(crawler.WaitForJobs(TEST_FOLDERS));
+
+  for (size_t i = 0; i < m_folders.size(); ++i)
+  {
+    CStdString fastHash, hash;
+    CFileItemList items;
+    bool listed = true;
+    ASSERT_TRUE(crawler.Get(m_folders[i], fastHash, items, hash, listed));
+    EXPECT_FALSE(listed);
+    EXPECT_EQ(0, items.Size());
+  }
+}
+
+TEST_F(TestVideoDirectoryCrawler, Discard)
+{
+  CVideoDirectoryCrawler crawler(1);
+  CFileItemList folders;
+  for (size_t i = 0; i < m_folders.size(); ++i)
+  {
+    crawler.Prefetch(m_folders[i], "");
+    folders.Add(CFileItemPtr(new CFileItem(m_folders[i], true)));
+  }
+
+  crawler.Discard(folders);
+  for (size_t i = 0; i < m_folders.size(); ++i)
+  {
+    CStdString fastHash, hash;
+    CFileItemList items;
+    bool listed;
+    EXPECT_FALSE(crawler.Get(m_folders[i], fastHash, items, hash, listed));
+  }
+}